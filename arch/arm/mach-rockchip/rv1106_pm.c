@@ -6,10 +6,12 @@
 #include <linux/init.h>
 #include <linux/io.h>
 #include <linux/kernel.h>
+#include <linux/kobject.h>
 #include <linux/of.h>
 #include <linux/of_address.h>
 #include <linux/suspend.h>
 #include <linux/mfd/syscon.h>
+#include <linux/soc/rockchip/rockchip_lp_playback.h>
 
 #include <asm/cacheflush.h>
 #include <asm/fiq_glue.h>
@@ -74,10 +76,69 @@ struct rv1106_sleep_ddr_data {
 	u32 gpio0_ddr_l, gpio0_ddr_h;
 	u32 pmu_wkup_int_st, gpio0_int_st;
 	u32 sleep_clk_freq_hz;
+	bool vd_log_pd;
 };
 
 static struct rv1106_sleep_ddr_data ddr_data;
 
+static struct rockchip_lp_playback lp_playback;
+static bool lp_playback_armed;
+
+/*
+ * Stages of rv1106_suspend_enter(), each stamped with the hptimer when it
+ * is done. The log is in pmu sram so it also survives a resume that never
+ * makes it back to Linux.
+ */
+enum rv1106_pm_stage {
+	RV1106_PM_STAGE_ENTER,
+	RV1106_PM_STAGE_CLOCK_SUSPEND,
+	RV1106_PM_STAGE_SOC_SLEEP_CONFIG,
+	RV1106_PM_STAGE_PLLS_SUSPEND,
+	RV1106_PM_STAGE_GPIO_CONFIG,
+	RV1106_PM_STAGE_VD_LOG_SAVE,
+	RV1106_PM_STAGE_WAKEUP,
+	RV1106_PM_STAGE_REG_RGNS_RESTORE,
+	RV1106_PM_STAGE_PLL_LOCK,
+	RV1106_PM_STAGE_GIC_RESTORE,
+	RV1106_PM_STAGE_GPIO_RESTORE,
+	RV1106_PM_STAGE_PLLS_RESUME,
+	RV1106_PM_STAGE_SOC_SLEEP_RESTORE,
+	RV1106_PM_STAGE_CLOCK_RESUME,
+	RV1106_PM_STAGE_HPMCU,
+	RV1106_PM_STAGE_EXIT,
+	RV1106_PM_STAGE_NUM,
+};
+
+static const char * const rv1106_pm_stage_names[RV1106_PM_STAGE_NUM] = {
+	[RV1106_PM_STAGE_ENTER] = "enter",
+	[RV1106_PM_STAGE_CLOCK_SUSPEND] = "clock_suspend",
+	[RV1106_PM_STAGE_SOC_SLEEP_CONFIG] = "soc_sleep_config",
+	[RV1106_PM_STAGE_PLLS_SUSPEND] = "plls_suspend",
+	[RV1106_PM_STAGE_GPIO_CONFIG] = "gpio_config",
+	[RV1106_PM_STAGE_VD_LOG_SAVE] = "vd_log_regs_save",
+	[RV1106_PM_STAGE_WAKEUP] = "wakeup",
+	[RV1106_PM_STAGE_REG_RGNS_RESTORE] = "reg_rgns_restore",
+	[RV1106_PM_STAGE_PLL_LOCK] = "pll_lock",
+	[RV1106_PM_STAGE_GIC_RESTORE] = "gic400_restore",
+	[RV1106_PM_STAGE_GPIO_RESTORE] = "gpio_restore",
+	[RV1106_PM_STAGE_PLLS_RESUME] = "plls_resume",
+	[RV1106_PM_STAGE_SOC_SLEEP_RESTORE] = "soc_sleep_restore",
+	[RV1106_PM_STAGE_CLOCK_RESUME] = "clock_resume",
+	[RV1106_PM_STAGE_HPMCU] = "hpmcu",
+	[RV1106_PM_STAGE_EXIT] = "exit",
+};
+
+struct rv1106_pm_log {
+	u32 magic;
+	u32 count;
+	u32 stamp[RV1106_PM_STAGE_NUM];
+};
+
+static struct rv1106_pm_log __iomem *pm_log;
+
+/* skip restoring the logic registers when the logic stayed powered */
+static bool fast_resume;
+
 static const struct rk_sleep_config *slp_cfg;
 
 static void __iomem *pmucru_base;
@@ -505,13 +566,13 @@ static int is_hpmcu_mbox_int(void)
 	return !!(readl(mbox_base + RV1106_MBOX_B2A_STATUS) & BIT(0));
 }
 
-static void hpmcu_start(void)
+static void hpmcu_start(u32 sys_state)
 {
 	/* enable hpmcu mailbox AP irq */
 	gic_irq_en(RV1106_HPMCU_MBOX_IRQ_AP);
 
-	/* tell hpmcu that we are currently in system wake up. */
-	writel(RV1106_SYS_IS_WKUP, pmu_base + RV1106_PMU_SYS_REG(0));
+	/* tell hpmcu what the system is currently doing. */
+	writel(sys_state, pmu_base + RV1106_PMU_SYS_REG(0));
 
 	/* set the mcu uncache area, usually set the devices address */
 	writel(0xff000, coregrf_base + RV1106_COREGRF_CACHE_PERI_ADDR_START);
@@ -528,11 +589,48 @@ static void hpmcu_start(void)
 	dsb(sy);
 }
 
+static void hpmcu_stop(void)
+{
+	writel(0x1e001e, corecru_base + RV1106_COERCRU_SFTRST_CON(1));
+	writel(0, pmu_base + RV1106_PMU_SYS_REG(0));
+	dsb(sy);
+}
+
+#ifdef CONFIG_RV1106_HPMCU_LP_PLAYBACK
+/**
+ * rockchip_lp_playback_set - keep a PCM playing over the next suspend
+ * @pb: the PCM, or NULL to suspend as usual
+ *
+ * Meant for the system sleep callbacks of the I2S driver, which knows
+ * where the DMA is at that point. The playback is handed to the hpmcu
+ * only for the suspend that follows, it is dropped on resume.
+ */
+void rockchip_lp_playback_set(const struct rockchip_lp_playback *pb)
+{
+	if (pb)
+		lp_playback = *pb;
+	lp_playback_armed = !!pb;
+}
+EXPORT_SYMBOL_GPL(rockchip_lp_playback_set);
+#endif
+
+static void lp_playback_handoff(void)
+{
+	writel(lp_playback.buf, pmu_base + RV1106_LP_PLAYBACK_BUF);
+	writel(lp_playback.size, pmu_base + RV1106_LP_PLAYBACK_SIZE);
+	writel(lp_playback.pos, pmu_base + RV1106_LP_PLAYBACK_POS);
+	writel(lp_playback.avail, pmu_base + RV1106_LP_PLAYBACK_AVAIL);
+	writel(lp_playback.byte_rate, pmu_base + RV1106_LP_PLAYBACK_BYTE_RATE);
+	writel(lp_playback.wake_bytes, pmu_base + RV1106_LP_PLAYBACK_WAKE_BYTES);
+
+	hpmcu_start(RV1106_SYS_IS_LP_PLAYBACK);
+}
+
 static int hpmcu_fast_wkup(void)
 {
 	u32 cmd;
 
-	hpmcu_start();
+	hpmcu_start(RV1106_SYS_IS_WKUP);
 
 	while (1) {
 		rkpm_printstr("-s-\n");
@@ -556,6 +654,13 @@ static int hpmcu_fast_wkup(void)
 		return 0;
 }
 
+static void rv1106_pm_stamp(enum rv1106_pm_stage stage)
+{
+	if (pm_log)
+		writel_relaxed((u32)rk_hptimer_get_count(hptimer_base),
+			       &pm_log->stamp[stage]);
+}
+
 static void clock_suspend(void)
 {
 	int i;
@@ -846,6 +951,30 @@ static void pmu_sleep_config(void)
 		BIT(RV1106_PMU_GPLL_PD_ENA) |
 		0;
 
+	/*
+	 * The hpmcu wakes us up by software when the PCM runs low, while I2S
+	 * and its DMA keep playing: keep the logic powered, the oscillator
+	 * and audio plls running and the buses it goes through awake.
+	 */
+	if (IS_ENABLED(CONFIG_RV1106_HPMCU_LP_PLAYBACK) && lp_playback_armed) {
+		pmu_wkup_con |= BIT(RV1106_PMU_WAKEUP_SFT_WAKEUP_CFG);
+		pmu_cru_con[0] &= ~(BIT(RV1106_PMU_OSC_DIS_ENA) |
+				    BIT(RV1106_PMU_INPUT_CLAMP_ENA) |
+				    BIT(RV1106_PMU_POWER_OFF_ENA));
+		pmu_pll_con &= ~(BIT(RV1106_PMU_CPLL_PD_ENA) |
+				 BIT(RV1106_PMU_GPLL_PD_ENA));
+		pmu_bus_idle_con &= ~(BIT(RV1106_PMU_IDLE_REQ_PERI) |
+				      BIT(RV1106_PMU_IDLE_REQ_CPU));
+		if (lp_playback.ddr) {
+			pmu_bus_idle_con &= ~(BIT(RV1106_PMU_IDLE_REQ_MSCH) |
+					      BIT(RV1106_PMU_IDLE_REQ_DDR));
+			pmu_ddr_con &= ~(BIT(RV1106_PMU_DDR_SREF_C_ENA) |
+					 BIT(RV1106_PMU_DDR_SREF_A_ENA));
+		}
+	}
+
+	ddr_data.vd_log_pd = !!(pmu_cru_con[0] & BIT(RV1106_PMU_POWER_OFF_ENA));
+
 	/* pmu_debug */
 	writel_relaxed(0xffffff01, pmu_base + RV1106_PMU_INFO_TX_CON);
 	writel_relaxed(BITS_WITH_WMASK(0x1, 0xf, 4), ioc_base[1] + 0);
@@ -1084,6 +1213,12 @@ static void pvtpllcru_restore(void)
 	writel_relaxed(0x00030003, pvtpllcru_base + CRU_PVTPLL1_CON0_L);
 }
 
+/* vd_core is lost with the cpu, vd_log only if the pmu powered it off */
+static bool vd_log_regs_lost(void)
+{
+	return !fast_resume || ddr_data.vd_log_pd;
+}
+
 static void vd_log_regs_save(void)
 {
 	cru_mode = readl_relaxed(cru_base + 0x280);
@@ -1093,26 +1228,34 @@ static void vd_log_regs_save(void)
 	gic400_save();
 	rkpm_printch('b');
 
-	pvtpllcru_save();
 	rkpm_reg_rgn_save(vd_core_reg_rgns, ARRAY_SIZE(vd_core_reg_rgns));
 	rkpm_printch('c');
-	rkpm_reg_rgn_save(vd_log_reg_rgns, ARRAY_SIZE(vd_log_reg_rgns));
-	rkpm_printch('d');
+	if (vd_log_regs_lost()) {
+		pvtpllcru_save();
+		rkpm_reg_rgn_save(vd_log_reg_rgns, ARRAY_SIZE(vd_log_reg_rgns));
+		rkpm_printch('d');
 
-	rkpm_uart_debug_save(uartdbg_base, &debug_port_save);
-	rkpm_printch('e');
+		rkpm_uart_debug_save(uartdbg_base, &debug_port_save);
+		rkpm_printch('e');
+	}
 }
 
 static void vd_log_regs_restore(void)
 {
-	rkpm_uart_debug_restore(uartdbg_base, &debug_port_save);
+	bool lost = vd_log_regs_lost();
+
+	if (lost)
+		rkpm_uart_debug_restore(uartdbg_base, &debug_port_save);
 
 	/* slow mode */
 	writel_relaxed(0x003f0000, cru_base + 0x280);
 
 	rkpm_reg_rgn_restore(vd_core_reg_rgns, ARRAY_SIZE(vd_core_reg_rgns));
-	rkpm_reg_rgn_restore(vd_log_reg_rgns, ARRAY_SIZE(vd_log_reg_rgns));
-	pvtpllcru_restore();
+	if (lost) {
+		rkpm_reg_rgn_restore(vd_log_reg_rgns, ARRAY_SIZE(vd_log_reg_rgns));
+		pvtpllcru_restore();
+	}
+	rv1106_pm_stamp(RV1106_PM_STAGE_REG_RGNS_RESTORE);
 
 	/* wait lock */
 	pm_pll_wait_lock(RV1106_APLL_ID);
@@ -1121,8 +1264,10 @@ static void vd_log_regs_restore(void)
 
 	/* restore mode */
 	writel_relaxed(WITH_16BITS_WMSK(cru_mode), cru_base + 0x280);
+	rv1106_pm_stamp(RV1106_PM_STAGE_PLL_LOCK);
 
 	gic400_restore();
+	rv1106_pm_stamp(RV1106_PM_STAGE_GIC_RESTORE);
 
 	writel_relaxed(0xffff0000, pmugrf_base + RV1106_PMUGRF_SOC_CON(4));
 	writel_relaxed(0xffff0000, pmugrf_base + RV1106_PMUGRF_SOC_CON(5));
@@ -1171,25 +1316,39 @@ static int rv1106_suspend_enter(suspend_state_t state)
 
 	rkpm_printch('-');
 
+	if (pm_log)
+		writel_relaxed(readl_relaxed(&pm_log->count) + 1, &pm_log->count);
+
 RE_ENTER_SLEEP:
+	rv1106_pm_stamp(RV1106_PM_STAGE_ENTER);
+
 	clock_suspend();
 	rkpm_printch('0');
+	rv1106_pm_stamp(RV1106_PM_STAGE_CLOCK_SUSPEND);
 
 	soc_sleep_config();
 	rkpm_printch('1');
+	rv1106_pm_stamp(RV1106_PM_STAGE_SOC_SLEEP_CONFIG);
 
 	plls_suspend();
 	rkpm_printch('2');
+	rv1106_pm_stamp(RV1106_PM_STAGE_PLLS_SUSPEND);
 
 	gpio_config();
 	rkpm_printch('3');
+	rv1106_pm_stamp(RV1106_PM_STAGE_GPIO_CONFIG);
 
 	vd_log_regs_save();
 	rkpm_regs_rgn_dump();
 	rkpm_printch('4');
+	rv1106_pm_stamp(RV1106_PM_STAGE_VD_LOG_SAVE);
+
+	if (IS_ENABLED(CONFIG_RV1106_HPMCU_LP_PLAYBACK) && lp_playback_armed)
+		lp_playback_handoff();
 
 	rkpm_printstr("-WFI-");
 	cpu_suspend(0, rockchip_lpmode_enter);
+	rv1106_pm_stamp(RV1106_PM_STAGE_WAKEUP);
 
 	rkpm_printch('4');
 
@@ -1199,18 +1358,26 @@ static int rv1106_suspend_enter(suspend_state_t state)
 
 	gpio_restore();
 	rkpm_printch('2');
+	rv1106_pm_stamp(RV1106_PM_STAGE_GPIO_RESTORE);
 
 	plls_resume();
 	rkpm_printch('1');
+	rv1106_pm_stamp(RV1106_PM_STAGE_PLLS_RESUME);
 
 	soc_sleep_restore();
 	rkpm_printch('0');
+	rv1106_pm_stamp(RV1106_PM_STAGE_SOC_SLEEP_RESTORE);
 
 	clock_resume();
 	rkpm_printch('-');
-
-	/* Check whether it's time_out wakeup */
-	if (IS_ENABLED(CONFIG_RV1106_HPMCU_FAST_WAKEUP)) {
+	rv1106_pm_stamp(RV1106_PM_STAGE_CLOCK_RESUME);
+
+	if (IS_ENABLED(CONFIG_RV1106_HPMCU_LP_PLAYBACK) && lp_playback_armed) {
+		/* Linux takes the PCM back from here */
+		hpmcu_stop();
+		lp_playback_armed = false;
+	} else if (IS_ENABLED(CONFIG_RV1106_HPMCU_FAST_WAKEUP)) {
+		/* Check whether it's time_out wakeup */
 		if (hpmcu_fast_wkup()) {
 			rkpm_gicv2_dist_restore(gicd_base, &gicd_ctx_save);
 			goto RE_ENTER_SLEEP;
@@ -1220,6 +1387,8 @@ static int rv1106_suspend_enter(suspend_state_t state)
 		}
 	}
 
+	rv1106_pm_stamp(RV1106_PM_STAGE_HPMCU);
+
 	if (rk_hptimer_get_mode(hptimer_base) == RK_HPTIMER_SOFT_ADJUST_MODE) {
 		if (rk_hptimer_wait_mode(hptimer_base,
 					 RK_HPTIMER_SOFT_ADJUST_MODE))
@@ -1232,6 +1401,7 @@ static int rv1106_suspend_enter(suspend_state_t state)
 
 	local_fiq_enable();
 	rkpm_printstr("rv1106 exit sleep\n");
+	rv1106_pm_stamp(RV1106_PM_STAGE_EXIT);
 
 	return 0;
 }
@@ -1320,6 +1490,14 @@ static int __init rv1106_suspend_init(struct device_node *np)
 	memcpy(rv1106_bootram_base, rockchip_slp_cpu_resume,
 	       rv1106_bootram_sz + 0x50);
 
+	if (rv1106_bootram_sz + 0x50 <= RV1106_PM_LOG_OFFSET) {
+		pm_log = rv1106_bootram_base + RV1106_PM_LOG_OFFSET;
+		memset_io(pm_log, 0, sizeof(*pm_log));
+		writel_relaxed(RV1106_PM_LOG_MAGIC, &pm_log->magic);
+	} else {
+		pr_warn("%s: no pmu sram left for the stage log\n", __func__);
+	}
+
 	/* remap */
 #if RV1106_WAKEUP_TO_SYSTEM_RESET
 	writel_relaxed(BITS_WITH_WMASK(1, 0x1, 10), pmusgrf_base + RV1106_PMUSGRF_SOC_CON(1));
@@ -1339,6 +1517,85 @@ static int __init rv1106_suspend_init(struct device_node *np)
 	return 0;
 }
 
+/*
+ * /sys/power/rv1106_pm_stages: time spent in each stage of the last
+ * suspend/resume, "wakeup" being the first stamp after the wake up.
+ */
+static ssize_t rv1106_pm_stages_show(struct kobject *kobj,
+				     struct kobj_attribute *attr, char *buf)
+{
+	u32 prev, stamp;
+	ssize_t len;
+	int i;
+
+	if (!pm_log || readl_relaxed(&pm_log->magic) != RV1106_PM_LOG_MAGIC)
+		return -ENODEV;
+
+	len = scnprintf(buf, PAGE_SIZE, "suspend %u\n",
+			readl_relaxed(&pm_log->count));
+	prev = readl_relaxed(&pm_log->stamp[RV1106_PM_STAGE_ENTER]);
+	for (i = RV1106_PM_STAGE_CLOCK_SUSPEND; i < RV1106_PM_STAGE_NUM; i++) {
+		stamp = readl_relaxed(&pm_log->stamp[i]);
+		/* the sleep itself is not a stage, the hptimer is adjusted */
+		if (i != RV1106_PM_STAGE_WAKEUP)
+			len += scnprintf(buf + len, PAGE_SIZE - len,
+					 "%-20s %8u us\n",
+					 rv1106_pm_stage_names[i],
+					 (stamp - prev) /
+					 RV1106_HPTIMER_TICKS_PER_US);
+		prev = stamp;
+	}
+
+	stamp = readl_relaxed(&pm_log->stamp[RV1106_PM_STAGE_WAKEUP]);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "%-20s %8u us\n",
+			 "resume", (prev - stamp) / RV1106_HPTIMER_TICKS_PER_US);
+
+	return len;
+}
+
+static struct kobj_attribute rv1106_pm_stages_attr =
+	__ATTR(rv1106_pm_stages, 0444, rv1106_pm_stages_show, NULL);
+
+static ssize_t rv1106_fast_resume_show(struct kobject *kobj,
+				       struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%d\n", fast_resume);
+}
+
+static ssize_t rv1106_fast_resume_store(struct kobject *kobj,
+					struct kobj_attribute *attr,
+					const char *buf, size_t n)
+{
+	int ret;
+
+	ret = kstrtobool(buf, &fast_resume);
+
+	return ret ? ret : n;
+}
+
+static struct kobj_attribute rv1106_fast_resume_attr =
+	__ATTR(rv1106_fast_resume, 0644, rv1106_fast_resume_show,
+	       rv1106_fast_resume_store);
+
+static struct attribute *rv1106_pm_attrs[] = {
+	&rv1106_pm_stages_attr.attr,
+	&rv1106_fast_resume_attr.attr,
+	NULL,
+};
+
+static const struct attribute_group rv1106_pm_attr_group = {
+	.attrs = rv1106_pm_attrs,
+};
+
+static int __init rv1106_pm_sysfs_init(void)
+{
+	if (!pmu_base)
+		return 0;
+
+	return sysfs_create_group(power_kobj, &rv1106_pm_attr_group);
+}
+late_initcall(rv1106_pm_sysfs_init);
+
 static const struct platform_suspend_ops rv1106_suspend_ops = {
 	.enter   = rv1106_suspend_enter,
 	.valid   = suspend_valid_only_mem,
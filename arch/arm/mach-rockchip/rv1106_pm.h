@@ -70,6 +70,11 @@
 #define RV1106_PMUSRAM_BASE		\
 	(RV1106_DEV_REG_BASE + RV1106_PMUSRAM_OFFSET)
 
+/* stage log, in pmu sram behind the resume code */
+#define RV1106_PM_LOG_OFFSET		0x800
+#define RV1106_PM_LOG_MAGIC		0x706d6c67
+#define RV1106_HPTIMER_TICKS_PER_US	24
+
 /* cru */
 #define RV1106_CRU_PLL_CON(pll_id, i)	((pll_id) * 0x20 + (i) * 4)
 #define RV1106_CRU_MODE_CON00		0x280
@@ -207,6 +212,15 @@
 #define RV1106_MBOX_CMD_AP_SUSPEND	0x12345600
 #define RV1106_MBOX_CMD_AP_RESUME	0x12345601
 #define RV1106_SYS_IS_WKUP		0x87654300
+#define RV1106_SYS_IS_LP_PLAYBACK	0x87654301
+
+/* struct rockchip_lp_playback as handed to the hpmcu */
+#define RV1106_LP_PLAYBACK_BUF		RV1106_PMU_SYS_REG(1)
+#define RV1106_LP_PLAYBACK_SIZE		RV1106_PMU_SYS_REG(2)
+#define RV1106_LP_PLAYBACK_POS		RV1106_PMU_SYS_REG(3)
+#define RV1106_LP_PLAYBACK_AVAIL	RV1106_PMU_SYS_REG(4)
+#define RV1106_LP_PLAYBACK_BYTE_RATE	RV1106_PMU_SYS_REG(5)
+#define RV1106_LP_PLAYBACK_WAKE_BYTES	RV1106_PMU_SYS_REG(6)
 
 #ifndef __ASSEMBLER__
 extern unsigned long rkpm_bootdata_cpusp;
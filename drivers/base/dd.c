@@ -23,6 +23,7 @@
 #include <linux/init.h>
 #include <linux/module.h>
 #include <linux/kthread.h>
+#include <linux/of.h>
 #include <linux/wait.h>
 #include <linux/async.h>
 #include <linux/pm_runtime.h>
@@ -69,6 +70,43 @@ static char async_probe_drv_names[ASYNC_DRV_NAMES_MAX_LEN];
  */
 static bool defer_all_probes;
 
+#ifdef CONFIG_ROCKCHIP_THUNDER_BOOT
+/*
+ * Thunderboot probe ordering. Devices whose DT node has
+ * "rockchip,boot-critical" (audio, storage, network...) are probed on
+ * their own async domain as soon as their driver registers, those with
+ * "rockchip,boot-late" (display, wifi firmware...) are held back as
+ * deferred until all boot-critical probes have finished after the
+ * initcalls, and are then probed from the deferred probe work so they
+ * do not delay userspace.
+ */
+static ASYNC_DOMAIN(tb_critical_domain);
+static atomic_t tb_critical_count = ATOMIC_INIT(0);
+static bool tb_late_released;
+
+static bool device_is_boot_critical(struct device *dev)
+{
+	return dev->of_node &&
+	       of_property_read_bool(dev->of_node, "rockchip,boot-critical");
+}
+
+static bool device_is_boot_late(struct device *dev)
+{
+	return !READ_ONCE(tb_late_released) && dev->of_node &&
+	       of_property_read_bool(dev->of_node, "rockchip,boot-late");
+}
+#else
+static inline bool device_is_boot_critical(struct device *dev)
+{
+	return false;
+}
+
+static inline bool device_is_boot_late(struct device *dev)
+{
+	return false;
+}
+#endif
+
 /*
  * deferred_probe_work_func() - Retry probing devices in the active list.
  */
@@ -337,6 +375,28 @@ static int deferred_probe_initcall(void)
 }
 late_initcall(deferred_probe_initcall);
 
+#ifdef CONFIG_ROCKCHIP_THUNDER_BOOT
+static void tb_late_probe_work_func(struct work_struct *work)
+{
+	async_synchronize_full_domain(&tb_critical_domain);
+	pr_info("thunderboot: %d boot-critical probes done at %lld ms, releasing late devices\n",
+		atomic_read(&tb_critical_count),
+		ktime_to_ms(ktime_get_boottime()));
+
+	WRITE_ONCE(tb_late_released, true);
+	driver_deferred_probe_trigger();
+}
+static DECLARE_WORK(tb_late_probe_work, tb_late_probe_work_func);
+
+static int __init tb_late_probe_initcall(void)
+{
+	queue_work(system_unbound_wq, &tb_late_probe_work);
+
+	return 0;
+}
+late_initcall_sync(tb_late_probe_initcall);
+#endif
+
 static void __exit deferred_probe_exit(void)
 {
 	debugfs_remove_recursive(deferred_devices);
@@ -512,6 +572,13 @@ static int really_probe(struct device *dev, struct device_driver *drv)
 		return ret;
 	}
 
+	if (device_is_boot_late(dev)) {
+		dev_dbg(dev, "Driver %s waits for boot-critical probes\n",
+			drv->name);
+		driver_deferred_probe_add(dev);
+		return ret;
+	}
+
 	ret = device_links_check_suppliers(dev);
 	if (ret == -EPROBE_DEFER)
 		driver_deferred_probe_add_trigger(dev, local_trigger_count);
@@ -1058,6 +1125,33 @@ static void __driver_attach_async_helper(void *_dev, async_cookie_t cookie)
 	put_device(dev);
 }
 
+#ifdef CONFIG_ROCKCHIP_THUNDER_BOOT
+static void __driver_attach_critical_helper(void *_dev, async_cookie_t cookie)
+{
+	struct device *dev = _dev;
+	ktime_t start = ktime_get();
+
+	get_device(dev);
+	__driver_attach_async_helper(dev, cookie);
+	dev_info(dev, "boot-critical probe %s in %lld us, at %lld ms\n",
+		 dev->driver ? "done" : "failed",
+		 ktime_us_delta(ktime_get(), start),
+		 ktime_to_ms(ktime_get_boottime()));
+	put_device(dev);
+}
+
+static void driver_attach_critical(struct device *dev)
+{
+	atomic_inc(&tb_critical_count);
+	async_schedule_dev_domain(__driver_attach_critical_helper, dev,
+				  &tb_critical_domain);
+}
+#else
+static inline void driver_attach_critical(struct device *dev)
+{
+}
+#endif
+
 static int __driver_attach(struct device *dev, void *data)
 {
 	struct device_driver *drv = data;
@@ -1091,7 +1185,9 @@ static int __driver_attach(struct device *dev, void *data)
 		return ret;
 	} /* ret > 0 means positive match */
 
-	if (driver_allows_async_probing(drv)) {
+	if (driver_allows_async_probing(drv) ||
+	    (drv->probe_type != PROBE_FORCE_SYNCHRONOUS &&
+	     device_is_boot_critical(dev))) {
 		/*
 		 * Instead of probing the device synchronously we will
 		 * probe it asynchronously to allow for more parallelism.
@@ -1107,7 +1203,9 @@ static int __driver_attach(struct device *dev, void *data)
 			async = true;
 		}
 		device_unlock(dev);
-		if (async)
+		if (async && device_is_boot_critical(dev))
+			driver_attach_critical(dev);
+		else if (async)
 			async_schedule_dev(__driver_attach_async_helper, dev);
 		return 0;
 	}
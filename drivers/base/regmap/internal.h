@@ -152,6 +152,8 @@ struct regmap {
 	bool use_single_write;
 	/* if set, the device supports multi write mode */
 	bool can_multi_write;
+	/* if set, multi register writes go to the bus as one batch */
+	bool bus_multi_write;
 
 	/* if set, raw reads/writes are limited to this size */
 	size_t max_raw_read;
@@ -164,6 +166,9 @@ struct regmap {
 
 	/* if set, the regmap core can sleep */
 	bool can_sleep;
+
+	/* if set, the MMIO accessors do not include barriers */
+	bool use_relaxed_mmio;
 };
 
 struct regcache_ops {
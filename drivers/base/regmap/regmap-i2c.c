@@ -9,6 +9,7 @@
 #include <linux/regmap.h>
 #include <linux/i2c.h>
 #include <linux/module.h>
+#include <linux/slab.h>
 
 #include "internal.h"
 
@@ -197,10 +198,57 @@ static int regmap_i2c_read(void *context,
 		return -EIO;
 }
 
+/*
+ * Queue every register write of a sequence as its own message of a single
+ * transfer, so the adapter can run them back to back instead of taking a
+ * separate bus lock, setup and completion for each register.
+ */
+static int regmap_i2c_multi_write(void *context, const void *data,
+				  size_t pair_size, size_t count)
+{
+	struct device *dev = context;
+	struct i2c_client *i2c = to_i2c_client(dev);
+	const struct i2c_adapter_quirks *q = i2c->adapter->quirks;
+	size_t max = q && q->max_num_msgs ? q->max_num_msgs : count;
+	const u8 *buf = data;
+	struct i2c_msg *xfer;
+	size_t i, n;
+	int ret = 0;
+
+	xfer = kcalloc(min(max, count), sizeof(*xfer), GFP_KERNEL);
+	if (!xfer)
+		return -ENOMEM;
+
+	while (count) {
+		n = min(max, count);
+		for (i = 0; i < n; i++) {
+			xfer[i].addr = i2c->addr;
+			xfer[i].flags = i2c->flags & I2C_M_TEN;
+			xfer[i].len = pair_size;
+			xfer[i].buf = (u8 *)buf;
+			buf += pair_size;
+		}
+
+		ret = i2c_transfer(i2c->adapter, xfer, n);
+		if (ret != (int)n) {
+			if (ret >= 0)
+				ret = -EIO;
+			break;
+		}
+		ret = 0;
+		count -= n;
+	}
+
+	kfree(xfer);
+
+	return ret;
+}
+
 static const struct regmap_bus regmap_i2c = {
 	.write = regmap_i2c_write,
 	.gather_write = regmap_i2c_gather_write,
 	.read = regmap_i2c_read,
+	.multi_write = regmap_i2c_multi_write,
 	.reg_format_endian_default = REGMAP_ENDIAN_BIG,
 	.val_format_endian_default = REGMAP_ENDIAN_BIG,
 };
@@ -803,6 +803,7 @@ struct regmap *__regmap_init(struct device *dev,
 	map->use_single_read = config->use_single_read || !bus || !bus->read;
 	map->use_single_write = config->use_single_write || !bus || !bus->write;
 	map->can_multi_write = config->can_multi_write && bus && bus->write;
+	map->use_relaxed_mmio = config->use_relaxed_mmio;
 	if (bus) {
 		map->max_raw_read = bus->max_raw_read;
 		map->max_raw_write = bus->max_raw_write;
@@ -1065,6 +1066,10 @@ struct regmap *__regmap_init(struct device *dev,
 	    !(map->format.format_reg && map->format.format_val))
 		goto err_hwlock;
 
+	map->bus_multi_write = !map->can_multi_write && bus &&
+			       bus->multi_write && !map->format.format_write &&
+			       map->format.parse_inplace;
+
 	map->work_buf = kzalloc(map->format.buf_size, GFP_KERNEL);
 	if (map->work_buf == NULL) {
 		ret = -ENOMEM;
@@ -2303,14 +2308,23 @@ static int _regmap_raw_multi_reg_write(struct regmap *map,
 		unsigned int val = regs[i].def;
 		trace_regmap_hw_write_start(map, reg, 1);
 		map->format.format_reg(u8, reg, map->reg_shift);
+		/* each pair is a write of its own on the bus */
+		if (map->bus_multi_write)
+			*u8 |= map->write_flag_mask;
 		u8 += reg_bytes + pad_bytes;
 		map->format.format_val(u8, val, 0);
 		u8 += val_bytes;
 	}
-	u8 = buf;
-	*u8 |= map->write_flag_mask;
 
-	ret = map->bus->write(map->bus_context, buf, len);
+	if (map->bus_multi_write) {
+		ret = map->bus->multi_write(map->bus_context, buf, pair_size,
+					    num_regs);
+	} else {
+		u8 = buf;
+		*u8 |= map->write_flag_mask;
+
+		ret = map->bus->write(map->bus_context, buf, len);
+	}
 
 	kfree(buf);
 
@@ -2418,7 +2432,7 @@ static int _regmap_multi_reg_write(struct regmap *map,
 	int i;
 	int ret;
 
-	if (!map->can_multi_write) {
+	if (!map->can_multi_write && !map->bus_multi_write) {
 		for (i = 0; i < num_regs; i++) {
 			ret = _regmap_write(map, regs[i].reg, regs[i].def);
 			if (ret != 0)
@@ -3086,6 +3100,53 @@ int regmap_update_bits_base(struct regmap *map, unsigned int reg,
 }
 EXPORT_SYMBOL_GPL(regmap_update_bits_base);
 
+/**
+ * regmap_multi_reg_update_bits() - Perform a sequence of read/modify/write
+ *                                  cycles under a single lock
+ *
+ * @map: Register map to update
+ * @updates: Array of updates, applied in order
+ * @num_updates: Number of updates in the array
+ * @change: Boolean indicating if any write was done, may be NULL
+ *
+ * Equivalent to a regmap_update_bits() per entry, but takes the map lock
+ * once for the whole sequence. For maps using relaxed MMIO a single write
+ * barrier orders the sequence after prior memory accesses, instead of one
+ * per register access. Stops at the first failing update.
+ *
+ * Returns zero for success, a negative number on error.
+ */
+int regmap_multi_reg_update_bits(struct regmap *map,
+				 const struct reg_update *updates,
+				 int num_updates, bool *change)
+{
+	bool changed;
+	int i, ret = 0;
+
+	if (change)
+		*change = false;
+
+	map->lock(map->lock_arg);
+
+	if (map->use_relaxed_mmio)
+		wmb();
+
+	for (i = 0; i < num_updates; i++) {
+		ret = _regmap_update_bits(map, updates[i].reg, updates[i].mask,
+					  updates[i].val, &changed, false);
+		if (ret != 0)
+			break;
+
+		if (change && changed)
+			*change = true;
+	}
+
+	map->unlock(map->lock_arg);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(regmap_multi_reg_update_bits);
+
 /**
  * regmap_test_bits() - Check if all specified bits are set in a register.
  *
@@ -151,6 +151,22 @@ int __exit h4_deinit(void)
 	return hci_uart_unregister_proto(&h4p);
 }
 
+/*
+ * Same as bt_skb_alloc(), but carved out of the per-CPU page fragment cache.
+ * Frames are reassembled at media packet rate with GFP_ATOMIC, a fragment
+ * is a pointer bump where a kmalloc-2k object per ACL frame is not.
+ */
+static struct sk_buff *h4_alloc_skb(unsigned int len)
+{
+	struct sk_buff *skb;
+
+	skb = __netdev_alloc_skb(NULL, len + BT_SKB_RESERVE, GFP_ATOMIC);
+	if (skb)
+		skb_reserve(skb, BT_SKB_RESERVE);
+
+	return skb;
+}
+
 struct sk_buff *h4_recv_buf(struct hci_dev *hdev, struct sk_buff *skb,
 			    const unsigned char *buffer, int count,
 			    const struct h4_recv_pkt *pkts, int pkts_count)
@@ -178,8 +194,7 @@ struct sk_buff *h4_recv_buf(struct hci_dev *hdev, struct sk_buff *skb,
 				if (buffer[0] != (&pkts[i])->type)
 					continue;
 
-				skb = bt_skb_alloc((&pkts[i])->maxlen,
-						   GFP_ATOMIC);
+				skb = h4_alloc_skb((&pkts[i])->maxlen);
 				if (!skb)
 					return ERR_PTR(-ENOMEM);
 
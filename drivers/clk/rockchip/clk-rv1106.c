@@ -10,6 +10,7 @@
 #include <linux/of.h>
 #include <linux/of_address.h>
 #include <linux/of_device.h>
+#include <linux/rational.h>
 #include <linux/regmap.h>
 #include <linux/syscore_ops.h>
 #include <dt-bindings/clock/rv1106-cru.h>
@@ -1142,6 +1143,194 @@ static void rockchip_rv1106_pvtpll_init(struct rockchip_clk_provider *ctx)
 	queue_delayed_work(system_freezable_wq, &pvtpll_calibrate_work, msecs_to_jiffies(300));
 }
 
+/*
+ * Audio clock planner: the i2s mclk comes from a 16/16 bit fractional
+ * divider behind an integer divided gpll or cpll. Not every pll/div pair
+ * reaches both the 44.1k and the 48k family exactly (1000MHz cpll can't
+ * reach 512 * 44100), so pick the source that comes closest for both,
+ * preferring gpll and small dividers, and keep that pll rate fixed.
+ */
+#define RV1106_AUDIO_FRAC_MAX		0xffff
+#define RV1106_AUDIO_SRC_DIV_MAX	32
+
+static const unsigned long rv1106_audio_rates[] = {
+	512 * 44100,
+	512 * 48000,
+};
+
+struct rv1106_audio_plan {
+	int src;
+	int frac;
+	struct clk *pll;
+	unsigned long src_rate;
+	s64 err_ppb[ARRAY_SIZE(rv1106_audio_rates)];
+};
+
+static struct rv1106_audio_plan rv1106_audio_plans[] = {
+	{ .src = CLK_I2S0_8CH_TX_SRC, .frac = CLK_I2S0_8CH_TX_FRAC },
+	{ .src = CLK_I2S0_8CH_RX_SRC, .frac = CLK_I2S0_8CH_RX_FRAC },
+};
+
+static s64 rv1106_audio_err_ppb(unsigned long actual, unsigned long rate)
+{
+	return div64_s64(((s64)actual - (s64)rate) * NSEC_PER_SEC, rate);
+}
+
+/* what rockchip_fractional_approximation() will get out of @prate */
+static s64 __init rv1106_audio_frac_err(unsigned long prate,
+					unsigned long rate)
+{
+	unsigned long m, n;
+
+	if (prate < rate * 20)
+		return prate % rate ? S64_MAX : 0;
+
+	rational_best_approximation(rate, prate, RV1106_AUDIO_FRAC_MAX,
+				    RV1106_AUDIO_FRAC_MAX, &m, &n);
+	if (!m || !n)
+		return S64_MAX;
+
+	return rv1106_audio_err_ppb(div64_u64((u64)prate * m, n), rate);
+}
+
+static void __init rv1106_audio_clk_plan(struct clk **clks)
+{
+	static const int plls[] = { PLL_GPLL, PLL_CPLL };
+	struct rv1106_audio_plan *plan;
+	s64 err[ARRAY_SIZE(rv1106_audio_rates)], worst, best;
+	unsigned long prate;
+	int i, j, div, best_div;
+	struct clk *pll;
+
+	for (i = 0; i < ARRAY_SIZE(rv1106_audio_plans); i++) {
+		plan = &rv1106_audio_plans[i];
+		best = S64_MAX;
+		best_div = 0;
+
+		for (j = 0; j < ARRAY_SIZE(plls); j++) {
+			pll = clks[plls[j]];
+			prate = clk_get_rate(pll);
+
+			for (div = 1; div <= RV1106_AUDIO_SRC_DIV_MAX; div++) {
+				int k;
+
+				worst = 0;
+				for (k = 0; k < ARRAY_SIZE(rv1106_audio_rates); k++) {
+					err[k] = rv1106_audio_frac_err(prate / div,
+								       rv1106_audio_rates[k]);
+					if (err[k] == S64_MAX) {
+						worst = S64_MAX;
+						break;
+					}
+					worst = max(worst, abs(err[k]));
+				}
+				if (worst >= best)
+					continue;
+
+				best = worst;
+				best_div = div;
+				plan->pll = pll;
+				plan->src_rate = prate / div;
+				memcpy(plan->err_ppb, err, sizeof(err));
+			}
+		}
+
+		if (!best_div) {
+			pr_warn("%s: no audio source for %s\n", __func__,
+				__clk_get_name(clks[plan->src]));
+			continue;
+		}
+
+		if (clk_set_parent(clks[plan->src], plan->pll) ||
+		    clk_set_rate(clks[plan->src], plan->src_rate)) {
+			pr_warn("%s: failed to set up %s\n", __func__,
+				__clk_get_name(clks[plan->src]));
+			plan->pll = NULL;
+			continue;
+		}
+
+		/* the plan only holds as long as the pll stays where it is */
+		clk_rate_exclusive_get(plan->pll);
+
+		if (best)
+			pr_warn("%s: %s from %s/%d, audio rates off by up to %lld ppb\n",
+				__func__, __clk_get_name(clks[plan->src]),
+				__clk_get_name(plan->pll), best_div, best);
+	}
+}
+
+#if defined(CONFIG_DEBUG_FS) && !defined(MODULE)
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+
+static int rv1106_audio_plan_show(struct seq_file *s, void *data)
+{
+	struct clk **clks = cru_ctx->clk_data.clks;
+	struct rv1106_audio_plan *plan;
+	static const unsigned long fs[] = { 44100, 48000 };
+	unsigned long rate, k;
+	s64 err, best;
+	int i, j;
+
+	for (i = 0; i < ARRAY_SIZE(rv1106_audio_plans); i++) {
+		plan = &rv1106_audio_plans[i];
+		if (!plan->pll)
+			continue;
+
+		seq_printf(s, "%s: %s/%lu = %lu Hz\n",
+			   __clk_get_name(clks[plan->src]),
+			   __clk_get_name(plan->pll),
+			   clk_get_rate(plan->pll) / plan->src_rate,
+			   plan->src_rate);
+		for (j = 0; j < ARRAY_SIZE(rv1106_audio_rates); j++)
+			seq_printf(s, "  plan %lu Hz: %lld ppb\n",
+				   rv1106_audio_rates[j], plan->err_ppb[j]);
+
+		/* error of the current rate from the nearest fs multiple */
+		rate = clk_get_rate(clks[plan->frac]);
+		best = S64_MAX;
+		for (j = 0; j < ARRAY_SIZE(fs); j++) {
+			k = DIV_ROUND_CLOSEST(rate, fs[j]);
+			if (!k)
+				continue;
+			err = rv1106_audio_err_ppb(rate, k * fs[j]);
+			if (abs(err) < abs(best))
+				best = err;
+		}
+		seq_printf(s, "  %s: %lu Hz, %lld ppb\n",
+			   __clk_get_name(clks[plan->frac]), rate,
+			   best == S64_MAX ? 0 : best);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(rv1106_audio_plan);
+
+static int __init rv1106_audio_plan_debug_init(void)
+{
+	struct dentry *rootdir;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(rv1106_audio_plans); i++)
+		if (rv1106_audio_plans[i].pll)
+			break;
+	if (i == ARRAY_SIZE(rv1106_audio_plans))
+		return 0;
+
+	rootdir = debugfs_lookup("clk", NULL);
+	if (!rootdir) {
+		pr_err("%s: failed to lookup clk dentry\n", __func__);
+		return -ENOMEM;
+	}
+
+	debugfs_create_file("rv1106_audio_plan", 0444, rootdir, NULL,
+			    &rv1106_audio_plan_fops);
+
+	return 0;
+}
+late_initcall(rv1106_audio_plan_debug_init);
+#endif
+
 static int rv1106_clk_panic(struct notifier_block *this,
 			    unsigned long ev, void *ptr)
 {
@@ -1201,6 +1390,10 @@ static void __init rv1106_clk_init(struct device_node *np)
 
 	rockchip_clk_of_add_provider(np, ctx);
 
+	/* after the assigned-clocks of the cru, which it overrides */
+	if (of_property_read_bool(np, "rockchip,audio-clk-plan"))
+		rv1106_audio_clk_plan(cru_clks);
+
 	atomic_notifier_chain_register(&panic_notifier_list,
 				       &rv1106_clk_panic_block);
 }
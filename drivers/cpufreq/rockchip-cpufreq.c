@@ -32,6 +32,7 @@
 #include <linux/regmap.h>
 #include <linux/regulator/consumer.h>
 #include <linux/rockchip/cpu.h>
+#include <soc/rockchip/rockchip_cpufreq.h>
 #include <soc/rockchip/rockchip_opp_select.h>
 #include <soc/rockchip/rockchip_system_monitor.h>
 
@@ -43,6 +44,8 @@ struct cluster_info {
 	struct monitor_dev_info *mdev_info;
 	struct rockchip_opp_info opp_info;
 	struct freq_qos_request dsu_qos_req;
+	struct freq_qos_request audio_qos_req;
+	unsigned int audio_max_freq;
 	cpumask_t cpus;
 	unsigned int idle_threshold_freq;
 	int scale;
@@ -54,6 +57,14 @@ struct cluster_info {
 };
 static LIST_HEAD(cluster_info_list);
 
+/* PCM buffer fill, in percent, below which the cpu floor is the max */
+#define AUDIO_FILL_LOW		25
+/* and above which there is no floor, it is linear in between */
+#define AUDIO_FILL_HIGH		75
+
+static LIST_HEAD(audio_req_list);
+static DEFINE_MUTEX(audio_req_lock);
+
 static int px30_get_soc_info(struct device *dev, struct device_node *np,
 			     int *bin, int *process)
 {
@@ -791,6 +802,90 @@ static int rockchip_cpufreq_add_dsu_qos_req(struct cluster_info *cluster,
 	return ret;
 }
 
+static unsigned int rockchip_cpufreq_audio_floor(struct cluster_info *cluster,
+						 int fill)
+{
+	if (fill < 0 || fill >= AUDIO_FILL_HIGH)
+		return FREQ_QOS_MIN_DEFAULT_VALUE;
+	if (fill <= AUDIO_FILL_LOW)
+		return cluster->audio_max_freq;
+
+	return cluster->audio_max_freq / (AUDIO_FILL_HIGH - AUDIO_FILL_LOW) *
+	       (AUDIO_FILL_HIGH - fill);
+}
+
+/* Called with audio_req_lock held */
+static void rockchip_cpufreq_audio_apply(void)
+{
+	struct cpufreq_audio_req *req;
+	struct cluster_info *cluster;
+	int fill = -1;
+
+	list_for_each_entry(req, &audio_req_list, node) {
+		if (fill < 0 || req->fill < fill)
+			fill = req->fill;
+	}
+
+	list_for_each_entry(cluster, &cluster_info_list, list_head) {
+		if (!freq_qos_request_active(&cluster->audio_qos_req))
+			continue;
+		freq_qos_update_request(&cluster->audio_qos_req,
+					rockchip_cpufreq_audio_floor(cluster,
+								     fill));
+	}
+}
+
+/*
+ * Floor the cpu rate from how full the PCM buffers are, so that the cpu
+ * speeds up before the decoder falls behind instead of after. @fill is the
+ * queued part of the buffer in percent, a negative one drops the request.
+ * May sleep.
+ */
+void rockchip_cpufreq_audio_fill_update(struct cpufreq_audio_req *req,
+					int fill)
+{
+	mutex_lock(&audio_req_lock);
+	if (fill < 0 && req->active)
+		list_del(&req->node);
+	else if (fill >= 0 && !req->active)
+		list_add(&req->node, &audio_req_list);
+	req->active = fill >= 0;
+	req->fill = fill;
+	rockchip_cpufreq_audio_apply();
+	mutex_unlock(&audio_req_lock);
+}
+EXPORT_SYMBOL_GPL(rockchip_cpufreq_audio_fill_update);
+
+static int rockchip_cpufreq_add_audio_req(struct cluster_info *cluster,
+					  struct cpufreq_policy *policy)
+{
+	int ret;
+
+	mutex_lock(&audio_req_lock);
+	cluster->audio_max_freq = policy->cpuinfo.max_freq;
+	ret = freq_qos_add_request(&policy->constraints,
+				   &cluster->audio_qos_req, FREQ_QOS_MIN,
+				   FREQ_QOS_MIN_DEFAULT_VALUE);
+	if (ret >= 0)
+		rockchip_cpufreq_audio_apply();
+	mutex_unlock(&audio_req_lock);
+	if (ret < 0) {
+		dev_err(cluster->opp_info.dev,
+			"failed to add audio freq constraint\n");
+		return ret;
+	}
+
+	return 0;
+}
+
+static void rockchip_cpufreq_remove_audio_req(struct cluster_info *cluster)
+{
+	mutex_lock(&audio_req_lock);
+	if (freq_qos_request_active(&cluster->audio_qos_req))
+		freq_qos_remove_request(&cluster->audio_qos_req);
+	mutex_unlock(&audio_req_lock);
+}
+
 static int rockchip_cpufreq_notifier(struct notifier_block *nb,
 				     unsigned long event, void *data)
 {
@@ -806,9 +901,12 @@ static int rockchip_cpufreq_notifier(struct notifier_block *nb,
 			return NOTIFY_BAD;
 		if (rockchip_cpufreq_add_dsu_qos_req(cluster, policy))
 			return NOTIFY_BAD;
+		if (rockchip_cpufreq_add_audio_req(cluster, policy))
+			return NOTIFY_BAD;
 	} else if (event == CPUFREQ_REMOVE_POLICY) {
 		rockchip_cpufreq_remove_monitor(cluster);
 		rockchip_cpufreq_remove_dsu_qos(cluster);
+		rockchip_cpufreq_remove_audio_req(cluster);
 	}
 
 	return NOTIFY_OK;
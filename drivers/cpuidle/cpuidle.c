@@ -316,6 +316,60 @@ int cpuidle_enter_state(struct cpuidle_device *dev, struct cpuidle_driver *drv,
 	return entered_state;
 }
 
+static DEFINE_PER_CPU(ktime_t, cpuidle_wakeup_hint);
+
+/**
+ * cpuidle_set_wakeup_hint - Tell cpuidle when the current CPU will be woken.
+ * @expires: Expected time of the next device interrupt, or 0 for none.
+ *
+ * For periodic device interrupts the governors cannot predict, such as audio
+ * DMA periods. Until @expires, the current CPU enters the deepest idle state
+ * whose target residency fits before @expires or the next timer, whichever
+ * comes first, and whose exit latency meets the PM QoS limit.
+ */
+void cpuidle_set_wakeup_hint(ktime_t expires)
+{
+	this_cpu_write(cpuidle_wakeup_hint, expires);
+}
+EXPORT_SYMBOL_GPL(cpuidle_set_wakeup_hint);
+
+static int cpuidle_select_hinted(struct cpuidle_driver *drv,
+				 struct cpuidle_device *dev, int index,
+				 bool stop_tick)
+{
+	ktime_t expires = __this_cpu_read(cpuidle_wakeup_hint);
+	ktime_t delta_tick, sleep_length;
+	s64 latency_req, slack;
+	int i;
+
+	if (!expires)
+		return index;
+
+	slack = ktime_to_ns(ktime_sub(expires, ktime_get()));
+	if (slack <= 0) {
+		__this_cpu_write(cpuidle_wakeup_hint, 0);
+		return index;
+	}
+
+	sleep_length = tick_nohz_get_sleep_length(&delta_tick);
+	slack = min_t(s64, slack, ktime_to_ns(stop_tick ? sleep_length :
+							  delta_tick));
+	latency_req = cpuidle_governor_latency_req(dev->cpu);
+
+	for (i = drv->state_count - 1; i > 0; i--) {
+		struct cpuidle_state *s = &drv->states[i];
+
+		if (dev->states_usage[i].disable)
+			continue;
+
+		if (s->target_residency_ns <= slack &&
+		    s->exit_latency_ns <= latency_req)
+			return i;
+	}
+
+	return 0;
+}
+
 /**
  * cpuidle_select - ask the cpuidle framework to choose an idle state
  *
@@ -332,7 +386,9 @@ int cpuidle_enter_state(struct cpuidle_device *dev, struct cpuidle_driver *drv,
 int cpuidle_select(struct cpuidle_driver *drv, struct cpuidle_device *dev,
 		   bool *stop_tick)
 {
-	return cpuidle_curr_governor->select(drv, dev, stop_tick);
+	int index = cpuidle_curr_governor->select(drv, dev, stop_tick);
+
+	return cpuidle_select_hinted(drv, dev, index, *stop_tick);
 }
 
 /**
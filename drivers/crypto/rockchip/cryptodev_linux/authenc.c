@@ -38,6 +38,7 @@
 #include <linux/pagemap.h>
 #include <linux/poll.h>
 #include <linux/uaccess.h>
+#include <crypto/algapi.h>
 #include <crypto/scatterwalk.h>
 #include <linux/scatterlist.h>
 #include "cryptodev.h"
@@ -1104,3 +1105,237 @@ int crypto_auth_run(struct fcrypt *fcr, struct kernel_crypt_auth_op *kcaop)
 	crypto_put_session(ses_ptr);
 	return ret;
 }
+
+#define MAX_SRTP_PKT_LEN 65535
+#define SRTP_IV_LEN 16
+
+int crypto_srtp_set_salt(struct fcrypt *fcr, void __user *arg)
+{
+	struct crypt_srtp_salt_op sop;
+	struct csession *ses_ptr;
+
+	if (unlikely(copy_from_user(&sop, arg, sizeof(sop))))
+		return -EFAULT;
+
+	/* this also enters ses_ptr->sem */
+	ses_ptr = crypto_get_session_by_sid(fcr, sop.ses);
+	if (unlikely(!ses_ptr)) {
+		derr(1, "invalid session ID=0x%08X", sop.ses);
+		return -EINVAL;
+	}
+
+	memcpy(ses_ptr->srtp_salt, sop.salt, sizeof(ses_ptr->srtp_salt));
+	ses_ptr->srtp_salt_set = true;
+
+	crypto_put_session(ses_ptr);
+
+	return 0;
+}
+
+/*
+ * IV = (salt * 2^16) XOR (SSRC * 2^64) XOR (index * 2^16), the index being
+ * ROC * 2^16 + SEQ (RFC 3711 4.1.1).
+ */
+static void srtp_make_iv(struct csession *ses_ptr, struct crypt_srtp_pkt *pkt,
+			 uint8_t *iv)
+{
+	__be32 ssrc = cpu_to_be32(pkt->ssrc), roc = cpu_to_be32(pkt->roc);
+	__be16 seq = cpu_to_be16(pkt->seq);
+	int i;
+
+	memset(iv, 0, SRTP_IV_LEN);
+	memcpy(iv + 4, &ssrc, sizeof(ssrc));
+	memcpy(iv + 8, &roc, sizeof(roc));
+	memcpy(iv + 12, &seq, sizeof(seq));
+
+	for (i = 0; i < RK_SRTP_SALT_LEN; i++)
+		iv[i] ^= ses_ptr->srtp_salt[i];
+}
+
+/* protect or unprotect one packet, the session is locked by the caller */
+static int srtp_batch_one(struct csession *ses_ptr, struct crypt_srtp_batch_op *bop,
+			  struct crypt_srtp_pkt *pkt, __be32 *roc)
+{
+	uint8_t __user *buf = u64_to_user_ptr(pkt->pkt);
+	uint8_t __user *tag = u64_to_user_ptr(pkt->tag);
+	uint8_t vhash[AALG_MAX_RESULT_LEN];
+	uint8_t hash_output[AALG_MAX_RESULT_LEN];
+	uint8_t iv[SRTP_IV_LEN];
+	struct scatterlist roc_sg, *payload_sg;
+	uint32_t payload_len;
+	int pagecount, ret;
+
+	if (unlikely(!pkt->len || pkt->len > MAX_SRTP_PKT_LEN ||
+		     pkt->hdr_len >= pkt->len)) {
+		derr(1, "invalid packet length %u (header %u)",
+		     pkt->len, pkt->hdr_len);
+		return -EINVAL;
+	}
+	payload_len = pkt->len - pkt->hdr_len;
+
+	if (bop->op == COP_DECRYPT &&
+	    unlikely(copy_from_user(vhash, tag, bop->tag_len)))
+		return -EFAULT;
+
+	srtp_make_iv(ses_ptr, pkt, iv);
+	cryptodev_cipher_set_iv(&ses_ptr->cdata, iv, sizeof(iv));
+
+	ret = cryptodev_hash_reset(&ses_ptr->hdata);
+	if (unlikely(ret)) {
+		derr(1, "error in cryptodev_hash_reset()");
+		return ret;
+	}
+
+	/* the second half of the array is for the payload, as in get_userbuf_srtp() */
+	pagecount = PAGECOUNT(buf, pkt->len);
+	if (ses_ptr->array_size < pagecount * 2) {
+		ret = cryptodev_adjust_sg_array(ses_ptr, pagecount * 2);
+		if (ret) {
+			derr(1, "cannot adjust sg array");
+			return ret;
+		}
+	}
+
+	ret = __cryptodev_get_userbuf(buf, pkt->len, 1, pagecount,
+				      ses_ptr->pages, ses_ptr->sg, current, current->mm);
+	if (unlikely(ret)) {
+		derr(1, "failed to get user pages for the packet");
+		return -EINVAL;
+	}
+	ses_ptr->used_pages = pagecount;
+	ses_ptr->readonly_pages = 0;
+
+	payload_sg = ses_ptr->sg + pagecount;
+	sg_init_table(payload_sg, pagecount);
+	cryptodev_sg_copy(ses_ptr->sg, payload_sg, pkt->len);
+	payload_sg = cryptodev_sg_advance(payload_sg, pkt->hdr_len);
+
+	*roc = cpu_to_be32(pkt->roc);
+	sg_init_one(&roc_sg, roc, sizeof(*roc));
+
+	/* SRTP authenticates the encrypted data */
+	if (bop->op == COP_ENCRYPT) {
+		ret = cryptodev_cipher_encrypt(&ses_ptr->cdata, payload_sg,
+					       payload_sg, payload_len);
+		if (unlikely(ret)) {
+			derr(0, "cryptodev_cipher_encrypt: %d", ret);
+			goto out;
+		}
+	}
+
+	ret = cryptodev_hash_update(&ses_ptr->hdata, ses_ptr->sg, pkt->len);
+	if (likely(!ret))
+		ret = cryptodev_hash_update(&ses_ptr->hdata, &roc_sg, sizeof(*roc));
+	if (likely(!ret))
+		ret = cryptodev_hash_final(&ses_ptr->hdata, hash_output);
+	if (unlikely(ret)) {
+		derr(0, "hash failure: %d", ret);
+		goto out;
+	}
+
+	if (bop->op == COP_ENCRYPT) {
+		if (unlikely(copy_to_user(tag, hash_output, bop->tag_len)))
+			ret = -EFAULT;
+		goto out;
+	}
+
+	if (crypto_memneq(vhash, hash_output, bop->tag_len)) {
+		derr(2, "MAC verification failed");
+		ret = -EBADMSG;
+		goto out;
+	}
+
+	ret = cryptodev_cipher_decrypt(&ses_ptr->cdata, payload_sg,
+				       payload_sg, payload_len);
+	if (unlikely(ret))
+		derr(0, "cryptodev_cipher_decrypt: %d", ret);
+
+out:
+	cryptodev_release_user_pages(ses_ptr);
+	return ret;
+}
+
+/*
+ * RIOCSRTP_BATCH: unlike COP_FLAG_AEAD_SRTP_TYPE operations the session is
+ * looked up and checked once for the whole batch, and the per packet IV
+ * is derived from the session salt instead of being passed by userspace.
+ */
+int crypto_srtp_batch(struct fcrypt *fcr, void __user *arg)
+{
+	struct crypt_srtp_batch_op bop;
+	struct crypt_srtp_pkt __user *upkts;
+	struct crypt_srtp_pkt pkt;
+	struct csession *ses_ptr;
+	__be32 *roc;
+	int ret = 0;
+
+	if (unlikely(copy_from_user(&bop, arg, sizeof(bop))))
+		return -EFAULT;
+
+	if (unlikely(bop.op != COP_ENCRYPT && bop.op != COP_DECRYPT)) {
+		ddebug(1, "invalid operation op=%u", bop.op);
+		return -EINVAL;
+	}
+
+	if (unlikely(!bop.count || bop.count > RK_CRYPTODEV_BATCH_MAX)) {
+		ddebug(1, "invalid batch size %u", bop.count);
+		return -EINVAL;
+	}
+
+	/* hashed by the engine, so not on the stack */
+	roc = kmalloc(sizeof(*roc), GFP_KERNEL);
+	if (unlikely(!roc))
+		return -ENOMEM;
+
+	/* this also enters ses_ptr->sem */
+	ses_ptr = crypto_get_session_by_sid(fcr, bop.ses);
+	if (unlikely(!ses_ptr)) {
+		derr(1, "invalid session ID=0x%08X", bop.ses);
+		ret = -EINVAL;
+		goto out_free;
+	}
+
+	if (unlikely(!ses_ptr->cdata.init || !ses_ptr->cdata.stream ||
+		     ses_ptr->cdata.aead || ses_ptr->cdata.ivsize != SRTP_IV_LEN ||
+		     !ses_ptr->hdata.init)) {
+		derr(0, "SRTP needs a stream cipher and a separate MAC");
+		ret = -EINVAL;
+		goto out_unlock;
+	}
+
+	if (unlikely(!ses_ptr->srtp_salt_set)) {
+		derr(1, "no SRTP salt for session 0x%08X", bop.ses);
+		ret = -EINVAL;
+		goto out_unlock;
+	}
+
+	if (unlikely(!bop.tag_len || bop.tag_len > ses_ptr->hdata.digestsize)) {
+		derr(1, "Illegal tag len size");
+		ret = -EINVAL;
+		goto out_unlock;
+	}
+
+	upkts = u64_to_user_ptr(bop.pkts);
+	for (bop.done = 0; bop.done < bop.count; bop.done++) {
+		if (unlikely(copy_from_user(&pkt, upkts + bop.done, sizeof(pkt)))) {
+			ret = -EFAULT;
+			goto out_unlock;
+		}
+
+		pkt.result = srtp_batch_one(ses_ptr, &bop, &pkt, roc);
+		if (unlikely(put_user(pkt.result, &upkts[bop.done].result))) {
+			ret = -EFAULT;
+			goto out_unlock;
+		}
+	}
+
+out_unlock:
+	crypto_put_session(ses_ptr);
+out_free:
+	kfree(roc);
+
+	if (!ret && unlikely(copy_to_user(arg, &bop, sizeof(bop))))
+		ret = -EFAULT;
+
+	return ret;
+}
@@ -36,6 +36,7 @@
 #include <crypto/authenc.h>
 #include "cryptodev.h"
 #include "cipherapi.h"
+#include "rk_cryptodev.h"
 
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(5, 0, 0))
 extern const struct crypto_type crypto_givcipher_type;
@@ -137,6 +138,73 @@ static int check_key_size(size_t keylen, const char *alg_name,
 	return 0;
 }
 
+/*
+ * Small requests are cheaper on the CPU than on the engine, so when the
+ * session runs on hardware keep a synchronous software tfm next to it for
+ * the requests below the crossover size of the algorithm. Not having one
+ * isn't an error, everything just goes to the main tfm.
+ */
+static void cryptodev_cipher_init_soft(struct cipher_data *out,
+				       uint8_t *keyp, size_t keylen)
+{
+	struct crypto_tfm *tfm = cryptodev_crypto_blkcipher_tfm(out->async.s);
+	const char *name = crypto_tfm_alg_name(tfm);
+	cryptodev_crypto_blkcipher_t *s;
+
+	out->soft_below = rk_cryptodev_soft_below(name);
+	if (!out->soft_below)
+		return;
+
+	s = cryptodev_crypto_alloc_blkcipher(name, 0, CRYPTO_ALG_ASYNC);
+	if (IS_ERR(s))
+		goto no_soft;
+
+	/* the main tfm is software already */
+	if (!strcmp(crypto_tfm_alg_driver_name(cryptodev_crypto_blkcipher_tfm(s)),
+		    crypto_tfm_alg_driver_name(tfm)))
+		goto free_tfm;
+
+	if (cryptodev_crypto_blkcipher_setkey(s, keyp, keylen))
+		goto free_tfm;
+
+	out->soft.request = cryptodev_blkcipher_request_alloc(s, GFP_KERNEL);
+	if (unlikely(!out->soft.request))
+		goto free_tfm;
+
+	cryptodev_blkcipher_request_set_callback(out->soft.request, 0,
+						 cryptodev_complete,
+						 &out->async.result);
+	out->soft.s = s;
+	ddebug(2, "software fallback %s",
+	       crypto_tfm_alg_driver_name(cryptodev_crypto_blkcipher_tfm(s)));
+	return;
+
+free_tfm:
+	cryptodev_crypto_free_blkcipher(s);
+no_soft:
+	out->soft_below = NULL;
+}
+
+static void cryptodev_cipher_deinit_soft(struct cipher_data *cdata)
+{
+	if (cdata->soft.s) {
+		cryptodev_blkcipher_request_free(cdata->soft.request);
+		cryptodev_crypto_free_blkcipher(cdata->soft.s);
+		cdata->soft.request = NULL;
+		cdata->soft.s = NULL;
+	}
+	cdata->soft_below = NULL;
+}
+
+static inline cryptodev_blkcipher_request_t *
+cryptodev_cipher_request(struct cipher_data *cdata, size_t len)
+{
+	if (cdata->soft.request && len < READ_ONCE(*cdata->soft_below))
+		return cdata->soft.request;
+
+	return cdata->async.request;
+}
+
 int cryptodev_cipher_init(struct cipher_data *out, const char *alg_name,
 				uint8_t *keyp, size_t keylen, int stream, int aead)
 {
@@ -229,6 +297,8 @@ int cryptodev_cipher_init(struct cipher_data *out, const char *alg_name,
 		cryptodev_blkcipher_request_set_callback(out->async.request,
 					CRYPTO_TFM_REQ_MAY_BACKLOG,
 					cryptodev_complete, &out->async.result);
+
+		cryptodev_cipher_init_soft(out, keyp, keylen);
 	} else {
 		out->async.arequest = aead_request_alloc(out->async.as, GFP_KERNEL);
 		if (unlikely(!out->async.arequest)) {
@@ -262,6 +332,7 @@ void cryptodev_cipher_deinit(struct cipher_data *cdata)
 {
 	if (cdata->init) {
 		if (cdata->aead == 0) {
+			cryptodev_cipher_deinit_soft(cdata);
 			cryptodev_blkcipher_request_free(cdata->async.request);
 			cryptodev_crypto_free_blkcipher(cdata->async.s);
 		} else {
@@ -311,10 +382,12 @@ ssize_t cryptodev_cipher_encrypt(struct cipher_data *cdata,
 	reinit_completion(&cdata->async.result.completion);
 
 	if (cdata->aead == 0) {
-		cryptodev_blkcipher_request_set_crypt(cdata->async.request,
+		cryptodev_blkcipher_request_t *req = cryptodev_cipher_request(cdata, len);
+
+		cryptodev_blkcipher_request_set_crypt(req,
 			(struct scatterlist *)src, dst,
 			len, cdata->async.iv);
-		ret = cryptodev_crypto_blkcipher_encrypt(cdata->async.request);
+		ret = cryptodev_crypto_blkcipher_encrypt(req);
 	} else {
 		aead_request_set_crypt(cdata->async.arequest,
 			(struct scatterlist *)src, dst,
@@ -333,10 +406,12 @@ ssize_t cryptodev_cipher_decrypt(struct cipher_data *cdata,
 
 	reinit_completion(&cdata->async.result.completion);
 	if (cdata->aead == 0) {
-		cryptodev_blkcipher_request_set_crypt(cdata->async.request,
+		cryptodev_blkcipher_request_t *req = cryptodev_cipher_request(cdata, len);
+
+		cryptodev_blkcipher_request_set_crypt(req,
 			(struct scatterlist *)src, dst,
 			len, cdata->async.iv);
-		ret = cryptodev_crypto_blkcipher_decrypt(cdata->async.request);
+		ret = cryptodev_crypto_blkcipher_decrypt(req);
 	} else {
 		aead_request_set_crypt(cdata->async.arequest,
 			(struct scatterlist *)src, dst,
@@ -31,6 +31,13 @@ struct cipher_data {
 		struct cryptodev_result result;
 		uint8_t iv[EALG_MAX_BLOCK_LEN];
 	} async;
+
+	/* software implementation, used below *soft_below bytes */
+	struct {
+		cryptodev_crypto_blkcipher_t *s;
+		cryptodev_blkcipher_request_t *request;
+	} soft;
+	const unsigned int *soft_below;
 };
 
 int cryptodev_cipher_init(struct cipher_data *out, const char *alg_name,
@@ -20,6 +20,7 @@
 #include <linux/moduleparam.h>
 #include <linux/scatterlist.h>
 #include <uapi/linux/cryptodev.h>
+#include <uapi/linux/rk_cryptodev.h>
 #include <crypto/aead.h>
 
 #define PFX "cryptodev: "
@@ -152,6 +153,8 @@ int cryptodev_kcaop_from_user(struct kernel_crypt_auth_op *kcop,
 int cryptodev_kcaop_to_user(struct kernel_crypt_auth_op *kcaop,
 		struct fcrypt *fcr, void __user *arg);
 int crypto_auth_run(struct fcrypt *fcr, struct kernel_crypt_auth_op *kcaop);
+int crypto_srtp_set_salt(struct fcrypt *fcr, void __user *arg);
+int crypto_srtp_batch(struct fcrypt *fcr, void __user *arg);
 int crypto_run(struct fcrypt *fcr, struct kernel_crypt_op *kcop);
 
 #include "cryptlib.h"
@@ -171,6 +174,10 @@ struct csession {
 	unsigned int readonly_pages;
 	struct page **pages;
 	struct scatterlist *sg;
+
+	/* RIOCSRTP_SESSION_SALT */
+	bool srtp_salt_set;
+	uint8_t srtp_salt[RK_SRTP_SALT_LEN];
 };
 
 struct csession *crypto_get_session_by_sid(struct fcrypt *fcr, uint32_t sid);
@@ -37,6 +37,7 @@
 #include <linux/mm.h>
 #include <linux/highmem.h>
 #include <linux/ioctl.h>
+#include <linux/kthread.h>
 #include <linux/random.h>
 #include <linux/syscalls.h>
 #include <linux/pagemap.h>
@@ -44,6 +45,7 @@
 #include <linux/uaccess.h>
 #include <linux/scatterlist.h>
 #include <linux/rtnetlink.h>
+#include <linux/sched/mm.h>
 #include <crypto/authenc.h>
 
 #include <linux/sysctl.h>
@@ -77,6 +79,18 @@ struct todo_list_item {
 	struct list_head __hook;
 	struct kernel_crypt_op kcop;
 	int result;
+
+	/*
+	 * 0, or the RIOCASYNC*_BATCH ioctl that queued the job, batches run
+	 * in the mm of their submitter
+	 */
+	unsigned int batch;
+	bool compat;
+	union {
+		struct crypt_auth_batch_op auth;
+		struct crypt_fd_batch_op fd;
+	} bop;
+	struct mm_struct *mm;
 };
 
 struct locked_list {
@@ -542,6 +556,87 @@ crypto_copy_hash_state(struct fcrypt *fcr, uint32_t dst_sid, uint32_t src_sid)
 }
 #endif /* CIOCCPHASH */
 
+static int crypto_auth_batch_one(struct fcrypt *fcr, void __user *arg,
+				 bool compat)
+{
+	struct kernel_crypt_auth_op kcaop;
+	int ret;
+
+#ifdef CONFIG_COMPAT
+	if (compat)
+		ret = compat_kcaop_from_user(&kcaop, fcr, arg);
+	else
+#endif
+		ret = cryptodev_kcaop_from_user(&kcaop, fcr, arg);
+	if (unlikely(ret))
+		return ret;
+
+	ret = crypto_auth_run(fcr, &kcaop);
+	if (unlikely(ret))
+		return ret;
+
+#ifdef CONFIG_COMPAT
+	if (compat)
+		return compat_kcaop_to_user(&kcaop, fcr, arg);
+#endif
+	return cryptodev_kcaop_to_user(&kcaop, fcr, arg);
+}
+
+/* run all the operations of a RIOC*AUTHCRYPT_BATCH request */
+static int crypto_auth_batch_run(struct fcrypt *fcr,
+				 struct crypt_auth_batch_op *bop, bool compat)
+{
+	u8 __user *ops = u64_to_user_ptr(bop->ops);
+	s32 __user *results = u64_to_user_ptr(bop->results);
+	size_t size = sizeof(struct crypt_auth_op);
+	int ret;
+
+#ifdef CONFIG_COMPAT
+	if (compat)
+		size = sizeof(struct compat_crypt_auth_op);
+#endif
+
+	for (bop->done = 0; bop->done < bop->count; bop->done++) {
+		ret = crypto_auth_batch_one(fcr, ops + bop->done * size, compat);
+		if (unlikely(ret))
+			dwarning(2, "batch operation %u failed: %d",
+				 bop->done, ret);
+		if (unlikely(put_user(ret, results + bop->done)))
+			return -EFAULT;
+	}
+
+	return 0;
+}
+
+static int crypto_batch_check(u32 count)
+{
+	if (unlikely(!count || count > RK_CRYPTODEV_BATCH_MAX)) {
+		ddebug(1, "invalid batch size %u", count);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int crypto_auth_batch(struct fcrypt *fcr, void __user *arg, bool compat)
+{
+	struct crypt_auth_batch_op bop;
+	int ret;
+
+	if (unlikely(copy_from_user(&bop, arg, sizeof(bop))))
+		return -EFAULT;
+
+	ret = crypto_batch_check(bop.count);
+	if (unlikely(ret))
+		return ret;
+
+	ret = crypto_auth_batch_run(fcr, &bop, compat);
+	if (unlikely(ret))
+		return ret;
+
+	return copy_to_user(arg, &bop, sizeof(bop)) ? -EFAULT : 0;
+}
+
 static void cryptask_routine(struct work_struct *work)
 {
 	struct crypt_priv *pcr = container_of(work, struct crypt_priv, cryptask);
@@ -555,6 +650,26 @@ static void cryptask_routine(struct work_struct *work)
 
 	/* handle each job locklessly */
 	list_for_each_entry(item, &tmp, __hook) {
+		if (item->batch) {
+			/* the operations and their buffers are user memory */
+			kthread_use_mm(item->mm);
+			if (item->batch == RIOCASYNCCRYPT_FD_BATCH)
+				item->result = rk_cryptodev_fd_batch_run(&pcr->fcrypt,
+									 &item->bop.fd,
+									 item->compat,
+									 true);
+			else
+				item->result = crypto_auth_batch_run(&pcr->fcrypt,
+								     &item->bop.auth,
+								     item->compat);
+			kthread_unuse_mm(item->mm);
+			mmput(item->mm);
+			item->mm = NULL;
+			if (unlikely(item->result))
+				derr(0, "batch failed: %d", item->result);
+			continue;
+		}
+
 		item->result = crypto_run(&pcr->fcrypt, &item->kcop);
 		if (unlikely(item->result))
 			derr(0, "crypto_run() failed: %d", item->result);
@@ -637,6 +752,11 @@ cryptodev_release(struct inode *inode, struct file *filp)
 
 	cancel_work_sync(&pcr->cryptask);
 
+	/* batches that never ran still hold the mm of their submitter */
+	list_for_each_entry(item, &pcr->todo.list, __hook)
+		if (item->mm)
+			mmput(item->mm);
+
 	list_splice_tail(&pcr->todo.list, &pcr->free.list);
 	list_splice_tail(&pcr->done.list, &pcr->free.list);
 
@@ -675,13 +795,10 @@ cryptodev_release(struct inode *inode, struct file *filp)
  *        (and the number of slots has reached it MAX_COP_RINGSIZE)
  * -EFAULT when there was a memory allocation error
  * 0 on success */
-static int crypto_async_run(struct crypt_priv *pcr, struct kernel_crypt_op *kcop)
+static struct todo_list_item *crypto_async_get_item(struct crypt_priv *pcr)
 {
 	struct todo_list_item *item = NULL;
 
-	if (unlikely(kcop->cop.flags & COP_FLAG_NO_ZC))
-		return -EINVAL;
-
 	mutex_lock(&pcr->free.lock);
 	if (likely(!list_empty(&pcr->free.list))) {
 		item = list_first_entry(&pcr->free.list,
@@ -691,27 +808,111 @@ static int crypto_async_run(struct crypt_priv *pcr, struct kernel_crypt_op *kcop
 		pcr->itemcount++;
 	} else {
 		mutex_unlock(&pcr->free.lock);
-		return -EBUSY;
+		return ERR_PTR(-EBUSY);
 	}
 	mutex_unlock(&pcr->free.lock);
 
 	if (unlikely(!item)) {
 		item = kzalloc(sizeof(struct todo_list_item), GFP_KERNEL);
 		if (unlikely(!item))
-			return -EFAULT;
+			return ERR_PTR(-EFAULT);
 		dinfo(1, "increased item count to %d", pcr->itemcount);
 	}
 
-	memcpy(&item->kcop, kcop, sizeof(struct kernel_crypt_op));
+	return item;
+}
 
+static void crypto_async_queue(struct crypt_priv *pcr,
+			       struct todo_list_item *item)
+{
 	mutex_lock(&pcr->todo.lock);
 	list_add_tail(&item->__hook, &pcr->todo.list);
 	mutex_unlock(&pcr->todo.lock);
 
 	queue_work(cryptodev_wq, &pcr->cryptask);
+}
+
+static int crypto_async_run(struct crypt_priv *pcr, struct kernel_crypt_op *kcop)
+{
+	struct todo_list_item *item;
+
+	if (unlikely(kcop->cop.flags & COP_FLAG_NO_ZC))
+		return -EINVAL;
+
+	item = crypto_async_get_item(pcr);
+	if (IS_ERR(item))
+		return PTR_ERR(item);
+
+	memcpy(&item->kcop, kcop, sizeof(struct kernel_crypt_op));
+	item->batch = 0;
+
+	crypto_async_queue(pcr, item);
+	return 0;
+}
+
+static int crypto_async_batch_run(struct crypt_priv *pcr, unsigned int cmd,
+				  void __user *arg, bool compat)
+{
+	struct todo_list_item *item;
+	typeof(item->bop) bop;
+	int ret;
+
+	BUILD_BUG_ON(sizeof(bop.auth) != sizeof(bop.fd));
+
+	if (unlikely(copy_from_user(&bop, arg, sizeof(bop))))
+		return -EFAULT;
+
+	if (cmd == RIOCASYNCCRYPT_FD_BATCH)
+		ret = crypto_batch_check(bop.fd.count);
+	else
+		ret = crypto_batch_check(bop.auth.count);
+	if (unlikely(ret))
+		return ret;
+
+	item = crypto_async_get_item(pcr);
+	if (IS_ERR(item))
+		return PTR_ERR(item);
+
+	item->bop = bop;
+	item->batch = cmd;
+	item->compat = compat;
+	item->mm = current->mm;
+	mmget(item->mm);
+
+	crypto_async_queue(pcr, item);
 	return 0;
 }
 
+/* take the first completed job of the requested kind off the "done" queue */
+static struct todo_list_item *crypto_async_take_done(struct crypt_priv *pcr,
+						     unsigned int batch)
+{
+	struct todo_list_item *item;
+
+	mutex_lock(&pcr->done.lock);
+	list_for_each_entry(item, &pcr->done.list, __hook) {
+		if (item->batch == batch) {
+			list_del(&item->__hook);
+			mutex_unlock(&pcr->done.lock);
+			return item;
+		}
+	}
+	mutex_unlock(&pcr->done.lock);
+
+	return NULL;
+}
+
+static void crypto_async_put_free(struct crypt_priv *pcr,
+				  struct todo_list_item *item)
+{
+	mutex_lock(&pcr->free.lock);
+	list_add_tail(&item->__hook, &pcr->free.list);
+	mutex_unlock(&pcr->free.lock);
+
+	/* wake for POLLOUT */
+	wake_up_interruptible(&pcr->user_waiter);
+}
+
 /* get the first completed job from the "done" queue
  *
  * returns:
@@ -723,24 +924,34 @@ static int crypto_async_fetch(struct crypt_priv *pcr,
 	struct todo_list_item *item;
 	int retval;
 
-	mutex_lock(&pcr->done.lock);
-	if (list_empty(&pcr->done.list)) {
-		mutex_unlock(&pcr->done.lock);
+	item = crypto_async_take_done(pcr, 0);
+	if (!item)
 		return -EBUSY;
-	}
-	item = list_first_entry(&pcr->done.list, struct todo_list_item, __hook);
-	list_del(&item->__hook);
-	mutex_unlock(&pcr->done.lock);
 
 	memcpy(kcop, &item->kcop, sizeof(struct kernel_crypt_op));
 	retval = item->result;
 
-	mutex_lock(&pcr->free.lock);
-	list_add_tail(&item->__hook, &pcr->free.list);
-	mutex_unlock(&pcr->free.lock);
+	crypto_async_put_free(pcr, item);
 
-	/* wake for POLLOUT */
-	wake_up_interruptible(&pcr->user_waiter);
+	return retval;
+}
+
+/* same for batches, the updated request is copied back to @arg */
+static int crypto_async_batch_fetch(struct crypt_priv *pcr, unsigned int batch,
+				    void __user *arg)
+{
+	struct todo_list_item *item;
+	int retval;
+
+	item = crypto_async_take_done(pcr, batch);
+	if (!item)
+		return -EBUSY;
+
+	retval = item->result;
+	if (copy_to_user(arg, &item->bop, sizeof(item->bop)))
+		retval = -EFAULT;
+
+	crypto_async_put_free(pcr, item);
 
 	return retval;
 }
@@ -1005,7 +1216,22 @@ cryptodev_ioctl(struct file *filp, unsigned int cmd, unsigned long arg_)
 			return ret;
 		}
 		return cryptodev_kcaop_to_user(&kcaop, fcr, arg);
+	case RIOCAUTHCRYPT_BATCH:
+		return crypto_auth_batch(fcr, arg, false);
+	case RIOCSRTP_SESSION_SALT:
+		return crypto_srtp_set_salt(fcr, arg);
+	case RIOCSRTP_BATCH:
+		return crypto_srtp_batch(fcr, arg);
 #ifdef ENABLE_ASYNC
+	case RIOCASYNCAUTHCRYPT_BATCH:
+	case RIOCASYNCCRYPT_FD_BATCH:
+		return crypto_async_batch_run(pcr, cmd, arg, false);
+	case RIOCASYNCAUTHFETCH_BATCH:
+		return crypto_async_batch_fetch(pcr, RIOCASYNCAUTHCRYPT_BATCH,
+						arg);
+	case RIOCASYNCFETCH_FD_BATCH:
+		return crypto_async_batch_fetch(pcr, RIOCASYNCCRYPT_FD_BATCH,
+						arg);
 	case CIOCASYNCCRYPT:
 		if (unlikely(ret = kcop_from_user(&kcop, fcr, arg)))
 			return ret;
@@ -1178,7 +1404,23 @@ cryptodev_compat_ioctl(struct file *file, unsigned int cmd, unsigned long arg_)
 			return ret;
 		}
 		return compat_kcaop_to_user(&kcaop, fcr, arg);
+	/* these have the same layout for 32bit */
+	case RIOCAUTHCRYPT_BATCH:
+		return crypto_auth_batch(fcr, arg, true);
+	case RIOCSRTP_SESSION_SALT:
+		return crypto_srtp_set_salt(fcr, arg);
+	case RIOCSRTP_BATCH:
+		return crypto_srtp_batch(fcr, arg);
 #ifdef ENABLE_ASYNC
+	case RIOCASYNCAUTHCRYPT_BATCH:
+	case RIOCASYNCCRYPT_FD_BATCH:
+		return crypto_async_batch_run(pcr, cmd, arg, true);
+	case RIOCASYNCAUTHFETCH_BATCH:
+		return crypto_async_batch_fetch(pcr, RIOCASYNCAUTHCRYPT_BATCH,
+						arg);
+	case RIOCASYNCFETCH_FD_BATCH:
+		return crypto_async_batch_fetch(pcr, RIOCASYNCCRYPT_FD_BATCH,
+						arg);
 	case COMPAT_CIOCASYNCCRYPT:
 		if (unlikely(ret = compat_kcop_from_user(&kcop, fcr, arg)))
 			return ret;
@@ -1290,6 +1532,8 @@ static int __init init_cryptodev(void)
 
 	verbosity_sysctl_header = register_sysctl_table(verbosity_ctl_root);
 
+	rk_cryptodev_soft_init();
+
 	pr_info(PFX "driver %s loaded.\n", VERSION);
 
 	return 0;
@@ -1300,6 +1544,8 @@ static void __exit exit_cryptodev(void)
 	flush_workqueue(cryptodev_wq);
 	destroy_workqueue(cryptodev_wq);
 
+	rk_cryptodev_soft_exit();
+
 	if (verbosity_sysctl_header)
 		unregister_sysctl_table(verbosity_sysctl_header);
 
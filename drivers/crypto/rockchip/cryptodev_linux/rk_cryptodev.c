@@ -9,6 +9,7 @@
  */
 #include <crypto/internal/akcipher.h>
 #include <crypto/internal/rsa.h>
+#include <crypto/skcipher.h>
 #include <linux/kernel.h>
 #include <linux/scatterlist.h>
 #include <linux/rtnetlink.h>
@@ -16,7 +17,12 @@
 #include <linux/dma-mapping.h>
 #include <linux/dma-direct.h>
 #include <linux/dma-buf.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
+#include <linux/proc_fs.h>
+#include <linux/random.h>
+#include <linux/seq_file.h>
+#include <linux/sizes.h>
 
 #include "version.h"
 #include "cipherapi.h"
@@ -41,6 +47,14 @@ struct crypto_dev_info {
 
 static struct crypto_dev_info g_dev_infos[MAX_CRYPTO_DEV];
 
+static bool soft_bench;
+module_param(soft_bench, bool, 0444);
+MODULE_PARM_DESC(soft_bench,
+		 "Measure the engine/software crossover sizes when the engine registers");
+
+static void rk_soft_bench_work_fn(struct work_struct *work);
+static DECLARE_WORK(rk_soft_bench_work, rk_soft_bench_work_fn);
+
 /*
  * rk_cryptodev_register_dev - register crypto device into rk_cryptodev.
  * @dev:	[in]	crypto device to register
@@ -65,6 +79,9 @@ int rk_cryptodev_register_dev(struct device *dev, const char *name)
 
 			g_dev_infos[i].is_multi_thread = strstr(g_dev_infos[i].name, "multi");
 			dev_info(dev, "register to cryptodev ok!\n");
+
+			if (soft_bench)
+				schedule_work(&rk_soft_bench_work);
 			return 0;
 		}
 	}
@@ -127,6 +144,7 @@ static int fill_kcop_fd_from_cop(struct kernel_crypt_fd_op *kcop, struct fcrypt
 
 	kcop->task = current;
 	kcop->mm = current->mm;
+	kcop->mapped_only = false;
 
 	if (cop->iv) {
 		rc = copy_from_user(kcop->iv, cop->iv, kcop->ivlen);
@@ -351,6 +369,10 @@ static int __crypto_fd_run(struct fcrypt *fcr, struct csession *ses_ptr,
 	node_src = dma_fd_find_node(fcr, kcop->cop.src_fd);
 	if (node_src) {
 		sg_tbl_in = node_src->sgtbl;
+	} else if (kcop->mapped_only) {
+		derr(1, "src fd %d isn't mapped.", kcop->cop.src_fd);
+		ret = -EBADF;
+		goto exit;
 	} else {
 		ret = get_dmafd_sgtbl(kcop->cop.src_fd, kcop->cop.len, DMA_TO_DEVICE,
 				&sg_tbl_in, &dma_attach_in, &dma_buf_in);
@@ -365,6 +387,10 @@ static int __crypto_fd_run(struct fcrypt *fcr, struct csession *ses_ptr,
 		node_dst = dma_fd_find_node(fcr, kcop->cop.dst_fd);
 		if (node_dst) {
 			sg_tbl_out = node_dst->sgtbl;
+		} else if (kcop->mapped_only) {
+			derr(1, "dst fd %d isn't mapped.", kcop->cop.dst_fd);
+			ret = -EBADF;
+			goto exit;
 		} else {
 			ret = get_dmafd_sgtbl(kcop->cop.dst_fd, kcop->cop.len, DMA_FROM_DEVICE,
 				&sg_tbl_out, &dma_attach_out, &dma_buf_out);
@@ -1123,6 +1149,26 @@ static int kcaop_fd_to_user(struct kernel_crypt_auth_fd_op *kcaop,
 	return 0;
 }
 
+static int rk_cryptodev_fd_batch(struct fcrypt *fcr, void __user *arg, bool compat)
+{
+	struct crypt_fd_batch_op bop;
+	int ret;
+
+	if (unlikely(copy_from_user(&bop, arg, sizeof(bop))))
+		return -EFAULT;
+
+	if (unlikely(!bop.count || bop.count > RK_CRYPTODEV_BATCH_MAX)) {
+		ddebug(1, "invalid batch size %u", bop.count);
+		return -EINVAL;
+	}
+
+	ret = rk_cryptodev_fd_batch_run(fcr, &bop, compat, false);
+	if (unlikely(ret))
+		return ret;
+
+	return copy_to_user(arg, &bop, sizeof(bop)) ? -EFAULT : 0;
+}
+
 long
 rk_cryptodev_ioctl(struct fcrypt *fcr, unsigned int cmd, unsigned long arg_)
 {
@@ -1148,6 +1194,8 @@ rk_cryptodev_ioctl(struct fcrypt *fcr, unsigned int cmd, unsigned long arg_)
 		}
 
 		return kcop_fd_to_user(&kcop, fcr, arg);
+	case RIOCCRYPT_FD_BATCH:
+		return rk_cryptodev_fd_batch(fcr, arg, false);
 	case RIOCAUTHCRYPT_FD:
 		ret = kcaop_fd_from_user(&kcaop, fcr, arg);
 		if (unlikely(ret)) {
@@ -1358,6 +1406,9 @@ rk_compat_cryptodev_ioctl(struct fcrypt *fcr, unsigned int cmd, unsigned long ar
 		}
 
 		return compat_kcop_fd_to_user(&kcop, fcr, arg);
+	/* struct crypt_fd_batch_op has the same layout for 32bit */
+	case RIOCCRYPT_FD_BATCH:
+		return rk_cryptodev_fd_batch(fcr, arg, true);
 	case COMPAT_RIOCCRYPT_FD_MAP:
 		ret = compat_kcop_map_fd_from_user(&kmop, fcr, arg);
 		if (unlikely(ret)) {
@@ -1417,6 +1468,64 @@ rk_compat_cryptodev_ioctl(struct fcrypt *fcr, unsigned int cmd, unsigned long ar
 
 #endif /* CONFIG_COMPAT */
 
+static int rk_cryptodev_fd_batch_one(struct fcrypt *fcr, void __user *arg,
+				     bool compat, bool mapped_only)
+{
+	struct kernel_crypt_fd_op kcop;
+	int ret;
+
+#ifdef CONFIG_COMPAT
+	if (compat)
+		ret = compat_kcop_fd_from_user(&kcop, fcr, arg);
+	else
+#endif
+		ret = kcop_fd_from_user(&kcop, fcr, arg);
+	if (unlikely(ret))
+		return ret;
+
+	kcop.mapped_only = mapped_only;
+
+	ret = crypto_fd_run(fcr, &kcop);
+	if (unlikely(ret))
+		return ret;
+
+#ifdef CONFIG_COMPAT
+	if (compat)
+		return compat_kcop_fd_to_user(&kcop, fcr, arg);
+#endif
+	return kcop_fd_to_user(&kcop, fcr, arg);
+}
+
+/*
+ * Run all the operations of a RIOC*CRYPT_FD_BATCH request, @mapped_only
+ * when not called from the submitter, see struct crypt_fd_batch_op.
+ */
+int rk_cryptodev_fd_batch_run(struct fcrypt *fcr, struct crypt_fd_batch_op *bop,
+			      bool compat, bool mapped_only)
+{
+	u8 __user *ops = u64_to_user_ptr(bop->ops);
+	s32 __user *results = u64_to_user_ptr(bop->results);
+	size_t size = sizeof(struct crypt_fd_op);
+	int ret;
+
+#ifdef CONFIG_COMPAT
+	if (compat)
+		size = sizeof(struct compat_crypt_fd_op);
+#endif
+
+	for (bop->done = 0; bop->done < bop->count; bop->done++) {
+		ret = rk_cryptodev_fd_batch_one(fcr, ops + bop->done * size,
+						compat, mapped_only);
+		if (unlikely(ret))
+			dwarning(2, "batch operation %u failed: %d",
+				 bop->done, ret);
+		if (unlikely(put_user(ret, results + bop->done)))
+			return -EFAULT;
+	}
+
+	return 0;
+}
+
 struct cipher_algo_name_map {
 	uint32_t	id;
 	const char	*name;
@@ -1526,3 +1635,246 @@ bool rk_cryptodev_multi_thread(const char *name)
 
 	return false;
 }
+
+/*
+ * Engine/software crossover sizes. The setup of an engine request costs
+ * more than running a small one on the CPU, so sessions on the engine send
+ * the requests of less than @below bytes to the synchronous software
+ * implementation of the algorithm instead (see cryptodev_cipher_init_soft()).
+ * Nothing is measured by default, everything goes to the engine until
+ * "bench" or a size is written to /proc/rk_cryptodev_soft.
+ */
+#define RK_SOFT_BENCH_MIN	16
+#define RK_SOFT_BENCH_MAX	SZ_16K
+#define RK_SOFT_BENCH_BYTES	SZ_256K	/* per size and implementation */
+
+struct soft_crossover {
+	const char	*name;
+	unsigned int	keylen;
+	unsigned int	below;
+};
+
+static struct soft_crossover soft_crossover_tbl[] = {
+	{"ecb(aes)",	16},
+	{"cbc(aes)",	16},
+	{"ctr(aes)",	16},
+	{"xts(aes)",	32},
+	{"ecb(sm4)",	16},
+	{"cbc(sm4)",	16},
+	{"ctr(sm4)",	16},
+	{"xts(sm4)",	32},
+};
+
+static DEFINE_MUTEX(soft_bench_lock);
+static struct proc_dir_entry *soft_proc;
+
+static struct soft_crossover *soft_crossover_find(const char *name)
+{
+	uint32_t i;
+
+	for (i = 0; i < ARRAY_SIZE(soft_crossover_tbl); i++) {
+		if (!strcmp(name, soft_crossover_tbl[i].name))
+			return &soft_crossover_tbl[i];
+	}
+
+	return NULL;
+}
+
+const unsigned int *rk_cryptodev_soft_below(const char *name)
+{
+	struct soft_crossover *entry = soft_crossover_find(name);
+
+	return entry ? &entry->below : NULL;
+}
+
+/* average time of one @len bytes encryption, or a negative error */
+static s64 soft_bench_ns(struct crypto_skcipher *tfm, u8 *buf, u8 *iv,
+			 unsigned int len)
+{
+	unsigned int i, loops = max_t(unsigned int, RK_SOFT_BENCH_BYTES / len, 8);
+	struct skcipher_request *req;
+	struct scatterlist sg;
+	DECLARE_CRYPTO_WAIT(wait);
+	ktime_t start;
+	int ret = 0;
+
+	req = skcipher_request_alloc(tfm, GFP_KERNEL);
+	if (!req)
+		return -ENOMEM;
+
+	sg_init_one(&sg, buf, len);
+	skcipher_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
+				      crypto_req_done, &wait);
+	skcipher_request_set_crypt(req, &sg, &sg, len, iv);
+
+	start = ktime_get();
+	for (i = 0; i < loops && !ret; i++)
+		ret = crypto_wait_req(crypto_skcipher_encrypt(req), &wait);
+
+	skcipher_request_free(req);
+
+	if (ret)
+		return ret;
+
+	return div_u64(ktime_to_ns(ktime_sub(ktime_get(), start)), loops);
+}
+
+static int soft_bench_one(struct soft_crossover *entry, u8 *buf)
+{
+	struct crypto_skcipher *hw, *sw;
+	u8 *iv = buf + RK_SOFT_BENCH_MAX;
+	unsigned int len, below = RK_SOFT_BENCH_MAX;
+	s64 hw_ns, sw_ns;
+	u8 key[32];
+	int ret;
+
+	hw = crypto_alloc_skcipher(entry->name, 0, 0);
+	if (IS_ERR(hw))
+		return PTR_ERR(hw);
+
+	sw = crypto_alloc_skcipher(entry->name, 0, CRYPTO_ALG_ASYNC);
+	if (IS_ERR(sw)) {
+		ret = PTR_ERR(sw);
+		goto free_hw;
+	}
+
+	/* no engine for this one */
+	if (!strcmp(crypto_tfm_alg_driver_name(crypto_skcipher_tfm(hw)),
+		    crypto_tfm_alg_driver_name(crypto_skcipher_tfm(sw)))) {
+		below = 0;
+		ret = 0;
+		goto out;
+	}
+
+	get_random_bytes(key, entry->keylen);
+	ret = crypto_skcipher_setkey(hw, key, entry->keylen);
+	if (!ret)
+		ret = crypto_skcipher_setkey(sw, key, entry->keylen);
+	if (ret)
+		goto free_sw;
+
+	for (len = RK_SOFT_BENCH_MIN; len <= RK_SOFT_BENCH_MAX; len *= 2) {
+		hw_ns = soft_bench_ns(hw, buf, iv, len);
+		sw_ns = soft_bench_ns(sw, buf, iv, len);
+		if (hw_ns < 0 || sw_ns < 0) {
+			ret = hw_ns < 0 ? hw_ns : sw_ns;
+			goto free_sw;
+		}
+
+		ddebug(1, "%s %u bytes: %s %lld ns, %s %lld ns", entry->name, len,
+		       crypto_tfm_alg_driver_name(crypto_skcipher_tfm(hw)), hw_ns,
+		       crypto_tfm_alg_driver_name(crypto_skcipher_tfm(sw)), sw_ns);
+
+		if (hw_ns <= sw_ns) {
+			below = len;
+			break;
+		}
+	}
+
+out:
+	WRITE_ONCE(entry->below, below);
+free_sw:
+	crypto_free_skcipher(sw);
+free_hw:
+	crypto_free_skcipher(hw);
+
+	return ret;
+}
+
+static void soft_bench_all(void)
+{
+	uint32_t i;
+	u8 *buf;
+	int ret;
+
+	buf = kzalloc(RK_SOFT_BENCH_MAX + EALG_MAX_BLOCK_LEN, GFP_KERNEL);
+	if (!buf)
+		return;
+
+	mutex_lock(&soft_bench_lock);
+
+	for (i = 0; i < ARRAY_SIZE(soft_crossover_tbl); i++) {
+		ret = soft_bench_one(&soft_crossover_tbl[i], buf);
+		if (ret)
+			ddebug(1, "%s not measured: %d", soft_crossover_tbl[i].name, ret);
+	}
+
+	mutex_unlock(&soft_bench_lock);
+
+	kfree(buf);
+}
+
+static void rk_soft_bench_work_fn(struct work_struct *work)
+{
+	soft_bench_all();
+}
+
+static int soft_proc_show(struct seq_file *m, void *v)
+{
+	uint32_t i;
+
+	seq_puts(m, "algorithm  software below (bytes)\n");
+	for (i = 0; i < ARRAY_SIZE(soft_crossover_tbl); i++)
+		seq_printf(m, "%-10s %u\n", soft_crossover_tbl[i].name,
+			   READ_ONCE(soft_crossover_tbl[i].below));
+
+	return 0;
+}
+
+static int soft_proc_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, soft_proc_show, NULL);
+}
+
+/* "bench" measures every algorithm, "<algorithm> <bytes>" sets one */
+static ssize_t soft_proc_write(struct file *file, const char __user *ubuf,
+			       size_t count, loff_t *ppos)
+{
+	struct soft_crossover *entry;
+	char buf[64], name[32];
+	unsigned int below;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sysfs_streq(buf, "bench")) {
+		soft_bench_all();
+		return count;
+	}
+
+	if (sscanf(buf, "%31s %u", name, &below) != 2)
+		return -EINVAL;
+
+	entry = soft_crossover_find(name);
+	if (!entry)
+		return -ENOENT;
+
+	WRITE_ONCE(entry->below, below);
+
+	return count;
+}
+
+static const struct proc_ops soft_proc_ops = {
+	.proc_open	= soft_proc_open,
+	.proc_read	= seq_read,
+	.proc_write	= soft_proc_write,
+	.proc_lseek	= seq_lseek,
+	.proc_release	= single_release,
+};
+
+int rk_cryptodev_soft_init(void)
+{
+	soft_proc = proc_create("rk_cryptodev_soft", 0644, NULL, &soft_proc_ops);
+
+	return soft_proc ? 0 : -ENOMEM;
+}
+
+void rk_cryptodev_soft_exit(void)
+{
+	cancel_work_sync(&rk_soft_bench_work);
+	proc_remove(soft_proc);
+}
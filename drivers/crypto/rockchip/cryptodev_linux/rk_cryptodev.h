@@ -53,6 +53,9 @@ struct kernel_crypt_fd_op {
 
 	struct task_struct *task;
 	struct mm_struct *mm;
+
+	/* only use fds of fcrypt::dma_map_list, not the caller's fd table */
+	bool mapped_only;
 };
 
 struct kernel_crypt_auth_fd_op {
@@ -100,10 +103,19 @@ rk_cryptodev_ioctl(struct fcrypt *fcr, unsigned int cmd, unsigned long arg_);
 long
 rk_compat_cryptodev_ioctl(struct fcrypt *fcr, unsigned int cmd, unsigned long arg_);
 
+int rk_cryptodev_fd_batch_run(struct fcrypt *fcr, struct crypt_fd_batch_op *bop,
+			      bool compat, bool mapped_only);
+
 const char *rk_get_cipher_name(uint32_t id, int *is_stream, int *is_aead);
 
 const char *rk_get_hash_name(uint32_t id, int *is_hmac);
 
 bool rk_cryptodev_multi_thread(const char *name);
 
+const unsigned int *rk_cryptodev_soft_below(const char *name);
+
+int rk_cryptodev_soft_init(void);
+
+void rk_cryptodev_soft_exit(void);
+
 #endif
@@ -369,6 +369,7 @@ static int devfreq_set_target(struct devfreq *devfreq, unsigned long new_freq,
 
 	freqs.new = new_freq;
 	devfreq_notify_transition(devfreq, &freqs, DEVFREQ_POSTCHANGE);
+	trace_devfreq_frequency(devfreq, new_freq, cur_freq);
 
 	if (devfreq_update_status(devfreq, new_freq))
 		dev_err(&devfreq->dev,
@@ -65,6 +65,9 @@
 
 #define FALLBACK_STATIC_TEMPERATURE 55000
 
+#define DMC_IDLE_POLLS		4
+#define DMC_IDLE_POLLING_MAX_MS	1000U
+
 struct dmc_freq_table {
 	unsigned long freq;
 	struct dev_pm_opp_supply supplies[2];
@@ -172,6 +175,9 @@ struct rockchip_dmcfreq {
 	unsigned int touchboostpulse_duration_val;
 	u64 touchboostpulse_endtime;
 
+	unsigned int polling_ms;
+	unsigned int idle_polls;
+
 	int (*set_auto_self_refresh)(u32 en);
 };
 
@@ -462,6 +468,9 @@ static int rockchip_dmcfreq_opp_helper(struct dev_pm_set_opp_data *data)
 			goto out;
 	}
 
+	/* Let latency critical DMA clients pick when the bus stalls */
+	rockchip_dmcfreq_wait_blackout();
+
 	/*
 	 * Writer in rwsem may block readers even during its waiting in queue,
 	 * and this may lead to a deadlock when the code path takes read sem
@@ -630,6 +639,37 @@ static struct devfreq_dev_profile rockchip_devfreq_dmc_profile = {
 };
 
 
+/*
+ * The DFI has no load threshold interrupt, so when the load has stayed
+ * low for a few samples the polling interval is doubled up to
+ * DMC_IDLE_POLLING_MAX_MS. The counters keep accumulating in between, a
+ * load rise is still seen at the next sample, and system status changes
+ * and input boosts restore the full rate at once.
+ * Called with devfreq->lock held.
+ */
+static void rockchip_dmcfreq_update_polling(struct rockchip_dmcfreq *dmcfreq,
+					    struct devfreq *df, bool idle)
+{
+	unsigned int base = dmcfreq->polling_ms;
+
+	if (!base)
+		return;
+
+	if (!idle) {
+		dmcfreq->idle_polls = 0;
+		df->profile->polling_ms = base;
+		return;
+	}
+
+	if (dmcfreq->idle_polls < DMC_IDLE_POLLS) {
+		dmcfreq->idle_polls++;
+		return;
+	}
+
+	df->profile->polling_ms = min(df->profile->polling_ms * 2,
+				      max(base, DMC_IDLE_POLLING_MAX_MS));
+}
+
 static inline void reset_last_status(struct devfreq *devfreq)
 {
 	devfreq->last_status.total_time = 1;
@@ -2382,10 +2422,17 @@ static int rockchip_get_system_status_level(struct device_node *np,
 static void rockchip_dmcfreq_update_target(struct rockchip_dmcfreq *dmcfreq)
 {
 	struct devfreq *devfreq = dmcfreq->info.devfreq;
+	bool backoff;
 
 	mutex_lock(&devfreq->lock);
+	dmcfreq->idle_polls = 0;
 	update_devfreq(devfreq);
+	backoff = devfreq->profile->polling_ms > dmcfreq->polling_ms;
 	mutex_unlock(&devfreq->lock);
+
+	/* something happened, go back to sampling the load at full rate */
+	if (backoff)
+		devfreq_update_interval(devfreq, &dmcfreq->polling_ms);
 }
 
 static int rockchip_dmcfreq_system_status_notifier(struct notifier_block *nb,
@@ -2618,6 +2665,7 @@ static int devfreq_dmc_ondemand_func(struct devfreq *df,
 		nocp_req_rate = get_nocp_req_rate(dmcfreq);
 		target_freq = max3(target_freq, nocp_req_rate,
 				   dmcfreq->info.vop_req_rate);
+		target_freq = max(target_freq, dmcfreq->info.audio_req_rate);
 		now = ktime_to_us(ktime_get());
 		if (now < dmcfreq->touchboostpulse_endtime)
 			target_freq = max(target_freq, dmcfreq->boost_rate);
@@ -2661,12 +2709,14 @@ static int devfreq_dmc_ondemand_func(struct devfreq *df,
 	/* Set MAX if it's busy enough */
 	if (stat->busy_time * 100 >
 	    stat->total_time * upthreshold) {
+		rockchip_dmcfreq_update_polling(dmcfreq, df, false);
 		*freq = DEVFREQ_MAX_FREQ;
 		return 0;
 	}
 
 	/* Set MAX if we do not know the initial frequency */
 	if (stat->current_frequency == 0) {
+		rockchip_dmcfreq_update_polling(dmcfreq, df, false);
 		*freq = DEVFREQ_MAX_FREQ;
 		return 0;
 	}
@@ -2674,6 +2724,7 @@ static int devfreq_dmc_ondemand_func(struct devfreq *df,
 	/* Keep the current frequency */
 	if (stat->busy_time * 100 >
 	    stat->total_time * (upthreshold - downdifferential)) {
+		rockchip_dmcfreq_update_polling(dmcfreq, df, false);
 		*freq = max(target_freq, stat->current_frequency);
 		return 0;
 	}
@@ -2685,6 +2736,8 @@ static int devfreq_dmc_ondemand_func(struct devfreq *df,
 	b *= 100;
 	b = div_u64(b, (upthreshold - downdifferential / 2));
 	*freq = max_t(unsigned long, target_freq, b);
+	rockchip_dmcfreq_update_polling(dmcfreq, df,
+					*freq <= stat->current_frequency);
 
 	return 0;
 
@@ -2712,6 +2765,8 @@ static int devfreq_dmc_ondemand_handler(struct devfreq *devfreq,
 		break;
 
 	case DEVFREQ_GOV_UPDATE_INTERVAL:
+		dmcfreq->polling_ms = *(unsigned int *)data;
+		dmcfreq->idle_polls = 0;
 		devfreq_update_interval(devfreq, (unsigned int *)data);
 		break;
 
@@ -2965,6 +3020,9 @@ static void rockchip_dmcfreq_parse_dt(struct rockchip_dmcfreq *dmcfreq)
 	if (rockchip_get_freq_map_talbe(np, "vop-bw-dmc-freq",
 					&dmcfreq->info.vop_bw_tbl))
 		dev_err(dev, "failed to get vop bandwidth to dmc rate\n");
+	if (rockchip_get_freq_map_talbe(np, "audio-bw-dmc-freq",
+					&dmcfreq->info.audio_bw_tbl))
+		dev_dbg(dev, "failed to get audio bandwidth to dmc rate\n");
 	if (rockchip_get_rl_map_talbe(np, "vop-pn-msch-readlatency",
 				      &dmcfreq->info.vop_pn_rl_tbl))
 		dev_err(dev, "failed to get vop pn to msch rl\n");
@@ -3017,6 +3075,7 @@ static int rockchip_dmcfreq_add_devfreq(struct rockchip_dmcfreq *dmcfreq)
 	dev_pm_opp_put(opp);
 
 	devp->initial_freq = dmcfreq->rate;
+	dmcfreq->polling_ms = devp->polling_ms;
 	devfreq = devm_devfreq_add_device(dev, devp, "dmc_ondemand",
 					  &dmcfreq->ondemand_data);
 	if (IS_ERR(devfreq)) {
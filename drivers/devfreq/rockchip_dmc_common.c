@@ -6,6 +6,7 @@
  * Author: Finley Xiao <finley.xiao@rock-chips.com>
  */
 
+#include <linux/delay.h>
 #include <linux/module.h>
 #include <soc/rockchip/rockchip_dmc.h>
 
@@ -13,9 +14,14 @@
 					      struct rockchip_dmcfreq, \
 					      msch_rl_work)
 #define MSCH_RL_DELAY_TIME	50 /* ms */
+#define BLACKOUT_MAX_WAIT_US	10000
 
 static struct dmcfreq_common_info *common_info;
 static DECLARE_RWSEM(rockchip_dmcfreq_sem);
+static DEFINE_MUTEX(audio_bw_lock);
+static unsigned int audio_bw_kbyte;
+static LIST_HEAD(blackout_list);
+static DEFINE_MUTEX(blackout_lock);
 
 void rockchip_dmcfreq_lock(void)
 {
@@ -163,6 +169,95 @@ int rockchip_dmcfreq_vop_bandwidth_request(struct dmcfreq_vop_info *vop_info)
 }
 EXPORT_SYMBOL(rockchip_dmcfreq_vop_bandwidth_request);
 
+/*
+ * Floor the dmc rate by the audio-bw-dmc-freq entry matching the sum of
+ * all PCM stream requests, a kbyte of 0 drops the request.
+ */
+void rockchip_dmcfreq_audio_bandwidth_update(struct dmcfreq_audio_req *req,
+					     unsigned int kbyte)
+{
+	unsigned long audio_last_rate, target = 0;
+	int i;
+
+	mutex_lock(&audio_bw_lock);
+	audio_bw_kbyte = audio_bw_kbyte - req->kbyte + kbyte;
+	req->kbyte = kbyte;
+
+	if (!common_info || !common_info->auto_freq_en ||
+	    !common_info->audio_bw_tbl)
+		goto out;
+
+	if (audio_bw_kbyte) {
+		for (i = 0; common_info->audio_bw_tbl[i].freq != DMCFREQ_TABLE_END;
+		     i++) {
+			if (audio_bw_kbyte >= common_info->audio_bw_tbl[i].min)
+				target = common_info->audio_bw_tbl[i].freq;
+		}
+	}
+
+	dev_dbg(common_info->dev, "audio bw=%u, rate=%lu\n",
+		audio_bw_kbyte, target);
+
+	audio_last_rate = common_info->audio_req_rate;
+	common_info->audio_req_rate = target;
+
+	if (target > audio_last_rate) {
+		mutex_lock(&common_info->devfreq->lock);
+		update_devfreq(common_info->devfreq);
+		mutex_unlock(&common_info->devfreq->lock);
+	}
+out:
+	mutex_unlock(&audio_bw_lock);
+}
+EXPORT_SYMBOL(rockchip_dmcfreq_audio_bandwidth_update);
+
 MODULE_AUTHOR("Finley Xiao <finley.xiao@rock-chips.com>");
 MODULE_DESCRIPTION("rockchip dmcfreq driver with devfreq framework");
 MODULE_LICENSE("GPL v2");
+
+int rockchip_dmcfreq_register_blackout(struct dmcfreq_blackout *blackout)
+{
+	if (!blackout || !blackout->safe_in_us)
+		return -EINVAL;
+
+	mutex_lock(&blackout_lock);
+	list_add_tail(&blackout->node, &blackout_list);
+	mutex_unlock(&blackout_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL(rockchip_dmcfreq_register_blackout);
+
+void rockchip_dmcfreq_unregister_blackout(struct dmcfreq_blackout *blackout)
+{
+	mutex_lock(&blackout_lock);
+	list_del(&blackout->node);
+	mutex_unlock(&blackout_lock);
+}
+EXPORT_SYMBOL(rockchip_dmcfreq_unregister_blackout);
+
+/*
+ * Delay a DDR frequency change until no registered client is close to a
+ * point where it cannot tolerate the bus stall, e.g. an audio DMA period
+ * boundary. The wait is bounded so that a client which is never safe
+ * does not hold off DVFS forever.
+ */
+void rockchip_dmcfreq_wait_blackout(void)
+{
+	struct dmcfreq_blackout *blackout;
+	unsigned int waited = 0, delay;
+
+	mutex_lock(&blackout_lock);
+	while (waited < BLACKOUT_MAX_WAIT_US) {
+		delay = 0;
+		list_for_each_entry(blackout, &blackout_list, node)
+			delay = max(delay, blackout->safe_in_us(blackout));
+		if (!delay)
+			break;
+		delay = min(delay, BLACKOUT_MAX_WAIT_US - waited);
+		usleep_range(delay, delay + 50);
+		waited += delay;
+	}
+	mutex_unlock(&blackout_lock);
+}
+EXPORT_SYMBOL(rockchip_dmcfreq_wait_blackout);
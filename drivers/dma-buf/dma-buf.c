@@ -67,10 +67,104 @@ EXPORT_SYMBOL_GPL(get_each_dmabuf);
 static size_t db_total_size;
 static size_t db_peak_size;
 
+/* Accounts by exporter and by exporting process, under db_list.lock */
+static LIST_HEAD(db_heap_accounts);
+static LIST_HEAD(db_proc_accounts);
+
+static struct dma_buf_account *
+dma_buf_account_get(struct list_head *head, const char *exp_name)
+{
+	struct dma_buf_account *acct;
+	pid_t pid = exp_name ? 0 : current->tgid;
+
+	list_for_each_entry(acct, head, node) {
+		if (exp_name ? !strcmp(acct->name, exp_name) : acct->pid == pid)
+			return acct;
+	}
+
+	acct = kzalloc(sizeof(*acct), GFP_KERNEL);
+	if (!acct)
+		return NULL;
+
+	if (exp_name)
+		strscpy(acct->name, exp_name, sizeof(acct->name));
+	else
+		__get_task_comm(acct->name, sizeof(acct->name),
+				current->group_leader);
+	acct->pid = pid;
+	list_add_tail(&acct->node, head);
+
+	return acct;
+}
+
+static void dma_buf_account_charge(struct dma_buf_account *acct, size_t size)
+{
+	if (!acct)
+		return;
+
+	acct->size += size;
+	acct->count++;
+	acct->peak = max(acct->size, acct->peak);
+}
+
+static void dma_buf_account_uncharge(struct dma_buf_account *acct,
+				     size_t size)
+{
+	if (!acct)
+		return;
+
+	acct->size -= size;
+	acct->count--;
+}
+
+/*
+ * Charge a new dmabuf to its exporter and to the process exporting it,
+ * which for heaps is the one that allocated it.
+ */
+static void dma_buf_account_add(struct dma_buf *dmabuf)
+{
+	lockdep_assert_held(&db_list.lock);
+
+	db_total_size += dmabuf->size;
+	db_peak_size = max(db_total_size, db_peak_size);
+
+	dmabuf->heap_acct = dma_buf_account_get(&db_heap_accounts,
+						dmabuf->exp_name ?: "unknown");
+	dmabuf->proc_acct = dma_buf_account_get(&db_proc_accounts, NULL);
+	dma_buf_account_charge(dmabuf->heap_acct, dmabuf->size);
+	dma_buf_account_charge(dmabuf->proc_acct, dmabuf->size);
+}
+
+static void dma_buf_account_del(struct dma_buf *dmabuf)
+{
+	lockdep_assert_held(&db_list.lock);
+
+	db_total_size -= dmabuf->size;
+	dma_buf_account_uncharge(dmabuf->heap_acct, dmabuf->size);
+	dma_buf_account_uncharge(dmabuf->proc_acct, dmabuf->size);
+}
+
+/*
+ * Peaks restart from the current sizes. Processes holding nothing are
+ * forgotten here rather than when their last buffer goes, so that their
+ * peak can still be read after they exit.
+ */
 void dma_buf_reset_peak_size(void)
 {
+	struct dma_buf_account *acct, *tmp;
+
 	mutex_lock(&db_list.lock);
 	db_peak_size = 0;
+	list_for_each_entry(acct, &db_heap_accounts, node)
+		acct->peak = acct->size;
+	list_for_each_entry_safe(acct, tmp, &db_proc_accounts, node) {
+		if (acct->count) {
+			acct->peak = acct->size;
+			continue;
+		}
+		list_del(&acct->node);
+		kfree(acct);
+	}
 	mutex_unlock(&db_list.lock);
 }
 EXPORT_SYMBOL_GPL(dma_buf_reset_peak_size);
@@ -98,6 +192,40 @@ size_t dma_buf_get_total_size(void)
 	return sz;
 }
 EXPORT_SYMBOL_GPL(dma_buf_get_total_size);
+
+static int get_each_dmabuf_account(struct list_head *head,
+				   int (*callback)(const struct dma_buf_account *acct,
+						   void *private),
+				   void *private)
+{
+	struct dma_buf_account *acct;
+	int ret = mutex_lock_interruptible(&db_list.lock);
+
+	if (ret)
+		return ret;
+
+	list_for_each_entry(acct, head, node) {
+		ret = callback(acct, private);
+		if (ret)
+			break;
+	}
+	mutex_unlock(&db_list.lock);
+	return ret;
+}
+
+int get_each_dmabuf_heap(int (*callback)(const struct dma_buf_account *acct,
+					 void *private), void *private)
+{
+	return get_each_dmabuf_account(&db_heap_accounts, callback, private);
+}
+EXPORT_SYMBOL_GPL(get_each_dmabuf_heap);
+
+int get_each_dmabuf_process(int (*callback)(const struct dma_buf_account *acct,
+					    void *private), void *private)
+{
+	return get_each_dmabuf_account(&db_proc_accounts, callback, private);
+}
+EXPORT_SYMBOL_GPL(get_each_dmabuf_process);
 #endif
 
 static char *dmabuffs_dname(struct dentry *dentry, char *buffer, int buflen)
@@ -168,7 +296,7 @@ static int dma_buf_file_release(struct inode *inode, struct file *file)
 
 	mutex_lock(&db_list.lock);
 #if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
-	db_total_size -= dmabuf->size;
+	dma_buf_account_del(dmabuf);
 #endif
 	list_del(&dmabuf->list_node);
 	mutex_unlock(&db_list.lock);
@@ -738,8 +866,7 @@ struct dma_buf *dma_buf_export(const struct dma_buf_export_info *exp_info)
 	mutex_lock(&db_list.lock);
 	list_add(&dmabuf->list_node, &db_list.head);
 #if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
-	db_total_size += dmabuf->size;
-	db_peak_size = max(db_total_size, db_peak_size);
+	dma_buf_account_add(dmabuf);
 #endif
 	mutex_unlock(&db_list.lock);
 
@@ -7,8 +7,11 @@
  *	Christian König <christian.koenig@amd.com>
  */
 
+#include <linux/dma-fence-array.h>
 #include <linux/dma-fence-chain.h>
 
+#include <trace/events/dma_fence.h>
+
 static bool dma_fence_chain_enable_signaling(struct dma_fence *fence);
 
 /**
@@ -256,3 +259,46 @@ void dma_fence_chain_init(struct dma_fence_chain *chain,
 		       &chain->lock, context, seqno);
 }
 EXPORT_SYMBOL(dma_fence_chain_init);
+
+static void dma_fence_trace_leaf(struct dma_fence *fence, const char *dev,
+				 u64 frame)
+{
+	struct dma_fence_array *array = to_dma_fence_array(fence);
+	unsigned int i;
+
+	if (!array) {
+		trace_dma_fence_consumer(fence, dev, frame);
+		return;
+	}
+
+	for (i = 0; i < array->num_fences; i++)
+		trace_dma_fence_consumer(array->fences[i], dev, frame);
+}
+
+/**
+ * dma_fence_trace_consumer - trace a device job waiting for a fence
+ * @fence: the in fence of the job, may be a chain or an array
+ * @dev: name of the device running the job
+ * @frame: id of the job, as passed to trace_dma_fence_producer() for its
+ *	   out fence
+ *
+ * Emits one dma_fence_consumer event per fence contained in @fence, so that
+ * a job waiting on a merged or timeline fence is tied to each of the jobs
+ * it really depends on. Chain nodes already signaled may have been
+ * garbage collected and are not reported.
+ */
+void dma_fence_trace_consumer(struct dma_fence *fence, const char *dev,
+			      u64 frame)
+{
+	struct dma_fence *iter;
+
+	if (!trace_dma_fence_consumer_enabled() || !fence)
+		return;
+
+	dma_fence_chain_for_each(iter, fence) {
+		struct dma_fence_chain *chain = to_dma_fence_chain(iter);
+
+		dma_fence_trace_leaf(chain ? chain->fence : iter, dev, frame);
+	}
+}
+EXPORT_SYMBOL(dma_fence_trace_consumer);
@@ -169,9 +169,26 @@ static int dma_heap_ioctl_get_phys(struct file *file, void *data)
 	return -EINVAL;
 }
 
+static int dma_heap_ioctl_prewarm(struct file *file, void *data)
+{
+#if IS_ENABLED(CONFIG_NO_GKI)
+	struct dma_heap *heap = file->private_data;
+	struct dma_heap_prewarm_data *prewarm = data;
+
+	if (prewarm->reserved)
+		return -EINVAL;
+
+	if (heap->ops->prewarm)
+		return heap->ops->prewarm(heap, prewarm);
+#endif
+
+	return -EINVAL;
+}
+
 static unsigned int dma_heap_ioctl_cmds[] = {
 	DMA_HEAP_IOCTL_ALLOC,
 	DMA_HEAP_IOCTL_GET_PHYS,
+	DMA_HEAP_IOCTL_PREWARM,
 };
 
 static long dma_heap_ioctl(struct file *file, unsigned int ucmd,
@@ -224,6 +241,9 @@ static long dma_heap_ioctl(struct file *file, unsigned int ucmd,
 	case DMA_HEAP_IOCTL_GET_PHYS:
 		ret = dma_heap_ioctl_get_phys(file, kdata);
 		break;
+	case DMA_HEAP_IOCTL_PREWARM:
+		ret = dma_heap_ioctl_prewarm(file, kdata);
+		break;
 	default:
 		ret = -ENOTTY;
 		goto err;
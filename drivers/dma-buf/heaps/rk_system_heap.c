@@ -19,6 +19,7 @@
 #include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/scatterlist.h>
+#include <linux/sched/signal.h>
 #include <linux/slab.h>
 #include <linux/swiotlb.h>
 #include <linux/vmalloc.h>
@@ -47,6 +48,8 @@ struct system_heap_buffer {
 	struct deferred_freelist_item deferred_free;
 	struct dmabuf_page_pool **pools;
 	bool uncached;
+	/* a CPU access that may write is open, see end_cpu_access */
+	bool cpu_dirty;
 };
 
 struct dma_heap_attachment {
@@ -177,6 +180,17 @@ static void system_heap_unmap_dma_buf(struct dma_buf_attachment *attachment,
 	dma_unmap_sgtable(attachment->dev, table, direction, attr);
 }
 
+/* Called with buffer->lock held when a CPU access ends */
+static bool system_heap_cpu_written(struct system_heap_buffer *buffer,
+				    enum dma_data_direction direction)
+{
+	bool written = buffer->cpu_dirty || direction != DMA_FROM_DEVICE;
+
+	buffer->cpu_dirty = false;
+
+	return written;
+}
+
 static int system_heap_dma_buf_begin_cpu_access(struct dma_buf *dmabuf,
 						enum dma_data_direction direction)
 {
@@ -185,6 +199,9 @@ static int system_heap_dma_buf_begin_cpu_access(struct dma_buf *dmabuf,
 
 	mutex_lock(&buffer->lock);
 
+	if (direction != DMA_FROM_DEVICE)
+		buffer->cpu_dirty = true;
+
 	if (buffer->vmap_cnt)
 		invalidate_kernel_vmap_range(buffer->vaddr, buffer->len);
 
@@ -208,6 +225,13 @@ static int system_heap_dma_buf_end_cpu_access(struct dma_buf *dmabuf,
 
 	mutex_lock(&buffer->lock);
 
+	/*
+	 * Nothing to write back after a read-only access: the lines the CPU
+	 * pulled in are clean and the next begin_cpu_access invalidates them.
+	 */
+	if (!system_heap_cpu_written(buffer, direction))
+		goto out;
+
 	if (buffer->vmap_cnt)
 		flush_kernel_vmap_range(buffer->vaddr, buffer->len);
 
@@ -218,6 +242,7 @@ static int system_heap_dma_buf_end_cpu_access(struct dma_buf *dmabuf,
 			dma_sync_sgtable_for_device(a->dev, a->table, direction);
 		}
 	}
+out:
 	mutex_unlock(&buffer->lock);
 
 	return 0;
@@ -276,10 +301,17 @@ system_heap_dma_buf_begin_cpu_access_partial(struct dma_buf *dmabuf,
 	struct sg_table *table = &buffer->sg_table;
 	int ret;
 
-	if (direction == DMA_TO_DEVICE)
+	if (direction == DMA_TO_DEVICE) {
+		mutex_lock(&buffer->lock);
+		buffer->cpu_dirty = true;
+		mutex_unlock(&buffer->lock);
 		return 0;
+	}
 
 	mutex_lock(&buffer->lock);
+	if (direction != DMA_FROM_DEVICE)
+		buffer->cpu_dirty = true;
+
 	if (buffer->vmap_cnt)
 		invalidate_kernel_vmap_range(buffer->vaddr, buffer->len);
 
@@ -307,6 +339,11 @@ system_heap_dma_buf_end_cpu_access_partial(struct dma_buf *dmabuf,
 	int ret;
 
 	mutex_lock(&buffer->lock);
+	if (!system_heap_cpu_written(buffer, direction)) {
+		mutex_unlock(&buffer->lock);
+		return 0;
+	}
+
 	if (buffer->vmap_cnt)
 		flush_kernel_vmap_range(buffer->vaddr, buffer->len);
 
@@ -670,9 +707,66 @@ static long system_get_pool_size(struct dma_heap *heap)
 	return num_pages << PAGE_SHIFT;
 }
 
+#if IS_ENABLED(CONFIG_NO_GKI)
+/*
+ * Top each order pool up to what count allocations of len take when they
+ * are served largest order first, the same way system_heap_do_allocate
+ * splits them. Orders that cannot be had are made up from the next one.
+ */
+static int system_heap_prewarm(struct dma_heap *heap,
+			       struct dma_heap_prewarm_data *data)
+{
+	struct dmabuf_page_pool **pool;
+	unsigned long need[NUM_ORDERS] = { 0 };
+	unsigned long size, have;
+	struct page *page;
+	int i;
+
+	if (!data->len || !data->count ||
+	    PAGE_ALIGN(data->len) >> PAGE_SHIFT >
+	    totalram_pages() / 2 / data->count)
+		return -EINVAL;
+
+	pool = strstr(dma_heap_get_name(heap), "dma32") ? dma32_pools : pools;
+
+	size = PAGE_ALIGN(data->len);
+	for (i = 0; i < NUM_ORDERS; i++) {
+		need[i] = (size >> (PAGE_SHIFT + orders[i])) * data->count;
+		size &= (PAGE_SIZE << orders[i]) - 1;
+	}
+
+	for (i = 0; i < NUM_ORDERS; i++) {
+		have = pool[i]->count[POOL_LOWPAGE] +
+		       pool[i]->count[POOL_HIGHPAGE];
+		while (have < need[i]) {
+			if (fatal_signal_pending(current))
+				return -EINTR;
+
+			page = alloc_pages(pool[i]->gfp_mask, orders[i]);
+			if (!page)
+				break;
+			dmabuf_page_pool_free(pool[i], page);
+			have++;
+		}
+
+		if (have < need[i]) {
+			if (i == NUM_ORDERS - 1)
+				return -ENOMEM;
+			need[i + 1] += (need[i] - have) <<
+				       (orders[i] - orders[i + 1]);
+		}
+	}
+
+	return 0;
+}
+#endif
+
 static const struct dma_heap_ops system_heap_ops = {
 	.allocate = system_heap_allocate,
 	.get_pool_size = system_get_pool_size,
+#if IS_ENABLED(CONFIG_NO_GKI)
+	.prewarm = system_heap_prewarm,
+#endif
 };
 
 static struct dma_buf *system_uncached_heap_allocate(struct dma_heap *heap,
@@ -695,6 +789,9 @@ static struct dma_buf *system_uncached_heap_not_initialized(struct dma_heap *hea
 static struct dma_heap_ops system_uncached_heap_ops = {
 	/* After system_heap_create is complete, we will swap this */
 	.allocate = system_uncached_heap_not_initialized,
+#if IS_ENABLED(CONFIG_NO_GKI)
+	.prewarm = system_heap_prewarm,
+#endif
 };
 
 static int set_heap_dev_dma(struct device *heap_dev)
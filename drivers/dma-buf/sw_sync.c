@@ -13,6 +13,8 @@
 #include <linux/slab.h>
 #include <linux/sync_file.h>
 
+#include <trace/events/dma_fence.h>
+
 #include "sync_debug.h"
 
 #define CREATE_TRACE_POINTS
@@ -349,6 +351,12 @@ static long sw_sync_ioctl_create_fence(struct sync_timeline *obj,
 		goto err;
 	}
 
+	/*
+	 * Userspace stages of a pipeline, e.g. the rkisp frames handed out
+	 * by the camera service, show up under the name of their timeline.
+	 */
+	trace_dma_fence_producer(&pt->base, obj->name, data.value);
+
 	sync_file = sync_file_create(&pt->base);
 	dma_fence_put(&pt->base);
 	if (!sync_file) {
@@ -28,6 +28,10 @@
 #include <linux/reset.h>
 
 #include "dmaengine.h"
+
+#define CREATE_TRACE_POINTS
+#include <trace/events/pl330.h>
+
 #define PL330_MAX_CHAN		8
 #define PL330_MAX_IRQS		32
 #define PL330_MAX_PERI		32
@@ -355,10 +359,34 @@ enum pl330_cond {
 
 struct dma_pl330_desc;
 
+/*
+ * Most segments of a cyclic transfer over a scatterlist: each costs some
+ * 30 bytes of microcode and the whole loop must fit a 255 byte DMALPEND.
+ */
+#define PL330_MAX_CYCLIC_SEGS	8
+
+/* Everything a cyclic microcode program is generated from */
+struct _pl330_mc_key {
+	u32 ccr;
+	struct pl330_xfer px;
+	size_t num_periods;
+	enum dma_transfer_direction rqtype;
+	unsigned int peri;
+	int ev;
+	bool irq;
+#ifdef CONFIG_NO_GKI
+	unsigned int src_interlace_size;
+	unsigned int dst_interlace_size;
+#endif
+};
+
 struct _pl330_req {
 	u32 mc_bus;
 	void *mc_cpu;
 	struct dma_pl330_desc *desc;
+	/* Cyclic program currently held in mc_cpu */
+	struct _pl330_mc_key mc_key;
+	bool mc_valid;
 };
 
 /* ToBeDone for tasklet */
@@ -486,6 +514,8 @@ struct pl330_dmac {
 	struct _pl330_tbd	dmac_tbd;
 	/* State of DMAC operation */
 	enum pl330_dmac_state	state;
+	/* A cyclic transfer kept the DMAC running over system suspend */
+	bool			kept_running;
 	/* Holds list of reqs with due callbacks */
 	struct list_head        req_done;
 
@@ -541,6 +571,11 @@ struct dma_pl330_desc {
 	/* For cyclic capability */
 	bool cyclic;
 	size_t num_periods;
+	/* Cyclic over a scatterlist, segs[] replaces px when num_segs */
+	struct pl330_xfer segs[PL330_MAX_CYCLIC_SEGS];
+	unsigned int num_segs;
+	/* Segments that end a period, followed by DMASEV */
+	u32 seg_sev;
 #ifdef CONFIG_NO_GKI
 	/* interlace size */
 	unsigned int src_interlace_size;
@@ -1469,7 +1504,9 @@ static int _period(struct pl330_dmac *pl330, unsigned int dry_run, u8 buf[],
 	}
 #endif
 
-	off += _emit_SEV(dry_run, &buf[off], ev);
+	/* no event for a period-less (no wakeup) cyclic transfer */
+	if (pxs->desc->txd.flags & DMA_PREP_INTERRUPT)
+		off += _emit_SEV(dry_run, &buf[off], ev);
 
 	return off;
 }
@@ -1524,6 +1561,62 @@ static inline int _loop_cyclic(struct pl330_dmac *pl330, unsigned int dry_run,
 	return off;
 }
 
+/*
+ * Only the memory side address moves from one segment to the next, the
+ * FIFO side is loaded once before the forever loop.
+ */
+static int _loop_cyclic_sg(struct pl330_dmac *pl330, unsigned int dry_run,
+			   u8 buf[], const struct _xfer_spec *pxs, int ev)
+{
+	struct dma_pl330_desc *desc = pxs->desc;
+	bool irq = desc->txd.flags & DMA_PREP_INTERRUPT;
+	struct _arg_LPEND lpend;
+	int off = 0, ljmpfe, i;
+
+	if (desc->rqcfg.src_inc)
+		off += _emit_MOV(dry_run, &buf[off], DAR, desc->segs[0].dst_addr);
+	else
+		off += _emit_MOV(dry_run, &buf[off], SAR, desc->segs[0].src_addr);
+
+	ljmpfe = off;
+	for (i = 0; i < desc->num_segs; i++) {
+		struct pl330_xfer *x = &desc->segs[i];
+		unsigned long c, bursts = BYTE_TO_BURST(x->bytes, pxs->ccr);
+		int num_dregs = BYTE_MOD_BURST_LEN(x->bytes, pxs->ccr);
+
+		if (desc->rqcfg.src_inc)
+			off += _emit_MOV(dry_run, &buf[off], SAR, x->src_addr);
+		else
+			off += _emit_MOV(dry_run, &buf[off], DAR, x->dst_addr);
+
+		while (bursts) {
+			c = bursts;
+			off += _loop(pl330, dry_run, &buf[off], &c, pxs);
+			bursts -= c;
+		}
+
+		if (num_dregs) {
+			off += _dregs(pl330, dry_run, &buf[off], pxs, num_dregs);
+			off += _emit_MOV(dry_run, &buf[off], CCR, pxs->ccr);
+		}
+
+		if (irq && (desc->seg_sev & BIT(i)))
+			off += _emit_SEV(dry_run, &buf[off], ev);
+	}
+
+	/* the backward jump of DMALPEND is 8 bits */
+	if (off - ljmpfe > 255)
+		return -ENOMEM;
+
+	lpend.cond = ALWAYS;
+	lpend.forever = true;
+	lpend.loop = 1;
+	lpend.bjump = off - ljmpfe;
+	off += _emit_LPEND(dry_run, &buf[off], &lpend);
+
+	return off;
+}
+
 static inline int _setup_loops(struct pl330_dmac *pl330,
 			       unsigned dry_run, u8 buf[],
 			       const struct _xfer_spec *pxs)
@@ -1609,7 +1702,7 @@ static int _setup_req(struct pl330_dmac *pl330, unsigned dry_run,
 {
 	struct _pl330_req *req = &thrd->req[index];
 	u8 *buf = req->mc_cpu;
-	int off = 0;
+	int off = 0, ret;
 
 	PL330_DBGMC_START(req->mc_bus);
 
@@ -1623,6 +1716,11 @@ static int _setup_req(struct pl330_dmac *pl330, unsigned dry_run,
 		off += _emit_SEV(dry_run, &buf[off], thrd->ev);
 		/* DMAEND */
 		off += _emit_END(dry_run, &buf[off]);
+	} else if (pxs->desc->num_segs) {
+		ret = _loop_cyclic_sg(pl330, dry_run, &buf[off], pxs, thrd->ev);
+		if (ret < 0)
+			return ret;
+		off += ret;
 	} else {
 		off += _setup_xfer_cyclic(pl330, dry_run, &buf[off],
 					  pxs, thrd->ev);
@@ -1668,10 +1766,31 @@ static inline u32 _prepare_ccr(const struct pl330_reqcfg *rqc)
  * Client is not notified after each xfer unit, just once after all
  * xfer units are done or some error occurs.
  */
+static void _mc_key(struct _pl330_mc_key *key, struct pl330_thread *thrd,
+		    const struct _xfer_spec *pxs)
+{
+	const struct dma_pl330_desc *desc = pxs->desc;
+
+	/* zeroed so padding doesn't defeat memcmp() */
+	memset(key, 0, sizeof(*key));
+	key->ccr = pxs->ccr;
+	key->px = desc->px;
+	key->num_periods = desc->num_periods;
+	key->rqtype = desc->rqtype;
+	key->peri = desc->peri;
+	key->ev = thrd->ev;
+	key->irq = !!(desc->txd.flags & DMA_PREP_INTERRUPT);
+#ifdef CONFIG_NO_GKI
+	key->src_interlace_size = desc->src_interlace_size;
+	key->dst_interlace_size = desc->dst_interlace_size;
+#endif
+}
+
 static int pl330_submit_req(struct pl330_thread *thrd,
 	struct dma_pl330_desc *desc)
 {
 	struct pl330_dmac *pl330 = thrd->dmac;
+	struct _pl330_mc_key key;
 	struct _xfer_spec xs;
 	unsigned long flags;
 	unsigned idx;
@@ -1728,6 +1847,21 @@ static int pl330_submit_req(struct pl330_thread *thrd,
 	xs.ccr = ccr;
 	xs.desc = desc;
 
+	/*
+	 * A restarted cyclic transfer (prepare, resume, gapless switch)
+	 * usually maps the same buffer again, so reuse its program. The
+	 * key does not cover scatterlist segments, those are rebuilt.
+	 */
+	if (desc->cyclic && !desc->num_segs) {
+		_mc_key(&key, thrd, &xs);
+		if (thrd->req[idx].mc_valid &&
+		    !memcmp(&thrd->req[idx].mc_key, &key, sizeof(key))) {
+			thrd->lstenq = idx;
+			thrd->req[idx].desc = desc;
+			goto xfer_exit;
+		}
+	}
+
 	/* First dry run to check if req is acceptable */
 	ret = _setup_req(pl330, 1, thrd, idx, &xs);
 	if (ret < 0)
@@ -1745,6 +1879,10 @@ static int pl330_submit_req(struct pl330_thread *thrd,
 	thrd->req[idx].desc = desc;
 	_setup_req(pl330, 0, thrd, idx, &xs);
 
+	thrd->req[idx].mc_valid = desc->cyclic && !desc->num_segs;
+	if (thrd->req[idx].mc_valid)
+		thrd->req[idx].mc_key = key;
+
 	ret = 0;
 
 xfer_exit:
@@ -1773,6 +1911,7 @@ static void dma_pl330_rqcb(struct dma_pl330_desc *desc, enum pl330_op_err err)
 
 	spin_unlock_irqrestore(&pch->lock, flags);
 
+	trace_pl330_rqcb(&pch->chan, err);
 	tasklet_schedule(&pch->task);
 }
 
@@ -1837,11 +1976,13 @@ static void pl330_dotask(struct tasklet_struct *t)
 /* Returns 1 if state was updated, 0 otherwise */
 static int pl330_update(struct pl330_dmac *pl330)
 {
+	struct dmaengine_desc_callback hardirq_cb[PL330_MAX_CHAN];
+	struct dma_chan *hardirq_chan[PL330_MAX_CHAN];
 	struct dma_pl330_desc *descdone;
 	unsigned long flags;
 	void __iomem *regs;
 	u32 val;
-	int id, ev, ret = 0;
+	int id, ev, i, ret = 0, n = 0;
 
 	regs = pl330->base;
 
@@ -1908,6 +2049,15 @@ static int pl330_update(struct pl330_dmac *pl330)
 					thrd->req_running = -1;
 					/* Get going again ASAP */
 					_start(thrd);
+				} else if (descdone->pchan &&
+					   (descdone->txd.flags &
+					    DMA_PREP_CALLBACK_HARDIRQ) &&
+					   n < PL330_MAX_CHAN) {
+					/* The period callback skips the tasklet */
+					dmaengine_desc_get_callback(&descdone->txd,
+								    &hardirq_cb[n]);
+					hardirq_chan[n++] = &descdone->pchan->chan;
+					continue;
 				}
 
 				/* For now, just make a list of callbacks to be done */
@@ -1929,6 +2079,12 @@ static int pl330_update(struct pl330_dmac *pl330)
 updt_exit:
 	spin_unlock_irqrestore(&pl330->lock, flags);
 
+	for (i = 0; i < n; i++) {
+		trace_pl330_rqcb(hardirq_chan[i], PL330_ERR_NONE);
+		trace_pl330_callback(hardirq_chan[i]);
+		dmaengine_desc_callback_invoke(&hardirq_cb[i], NULL);
+	}
+
 	if (pl330->dmac_tbd.reset_dmac
 			|| pl330->dmac_tbd.reset_mngr
 			|| pl330->dmac_tbd.reset_chan) {
@@ -1982,6 +2138,8 @@ static struct pl330_thread *pl330_request_channel(struct pl330_dmac *pl330)
 				thrd->lstenq = 1;
 				thrd->req[0].desc = NULL;
 				thrd->req[1].desc = NULL;
+				thrd->req[0].mc_valid = false;
+				thrd->req[1].mc_valid = false;
 				thrd->req_running = -1;
 				break;
 			}
@@ -2290,6 +2448,7 @@ static void pl330_tasklet(struct tasklet_struct *t)
 
 				if (dmaengine_desc_callback_valid(&cb)) {
 					spin_unlock_irqrestore(&pch->lock, flags);
+					trace_pl330_callback(&pch->chan);
 					dmaengine_desc_callback_invoke(&cb, NULL);
 					spin_lock_irqsave(&pch->lock, flags);
 				}
@@ -2530,6 +2689,19 @@ static int pl330_terminate_all(struct dma_chan *chan)
 	return 0;
 }
 
+/* Waits for callbacks run from the DMAC interrupt or the channel tasklet */
+static void pl330_synchronize(struct dma_chan *chan)
+{
+	struct dma_pl330_chan *pch = to_pchan(chan);
+	struct amba_device *adev = to_amba_device(pch->dmac->ddma.dev);
+	int i;
+
+	for (i = 0; i < AMBA_NR_IRQS && adev->irq[i]; i++)
+		synchronize_irq(adev->irq[i]);
+
+	tasklet_kill(&pch->task);
+}
+
 /*
  * We don't support DMA_RESUME command because of hardware
  * limitations, so after pausing the channel we cannot restore
@@ -2585,22 +2757,53 @@ static int pl330_get_current_xferred_count(struct dma_pl330_chan *pch,
 	struct pl330_thread *thrd = pch->thread;
 	struct pl330_dmac *pl330 = pch->dmac;
 	void __iomem *regs = thrd->dmac->base;
-	u32 val, addr;
+	u32 val, addr, reg;
+	bool active = pch->active;
+
+	/*
+	 * An issued channel already holds a runtime PM reference, so the
+	 * pointer path (called for every ALSA position query) can read
+	 * the registers directly.
+	 */
+	if (!active)
+		pm_runtime_get_sync(pl330->ddma.dev);
 
-	pm_runtime_get_sync(pl330->ddma.dev);
-	val = addr = 0;
 	if (desc->rqcfg.src_inc) {
-		val = readl(regs + SA(thrd->id));
+		reg = SA(thrd->id);
 		addr = desc->px.src_addr;
 	} else {
-		val = readl(regs + DA(thrd->id));
+		reg = DA(thrd->id);
 		addr = desc->px.dst_addr;
 	}
-	pm_runtime_mark_last_busy(pch->dmac->ddma.dev);
-	pm_runtime_put_autosuspend(pl330->ddma.dev);
+	val = readl(regs + reg);
+
+	if (!active) {
+		pm_runtime_mark_last_busy(pch->dmac->ddma.dev);
+		pm_runtime_put_autosuspend(pl330->ddma.dev);
+	}
+
+	if (desc->num_segs) {
+		u32 done = 0;
+		int i;
 
-	/* If DMAMOV hasn't finished yet, SAR/DAR can be zero */
-	if (!val)
+		for (i = 0; i < desc->num_segs; i++) {
+			struct pl330_xfer *x = &desc->segs[i];
+
+			addr = desc->rqcfg.src_inc ? x->src_addr : x->dst_addr;
+			if (val >= addr && val - addr < x->bytes)
+				return done + val - addr;
+			done += x->bytes;
+		}
+
+		return 0;
+	}
+
+	/*
+	 * Until DMAMOV has run SAR/DAR is zero or still holds the address
+	 * of the previous transfer, so anything outside the buffer means
+	 * nothing has moved yet.
+	 */
+	if (val < addr || val - addr > desc->bytes_requested)
 		return 0;
 
 	return val - addr;
@@ -2630,6 +2833,14 @@ pl330_tx_status(struct dma_chan *chan, dma_cookie_t cookie,
 	if (pch->thread->req_running != -1)
 		running = pch->thread->req[pch->thread->req_running].desc;
 
+	/* Fast path for the position of a running cyclic (audio) transfer */
+	if (running && running->cyclic && running->txd.cookie == cookie) {
+		residual = running->bytes_requested -
+			   pl330_get_current_xferred_count(pch, running);
+		ret = DMA_IN_PROGRESS;
+		goto unlock;
+	}
+
 	last_enq = pch->thread->req[pch->thread->lstenq].desc;
 
 	/* Check in pending list */
@@ -2668,6 +2879,7 @@ pl330_tx_status(struct dma_chan *chan, dma_cookie_t cookie,
 		if (desc->last)
 			residual = 0;
 	}
+unlock:
 	spin_unlock(&pch->thread->dmac->lock);
 	spin_unlock_irqrestore(&pch->lock, flags);
 
@@ -2820,6 +3032,8 @@ static struct dma_pl330_desc *pl330_get_desc(struct dma_pl330_chan *pch)
 
 	desc->cyclic = false;
 	desc->num_periods = 1;
+	desc->num_segs = 0;
+	desc->seg_sev = 0;
 
 	dma_async_tx_descriptor_init(&desc->txd, &pch->chan);
 
@@ -2943,6 +3157,84 @@ static struct dma_async_tx_descriptor *pl330_prep_dma_cyclic(
 	return &desc->txd;
 }
 
+static struct dma_async_tx_descriptor *pl330_prep_dma_cyclic_sg(
+		struct dma_chan *chan, struct scatterlist *sgl,
+		unsigned int sg_len, size_t period_len,
+		enum dma_transfer_direction direction, unsigned long flags)
+{
+	struct dma_pl330_chan *pch = to_pchan(chan);
+	struct dma_pl330_desc *desc;
+	struct scatterlist *sg;
+	u32 seg_sev = 0;
+	size_t len = 0;
+	int i;
+
+	if (!sgl || !sg_len || sg_len > PL330_MAX_CYCLIC_SEGS || !period_len)
+		return NULL;
+
+	if (!is_slave_direction(direction)) {
+		dev_err(pch->dmac->ddma.dev, "%s:%d Invalid dma direction\n",
+		__func__, __LINE__);
+		return NULL;
+	}
+
+	/* a period may span segments but must end at the end of one */
+	for_each_sg(sgl, sg, sg_len, i) {
+		size_t seg = sg_dma_len(sg);
+
+		if (!seg || len / period_len != (len + seg - 1) / period_len)
+			return NULL;
+		len += seg;
+		if (!(len % period_len))
+			seg_sev |= BIT(i);
+	}
+	if (len % period_len)
+		return NULL;
+
+#ifdef CONFIG_NO_GKI
+	if (pch->slave_config.src_interlace_size ||
+	    pch->slave_config.dst_interlace_size)
+		return NULL;
+#endif
+
+	pl330_config_write(chan, &pch->slave_config, direction);
+
+	if (!pl330_prep_slave_fifo(pch, direction))
+		return NULL;
+
+	desc = pl330_get_desc(pch);
+	if (!desc) {
+		dev_err(pch->dmac->ddma.dev, "%s:%d Unable to fetch desc\n",
+			__func__, __LINE__);
+		return NULL;
+	}
+
+	desc->rqcfg.src_inc = direction == DMA_MEM_TO_DEV;
+	desc->rqcfg.dst_inc = !desc->rqcfg.src_inc;
+	for_each_sg(sgl, sg, sg_len, i) {
+		if (direction == DMA_MEM_TO_DEV)
+			fill_px(&desc->segs[i], pch->fifo_dma,
+				sg_dma_address(sg), sg_dma_len(sg));
+		else
+			fill_px(&desc->segs[i], sg_dma_address(sg),
+				pch->fifo_dma, sg_dma_len(sg));
+	}
+
+	desc->rqtype = direction;
+	desc->rqcfg.brst_size = pch->burst_sz;
+	desc->rqcfg.brst_len = pch->burst_len;
+	desc->bytes_requested = len;
+	desc->px = desc->segs[0];
+	desc->num_segs = sg_len;
+	desc->seg_sev = seg_sev;
+
+	desc->cyclic = true;
+	desc->num_periods = len / period_len;
+	desc->txd.flags = flags;
+
+	return &desc->txd;
+}
+
 static struct dma_async_tx_descriptor *
 pl330_prep_dma_memcpy(struct dma_chan *chan, dma_addr_t dst,
 		dma_addr_t src, size_t len, unsigned long flags)
@@ -3153,9 +3445,41 @@ static inline void init_pl330_debugfs(struct pl330_dmac *pl330)
  * It is assumed here that IRQ safe runtime PM is chosen in probe and amba
  * bus driver will only disable/enable the clock in runtime PM callbacks.
  */
+/*
+ * Clients stop their transfers before the system suspends, except those
+ * meant to run through it: an audio playback a coprocessor follows while
+ * the CPU sleeps is still cyclic and running here.
+ */
+static bool pl330_cyclic_running(struct pl330_dmac *pl330)
+{
+	struct dma_pl330_chan *pch;
+	struct pl330_thread *thrd;
+	unsigned long flags;
+	bool running = false;
+	int i;
+
+	for (i = 0; i < pl330->num_peripherals && !running; i++) {
+		pch = &pl330->peripherals[i];
+		spin_lock_irqsave(&pch->lock, flags);
+		thrd = pch->thread;
+		if (thrd && thrd->req_running != -1 &&
+		    thrd->req[thrd->req_running].desc &&
+		    thrd->req[thrd->req_running].desc->cyclic)
+			running = true;
+		spin_unlock_irqrestore(&pch->lock, flags);
+	}
+
+	return running;
+}
+
 static int __maybe_unused pl330_suspend(struct device *dev)
 {
 	struct amba_device *pcdev = to_amba_device(dev);
+	struct pl330_dmac *pl330 = amba_get_drvdata(pcdev);
+
+	pl330->kept_running = pl330_cyclic_running(pl330);
+	if (pl330->kept_running)
+		return 0;
 
 	pm_runtime_force_suspend(dev);
 	amba_pclk_unprepare(pcdev);
@@ -3166,8 +3490,14 @@ static int __maybe_unused pl330_suspend(struct device *dev)
 static int __maybe_unused pl330_resume(struct device *dev)
 {
 	struct amba_device *pcdev = to_amba_device(dev);
+	struct pl330_dmac *pl330 = amba_get_drvdata(pcdev);
 	int ret;
 
+	if (pl330->kept_running) {
+		pl330->kept_running = false;
+		return 0;
+	}
+
 	ret = amba_pclk_prepare(pcdev);
 	if (ret)
 		return ret;
@@ -3311,11 +3641,13 @@ pl330_probe(struct amba_device *adev, const struct amba_id *id)
 	pd->device_free_chan_resources = pl330_free_chan_resources;
 	pd->device_prep_dma_memcpy = pl330_prep_dma_memcpy;
 	pd->device_prep_dma_cyclic = pl330_prep_dma_cyclic;
+	pd->device_prep_dma_cyclic_sg = pl330_prep_dma_cyclic_sg;
 	pd->device_tx_status = pl330_tx_status;
 	pd->device_prep_slave_sg = pl330_prep_slave_sg;
 	pd->device_config = pl330_config;
 	pd->device_pause = pl330_pause;
 	pd->device_terminate_all = pl330_terminate_all;
+	pd->device_synchronize = pl330_synchronize;
 	pd->device_issue_pending = pl330_issue_pending;
 	pd->src_addr_widths = PL330_DMA_BUSWIDTHS;
 	pd->dst_addr_widths = PL330_DMA_BUSWIDTHS;
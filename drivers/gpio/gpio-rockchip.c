@@ -22,6 +22,7 @@
 #include <linux/property.h>
 #include <linux/regmap.h>
 
+#include <linux/soc/rockchip/rockchip_gpio.h>
 #include "../pinctrl/core.h"
 #include "../pinctrl/pinctrl-rockchip.h"
 
@@ -332,6 +333,10 @@ static void rockchip_irq_demux(struct irq_desc *desc)
 	struct rockchip_pin_bank *bank = irq_desc_get_handler_data(desc);
 	u32 pend;
 
+	/* before anything else, see rockchip_gpio_irq_timestamp() */
+	if (bank->ts_mask)
+		ktime_get_snapshot(&bank->ts);
+
 	dev_dbg(bank->dev, "got irq for bank %s\n", bank->name);
 
 	chained_irq_enter(chip, desc);
@@ -474,6 +479,79 @@ static int rockchip_irq_set_type(struct irq_data *d, unsigned int type)
 	return ret;
 }
 
+static struct rockchip_pin_bank *rockchip_irq_to_bank(unsigned int irq,
+						      u32 *mask)
+{
+	struct irq_data *d = irq_get_irq_data(irq);
+	struct irq_chip *chip = d ? irq_data_get_irq_chip(d) : NULL;
+	struct irq_chip_generic *gc;
+
+	if (!chip || chip->irq_set_type != rockchip_irq_set_type)
+		return NULL;
+
+	gc = irq_data_get_irq_chip_data(d);
+	*mask = BIT(d->hwirq);
+
+	return gc->private;
+}
+
+/**
+ * rockchip_gpio_irq_timestamp_enable - timestamp a GPIO interrupt at entry
+ * @irq: Linux interrupt number of the GPIO
+ * @enable: Whether to take the timestamp
+ *
+ * When enabled, the bank interrupt takes a system time snapshot first thing,
+ * before demultiplexing and flow handling, for rockchip_gpio_irq_timestamp().
+ *
+ * Return: 0 on success, -EINVAL if @irq is not a Rockchip GPIO interrupt.
+ */
+int rockchip_gpio_irq_timestamp_enable(unsigned int irq, bool enable)
+{
+	struct rockchip_pin_bank *bank;
+	unsigned long flags;
+	u32 mask;
+
+	bank = rockchip_irq_to_bank(irq, &mask);
+	if (!bank)
+		return -EINVAL;
+
+	raw_spin_lock_irqsave(&bank->slock, flags);
+	if (enable)
+		bank->ts_mask |= mask;
+	else
+		bank->ts_mask &= ~mask;
+	raw_spin_unlock_irqrestore(&bank->slock, flags);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rockchip_gpio_irq_timestamp_enable);
+
+/**
+ * rockchip_gpio_irq_timestamp - get the entry timestamp of a GPIO interrupt
+ * @irq: Linux interrupt number of the GPIO
+ * @snap: Filled with the snapshot taken when the bank interrupt was entered
+ *
+ * Only meaningful from the hardirq handler of @irq, the next bank interrupt
+ * overwrites the snapshot.
+ *
+ * Return: 0 on success, -EINVAL if timestamping is not enabled for @irq.
+ */
+int rockchip_gpio_irq_timestamp(unsigned int irq,
+				struct system_time_snapshot *snap)
+{
+	struct rockchip_pin_bank *bank;
+	u32 mask;
+
+	bank = rockchip_irq_to_bank(irq, &mask);
+	if (!bank || !(bank->ts_mask & mask))
+		return -EINVAL;
+
+	*snap = bank->ts;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rockchip_gpio_irq_timestamp);
+
 static void rockchip_irq_suspend(struct irq_data *d)
 {
 	struct irq_chip_generic *gc = irq_data_get_irq_chip_data(d);
@@ -55,6 +55,7 @@
 #define EBC_VNUM				0x0054 //Line flag num
 #define EBC_WIN_MST2			0x0058 //Framecount memory start
 #define EBC_LUT_DATA_ADDR	0x1000 //lut data address
+#define EBC_LUT_DATA_SIZE	4096 //256 frames x 16 or 64 frames x 64 words
 
 #define DSP_HTOTAL(x)			UPDATE(x, 27, 16)
 #define DSP_HS_END(x)			UPDATE(x, 7, 0)
@@ -226,6 +227,9 @@ static void tcon_disable(struct ebc_tcon *tcon)
 	pm_runtime_put_sync(tcon->dev);
 	clk_disable_unprepare(tcon->dclk);
 	clk_disable_unprepare(tcon->hclk);
+
+	/* the lut ram may lose its content with the power domain */
+	tcon->lut_cache_valid = 0;
 }
 
 static void tcon_dsp_mode_set(struct ebc_tcon *tcon, int update_mode, int display_mode, int three_win_mode, int eink_mode)
@@ -267,9 +271,22 @@ static int tcon_lut_data_set(struct ebc_tcon *tcon, unsigned int *lut_data, int
 	else
 		lut_size = frame_count * 16;
 
+	/*
+	 * The waveform only changes with the update mode and the temperature
+	 * range, most updates load the lut already in the ram: only write
+	 * the words that differ from it.
+	 */
+	if (lut_size <= tcon->lut_cache_valid &&
+	    !memcmp(tcon->lut_cache, lut_data, lut_size * sizeof(*lut_data)))
+		return 0;
+
 	for (i = 0; i < lut_size; i++) {
+		if (i < tcon->lut_cache_valid && tcon->lut_cache[i] == lut_data[i])
+			continue;
 		tcon_write(tcon, EBC_LUT_DATA_ADDR + (i * 4), lut_data[i]);
+		tcon->lut_cache[i] = lut_data[i];
 	}
+	tcon->lut_cache_valid = max(tcon->lut_cache_valid, lut_size);
 	tcon_cfg_done(tcon);
 
 	return 0;
@@ -339,6 +356,11 @@ static int ebc_tcon_probe(struct platform_device *pdev)
 		return PTR_ERR(tcon->regs);
 
 	tcon->len = resource_size(res);
+	tcon->lut_cache = devm_kcalloc(dev, EBC_LUT_DATA_SIZE,
+				       sizeof(*tcon->lut_cache), GFP_KERNEL);
+	if (!tcon->lut_cache)
+		return -ENOMEM;
+
 	ebc_regmap_config.max_register = resource_size(res) - 4;
 	ebc_regmap_config.name = "rockchip,ebc_tcon";
 	tcon->regmap_base = devm_regmap_init_mmio(dev, tcon->regs, &ebc_regmap_config);
@@ -30,6 +30,10 @@ struct ebc_tcon {
 	struct clk *dclk;
 	struct regmap *regmap_base;
 
+	/* what the lut ram holds, lut_cache_valid words of it */
+	unsigned int *lut_cache;
+	int lut_cache_valid;
+
 	int (*enable)(struct ebc_tcon *tcon, struct ebc_panel *panel);
 	void (*disable)(struct ebc_tcon *tcon);
 	void (*dsp_mode_set)(struct ebc_tcon *tcon, int update_mode, int display_mode, int three_win_mode, int eink_mode);
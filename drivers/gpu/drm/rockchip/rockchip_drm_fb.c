@@ -83,6 +83,7 @@ static int rockchip_drm_gem_fb_create_handle(struct drm_framebuffer *fb,
 static const struct drm_framebuffer_funcs rockchip_drm_fb_funcs = {
 	.destroy       = rockchip_drm_fb_destroy,
 	.create_handle = rockchip_drm_gem_fb_create_handle,
+	.dirty         = drm_atomic_helper_dirtyfb,
 };
 
 struct drm_framebuffer *
@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: (GPL-2.0+ OR MIT)
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd.
+ *
+ * Level meter overlay drawn by the kernel on a plane of its own through
+ * the direct show api, fed with peaks by rockchip_drm_meter_update().
+ * Two buffers ping pong, and a commit is only made when a bar or the
+ * progress bar moved by a pixel.
+ */
+
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+#include <linux/soc/rockchip/rockchip_drm_meter.h>
+
+#include "rockchip_drm_drv.h"
+#include "rockchip_drm_direct_show.h"
+
+#define METER_BUFFER_NUM	2
+#define METER_PROGRESS_H	4
+#define METER_GAP		2
+/* the bars cover 60dB, 10 octaves from full scale */
+#define METER_LOG2_FLOOR	(6 << 8)
+#define METER_LOG2_RANGE	(10 << 8)
+
+#define METER_COLOR_BG		0x00000000
+#define METER_COLOR_GREEN	0xff20c020
+#define METER_COLOR_YELLOW	0xffe0c000
+#define METER_COLOR_RED		0xffe02020
+#define METER_COLOR_PROGRESS	0xffc0c0c0
+
+static char *meter_plane = "Esmart1-win0";
+module_param(meter_plane, charp, 0444);
+MODULE_PARM_DESC(meter_plane, "plane the level meter is shown on");
+
+static unsigned int meter_x;
+module_param(meter_x, uint, 0444);
+static unsigned int meter_y;
+module_param(meter_y, uint, 0444);
+static unsigned int meter_width = 128;
+module_param(meter_width, uint, 0444);
+static unsigned int meter_height = 64;
+module_param(meter_height, uint, 0444);
+
+struct rockchip_drm_meter {
+	struct drm_device *dev;
+	struct drm_crtc *crtc;
+	struct drm_plane *plane;
+	struct rockchip_drm_direct_show_buffer buffer[METER_BUFFER_NUM];
+	int back;
+	bool ready;
+	bool shown;
+
+	struct delayed_work work;
+	spinlock_t lock;
+	struct rockchip_drm_meter_levels levels;
+
+	/* what is on screen, in pixels */
+	unsigned int channels;
+	unsigned int bar[ROCKCHIP_DRM_METER_MAX_CHANNELS];
+	unsigned int progress;
+};
+
+static struct rockchip_drm_meter rockchip_drm_meter;
+
+/* log2 of a 16 bit peak in 8.8 fixed point, linear in between octaves */
+static unsigned int rockchip_drm_meter_log2(u16 peak)
+{
+	unsigned int l;
+
+	if (!peak)
+		return 0;
+
+	l = ilog2(peak);
+
+	return (l << 8) | ((((u32)peak << (16 - l)) & 0xffff) >> 8);
+}
+
+static unsigned int rockchip_drm_meter_bar(u16 peak, unsigned int height)
+{
+	int v = rockchip_drm_meter_log2(peak) - METER_LOG2_FLOOR;
+
+	return clamp(v, 0, METER_LOG2_RANGE) * height / METER_LOG2_RANGE;
+}
+
+static void rockchip_drm_meter_draw(struct rockchip_drm_meter *meter,
+				    struct rockchip_drm_direct_show_buffer *buffer)
+{
+	unsigned int bars_h = buffer->height - METER_PROGRESS_H;
+	unsigned int bar_w = (buffer->width + METER_GAP) / meter->channels;
+	unsigned int x, y, ch;
+	u32 *line, color;
+
+	for (y = 0; y < buffer->height; y++) {
+		line = buffer->vir_addr[0] + y * buffer->pitch[0];
+
+		if (y >= bars_h) {
+			for (x = 0; x < buffer->width; x++)
+				line[x] = x < meter->progress ?
+					  METER_COLOR_PROGRESS : METER_COLOR_BG;
+			continue;
+		}
+
+		/* -3dB and -12dB from the top of the scale */
+		if (y < bars_h / 20)
+			color = METER_COLOR_RED;
+		else if (y < bars_h / 5)
+			color = METER_COLOR_YELLOW;
+		else
+			color = METER_COLOR_GREEN;
+
+		for (x = 0; x < buffer->width; x++) {
+			ch = x / bar_w;
+			line[x] = ch < meter->channels &&
+				  x % bar_w + METER_GAP < bar_w &&
+				  bars_h - y <= meter->bar[ch] ?
+				  color : METER_COLOR_BG;
+		}
+	}
+}
+
+static int rockchip_drm_meter_setup(struct rockchip_drm_meter *meter)
+{
+	struct rockchip_drm_direct_show_buffer *buffer;
+	int i, ret;
+
+	meter->dev = rockchip_drm_get_dev();
+	if (!meter->dev)
+		return -EPROBE_DEFER;
+
+	meter->crtc = rockchip_drm_direct_show_get_crtc(meter->dev, NULL);
+	if (!meter->crtc)
+		return -EPROBE_DEFER;
+
+	meter->plane = rockchip_drm_direct_show_get_plane(meter->dev,
+							  meter_plane);
+	if (!meter->plane)
+		return -ENODEV;
+
+	for (i = 0; i < METER_BUFFER_NUM; i++) {
+		buffer = &meter->buffer[i];
+		buffer->width = meter_width;
+		buffer->height = max(meter_height, METER_PROGRESS_H + 1U);
+		buffer->pixel_format = DRM_FORMAT_ARGB8888;
+		buffer->flag = ROCKCHIP_BO_CONTIG;
+		ret = rockchip_drm_direct_show_alloc_buffer(meter->dev, buffer);
+		if (ret) {
+			while (i--)
+				rockchip_drm_direct_show_free_buffer(meter->dev,
+								     &meter->buffer[i]);
+			return ret;
+		}
+	}
+
+	meter->ready = true;
+
+	return 0;
+}
+
+static void rockchip_drm_meter_work(struct work_struct *work)
+{
+	struct rockchip_drm_meter *meter =
+		container_of(to_delayed_work(work), struct rockchip_drm_meter, work);
+	struct rockchip_drm_direct_show_commit_info commit_info = {};
+	struct rockchip_drm_direct_show_buffer *buffer;
+	struct rockchip_drm_meter_levels levels;
+	unsigned int bar[ROCKCHIP_DRM_METER_MAX_CHANNELS];
+	unsigned int bars_h, progress = 0, ch;
+	int ret;
+
+	if (!meter->ready) {
+		ret = rockchip_drm_meter_setup(meter);
+		if (ret == -EPROBE_DEFER) {
+			schedule_delayed_work(&meter->work, HZ / 10);
+			return;
+		}
+		if (ret) {
+			DRM_ERROR("level meter disabled: %d\n", ret);
+			return;
+		}
+	}
+
+	spin_lock_irq(&meter->lock);
+	levels = meter->levels;
+	spin_unlock_irq(&meter->lock);
+
+	if (!levels.channels) {
+		if (meter->shown)
+			rockchip_drm_direct_show_disable_plane(meter->dev,
+							       meter->plane);
+		meter->shown = false;
+		return;
+	}
+
+	buffer = &meter->buffer[meter->back];
+	bars_h = buffer->height - METER_PROGRESS_H;
+	for (ch = 0; ch < levels.channels; ch++)
+		bar[ch] = rockchip_drm_meter_bar(levels.peak[ch], bars_h);
+	if (levels.len_ms)
+		progress = div_u64((u64)min(levels.pos_ms, levels.len_ms) *
+				   buffer->width, levels.len_ms);
+
+	/* nothing moved by a pixel, keep what is on screen */
+	if (meter->shown && levels.channels == meter->channels &&
+	    progress == meter->progress &&
+	    !memcmp(bar, meter->bar, levels.channels * sizeof(bar[0])))
+		return;
+
+	meter->channels = levels.channels;
+	memcpy(meter->bar, bar, sizeof(bar));
+	meter->progress = progress;
+	rockchip_drm_meter_draw(meter, buffer);
+
+	commit_info.crtc = meter->crtc;
+	commit_info.plane = meter->plane;
+	commit_info.buffer = buffer;
+	commit_info.src_w = buffer->width;
+	commit_info.src_h = buffer->height;
+	commit_info.dst_x = meter_x;
+	commit_info.dst_y = meter_y;
+	commit_info.dst_w = buffer->width;
+	commit_info.dst_h = buffer->height;
+	commit_info.top_zpos = true;
+
+	/* blocking, the front buffer is released once it returns */
+	ret = rockchip_drm_direct_show_commit(meter->dev, &commit_info);
+	if (ret) {
+		DRM_DEV_ERROR(meter->dev->dev, "level meter commit: %d\n", ret);
+		meter->shown = false;
+		return;
+	}
+
+	meter->shown = true;
+	meter->back = !meter->back;
+}
+
+/**
+ * rockchip_drm_meter_update - show new levels on the meter overlay
+ * @levels: peaks and track position, @levels->channels 0 hides it
+ *
+ * Can be called from any context, such as a PCM period callback. Updates
+ * arriving faster than the display can show are merged, only the last
+ * levels are drawn.
+ */
+void rockchip_drm_meter_update(const struct rockchip_drm_meter_levels *levels)
+{
+	struct rockchip_drm_meter *meter = &rockchip_drm_meter;
+	unsigned long flags;
+
+	spin_lock_irqsave(&meter->lock, flags);
+	meter->levels = *levels;
+	meter->levels.channels = min_t(unsigned int, levels->channels,
+				       ROCKCHIP_DRM_METER_MAX_CHANNELS);
+	spin_unlock_irqrestore(&meter->lock, flags);
+
+	schedule_delayed_work(&meter->work, 0);
+}
+EXPORT_SYMBOL_GPL(rockchip_drm_meter_update);
+
+static int __init rockchip_drm_meter_init(void)
+{
+	spin_lock_init(&rockchip_drm_meter.lock);
+	INIT_DELAYED_WORK(&rockchip_drm_meter.work, rockchip_drm_meter_work);
+
+	return 0;
+}
+subsys_initcall_sync(rockchip_drm_meter_init);
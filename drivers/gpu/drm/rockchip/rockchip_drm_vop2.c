@@ -8,6 +8,7 @@
 #include <drm/drm_atomic_uapi.h>
 #include <drm/drm_crtc.h>
 #include <drm/drm_crtc_helper.h>
+#include <drm/drm_damage_helper.h>
 #include <drm/drm_debugfs.h>
 #include <drm/drm_flip_work.h>
 #include <drm/drm_fourcc.h>
@@ -4569,6 +4570,8 @@ static int vop2_plane_atomic_check(struct drm_plane *plane, struct drm_plane_sta
 	if (WARN_ON(!cstate))
 		return -EINVAL;
 
+	drm_atomic_helper_check_plane_damage(state->state, state);
+
 	mode = &cstate->mode;
 	vcstate = to_rockchip_crtc_state(cstate);
 
@@ -5687,11 +5690,61 @@ static void vop2_crtc_line_flag_irq_disable(struct vop2_video_port *vp)
 	spin_unlock_irqrestore(&vop2->irq_lock, flags);
 }
 
+/*
+ * A panel with its own frame memory is left in hold mode: the vp only
+ * fetches a frame from ddr when a commit starts one with mcu_frame_st,
+ * so a static picture costs no ddr bandwidth at all.
+ */
+static bool vop3_mcu_hold_mode(struct vop2_video_port *vp)
+{
+	return vp->mcu_timing.mcu_pix_total && vp->mcu_timing.mcu_hold_mode;
+}
+
+/*
+ * Only commits that change what is on the screen need a frame in hold
+ * mode: planes with damage or switched on or off, and anything else than
+ * a plane update.
+ */
+static bool vop3_mcu_need_refresh(struct drm_crtc *crtc,
+				  struct drm_crtc_state *old_cstate)
+{
+	struct drm_atomic_state *state = old_cstate->state;
+	struct drm_plane_state *old_pstate, *new_pstate;
+	struct drm_plane *plane;
+	struct drm_rect clip;
+	bool has_plane = false;
+	int i;
+
+	if (drm_atomic_crtc_needs_modeset(crtc->state) ||
+	    crtc->state->color_mgmt_changed)
+		return true;
+
+	for_each_oldnew_plane_in_state(state, plane, old_pstate, new_pstate, i) {
+		if (old_pstate->crtc != crtc && new_pstate->crtc != crtc)
+			continue;
+
+		has_plane = true;
+		if (old_pstate->crtc != new_pstate->crtc ||
+		    old_pstate->visible != new_pstate->visible)
+			return true;
+		if (drm_atomic_helper_damage_merged(old_pstate, new_pstate, &clip))
+			return true;
+	}
+
+	return !has_plane;
+}
+
 static void vop3_mcu_mode_setup(struct drm_crtc *crtc)
 {
 	struct vop2_video_port *vp = to_vop2_video_port(crtc);
 	struct vop2 *vop2 = vp->vop2;
 
+	/*
+	 * If mcu_hold_mode is 1, set 1 to mcu_frame_st will
+	 * refresh one frame from ddr. So mcu_frame_st is needed
+	 * to be initialized as 0.
+	 */
+	VOP_MODULE_SET(vop2, vp, mcu_frame_st, 0);
 	VOP_MODULE_SET(vop2, vp, mcu_type, 1);
 	VOP_MODULE_SET(vop2, vp, mcu_hold_mode, 1);
 	VOP_MODULE_SET(vop2, vp, mcu_pix_total, vp->mcu_timing.mcu_pix_total);
@@ -6408,9 +6461,9 @@ static size_t vop2_crtc_bandwidth(struct drm_crtc *crtc,
 	u64 line_bw_mbyte = 0;
 	int8_t cnt = 0, plane_num = 0;
 	int i = 0;
+	struct vop2_video_port *vp = to_vop2_video_port(crtc);
 #if defined(CONFIG_ROCKCHIP_DRM_DEBUG)
 	struct vop_dump_list *pos, *n;
-	struct vop2_video_port *vp = to_vop2_video_port(crtc);
 #endif
 
 	if (!htotal || !vdisplay)
@@ -6443,7 +6496,8 @@ static size_t vop2_crtc_bandwidth(struct drm_crtc *crtc,
 
 	for_each_new_plane_in_state(state, plane, pstate, i) {
 		int act_w, act_h, bpp, afbc_fac;
-		int fps = drm_mode_vrefresh(adjusted_mode);
+		/* frames are only fetched on updates in mcu hold mode */
+		int fps = vop3_mcu_hold_mode(vp) ? 0 : drm_mode_vrefresh(adjusted_mode);
 
 		if (!pstate || pstate->crtc != crtc || !pstate->fb)
 			continue;
@@ -9646,6 +9700,10 @@ static void vop2_crtc_atomic_flush(struct drm_crtc *crtc, struct drm_crtc_state
 	struct vop2_wb *wb = &vop2->wb;
 	struct drm_writeback_connector *wb_conn = &wb->conn;
 	struct drm_connector_state *conn_state = wb_conn->base.state;
+	bool mcu_refresh = true;
+
+	if (vop3_mcu_hold_mode(vp))
+		mcu_refresh = vop3_mcu_need_refresh(crtc, old_cstate);
 
 	if (conn_state && conn_state->writeback_job && conn_state->writeback_job->fb) {
 		u16 vtotal = VOP_MODULE_GET(vop2, vp, dsp_vtotal);
@@ -9703,8 +9761,14 @@ static void vop2_crtc_atomic_flush(struct drm_crtc *crtc, struct drm_crtc_state
 	vop2_wb_commit(crtc);
 	vop2_cfg_done(crtc);
 
-	if (vp->mcu_timing.mcu_pix_total)
+	if (vop3_mcu_hold_mode(vp)) {
+		if (mcu_refresh) {
+			VOP_MODULE_SET(vop2, vp, mcu_frame_st, 0);
+			VOP_MODULE_SET(vop2, vp, mcu_frame_st, 1);
+		}
+	} else if (vp->mcu_timing.mcu_pix_total) {
 		VOP_MODULE_SET(vop2, vp, mcu_hold_mode, 0);
+	}
 
 	spin_unlock_irqrestore(&vop2->irq_lock, flags);
 
@@ -9722,7 +9786,11 @@ static void vop2_crtc_atomic_flush(struct drm_crtc *crtc, struct drm_crtc_state
 	vp->layer_sel_update = false;
 
 	spin_lock_irq(&crtc->dev->event_lock);
-	if (crtc->state->event) {
+	if (crtc->state->event && !mcu_refresh) {
+		/* no frame is going to start and complete it */
+		drm_crtc_send_vblank_event(crtc, crtc->state->event);
+		crtc->state->event = NULL;
+	} else if (crtc->state->event) {
 		WARN_ON(drm_crtc_vblank_get(crtc) != 0);
 		WARN_ON(vp->event);
 
@@ -10530,6 +10598,7 @@ static int vop2_plane_init(struct vop2 *vop2, struct vop2_win *win, unsigned lon
 	drm_plane_create_alpha_property(&win->base);
 	drm_plane_create_blend_mode_property(&win->base, blend_caps);
 	drm_plane_create_zpos_property(&win->base, win->win_id, 0, vop2->registered_num_wins - 1);
+	drm_plane_enable_fb_damage_clips(&win->base);
 	vop2_plane_create_name_property(vop2, win);
 	vop2_plane_create_feature_property(vop2, win);
 	max_width = vop2->data->max_input.width;
@@ -209,6 +209,8 @@ struct rk3x_i2c_soc_data {
  * @addr: addr of i2c slave device
  * @mode: mode of i2c transfer
  * @is_last_msg: flag determines whether it is the last msg in this transfer
+ * @msgs: messages of this transfer queued behind @msg
+ * @num_left: number of messages in @msgs
  * @state: state of i2c transfer
  * @processed: byte length which has been send or received
  * @error: error code for i2c transfer
@@ -244,6 +246,8 @@ struct rk3x_i2c {
 	u8 addr;
 	unsigned int mode;
 	bool is_last_msg;
+	struct i2c_msg *msgs;
+	int num_left;
 
 	/* I2C state machine */
 	enum rk3x_i2c_state state;
@@ -259,6 +263,7 @@ struct rk3x_i2c {
 
 static void rk3x_i2c_prepare_read(struct rk3x_i2c *i2c);
 static int rk3x_i2c_fill_transmit_buf(struct rk3x_i2c *i2c, bool sended);
+static int rk3x_i2c_setup(struct rk3x_i2c *i2c, struct i2c_msg *msgs, int num);
 
 static inline void rk3x_i2c_wake_up(struct rk3x_i2c *i2c)
 {
@@ -376,6 +381,22 @@ static void rk3x_i2c_start(struct rk3x_i2c *i2c)
 		rk3x_i2c_prepare_read(i2c);
 }
 
+/**
+ * Set up and start the next queued message straight from the interrupt
+ * handler, so a multi-message transfer such as a codec register sequence
+ * does not bounce through the waiting thread between messages.
+ */
+static void rk3x_i2c_start_next(struct rk3x_i2c *i2c)
+{
+	int ret = rk3x_i2c_setup(i2c, i2c->msgs, i2c->num_left);
+
+	i2c->msgs += ret;
+	i2c->num_left -= ret;
+	i2c->is_last_msg = !i2c->num_left;
+
+	rk3x_i2c_start(i2c);
+}
+
 /**
  * Generate a STOP condition, which triggers a REG_INT_STOP interrupt.
  *
@@ -400,10 +421,6 @@ static void rk3x_i2c_stop(struct rk3x_i2c *i2c, int error)
 		ctrl &= ~REG_CON_START;
 		i2c_writel(i2c, ctrl, REG_CON);
 	} else {
-		/* Signal rk3x_i2c_xfer to start the next message. */
-		i2c->busy = false;
-		i2c->state = STATE_IDLE;
-
 		/*
 		 * The HW is actually not capable of REPEATED START. But we can
 		 * get the intended effect by resetting its internal state
@@ -412,7 +429,14 @@ static void rk3x_i2c_stop(struct rk3x_i2c *i2c, int error)
 		ctrl = i2c_readl(i2c, REG_CON) & REG_CON_TUNING_MASK;
 		i2c_writel(i2c, ctrl, REG_CON);
 
-		/* signal that we are finished with the current msg */
+		if (!error && i2c->num_left) {
+			rk3x_i2c_start_next(i2c);
+			return;
+		}
+
+		/* Signal rk3x_i2c_xfer that we are finished with the msgs. */
+		i2c->busy = false;
+		i2c->state = STATE_IDLE;
 		rk3x_i2c_wake_up(i2c);
 	}
 }
@@ -1170,6 +1194,26 @@ static int rk3x_i2c_setup(struct rk3x_i2c *i2c, struct i2c_msg *msgs, int num)
 	return ret;
 }
 
+/*
+ * Transfer time in mSec = Total bits / transfer rate + interval time
+ * Total bits = 9 bits per byte (including ACK bit) + Start & stop bits
+ */
+static unsigned long rk3x_i2c_xfer_time(struct rk3x_i2c *i2c,
+					struct i2c_msg *msgs, int num)
+{
+	unsigned long xfer_time = WAIT_TIMEOUT;
+	int i;
+
+	for (i = 0; i < num; i++) {
+		xfer_time += msgs[i].len / 64;
+		xfer_time += DIV_ROUND_CLOSEST(((msgs[i].len * 9) + 2) *
+					       MSEC_PER_SEC,
+					       i2c->t.bus_freq_hz);
+	}
+
+	return xfer_time;
+}
+
 static int rk3x_i2c_wait_xfer_poll(struct rk3x_i2c *i2c, unsigned long xfer_time)
 {
 	ktime_t timeout = ktime_add_ms(ktime_get(), xfer_time);
@@ -1222,11 +1266,11 @@ static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 
 	/*
 	 * Process msgs. We can handle more than one message at once (see
-	 * rk3x_i2c_setup()).
+	 * rk3x_i2c_setup()), and the interrupt handler starts the ones after
+	 * the first by itself (see rk3x_i2c_start_next()).
 	 */
-	for (i = 0; i < num; i += ret) {
-		unsigned long xfer_time = WAIT_TIMEOUT;
-		int len;
+	for (i = 0; i < num; i = num - i2c->num_left) {
+		unsigned long xfer_time;
 
 		ret = rk3x_i2c_setup(i2c, msgs + i, num - i);
 		if (ret < 0) {
@@ -1234,19 +1278,11 @@ static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 			break;
 		}
 
-		/*
-		 * Transfer time in mSec = Total bits / transfer rate + interval time
-		 * Total bits = 9 bits per byte (including ACK bit) + Start & stop bits
-		 */
-		if (ret == 2)
-			len = msgs[i + 1].len;
-		else
-			len = msgs[i].len;
-		xfer_time += len / 64;
-		xfer_time += DIV_ROUND_CLOSEST(((len * 9) + 2) * MSEC_PER_SEC,
-					       i2c->t.bus_freq_hz);
+		i2c->msgs = msgs + i + ret;
+		i2c->num_left = num - i - ret;
+		xfer_time = rk3x_i2c_xfer_time(i2c, msgs + i, num - i);
 
-		if (i + ret >= num)
+		if (!i2c->num_left)
 			i2c->is_last_msg = true;
 
 		rk3x_i2c_start(i2c);
@@ -1285,6 +1321,7 @@ static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 		}
 	}
 
+	i2c->num_left = 0;
 	rk3x_i2c_disable_irq(i2c);
 	rk3x_i2c_disable(i2c);
 
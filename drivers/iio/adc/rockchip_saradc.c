@@ -16,6 +16,7 @@
 #include <linux/reset.h>
 #include <linux/regulator/consumer.h>
 #include <linux/iio/buffer.h>
+#include <linux/iio/events.h>
 #include <linux/iio/iio.h>
 #include <linux/iio/trigger_consumer.h>
 #include <linux/iio/triggered_buffer.h>
@@ -41,12 +42,19 @@
 #define SARADC2_CONV_CON		0x0
 #define SARADC_T_PD_SOC			0x4
 #define SARADC_T_DAS_SOC		0xc
+#define SARADC2_HIGH_COMP(chn)		(0x20 + (chn) * 0x4)
+#define SARADC2_LOW_COMP(chn)		(0x60 + (chn) * 0x4)
+#define SARADC2_HT_INT_EN		0xa4
+#define SARADC2_LT_INT_EN		0xa8
 #define SARADC2_END_INT_EN		0x104
 #define SARADC2_ST_CON			0x108
 #define SARADC2_STATUS			0x10c
 #define SARADC2_END_INT_ST		0x110
+#define SARADC2_HT_INT_ST		0x114
+#define SARADC2_LT_INT_ST		0x118
 #define SARADC2_DATA_BASE		0x120
 
+#define SARADC2_CHN_MASK		0xf
 #define SARADC2_EN_END_INT		BIT(0)
 #define SARADC2_START			BIT(4)
 #define SARADC2_SINGLE_MODE		BIT(5)
@@ -60,6 +68,8 @@ struct rockchip_saradc_data {
 	void (*start)(struct rockchip_saradc *info, int chn);
 	int (*read)(struct rockchip_saradc *info);
 	void (*power_down)(struct rockchip_saradc *info);
+	void (*monitor)(struct rockchip_saradc *info);
+	bool (*monitor_irq)(struct rockchip_saradc *info, u32 *high, u32 *low);
 };
 
 struct rockchip_saradc {
@@ -75,6 +85,20 @@ struct rockchip_saradc {
 	const struct iio_chan_spec *last_chan;
 	struct notifier_block nb;
 	bool			suspended;
+	struct iio_dev		*indio_dev;
+
+	/*
+	 * Threshold monitor: the channel converted continuously with the
+	 * comparators armed (-1 if none), the event directions enabled on
+	 * it and which side of the window it was last seen on. Protected
+	 * by mon_lock against the interrupt handler.
+	 */
+	spinlock_t		mon_lock;
+	int			mon_chn;
+	unsigned int		mon_dir;
+	bool			mon_above;
+	u16			thresh_high[SARADC_MAX_CHANNELS];
+	u16			thresh_low[SARADC_MAX_CHANNELS];
 #ifdef CONFIG_ROCKCHIP_SARADC_TEST_CHN
 	bool			test;
 	u32			chn;
@@ -107,6 +131,12 @@ static void rockchip_saradc_start_v2(struct rockchip_saradc *info,
 	if (info->reset)
 		rockchip_saradc_reset_controller(info->reset);
 
+	/* A single conversion preempts the monitor, restarted afterwards */
+	if (info->mon_chn >= 0) {
+		writel_relaxed(0xffff << 16, info->regs + SARADC2_HT_INT_EN);
+		writel_relaxed(0xffff << 16, info->regs + SARADC2_LT_INT_EN);
+	}
+
 	writel_relaxed(0xc, info->regs + SARADC_T_DAS_SOC);
 	writel_relaxed(0x20, info->regs + SARADC_T_PD_SOC);
 	val = SARADC2_EN_END_INT << 16 | SARADC2_EN_END_INT;
@@ -115,6 +145,62 @@ static void rockchip_saradc_start_v2(struct rockchip_saradc *info,
 	writel(val << 16 | val, info->regs + SARADC2_CONV_CON);
 }
 
+/*
+ * Convert mon_chn continuously and let the comparators interrupt only when
+ * it leaves the side of the window it is on, so nothing runs on the CPU
+ * while the input is stable. With only one direction enabled the other
+ * comparator uses the same threshold, just to re-arm it.
+ */
+static void rockchip_saradc_monitor_v2(struct rockchip_saradc *info)
+{
+	int chn = info->mon_chn;
+	u16 high, low;
+	u32 val;
+
+	if (chn < 0) {
+		writel_relaxed(0xffff << 16, info->regs + SARADC2_HT_INT_EN);
+		writel_relaxed(0xffff << 16, info->regs + SARADC2_LT_INT_EN);
+		val = SARADC2_START | SARADC2_SINGLE_MODE;
+		writel(val << 16 | SARADC2_SINGLE_MODE,
+		       info->regs + SARADC2_CONV_CON);
+		return;
+	}
+
+	high = info->thresh_high[chn];
+	low = info->thresh_low[chn];
+	if (!(info->mon_dir & BIT(IIO_EV_DIR_RISING)))
+		high = low;
+	if (!(info->mon_dir & BIT(IIO_EV_DIR_FALLING)))
+		low = high;
+
+	writel_relaxed(0xc, info->regs + SARADC_T_DAS_SOC);
+	writel_relaxed(0x20, info->regs + SARADC_T_PD_SOC);
+	writel_relaxed(SARADC2_EN_END_INT << 16,
+		       info->regs + SARADC2_END_INT_EN);
+	writel_relaxed(high, info->regs + SARADC2_HIGH_COMP(chn));
+	writel_relaxed(low, info->regs + SARADC2_LOW_COMP(chn));
+	writel_relaxed(BIT(chn) << 16 | (info->mon_above ? 0 : BIT(chn)),
+		       info->regs + SARADC2_HT_INT_EN);
+	writel_relaxed(BIT(chn) << 16 | (info->mon_above ? BIT(chn) : 0),
+		       info->regs + SARADC2_LT_INT_EN);
+	val = SARADC2_START | SARADC2_SINGLE_MODE | SARADC2_CHN_MASK;
+	writel(val << 16 | SARADC2_START | chn, info->regs + SARADC2_CONV_CON);
+}
+
+static bool rockchip_saradc_monitor_irq_v2(struct rockchip_saradc *info,
+					   u32 *high, u32 *low)
+{
+	*high = readl_relaxed(info->regs + SARADC2_HT_INT_ST);
+	*low = readl_relaxed(info->regs + SARADC2_LT_INT_ST);
+	if (!*high && !*low)
+		return false;
+
+	writel_relaxed(*high, info->regs + SARADC2_HT_INT_ST);
+	writel_relaxed(*low, info->regs + SARADC2_LT_INT_ST);
+
+	return true;
+}
+
 static void rockchip_saradc_start(struct rockchip_saradc *info,
 					int chn)
 {
@@ -161,6 +247,54 @@ static void rockchip_saradc_power_down(struct rockchip_saradc *info)
 		info->data->power_down(info);
 }
 
+/* (Re)program the threshold monitor from its state, or stop it */
+static void rockchip_saradc_monitor_update(struct rockchip_saradc *info)
+{
+	unsigned long flags;
+
+	if (!info->data->monitor)
+		return;
+
+	if (info->mon_chn >= 0 && info->reset)
+		rockchip_saradc_reset_controller(info->reset);
+
+	spin_lock_irqsave(&info->mon_lock, flags);
+	info->data->monitor(info);
+	spin_unlock_irqrestore(&info->mon_lock, flags);
+}
+
+static bool rockchip_saradc_monitor_irq(struct rockchip_saradc *info)
+{
+	struct iio_dev *indio_dev = info->indio_dev;
+	enum iio_event_direction dir;
+	int chn = info->mon_chn;
+	u32 high, low;
+
+	if (!info->data->monitor_irq(info, &high, &low))
+		return false;
+
+	if (chn < 0)
+		return true;
+
+	if (!info->mon_above && (high & BIT(chn)))
+		dir = IIO_EV_DIR_RISING;
+	else if (info->mon_above && (low & BIT(chn)))
+		dir = IIO_EV_DIR_FALLING;
+	else
+		return true;
+
+	info->mon_above = dir == IIO_EV_DIR_RISING;
+	if (info->mon_dir & BIT(dir))
+		iio_push_event(indio_dev,
+			       IIO_UNMOD_EVENT_CODE(IIO_VOLTAGE, chn,
+						    IIO_EV_TYPE_THRESH, dir),
+			       iio_get_time_ns(indio_dev));
+
+	info->data->monitor(info);
+
+	return true;
+}
+
 static int rockchip_saradc_conversion(struct rockchip_saradc *info,
 				   struct iio_chan_spec const *chan)
 {
@@ -199,11 +333,15 @@ static int rockchip_saradc_read_raw(struct iio_dev *indio_dev,
 		ret = rockchip_saradc_conversion(info, chan);
 		if (ret) {
 			rockchip_saradc_power_down(info);
+			if (info->mon_chn >= 0)
+				rockchip_saradc_monitor_update(info);
 			mutex_unlock(&indio_dev->mlock);
 			return ret;
 		}
 
 		*val = info->last_val;
+		if (info->mon_chn >= 0)
+			rockchip_saradc_monitor_update(info);
 		mutex_unlock(&indio_dev->mlock);
 		return IIO_VAL_INT;
 	case IIO_CHAN_INFO_SCALE:
@@ -226,6 +364,18 @@ static irqreturn_t rockchip_saradc_isr(int irq, void *dev_id)
 	unsigned long flags;
 #endif
 
+	if (info->data->monitor_irq) {
+		bool handled;
+
+		spin_lock(&info->mon_lock);
+		handled = info->mon_chn >= 0 &&
+			  rockchip_saradc_monitor_irq(info);
+		spin_unlock(&info->mon_lock);
+
+		if (handled)
+			return IRQ_HANDLED;
+	}
+
 	/* Read value */
 	info->last_val = rockchip_saradc_read(info);
 #ifndef CONFIG_ROCKCHIP_SARADC_TEST_CHN
@@ -246,11 +396,115 @@ static irqreturn_t rockchip_saradc_isr(int irq, void *dev_id)
 	return IRQ_HANDLED;
 }
 
+static int rockchip_saradc_read_event_config(struct iio_dev *indio_dev,
+					     const struct iio_chan_spec *chan,
+					     enum iio_event_type type,
+					     enum iio_event_direction dir)
+{
+	struct rockchip_saradc *info = iio_priv(indio_dev);
+
+	return info->mon_chn == chan->channel && (info->mon_dir & BIT(dir));
+}
+
+static int rockchip_saradc_write_event_config(struct iio_dev *indio_dev,
+					      const struct iio_chan_spec *chan,
+					      enum iio_event_type type,
+					      enum iio_event_direction dir,
+					      int state)
+{
+	struct rockchip_saradc *info = iio_priv(indio_dev);
+	int ret = 0;
+
+	mutex_lock(&indio_dev->mlock);
+
+	/* The comparators only see the channel being converted */
+	if (info->mon_chn >= 0 && info->mon_chn != chan->channel) {
+		ret = state ? -EBUSY : 0;
+		goto out;
+	}
+
+	if (state)
+		info->mon_dir |= BIT(dir);
+	else
+		info->mon_dir &= ~BIT(dir);
+	info->mon_chn = info->mon_dir ? chan->channel : -1;
+	info->mon_above = false;
+
+	if (!info->suspended)
+		rockchip_saradc_monitor_update(info);
+out:
+	mutex_unlock(&indio_dev->mlock);
+
+	return ret;
+}
+
+static int rockchip_saradc_read_event_value(struct iio_dev *indio_dev,
+					    const struct iio_chan_spec *chan,
+					    enum iio_event_type type,
+					    enum iio_event_direction dir,
+					    enum iio_event_info ev_info,
+					    int *val, int *val2)
+{
+	struct rockchip_saradc *info = iio_priv(indio_dev);
+
+	if (dir == IIO_EV_DIR_RISING)
+		*val = info->thresh_high[chan->channel];
+	else
+		*val = info->thresh_low[chan->channel];
+
+	return IIO_VAL_INT;
+}
+
+static int rockchip_saradc_write_event_value(struct iio_dev *indio_dev,
+					     const struct iio_chan_spec *chan,
+					     enum iio_event_type type,
+					     enum iio_event_direction dir,
+					     enum iio_event_info ev_info,
+					     int val, int val2)
+{
+	struct rockchip_saradc *info = iio_priv(indio_dev);
+
+	if (val < 0 || val > GENMASK(chan->scan_type.realbits - 1, 0))
+		return -EINVAL;
+
+	mutex_lock(&indio_dev->mlock);
+
+	if (dir == IIO_EV_DIR_RISING)
+		info->thresh_high[chan->channel] = val;
+	else
+		info->thresh_low[chan->channel] = val;
+
+	if (info->mon_chn == chan->channel && !info->suspended)
+		rockchip_saradc_monitor_update(info);
+
+	mutex_unlock(&indio_dev->mlock);
+
+	return 0;
+}
+
 static const struct iio_info rockchip_saradc_iio_info = {
 	.read_raw = rockchip_saradc_read_raw,
+	.read_event_config = rockchip_saradc_read_event_config,
+	.write_event_config = rockchip_saradc_write_event_config,
+	.read_event_value = rockchip_saradc_read_event_value,
+	.write_event_value = rockchip_saradc_write_event_value,
+};
+
+static const struct iio_event_spec rockchip_saradc2_events[] = {
+	{
+		.type = IIO_EV_TYPE_THRESH,
+		.dir = IIO_EV_DIR_RISING,
+		.mask_separate = BIT(IIO_EV_INFO_VALUE) |
+				 BIT(IIO_EV_INFO_ENABLE),
+	}, {
+		.type = IIO_EV_TYPE_THRESH,
+		.dir = IIO_EV_DIR_FALLING,
+		.mask_separate = BIT(IIO_EV_INFO_VALUE) |
+				 BIT(IIO_EV_INFO_ENABLE),
+	},
 };
 
-#define SARADC_CHANNEL(_index, _id, _res) {			\
+#define __SARADC_CHANNEL(_index, _id, _res, _events, _num_events) {	\
 	.type = IIO_VOLTAGE,					\
 	.indexed = 1,						\
 	.channel = _index,					\
@@ -264,8 +518,18 @@ static const struct iio_info rockchip_saradc_iio_info = {
 		.storagebits = 16,				\
 		.endianness = IIO_CPU,				\
 	},							\
+	.event_spec = _events,					\
+	.num_event_specs = _num_events,				\
 }
 
+#define SARADC_CHANNEL(_index, _id, _res)			\
+	__SARADC_CHANNEL(_index, _id, _res, NULL, 0)
+
+/* v2 controllers compare every conversion against per-channel thresholds */
+#define SARADC2_CHANNEL(_index, _id, _res)			\
+	__SARADC_CHANNEL(_index, _id, _res, rockchip_saradc2_events,	\
+			 ARRAY_SIZE(rockchip_saradc2_events))
+
 static const struct iio_chan_spec rockchip_saradc_iio_channels[] = {
 	SARADC_CHANNEL(0, "adc0", 10),
 	SARADC_CHANNEL(1, "adc1", 10),
@@ -314,10 +578,10 @@ static const struct rockchip_saradc_data rk3399_saradc_data = {
 };
 
 static const struct iio_chan_spec rockchip_rk3528_saradc_iio_channels[] = {
-	SARADC_CHANNEL(0, "adc0", 10),
-	SARADC_CHANNEL(1, "adc1", 10),
-	SARADC_CHANNEL(2, "adc2", 10),
-	SARADC_CHANNEL(3, "adc3", 10),
+	SARADC2_CHANNEL(0, "adc0", 10),
+	SARADC2_CHANNEL(1, "adc1", 10),
+	SARADC2_CHANNEL(2, "adc2", 10),
+	SARADC2_CHANNEL(3, "adc3", 10),
 };
 
 static const struct rockchip_saradc_data rk3528_saradc_data = {
@@ -326,17 +590,19 @@ static const struct rockchip_saradc_data rk3528_saradc_data = {
 	.clk_rate = 1000000,
 	.start = rockchip_saradc_start_v2,
 	.read = rockchip_saradc_read_v2,
+	.monitor = rockchip_saradc_monitor_v2,
+	.monitor_irq = rockchip_saradc_monitor_irq_v2,
 };
 
 static const struct iio_chan_spec rockchip_rk3562_saradc_iio_channels[] = {
-	SARADC_CHANNEL(0, "adc0", 10),
-	SARADC_CHANNEL(1, "adc1", 10),
-	SARADC_CHANNEL(2, "adc2", 10),
-	SARADC_CHANNEL(3, "adc3", 10),
-	SARADC_CHANNEL(4, "adc4", 10),
-	SARADC_CHANNEL(5, "adc5", 10),
-	SARADC_CHANNEL(6, "adc6", 10),
-	SARADC_CHANNEL(7, "adc7", 10),
+	SARADC2_CHANNEL(0, "adc0", 10),
+	SARADC2_CHANNEL(1, "adc1", 10),
+	SARADC2_CHANNEL(2, "adc2", 10),
+	SARADC2_CHANNEL(3, "adc3", 10),
+	SARADC2_CHANNEL(4, "adc4", 10),
+	SARADC2_CHANNEL(5, "adc5", 10),
+	SARADC2_CHANNEL(6, "adc6", 10),
+	SARADC2_CHANNEL(7, "adc7", 10),
 };
 
 static const struct rockchip_saradc_data rk3562_saradc_data = {
@@ -345,6 +611,8 @@ static const struct rockchip_saradc_data rk3562_saradc_data = {
 	.clk_rate = 1000000,
 	.start = rockchip_saradc_start_v2,
 	.read = rockchip_saradc_read_v2,
+	.monitor = rockchip_saradc_monitor_v2,
+	.monitor_irq = rockchip_saradc_monitor_irq_v2,
 };
 
 static const struct iio_chan_spec rockchip_rk3568_saradc_iio_channels[] = {
@@ -368,14 +636,14 @@ static const struct rockchip_saradc_data rk3568_saradc_data = {
 };
 
 static const struct iio_chan_spec rockchip_rk3588_saradc_iio_channels[] = {
-	SARADC_CHANNEL(0, "adc0", 12),
-	SARADC_CHANNEL(1, "adc1", 12),
-	SARADC_CHANNEL(2, "adc2", 12),
-	SARADC_CHANNEL(3, "adc3", 12),
-	SARADC_CHANNEL(4, "adc4", 12),
-	SARADC_CHANNEL(5, "adc5", 12),
-	SARADC_CHANNEL(6, "adc6", 12),
-	SARADC_CHANNEL(7, "adc7", 12),
+	SARADC2_CHANNEL(0, "adc0", 12),
+	SARADC2_CHANNEL(1, "adc1", 12),
+	SARADC2_CHANNEL(2, "adc2", 12),
+	SARADC2_CHANNEL(3, "adc3", 12),
+	SARADC2_CHANNEL(4, "adc4", 12),
+	SARADC2_CHANNEL(5, "adc5", 12),
+	SARADC2_CHANNEL(6, "adc6", 12),
+	SARADC2_CHANNEL(7, "adc7", 12),
 };
 
 static const struct rockchip_saradc_data rk3588_saradc_data = {
@@ -384,11 +652,13 @@ static const struct rockchip_saradc_data rk3588_saradc_data = {
 	.clk_rate = 1000000,
 	.start = rockchip_saradc_start_v2,
 	.read = rockchip_saradc_read_v2,
+	.monitor = rockchip_saradc_monitor_v2,
+	.monitor_irq = rockchip_saradc_monitor_irq_v2,
 };
 
 static const struct iio_chan_spec rockchip_rv1106_saradc_iio_channels[] = {
-	SARADC_CHANNEL(0, "adc0", 10),
-	SARADC_CHANNEL(1, "adc1", 10),
+	SARADC2_CHANNEL(0, "adc0", 10),
+	SARADC2_CHANNEL(1, "adc1", 10),
 };
 
 static const struct rockchip_saradc_data rv1106_saradc_data = {
@@ -397,6 +667,8 @@ static const struct rockchip_saradc_data rv1106_saradc_data = {
 	.clk_rate = 1000000,
 	.start = rockchip_saradc_start_v2,
 	.read = rockchip_saradc_read_v2,
+	.monitor = rockchip_saradc_monitor_v2,
+	.monitor_irq = rockchip_saradc_monitor_irq_v2,
 };
 
 static const struct of_device_id rockchip_saradc_match[] = {
@@ -493,6 +765,8 @@ static irqreturn_t rockchip_saradc_trigger_handler(int irq, void *p)
 
 	iio_push_to_buffers_with_timestamp(i_dev, &data, iio_get_time_ns(i_dev));
 out:
+	if (info->mon_chn >= 0)
+		rockchip_saradc_monitor_update(info);
 	mutex_unlock(&i_dev->mlock);
 
 	iio_trigger_notify_done(i_dev->trig);
@@ -598,6 +872,7 @@ static int rockchip_saradc_probe(struct platform_device *pdev)
 	const struct of_device_id *match;
 	int ret;
 	int irq;
+	int i;
 
 	if (!np)
 		return -ENODEV;
@@ -645,6 +920,13 @@ static int rockchip_saradc_probe(struct platform_device *pdev)
 
 	init_completion(&info->completion);
 
+	info->indio_dev = indio_dev;
+	spin_lock_init(&info->mon_lock);
+	info->mon_chn = -1;
+	for (i = 0; i < info->data->num_channels; i++)
+		info->thresh_high[i] =
+			GENMASK(info->data->channels[i].scan_type.realbits - 1, 0);
+
 	irq = platform_get_irq(pdev, 0);
 	if (irq < 0)
 		return irq;
@@ -796,6 +1078,14 @@ static int rockchip_saradc_suspend(struct device *dev)
 	/* Avoid reading saradc when suspending */
 	mutex_lock(&indio_dev->mlock);
 
+	if (info->mon_chn >= 0) {
+		int chn = info->mon_chn;
+
+		info->mon_chn = -1;
+		rockchip_saradc_monitor_update(info);
+		info->mon_chn = chn;
+	}
+
 	clk_disable_unprepare(info->clk);
 	clk_disable_unprepare(info->pclk);
 	regulator_disable(info->vref);
@@ -824,7 +1114,13 @@ static int rockchip_saradc_resume(struct device *dev)
 	if (ret)
 		clk_disable_unprepare(info->pclk);
 
+	mutex_lock(&indio_dev->mlock);
 	info->suspended = false;
+	if (!ret && info->mon_chn >= 0) {
+		info->mon_above = false;
+		rockchip_saradc_monitor_update(info);
+	}
+	mutex_unlock(&indio_dev->mlock);
 
 	return ret;
 }
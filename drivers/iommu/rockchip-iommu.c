@@ -76,6 +76,14 @@
 
 #define SPAGE_ORDER 12
 #define SPAGE_SIZE (1 << SPAGE_ORDER)
+/* iova span of one page table */
+#define RK_IOMMU_PT_SPAN (NUM_PT_ENTRIES * SPAGE_SIZE)
+
+/*
+ * Past this many lines, one shootdown of the entire iotlb is cheaper than
+ * zapping lines one by one, as a large unmap always misses the iotlb anyway.
+ */
+#define RK_IOMMU_ZAP_LINES_MAX 64
 
 #define DISABLE_FETCH_DTE_TIME_LIMIT BIT(31)
 
@@ -377,10 +385,14 @@ static void rk_iommu_zap_lines(struct rk_iommu *iommu, dma_addr_t iova_start,
 {
 	int i;
 	dma_addr_t iova_end = iova_start + size;
-	/*
-	 * TODO(djkurtz): Figure out when it is more efficient to shootdown the
-	 * entire iotlb rather than iterate over individual iovas.
-	 */
+
+	if (size > RK_IOMMU_ZAP_LINES_MAX * SPAGE_SIZE) {
+		for (i = 0; i < iommu->num_mmu; i++)
+			rk_iommu_write(iommu->bases[i], RK_MMU_COMMAND,
+				       RK_MMU_CMD_ZAP_CACHE);
+		return;
+	}
+
 	for (i = 0; i < iommu->num_mmu; i++) {
 		dma_addr_t iova;
 
@@ -389,6 +401,33 @@ static void rk_iommu_zap_lines(struct rk_iommu *iommu, dma_addr_t iova_start,
 	}
 }
 
+/*
+ * Zap the first and last iova of a new mapping, together with the iovas on
+ * either side of each page table boundary it crosses: only those could have
+ * a dte or pte sharing an iotlb line with an existing mapping.
+ */
+static void rk_iommu_zap_first_last_lines(struct rk_iommu *iommu,
+					  dma_addr_t iova_start, size_t size)
+{
+	dma_addr_t iova_last = iova_start + size - SPAGE_SIZE;
+	dma_addr_t iova;
+	int i;
+
+	for (i = 0; i < iommu->num_mmu; i++) {
+		rk_iommu_write(iommu->bases[i], RK_MMU_ZAP_ONE_LINE, iova_start);
+		for (iova = ALIGN(iova_start + SPAGE_SIZE, RK_IOMMU_PT_SPAN);
+		     iova <= iova_last; iova += RK_IOMMU_PT_SPAN) {
+			rk_iommu_write(iommu->bases[i], RK_MMU_ZAP_ONE_LINE,
+				       iova - SPAGE_SIZE);
+			rk_iommu_write(iommu->bases[i], RK_MMU_ZAP_ONE_LINE,
+				       iova);
+		}
+		if (iova_last != iova_start)
+			rk_iommu_write(iommu->bases[i], RK_MMU_ZAP_ONE_LINE,
+				       iova_last);
+	}
+}
+
 static bool rk_iommu_is_stall_active(struct rk_iommu *iommu)
 {
 	bool active = true;
@@ -825,8 +864,8 @@ static phys_addr_t rk_iommu_iova_to_phys(struct iommu_domain *domain,
 	return phys;
 }
 
-static void rk_iommu_zap_iova(struct rk_iommu_domain *rk_domain,
-			      dma_addr_t iova, size_t size)
+static void __rk_iommu_zap_iova(struct rk_iommu_domain *rk_domain,
+				dma_addr_t iova, size_t size, bool first_last)
 {
 	struct list_head *pos;
 	unsigned long flags;
@@ -850,7 +889,11 @@ static void rk_iommu_zap_iova(struct rk_iommu_domain *rk_domain,
 		if (ret) {
 			WARN_ON(clk_bulk_enable(iommu->num_clocks,
 						iommu->clocks));
-			rk_iommu_zap_lines(iommu, iova, size);
+			if (first_last)
+				rk_iommu_zap_first_last_lines(iommu, iova,
+							      size);
+			else
+				rk_iommu_zap_lines(iommu, iova, size);
 			clk_bulk_disable(iommu->num_clocks, iommu->clocks);
 			pm_runtime_put(iommu->dev);
 		}
@@ -858,13 +901,16 @@ static void rk_iommu_zap_iova(struct rk_iommu_domain *rk_domain,
 	spin_unlock_irqrestore(&rk_domain->iommus_lock, flags);
 }
 
+static void rk_iommu_zap_iova(struct rk_iommu_domain *rk_domain,
+			      dma_addr_t iova, size_t size)
+{
+	__rk_iommu_zap_iova(rk_domain, iova, size, false);
+}
+
 static void rk_iommu_zap_iova_first_last(struct rk_iommu_domain *rk_domain,
 					 dma_addr_t iova, size_t size)
 {
-	rk_iommu_zap_iova(rk_domain, iova, SPAGE_SIZE);
-	if (size > SPAGE_SIZE)
-		rk_iommu_zap_iova(rk_domain, iova + size - SPAGE_SIZE,
-					SPAGE_SIZE);
+	__rk_iommu_zap_iova(rk_domain, iova, size, true);
 }
 
 static u32 *rk_dte_get_page_table(struct rk_iommu_domain *rk_domain,
@@ -975,14 +1021,7 @@ static int rk_iommu_map_iova(struct rk_iommu_domain *rk_domain, u32 *pte_addr,
 
 	rk_table_flush(rk_domain, pte_dma, pte_total);
 
-	/*
-	 * Zap the first and last iova to evict from iotlb any previously
-	 * mapped cachelines holding stale values for its dte and pte.
-	 * We only zap the first and last iova, since only they could have
-	 * dte or pte shared with an existing mapping.
-	 */
-	rk_iommu_zap_iova_first_last(rk_domain, iova, size);
-
+	/* The iotlb is zapped once for the whole range by iotlb_sync_map */
 	return 0;
 unwind:
 	/* Unmap the range of iovas that we just mapped */
@@ -997,81 +1036,120 @@ static int rk_iommu_map_iova(struct rk_iommu_domain *rk_domain, u32 *pte_addr,
 	return -EADDRINUSE;
 }
 
-static int rk_iommu_map(struct iommu_domain *domain, unsigned long _iova,
-			phys_addr_t paddr, size_t size, int prot, gfp_t gfp)
+static int rk_iommu_map_pages(struct iommu_domain *domain, unsigned long _iova,
+			      phys_addr_t paddr, size_t pgsize, size_t pgcount,
+			      int prot, gfp_t gfp, size_t *mapped)
 {
 	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
 	unsigned long flags;
 	dma_addr_t pte_dma, iova = (dma_addr_t)_iova;
+	size_t size = pgsize * pgcount;
 	u32 *page_table, *pte_addr;
 	u32 dte, pte_index;
-	int ret;
+	int ret = 0;
 
 	spin_lock_irqsave(&rk_domain->dt_lock, flags);
 
 	/*
 	 * pgsize_bitmap specifies iova sizes that fit in one page table
-	 * (1024 4-KiB pages = 4 MiB).
-	 * So, size will always be 4096 <= size <= 4194304.
-	 * Since iommu_map() guarantees that both iova and size will be
-	 * aligned, we will always only be mapping from a single dte here.
+	 * (1024 4-KiB pages = 4 MiB), but a physically contiguous run may
+	 * come in as several of them. Map it one page table at a time,
+	 * flushing each run of ptes with a single table flush.
 	 */
-	page_table = rk_dte_get_page_table(rk_domain, iova);
-	if (IS_ERR(page_table)) {
-		spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
-		return PTR_ERR(page_table);
-	}
+	while (size) {
+		size_t chunk = min_t(size_t, size, RK_IOMMU_PT_SPAN -
+				     (iova & (RK_IOMMU_PT_SPAN - 1)));
 
-	dte = rk_domain->dt[rk_iova_dte_index(iova)];
-	pte_index = rk_iova_pte_index(iova);
-	pte_addr = &page_table[pte_index];
-	pte_dma = rk_ops->pt_address(dte) + pte_index * sizeof(u32);
-	ret = rk_iommu_map_iova(rk_domain, pte_addr, pte_dma, iova,
-				paddr, size, prot);
+		page_table = rk_dte_get_page_table(rk_domain, iova);
+		if (IS_ERR(page_table)) {
+			ret = PTR_ERR(page_table);
+			break;
+		}
+
+		dte = rk_domain->dt[rk_iova_dte_index(iova)];
+		pte_index = rk_iova_pte_index(iova);
+		pte_addr = &page_table[pte_index];
+		pte_dma = rk_ops->pt_address(dte) + pte_index * sizeof(u32);
+		ret = rk_iommu_map_iova(rk_domain, pte_addr, pte_dma, iova,
+					paddr, chunk, prot);
+		if (ret)
+			break;
+
+		*mapped += chunk;
+		iova += chunk;
+		paddr += chunk;
+		size -= chunk;
+	}
 
 	spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
 
 	return ret;
 }
 
-static size_t rk_iommu_unmap(struct iommu_domain *domain, unsigned long _iova,
-			     size_t size, struct iommu_iotlb_gather *gather)
+static void rk_iommu_iotlb_sync_map(struct iommu_domain *domain,
+				    unsigned long iova, size_t size)
+{
+	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
+
+	if (!size)
+		return;
+
+	/*
+	 * Zap the first and last iova to evict from iotlb any previously
+	 * mapped cachelines holding stale values for its dte and pte.
+	 * This is done once per iommu_map()/iommu_map_sg() call rather than
+	 * once per chunk, since only the edges of the range could have dte
+	 * or pte shared with an existing mapping.
+	 */
+	rk_iommu_zap_iova_first_last(rk_domain, iova, size);
+}
+
+static size_t rk_iommu_unmap_pages(struct iommu_domain *domain,
+				   unsigned long _iova, size_t pgsize,
+				   size_t pgcount,
+				   struct iommu_iotlb_gather *gather)
 {
 	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
 	unsigned long flags;
 	dma_addr_t pte_dma, iova = (dma_addr_t)_iova;
+	size_t size = pgsize * pgcount;
 	phys_addr_t pt_phys;
 	u32 dte;
 	u32 *pte_addr;
-	size_t unmap_size;
+	size_t unmap_size = 0;
 	struct rk_iommu *iommu = rk_iommu_get(rk_domain);
 
 	spin_lock_irqsave(&rk_domain->dt_lock, flags);
 
-	/*
-	 * pgsize_bitmap specifies iova sizes that fit in one page table
-	 * (1024 4-KiB pages = 4 MiB).
-	 * So, size will always be 4096 <= size <= 4194304.
-	 * Since iommu_unmap() guarantees that both iova and size will be
-	 * aligned, we will always only be unmapping from a single dte here.
-	 */
-	dte = rk_domain->dt[rk_iova_dte_index(iova)];
-	/* Just return 0 if iova is unmapped */
-	if (!rk_dte_is_pt_valid(dte)) {
-		spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
-		return 0;
-	}
+	/* Unmap one page table at a time, stopping at the first hole */
+	while (unmap_size < size) {
+		size_t chunk = min_t(size_t, size - unmap_size,
+				     RK_IOMMU_PT_SPAN -
+				     (iova & (RK_IOMMU_PT_SPAN - 1)));
+		size_t unmapped;
 
-	pt_phys = rk_ops->pt_address(dte);
-	pte_addr = (u32 *)phys_to_virt(pt_phys) + rk_iova_pte_index(iova);
-	pte_dma = pt_phys + rk_iova_pte_index(iova) * sizeof(u32);
-	unmap_size = rk_iommu_unmap_iova(rk_domain, pte_addr, pte_dma, size,
-					 iommu);
+		dte = rk_domain->dt[rk_iova_dte_index(iova)];
+		/* Stop here if iova is unmapped */
+		if (!rk_dte_is_pt_valid(dte))
+			break;
+
+		pt_phys = rk_ops->pt_address(dte);
+		pte_addr = (u32 *)phys_to_virt(pt_phys) +
+			   rk_iova_pte_index(iova);
+		pte_dma = pt_phys + rk_iova_pte_index(iova) * sizeof(u32);
+		unmapped = rk_iommu_unmap_iova(rk_domain, pte_addr, pte_dma,
+					       chunk, iommu);
+		unmap_size += unmapped;
+		iova += unmapped;
+		if (unmapped < chunk)
+			break;
+	}
 
 	spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
 
 	/* Shootdown iotlb entries for iova range that was just unmapped */
-	rk_iommu_zap_iova(rk_domain, iova, unmap_size);
+	if (unmap_size)
+		rk_iommu_zap_iova(rk_domain, (dma_addr_t)_iova, unmap_size);
 
 	return unmap_size;
 }
@@ -1504,9 +1582,10 @@ static const struct iommu_ops rk_iommu_ops = {
 	.domain_free = rk_iommu_domain_free,
 	.attach_dev = rk_iommu_attach_device,
 	.detach_dev = rk_iommu_detach_device,
-	.map = rk_iommu_map,
-	.unmap = rk_iommu_unmap,
+	.map_pages = rk_iommu_map_pages,
+	.unmap_pages = rk_iommu_unmap_pages,
 	.flush_iotlb_all = rk_iommu_flush_tlb_all,
+	.iotlb_sync_map = rk_iommu_iotlb_sync_map,
 	.probe_device = rk_iommu_probe_device,
 	.release_device = rk_iommu_release_device,
 	.iova_to_phys = rk_iommu_iova_to_phys,
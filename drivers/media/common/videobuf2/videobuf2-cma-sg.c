@@ -38,12 +38,32 @@ struct vb2_cma_sg_buf {
 	unsigned int			num_pages;
 	refcount_t			refcount;
 	struct vb2_vmarea_handler	handler;
+	/* a CPU mapping exists, see vb2_cma_sg_cpu_access() */
+	bool				cpu_access;
+	bool				cleaned;
 
 	struct dma_buf_attachment	*db_attach;
 };
 
 static void vb2_cma_sg_put(void *buf_priv);
 
+/*
+ * An MMAP buffer only passed between devices, e.g. exported from the ISP
+ * to the encoder, is never written by the CPU, so after the clean of its
+ * zeroed pages before the first DMA it needs no cache maintenance at all.
+ * Once it gets a CPU mapping, drop what the linear map may have fetched
+ * meanwhile and sync it on every prepare/finish from then on.
+ */
+static void vb2_cma_sg_cpu_access(struct vb2_cma_sg_buf *buf)
+{
+	if (buf->cpu_access)
+		return;
+
+	buf->cpu_access = true;
+	if (buf->cleaned)
+		dma_sync_sgtable_for_cpu(buf->dev, buf->dma_sgt, buf->dma_dir);
+}
+
 static int vb2_cma_sg_alloc_compacted(struct vb2_cma_sg_buf *buf,
 				      gfp_t gfp_flags)
 {
@@ -240,7 +260,11 @@ static void vb2_cma_sg_prepare(void *buf_priv)
 	struct vb2_cma_sg_buf *buf = buf_priv;
 	struct sg_table *sgt = buf->dma_sgt;
 
+	if (!buf->cpu_access && buf->cleaned)
+		return;
+
 	dma_sync_sgtable_for_device(buf->dev, sgt, buf->dma_dir);
+	buf->cleaned = true;
 }
 
 static void vb2_cma_sg_finish(void *buf_priv)
@@ -248,6 +272,9 @@ static void vb2_cma_sg_finish(void *buf_priv)
 	struct vb2_cma_sg_buf *buf = buf_priv;
 	struct sg_table *sgt = buf->dma_sgt;
 
+	if (!buf->cpu_access)
+		return;
+
 	dma_sync_sgtable_for_cpu(buf->dev, sgt, buf->dma_dir);
 }
 
@@ -272,6 +299,7 @@ static void *vb2_cma_sg_get_userptr(struct device *dev, unsigned long vaddr,
 	buf->offset = vaddr & ~PAGE_MASK;
 	buf->size = size;
 	buf->dma_sgt = &buf->sg_table;
+	buf->cpu_access = true;
 	vec = vb2_create_framevec(vaddr, size);
 	if (IS_ERR(vec))
 		goto userptr_fail_pfnvec;
@@ -339,6 +367,8 @@ static void *vb2_cma_sg_vaddr(void *buf_priv)
 			buf->vaddr = dma_buf_vmap(buf->db_attach->dmabuf);
 		else
 			buf->vaddr = vm_map_ram(buf->pages, buf->num_pages, -1);
+		if (buf->vaddr)
+			vb2_cma_sg_cpu_access(buf);
 	}
 
 	/* add offset in case userptr is not page-aligned */
@@ -367,6 +397,7 @@ static int vb2_cma_sg_mmap(void *buf_priv, struct vm_area_struct *vma)
 		pr_err("Remapping memory, error: %d\n", err);
 		return err;
 	}
+	vb2_cma_sg_cpu_access(buf);
 
 	/*
 	 * Use common vm_area operations to track buffer refcount.
@@ -501,6 +532,7 @@ vb2_cma_sg_dmabuf_ops_begin_cpu_access(struct dma_buf *dbuf,
 	struct vb2_cma_sg_buf *buf = dbuf->priv;
 	struct sg_table *sgt = buf->dma_sgt;
 
+	buf->cpu_access = true;
 	dma_sync_sgtable_for_cpu(buf->dev, sgt, buf->dma_dir);
 	return 0;
 }
@@ -662,6 +694,8 @@ static void *vb2_cma_sg_attach_dmabuf(struct device *dev, struct dma_buf *dbuf,
 	buf->dma_dir = dma_dir;
 	buf->size = size;
 	buf->db_attach = dba;
+	/* the exporter owns the caches of an imported buffer */
+	buf->cpu_access = true;
 
 	return buf;
 }
@@ -29,6 +29,9 @@
 #include "rkcif-externel.h"
 #include "../../../i2c/cam-tb-setup.h"
 
+#define CREATE_TRACE_POINTS
+#include "trace.h"
+
 #define CIF_REQ_BUFS_MIN	1
 #define CIF_MIN_WIDTH		64
 #define CIF_MIN_HEIGHT		64
@@ -7726,6 +7729,7 @@ void rkcif_vb_done_oneframe(struct rkcif_stream *stream,
 				      stream->pixm.plane_fmt[i].sizeimage);
 	}
 
+	trace_rkcif_buf_done(stream, vb_done);
 	vb2_buffer_done(&vb_done->vb2_buf, VB2_BUF_STATE_DONE);
 	v4l2_dbg(2, rkcif_debug, &stream->cifdev->v4l2_dev,
 		 "stream[%d] vb done, index: %d, sequence %d\n", stream->id,
@@ -8990,6 +8994,7 @@ static void rkcif_buf_done_prepare(struct rkcif_stream *stream,
 			vb_done->vb2_buf.timestamp = stream->readout.fs_timestamp;
 		vb_done->sequence = stream->frame_idx - 1;
 		active_buf->fe_timestamp = rkcif_time_get_ns(cif_dev);
+		trace_rkcif_dma_done(stream, active_buf);
 		if (stream->is_line_wake_up) {
 			spin_lock_irqsave(&stream->fps_lock, flags);
 			if (mode)
@@ -9559,6 +9564,8 @@ static void rkcif_update_stream_rockit(struct rkcif_device *cif_dev,
 	if (active_buf) {
 		active_buf->vb.vb2_buf.timestamp = stream->readout.fs_timestamp;
 		active_buf->vb.sequence = stream->frame_idx - 1;
+		active_buf->fe_timestamp = rkcif_time_get_ns(cif_dev);
+		trace_rkcif_dma_done(stream, active_buf);
 		rkcif_rockit_buf_done(stream, active_buf);
 	}
 }
@@ -9608,6 +9615,55 @@ static void rkcif_toisp_set_stream(struct rkcif_device *dev, int on)
 				 RKISP_VICAP_CMD_SET_STREAM, &on);
 }
 
+/*
+ * Transient csi2 errors only need the csi host to resync: reset it alone
+ * and keep the vicap, its buffers and the sensor streaming. Errors that
+ * come back right after a few recoveries get the full reset.
+ */
+static int rkcif_csi2_try_recover(struct rkcif_device *cif_dev)
+{
+	struct rkcif_sensor_info *sensor = cif_dev->active_sensor;
+	struct rkcif_timer *timer = &cif_dev->reset_watchdog_timer;
+	struct rkcif_stream *stream;
+	struct csi2_dev *csi;
+	u64 cur_time, diff_time;
+	int i, ret;
+
+	if (!sensor ||
+	    (sensor->mbus.type != V4L2_MBUS_CSI2_DPHY &&
+	     sensor->mbus.type != V4L2_MBUS_CSI2_CPHY))
+		return -EINVAL;
+
+	cur_time = rkcif_time_get_ns(cif_dev);
+	diff_time = div_u64(cur_time - timer->csi2_recover_timestamp, 1000000);
+	if (diff_time >= 2 * timer->err_time_interval)
+		timer->csi2_recover_cnt = 0;
+	if (timer->csi2_recover_cnt >= RKCIF_CSI2_RECOVER_MAX)
+		return -EAGAIN;
+
+	csi = container_of(sensor->sd, struct csi2_dev, sd);
+	ret = rkcif_csi2_recover(csi);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < RKCIF_MAX_STREAM_MIPI; i++) {
+		stream = &cif_dev->stream[i];
+		if (stream->state != RKCIF_STATE_STREAMING)
+			continue;
+		stream->is_fs_fe_not_paired = false;
+		stream->fs_cnt_in_single_frame = 0;
+	}
+
+	timer->csi2_recover_cnt++;
+	timer->csi2_recover_timestamp = cur_time;
+	timer->csi2_err_triggered_cnt = 0;
+	cif_dev->irq_stats.csi2_recover_cnt++;
+	v4l2_info(&cif_dev->v4l2_dev, "csi host recovered, cnt:%d\n",
+		  timer->csi2_recover_cnt);
+
+	return 0;
+}
+
 static int rkcif_do_reset_work(struct rkcif_device *cif_dev,
 			       enum rkmodule_reset_src reset_src)
 {
@@ -9627,6 +9683,13 @@ static int rkcif_do_reset_work(struct rkcif_device *cif_dev,
 		ret = 0;
 		goto unlock_stream;
 	}
+
+	if (reset_src == RKCIF_RESET_SRC_ERR_CSI2 &&
+	    !rkcif_csi2_try_recover(cif_dev)) {
+		rkcif_monitor_reset_event(cif_dev);
+		goto unlock_stream;
+	}
+
 	v4l2_dbg(1, rkcif_debug, &cif_dev->v4l2_dev, "do rkcif reset\n");
 
 	for (i = 0, j = 0; i < RKCIF_MAX_STREAM_MIPI; i++) {
@@ -9803,6 +9866,8 @@ static int rkcif_do_reset_work(struct rkcif_device *cif_dev,
 				 cif_dev->stream[RKCIF_STREAM_MIPI_ID0].cif_fmt_in);
 
 	timer->csi2_err_triggered_cnt = 0;
+	timer->csi2_recover_cnt = 0;
+	cif_dev->irq_stats.reset_cnt++;
 	rkcif_monitor_reset_event(cif_dev);
 
 	v4l2_dbg(1, rkcif_debug, &cif_dev->v4l2_dev, "do rkcif reset successfully!\n");
@@ -10153,6 +10218,7 @@ int rkcif_reset_notifier(struct notifier_block *nb,
 	}
 	if (!is_match_dev)
 		return -EINVAL;
+	dev->irq_stats.csi2_err_cnt++;
 	timer = &dev->reset_watchdog_timer;
 	if (timer->is_running) {
 		val = action & CSI2_ERR_COUNT_ALL_MASK;
@@ -10635,6 +10701,7 @@ static void rkcif_toisp_check_stop_status(struct sditf_priv *priv,
 			cur_time = rkcif_time_get_ns(stream->cifdev);
 			stream->readout.readout_time = cur_time - stream->readout.fs_timestamp;
 			stream->readout.fs_timestamp = cur_time;
+			trace_rkcif_frame_start(stream);
 			stream->buf_wake_up_cnt++;
 			if (stream->frame_idx % 2)
 				stream->fps_stats.frm0_timestamp = rkcif_time_get_ns(stream->cifdev);
@@ -10766,6 +10833,7 @@ static void rkcif_deal_sof(struct rkcif_device *cif_dev)
 	spin_lock_irqsave(&detect_stream->fps_lock, flags);
 	detect_stream->readout.fs_timestamp = rkcif_time_get_ns(cif_dev);
 	spin_unlock_irqrestore(&detect_stream->fps_lock, flags);
+	trace_rkcif_frame_start(detect_stream);
 
 	if (cif_dev->sync_cfg.type != RKCIF_NOSYNC_MODE) {
 		struct rkcif_multi_sync_config *sync_config;
@@ -11815,6 +11883,7 @@ void rkcif_irq_pingpong_v1(struct rkcif_device *cif_dev)
 					stream->readout.fs_timestamp = rkcif_time_get_ns(cif_dev);
 					stream->frame_idx++;
 					spin_unlock_irqrestore(&stream->fps_lock, flags);
+					trace_rkcif_frame_start(stream);
 				}
 				stream->is_in_vblank = false;
 				spin_lock_irqsave(&stream->vbq_lock, flags);
@@ -12080,6 +12149,7 @@ void rkcif_irq_pingpong(struct rkcif_device *cif_dev)
 					stream->readout.fs_timestamp = rkcif_time_get_ns(cif_dev);
 					stream->frame_idx++;
 					spin_unlock_irqrestore(&stream->fps_lock, flags);
+					trace_rkcif_frame_start(stream);
 				}
 				stream->is_in_vblank = false;
 				if (rkcif_get_interlace_mode(stream) == RKCIF_INTERLACE_SOFT_AUTO)
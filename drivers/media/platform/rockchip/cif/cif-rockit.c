@@ -18,6 +18,7 @@ struct rkcif_rockit_buffer {
 	void *mpi_buf;
 	struct list_head queue;
 	int buf_id;
+	size_t size;
 	union {
 		u32 buff_addr;
 		void *vaddr;
@@ -73,6 +74,36 @@ static struct rkcif_stream *rkcif_rockit_get_stream(struct rockit_rkcif_cfg *inp
 	return stream;
 }
 
+static void rkcif_rockit_buf_release(struct rkcif_stream *stream,
+				     struct rkcif_stream_cfg *stream_cfg, int i)
+{
+	const struct vb2_mem_ops *g_ops = stream->cifdev->hw_dev->mem_ops;
+	struct rkcif_rockit_buffer *rkcif_buf = stream_cfg->rkcif_buff[i];
+
+	if (!rkcif_buf)
+		return;
+
+	if (rkcif_buf->mpi_mem) {
+		g_ops->unmap_dmabuf(rkcif_buf->mpi_mem);
+		g_ops->detach_dmabuf(rkcif_buf->mpi_mem);
+		dma_buf_put(rkcif_buf->dmabuf);
+	}
+	kfree(rkcif_buf);
+	stream_cfg->rkcif_buff[i] = NULL;
+	stream_cfg->buff_id[i] = 0;
+}
+
+static size_t rkcif_rockit_frame_size(struct rkcif_stream *stream)
+{
+	size_t size = 0;
+	int i;
+
+	for (i = 0; i < stream->pixm.num_planes; i++)
+		size += stream->pixm.plane_fmt[i].sizeimage;
+
+	return size;
+}
+
 int rkcif_rockit_buf_queue(struct rockit_rkcif_cfg *input_rockit_cfg)
 {
 	struct rkcif_stream *stream = NULL;
@@ -106,9 +137,22 @@ int rkcif_rockit_buf_queue(struct rockit_rkcif_cfg *input_rockit_cfg)
 	if (!input_rockit_cfg->buf)
 		return -EINVAL;
 
+	/*
+	 * Imported buffers survive pause/config/resume, so an mpi_id seen
+	 * before is normally queued straight away. Re-import only if rockit
+	 * handed over another dmabuf under that id, or the slot is too small
+	 * for the format configured since it was imported.
+	 */
 	for (i = 0; i < ROCKIT_BUF_NUM_MAX; i++) {
 		if (stream_cfg->buff_id[i] == input_rockit_cfg->mpi_id) {
-			input_rockit_cfg->is_alloc = 0;
+			rkcif_buf = stream_cfg->rkcif_buff[i];
+			if (rkcif_buf->dmabuf != input_rockit_cfg->buf ||
+			    rkcif_buf->size < rkcif_rockit_frame_size(stream)) {
+				rkcif_rockit_buf_release(stream, stream_cfg, i);
+				input_rockit_cfg->is_alloc = 1;
+			} else {
+				input_rockit_cfg->is_alloc = 0;
+			}
 			break;
 		}
 	}
@@ -141,6 +185,7 @@ int rkcif_rockit_buf_queue(struct rockit_rkcif_cfg *input_rockit_cfg)
 
 		rkcif_buf->mpi_mem = mem;
 		rkcif_buf->dmabuf = input_rockit_cfg->buf;
+		rkcif_buf->size = input_rockit_cfg->buf->size;
 
 		ret = g_ops->map_dmabuf(mem);
 		if (ret)
@@ -236,9 +281,7 @@ int rkcif_rockit_buf_done(struct rkcif_stream *stream, struct rkcif_buffer *buf)
 
 static int rkcif_rockit_buf_free(struct rkcif_stream *stream)
 {
-	struct rkcif_rockit_buffer *rkcif_buf = NULL;
 	u32 i = 0, dev_id = stream->cifdev->csi_host_idx;
-	const struct vb2_mem_ops *g_ops = stream->cifdev->hw_dev->mem_ops;
 	struct rkcif_stream_cfg *stream_cfg = NULL;
 
 	if (!rockit_rkcif_cfg || stream->id >= RKCIF_MAX_STREAM_MIPI)
@@ -246,25 +289,33 @@ static int rkcif_rockit_buf_free(struct rkcif_stream *stream)
 
 	stream_cfg = &rockit_rkcif_cfg->rkcif_dev_cfg[dev_id].rkcif_stream_cfg[stream->id];
 	stream_cfg->is_discard = false;
-	for (i = 0; i < ROCKIT_BUF_NUM_MAX; i++) {
-		if (stream_cfg->rkcif_buff[i]) {
-			rkcif_buf = (struct rkcif_rockit_buffer *)stream_cfg->rkcif_buff[i];
-			if (rkcif_buf->mpi_mem) {
-				g_ops->unmap_dmabuf(rkcif_buf->mpi_mem);
-				g_ops->detach_dmabuf(rkcif_buf->mpi_mem);
-				dma_buf_put(rkcif_buf->dmabuf);
-			}
-			kfree(stream_cfg->rkcif_buff[i]);
-			stream_cfg->rkcif_buff[i] = NULL;
-			stream_cfg->buff_id[i] = 0;
-		}
-	}
+	for (i = 0; i < ROCKIT_BUF_NUM_MAX; i++)
+		rkcif_rockit_buf_release(stream, stream_cfg, i);
 	stream->curr_buf_rockit = NULL;
 	stream->next_buf_rockit = NULL;
 	INIT_LIST_HEAD(&stream->rockit_buf_head);
 	return 0;
 }
 
+/* Drop the queue but keep the imported buffers for the next resume */
+static void rkcif_rockit_buf_reset(struct rkcif_stream *stream)
+{
+	u32 dev_id = stream->cifdev->csi_host_idx;
+	struct rkcif_stream_cfg *stream_cfg;
+	unsigned long lock_flags = 0;
+
+	if (!rockit_rkcif_cfg || stream->id >= RKCIF_MAX_STREAM_MIPI)
+		return;
+
+	stream_cfg = &rockit_rkcif_cfg->rkcif_dev_cfg[dev_id].rkcif_stream_cfg[stream->id];
+	spin_lock_irqsave(&stream->vbq_lock, lock_flags);
+	stream_cfg->is_discard = false;
+	stream->curr_buf_rockit = NULL;
+	stream->next_buf_rockit = NULL;
+	INIT_LIST_HEAD(&stream->rockit_buf_head);
+	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
+}
+
 int rkcif_rockit_pause_stream(struct rockit_rkcif_cfg *input_rockit_cfg)
 {
 	struct rkcif_stream *stream = NULL;
@@ -277,11 +328,31 @@ int rkcif_rockit_pause_stream(struct rockit_rkcif_cfg *input_rockit_cfg)
 	}
 
 	rkcif_do_stop_stream(stream, RKCIF_STREAM_MODE_ROCKIT);
-	rkcif_rockit_buf_free(stream);
+	rkcif_rockit_buf_reset(stream);
 	return 0;
 }
 EXPORT_SYMBOL(rkcif_rockit_pause_stream);
 
+int rkcif_rockit_free_stream_buf(struct rockit_rkcif_cfg *input_rockit_cfg)
+{
+	struct rkcif_stream *stream = NULL;
+
+	stream = rkcif_rockit_get_stream(input_rockit_cfg);
+
+	if (stream == NULL) {
+		pr_err("the stream is NULL");
+		return -EINVAL;
+	}
+
+	if (stream->state == RKCIF_STATE_STREAMING) {
+		pr_err("stream id %d is streaming, pause it first\n", stream->id);
+		return -EBUSY;
+	}
+
+	return rkcif_rockit_buf_free(stream);
+}
+EXPORT_SYMBOL(rkcif_rockit_free_stream_buf);
+
 int rkcif_rockit_config_stream(struct rockit_rkcif_cfg *input_rockit_cfg,
 				int width, int height, int v4l2_fmt)
 {
@@ -78,6 +78,7 @@
 #define RKCIF_DEFAULT_WIDTH	640
 #define RKCIF_DEFAULT_HEIGHT	480
 #define RKCIF_FS_DETECTED_NUM	2
+#define RKCIF_CSI2_RECOVER_MAX	3
 
 #define RKCIF_MAX_INTERVAL_NS	5000000
 /*
@@ -371,6 +372,9 @@ struct rkcif_irq_stats {
 	u64 not_active_buf_cnt[RKCIF_MAX_STREAM_MIPI];
 	u64 trig_simult_cnt[RKCIF_MAX_STREAM_MIPI];
 	u64 all_err_cnt;
+	u64 csi2_err_cnt;
+	u64 csi2_recover_cnt;
+	u64 reset_cnt;
 };
 
 /*
@@ -420,9 +424,12 @@ struct rkcif_timer {
 	/* unit: ms */
 	unsigned int		err_time_interval;
 	unsigned int		csi2_err_triggered_cnt;
+	/* csi host recoveries in a row, without a quiet period in between */
+	unsigned int		csi2_recover_cnt;
 	unsigned int		notifer_called_cnt;
 	unsigned long		frame_end_cycle_us;
 	u64			csi2_first_err_timestamp;
+	u64			csi2_recover_timestamp;
 	bool			is_triggered;
 	bool			is_buf_stop_update;
 	bool			is_running;
@@ -298,6 +298,47 @@ static void csi2_stop(struct csi2_dev *csi2)
 	}
 }
 
+/*
+ * Light recovery from transient ECC/CRC errors: reset the csi host alone
+ * and let it resync on the next frame start. The sensor keeps streaming,
+ * clocks and the dphy stay configured.
+ */
+int rkcif_csi2_recover(struct csi2_dev *csi2)
+{
+	struct csi2_hw *csi2_hw;
+	enum host_type_t host_type;
+	int i, csi_idx;
+
+	mutex_lock(&csi2->lock);
+	if (!csi2->stream_count) {
+		mutex_unlock(&csi2->lock);
+		return -EINVAL;
+	}
+
+	if (csi2->dsi_input_en == RKMODULE_DSI_INPUT)
+		host_type = RK_DSI_RXHOST;
+	else
+		host_type = RK_CSI_RXHOST;
+
+	for (i = 0; i < csi2->csi_info.csi_num; i++) {
+		csi_idx = csi2->csi_info.csi_idx[i];
+		csi2_hw = csi2->csi2_hw[csi_idx];
+		disable_irq(csi2_hw->irq1);
+		disable_irq(csi2_hw->irq2);
+		csi2_disable(csi2_hw);
+		csi2_hw_do_reset(csi2_hw);
+		csi2_enable(csi2_hw, host_type);
+		enable_irq(csi2_hw->irq1);
+		enable_irq(csi2_hw->irq2);
+	}
+
+	for (i = 0; i < RK_CSI2_ERR_MAX; i++)
+		csi2->err_list[i].cnt = 0;
+	mutex_unlock(&csi2->lock);
+
+	return 0;
+}
+
 /*
  * V4L2 subdev operations.
  */
@@ -355,7 +355,11 @@ static void rkcif_show_format(struct rkcif_device *dev, struct seq_file *f)
 			seq_printf(f, "\t\t\tcsi bandwidth lack:%llu\n",
 				   dev->irq_stats.csi_bwidth_lack_cnt);
 			seq_printf(f, "\t\t\tcsi size err:%llu\n", dev->irq_stats.csi_size_err_cnt);
+			seq_printf(f, "\t\t\tcsi2 host err:%llu\n", dev->irq_stats.csi2_err_cnt);
+			seq_printf(f, "\t\t\tcsi2 host recover:%llu\n",
+				   dev->irq_stats.csi2_recover_cnt);
 		}
+		seq_printf(f, "\t\t\tpipeline reset:%llu\n", dev->irq_stats.reset_cnt);
 		seq_printf(f, "\t\t\tnot active buf cnt:%llu %llu %llu %llu\n",
 			   dev->irq_stats.not_active_buf_cnt[0],
 			   dev->irq_stats.not_active_buf_cnt[1],
@@ -0,0 +1,105 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* Copyright (C) 2026 Rockchip Electronics Co., Ltd. */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM rkcif
+
+#if !defined(__RKCIF_TRACE_H__) || defined(TRACE_HEADER_MULTI_READ)
+#define __RKCIF_TRACE_H__
+
+#include <linux/tracepoint.h>
+#include <media/videobuf2-v4l2.h>
+
+#include "dev.h"
+
+/*
+ * All *_ts fields are rkcif_time_get_ns() stamps, the clock vb2 timestamps
+ * of the stream are taken from, so latencies can be computed from the
+ * fields alone whatever the trace clock is.
+ */
+TRACE_EVENT(rkcif_frame_start,
+	TP_PROTO(struct rkcif_stream *stream),
+
+	TP_ARGS(stream),
+
+	TP_STRUCT__entry(
+		__string(dev, dev_name(stream->cifdev->dev))
+		__field(int, id)
+		__field(u32, frame_idx)
+		__field(u64, fs_ts)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev, dev_name(stream->cifdev->dev));
+		__entry->id = stream->id;
+		__entry->frame_idx = stream->frame_idx;
+		__entry->fs_ts = stream->readout.fs_timestamp;
+	),
+
+	TP_printk("dev=%s id=%d frame_idx=%u fs_ts=%llu",
+		  __get_str(dev), __entry->id, __entry->frame_idx,
+		  __entry->fs_ts)
+);
+
+TRACE_EVENT(rkcif_dma_done,
+	TP_PROTO(struct rkcif_stream *stream, struct rkcif_buffer *buf),
+
+	TP_ARGS(stream, buf),
+
+	TP_STRUCT__entry(
+		__string(dev, dev_name(stream->cifdev->dev))
+		__field(int, id)
+		__field(u32, sequence)
+		__field(u64, fs_ts)
+		__field(u64, fe_ts)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev, dev_name(stream->cifdev->dev));
+		__entry->id = stream->id;
+		__entry->sequence = buf->vb.sequence;
+		__entry->fs_ts = buf->vb.vb2_buf.timestamp;
+		__entry->fe_ts = buf->fe_timestamp;
+	),
+
+	TP_printk("dev=%s id=%d sequence=%u fs_ts=%llu fe_ts=%llu",
+		  __get_str(dev), __entry->id, __entry->sequence,
+		  __entry->fs_ts, __entry->fe_ts)
+);
+
+TRACE_EVENT(rkcif_buf_done,
+	TP_PROTO(struct rkcif_stream *stream, struct vb2_v4l2_buffer *vb),
+
+	TP_ARGS(stream, vb),
+
+	TP_STRUCT__entry(
+		__string(dev, dev_name(stream->cifdev->dev))
+		__field(int, id)
+		__field(u32, index)
+		__field(u32, sequence)
+		__field(u64, fs_ts)
+		__field(u64, done_ts)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev, dev_name(stream->cifdev->dev));
+		__entry->id = stream->id;
+		__entry->index = vb->vb2_buf.index;
+		__entry->sequence = vb->sequence;
+		__entry->fs_ts = vb->vb2_buf.timestamp;
+		__entry->done_ts = rkcif_time_get_ns(stream->cifdev);
+	),
+
+	TP_printk("dev=%s id=%d index=%u sequence=%u fs_ts=%llu done_ts=%llu",
+		  __get_str(dev), __entry->id, __entry->index,
+		  __entry->sequence, __entry->fs_ts, __entry->done_ts)
+);
+
+#endif /* __RKCIF_TRACE_H__ */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH ../../drivers/media/platform/rockchip/cif
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE trace
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
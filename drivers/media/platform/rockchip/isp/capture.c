@@ -13,6 +13,9 @@
 #include "regs.h"
 #include "rkisp_tb_helper.h"
 
+/* a whole frame of slices, the smallest slice is 16 lines */
+#define RKISP_WRAP_SLICE_EVENT_ELEMS		8
+
 #define STREAM_MIN_MP_SP_INPUT_WIDTH		STREAM_MIN_RSZ_OUTPUT_WIDTH
 #define STREAM_MIN_MP_SP_INPUT_HEIGHT		STREAM_MIN_RSZ_OUTPUT_HEIGHT
 
@@ -1172,6 +1175,17 @@ static int rkisp_set_wrap_line(struct rkisp_stream *stream, struct rkisp_wrap_in
 	return stream->ops->set_wrap(stream, arg->height);
 }
 
+static int rkisp_get_wrap_buf(struct rkisp_stream *stream, struct rkisp_wrap_buf *arg)
+{
+	struct rkisp_device *dev = stream->ispdev;
+
+	if (!stream->ops->get_wrap_buf) {
+		v4l2_err(&dev->v4l2_dev, "no support wrap\n");
+		return -EINVAL;
+	}
+	return stream->ops->get_wrap_buf(stream, arg);
+}
+
 static int rkisp_set_fps(struct rkisp_stream *stream, int *fps)
 {
 	struct rkisp_device *dev = stream->ispdev;
@@ -1300,6 +1314,9 @@ static long rkisp_ioctl_default(struct file *file, void *fh,
 	case RKISP_CMD_SET_WRAP_LINE:
 		ret = rkisp_set_wrap_line(stream, arg);
 		break;
+	case RKISP_CMD_GET_WRAP_BUF:
+		ret = rkisp_get_wrap_buf(stream, arg);
+		break;
 	case RKISP_CMD_SET_FPS:
 		ret = rkisp_set_fps(stream, arg);
 		break;
@@ -1575,6 +1592,18 @@ static int rkisp_querycap(struct file *file, void *priv,
 	return 0;
 }
 
+static int rkisp_subscribe_event(struct v4l2_fh *fh,
+				 const struct v4l2_event_subscription *sub)
+{
+	struct rkisp_stream *stream = video_get_drvdata(fh->vdev);
+
+	if (sub->type != RKISP_V4L2_EVENT_WRAP_SLICE ||
+	    !stream->ops || !stream->ops->get_wrap_buf)
+		return -EINVAL;
+
+	return v4l2_event_subscribe(fh, sub, RKISP_WRAP_SLICE_EVENT_ELEMS, NULL);
+}
+
 static const struct v4l2_ioctl_ops rkisp_v4l2_ioctl_ops = {
 	.vidioc_reqbufs = vb2_ioctl_reqbufs,
 	.vidioc_querybuf = vb2_ioctl_querybuf,
@@ -1595,6 +1624,8 @@ static const struct v4l2_ioctl_ops rkisp_v4l2_ioctl_ops = {
 	.vidioc_querycap = rkisp_querycap,
 	.vidioc_enum_frameintervals = rkisp_enum_frameintervals,
 	.vidioc_enum_framesizes = rkisp_enum_framesizes,
+	.vidioc_subscribe_event = rkisp_subscribe_event,
+	.vidioc_unsubscribe_event = v4l2_event_unsubscribe,
 	.vidioc_default = rkisp_ioctl_default,
 };
 
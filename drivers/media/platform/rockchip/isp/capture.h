@@ -230,6 +230,7 @@ struct streams_ops {
 	int (*frame_end)(struct rkisp_stream *stream, u32 state);
 	int (*frame_start)(struct rkisp_stream *stream, u32 mis);
 	int (*set_wrap)(struct rkisp_stream *stream, int line);
+	int (*get_wrap_buf)(struct rkisp_stream *stream, struct rkisp_wrap_buf *arg);
 };
 
 struct rockit_isp_ops {
@@ -286,6 +287,7 @@ struct rkisp_stream {
 	bool is_mf_upd;
 	bool is_flip;
 	bool is_pause;
+	bool is_resume;
 	bool is_crop_upd;
 	bool is_using_resmem;
 	bool frame_early;
@@ -311,6 +313,20 @@ struct rkisp_vir_cpy {
 	struct rkisp_stream *stream;
 };
 
+/* isp to encoder line ring, see isp_dvbm.c */
+struct rkisp_dvbm_stats {
+	struct work_struct work;
+	u32 wrap_line;		/* ring depth configured at stream on */
+	u32 frame_cnt;
+	u32 overflow;		/* frames the encoder was still behind */
+	u32 underflow;		/* frames without a matching start/end */
+	u32 fallback;		/* switches to frame mode */
+	u32 lag;		/* consecutive overflowed frames */
+	bool in_frame;
+	bool linked;
+	bool is_fallback;
+};
+
 struct rkisp_capture_device {
 	struct rkisp_device *ispdev;
 	struct rkisp_stream stream[RKISP_MAX_STREAM];
@@ -321,9 +337,13 @@ struct rkisp_capture_device {
 	u32 wait_line;
 	u32 wrap_width;
 	u32 wrap_line;
+	u32 wrap_slice_line;	/* lines per slice event to userspace */
+	u32 wrap_mblk_cnt;	/* 16 lines written in the current frame */
+	bool is_wrap_user;	/* wrap ring exported instead of linked to dvbm */
 	bool is_done_early;
 	bool is_mirror;
 
+	struct rkisp_dvbm_stats dvbm;
 	struct work_struct fast_work;
 };
 
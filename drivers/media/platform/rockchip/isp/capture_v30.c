@@ -800,11 +800,28 @@ static void update_mi(struct rkisp_stream *stream)
 			}
 		}
 
+		/* mi closed for lack of buf, capture again from next frame */
+		if (stream->is_pause) {
+			stream->ops->enable_mi(stream);
+			stream->is_pause = false;
+			stream->is_resume = true;
+		}
+
 		/* single buf updated at readback for multidevice */
 		if (!dev->hw_dev->is_single) {
 			stream->curr_buf = stream->next_buf;
 			stream->next_buf = NULL;
 		}
+	} else if (rkisp_mi_pause && dev->hw_dev->is_single &&
+		   !IS_HDR_RDBK(dev->rd_mode)) {
+		/* close mi rather than write the frame to dummy buf,
+		 * frames lost are counted at frame start while closed.
+		 */
+		if (!stream->is_pause) {
+			stream->dbg.frameloss++;
+			stream->is_pause = true;
+			stream->ops->disable_mi(stream);
+		}
 	} else if (dummy_buf->mem_priv) {
 		stream->dbg.frameloss++;
 		val = dummy_buf->dma_addr;
@@ -934,6 +951,30 @@ static int mi_frame_start(struct rkisp_stream *stream, u32 mis)
 			stream->next_buf = NULL;
 			stream_self_update(stream);
 		}
+	} else if (stream->streaming && mis && stream->is_pause) {
+		/* mi closed, reopen to capture next frame if buf queued */
+		stream->dbg.frameloss++;
+		if (!list_empty(&stream->buf_queue)) {
+			stream->next_buf = list_first_entry(&stream->buf_queue,
+							    struct rkisp_buffer, queue);
+			list_del(&stream->next_buf->queue);
+			stream->ops->update_mi(stream);
+		}
+	} else if (stream->streaming && mis && stream->is_resume) {
+		/* no mi frame end for the frame which mi closed,
+		 * rotate buf here as frame end to setup next-next frame.
+		 */
+		stream->is_resume = false;
+		if (!stream->curr_buf) {
+			stream->curr_buf = stream->next_buf;
+			stream->next_buf = NULL;
+			if (!list_empty(&stream->buf_queue)) {
+				stream->next_buf = list_first_entry(&stream->buf_queue,
+								    struct rkisp_buffer, queue);
+				list_del(&stream->next_buf->queue);
+			}
+			stream->ops->update_mi(stream);
+		}
 	}
 	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
 
@@ -1108,6 +1149,8 @@ static int rkisp_start(struct rkisp_stream *stream)
 	stream->ops->enable_mi(stream);
 	stream->streaming = true;
 	stream->skip_frame = 0;
+	stream->is_pause = false;
+	stream->is_resume = false;
 	return 0;
 }
 
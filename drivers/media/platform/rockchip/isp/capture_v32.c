@@ -751,6 +751,14 @@ static int mp_config_mi(struct rkisp_stream *stream)
 	rkisp_unite_set_bits(dev, ISP3X_MI_WR_CTRL, mask, val, false);
 
 	mi_frame_end_int_enable(stream);
+	/* mb line interrupts every 16 lines pace the userspace wrap slices */
+	val = rkisp_read(dev, ISP3X_MI_IMSC, true);
+	if (dev->cap_dev.is_wrap_user)
+		val |= ISP3X_MI_MBLK_LINE;
+	else
+		val &= ~ISP3X_MI_MBLK_LINE;
+	rkisp_write(dev, ISP3X_MI_IMSC, val, true);
+	dev->cap_dev.wrap_mblk_cnt = 0;
 	/* set up first buffer */
 	mi_frame_end(stream, FRAME_INIT);
 
@@ -1153,7 +1161,7 @@ static void update_mi(struct rkisp_stream *stream)
 			stream->curr_buf = stream->next_buf;
 			stream->next_buf = NULL;
 		}
-	} else if (dummy_buf->mem_priv) {
+	} else if (dummy_buf->mem_priv && dev->cap_dev.wrap_line) {
 		val = dummy_buf->dma_addr;
 		reg = stream->config->mi.y_base_ad_init;
 		rkisp_unite_write(dev, reg, val, false);
@@ -1346,6 +1354,77 @@ static int mp_set_wrap(struct rkisp_stream *stream, int line)
 	return ret;
 }
 
+static int mp_get_wrap_buf(struct rkisp_stream *stream, struct rkisp_wrap_buf *arg)
+{
+	struct rkisp_device *dev = stream->ispdev;
+	struct rkisp_capture_device *cap_dev = &dev->cap_dev;
+	struct rkisp_dummy_buffer *buf = &stream->dummy_buf;
+	u32 bytesperline = stream->out_fmt.plane_fmt[0].bytesperline;
+	int ret;
+
+	if (dev->isp_ver != ISP_V32 || !cap_dev->wrap_line)
+		return -EINVAL;
+	/* exported once per stream, or already linked to the encoder */
+	if (stream->streaming || cap_dev->is_wrap_user || buf->dma_addr)
+		return -EBUSY;
+	if (cap_dev->wrap_line > stream->out_fmt.height)
+		cap_dev->wrap_line = stream->out_fmt.height;
+	if (arg->slice_line < 16 || arg->slice_line % 16 ||
+	    arg->slice_line > cap_dev->wrap_line)
+		return -EINVAL;
+
+	cap_dev->is_wrap_user = true;
+	cap_dev->wrap_slice_line = arg->slice_line;
+	ret = rkisp_create_dummy_buf(stream);
+	if (!ret)
+		ret = rkisp_buf_get_fd(dev, buf, true);
+	if (ret) {
+		rkisp_free_buffer(dev, buf);
+		buf->dma_addr = 0;
+		cap_dev->is_wrap_user = false;
+		return ret;
+	}
+
+	arg->fd = buf->dma_fd;
+	arg->size = buf->size;
+	arg->uv_offset = bytesperline * cap_dev->wrap_line;
+	arg->bytesperline = bytesperline;
+	arg->wrap_line = cap_dev->wrap_line;
+	return 0;
+}
+
+/*
+ * Userspace wrap: tell each slice_line lines written, and the last lines
+ * at frame end. The ISP doesn't wait, a slice is overwritten wrap_line
+ * lines later.
+ */
+static void mp_wrap_slice_event(struct rkisp_device *dev, bool frame_end)
+{
+	struct rkisp_capture_device *cap_dev = &dev->cap_dev;
+	struct rkisp_stream *stream = &cap_dev->stream[RKISP_STREAM_MP];
+	struct v4l2_event ev = {
+		.type = RKISP_V4L2_EVENT_WRAP_SLICE,
+	};
+	struct rkisp_wrap_slice *slice = (struct rkisp_wrap_slice *)ev.u.data;
+	u32 line, height = stream->out_fmt.height;
+
+	if (!cap_dev->is_wrap_user || !stream->streaming)
+		return;
+
+	if (frame_end) {
+		line = height;
+		cap_dev->wrap_mblk_cnt = 0;
+	} else {
+		line = ++cap_dev->wrap_mblk_cnt * 16;
+		if (line % cap_dev->wrap_slice_line || line >= height)
+			return;
+	}
+
+	rkisp_dmarx_get_frame(dev, &slice->sequence, NULL, NULL, true);
+	slice->line = line;
+	v4l2_event_queue(&stream->vnode.vdev, &ev);
+}
+
 static struct streams_ops rkisp_mp_streams_ops = {
 	.config_mi = mp_config_mi,
 	.enable_mi = mp_enable_mi,
@@ -1356,6 +1435,7 @@ static struct streams_ops rkisp_mp_streams_ops = {
 	.frame_end = mi_frame_end,
 	.frame_start = mi_frame_start,
 	.set_wrap = mp_set_wrap,
+	.get_wrap_buf = mp_get_wrap_buf,
 };
 
 static struct streams_ops rkisp_sp_streams_ops = {
@@ -1760,7 +1840,8 @@ static int rkisp_create_dummy_buf(struct rkisp_stream *stream)
 		buf->is_need_dbuf = true;
 		ret = rkisp_alloc_buffer(stream->ispdev, buf);
 	}
-	if (ret == 0) {
+	/* a ring exported to userspace is not linked to the encoder */
+	if (ret == 0 && !dev->cap_dev.is_wrap_user) {
 		ret = rkisp_dvbm_init(stream);
 		if (ret < 0)
 			rkisp_free_buffer(dev, buf);
@@ -1773,11 +1854,15 @@ static void rkisp_destroy_dummy_buf(struct rkisp_stream *stream)
 {
 	struct rkisp_device *dev = stream->ispdev;
 
-	if (!dev->cap_dev.wrap_line || stream->id != RKISP_STREAM_MP)
+	/* wrap_line is cleared when the encoder made us fall back */
+	if ((!dev->cap_dev.wrap_line && !stream->dummy_buf.dma_addr) ||
+	    stream->id != RKISP_STREAM_MP)
 		return;
-	rkisp_dvbm_deinit();
+	rkisp_dvbm_deinit(dev);
 	rkisp_free_buffer(dev, &stream->dummy_buf);
 	stream->dummy_buf.dma_addr = 0;
+	/* userspace keeps its fd, the next stream exports a new ring */
+	dev->cap_dev.is_wrap_user = false;
 }
 
 static void destroy_buf_queue(struct rkisp_stream *stream,
@@ -2350,6 +2435,11 @@ void rkisp_mi_v32_isr(u32 mis_val, struct rkisp_device *dev)
 		goto end;
 	}
 
+	if (mis_val & ISP3X_MI_MBLK_LINE) {
+		rkisp_write(dev, ISP3X_MI_ICR, ISP3X_MI_MBLK_LINE, true);
+		mp_wrap_slice_event(dev, false);
+	}
+
 	for (i = 0; i < RKISP_MAX_STREAM; ++i) {
 		stream = &dev->cap_dev.stream[i];
 
@@ -2382,6 +2472,7 @@ void rkisp_mi_v32_isr(u32 mis_val, struct rkisp_device *dev)
 				wake_up(&stream->done);
 			}
 		} else if (stream->id == RKISP_STREAM_MP && dev->cap_dev.wrap_line) {
+			mp_wrap_slice_event(dev, true);
 			ns = rkisp_time_get_ns(dev);
 			rkisp_dmarx_get_frame(dev, &seq, NULL, NULL, true);
 			stream->dbg.interval = ns - stream->dbg.timestamp;
@@ -53,12 +53,12 @@ static inline int rkisp_rockit_buf_done(struct rkisp_stream *stream, int cmd) {
 #if IS_ENABLED(CONFIG_ROCKCHIP_DVBM)
 int rkisp_dvbm_get(struct rkisp_device *dev);
 int rkisp_dvbm_init(struct rkisp_stream *stream);
-void rkisp_dvbm_deinit(void);
+void rkisp_dvbm_deinit(struct rkisp_device *dev);
 int rkisp_dvbm_event(struct rkisp_device *dev, u32 event);
 #else
 static inline int rkisp_dvbm_get(struct rkisp_device *dev) { return -EINVAL; }
 static inline int rkisp_dvbm_init(struct rkisp_stream *stream) { return -EINVAL; }
-static inline void rkisp_dvbm_deinit(void) {}
+static inline void rkisp_dvbm_deinit(struct rkisp_device *dev) {}
 static inline int rkisp_dvbm_event(struct rkisp_device *dev, u32 event) { return -EINVAL; }
 #endif
 
@@ -138,7 +138,10 @@ extern int rkisp_debug;
 extern bool rkisp_monitor;
 extern bool rkisp_irq_dbg;
 extern bool rkisp_buf_dbg;
+extern bool rkisp_mi_pause;
 extern u64 rkisp_debug_reg;
+extern unsigned int rkisp_dvbm_fallback;
+extern unsigned int rkisp_stats_early;
 extern struct platform_driver rkisp_plat_drv;
 
 static inline
@@ -72,6 +72,10 @@ bool rkisp_buf_dbg;
 module_param_named(buf_dbg, rkisp_buf_dbg, bool, 0644);
 MODULE_PARM_DESC(buf_dbg, "rkisp check output buf");
 
+bool rkisp_mi_pause;
+module_param_named(mi_pause, rkisp_mi_pause, bool, 0644);
+MODULE_PARM_DESC(mi_pause, "rkisp close mi instead of writing to dummy buf if no buf queued, isp30");
+
 static bool rkisp_rdbk_auto;
 module_param_named(rdbk_auto, rkisp_rdbk_auto, bool, 0644);
 MODULE_PARM_DESC(irq_dbg, "rkisp and vicap auto readback mode");
@@ -92,10 +96,18 @@ static unsigned int rkisp_wait_line;
 module_param_named(wait_line, rkisp_wait_line, uint, 0644);
 MODULE_PARM_DESC(wait_line, "rkisp wait line to buf done early");
 
+unsigned int rkisp_stats_early;
+module_param_named(stats_early, rkisp_stats_early, uint, 0644);
+MODULE_PARM_DESC(stats_early, "rkisp 3A ris bits sent as soon as done for isp32, e.g. 0x1 for big ae");
+
 static unsigned int rkisp_wrap_line;
 module_param_named(wrap_line, rkisp_wrap_line, uint, 0644);
 MODULE_PARM_DESC(wrap_line, "rkisp wrap line for mpp");
 
+unsigned int rkisp_dvbm_fallback = 3;
+module_param_named(dvbm_fallback, rkisp_dvbm_fallback, uint, 0644);
+MODULE_PARM_DESC(dvbm_fallback, "rkisp frames in a row the encoder may fall behind before wrap goes to frame mode, 0 to never");
+
 static DEFINE_MUTEX(rkisp_dev_mutex);
 static LIST_HEAD(rkisp_device_list);
 
@@ -62,6 +62,8 @@
 
 #define RKISP_MAX_SENSOR		4
 #define RKISP_MAX_PIPELINE		8
+/* queued frames of another sensor that end a readback batch */
+#define RKISP_RDBK_BATCH_MAX		2
 
 #define RKISP_MEDIA_BUS_FMT_MASK	0xF000
 #define RKISP_MEDIA_BUS_FMT_BAYER	0x3000
@@ -271,6 +273,11 @@ struct rkisp_device {
 	int rdbk_cnt_x1;
 	int rdbk_cnt_x2;
 	int rdbk_cnt_x3;
+	/* isp occupancy by this sensor in multi sensor readback */
+	u64 rdbk_busy_ns;
+	u64 rdbk_start_ns;
+	u64 rdbk_stat_ns;
+	u32 rdbk_reload_cnt;
 	u32 rd_mode;
 	int sw_rd_cnt;
 
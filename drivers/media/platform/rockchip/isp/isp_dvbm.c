@@ -8,14 +8,51 @@
 #include "dev.h"
 #include "regs.h"
 
+/* shallowest ring the encoder can follow, one CTU row */
+#define RKISP_DVBM_MIN_LINE	64
+
 static struct dvbm_port *g_dvbm;
 
+/*
+ * The encoder fell behind for rkisp_dvbm_fallback frames in a row: stop
+ * feeding it online and let the mainpath write whole frames to the vb2
+ * buffers, so that a slow encoder drops frames instead of reading lines
+ * the ISP has already overwritten.
+ */
+static void rkisp_dvbm_fallback_work(struct work_struct *work)
+{
+	struct rkisp_dvbm_stats *stats =
+		container_of(work, struct rkisp_dvbm_stats, work);
+	struct rkisp_capture_device *cap_dev =
+		container_of(stats, struct rkisp_capture_device, dvbm);
+	struct rkisp_device *dev = cap_dev->ispdev;
+	struct rkisp_stream *stream = &cap_dev->stream[RKISP_STREAM_MP];
+
+	mutex_lock(&dev->hw_dev->dev_lock);
+	if (!stream->streaming || !cap_dev->wrap_line || !stats->linked)
+		goto unlock;
+
+	v4l2_warn(&dev->v4l2_dev,
+		  "dvbm: encoder %u frames behind, wrap %u lines to frame mode\n",
+		  stats->lag, cap_dev->wrap_line);
+
+	rk_dvbm_unlink(g_dvbm);
+	stats->linked = false;
+	stats->is_fallback = true;
+	stats->fallback++;
+	cap_dev->wrap_line = 0;
+	stream->ops->config_mi(stream);
+unlock:
+	mutex_unlock(&dev->hw_dev->dev_lock);
+}
+
 int rkisp_dvbm_get(struct rkisp_device *dev)
 {
 	struct device_node *np = dev->dev->of_node;
 	struct device_node *np_dvbm = of_parse_phandle(np, "dvbm", 0);
 	int ret = -EINVAL;
 
+	INIT_WORK(&dev->cap_dev.dvbm.work, rkisp_dvbm_fallback_work);
 	g_dvbm = NULL;
 	if (dev->isp_ver != ISP_V32)
 		goto end;
@@ -37,6 +74,7 @@ int rkisp_dvbm_init(struct rkisp_stream *stream)
 {
 	struct rkisp_device *dev = stream->ispdev;
 	struct rkisp_dummy_buffer *buf = &stream->dummy_buf;
+	struct rkisp_dvbm_stats *stats = &dev->cap_dev.dvbm;
 	struct dvbm_isp_cfg_t dvbm_cfg;
 	u32 width, height, wrap_line;
 
@@ -46,6 +84,15 @@ int rkisp_dvbm_init(struct rkisp_stream *stream)
 	width = stream->out_fmt.plane_fmt[0].bytesperline;
 	height = stream->out_fmt.height;
 	wrap_line = dev->cap_dev.wrap_line;
+	/* the ring is already allocated, it can only get shallower */
+	if (wrap_line > height) {
+		wrap_line = height;
+		dev->cap_dev.wrap_line = wrap_line;
+	}
+	if (wrap_line < RKISP_DVBM_MIN_LINE && wrap_line < height)
+		v4l2_warn(&dev->v4l2_dev,
+			  "dvbm: wrap %u lines is shallower than the encoder needs\n",
+			  wrap_line);
 	dvbm_cfg.dma_addr = buf->dma_addr;
 	dvbm_cfg.ybuf_bot = 0;
 	dvbm_cfg.ybuf_top = width * wrap_line;
@@ -59,22 +106,39 @@ int rkisp_dvbm_init(struct rkisp_stream *stream)
 
 	rk_dvbm_ctrl(g_dvbm, DVBM_ISP_SET_CFG, &dvbm_cfg);
 	rk_dvbm_link(g_dvbm);
+
+	stats->wrap_line = wrap_line;
+	stats->frame_cnt = 0;
+	stats->overflow = 0;
+	stats->underflow = 0;
+	stats->lag = 0;
+	stats->in_frame = false;
+	stats->linked = true;
 	return 0;
 }
 
-void rkisp_dvbm_deinit(void)
+void rkisp_dvbm_deinit(struct rkisp_device *dev)
 {
-	if (g_dvbm)
+	struct rkisp_dvbm_stats *stats = &dev->cap_dev.dvbm;
+
+	if (g_dvbm && stats->linked)
 		rk_dvbm_unlink(g_dvbm);
+	stats->linked = false;
+	/* next stream starts in wrap mode again */
+	if (stats->is_fallback)
+		dev->cap_dev.wrap_line = stats->wrap_line;
+	stats->is_fallback = false;
 }
 
 int rkisp_dvbm_event(struct rkisp_device *dev, u32 event)
 {
+	struct rkisp_dvbm_stats *stats = &dev->cap_dev.dvbm;
 	enum dvbm_cmd cmd;
 	u32 seq;
+	int ret;
 
 	if (!g_dvbm || dev->isp_ver != ISP_V32 ||
-	    !dev->cap_dev.wrap_line)
+	    !dev->cap_dev.wrap_line || !stats->linked)
 		return -EINVAL;
 
 	rkisp_dmarx_get_frame(dev, &seq, NULL, NULL, true);
@@ -82,13 +146,37 @@ int rkisp_dvbm_event(struct rkisp_device *dev, u32 event)
 	switch (event) {
 	case CIF_ISP_V_START:
 		cmd = DVBM_ISP_FRM_START;
+		/* previous frame end lost, the encoder waits for lines never written */
+		if (stats->in_frame)
+			stats->underflow++;
+		stats->in_frame = true;
 		break;
 	case CIF_MI_MP_FRAME:
 		cmd = DVBM_ISP_FRM_END;
+		if (!stats->in_frame)
+			stats->underflow++;
+		stats->in_frame = false;
+		stats->frame_cnt++;
 		break;
 	default:
 		return -EINVAL;
 	}
 
-	return rk_dvbm_ctrl(g_dvbm, cmd, &seq);
+	/*
+	 * The core refuses a frame event while the encoder still holds
+	 * the ring: the ISP is about to wrap over lines not read yet.
+	 */
+	ret = rk_dvbm_ctrl(g_dvbm, cmd, &seq);
+	if (cmd == DVBM_ISP_FRM_START) {
+		if (ret) {
+			stats->overflow++;
+			stats->lag++;
+		} else {
+			stats->lag = 0;
+		}
+		if (rkisp_dvbm_fallback && stats->lag >= rkisp_dvbm_fallback)
+			schedule_work(&stats->work);
+	}
+
+	return ret;
 }
@@ -15,6 +15,7 @@
 #include "isp_params_v3x.h"
 #include "isp_params_v32.h"
 #include "regs.h"
+#include "rkisp_tb_helper.h"
 
 #define PARAMS_NAME DRIVER_NAME "-input-params"
 #define RKISP_ISP_PARAMS_REQ_BUFS_MIN	2
@@ -151,6 +152,19 @@ static void rkisp_params_vb2_buf_queue(struct vb2_buffer *vb)
 	unsigned int cur_frame_id = -1;
 
 	cur_frame_id = atomic_read(&dev->isp_sdev.frm_sync_seq) - 1;
+	/*
+	 * Thunderboot handoff: the isp already runs on the params the MCU
+	 * left in the reserved memory, see rkisp_save_tb_info(). Apply the
+	 * first buffer from userspace as a per-frame update on top of them,
+	 * saved as first params it would only take effect after a restart.
+	 */
+	if (params_vdev->first_params && dev->is_pre_on &&
+	    !dev->is_first_double && dev->tb_head.complete == RKISP_TB_OK &&
+	    !(dev->isp_state & ISP_STOP)) {
+		params_vdev->first_params = false;
+		wake_up(&dev->sync_onoff);
+		dev_info(dev->dev, "first params over thunderboot params\n");
+	}
 	if (params_vdev->first_params) {
 		first_param = vb2_plane_vaddr(vb, 0);
 		params_vdev->ops->save_first_param(params_vdev, first_param);
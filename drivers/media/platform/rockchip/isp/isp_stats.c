@@ -340,6 +340,16 @@ void rkisp_stats_next_ddr_config(struct rkisp_isp_stats_vdev *stats_vdev)
 		rkisp_stats_next_ddr_config_v32(stats_vdev);
 }
 
+/* 3A done interrupts to enable for results sent before frame end */
+u32 rkisp_stats_early_mask(struct rkisp_isp_stats_vdev *stats_vdev)
+{
+	stats_vdev->isp3a_early = 0;
+	if (stats_vdev->dev->isp_ver == ISP_V32 ||
+	    stats_vdev->dev->isp_ver == ISP_V32_L)
+		return rkisp_stats_early_mask_v32(stats_vdev);
+	return 0;
+}
+
 void rkisp_stats_isr(struct rkisp_isp_stats_vdev *stats_vdev,
 		      u32 isp_ris, u32 isp3a_ris)
 {
@@ -77,12 +77,16 @@ struct rkisp_isp_stats_vdev {
 
 	bool af_meas_done_next;
 	bool ae_meas_done_next;
+
+	/* 3A done bits cleared early but not sent, for the frame end */
+	u32 isp3a_early;
 };
 
 void rkisp_stats_rdbk_enable(struct rkisp_isp_stats_vdev *stats_vdev, bool en);
 
 void rkisp_stats_first_ddr_config(struct rkisp_isp_stats_vdev *stats_vdev);
 void rkisp_stats_next_ddr_config(struct rkisp_isp_stats_vdev *stats_vdev);
+u32 rkisp_stats_early_mask(struct rkisp_isp_stats_vdev *stats_vdev);
 
 void rkisp_stats_isr(struct rkisp_isp_stats_vdev *stats_vdev,
 		     u32 isp_ris, u32 isp3a_ris);
@@ -16,6 +16,16 @@
 
 #define ISP32_3A_MEAS_DONE		BIT(31)
 
+/*
+ * Results that can be sent before frame end: read from registers, not
+ * part of the 3A DDR write. Only the subwindow sums for isp32.
+ */
+#define ISP32_STATS_EARLY_MASK \
+	(ISP3X_3A_RAWAE_BIG | ISP3X_3A_RAWAE_CH1 | ISP3X_3A_RAWAE_CH2)
+#define ISP32L_STATS_EARLY_MASK \
+	(ISP3X_3A_RAWAE_BIG | ISP3X_3A_RAWHIST_BIG | \
+	 ISP3X_3A_RAWAE_CH0 | ISP3X_3A_RAWHIST_CH0)
+
 static void isp3_module_done(struct rkisp_isp_stats_vdev *stats_vdev,
 			     u32 reg, u32 value)
 {
@@ -989,6 +999,74 @@ rkisp_stats_send_meas_lite(struct rkisp_isp_stats_vdev *stats_vdev,
 		 cur_buf, !cur_stat_buf ? 0 : cur_stat_buf->meas_type);
 }
 
+/*
+ * A 3A module finished before frame end, e.g. AE with its window in the
+ * upper part of the picture: send it in a buffer of its own flagged
+ * ISP32_STAT_PARTIAL, the frame end buffer will not carry it again.
+ */
+static void
+rkisp_stats_send_early(struct rkisp_isp_stats_vdev *stats_vdev,
+		       u32 isp3a_ris, u32 frame_id)
+{
+	struct rkisp_device *dev = stats_vdev->dev;
+	struct rkisp_stats_ops_v32 *ops =
+		(struct rkisp_stats_ops_v32 *)stats_vdev->priv_ops;
+	u32 size = stats_vdev->vdev_fmt.fmt.meta.buffersize;
+	struct rkisp_buffer *buf = NULL;
+	u32 meas_type;
+
+	spin_lock(&stats_vdev->rd_lock);
+	if (!list_empty(&stats_vdev->stat)) {
+		buf = list_first_entry(&stats_vdev->stat, struct rkisp_buffer, queue);
+		list_del(&buf->queue);
+	}
+	spin_unlock(&stats_vdev->rd_lock);
+
+	if (!buf) {
+		stats_vdev->isp3a_early |= isp3a_ris;
+		return;
+	}
+
+	if (dev->isp_ver == ISP_V32) {
+		struct rkisp32_isp_stat_buffer *stat = buf->vaddr[0];
+
+		stat->meas_type = ISP32_STAT_PARTIAL;
+		if (isp3a_ris & ISP3X_3A_RAWAE_BIG)
+			ops->get_rawae3_meas(stats_vdev, stat);
+		if (isp3a_ris & ISP3X_3A_RAWAE_CH1)
+			ops->get_rawae1_meas(stats_vdev, stat);
+		if (isp3a_ris & ISP3X_3A_RAWAE_CH2)
+			ops->get_rawae2_meas(stats_vdev, stat);
+		stat->frame_id = frame_id;
+		stat->params_id = dev->params_vdev.cur_frame_id;
+		meas_type = stat->meas_type;
+	} else {
+		struct rkisp32_lite_stat_buffer *stat = buf->vaddr[0];
+
+		stat->meas_type = ISP32_STAT_PARTIAL;
+		if (isp3a_ris & ISP3X_3A_RAWAE_BIG)
+			rkisp_stats_get_rawae3_meas_lite(stats_vdev, stat);
+		if (isp3a_ris & ISP3X_3A_RAWHIST_BIG)
+			rkisp_stats_get_rawhst3_meas_lite(stats_vdev, stat);
+		if (isp3a_ris & ISP3X_3A_RAWAE_CH0)
+			rkisp_stats_get_rawaelite_meas_lite(stats_vdev, stat);
+		if (isp3a_ris & ISP3X_3A_RAWHIST_CH0)
+			rkisp_stats_get_rawhstlite_meas_lite(stats_vdev, stat);
+		stat->frame_id = frame_id;
+		stat->params_id = dev->params_vdev.cur_frame_id;
+		meas_type = stat->meas_type;
+	}
+
+	vb2_set_plane_payload(&buf->vb.vb2_buf, 0, size);
+	buf->vb.sequence = frame_id;
+	buf->vb.vb2_buf.timestamp = rkisp_time_get_ns(dev);
+	vb2_buffer_done(&buf->vb.vb2_buf, VB2_BUF_STATE_DONE);
+
+	v4l2_dbg(4, rkisp_debug, &dev->v4l2_dev,
+		 "%s seq:%d ris:0x%x meas_type:0x%x\n",
+		 __func__, frame_id, isp3a_ris, meas_type);
+}
+
 static void
 rkisp_stats_send_meas_v32(struct rkisp_isp_stats_vdev *stats_vdev,
 			  struct rkisp_isp_readout_work *meas_work)
@@ -1019,12 +1097,20 @@ rkisp_stats_isr_v32(struct rkisp_isp_stats_vdev *stats_vdev,
 	u32 iq_isr_mask = ISP3X_SIAWB_DONE | ISP3X_SIAF_FIN |
 		ISP3X_EXP_END | ISP3X_SIHST_RDY | ISP3X_AFM_SUM_OF | ISP3X_AFM_LUM_OF;
 	u32 cur_frame_id, isp_mis_tmp = 0;
-	u32 temp_isp_ris, temp_isp3a_ris;
+	u32 temp_isp_ris, temp_isp3a_ris, early;
 
 	rkisp_dmarx_get_frame(stats_vdev->dev, &cur_frame_id, NULL, NULL, true);
 
 	spin_lock(&stats_vdev->irq_lock);
 
+	early = isp3a_ris & rkisp_stats_early_mask_v32(stats_vdev);
+	if (early && !(isp_ris & ISP3X_FRAME)) {
+		isp3_stats_write(stats_vdev, ISP3X_ISP_3A_ICR, early);
+		rkisp_stats_send_early(stats_vdev, early, cur_frame_id);
+		spin_unlock(&stats_vdev->irq_lock);
+		return;
+	}
+
 	temp_isp_ris = isp3_stats_read(stats_vdev, ISP3X_ISP_RIS);
 	temp_isp3a_ris = isp3_stats_read(stats_vdev, ISP3X_ISP_3A_RIS);
 
@@ -1054,8 +1140,9 @@ rkisp_stats_isr_v32(struct rkisp_isp_stats_vdev *stats_vdev,
 		work.readout = RKISP_ISP_READOUT_MEAS;
 		work.frame_id = cur_frame_id;
 		work.isp_ris = temp_isp_ris | isp_ris;
-		work.isp3a_ris = temp_isp3a_ris;
+		work.isp3a_ris = temp_isp3a_ris | stats_vdev->isp3a_early;
 		work.timestamp = rkisp_time_get_ns(stats_vdev->dev);
+		stats_vdev->isp3a_early = 0;
 		rkisp_stats_send_meas_v32(stats_vdev, &work);
 	}
 
@@ -1094,6 +1181,21 @@ static struct rkisp_isp_stats_ops rkisp_isp_stats_ops_tbl = {
 	.get_stat_size = rkisp_get_stat_size_v32,
 };
 
+u32 rkisp_stats_early_mask_v32(struct rkisp_isp_stats_vdev *stats_vdev)
+{
+	struct rkisp_device *dev = stats_vdev->dev;
+	u32 mask = ISP32L_STATS_EARLY_MASK;
+
+	if (dev->isp_ver == ISP_V32)
+		mask = ISP32_STATS_EARLY_MASK;
+	/* one buffer is shared by the unite halves, every pass of readback */
+	if (dev->unite_div > ISP_UNITE_DIV1 || !dev->hw_dev->is_single ||
+	    IS_HDR_RDBK(dev->rd_mode))
+		return 0;
+
+	return rkisp_stats_early & mask;
+}
+
 void rkisp_stats_first_ddr_config_v32(struct rkisp_isp_stats_vdev *stats_vdev)
 {
 	struct rkisp_device *dev = stats_vdev->dev;
@@ -40,11 +40,13 @@ struct rkisp_stats_ops_v32 {
 };
 
 #if IS_ENABLED(CONFIG_VIDEO_ROCKCHIP_ISP_VERSION_V32)
+u32 rkisp_stats_early_mask_v32(struct rkisp_isp_stats_vdev *stats_vdev);
 void rkisp_stats_first_ddr_config_v32(struct rkisp_isp_stats_vdev *stats_vdev);
 void rkisp_stats_next_ddr_config_v32(struct rkisp_isp_stats_vdev *stats_vdev);
 void rkisp_init_stats_vdev_v32(struct rkisp_isp_stats_vdev *stats_vdev);
 void rkisp_uninit_stats_vdev_v32(struct rkisp_isp_stats_vdev *stats_vdev);
 #else
+static inline u32 rkisp_stats_early_mask_v32(struct rkisp_isp_stats_vdev *stats_vdev) { return 0; }
 static inline void rkisp_stats_first_ddr_config_v32(struct rkisp_isp_stats_vdev *stats_vdev) {}
 static inline void rkisp_stats_next_ddr_config_v32(struct rkisp_isp_stats_vdev *stats_vdev) {}
 static inline void rkisp_init_stats_vdev_v32(struct rkisp_isp_stats_vdev *stats_vdev) {}
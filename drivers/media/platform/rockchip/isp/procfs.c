@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0
 /* Copyright (c) Rockchip Electronics Co., Ltd. */
 #include <linux/clk.h>
+#include <linux/math64.h>
 #include <linux/proc_fs.h>
 #include <linux/sem.h>
 #include <linux/seq_file.h>
@@ -688,6 +689,13 @@ static void isp32_show(struct rkisp_device *dev, struct seq_file *p)
 		seq_printf(p, "%-10s %s warp:%d\n", "ISP2ENC",
 			   dev->cap_dev.wrap_line ? "online" : "offline",
 			   dev->cap_dev.wrap_line);
+		if (dev->cap_dev.dvbm.wrap_line)
+			seq_printf(p, "%-10s wrap:%d frame:%d overflow:%d underflow:%d fallback:%d\n",
+				   "DVBM", dev->cap_dev.dvbm.wrap_line,
+				   dev->cap_dev.dvbm.frame_cnt,
+				   dev->cap_dev.dvbm.overflow,
+				   dev->cap_dev.dvbm.underflow,
+				   dev->cap_dev.dvbm.fallback);
 		tmp = rkisp_read(dev, ISP32_MI_WR_VFLIP_CTRL, false);
 		val = rkisp_read(dev, ISP3X_ISP_CTRL0, false);
 		seq_printf(p, "%-10s mirror:%d flip(mp:%d sp:%d bp:%d mpds:%d bpds:%d)\n",
@@ -883,6 +891,14 @@ static int isp_show(struct seq_file *p, void *v)
 		seq_printf(p, "\t   hw link:%d idle:%d vir(mode:%d index:%d)\n",
 			   dev->hw_dev->dev_link_num, dev->hw_dev->is_idle,
 			   dev->multi_mode, dev->multi_index);
+		if (!dev->hw_dev->is_single) {
+			u64 busy = dev->rdbk_busy_ns;
+			u64 total = rkisp_time_get_ns(dev) - dev->rdbk_stat_ns;
+
+			seq_printf(p, "\t   occupancy:%llu%% busy:%llums reload:%u\n",
+				   total ? div64_u64(busy * 100, total) : 0,
+				   div_u64(busy, 1000000), dev->rdbk_reload_cnt);
+		}
 	} else {
 		seq_printf(p, "%-10s frame:%d state:%s time:%dms v-blank:%dus\n",
 			   "Isp online",
@@ -908,13 +908,52 @@ static void rkisp_fast_switch_rx_buf(struct rkisp_device *dev, bool is_current)
 	}
 }
 
+/*
+ * Pick the sensor the isp reads back next. The oldest queued frame goes
+ * first so no sensor starves behind another. Switching sensors costs an
+ * extra isp pass in multi overflow mode, so there the previous sensor
+ * keeps the isp while it has frames queued, unless another sensor is
+ * about to drop frames.
+ */
+static int rkisp_rdbk_select(struct rkisp_hw_dev *hw, int *len)
+{
+	struct rkisp_device *isp;
+	struct isp2x_csi_trigger t;
+	u64 oldest = U64_MAX;
+	int i, id = -1, pre = hw->pre_dev_id;
+	bool is_batch = hw->is_multi_overflow && pre >= 0 && pre < hw->dev_num;
+
+	for (i = 0; i < hw->dev_num; i++) {
+		isp = hw->isp[i];
+		if (!isp ||
+		    (isp && (!(isp->isp_state & ISP_START) || isp->is_suspend)))
+			continue;
+		rkisp_rdbk_trigger_event(isp, T_CMD_LEN, &len[i]);
+		if (!len[i])
+			continue;
+		if (len[i] >= RKISP_RDBK_BATCH_MAX && i != pre)
+			is_batch = false;
+		if (rkisp_rdbk_trigger_event(isp, T_CMD_PEEK, &t) < 0)
+			continue;
+		if (t.sof_timestamp < oldest) {
+			oldest = t.sof_timestamp;
+			id = i;
+		}
+	}
+
+	if (is_batch && len[pre])
+		id = pre;
+
+	return id;
+}
+
 static void rkisp_rdbk_trigger_handle(struct rkisp_device *dev, u32 cmd)
 {
 	struct rkisp_hw_dev *hw = dev->hw_dev;
 	struct rkisp_device *isp = NULL;
 	struct isp2x_csi_trigger t = { 0 };
 	unsigned long lock_flags = 0;
-	int i, times = -1, max = 0, id = 0;
+	int times = -1, max = 0, id = 0;
 	int len[DEV_MAX] = { 0 };
 	u32 mode = 0;
 	bool is_try = false;
@@ -938,6 +977,10 @@ static void rkisp_rdbk_trigger_handle(struct rkisp_device *dev, u32 cmd)
 		}
 		hw->is_idle = true;
 		hw->pre_dev_id = dev->dev_id;
+		if (dev->rdbk_start_ns) {
+			dev->rdbk_busy_ns += rkisp_time_get_ns(dev) - dev->rdbk_start_ns;
+			dev->rdbk_start_ns = 0;
+		}
 	}
 	if (hw->is_shutdown)
 		hw->is_idle = false;
@@ -953,17 +996,9 @@ static void rkisp_rdbk_trigger_handle(struct rkisp_device *dev, u32 cmd)
 		goto end;
 	}
 
-	for (i = 0; i < hw->dev_num; i++) {
-		isp = hw->isp[i];
-		if (!isp ||
-		    (isp && (!(isp->isp_state & ISP_START) || isp->is_suspend)))
-			continue;
-		rkisp_rdbk_trigger_event(isp, T_CMD_LEN, &len[i]);
-		if (max < len[i]) {
-			max = len[i];
-			id = i;
-		}
-	}
+	id = rkisp_rdbk_select(hw, len);
+	if (id >= 0)
+		max = len[id];
 
 	/* wait 2 frame to start isp for fast */
 	if (dev->is_rtt_first && max == 1 && !atomic_read(&dev->isp_sdev.frm_sync_seq))
@@ -988,6 +1023,9 @@ static void rkisp_rdbk_trigger_handle(struct rkisp_device *dev, u32 cmd)
 		times = t.times;
 		hw->cur_dev_id = id;
 		hw->is_idle = false;
+		if (hw->pre_dev_id != -1 && hw->pre_dev_id != id)
+			isp->rdbk_reload_cnt++;
+		isp->rdbk_start_ns = rkisp_time_get_ns(isp);
 		/* this frame will read count by isp */
 		isp->sw_rd_cnt = 0;
 		isp->is_frame_double = false;
@@ -1062,6 +1100,12 @@ int rkisp_rdbk_trigger_event(struct rkisp_device *dev, u32 cmd, void *arg)
 		val = kfifo_len(fifo) / sizeof(struct isp2x_csi_trigger);
 		*(u32 *)arg = val;
 		break;
+	case T_CMD_PEEK:
+		if (!kfifo_is_empty(fifo))
+			ret = kfifo_out_peek(fifo, arg, sizeof(struct isp2x_csi_trigger));
+		if (!ret)
+			ret = -EINVAL;
+		break;
 	default:
 		break;
 	}
@@ -2156,6 +2200,9 @@ static int rkisp_isp_start(struct rkisp_device *dev)
 	dev->cap_dev.is_done_early = false;
 	if (dev->cap_dev.wait_line >= dev->isp_sdev.out_crop.height)
 		dev->cap_dev.wait_line = 0;
+	val = rkisp_stats_early_mask(&dev->stats_vdev);
+	if (val)
+		rkisp_unite_set_bits(dev, ISP_ISP3A_IMSC, 0, val, false);
 	if (dev->cap_dev.wait_line) {
 		dev->cap_dev.is_done_early = true;
 		if (dev->isp_ver >= ISP_V32) {
@@ -2933,6 +2980,10 @@ static int rkisp_isp_sd_s_stream(struct v4l2_subdev *sd, int on)
 	hw_dev->is_runing = true;
 	rkisp_start_3a_run(isp_dev);
 	memset(&isp_dev->isp_sdev.dbg, 0, sizeof(isp_dev->isp_sdev.dbg));
+	isp_dev->rdbk_busy_ns = 0;
+	isp_dev->rdbk_start_ns = 0;
+	isp_dev->rdbk_reload_cnt = 0;
+	isp_dev->rdbk_stat_ns = rkisp_time_get_ns(isp_dev);
 	if (atomic_inc_return(&hw_dev->refcnt) > hw_dev->dev_link_num) {
 		dev_err(isp_dev->dev, "%s fail: input link before hw start\n", __func__);
 		atomic_dec(&hw_dev->refcnt);
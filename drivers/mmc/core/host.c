@@ -494,6 +494,7 @@ struct mmc_host *mmc_alloc_host(int extra, struct device *dev)
 	init_waitqueue_head(&host->wq);
 	INIT_DELAYED_WORK(&host->detect, mmc_rescan);
 	INIT_DELAYED_WORK(&host->sdio_irq_work, sdio_irq_work);
+	kthread_init_work(&host->sdio_irq_kwork, sdio_irq_kwork);
 	timer_setup(&host->retune_timer, mmc_retune_timer, 0);
 
 	/*
@@ -569,6 +570,7 @@ EXPORT_SYMBOL(mmc_add_host);
 void mmc_remove_host(struct mmc_host *host)
 {
 	mmc_stop_host(host);
+	sdio_irq_worker_destroy(host);
 
 #ifdef CONFIG_DEBUG_FS
 	mmc_remove_host_debugfs(host);
@@ -16,6 +16,7 @@
 #include <linux/export.h>
 #include <linux/wait.h>
 #include <linux/delay.h>
+#include <linux/moduleparam.h>
 
 #include <linux/mmc/core.h>
 #include <linux/mmc/host.h>
@@ -27,6 +28,38 @@
 #include "core.h"
 #include "card.h"
 
+/*
+ * SCHED_FIFO priority of the SDIO IRQ thread, or of the worker running
+ * sdio_irq_work for hosts with MMC_CAP2_SDIO_IRQ_NOTHREAD. With 0 the
+ * thread is FIFO low and the work goes to system_wq.
+ */
+static int sdio_irq_prio;
+module_param(sdio_irq_prio, int, 0644);
+MODULE_PARM_DESC(sdio_irq_prio, "SCHED_FIFO priority of SDIO IRQ processing, 0 for default");
+
+static int sdio_irq_cpu = -1;
+module_param(sdio_irq_cpu, int, 0644);
+MODULE_PARM_DESC(sdio_irq_cpu, "CPU to run SDIO IRQ processing on, -1 for any");
+
+static void sdio_irq_set_sched(struct task_struct *p)
+{
+	int prio = READ_ONCE(sdio_irq_prio);
+	int cpu = READ_ONCE(sdio_irq_cpu);
+
+	if (prio > 0) {
+		struct sched_param param = {
+			.sched_priority = min(prio, MAX_RT_PRIO - 1),
+		};
+
+		sched_setscheduler_nocheck(p, SCHED_FIFO, &param);
+	} else {
+		sched_set_fifo_low(p);
+	}
+
+	if (cpu >= 0 && cpu < nr_cpu_ids && cpu_online(cpu))
+		set_cpus_allowed_ptr(p, cpumask_of(cpu));
+}
+
 static int sdio_get_pending_irqs(struct mmc_host *host, u8 *pending)
 {
 	struct mmc_card *card = host->card;
@@ -129,10 +162,60 @@ void sdio_irq_work(struct work_struct *work)
 	sdio_run_irqs(host);
 }
 
+void sdio_irq_kwork(struct kthread_work *work)
+{
+	struct mmc_host *host =
+		container_of(work, struct mmc_host, sdio_irq_kwork);
+
+	sdio_run_irqs(host);
+}
+
+void sdio_queue_irq_work(struct mmc_host *host)
+{
+	struct kthread_worker *worker = READ_ONCE(host->sdio_irq_worker);
+
+	if (worker)
+		kthread_queue_work(worker, &host->sdio_irq_kwork);
+	else
+		queue_delayed_work(system_wq, &host->sdio_irq_work, 0);
+}
+
+void sdio_cancel_irq_work(struct mmc_host *host)
+{
+	cancel_delayed_work_sync(&host->sdio_irq_work);
+	if (host->sdio_irq_worker)
+		kthread_cancel_work_sync(&host->sdio_irq_kwork);
+}
+
+static void sdio_irq_worker_create(struct mmc_host *host)
+{
+	struct kthread_worker *worker;
+
+	worker = kthread_create_worker(0, "ksdioirqd/%s", mmc_hostname(host));
+	if (IS_ERR(worker)) {
+		pr_warn("%s: no SDIO IRQ worker, using system_wq\n",
+			mmc_hostname(host));
+		return;
+	}
+
+	sdio_irq_set_sched(worker->task);
+	WRITE_ONCE(host->sdio_irq_worker, worker);
+}
+
+/* Called once the card is gone, nothing can queue the work any more */
+void sdio_irq_worker_destroy(struct mmc_host *host)
+{
+	if (!host->sdio_irq_worker)
+		return;
+
+	kthread_destroy_worker(host->sdio_irq_worker);
+	host->sdio_irq_worker = NULL;
+}
+
 void sdio_signal_irq(struct mmc_host *host)
 {
 	host->sdio_irq_pending = true;
-	queue_delayed_work(system_wq, &host->sdio_irq_work, 0);
+	sdio_queue_irq_work(host);
 }
 EXPORT_SYMBOL_GPL(sdio_signal_irq);
 
@@ -142,7 +225,7 @@ static int sdio_irq_thread(void *_host)
 	unsigned long period, idle_period;
 	int ret;
 
-	sched_set_fifo_low(current);
+	sdio_irq_set_sched(current);
 
 	/*
 	 * We want to allow for SDIO cards to work even on non SDIO
@@ -239,6 +322,9 @@ static int sdio_card_irq_get(struct mmc_card *card)
 				return err;
 			}
 		} else if (host->caps & MMC_CAP_SDIO_IRQ) {
+			/* kept until the host goes, the work may be in flight */
+			if (READ_ONCE(sdio_irq_prio) > 0 && !host->sdio_irq_worker)
+				sdio_irq_worker_create(host);
 			host->ops->enable_sdio_irq(host, 1);
 		}
 	}
@@ -14,6 +14,7 @@
 struct mmc_host;
 struct mmc_card;
 struct work_struct;
+struct kthread_work;
 
 int mmc_send_io_op_cond(struct mmc_host *host, u32 ocr, u32 *rocr);
 int mmc_io_rw_direct(struct mmc_card *card, int write, unsigned fn,
@@ -22,6 +23,10 @@ int mmc_io_rw_extended(struct mmc_card *card, int write, unsigned fn,
 	unsigned addr, int incr_addr, u8 *buf, unsigned blocks, unsigned blksz);
 int sdio_reset(struct mmc_host *host);
 void sdio_irq_work(struct work_struct *work);
+void sdio_irq_kwork(struct kthread_work *work);
+void sdio_queue_irq_work(struct mmc_host *host);
+void sdio_cancel_irq_work(struct mmc_host *host);
+void sdio_irq_worker_destroy(struct mmc_host *host);
 
 static inline bool sdio_is_io_busy(u32 opcode, u32 arg)
 {
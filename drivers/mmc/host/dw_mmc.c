@@ -531,24 +531,24 @@ static void dw_mci_dmac_complete_dma(void *arg)
 		del_timer(&host->xfer_timer);
 }
 
-static int dw_mci_idmac_init(struct dw_mci *host)
+/* Link the descriptors of ring @n into a circular chain */
+static void dw_mci_idmac_init_ring(struct dw_mci *host, unsigned int n)
 {
-	int i;
+	struct dw_mci_desc_ring *ring = &host->desc_ring[n];
+	int i, size;
 
 	if (host->dma_64bit_address == 1) {
 		struct idmac_desc_64addr *p;
-		/* Number of descriptors in the ring buffer */
-		host->ring_size =
-			DESC_RING_BUF_SZ / sizeof(struct idmac_desc_64addr);
+
+		size = DESC_RING_BUF_SZ / sizeof(struct idmac_desc_64addr);
 
 		/* Forward link the descriptor list */
-		for (i = 0, p = host->sg_cpu; i < host->ring_size - 1;
-								i++, p++) {
-			p->des6 = (host->sg_dma +
+		for (i = 0, p = ring->cpu; i < size - 1; i++, p++) {
+			p->des6 = (ring->dma +
 					(sizeof(struct idmac_desc_64addr) *
 							(i + 1))) & 0xffffffff;
 
-			p->des7 = (u64)(host->sg_dma +
+			p->des7 = (u64)(ring->dma +
 					(sizeof(struct idmac_desc_64addr) *
 							(i + 1))) >> 32;
 			/* Initialize reserved and buffer size fields to "0" */
@@ -559,31 +559,57 @@ static int dw_mci_idmac_init(struct dw_mci *host)
 		}
 
 		/* Set the last descriptor as the end-of-ring descriptor */
-		p->des6 = host->sg_dma & 0xffffffff;
-		p->des7 = (u64)host->sg_dma >> 32;
+		p->des6 = ring->dma & 0xffffffff;
+		p->des7 = (u64)ring->dma >> 32;
 		p->des0 = IDMAC_DES0_ER;
 
 	} else {
 		struct idmac_desc *p;
-		/* Number of descriptors in the ring buffer */
-		host->ring_size =
-			DESC_RING_BUF_SZ / sizeof(struct idmac_desc);
+
+		size = DESC_RING_BUF_SZ / sizeof(struct idmac_desc);
 
 		/* Forward link the descriptor list */
-		for (i = 0, p = host->sg_cpu;
-		     i < host->ring_size - 1;
-		     i++, p++) {
-			p->des3 = cpu_to_le32(host->sg_dma +
+		for (i = 0, p = ring->cpu; i < size - 1; i++, p++) {
+			p->des3 = cpu_to_le32(ring->dma +
 					(sizeof(struct idmac_desc) * (i + 1)));
 			p->des0 = 0;
 			p->des1 = 0;
 		}
 
 		/* Set the last descriptor as the end-of-ring descriptor */
-		p->des3 = cpu_to_le32(host->sg_dma);
+		p->des3 = cpu_to_le32(ring->dma);
 		p->des0 = cpu_to_le32(IDMAC_DES0_ER);
 	}
 
+	ring->data = NULL;
+}
+
+static int dw_mci_idmac_init(struct dw_mci *host)
+{
+	unsigned long flags;
+	int i;
+
+	/* Number of descriptors in each ring buffer */
+	if (host->dma_64bit_address == 1)
+		host->ring_size =
+			DESC_RING_BUF_SZ / sizeof(struct idmac_desc_64addr);
+	else
+		host->ring_size =
+			DESC_RING_BUF_SZ / sizeof(struct idmac_desc);
+
+	/*
+	 * Two rings: while the IDMAC walks one, pre_req() fills the other
+	 * for the next request.
+	 */
+	spin_lock_irqsave(&host->desc_lock, flags);
+	for (i = 0; i < ARRAY_SIZE(host->desc_ring); i++) {
+		host->desc_ring[i].cpu = host->sg_cpu + i * DESC_RING_BUF_SZ;
+		host->desc_ring[i].dma = host->sg_dma + i * DESC_RING_BUF_SZ;
+		dw_mci_idmac_init_ring(host, i);
+	}
+	host->desc_active = 0;
+	spin_unlock_irqrestore(&host->desc_lock, flags);
+
 	dw_mci_idmac_reset(host);
 
 	if (host->dma_64bit_address == 1) {
@@ -611,14 +637,14 @@ static int dw_mci_idmac_init(struct dw_mci *host)
 
 static inline int dw_mci_prepare_desc64(struct dw_mci *host,
 					 struct mmc_data *data,
-					 unsigned int sg_len)
+					 unsigned int sg_len, unsigned int n)
 {
 	unsigned int desc_len;
 	struct idmac_desc_64addr *desc_first, *desc_last, *desc;
 	u32 val;
 	int i;
 
-	desc_first = desc_last = desc = host->sg_cpu;
+	desc_first = desc_last = desc = host->desc_ring[n].cpu;
 
 	for (i = 0; i < sg_len; i++) {
 		unsigned int length = sg_dma_len(&data->sg[i]);
@@ -675,22 +701,22 @@ static inline int dw_mci_prepare_desc64(struct dw_mci *host,
 err_own_bit:
 	/* restore the descriptor chain as it's polluted */
 	dev_dbg(host->dev, "descriptor is still owned by IDMAC.\n");
-	memset(host->sg_cpu, 0, DESC_RING_BUF_SZ);
-	dw_mci_idmac_init(host);
+	memset(host->desc_ring[n].cpu, 0, DESC_RING_BUF_SZ);
+	dw_mci_idmac_init_ring(host, n);
 	return -EINVAL;
 }
 
 
 static inline int dw_mci_prepare_desc32(struct dw_mci *host,
 					 struct mmc_data *data,
-					 unsigned int sg_len)
+					 unsigned int sg_len, unsigned int n)
 {
 	unsigned int desc_len;
 	struct idmac_desc *desc_first, *desc_last, *desc;
 	u32 val;
 	int i;
 
-	desc_first = desc_last = desc = host->sg_cpu;
+	desc_first = desc_last = desc = host->desc_ring[n].cpu;
 
 	for (i = 0; i < sg_len; i++) {
 		unsigned int length = sg_dma_len(&data->sg[i]);
@@ -756,23 +782,87 @@ static inline int dw_mci_prepare_desc32(struct dw_mci *host,
 err_own_bit:
 	/* restore the descriptor chain as it's polluted */
 	dev_dbg(host->dev, "descriptor is still owned by IDMAC.\n");
-	memset(host->sg_cpu, 0, DESC_RING_BUF_SZ);
-	dw_mci_idmac_init(host);
+	memset(host->desc_ring[n].cpu, 0, DESC_RING_BUF_SZ);
+	dw_mci_idmac_init_ring(host, n);
 	return -EINVAL;
 }
 
+static int dw_mci_idmac_prepare_desc(struct dw_mci *host,
+				     struct mmc_data *data,
+				     unsigned int sg_len, unsigned int n)
+{
+	if (host->dma_64bit_address == 1)
+		return dw_mci_prepare_desc64(host, data, sg_len, n);
+	else
+		return dw_mci_prepare_desc32(host, data, sg_len, n);
+}
+
+/*
+ * Called from pre_req() while the previous request may still be running:
+ * build the descriptors of @data in the ring the IDMAC is not walking, so
+ * that starting @data only has to point the IDMAC at it.
+ */
+static void dw_mci_idmac_pre_desc(struct dw_mci *host, struct mmc_data *data,
+				  unsigned int sg_len)
+{
+	struct dw_mci_desc_ring *ring;
+	unsigned long flags;
+	unsigned int n;
+
+	spin_lock_irqsave(&host->desc_lock, flags);
+	n = !host->desc_active;
+	ring = &host->desc_ring[n];
+	if (ring->data) {
+		spin_unlock_irqrestore(&host->desc_lock, flags);
+		return;
+	}
+	ring->data = data;
+	spin_unlock_irqrestore(&host->desc_lock, flags);
+
+	if (dw_mci_idmac_prepare_desc(host, data, sg_len, n)) {
+		spin_lock_irqsave(&host->desc_lock, flags);
+		ring->data = NULL;
+		spin_unlock_irqrestore(&host->desc_lock, flags);
+	}
+}
+
+/* Drop the descriptors pre_req() built for @data if it never started */
+static void dw_mci_idmac_post_desc(struct dw_mci *host, struct mmc_data *data)
+{
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&host->desc_lock, flags);
+	for (i = 0; i < ARRAY_SIZE(host->desc_ring); i++)
+		if (host->desc_ring[i].data == data)
+			host->desc_ring[i].data = NULL;
+	spin_unlock_irqrestore(&host->desc_lock, flags);
+}
+
 static int dw_mci_idmac_start_dma(struct dw_mci *host, unsigned int sg_len)
 {
+	struct dw_mci_desc_ring *ring;
+	unsigned long flags;
+	bool prepared = false;
 	u32 temp;
-	int ret;
+	int ret = 0;
 
-	if (host->dma_64bit_address == 1)
-		ret = dw_mci_prepare_desc64(host, host->data, sg_len);
-	else
-		ret = dw_mci_prepare_desc32(host, host->data, sg_len);
+	spin_lock_irqsave(&host->desc_lock, flags);
+	if (host->desc_ring[!host->desc_active].data == host->data) {
+		host->desc_active = !host->desc_active;
+		host->desc_ring[host->desc_active].data = NULL;
+		prepared = true;
+	}
+	ring = &host->desc_ring[host->desc_active];
+	spin_unlock_irqrestore(&host->desc_lock, flags);
 
-	if (ret)
+	if (!prepared)
+		ret = dw_mci_idmac_prepare_desc(host, host->data, sg_len,
+						host->desc_active);
+	if (ret) {
+		dw_mci_idmac_init(host);
 		goto out;
+	}
 
 	/* drain writebuffer */
 	wmb();
@@ -781,6 +871,14 @@ static int dw_mci_idmac_start_dma(struct dw_mci *host, unsigned int sg_len)
 	dw_mci_ctrl_reset(host, SDMMC_CTRL_DMA_RESET);
 	dw_mci_idmac_reset(host);
 
+	/* Point the IDMAC at the ring holding this request */
+	if (host->dma_64bit_address == 1) {
+		mci_writel(host, DBADDRL, ring->dma & 0xffffffff);
+		mci_writel(host, DBADDRU, (u64)ring->dma >> 32);
+	} else {
+		mci_writel(host, DBADDR, ring->dma);
+	}
+
 	/* Select IDMAC interface */
 	temp = mci_readl(host, CTRL);
 	temp |= SDMMC_CTRL_USE_IDMAC;
@@ -956,6 +1054,7 @@ static void dw_mci_pre_req(struct mmc_host *mmc,
 {
 	struct dw_mci_slot *slot = mmc_priv(mmc);
 	struct mmc_data *data = mrq->data;
+	int sg_len;
 
 	if (!slot->host->use_dma || !data)
 		return;
@@ -963,9 +1062,15 @@ static void dw_mci_pre_req(struct mmc_host *mmc,
 	/* This data might be unmapped at this time */
 	data->host_cookie = COOKIE_UNMAPPED;
 
-	if (dw_mci_pre_dma_transfer(slot->host, mrq->data,
-				COOKIE_PRE_MAPPED) < 0)
+	sg_len = dw_mci_pre_dma_transfer(slot->host, mrq->data,
+					 COOKIE_PRE_MAPPED);
+	if (sg_len < 0) {
 		data->host_cookie = COOKIE_UNMAPPED;
+		return;
+	}
+
+	if (slot->host->use_dma == TRANS_MODE_IDMAC)
+		dw_mci_idmac_pre_desc(slot->host, data, sg_len);
 }
 
 static void dw_mci_post_req(struct mmc_host *mmc,
@@ -978,6 +1083,9 @@ static void dw_mci_post_req(struct mmc_host *mmc,
 	if (!slot->host->use_dma || !data)
 		return;
 
+	if (slot->host->use_dma == TRANS_MODE_IDMAC)
+		dw_mci_idmac_post_desc(slot->host, data);
+
 	if (data->host_cookie != COOKIE_UNMAPPED)
 		dma_unmap_sg(slot->host->dev,
 			     data->sg,
@@ -3064,7 +3172,7 @@ static void dw_mci_init_dma(struct dw_mci *host)
 
 		/* Alloc memory for sg translation */
 		host->sg_cpu = dmam_alloc_coherent(host->dev,
-						   DESC_RING_BUF_SZ,
+						   2 * DESC_RING_BUF_SZ,
 						   &host->sg_dma, GFP_KERNEL);
 		if (!host->sg_cpu) {
 			dev_err(host->dev,
@@ -3436,6 +3544,7 @@ int dw_mci_probe(struct dw_mci *host)
 
 	spin_lock_init(&host->lock);
 	spin_lock_init(&host->irq_lock);
+	spin_lock_init(&host->desc_lock);
 	INIT_LIST_HEAD(&host->queue);
 
 	/*
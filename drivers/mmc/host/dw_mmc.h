@@ -53,6 +53,18 @@ struct dw_mci_dma_slave {
 	enum dma_transfer_direction direction;
 };
 
+/**
+ * struct dw_mci_desc_ring - one idma descriptor ring
+ * @cpu: Virtual address of the ring.
+ * @dma: Bus address of the ring.
+ * @data: The request pre_req() built the ring for, not started yet.
+ */
+struct dw_mci_desc_ring {
+	void			*cpu;
+	dma_addr_t		dma;
+	struct mmc_data		*data;
+};
+
 /**
  * struct dw_mci - MMC controller state shared between all slots
  * @lock: Spinlock protecting the queue and associated data.
@@ -75,6 +87,9 @@ struct dw_mci_dma_slave {
  * @dma_64bit_address: Whether DMA supports 64-bit address mode or not.
  * @sg_dma: Bus address of DMA buffer.
  * @sg_cpu: Virtual address of DMA buffer.
+ * @desc_ring: The two idma descriptor rings carved out of the DMA buffer.
+ * @desc_active: Index of the ring the IDMAC walks, or walked last.
+ * @desc_lock: Spinlock protecting @desc_ring ownership and @desc_active.
  * @dma_ops: Pointer to platform-specific DMA callbacks.
  * @cmd_status: Snapshot of SR taken upon completion of the current
  * @ring_size: Buffer size for idma descriptors.
@@ -180,6 +195,9 @@ struct dw_mci {
 	const struct dw_mci_dma_ops	*dma_ops;
 	/* For idmac */
 	unsigned int		ring_size;
+	struct dw_mci_desc_ring	desc_ring[2];
+	unsigned int		desc_active;
+	spinlock_t		desc_lock;
 
 	/* For edmac */
 	struct dw_mci_dma_slave *dms;
@@ -74,6 +74,8 @@
 #include <linux/crc32.h>
 #include <linux/math64.h>
 #include <linux/random.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
 #include "ubi.h"
 
 static int self_check_ai(struct ubi_device *ubi, struct ubi_attach_info *ai);
@@ -927,38 +929,73 @@ static bool vol_ignored(int vol_id)
 }
 
 /**
- * scan_peb - scan and process UBI headers of a PEB.
+ * read_peb_hdrs - read the UBI headers of a PEB.
+ * @ubi: UBI device description object
+ * @pnum: the physical eraseblock number
+ * @ech: buffer for the EC header
+ * @vidb: buffer for the VID header
+ * @ec_res: where to store what ubi_io_read_ec_hdr() returned
+ * @vid_res: where to store what ubi_io_read_vid_hdr() returned
+ *
+ * This function only does the I/O and CRC checking part of scanning, it
+ * does not touch attaching information and may run in parallel for different
+ * PEBs. The VID header is not read if the EC header says the PEB is empty.
+ * Returns %1 if the PEB is bad, zero if the headers were read, and a
+ * negative error code in case of failure.
+ */
+static int read_peb_hdrs(struct ubi_device *ubi, int pnum,
+			 struct ubi_ec_hdr *ech, struct ubi_vid_io_buf *vidb,
+			 int *ec_res, int *vid_res)
+{
+	int err;
+
+	/* Skip bad physical eraseblocks */
+	err = ubi_io_is_bad(ubi, pnum);
+	if (err)
+		return err < 0 ? err : 1;
+
+	*ec_res = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
+	switch (*ec_res) {
+	case 0:
+	case UBI_IO_BITFLIPS:
+	case UBI_IO_BAD_HDR_EBADMSG:
+	case UBI_IO_BAD_HDR:
+		*vid_res = ubi_io_read_vid_hdr(ubi, pnum, vidb, 0);
+		break;
+	default:
+		*vid_res = 0;
+		break;
+	}
+
+	return 0;
+}
+
+/**
+ * process_peb_hdrs - process UBI headers of a PEB.
  * @ubi: UBI device description object
  * @ai: attaching information
  * @pnum: the physical eraseblock number
+ * @ech: EC header read by read_peb_hdrs()
+ * @vidb: VID header read by read_peb_hdrs()
+ * @ec_res: EC header read result
+ * @vid_res: VID header read result
  * @fast: true if we're scanning for a Fastmap
  *
- * This function reads UBI headers of PEB @pnum, checks them, and adds
- * information about this PEB to the corresponding list or RB-tree in the
- * "attaching info" structure. Returns zero if the physical eraseblock was
- * successfully handled and a negative error code in case of failure.
+ * This function checks the headers of PEB @pnum and adds information about
+ * this PEB to the corresponding list or RB-tree in the "attaching info"
+ * structure. Returns zero if the physical eraseblock was successfully handled
+ * and a negative error code in case of failure.
  */
-static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
-		    int pnum, bool fast)
+static int process_peb_hdrs(struct ubi_device *ubi, struct ubi_attach_info *ai,
+			    int pnum, struct ubi_ec_hdr *ech,
+			    struct ubi_vid_io_buf *vidb, int ec_res,
+			    int vid_res, bool fast)
 {
-	struct ubi_ec_hdr *ech = ai->ech;
-	struct ubi_vid_io_buf *vidb = ai->vidb;
 	struct ubi_vid_hdr *vidh = ubi_get_vid_hdr(vidb);
 	long long ec;
 	int err, bitflips = 0, vol_id = -1, ec_err = 0;
 
-	dbg_bld("scan PEB %d", pnum);
-
-	/* Skip bad physical eraseblocks */
-	err = ubi_io_is_bad(ubi, pnum);
-	if (err < 0)
-		return err;
-	else if (err) {
-		ai->bad_peb_count += 1;
-		return 0;
-	}
-
-	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
+	err = ec_res;
 	if (err < 0)
 		return err;
 	switch (err) {
@@ -1041,7 +1078,7 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 
 	/* OK, we've done with the EC header, let's look at the VID header */
 
-	err = ubi_io_read_vid_hdr(ubi, pnum, vidb, 0);
+	err = vid_res;
 	if (err < 0)
 		return err;
 	switch (err) {
@@ -1193,6 +1230,229 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	return 0;
 }
 
+/**
+ * scan_peb - scan and process UBI headers of a PEB.
+ * @ubi: UBI device description object
+ * @ai: attaching information
+ * @pnum: the physical eraseblock number
+ * @fast: true if we're scanning for a Fastmap
+ *
+ * This function reads UBI headers of PEB @pnum, checks them, and adds
+ * information about this PEB to the corresponding list or RB-tree in the
+ * "attaching info" structure. Returns zero if the physical eraseblock was
+ * successfully handled and a negative error code in case of failure.
+ */
+static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
+		    int pnum, bool fast)
+{
+	int err, ec_res, vid_res;
+
+	dbg_bld("scan PEB %d", pnum);
+
+	err = read_peb_hdrs(ubi, pnum, ai->ech, ai->vidb, &ec_res, &vid_res);
+	if (err < 0)
+		return err;
+	if (err) {
+		ai->bad_peb_count += 1;
+		return 0;
+	}
+
+	return process_peb_hdrs(ubi, ai, pnum, ai->ech, ai->vidb, ec_res,
+				vid_res, fast);
+}
+
+#if CONFIG_MTD_UBI_SCAN_WORKERS > 0
+
+/*
+ * Parallel scanning.
+ *
+ * Worker threads read and CRC-check the headers of upcoming PEBs into a ring
+ * of slots, while the attaching thread consumes the slots in PEB order and
+ * does all the bookkeeping exactly as serial scanning would. This keeps the
+ * flash busy while headers are verified and sorted into the RB-trees.
+ */
+#define UBI_SCAN_SLOTS 16
+
+struct ubi_scan_slot {
+	struct ubi_ec_hdr *ech;
+	struct ubi_vid_io_buf *vidb;
+	int err;
+	int ec_res;
+	int vid_res;
+	bool ready;
+};
+
+struct ubi_scan_pool;
+
+struct ubi_scan_worker {
+	struct work_struct work;
+	struct ubi_scan_pool *pool;
+};
+
+struct ubi_scan_pool {
+	struct ubi_device *ubi;
+	struct ubi_scan_slot slots[UBI_SCAN_SLOTS];
+	struct ubi_scan_worker workers[CONFIG_MTD_UBI_SCAN_WORKERS];
+	spinlock_t lock;
+	wait_queue_head_t wait;
+	int next;		/* next PEB a worker reads */
+	int consumed;		/* PEBs below this have been processed */
+	bool stop;
+};
+
+static bool scan_pool_can_read(struct ubi_scan_pool *pool)
+{
+	bool ret;
+
+	spin_lock(&pool->lock);
+	ret = pool->stop || pool->next >= pool->ubi->peb_count ||
+	      pool->next < pool->consumed + UBI_SCAN_SLOTS;
+	spin_unlock(&pool->lock);
+
+	return ret;
+}
+
+static bool scan_slot_ready(struct ubi_scan_pool *pool,
+			    struct ubi_scan_slot *slot)
+{
+	bool ret;
+
+	spin_lock(&pool->lock);
+	ret = slot->ready;
+	spin_unlock(&pool->lock);
+
+	return ret;
+}
+
+static void scan_pool_work(struct work_struct *work)
+{
+	struct ubi_scan_worker *worker;
+	struct ubi_scan_pool *pool;
+	struct ubi_scan_slot *slot;
+	int pnum;
+
+	worker = container_of(work, struct ubi_scan_worker, work);
+	pool = worker->pool;
+
+	for (;;) {
+		wait_event(pool->wait, scan_pool_can_read(pool));
+
+		spin_lock(&pool->lock);
+		if (pool->stop || pool->next >= pool->ubi->peb_count) {
+			spin_unlock(&pool->lock);
+			return;
+		}
+		if (pool->next >= pool->consumed + UBI_SCAN_SLOTS) {
+			/* another worker took the last free slot */
+			spin_unlock(&pool->lock);
+			continue;
+		}
+		pnum = pool->next++;
+		spin_unlock(&pool->lock);
+
+		slot = &pool->slots[pnum % UBI_SCAN_SLOTS];
+		slot->err = read_peb_hdrs(pool->ubi, pnum, slot->ech,
+					  slot->vidb, &slot->ec_res,
+					  &slot->vid_res);
+
+		spin_lock(&pool->lock);
+		slot->ready = true;
+		spin_unlock(&pool->lock);
+		wake_up_all(&pool->wait);
+	}
+}
+
+static int scan_all_parallel(struct ubi_device *ubi, struct ubi_attach_info *ai,
+			     int start)
+{
+	struct ubi_scan_pool *pool;
+	int err = -ENOMEM, pnum, i;
+
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return err;
+
+	for (i = 0; i < UBI_SCAN_SLOTS; i++) {
+		pool->slots[i].ech = kzalloc(ubi->ec_hdr_alsize, GFP_KERNEL);
+		pool->slots[i].vidb = ubi_alloc_vid_buf(ubi, GFP_KERNEL);
+		if (!pool->slots[i].ech || !pool->slots[i].vidb)
+			goto out_free;
+	}
+
+	pool->ubi = ubi;
+	pool->next = start;
+	pool->consumed = start;
+	spin_lock_init(&pool->lock);
+	init_waitqueue_head(&pool->wait);
+
+	for (i = 0; i < CONFIG_MTD_UBI_SCAN_WORKERS; i++) {
+		pool->workers[i].pool = pool;
+		INIT_WORK(&pool->workers[i].work, scan_pool_work);
+		queue_work(system_unbound_wq, &pool->workers[i].work);
+	}
+
+	err = 0;
+	for (pnum = start; pnum < ubi->peb_count; pnum++) {
+		struct ubi_scan_slot *slot = &pool->slots[pnum % UBI_SCAN_SLOTS];
+
+		wait_event(pool->wait, scan_slot_ready(pool, slot));
+
+		dbg_gen("process PEB %d", pnum);
+		err = slot->err;
+		if (err > 0) {
+			ai->bad_peb_count += 1;
+			err = 0;
+		} else if (!err) {
+			err = process_peb_hdrs(ubi, ai, pnum, slot->ech,
+					       slot->vidb, slot->ec_res,
+					       slot->vid_res, false);
+		}
+
+		spin_lock(&pool->lock);
+		slot->ready = false;
+		pool->consumed = pnum + 1;
+		if (err < 0)
+			pool->stop = true;
+		spin_unlock(&pool->lock);
+		wake_up_all(&pool->wait);
+
+		if (err < 0)
+			break;
+	}
+
+	for (i = 0; i < CONFIG_MTD_UBI_SCAN_WORKERS; i++)
+		flush_work(&pool->workers[i].work);
+
+out_free:
+	for (i = 0; i < UBI_SCAN_SLOTS; i++) {
+		ubi_free_vid_buf(pool->slots[i].vidb);
+		kfree(pool->slots[i].ech);
+	}
+	kfree(pool);
+	return err;
+}
+
+#else
+
+static int scan_all_parallel(struct ubi_device *ubi, struct ubi_attach_info *ai,
+			     int start)
+{
+	int err, pnum;
+
+	for (pnum = start; pnum < ubi->peb_count; pnum++) {
+		cond_resched();
+
+		dbg_gen("process PEB %d", pnum);
+		err = scan_peb(ubi, ai, pnum, false);
+		if (err < 0)
+			return err;
+	}
+
+	return 0;
+}
+
+#endif
+
 /**
  * late_analysis - analyze the overall situation with PEB.
  * @ubi: UBI device description object
@@ -1389,14 +1649,9 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	if (!ai->vidb)
 		goto out_ech;
 
-	for (pnum = start; pnum < ubi->peb_count; pnum++) {
-		cond_resched();
-
-		dbg_gen("process PEB %d", pnum);
-		err = scan_peb(ubi, ai, pnum, false);
-		if (err < 0)
-			goto out_vidh;
-	}
+	err = scan_all_parallel(ubi, ai, start);
+	if (err < 0)
+		goto out_vidh;
 
 	ubi_msg(ubi, "scanning is finished");
 
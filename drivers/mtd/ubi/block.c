@@ -41,6 +41,10 @@
 #include <linux/hdreg.h>
 #include <linux/scatterlist.h>
 #include <linux/idr.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/vmalloc.h>
+#include <linux/ktime.h>
 #include <asm/div64.h>
 
 #include "ubi-media.h"
@@ -55,6 +59,17 @@
 /* Maximum number of comma-separated items in the 'block=' parameter */
 #define UBIBLOCK_PARAM_COUNT 2
 
+/* Whole LEBs cached ahead of a sequential reader */
+#define UBIBLOCK_RA_SLOTS 2
+
+/* Back to back requests before the stream counts as sequential */
+#define UBIBLOCK_RA_SEQ_REQS 2
+
+static bool ubiblock_readahead = true;
+module_param_named(block_readahead, ubiblock_readahead, bool, 0444);
+MODULE_PARM_DESC(block_readahead,
+		 "Read whole LEBs ahead of sequential ubiblock readers (default: on)");
+
 struct ubiblock_param {
 	int ubi_num;
 	int vol_id;
@@ -63,6 +78,7 @@ struct ubiblock_param {
 
 struct ubiblock_pdu {
 	struct work_struct work;
+	u64 queued_ns;
 	struct ubi_sgl usgl;
 };
 
@@ -72,6 +88,25 @@ static int ubiblock_devs __initdata;
 /* MTD devices specification parameters */
 static struct ubiblock_param ubiblock_param[UBIBLOCK_MAX_DEVICES] __initdata;
 
+struct ubiblock_ra_slot {
+	struct mutex lock;		/* held while @buf is filled or read */
+	void *buf;
+	int leb;			/* LEB held in @buf, -1 if none */
+	int filling;			/* LEB being read into @buf, -1 if none */
+	int len;
+};
+
+struct ubiblock_stats {
+	u64 reads;
+	u64 bytes;
+	u64 ra_hit_bytes;
+	u64 ra_fills;
+	u64 wait_ns;			/* queue_rq() to the work running */
+	u64 wait_max_ns;
+	u64 service_ns;			/* reading the flash */
+	u64 service_max_ns;
+};
+
 struct ubiblock {
 	struct ubi_volume_desc *desc;
 	int ubi_num;
@@ -87,6 +122,18 @@ struct ubiblock {
 	struct mutex dev_mutex;
 	struct list_head list;
 	struct blk_mq_tag_set tag_set;
+
+	/* readahead, @ra_lock covers @ra_want and the stream detection */
+	struct ubiblock_ra_slot ra[UBIBLOCK_RA_SLOTS];
+	struct work_struct ra_work;
+	spinlock_t ra_lock;
+	int ra_want;			/* LEB the work should fetch next */
+	u64 seq_next;			/* byte a sequential reader asks next */
+	int seq_reqs;
+
+	spinlock_t stats_lock;
+	struct ubiblock_stats stats;
+	struct dentry *dbg;
 };
 
 /* Linked list of all ubiblock instances */
@@ -95,6 +142,7 @@ static DEFINE_IDR(ubiblock_minor_idr);
 /* Protects ubiblock_devices and ubiblock_minor_idr */
 static DEFINE_MUTEX(devices_mutex);
 static int ubiblock_major;
+static struct dentry *ubiblock_dbg_root;
 
 static int __init ubiblock_set_param(const char *val,
 				     const struct kernel_param *kp)
@@ -181,6 +229,215 @@ static struct ubiblock *find_dev_nolock(int ubi_num, int vol_id)
 	return NULL;
 }
 
+/* Same walk over the request's scatterlist as ubi_eba_read_leb_sg() */
+static void ubiblock_copy_sg(struct ubi_sgl *sgl, const void *buf, int len)
+{
+	struct scatterlist *sg;
+	int to_copy;
+
+	while (len) {
+		sg = &sgl->sg[sgl->list_pos];
+		to_copy = min_t(int, len, sg->length - sgl->page_pos);
+		memcpy(sg_virt(sg) + sgl->page_pos, buf, to_copy);
+
+		buf += to_copy;
+		len -= to_copy;
+		sgl->page_pos += to_copy;
+		if (sgl->page_pos == sg->length) {
+			sgl->list_pos++;
+			sgl->page_pos = 0;
+		}
+	}
+}
+
+/* Slot holding or being filled with @leb, looked up without locks */
+static struct ubiblock_ra_slot *ubiblock_ra_find(struct ubiblock *dev, int leb)
+{
+	int i;
+
+	for (i = 0; i < UBIBLOCK_RA_SLOTS; i++)
+		if (READ_ONCE(dev->ra[i].leb) == leb ||
+		    READ_ONCE(dev->ra[i].filling) == leb)
+			return &dev->ra[i];
+	return NULL;
+}
+
+/* Serve a chunk from a cached LEB, waiting if the work is reading it */
+static bool ubiblock_ra_read(struct ubiblock *dev, struct ubi_sgl *sgl,
+			     int leb, int offset, int len)
+{
+	struct ubiblock_ra_slot *slot;
+	bool hit = false;
+
+	if (!dev->ra[0].buf)
+		return false;
+
+	slot = ubiblock_ra_find(dev, leb);
+	if (!slot)
+		return false;
+
+	mutex_lock(&slot->lock);
+	if (slot->leb == leb && offset + len <= slot->len) {
+		ubiblock_copy_sg(sgl, slot->buf + offset, len);
+		hit = true;
+	}
+	mutex_unlock(&slot->lock);
+
+	return hit;
+}
+
+static void ubiblock_ra_work(struct work_struct *work)
+{
+	struct ubiblock *dev = container_of(work, struct ubiblock, ra_work);
+	struct ubiblock_ra_slot *slot;
+	int leb, len, ret, i;
+	u64 end;
+
+	spin_lock(&dev->ra_lock);
+	leb = dev->ra_want;
+	dev->ra_want = -1;
+	spin_unlock(&dev->ra_lock);
+
+	end = (u64)get_capacity(dev->gd) << 9;
+	if (!dev->desc || leb < 0 || ubiblock_ra_find(dev, leb) ||
+	    (u64)leb * dev->leb_size >= end)
+		return;
+
+	/* evict the slot furthest behind the reader */
+	slot = &dev->ra[0];
+	for (i = 1; i < UBIBLOCK_RA_SLOTS; i++)
+		if (dev->ra[i].leb < slot->leb)
+			slot = &dev->ra[i];
+
+	len = min_t(u64, dev->leb_size, end - (u64)leb * dev->leb_size);
+
+	mutex_lock(&slot->lock);
+	WRITE_ONCE(slot->leb, -1);
+	WRITE_ONCE(slot->filling, leb);
+	ret = ubi_read(dev->desc, leb, slot->buf, 0, len);
+	if (!ret) {
+		slot->len = len;
+		WRITE_ONCE(slot->leb, leb);
+	}
+	WRITE_ONCE(slot->filling, -1);
+	mutex_unlock(&slot->lock);
+
+	if (!ret) {
+		spin_lock(&dev->stats_lock);
+		dev->stats.ra_fills++;
+		spin_unlock(&dev->stats_lock);
+	}
+}
+
+/* Called once a request is done, @pos and @len in bytes */
+static void ubiblock_ra_update(struct ubiblock *dev, u64 pos, u64 len)
+{
+	bool fetch = false;
+	int leb;
+
+	if (!dev->ra[0].buf)
+		return;
+
+	spin_lock(&dev->ra_lock);
+	if (pos == dev->seq_next)
+		dev->seq_reqs++;
+	else
+		dev->seq_reqs = 0;
+	dev->seq_next = pos + len;
+
+	if (dev->seq_reqs >= UBIBLOCK_RA_SEQ_REQS) {
+		leb = div_u64(dev->seq_next, dev->leb_size);
+		/* once the reader's LEB is cached, keep one LEB ahead of it */
+		if (ubiblock_ra_find(dev, leb))
+			leb++;
+		if (!ubiblock_ra_find(dev, leb)) {
+			dev->ra_want = leb;
+			fetch = true;
+		}
+	}
+	spin_unlock(&dev->ra_lock);
+
+	if (fetch)
+		queue_work(dev->wq, &dev->ra_work);
+}
+
+static void ubiblock_ra_invalidate(struct ubiblock *dev)
+{
+	int i;
+
+	if (!dev->ra[0].buf)
+		return;
+
+	cancel_work_sync(&dev->ra_work);
+	for (i = 0; i < UBIBLOCK_RA_SLOTS; i++) {
+		mutex_lock(&dev->ra[i].lock);
+		dev->ra[i].leb = -1;
+		mutex_unlock(&dev->ra[i].lock);
+	}
+
+	spin_lock(&dev->ra_lock);
+	dev->seq_reqs = 0;
+	spin_unlock(&dev->ra_lock);
+}
+
+static int ubiblock_ra_alloc(struct ubiblock *dev)
+{
+	int i;
+
+	spin_lock_init(&dev->ra_lock);
+	INIT_WORK(&dev->ra_work, ubiblock_ra_work);
+	dev->ra_want = -1;
+
+	for (i = 0; i < UBIBLOCK_RA_SLOTS; i++) {
+		mutex_init(&dev->ra[i].lock);
+		dev->ra[i].leb = -1;
+		dev->ra[i].filling = -1;
+	}
+
+	if (!ubiblock_readahead)
+		return 0;
+
+	for (i = 0; i < UBIBLOCK_RA_SLOTS; i++) {
+		dev->ra[i].buf = vmalloc(dev->leb_size);
+		if (!dev->ra[i].buf)
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void ubiblock_ra_free(struct ubiblock *dev)
+{
+	int i;
+
+	for (i = 0; i < UBIBLOCK_RA_SLOTS; i++)
+		vfree(dev->ra[i].buf);
+}
+
+static int ubiblock_stats_show(struct seq_file *s, void *data)
+{
+	struct ubiblock *dev = s->private;
+	struct ubiblock_stats st;
+
+	spin_lock(&dev->stats_lock);
+	st = dev->stats;
+	spin_unlock(&dev->stats_lock);
+
+	seq_printf(s, "reads:            %llu\n", st.reads);
+	seq_printf(s, "bytes:            %llu\n", st.bytes);
+	seq_printf(s, "ra_hit_bytes:     %llu\n", st.ra_hit_bytes);
+	seq_printf(s, "ra_fills:         %llu\n", st.ra_fills);
+	seq_printf(s, "wait_avg_us:      %llu\n",
+		   st.reads ? div64_u64(st.wait_ns, st.reads) / 1000 : 0);
+	seq_printf(s, "wait_max_us:      %llu\n", st.wait_max_ns / 1000);
+	seq_printf(s, "service_avg_us:   %llu\n",
+		   st.reads ? div64_u64(st.service_ns, st.reads) / 1000 : 0);
+	seq_printf(s, "service_max_us:   %llu\n", st.service_max_ns / 1000);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(ubiblock_stats);
+
 static int ubiblock_read(struct ubiblock_pdu *pdu)
 {
 	int ret, leb, offset, bytes_left, to_read;
@@ -204,9 +461,16 @@ static int ubiblock_read(struct ubiblock_pdu *pdu)
 		if (offset + to_read > dev->leb_size)
 			to_read = dev->leb_size - offset;
 
-		ret = ubi_read_sg(dev->desc, leb, &pdu->usgl, offset, to_read);
-		if (ret < 0)
-			return ret;
+		if (ubiblock_ra_read(dev, &pdu->usgl, leb, offset, to_read)) {
+			spin_lock(&dev->stats_lock);
+			dev->stats.ra_hit_bytes += to_read;
+			spin_unlock(&dev->stats_lock);
+		} else {
+			ret = ubi_read_sg(dev->desc, leb, &pdu->usgl, offset,
+					  to_read);
+			if (ret < 0)
+				return ret;
+		}
 
 		bytes_left -= to_read;
 		to_read = bytes_left;
@@ -266,6 +530,8 @@ static void ubiblock_release(struct gendisk *gd, fmode_t mode)
 	mutex_lock(&dev->dev_mutex);
 	dev->refcnt--;
 	if (dev->refcnt == 0) {
+		/* the volume may be updated before it is opened again */
+		ubiblock_ra_invalidate(dev);
 		ubi_close_volume(dev->desc);
 		dev->desc = NULL;
 	}
@@ -294,7 +560,10 @@ static void ubiblock_do_work(struct work_struct *work)
 	int ret;
 	struct ubiblock_pdu *pdu = container_of(work, struct ubiblock_pdu, work);
 	struct request *req = blk_mq_rq_from_pdu(pdu);
+	struct ubiblock *dev = req->q->queuedata;
+	u64 start, wait, service;
 
+	start = ktime_get_ns();
 	blk_mq_start_request(req);
 
 	/*
@@ -307,6 +576,20 @@ static void ubiblock_do_work(struct work_struct *work)
 	ret = ubiblock_read(pdu);
 	rq_flush_dcache_pages(req);
 
+	wait = start - pdu->queued_ns;
+	service = ktime_get_ns() - start;
+	spin_lock(&dev->stats_lock);
+	dev->stats.reads++;
+	dev->stats.bytes += blk_rq_bytes(req);
+	dev->stats.wait_ns += wait;
+	dev->stats.wait_max_ns = max(dev->stats.wait_max_ns, wait);
+	dev->stats.service_ns += service;
+	dev->stats.service_max_ns = max(dev->stats.service_max_ns, service);
+	spin_unlock(&dev->stats_lock);
+
+	if (!ret)
+		ubiblock_ra_update(dev, blk_rq_pos(req) << 9, blk_rq_bytes(req));
+
 	blk_mq_end_request(req, errno_to_blk_status(ret));
 }
 
@@ -319,6 +602,7 @@ static blk_status_t ubiblock_queue_rq(struct blk_mq_hw_ctx *hctx,
 
 	switch (req_op(req)) {
 	case REQ_OP_READ:
+		pdu->queued_ns = ktime_get_ns();
 		ubi_sgl_init(&pdu->usgl);
 		queue_work(dev->wq, &pdu->work);
 		return BLK_STS_OK;
@@ -389,17 +673,22 @@ int ubiblock_create(struct ubi_volume_info *vi)
 	}
 
 	mutex_init(&dev->dev_mutex);
+	spin_lock_init(&dev->stats_lock);
 
 	dev->ubi_num = vi->ubi_num;
 	dev->vol_id = vi->vol_id;
 	dev->leb_size = vi->usable_leb_size;
 
+	ret = ubiblock_ra_alloc(dev);
+	if (ret)
+		goto out_free_ra;
+
 	/* Initialize the gendisk of this ubiblock device */
 	gd = alloc_disk(1);
 	if (!gd) {
 		pr_err("UBI: block: alloc_disk failed\n");
 		ret = -ENODEV;
-		goto out_free_dev;
+		goto out_free_ra;
 	}
 
 	gd->fops = &ubiblock_ops;
@@ -453,6 +742,9 @@ int ubiblock_create(struct ubi_volume_info *vi)
 
 	list_add_tail(&dev->list, &ubiblock_devices);
 
+	dev->dbg = debugfs_create_file(gd->disk_name, 0444, ubiblock_dbg_root,
+				       dev, &ubiblock_stats_fops);
+
 	/* Must be the last step: anyone can call file ops from now on */
 	add_disk(dev->gd);
 	dev_info(disk_to_dev(dev->gd), "created from ubi%d:%d(%s)",
@@ -468,7 +760,8 @@ int ubiblock_create(struct ubi_volume_info *vi)
 	idr_remove(&ubiblock_minor_idr, gd->first_minor);
 out_put_disk:
 	put_disk(dev->gd);
-out_free_dev:
+out_free_ra:
+	ubiblock_ra_free(dev);
 	kfree(dev);
 out_unlock:
 	mutex_unlock(&devices_mutex);
@@ -480,8 +773,10 @@ static void ubiblock_cleanup(struct ubiblock *dev)
 {
 	/* Stop new requests to arrive */
 	del_gendisk(dev->gd);
+	debugfs_remove(dev->dbg);
 	/* Flush pending work */
 	destroy_workqueue(dev->wq);
+	ubiblock_ra_free(dev);
 	/* Finally destroy the blk queue */
 	blk_cleanup_queue(dev->rq);
 	blk_mq_free_tag_set(&dev->tag_set);
@@ -557,6 +852,7 @@ static int ubiblock_resize(struct ubi_volume_info *vi)
 	mutex_lock(&dev->dev_mutex);
 
 	if (get_capacity(dev->gd) != disk_capacity) {
+		ubiblock_ra_invalidate(dev);
 		set_capacity(dev->gd, disk_capacity);
 		dev_info(disk_to_dev(dev->gd), "resized to %lld bytes",
 			 vi->used_bytes);
@@ -677,6 +973,8 @@ int __init ubiblock_init(void)
 	if (ubiblock_major < 0)
 		return ubiblock_major;
 
+	ubiblock_dbg_root = debugfs_create_dir("ubiblock", NULL);
+
 	/*
 	 * Attach block devices from 'block=' module param.
 	 * Even if one block device in the param list fails to come up,
@@ -696,6 +994,7 @@ int __init ubiblock_init(void)
 err_unreg:
 	unregister_blkdev(ubiblock_major, "ubiblock");
 	ubiblock_remove_all();
+	debugfs_remove_recursive(ubiblock_dbg_root);
 	return ret;
 }
 
@@ -703,5 +1002,6 @@ void __exit ubiblock_exit(void)
 {
 	ubi_unregister_volume_notifier(&ubiblock_notifier);
 	ubiblock_remove_all();
+	debugfs_remove_recursive(ubiblock_dbg_root);
 	unregister_blkdev(ubiblock_major, "ubiblock");
 }
@@ -42,6 +42,8 @@ struct rk_gmac_ops {
 	void (*set_clock_selection)(struct rk_priv_data *bsp_priv, bool input,
 				    bool enable);
 	void (*integrated_phy_power)(struct rk_priv_data *bsp_priv, bool up);
+	/* TSO is used when the IP also reports it in HW feature 1 */
+	bool tso_en;
 };
 
 struct rk_priv_data {
@@ -80,6 +82,12 @@ struct rk_priv_data {
 
 	unsigned char otp_data;
 	unsigned int bgs_increment;
+
+	/* integrated PHY powered from probe, ahead of the first open */
+	bool phy_early_power;
+	bool phy_powered;
+	struct mutex phy_power_lock; /* phy_powered */
+	struct work_struct phy_power_work;
 };
 
 /* XPCS */
@@ -2068,6 +2076,7 @@ static const struct rk_gmac_ops rv1106_ops = {
 	.set_to_rmii = rv1106_set_to_rmii,
 	.set_rmii_speed = rv1106_set_rmii_speed,
 	.integrated_phy_power = rv1106_integrated_sphy_power,
+	.tso_en = true,
 };
 
 #define RV1108_GRF_GMAC_CON0		0X0900
@@ -2529,6 +2538,10 @@ static struct rk_priv_data *rk_gmac_setup(struct platform_device *pdev,
 				bsp_priv->phy_reset = NULL;
 			}
 
+			bsp_priv->phy_early_power =
+				of_property_read_bool(dev->of_node,
+						      "rockchip,phy-early-power");
+
 			if (of_property_read_u32(plat->phy_node, "bgs,increment",
 						 &bsp_priv->bgs_increment)) {
 				bsp_priv->bgs_increment = 0;
@@ -2672,11 +2685,30 @@ static int rk_integrated_phy_power(void *priv, bool up)
 	    !bsp_priv->ops->integrated_phy_power)
 		return 0;
 
-	bsp_priv->ops->integrated_phy_power(bsp_priv, up);
+	mutex_lock(&bsp_priv->phy_power_lock);
+	if (bsp_priv->phy_powered != up) {
+		bsp_priv->ops->integrated_phy_power(bsp_priv, up);
+		bsp_priv->phy_powered = up;
+	}
+	mutex_unlock(&bsp_priv->phy_power_lock);
 
 	return 0;
 }
 
+/*
+ * The power up sequence of the integrated PHY sleeps for more than 60ms and
+ * autonegotiation only starts after it. Run it from probe in the background,
+ * so by the time the interface is opened the PHY is ready and the open only
+ * has to start the negotiation.
+ */
+static void rk_integrated_phy_power_work(struct work_struct *work)
+{
+	struct rk_priv_data *bsp_priv = container_of(work, struct rk_priv_data,
+						     phy_power_work);
+
+	rk_integrated_phy_power(bsp_priv, true);
+}
+
 void dwmac_rk_set_rgmii_delayline(struct stmmac_priv *priv,
 				  int tx_delay, int rx_delay)
 {
@@ -2757,6 +2789,7 @@ static int rk_gmac_probe(struct platform_device *pdev)
 	struct plat_stmmacenet_data *plat_dat;
 	struct stmmac_resources stmmac_res;
 	const struct rk_gmac_ops *data;
+	struct rk_priv_data *bsp_priv;
 	int ret;
 
 	data = of_device_get_match_data(&pdev->dev);
@@ -2777,6 +2810,8 @@ static int rk_gmac_probe(struct platform_device *pdev)
 		plat_dat->has_gmac = true;
 
 	plat_dat->sph_disable = true;
+	if (data->tso_en)
+		plat_dat->tso_en = true;
 	plat_dat->fix_mac_speed = rk_fix_speed;
 	plat_dat->get_eth_addr = rk_get_eth_addr;
 	plat_dat->integrated_phy_power = rk_integrated_phy_power;
@@ -2795,6 +2830,10 @@ static int rk_gmac_probe(struct platform_device *pdev)
 	if (ret)
 		goto err_remove_config_dt;
 
+	bsp_priv = plat_dat->bsp_priv;
+	mutex_init(&bsp_priv->phy_power_lock);
+	INIT_WORK(&bsp_priv->phy_power_work, rk_integrated_phy_power_work);
+
 	ret = stmmac_dvr_probe(&pdev->dev, plat_dat, &stmmac_res);
 	if (ret)
 		goto err_gmac_powerdown;
@@ -2803,6 +2842,9 @@ static int rk_gmac_probe(struct platform_device *pdev)
 	if (ret)
 		goto err_gmac_powerdown;
 
+	if (bsp_priv->integrated_phy && bsp_priv->phy_early_power)
+		queue_work(system_unbound_wq, &bsp_priv->phy_power_work);
+
 	return 0;
 
 err_gmac_powerdown:
@@ -2816,7 +2858,11 @@ static int rk_gmac_probe(struct platform_device *pdev)
 static int rk_gmac_remove(struct platform_device *pdev)
 {
 	struct rk_priv_data *bsp_priv = get_stmmac_bsp_priv(&pdev->dev);
-	int ret = stmmac_dvr_remove(&pdev->dev);
+	int ret;
+
+	cancel_work_sync(&bsp_priv->phy_power_work);
+	ret = stmmac_dvr_remove(&pdev->dev);
+	rk_integrated_phy_power(bsp_priv, false);
 
 	rk_gmac_powerdown(bsp_priv);
 	dwmac_rk_remove_loopback_sysfs(&pdev->dev);
@@ -2832,6 +2878,9 @@ static int rk_gmac_suspend(struct device *dev)
 
 	/* Keep the PHY up if we use Wake-on-Lan. */
 	if (!device_may_wakeup(dev)) {
+		/* powered early, but the interface was never opened */
+		cancel_work_sync(&bsp_priv->phy_power_work);
+		rk_integrated_phy_power(bsp_priv, false);
 		rk_gmac_powerdown(bsp_priv);
 		bsp_priv->suspended = true;
 	}
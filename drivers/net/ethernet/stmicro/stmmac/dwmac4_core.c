@@ -229,6 +229,21 @@ static void dwmac4_map_mtl_dma(struct mac_device_info *hw, u32 queue, u32 chan)
 		writel(value, ioaddr + MTL_RXQ_DMA_MAP1);
 }
 
+static void dwmac4_set_mtl_dyn_dma(struct mac_device_info *hw, u32 queue,
+				   bool en)
+{
+	void __iomem *ioaddr = hw->pcsr;
+	u32 reg = queue < 4 ? MTL_RXQ_DMA_MAP0 : MTL_RXQ_DMA_MAP1;
+	u32 value;
+
+	value = readl(ioaddr + reg);
+	if (en)
+		value |= MTL_RXQ_DMA_QXDDMACH(queue % 4);
+	else
+		value &= ~MTL_RXQ_DMA_QXDDMACH(queue % 4);
+	writel(value, ioaddr + reg);
+}
+
 static void dwmac4_config_cbs(struct mac_device_info *hw,
 			      u32 send_slope, u32 idle_slope,
 			      u32 high_credit, u32 low_credit, u32 queue)
@@ -1148,6 +1163,26 @@ static int dwmac4_config_l4_filter(struct mac_device_info *hw, u32 filter_no,
 	return 0;
 }
 
+/*
+ * Route the packets passed by an L3/L4 filter to @chan. Only effective
+ * on RX queues switched to dynamic DMA channel selection.
+ */
+static int dwmac4_config_l3l4_dma(struct mac_device_info *hw, u32 filter_no,
+				  bool en, u32 chan)
+{
+	void __iomem *ioaddr = hw->pcsr;
+	u32 value;
+
+	value = readl(ioaddr + GMAC_L3L4_CTRL(filter_no));
+	value &= ~(GMAC_DMCHEN0 | GMAC_DMCHN0);
+	if (en)
+		value |= GMAC_DMCHEN0 |
+			 ((chan << GMAC_DMCHN0_SHIFT) & GMAC_DMCHN0);
+	writel(value, ioaddr + GMAC_L3L4_CTRL(filter_no));
+
+	return 0;
+}
+
 #ifdef CONFIG_STMMAC_FULL
 const struct stmmac_ops dwmac4_ops = {
 	.core_init = dwmac4_core_init,
@@ -1203,6 +1238,7 @@ const struct stmmac_ops dwmac410_ops = {
 	.prog_mtl_tx_algorithms = dwmac4_prog_mtl_tx_algorithms,
 	.set_mtl_tx_queue_weight = dwmac4_set_mtl_tx_queue_weight,
 	.map_mtl_to_dma = dwmac4_map_mtl_dma,
+	.set_mtl_dyn_dma = dwmac4_set_mtl_dyn_dma,
 	.config_cbs = dwmac4_config_cbs,
 	.dump_regs = dwmac4_dump_regs,
 	.host_irq_status = dwmac4_irq_status,
@@ -1230,6 +1266,7 @@ const struct stmmac_ops dwmac410_ops = {
 	.set_arp_offload = dwmac4_set_arp_offload,
 	.config_l3_filter = dwmac4_config_l3_filter,
 	.config_l4_filter = dwmac4_config_l4_filter,
+	.config_l3l4_dma = dwmac4_config_l3l4_dma,
 #ifdef CONFIG_STMMAC_FULL
 	.est_configure = dwmac5_est_configure,
 	.fpe_configure = dwmac5_fpe_configure,
@@ -1252,6 +1289,7 @@ const struct stmmac_ops dwmac510_ops = {
 	.prog_mtl_tx_algorithms = dwmac4_prog_mtl_tx_algorithms,
 	.set_mtl_tx_queue_weight = dwmac4_set_mtl_tx_queue_weight,
 	.map_mtl_to_dma = dwmac4_map_mtl_dma,
+	.set_mtl_dyn_dma = dwmac4_set_mtl_dyn_dma,
 	.config_cbs = dwmac4_config_cbs,
 	.dump_regs = dwmac4_dump_regs,
 	.host_irq_status = dwmac4_irq_status,
@@ -1281,6 +1319,7 @@ const struct stmmac_ops dwmac510_ops = {
 	.set_arp_offload = dwmac4_set_arp_offload,
 	.config_l3_filter = dwmac4_config_l3_filter,
 	.config_l4_filter = dwmac4_config_l4_filter,
+	.config_l3l4_dma = dwmac4_config_l3l4_dma,
 	.est_configure = dwmac5_est_configure,
 	.fpe_configure = dwmac5_fpe_configure,
 	.add_hw_vlan_rx_fltr = dwmac4_add_hw_vlan_rx_fltr,
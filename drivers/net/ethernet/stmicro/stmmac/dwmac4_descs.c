@@ -8,6 +8,7 @@
  * Author: Alexandre Torgue <alexandre.torgue@st.com>
  */
 
+#include <linux/delay.h>
 #include <linux/stmmac.h>
 #include "common.h"
 #include "dwmac4.h"
@@ -274,16 +275,23 @@ static int dwmac4_wrback_get_rx_timestamp_status(void *desc, void *next_desc,
 		if (likely(le32_to_cpu(p->des1) & RDES1_TIMESTAMP_AVAILABLE)) {
 			int i = 0;
 
-			/* Check if timestamp is OK from context descriptor */
+			/* Check if timestamp is OK from context descriptor,
+			 * its write-back may trail the normal descriptor by
+			 * a few bus cycles.
+			 */
 			do {
 				ret = dwmac4_rx_check_timestamp(next_desc);
 				if (ret < 0)
 					goto exit;
+				if (ret == 1) {
+					udelay(1);
+					dma_rmb();
+				}
 				i++;
 
 			} while ((ret == 1) && (i < 10));
 
-			if (i == 10)
+			if (ret == 1)
 				ret = -EBUSY;
 		}
 	}
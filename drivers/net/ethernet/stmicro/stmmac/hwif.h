@@ -312,6 +312,8 @@ struct stmmac_ops {
 					u32 weight, u32 queue);
 	/* RX MTL queue to RX dma mapping */
 	void (*map_mtl_to_dma)(struct mac_device_info *hw, u32 queue, u32 chan);
+	/* Let the MAC filters pick the DMA channel of an RX queue */
+	void (*set_mtl_dyn_dma)(struct mac_device_info *hw, u32 queue, bool en);
 	/* Configure AV Algorithm */
 	void (*config_cbs)(struct mac_device_info *hw, u32 send_slope,
 			   u32 idle_slope, u32 high_credit, u32 low_credit,
@@ -389,6 +391,8 @@ struct stmmac_ops {
 	int (*config_l4_filter)(struct mac_device_info *hw, u32 filter_no,
 				bool en, bool udp, bool sa, bool inv,
 				u32 match);
+	int (*config_l3l4_dma)(struct mac_device_info *hw, u32 filter_no,
+			       bool en, u32 chan);
 	void (*set_arp_offload)(struct mac_device_info *hw, bool en, u32 addr);
 	int (*est_configure)(void __iomem *ioaddr, struct stmmac_est *cfg,
 			     unsigned int ptp_rate);
@@ -418,6 +422,8 @@ struct stmmac_ops {
 	stmmac_do_void_callback(__priv, mac, set_mtl_tx_queue_weight, __args)
 #define stmmac_map_mtl_to_dma(__priv, __args...) \
 	stmmac_do_void_callback(__priv, mac, map_mtl_to_dma, __args)
+#define stmmac_set_mtl_dyn_dma(__priv, __args...) \
+	stmmac_do_void_callback(__priv, mac, set_mtl_dyn_dma, __args)
 #define stmmac_config_cbs(__priv, __args...) \
 	stmmac_do_void_callback(__priv, mac, config_cbs, __args)
 #define stmmac_dump_mac_regs(__priv, __args...) \
@@ -484,6 +490,8 @@ struct stmmac_ops {
 	stmmac_do_callback(__priv, mac, config_l3_filter, __args)
 #define stmmac_config_l4_filter(__priv, __args...) \
 	stmmac_do_callback(__priv, mac, config_l4_filter, __args)
+#define stmmac_config_l3l4_dma(__priv, __args...) \
+	stmmac_do_callback(__priv, mac, config_l3l4_dma, __args)
 #define stmmac_set_arp_offload(__priv, __args...) \
 	stmmac_do_void_callback(__priv, mac, set_arp_offload, __args)
 #define stmmac_est_configure(__priv, __args...) \
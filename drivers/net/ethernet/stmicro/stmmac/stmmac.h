@@ -13,6 +13,7 @@
 #define DRV_MODULE_VERSION	"Jan_2016"
 
 #include <linux/clk.h>
+#include <linux/dim.h>
 #include <linux/if_vlan.h>
 #include <linux/stmmac.h>
 #include <linux/phylink.h>
@@ -22,6 +23,7 @@
 #include <linux/net_tstamp.h>
 #include <linux/reset.h>
 #include <net/page_pool.h>
+#include <net/xdp.h>
 
 struct stmmac_resources {
 	void __iomem *addr;
@@ -31,12 +33,19 @@ struct stmmac_resources {
 	int irq;
 };
 
+enum stmmac_txbuf_type {
+	STMMAC_TXBUF_T_SKB,
+	STMMAC_TXBUF_T_XDP_TX,
+	STMMAC_TXBUF_T_XDP_NDO,
+};
+
 struct stmmac_tx_info {
 	dma_addr_t buf;
 	bool map_as_page;
 	unsigned len;
 	bool last_segment;
 	bool is_jumbo;
+	enum stmmac_txbuf_type buf_type;
 };
 
 #define STMMAC_TBS_AVAIL	BIT(0)
@@ -53,6 +62,7 @@ struct stmmac_tx_queue {
 	struct dma_edesc *dma_entx;
 	struct dma_desc *dma_tx;
 	struct sk_buff **tx_skbuff;
+	struct xdp_frame **xdpf;
 	struct stmmac_tx_info *tx_skbuff_dma;
 	unsigned int cur_tx;
 	unsigned int dirty_tx;
@@ -64,6 +74,7 @@ struct stmmac_tx_queue {
 struct stmmac_rx_buffer {
 	struct page *page;
 	struct page *sec_page;
+	unsigned int page_offset;
 	dma_addr_t addr;
 	dma_addr_t sec_addr;
 };
@@ -72,6 +83,7 @@ struct stmmac_rx_queue {
 	u32 rx_count_frames;
 	u32 queue_index;
 	struct page_pool *page_pool;
+	struct xdp_rxq_info xdp_rxq;
 	struct stmmac_rx_buffer *buf_pool;
 	struct stmmac_priv *priv_data;
 	struct dma_extended_desc *dma_erx;
@@ -95,6 +107,28 @@ struct stmmac_channel {
 	struct stmmac_priv *priv_data;
 	spinlock_t lock;
 	u32 index;
+
+	/* Adaptive interrupt moderation, sampled on NAPI completion */
+	struct dim rx_dim;
+	struct dim tx_dim;
+	u16 rx_dim_events;
+	u16 tx_dim_events;
+	u64 rx_dim_packets;
+	u64 rx_dim_bytes;
+	u64 tx_dim_packets;
+	u64 tx_dim_bytes;
+	u32 rx_dim_riwt;
+	struct dim_cq_moder tx_dim_moder;
+
+	/* RX NAPI polled by this thread instead of NET_RX, see rx_thread */
+	struct task_struct *rx_thread;
+	unsigned long rx_thread_sched;
+
+	/* IRQ to RX NAPI latency, only sampled by the loopback benchmark */
+	u64 bench_irq_ns;
+	u64 bench_lat_ns;
+	u64 bench_lat_max_ns;
+	u32 bench_lat_cnt;
 };
 
 struct stmmac_tc_entry {
@@ -135,6 +169,7 @@ struct stmmac_rss {
 };
 
 #define STMMAC_FLOW_ACTION_DROP		BIT(0)
+#define STMMAC_FLOW_ACTION_QUEUE	BIT(1)
 struct stmmac_flow_entry {
 	unsigned long cookie;
 	unsigned long action;
@@ -142,6 +177,7 @@ struct stmmac_flow_entry {
 	int in_use;
 	int idx;
 	int is_l4;
+	u32 queue;
 };
 
 struct stmmac_priv {
@@ -155,6 +191,7 @@ struct stmmac_priv {
 	bool tx_path_in_lpi_mode;
 	bool tso;
 	int sph;
+	int sph_cap;
 	u32 sarc_type;
 
 	unsigned int dma_buf_sz;
@@ -218,6 +255,12 @@ struct stmmac_priv {
 	u32 systime_flags;
 	u32 adv_ts;
 	int use_riwt;
+	bool rx_dim_enabled;
+	bool tx_dim_enabled;
+	/* Loopback benchmark selftest running, see stmmac_test_bench() */
+	bool bench;
+	/* DMA channels lent to stmmac_uio, left alone by the stack */
+	unsigned long uio_chans;
 	int irq_wake;
 	spinlock_t ptp_lock;
 	void __iomem *mmcaddr;
@@ -232,6 +275,13 @@ struct stmmac_priv {
 	struct workqueue_struct *wq;
 	struct work_struct service_task;
 
+	/* RX ring pages given back to the system while the link is down */
+	struct shrinker rx_shrinker;
+	struct delayed_work rx_release_work;
+	struct mutex rx_release_lock;
+	bool rx_link_up;
+	bool rx_released;
+
 	/* TC Handling */
 	unsigned int tc_entries_max;
 	unsigned int tc_off_max;
@@ -244,6 +294,9 @@ struct stmmac_priv {
 
 	/* Receive Side Scaling */
 	struct stmmac_rss rss;
+
+	/* XDP BPF Program */
+	struct bpf_prog *xdp_prog;
 };
 
 enum stmmac_state {
@@ -253,6 +306,19 @@ enum stmmac_state {
 	STMMAC_SERVICE_SCHED,
 };
 
+static inline bool stmmac_xdp_is_enabled(struct stmmac_priv *priv)
+{
+	return !!priv->xdp_prog;
+}
+
+static inline unsigned int stmmac_rx_offset(struct stmmac_priv *priv)
+{
+	if (stmmac_xdp_is_enabled(priv))
+		return XDP_PACKET_HEADROOM;
+
+	return 0;
+}
+
 int stmmac_mdio_unregister(struct net_device *ndev);
 int stmmac_mdio_register(struct net_device *ndev);
 int stmmac_mdio_reset(struct mii_bus *mii);
@@ -279,6 +345,8 @@ bool stmmac_eee_init(struct stmmac_priv *priv);
 int stmmac_reinit_queues(struct net_device *dev, u32 rx_cnt, u32 tx_cnt);
 int stmmac_reinit_ringparam(struct net_device *dev, u32 rx_size, u32 tx_size);
 int stmmac_bus_clks_config(struct stmmac_priv *priv, bool enabled);
+u32 stmmac_usec2riwt(u32 usec, struct stmmac_priv *priv);
+u32 stmmac_riwt2usec(u32 riwt, struct stmmac_priv *priv);
 
 #if IS_ENABLED(CONFIG_STMMAC_SELFTESTS)
 void stmmac_selftest_run(struct net_device *dev,
@@ -18,6 +18,7 @@
 #include <linux/kernel.h>
 #include <linux/interrupt.h>
 #include <linux/ip.h>
+#include <linux/kthread.h>
 #include <linux/tcp.h>
 #include <linux/skbuff.h>
 #include <linux/ethtool.h>
@@ -38,6 +39,7 @@
 #include <linux/net_tstamp.h>
 #include <linux/phylink.h>
 #include <linux/udp.h>
+#include <linux/bpf_trace.h>
 #include <net/pkt_cls.h>
 #include "stmmac_ptp.h"
 #include "stmmac.h"
@@ -74,6 +76,12 @@ MODULE_PARM_DESC(phyaddr, "Physical device address");
 #define STMMAC_TX_THRESH(x)	((x)->dma_tx_size / 4)
 #define STMMAC_RX_THRESH(x)	((x)->dma_rx_size / 4)
 
+/* XDP verdicts, as seen by the RX loop */
+#define STMMAC_XDP_PASS		0
+#define STMMAC_XDP_CONSUMED	BIT(0)
+#define STMMAC_XDP_TX		BIT(1)
+#define STMMAC_XDP_REDIRECT	BIT(2)
+
 static int flow_ctrl = FLOW_AUTO;
 module_param(flow_ctrl, int, 0644);
 MODULE_PARM_DESC(flow_ctrl, "Flow control ability [on/off]");
@@ -111,6 +119,17 @@ static unsigned int chain_mode;
 module_param(chain_mode, int, 0444);
 MODULE_PARM_DESC(chain_mode, "To use chain instead of ring mode");
 
+/* A NET_RX burst can hold off the wakeup of an audio thread for
+ * milliseconds on a single core. In a thread the RX poll is preempted
+ * between budgets instead, and its priority can be tuned with chrt.
+ */
+#define STMMAC_RX_SOFTIRQ	0
+#define STMMAC_RX_THREAD	1
+#define STMMAC_RX_THREAD_FIFO	2
+static int rx_thread = STMMAC_RX_SOFTIRQ;
+module_param(rx_thread, int, 0444);
+MODULE_PARM_DESC(rx_thread, "RX NAPI in kthread stmmac<bus>-rx<q>: 0 off (softirq), 1 SCHED_NORMAL, 2 lowest SCHED_FIFO");
+
 static irqreturn_t stmmac_interrupt(int irq, void *dev_id);
 
 #ifdef CONFIG_DEBUG_FS
@@ -119,6 +138,8 @@ static void stmmac_init_fs(struct net_device *dev);
 static void stmmac_exit_fs(struct net_device *dev);
 #endif
 
+static int stmmac_rx_restore(struct stmmac_priv *priv);
+
 #define STMMAC_COAL_TIMER(x) (jiffies + usecs_to_jiffies(x))
 
 int stmmac_bus_clks_config(struct stmmac_priv *priv, bool enabled)
@@ -183,6 +204,16 @@ static void stmmac_disable_all_queues(struct stmmac_priv *priv)
 		if (queue < tx_queues_cnt)
 			napi_disable(&ch->tx_napi);
 	}
+
+	/* No more samples can arrive, let queued moderation updates finish */
+	for (queue = 0; queue < maxq; queue++) {
+		struct stmmac_channel *ch = &priv->channel[queue];
+
+		if (queue < rx_queues_cnt)
+			cancel_work_sync(&ch->rx_dim.work);
+		if (queue < tx_queues_cnt)
+			cancel_work_sync(&ch->tx_dim.work);
+	}
 }
 
 /**
@@ -957,6 +988,40 @@ static void stmmac_mac_link_down(struct phylink_config *config,
 	priv->tx_lpi_enabled = false;
 	stmmac_eee_init(priv);
 	stmmac_set_eee_pls(priv, priv->hw, false);
+
+	mutex_lock(&priv->rx_release_lock);
+	priv->rx_link_up = false;
+	mutex_unlock(&priv->rx_release_lock);
+}
+
+/**
+ * stmmac_bql_set_limits - size BQL for the negotiated speed
+ * @priv: driver private structure
+ * @speed: link speed in Mbps
+ * Description: completions arrive at most every tx_coal_timer usecs, so
+ * BQL must let at least that much line time be in flight or the queue
+ * starves between cleanings while the algorithm ramps up.
+ */
+static void stmmac_bql_set_limits(struct stmmac_priv *priv, int speed)
+{
+#ifdef CONFIG_BQL
+	u32 tx_cnt = priv->plat->tx_queues_to_use;
+	unsigned int min_limit;
+	u64 bytes;
+	u32 queue;
+
+	/* Mbps * usecs = bits */
+	bytes = (u64)speed * priv->tx_coal_timer / BITS_PER_BYTE;
+	min_limit = clamp_t(u64, bytes, 2 * ETH_FRAME_LEN,
+			    priv->dma_tx_size * ETH_FRAME_LEN / 2);
+
+	for (queue = 0; queue < tx_cnt; queue++) {
+		struct netdev_queue *txq = netdev_get_tx_queue(priv->dev,
+							       queue);
+
+		txq->dql.min_limit = min_limit;
+	}
+#endif
 }
 
 static void stmmac_mac_link_up(struct phylink_config *config,
@@ -1033,6 +1098,7 @@ static void stmmac_mac_link_up(struct phylink_config *config,
 	}
 
 	priv->speed = speed;
+	stmmac_bql_set_limits(priv, speed);
 
 	if (priv->plat->fix_mac_speed)
 		priv->plat->fix_mac_speed(priv->plat->bsp_priv, speed);
@@ -1056,6 +1122,13 @@ static void stmmac_mac_link_up(struct phylink_config *config,
 
 	writel(ctrl, priv->ioaddr + MAC_CTRL_REG);
 
+	/* Repopulate RX rings the shrinker emptied, retrying if short */
+	mutex_lock(&priv->rx_release_lock);
+	priv->rx_link_up = true;
+	if (stmmac_rx_restore(priv))
+		queue_delayed_work(priv->wq, &priv->rx_release_work, HZ / 10);
+	mutex_unlock(&priv->rx_release_lock);
+
 	stmmac_mac_set(priv, priv->ioaddr, true);
 	if (phy && priv->dma_cap.eee) {
 		priv->eee_active = phy_init_eee(phy, 1) >= 0;
@@ -1363,7 +1436,8 @@ static int stmmac_init_rx_buffers(struct stmmac_priv *priv, struct dma_desc *p,
 		stmmac_set_desc_sec_addr(priv, p, buf->sec_addr, false);
 	}
 
-	buf->addr = page_pool_get_dma_addr(buf->page);
+	buf->page_offset = stmmac_rx_offset(priv);
+	buf->addr = page_pool_get_dma_addr(buf->page) + buf->page_offset;
 	stmmac_set_desc_addr(priv, p, buf->addr);
 	if (priv->dma_buf_sz == BUF_SIZE_16KiB)
 		stmmac_init_desc3(priv, p);
@@ -1401,7 +1475,9 @@ static void stmmac_free_tx_buffer(struct stmmac_priv *priv, u32 queue, int i)
 {
 	struct stmmac_tx_queue *tx_q = &priv->tx_queue[queue];
 
-	if (tx_q->tx_skbuff_dma[i].buf) {
+	/* XDP_TX frames still belong to the RX page pool mapping */
+	if (tx_q->tx_skbuff_dma[i].buf &&
+	    tx_q->tx_skbuff_dma[i].buf_type != STMMAC_TXBUF_T_XDP_TX) {
 		if (tx_q->tx_skbuff_dma[i].map_as_page)
 			dma_unmap_page(priv->device,
 				       tx_q->tx_skbuff_dma[i].buf,
@@ -1414,6 +1490,13 @@ static void stmmac_free_tx_buffer(struct stmmac_priv *priv, u32 queue, int i)
 					 DMA_TO_DEVICE);
 	}
 
+	if (tx_q->xdpf[i]) {
+		xdp_return_frame(tx_q->xdpf[i]);
+		tx_q->xdpf[i] = NULL;
+		tx_q->tx_skbuff_dma[i].buf = 0;
+		tx_q->tx_skbuff_dma[i].buf_type = STMMAC_TXBUF_T_SKB;
+	}
+
 	if (tx_q->tx_skbuff[i]) {
 		dev_kfree_skb_any(tx_q->tx_skbuff[i]);
 		tx_q->tx_skbuff[i] = NULL;
@@ -1651,6 +1734,9 @@ static void free_dma_rx_desc_resources(struct stmmac_priv *priv)
 					  sizeof(struct dma_extended_desc),
 					  rx_q->dma_erx, rx_q->dma_rx_phy);
 
+		if (xdp_rxq_info_is_reg(&rx_q->xdp_rxq))
+			xdp_rxq_info_unreg(&rx_q->xdp_rxq);
+
 		kfree(rx_q->buf_pool);
 		if (rx_q->page_pool)
 			page_pool_destroy(rx_q->page_pool);
@@ -1692,6 +1778,7 @@ static void free_dma_tx_desc_resources(struct stmmac_priv *priv)
 
 		kfree(tx_q->tx_skbuff_dma);
 		kfree(tx_q->tx_skbuff);
+		kfree(tx_q->xdpf);
 	}
 }
 
@@ -1720,12 +1807,16 @@ static int alloc_dma_rx_desc_resources(struct stmmac_priv *priv)
 
 		pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
 		pp_params.pool_size = priv->dma_rx_size;
-		num_pages = DIV_ROUND_UP(priv->dma_buf_sz, PAGE_SIZE);
+		num_pages = DIV_ROUND_UP(priv->dma_buf_sz + stmmac_rx_offset(priv),
+					 PAGE_SIZE);
 		pp_params.order = ilog2(num_pages);
 		pp_params.nid = dev_to_node(priv->device);
 		pp_params.dev = priv->device;
-		pp_params.dma_dir = DMA_FROM_DEVICE;
-		pp_params.max_len = num_pages * PAGE_SIZE;
+		/* XDP_TX sends received pages back out without remapping */
+		pp_params.dma_dir = stmmac_xdp_is_enabled(priv) ?
+				    DMA_BIDIRECTIONAL : DMA_FROM_DEVICE;
+		pp_params.offset = stmmac_rx_offset(priv);
+		pp_params.max_len = num_pages * PAGE_SIZE - pp_params.offset;
 
 		rx_q->page_pool = page_pool_create(&pp_params);
 		if (IS_ERR(rx_q->page_pool)) {
@@ -1734,6 +1825,17 @@ static int alloc_dma_rx_desc_resources(struct stmmac_priv *priv)
 			goto err_dma;
 		}
 
+		ret = xdp_rxq_info_reg(&rx_q->xdp_rxq, priv->dev, queue);
+		if (ret)
+			goto err_dma;
+
+		ret = xdp_rxq_info_reg_mem_model(&rx_q->xdp_rxq,
+						 MEM_TYPE_PAGE_POOL,
+						 rx_q->page_pool);
+		if (ret)
+			goto err_dma;
+		ret = -ENOMEM;
+
 		rx_q->buf_pool = kcalloc(priv->dma_rx_size,
 					 sizeof(*rx_q->buf_pool),
 					 GFP_KERNEL);
@@ -1803,6 +1905,12 @@ static int alloc_dma_tx_desc_resources(struct stmmac_priv *priv)
 		if (!tx_q->tx_skbuff)
 			goto err_dma;
 
+		tx_q->xdpf = kcalloc(priv->dma_tx_size,
+				     sizeof(struct xdp_frame *),
+				     GFP_KERNEL);
+		if (!tx_q->xdpf)
+			goto err_dma;
+
 		if (priv->extend_desc)
 			size = sizeof(struct dma_extended_desc);
 		else if (tx_q->tbs & STMMAC_TBS_AVAIL)
@@ -2041,9 +2149,12 @@ static void stmmac_dma_operation_mode(struct stmmac_priv *priv)
  * @priv: driver private structure
  * @budget: napi budget limiting this functions packet handling
  * @queue: TX queue index
+ * @napi_budget: budget of the calling NAPI poll, 0 from netpoll
  * Description: it reclaims the transmit resources after transmission completes.
+ * Freed skbs go to the per-CPU NAPI cache and are released in bulk.
  */
-static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue)
+static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue,
+			   int napi_budget)
 {
 	struct stmmac_tx_queue *tx_q = &priv->tx_queue[queue];
 	unsigned int bytes_compl = 0, pkts_compl = 0;
@@ -2074,6 +2185,10 @@ static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue)
 
 		count++;
 
+		/* Descriptors are coherent memory, warm up the next skb instead */
+		prefetch(tx_q->tx_skbuff[STMMAC_GET_ENTRY(entry,
+							  priv->dma_tx_size)]);
+
 		/* Make sure descriptor fields are read after reading
 		 * the own bit.
 		 */
@@ -2091,7 +2206,9 @@ static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue)
 			stmmac_get_tx_hwtstamp(priv, p, skb);
 		}
 
-		if (likely(tx_q->tx_skbuff_dma[entry].buf)) {
+		if (likely(tx_q->tx_skbuff_dma[entry].buf &&
+			   tx_q->tx_skbuff_dma[entry].buf_type !=
+			   STMMAC_TXBUF_T_XDP_TX)) {
 			if (tx_q->tx_skbuff_dma[entry].map_as_page)
 				dma_unmap_page(priv->device,
 					       tx_q->tx_skbuff_dma[entry].buf,
@@ -2112,10 +2229,17 @@ static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue)
 		tx_q->tx_skbuff_dma[entry].last_segment = false;
 		tx_q->tx_skbuff_dma[entry].is_jumbo = false;
 
+		if (tx_q->xdpf[entry]) {
+			xdp_return_frame(tx_q->xdpf[entry]);
+			tx_q->xdpf[entry] = NULL;
+			tx_q->tx_skbuff_dma[entry].buf = 0;
+			tx_q->tx_skbuff_dma[entry].buf_type = STMMAC_TXBUF_T_SKB;
+		}
+
 		if (likely(skb != NULL)) {
 			pkts_compl++;
 			bytes_compl += skb->len;
-			dev_consume_skb_any(skb);
+			napi_consume_skb(skb, napi_budget);
 			tx_q->tx_skbuff[entry] = NULL;
 		}
 
@@ -2128,6 +2252,9 @@ static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue)
 	netdev_tx_completed_queue(netdev_get_tx_queue(priv->dev, queue),
 				  pkts_compl, bytes_compl);
 
+	priv->channel[queue].tx_dim_packets += pkts_compl;
+	priv->channel[queue].tx_dim_bytes += bytes_compl;
+
 	if (unlikely(netif_tx_queue_stopped(netdev_get_tx_queue(priv->dev,
 								queue))) &&
 	    stmmac_tx_avail(priv, queue) > STMMAC_TX_THRESH(priv)) {
@@ -2235,10 +2362,17 @@ static int stmmac_napi_check(struct stmmac_priv *priv, u32 chan)
 
 	if ((status & handle_rx) && (chan < priv->plat->rx_queues_to_use)) {
 		if (napi_schedule_prep(&ch->rx_napi)) {
+			if (unlikely(priv->bench))
+				ch->bench_irq_ns = ktime_get_ns();
 			spin_lock_irqsave(&ch->lock, flags);
 			stmmac_disable_dma_irq(priv, priv->ioaddr, chan, 1, 0);
 			spin_unlock_irqrestore(&ch->lock, flags);
-			__napi_schedule(&ch->rx_napi);
+			if (ch->rx_thread) {
+				set_bit(0, &ch->rx_thread_sched);
+				wake_up_process(ch->rx_thread);
+			} else {
+				__napi_schedule(&ch->rx_napi);
+			}
 		}
 	}
 
@@ -2274,8 +2408,12 @@ static void stmmac_dma_interrupt(struct stmmac_priv *priv)
 	if (WARN_ON_ONCE(channels_to_check > ARRAY_SIZE(status)))
 		channels_to_check = ARRAY_SIZE(status);
 
-	for (chan = 0; chan < channels_to_check; chan++)
-		status[chan] = stmmac_napi_check(priv, chan);
+	for (chan = 0; chan < channels_to_check; chan++) {
+		if (test_bit(chan, &priv->uio_chans))
+			status[chan] = 0;
+		else
+			status[chan] = stmmac_napi_check(priv, chan);
+	}
 
 	for (chan = 0; chan < tx_channel_count; chan++) {
 		if (unlikely(status[chan] & tx_hard_error_bump_tc)) {
@@ -2482,6 +2620,100 @@ static void stmmac_init_coalesce(struct stmmac_priv *priv)
 	}
 }
 
+u32 stmmac_usec2riwt(u32 usec, struct stmmac_priv *priv)
+{
+	unsigned long clk = clk_get_rate(priv->plat->stmmac_clk);
+
+	if (!clk) {
+		clk = priv->plat->clk_ref_rate;
+		if (!clk)
+			return 0;
+	}
+
+	return (usec * (clk / 1000000)) / 256;
+}
+
+u32 stmmac_riwt2usec(u32 riwt, struct stmmac_priv *priv)
+{
+	unsigned long clk = clk_get_rate(priv->plat->stmmac_clk);
+
+	if (!clk) {
+		clk = priv->plat->clk_ref_rate;
+		if (!clk)
+			return 0;
+	}
+
+	return (riwt * 256) / (clk / 1000000);
+}
+
+/**
+ * stmmac_rx_dim_work - apply an adaptive RX moderation decision
+ * @work: work_struct of the channel's RX dim
+ * Description: the RX watchdog is programmed with one value for every
+ * channel, so the shortest timeout requested by any RX channel wins.
+ */
+static void stmmac_rx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct stmmac_channel *ch = container_of(dim, struct stmmac_channel,
+						 rx_dim);
+	struct stmmac_priv *priv = ch->priv_data;
+	u32 rx_cnt = priv->plat->rx_queues_to_use;
+	struct dim_cq_moder moder;
+	u32 riwt = MAX_DMA_RIWT;
+	u32 chan;
+
+	moder = net_dim_get_rx_moderation(dim->mode, dim->profile_ix);
+	ch->rx_dim_riwt = clamp_t(u32, stmmac_usec2riwt(moder.usec, priv),
+				  MIN_DMA_RIWT, MAX_DMA_RIWT);
+
+	for (chan = 0; chan < rx_cnt; chan++)
+		if (priv->channel[chan].rx_dim_riwt)
+			riwt = min(riwt, priv->channel[chan].rx_dim_riwt);
+
+	if (riwt != priv->rx_riwt) {
+		priv->rx_riwt = riwt;
+		stmmac_rx_watchdog(priv, priv->ioaddr, riwt, rx_cnt);
+	}
+
+	dim->state = DIM_START_MEASURE;
+}
+
+/**
+ * stmmac_tx_dim_work - apply an adaptive TX moderation decision
+ * @work: work_struct of the channel's TX dim
+ * Description: retunes the TX coalesce timer and frame threshold, which
+ * are shared by all channels; the most latency-sensitive channel wins.
+ */
+static void stmmac_tx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct stmmac_channel *ch = container_of(dim, struct stmmac_channel,
+						 tx_dim);
+	struct stmmac_priv *priv = ch->priv_data;
+	u32 tx_cnt = priv->plat->tx_queues_to_use;
+	u32 usec = STMMAC_MAX_COAL_TX_TICK;
+	u32 frames = STMMAC_TX_MAX_FRAMES;
+	u32 chan;
+
+	ch->tx_dim_moder = net_dim_get_tx_moderation(dim->mode,
+						     dim->profile_ix);
+
+	for (chan = 0; chan < tx_cnt; chan++) {
+		struct dim_cq_moder *m = &priv->channel[chan].tx_dim_moder;
+
+		if (!m->usec && !m->pkts)
+			continue;
+		usec = min_t(u32, usec, m->usec);
+		frames = min_t(u32, frames, m->pkts);
+	}
+
+	WRITE_ONCE(priv->tx_coal_timer, max_t(u32, usec, 1));
+	WRITE_ONCE(priv->tx_coal_frames, max_t(u32, frames, 1));
+
+	dim->state = DIM_START_MEASURE;
+}
+
 static void stmmac_set_rings_length(struct stmmac_priv *priv)
 {
 	u32 rx_channels_count = priv->plat->rx_queues_to_use;
@@ -2870,6 +3102,9 @@ static int stmmac_open(struct net_device *dev)
 		return ret;
 	}
 
+	priv->rx_link_up = false;
+	priv->rx_released = false;
+
 	if (priv->hw->pcs != STMMAC_PCS_TBI &&
 	    priv->hw->pcs != STMMAC_PCS_RTBI &&
 	    priv->hw->xpcs == NULL) {
@@ -2896,8 +3131,6 @@ static int stmmac_open(struct net_device *dev)
 	priv->dma_buf_sz = bfsize;
 	buf_sz = bfsize;
 
-	priv->rx_copybreak = STMMAC_RX_COPYBREAK;
-
 	if (!priv->dma_tx_size)
 		priv->dma_tx_size = priv->plat->dma_tx_size ? priv->plat->dma_tx_size :
 				    DMA_DEFAULT_TX_SIZE;
@@ -3021,6 +3254,9 @@ static int stmmac_release(struct net_device *dev)
 	struct stmmac_priv *priv = netdev_priv(dev);
 	u32 chan;
 
+	/* Not running anymore, so the shrinker cannot queue it again */
+	cancel_delayed_work_sync(&priv->rx_release_work);
+
 	if (device_may_wakeup(priv->device))
 		phylink_speed_down(priv->phylink, false);
 	/* Stop and disconnect the PHY */
@@ -3732,7 +3968,8 @@ static inline void stmmac_rx_refill(struct stmmac_priv *priv, u32 queue)
 			buf->sec_addr = page_pool_get_dma_addr(buf->sec_page);
 		}
 
-		buf->addr = page_pool_get_dma_addr(buf->page);
+		buf->page_offset = stmmac_rx_offset(priv);
+		buf->addr = page_pool_get_dma_addr(buf->page) + buf->page_offset;
 		stmmac_set_desc_addr(priv, p, buf->addr);
 		if (priv->sph)
 			stmmac_set_desc_sec_addr(priv, p, buf->sec_addr, true);
@@ -3761,6 +3998,193 @@ static inline void stmmac_rx_refill(struct stmmac_priv *priv, u32 queue)
 	stmmac_set_rx_tail_ptr(priv, priv->ioaddr, rx_q->rx_tail_addr, queue);
 }
 
+/**
+ * stmmac_rx_release_queue - give the RX ring pages back to the system
+ * @priv: driver private structure
+ * @queue: RX queue index
+ * Description: the RX DMA is stopped and every descriptor is left owned
+ * by it, so stmmac_rx() finds nothing to do until stmmac_rx_restore()
+ * repopulates the ring. The pages bypass the page_pool cache, which would
+ * otherwise keep them.
+ */
+static void stmmac_rx_release_queue(struct stmmac_priv *priv, u32 queue)
+{
+	struct stmmac_rx_queue *rx_q = &priv->rx_queue[queue];
+	struct stmmac_channel *ch = &priv->channel[queue];
+	int i;
+
+	napi_disable(&ch->rx_napi);
+	stmmac_stop_rx_dma(priv, queue);
+
+	if (rx_q->state_saved) {
+		dev_kfree_skb(rx_q->state.skb);
+		rx_q->state_saved = false;
+	}
+
+	for (i = 0; i < priv->dma_rx_size; i++) {
+		struct stmmac_rx_buffer *buf = &rx_q->buf_pool[i];
+
+		if (buf->page) {
+			page_pool_release_page(rx_q->page_pool, buf->page);
+			put_page(buf->page);
+			buf->page = NULL;
+		}
+		if (buf->sec_page) {
+			page_pool_release_page(rx_q->page_pool, buf->sec_page);
+			put_page(buf->sec_page);
+			buf->sec_page = NULL;
+		}
+	}
+
+	stmmac_clear_rx_descriptors(priv, queue);
+	rx_q->cur_rx = 0;
+	rx_q->dirty_rx = 0;
+
+	napi_enable(&ch->rx_napi);
+}
+
+/**
+ * stmmac_rx_restore_queue - repopulate a ring emptied by the shrinker
+ * @priv: driver private structure
+ * @queue: RX queue index
+ * Description: the ring is only restarted once every entry has its
+ * buffers, from the head as after stmmac_hw_setup(). Buffers allocated
+ * before a failure are kept for the next attempt.
+ */
+static int stmmac_rx_restore_queue(struct stmmac_priv *priv, u32 queue)
+{
+	struct stmmac_rx_queue *rx_q = &priv->rx_queue[queue];
+	struct stmmac_channel *ch = &priv->channel[queue];
+	int i;
+
+	for (i = 0; i < priv->dma_rx_size; i++) {
+		struct stmmac_rx_buffer *buf = &rx_q->buf_pool[i];
+		struct dma_desc *p;
+
+		if (buf->page && (!priv->sph || buf->sec_page))
+			continue;
+
+		if (priv->extend_desc)
+			p = &((rx_q->dma_erx + i)->basic);
+		else
+			p = rx_q->dma_rx + i;
+
+		stmmac_free_rx_buffer(priv, queue, i);
+		if (stmmac_init_rx_buffers(priv, p, i, GFP_KERNEL, queue)) {
+			stmmac_free_rx_buffer(priv, queue, i);
+			return -ENOMEM;
+		}
+	}
+
+	napi_disable(&ch->rx_napi);
+
+	stmmac_clear_rx_descriptors(priv, queue);
+	rx_q->cur_rx = 0;
+	rx_q->dirty_rx = 0;
+
+	stmmac_init_rx_chan(priv, priv->ioaddr, priv->plat->dma_cfg,
+			    rx_q->dma_rx_phy, queue);
+	rx_q->rx_tail_addr = rx_q->dma_rx_phy +
+			     (priv->dma_rx_size * sizeof(struct dma_desc));
+	stmmac_set_rx_tail_ptr(priv, priv->ioaddr, rx_q->rx_tail_addr, queue);
+	stmmac_start_rx_dma(priv, queue);
+
+	napi_enable(&ch->rx_napi);
+
+	return 0;
+}
+
+/* Called with rx_release_lock held */
+static int stmmac_rx_restore(struct stmmac_priv *priv)
+{
+	u32 queue;
+	int ret;
+
+	if (!priv->rx_released)
+		return 0;
+
+	for (queue = 0; queue < priv->plat->rx_queues_to_use; queue++) {
+		if (test_bit(queue, &priv->uio_chans))
+			continue;
+
+		ret = stmmac_rx_restore_queue(priv, queue);
+		if (ret) {
+			netdev_warn(priv->dev,
+				    "%s: RX queue %u not refilled yet\n",
+				    __func__, queue);
+			return ret;
+		}
+	}
+
+	priv->rx_released = false;
+
+	return 0;
+}
+
+static void stmmac_rx_release_work(struct work_struct *work)
+{
+	struct stmmac_priv *priv = container_of(to_delayed_work(work),
+						struct stmmac_priv,
+						rx_release_work);
+	u32 queue;
+
+	mutex_lock(&priv->rx_release_lock);
+
+	if (!netif_running(priv->dev) || !netif_device_present(priv->dev))
+		goto unlock;
+
+	if (priv->rx_link_up) {
+		/* a refill that failed when the link came up */
+		if (stmmac_rx_restore(priv))
+			queue_delayed_work(priv->wq, &priv->rx_release_work,
+					   HZ / 10);
+		goto unlock;
+	}
+
+	if (priv->rx_released)
+		goto unlock;
+
+	for (queue = 0; queue < priv->plat->rx_queues_to_use; queue++)
+		if (!test_bit(queue, &priv->uio_chans))
+			stmmac_rx_release_queue(priv, queue);
+
+	priv->rx_released = true;
+	netif_dbg(priv, drv, priv->dev, "RX buffers released, link is down\n");
+
+unlock:
+	mutex_unlock(&priv->rx_release_lock);
+}
+
+static unsigned long stmmac_rx_shrink_count(struct shrinker *shrink,
+					    struct shrink_control *sc)
+{
+	struct stmmac_priv *priv = container_of(shrink, struct stmmac_priv,
+						rx_shrinker);
+	unsigned long pages;
+
+	if (!netif_running(priv->dev) || !netif_device_present(priv->dev) ||
+	    READ_ONCE(priv->rx_link_up) || READ_ONCE(priv->rx_released))
+		return 0;
+
+	pages = DIV_ROUND_UP(priv->dma_buf_sz, PAGE_SIZE);
+	if (priv->sph)
+		pages *= 2;
+
+	return pages * priv->dma_rx_size * priv->plat->rx_queues_to_use;
+}
+
+static unsigned long stmmac_rx_shrink_scan(struct shrinker *shrink,
+					   struct shrink_control *sc)
+{
+	struct stmmac_priv *priv = container_of(shrink, struct stmmac_priv,
+						rx_shrinker);
+
+	/* NAPI has to be stopped, which must not be done from reclaim */
+	queue_delayed_work(priv->wq, &priv->rx_release_work, 0);
+
+	return SHRINK_STOP;
+}
+
 static unsigned int stmmac_rx_buf1_len(struct stmmac_priv *priv,
 				       struct dma_desc *p,
 				       int status, unsigned int len)
@@ -3810,6 +4234,194 @@ static unsigned int stmmac_rx_buf2_len(struct stmmac_priv *priv,
 	return plen - len;
 }
 
+static int stmmac_xdp_get_tx_queue(struct stmmac_priv *priv, int cpu)
+{
+	int index = cpu;
+
+	if (unlikely(index < 0))
+		index = 0;
+
+	while (index >= priv->dev->real_num_tx_queues)
+		index -= priv->dev->real_num_tx_queues;
+
+	return index;
+}
+
+static void stmmac_flush_tx_descriptors(struct stmmac_priv *priv, int queue)
+{
+	struct stmmac_tx_queue *tx_q = &priv->tx_queue[queue];
+	int desc_size;
+
+	if (likely(priv->extend_desc))
+		desc_size = sizeof(struct dma_extended_desc);
+	else if (tx_q->tbs & STMMAC_TBS_AVAIL)
+		desc_size = sizeof(struct dma_edesc);
+	else
+		desc_size = sizeof(struct dma_desc);
+
+	/* The own bit must be the latest setting done when prepare the
+	 * descriptor and then barrier is needed to make sure that
+	 * all is coherent before granting the DMA engine.
+	 */
+	wmb();
+
+	tx_q->tx_tail_addr = tx_q->dma_tx_phy + (tx_q->cur_tx * desc_size);
+	stmmac_set_tx_tail_ptr(priv, priv->ioaddr, tx_q->tx_tail_addr, queue);
+}
+
+/**
+ * stmmac_xdp_xmit_xdpf - queue one XDP frame on a TX ring
+ * @priv: driver private structure
+ * @queue: TX queue index
+ * @xdpf: frame to send
+ * @dma_map: map the frame (ndo_xdp_xmit) rather than reuse the mapping of
+ * the RX page pool it was received into (XDP_TX)
+ * Description: must be called with the netdev TX queue lock held.
+ */
+static int stmmac_xdp_xmit_xdpf(struct stmmac_priv *priv, int queue,
+				struct xdp_frame *xdpf, bool dma_map)
+{
+	struct stmmac_tx_queue *tx_q = &priv->tx_queue[queue];
+	unsigned int entry = tx_q->cur_tx;
+	struct dma_desc *tx_desc;
+	dma_addr_t dma_addr;
+
+	if (stmmac_tx_avail(priv, queue) < STMMAC_TX_THRESH(priv))
+		return STMMAC_XDP_CONSUMED;
+
+	if (likely(priv->extend_desc))
+		tx_desc = (struct dma_desc *)(tx_q->dma_etx + entry);
+	else if (tx_q->tbs & STMMAC_TBS_AVAIL)
+		tx_desc = &tx_q->dma_entx[entry].basic;
+	else
+		tx_desc = tx_q->dma_tx + entry;
+
+	if (dma_map) {
+		dma_addr = dma_map_single(priv->device, xdpf->data,
+					  xdpf->len, DMA_TO_DEVICE);
+		if (dma_mapping_error(priv->device, dma_addr))
+			return STMMAC_XDP_CONSUMED;
+
+		tx_q->tx_skbuff_dma[entry].buf_type = STMMAC_TXBUF_T_XDP_NDO;
+	} else {
+		struct page *page = virt_to_page(xdpf->data);
+
+		dma_addr = page_pool_get_dma_addr(page) + sizeof(*xdpf) +
+			   xdpf->headroom;
+		dma_sync_single_for_device(priv->device, dma_addr,
+					   xdpf->len, DMA_BIDIRECTIONAL);
+
+		tx_q->tx_skbuff_dma[entry].buf_type = STMMAC_TXBUF_T_XDP_TX;
+	}
+
+	tx_q->tx_skbuff_dma[entry].buf = dma_addr;
+	tx_q->tx_skbuff_dma[entry].map_as_page = false;
+	tx_q->tx_skbuff_dma[entry].len = xdpf->len;
+	tx_q->tx_skbuff_dma[entry].last_segment = true;
+	tx_q->tx_skbuff_dma[entry].is_jumbo = false;
+
+	tx_q->xdpf[entry] = xdpf;
+
+	stmmac_set_desc_addr(priv, tx_desc, dma_addr);
+
+	stmmac_prepare_tx_desc(priv, tx_desc, 1, xdpf->len,
+			       true, priv->mode, true, true,
+			       xdpf->len);
+
+	tx_q->tx_count_frames++;
+	if (priv->tx_coal_frames &&
+	    tx_q->tx_count_frames % priv->tx_coal_frames == 0) {
+		tx_q->tx_count_frames = 0;
+		stmmac_set_tx_ic(priv, tx_desc);
+		priv->xstats.tx_set_ic_bit++;
+	}
+
+	stmmac_enable_dma_transmission(priv, priv->ioaddr);
+
+	entry = STMMAC_GET_ENTRY(entry, priv->dma_tx_size);
+	tx_q->cur_tx = entry;
+
+	return STMMAC_XDP_TX;
+}
+
+static int stmmac_xdp_xmit_back(struct stmmac_priv *priv,
+				struct xdp_buff *xdp)
+{
+	struct xdp_frame *xdpf = xdp_convert_buff_to_frame(xdp);
+	int cpu = smp_processor_id();
+	struct netdev_queue *nq;
+	int queue;
+	int res;
+
+	if (unlikely(!xdpf))
+		return STMMAC_XDP_CONSUMED;
+
+	queue = stmmac_xdp_get_tx_queue(priv, cpu);
+	nq = netdev_get_tx_queue(priv->dev, queue);
+
+	__netif_tx_lock(nq, cpu);
+	/* Avoids TX time-out as we are sharing with slow path */
+	nq->trans_start = jiffies;
+
+	res = stmmac_xdp_xmit_xdpf(priv, queue, xdpf, false);
+	if (res == STMMAC_XDP_TX)
+		stmmac_flush_tx_descriptors(priv, queue);
+
+	__netif_tx_unlock(nq);
+
+	return res;
+}
+
+static int stmmac_xdp_run_prog(struct stmmac_priv *priv,
+			       struct bpf_prog *prog,
+			       struct xdp_buff *xdp)
+{
+	u32 act;
+	int res;
+
+	act = bpf_prog_run_xdp(prog, xdp);
+	switch (act) {
+	case XDP_PASS:
+		res = STMMAC_XDP_PASS;
+		break;
+	case XDP_TX:
+		res = stmmac_xdp_xmit_back(priv, xdp);
+		break;
+	case XDP_REDIRECT:
+		if (xdp_do_redirect(priv->dev, xdp, prog) < 0)
+			res = STMMAC_XDP_CONSUMED;
+		else
+			res = STMMAC_XDP_REDIRECT;
+		break;
+	default:
+		bpf_warn_invalid_xdp_action(act);
+		fallthrough;
+	case XDP_ABORTED:
+		trace_xdp_exception(priv->dev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		res = STMMAC_XDP_CONSUMED;
+		break;
+	}
+
+	return res;
+}
+
+static void stmmac_finalize_xdp_rx(struct stmmac_priv *priv,
+				   int xdp_status)
+{
+	int cpu = smp_processor_id();
+	int queue;
+
+	queue = stmmac_xdp_get_tx_queue(priv, cpu);
+
+	if (xdp_status & STMMAC_XDP_TX)
+		stmmac_tx_timer_arm(priv, queue);
+
+	if (xdp_status & STMMAC_XDP_REDIRECT)
+		xdp_do_flush();
+}
+
 /**
  * stmmac_rx - manage the receive process
  * @priv: driver private structure
@@ -3825,8 +4437,19 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 	unsigned int count = 0, error = 0, len = 0;
 	int status = 0, coe = priv->hw->rx_csum;
 	unsigned int next_entry = rx_q->cur_rx;
+	enum dma_data_direction dma_dir;
 	unsigned int desc_size;
 	struct sk_buff *skb = NULL;
+	struct bpf_prog *prog;
+	struct xdp_buff xdp;
+	int xdp_status = 0;
+	unsigned int copy_len;
+	unsigned int buf_sz;
+
+	dma_dir = page_pool_get_dma_dir(rx_q->page_pool);
+	buf_sz = DIV_ROUND_UP(priv->dma_buf_sz + stmmac_rx_offset(priv),
+			      PAGE_SIZE) * PAGE_SIZE;
+	prog = READ_ONCE(priv->xdp_prog);
 
 	if (netif_msg_rx_status(priv)) {
 		void *rx_head;
@@ -3944,27 +4567,99 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 		}
 
 		if (!skb) {
-			skb = napi_alloc_skb(&ch->rx_napi, buf1_len);
+			dma_sync_single_for_cpu(priv->device, buf->addr,
+						buf1_len, dma_dir);
+
+			xdp.data_hard_start = page_address(buf->page);
+			xdp.data = xdp.data_hard_start + buf->page_offset;
+			xdp.data_end = xdp.data + buf1_len;
+			xdp_set_data_meta_invalid(&xdp);
+			xdp.frame_sz = buf_sz;
+			xdp.rxq = &rx_q->xdp_rxq;
+
+			/* Jumbo frames spanning descriptors skip XDP */
+			if (prog && !(status & rx_not_ls)) {
+				unsigned int pre_len, sync_len;
+				int res;
+
+				pre_len = xdp.data_end - xdp.data_hard_start -
+					  buf->page_offset;
+				res = stmmac_xdp_run_prog(priv, prog, &xdp);
+				/* Due xdp_adjust_tail: DMA sync for_device
+				 * cover max len CPU touch
+				 */
+				sync_len = xdp.data_end - xdp.data_hard_start -
+					   buf->page_offset;
+				sync_len = max(sync_len, pre_len);
+
+				if (res & STMMAC_XDP_CONSUMED) {
+					page_pool_put_page(rx_q->page_pool,
+							   buf->page, sync_len,
+							   true);
+					buf->page = NULL;
+					priv->dev->stats.rx_dropped++;
+					count++;
+					continue;
+				} else if (res & (STMMAC_XDP_TX |
+						  STMMAC_XDP_REDIRECT)) {
+					xdp_status |= res;
+					buf->page = NULL;
+					priv->dev->stats.rx_packets++;
+					priv->dev->stats.rx_bytes += len;
+					ch->rx_dim_bytes += len;
+					count++;
+					continue;
+				}
+			}
+
+			/* XDP program may expand or reduce tail */
+			buf1_len = xdp.data_end - xdp.data;
+
+			/* Frames up to rx_copybreak are copied whole into a
+			 * compact skb; for bigger ones only the headers are,
+			 * and the payload stays in the page as a fragment.
+			 */
+			copy_len = buf1_len;
+			if (buf1_len > priv->rx_copybreak)
+				copy_len = eth_get_headlen(priv->dev, xdp.data,
+							   max_t(unsigned int,
+								 priv->rx_copybreak,
+								 ETH_HLEN));
+
+			skb = napi_alloc_skb(&ch->rx_napi, copy_len);
 			if (!skb) {
 				priv->dev->stats.rx_dropped++;
 				count++;
 				goto drain_data;
 			}
 
-			dma_sync_single_for_cpu(priv->device, buf->addr,
-						buf1_len, DMA_FROM_DEVICE);
-			skb_copy_to_linear_data(skb, page_address(buf->page),
-						buf1_len);
-			skb_put(skb, buf1_len);
+			/* XDP program may adjust header */
+			skb_copy_to_linear_data(skb, xdp.data, copy_len);
+			skb_put(skb, copy_len);
 
-			/* Data payload copied into SKB, page ready for recycle */
-			page_pool_recycle_direct(rx_q->page_pool, buf->page);
+			if (copy_len < buf1_len) {
+				skb_add_rx_frag(skb, 0, buf->page,
+						xdp.data + copy_len -
+						xdp.data_hard_start,
+						buf1_len - copy_len,
+						priv->dma_buf_sz);
+
+				/* Page handed over to the SKB */
+				page_pool_release_page(rx_q->page_pool,
+						       buf->page);
+			} else {
+				/* Data payload copied into SKB, page ready
+				 * for recycle
+				 */
+				page_pool_recycle_direct(rx_q->page_pool,
+							 buf->page);
+			}
 			buf->page = NULL;
 		} else if (buf1_len) {
 			dma_sync_single_for_cpu(priv->device, buf->addr,
-						buf1_len, DMA_FROM_DEVICE);
+						buf1_len, dma_dir);
 			skb_add_rx_frag(skb, skb_shinfo(skb)->nr_frags,
-					buf->page, 0, buf1_len,
+					buf->page, buf->page_offset, buf1_len,
 					priv->dma_buf_sz);
 
 			/* Data payload appended into SKB */
@@ -3974,7 +4669,7 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 
 		if (buf2_len) {
 			dma_sync_single_for_cpu(priv->device, buf->sec_addr,
-						buf2_len, DMA_FROM_DEVICE);
+						buf2_len, dma_dir);
 			skb_add_rx_frag(skb, skb_shinfo(skb)->nr_frags,
 					buf->sec_page, 0, buf2_len,
 					priv->dma_buf_sz);
@@ -4010,6 +4705,7 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 
 		priv->dev->stats.rx_packets++;
 		priv->dev->stats.rx_bytes += len;
+		ch->rx_dim_bytes += len;
 		count++;
 	}
 
@@ -4020,9 +4716,12 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 		rx_q->state.len = len;
 	}
 
+	stmmac_finalize_xdp_rx(priv, xdp_status);
+
 	stmmac_rx_refill(priv, queue);
 
 	priv->xstats.rx_pkt_n += count;
+	ch->rx_dim_packets += count;
 
 	return count;
 }
@@ -4037,10 +4736,28 @@ static int stmmac_napi_poll_rx(struct napi_struct *napi, int budget)
 
 	priv->xstats.napi_poll++;
 
+	if (unlikely(priv->bench) && ch->bench_irq_ns) {
+		u64 lat = ktime_get_ns() - ch->bench_irq_ns;
+
+		ch->bench_irq_ns = 0;
+		ch->bench_lat_ns += lat;
+		ch->bench_lat_max_ns = max(ch->bench_lat_max_ns, lat);
+		ch->bench_lat_cnt++;
+	}
+
 	work_done = stmmac_rx(priv, budget, chan);
 	if (work_done < budget && napi_complete_done(napi, work_done)) {
 		unsigned long flags;
 
+		ch->rx_dim_events++;
+		if (priv->rx_dim_enabled) {
+			struct dim_sample sample = {};
+
+			dim_update_sample(ch->rx_dim_events, ch->rx_dim_packets,
+					  ch->rx_dim_bytes, &sample);
+			net_dim(&ch->rx_dim, sample);
+		}
+
 		spin_lock_irqsave(&ch->lock, flags);
 		stmmac_enable_dma_irq(priv, priv->ioaddr, chan, 1, 0);
 		spin_unlock_irqrestore(&ch->lock, flags);
@@ -4049,6 +4766,41 @@ static int stmmac_napi_poll_rx(struct napi_struct *napi, int budget)
 	return work_done;
 }
 
+/* Owns the RX NAPI once stmmac_napi_check() scheduled it, like NET_RX does */
+static int stmmac_rx_thread_fn(void *data)
+{
+	struct stmmac_channel *ch = data;
+	struct napi_struct *napi = &ch->rx_napi;
+	int work_done;
+
+	for (;;) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (kthread_should_stop()) {
+			__set_current_state(TASK_RUNNING);
+			break;
+		}
+		if (!test_and_clear_bit(0, &ch->rx_thread_sched)) {
+			schedule();
+			continue;
+		}
+		__set_current_state(TASK_RUNNING);
+
+		do {
+			/* the RX path allocates from and frees to the BH caches */
+			local_bh_disable();
+			work_done = stmmac_napi_poll_rx(napi, napi->weight);
+			if (work_done >= napi->weight && napi_disable_pending(napi)) {
+				napi_complete(napi);
+				work_done = 0;
+			}
+			local_bh_enable();
+			cond_resched();
+		} while (work_done >= napi->weight);
+	}
+
+	return 0;
+}
+
 static int stmmac_napi_poll_tx(struct napi_struct *napi, int budget)
 {
 	struct stmmac_channel *ch =
@@ -4059,12 +4811,21 @@ static int stmmac_napi_poll_tx(struct napi_struct *napi, int budget)
 
 	priv->xstats.napi_poll++;
 
-	work_done = stmmac_tx_clean(priv, priv->dma_tx_size, chan);
+	work_done = stmmac_tx_clean(priv, priv->dma_tx_size, chan, budget);
 	work_done = min(work_done, budget);
 
 	if (work_done < budget && napi_complete_done(napi, work_done)) {
 		unsigned long flags;
 
+		ch->tx_dim_events++;
+		if (priv->tx_dim_enabled) {
+			struct dim_sample sample = {};
+
+			dim_update_sample(ch->tx_dim_events, ch->tx_dim_packets,
+					  ch->tx_dim_bytes, &sample);
+			net_dim(&ch->tx_dim, sample);
+		}
+
 		spin_lock_irqsave(&ch->lock, flags);
 		stmmac_enable_dma_irq(priv, priv->ioaddr, chan, 0, 1);
 		spin_unlock_irqrestore(&ch->lock, flags);
@@ -4132,6 +4893,11 @@ static int stmmac_change_mtu(struct net_device *dev, int new_mtu)
 		return -EBUSY;
 	}
 
+	if (stmmac_xdp_is_enabled(priv) && new_mtu > ETH_DATA_LEN) {
+		netdev_dbg(priv->dev, "Jumbo frames not supported for XDP\n");
+		return -EINVAL;
+	}
+
 	new_mtu = STMMAC_ALIGN(new_mtu);
 
 	/* If condition true, FIFO is too small or MTU too large */
@@ -4745,6 +5511,95 @@ static int stmmac_vlan_rx_kill_vid(struct net_device *ndev, __be16 proto, u16 vi
 	return ret;
 }
 
+static int stmmac_xdp_set_prog(struct stmmac_priv *priv, struct bpf_prog *prog,
+			       struct netlink_ext_ack *extack)
+{
+	struct net_device *dev = priv->dev;
+	struct bpf_prog *old_prog;
+	bool need_update;
+	bool if_running;
+
+	if_running = netif_running(dev);
+
+	if (prog && dev->mtu > ETH_DATA_LEN) {
+		/* Frames must fit one page pool buffer with XDP headroom */
+		NL_SET_ERR_MSG_MOD(extack, "Jumbo frames not supported");
+		return -EOPNOTSUPP;
+	}
+
+	/* Rings are rebuilt when headroom and DMA direction change */
+	need_update = !!priv->xdp_prog != !!prog;
+	if (if_running && need_update)
+		stmmac_release(dev);
+
+	old_prog = xchg(&priv->xdp_prog, prog);
+	if (old_prog)
+		bpf_prog_put(old_prog);
+
+	/* Disable RX SPH for XDP operation */
+	priv->sph = priv->sph_cap && !stmmac_xdp_is_enabled(priv);
+
+	if (if_running && need_update)
+		return stmmac_open(dev);
+
+	return 0;
+}
+
+static int stmmac_bpf(struct net_device *dev, struct netdev_bpf *bpf)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		return stmmac_xdp_set_prog(priv, bpf->prog, bpf->extack);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static int stmmac_xdp_xmit(struct net_device *dev, int num_frames,
+			   struct xdp_frame **frames, u32 flags)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+	int cpu = smp_processor_id();
+	struct netdev_queue *nq;
+	int i, drops = 0;
+	int queue;
+
+	if (unlikely(!netif_running(dev) ||
+		     test_bit(STMMAC_DOWN, &priv->state)))
+		return -ENETDOWN;
+
+	if (unlikely(flags & ~XDP_XMIT_FLAGS_MASK))
+		return -EINVAL;
+
+	queue = stmmac_xdp_get_tx_queue(priv, cpu);
+	nq = netdev_get_tx_queue(priv->dev, queue);
+
+	__netif_tx_lock(nq, cpu);
+	/* Avoids TX time-out as we are sharing with slow path */
+	nq->trans_start = jiffies;
+
+	for (i = 0; i < num_frames; i++) {
+		int res;
+
+		res = stmmac_xdp_xmit_xdpf(priv, queue, frames[i], true);
+		if (res == STMMAC_XDP_CONSUMED) {
+			xdp_return_frame_rx_napi(frames[i]);
+			drops++;
+		}
+	}
+
+	if (flags & XDP_XMIT_FLUSH) {
+		stmmac_flush_tx_descriptors(priv, queue);
+		stmmac_tx_timer_arm(priv, queue);
+	}
+
+	__netif_tx_unlock(nq);
+
+	return num_frames - drops;
+}
+
 static const struct net_device_ops stmmac_netdev_ops = {
 	.ndo_open = stmmac_open,
 	.ndo_start_xmit = stmmac_xmit,
@@ -4763,6 +5618,8 @@ static const struct net_device_ops stmmac_netdev_ops = {
 	.ndo_set_mac_address = stmmac_set_mac_address,
 	.ndo_vlan_rx_add_vid = stmmac_vlan_rx_add_vid,
 	.ndo_vlan_rx_kill_vid = stmmac_vlan_rx_kill_vid,
+	.ndo_bpf = stmmac_bpf,
+	.ndo_xdp_xmit = stmmac_xdp_xmit,
 };
 
 static void stmmac_reset_subtask(struct stmmac_priv *priv)
@@ -4895,6 +5752,10 @@ static int stmmac_hw_init(struct stmmac_priv *priv)
 			 "Enable RX Mitigation via HW Watchdog Timer\n");
 	}
 
+	/* Adaptive RX moderation works by retuning the RX watchdog */
+	priv->rx_dim_enabled = priv->use_riwt;
+	priv->tx_dim_enabled = true;
+
 	return 0;
 }
 
@@ -4921,10 +5782,27 @@ static void stmmac_napi_add(struct net_device *dev)
 		if (queue < priv->plat->rx_queues_to_use) {
 			netif_napi_add(dev, &ch->rx_napi, stmmac_napi_poll_rx,
 				       rx_budget);
+			INIT_WORK(&ch->rx_dim.work, stmmac_rx_dim_work);
+			ch->rx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+
+			if (rx_thread != STMMAC_RX_SOFTIRQ) {
+				ch->rx_thread = kthread_run(stmmac_rx_thread_fn, ch,
+							    "stmmac%d-rx%u",
+							    priv->plat->bus_id, queue);
+				if (IS_ERR(ch->rx_thread)) {
+					netdev_warn(dev, "RX%u stays in softirq\n",
+						    queue);
+					ch->rx_thread = NULL;
+				} else if (rx_thread == STMMAC_RX_THREAD_FIFO) {
+					sched_set_fifo_low(ch->rx_thread);
+				}
+			}
 		}
 		if (queue < priv->plat->tx_queues_to_use) {
 			netif_tx_napi_add(dev, &ch->tx_napi,
 					  stmmac_napi_poll_tx, tx_budget);
+			INIT_WORK(&ch->tx_dim.work, stmmac_tx_dim_work);
+			ch->tx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
 		}
 	}
 }
@@ -4939,8 +5817,13 @@ static void stmmac_napi_del(struct net_device *dev)
 	for (queue = 0; queue < maxq; queue++) {
 		struct stmmac_channel *ch = &priv->channel[queue];
 
-		if (queue < priv->plat->rx_queues_to_use)
+		if (queue < priv->plat->rx_queues_to_use) {
+			if (ch->rx_thread) {
+				kthread_stop(ch->rx_thread);
+				ch->rx_thread = NULL;
+			}
 			netif_napi_del(&ch->rx_napi);
+		}
 		if (queue < priv->plat->tx_queues_to_use)
 			netif_napi_del(&ch->tx_napi);
 	}
@@ -5016,6 +5899,7 @@ int stmmac_dvr_probe(struct device *device,
 
 	stmmac_set_ethtool_ops(ndev);
 	priv->pause = pause;
+	priv->rx_copybreak = STMMAC_RX_COPYBREAK;
 	priv->plat = plat_dat;
 	priv->ioaddr = res->addr;
 	priv->dev->base_addr = (unsigned long)res->addr;
@@ -5040,6 +5924,8 @@ int stmmac_dvr_probe(struct device *device,
 	}
 
 	INIT_WORK(&priv->service_task, stmmac_service_task);
+	INIT_DELAYED_WORK(&priv->rx_release_work, stmmac_rx_release_work);
+	mutex_init(&priv->rx_release_lock);
 
 	/* Override with kernel parameters if supplied XXX CRS XXX
 	 * this needs to have multiple instances
@@ -5085,7 +5971,8 @@ int stmmac_dvr_probe(struct device *device,
 	if (priv->dma_cap.sphen && !priv->plat->sph_disable) {
 		ndev->hw_features |= NETIF_F_GRO;
 		if (!priv->plat->sph_disable) {
-			priv->sph = true;
+			priv->sph_cap = true;
+			priv->sph = priv->sph_cap;
 			dev_info(priv->device, "SPH feature enabled\n");
 		}
 	}
@@ -5210,6 +6097,15 @@ int stmmac_dvr_probe(struct device *device,
 		goto error_phy_setup;
 	}
 
+	priv->rx_shrinker.count_objects = stmmac_rx_shrink_count;
+	priv->rx_shrinker.scan_objects = stmmac_rx_shrink_scan;
+	priv->rx_shrinker.seeks = DEFAULT_SEEKS;
+	ret = register_shrinker(&priv->rx_shrinker);
+	if (ret) {
+		dev_err(priv->device, "failed to register shrinker\n");
+		goto error_shrinker;
+	}
+
 	ret = register_netdev(ndev);
 	if (ret) {
 		dev_err(priv->device, "%s: ERROR %i registering the device\n",
@@ -5229,6 +6125,8 @@ int stmmac_dvr_probe(struct device *device,
 	return ret;
 
 error_netdev_register:
+	unregister_shrinker(&priv->rx_shrinker);
+error_shrinker:
 	phylink_destroy(priv->phylink);
 error_phy_setup:
 	if (priv->hw->pcs != STMMAC_PCS_TBI &&
@@ -5260,6 +6158,7 @@ int stmmac_dvr_remove(struct device *dev)
 	stmmac_mac_set(priv, priv->ioaddr, false);
 	netif_carrier_off(ndev);
 	unregister_netdev(ndev);
+	unregister_shrinker(&priv->rx_shrinker);
 
 	/* Serdes power down needs to happen after VLAN filter
 	 * is deleted that is triggered by unregister_netdev().
@@ -5279,6 +6178,7 @@ int stmmac_dvr_remove(struct device *dev)
 	    priv->hw->pcs != STMMAC_PCS_RTBI)
 		stmmac_mdio_unregister(ndev);
 	destroy_workqueue(priv->wq);
+	mutex_destroy(&priv->rx_release_lock);
 	mutex_destroy(&priv->lock);
 
 	return 0;
@@ -5297,6 +6197,7 @@ int stmmac_suspend(struct device *dev)
 	struct net_device *ndev = dev_get_drvdata(dev);
 	struct stmmac_priv *priv = netdev_priv(ndev);
 	u32 chan;
+	int ret;
 
 	if (!ndev || !netif_running(ndev))
 		return 0;
@@ -5307,6 +6208,18 @@ int stmmac_suspend(struct device *dev)
 
 	netif_device_detach(ndev);
 
+	/* Resume reuses the RX buffers, bring back any the shrinker took */
+	cancel_delayed_work_sync(&priv->rx_release_work);
+	mutex_lock(&priv->rx_release_lock);
+	ret = stmmac_rx_restore(priv);
+	mutex_unlock(&priv->rx_release_lock);
+	if (ret) {
+		netif_device_attach(ndev);
+		mutex_unlock(&priv->lock);
+		phylink_mac_change(priv->phylink, true);
+		return ret;
+	}
+
 	stmmac_disable_all_queues(priv);
 
 	for (chan = 0; chan < priv->plat->tx_queues_to_use; chan++)
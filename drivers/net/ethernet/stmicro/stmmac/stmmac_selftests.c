@@ -11,6 +11,7 @@
 #include <linux/crc32.h>
 #include <linux/ethtool.h>
 #include <linux/ip.h>
+#include <linux/kernel_stat.h>
 #include <linux/phy.h>
 #include <linux/udp.h>
 #include <net/pkt_cls.h>
@@ -1811,6 +1812,313 @@ static int stmmac_test_tbs(struct stmmac_priv *priv)
 	return ret;
 }
 
+#define STMMAC_CSUM_MSS		1000
+#define STMMAC_TSO_SEGS		4
+
+struct stmmac_csum_priv {
+	struct packet_type pt;
+	struct completion comp;
+	u16 dport;
+	unsigned int segs;
+	unsigned int bytes;
+	unsigned int exp_bytes;
+	bool bad;
+};
+
+/* Checks the TCP/IP checksums of every segment in software */
+static int stmmac_test_csum_validate(struct sk_buff *skb,
+				     struct net_device *ndev,
+				     struct packet_type *pt,
+				     struct net_device *orig_ndev)
+{
+	struct stmmac_csum_priv *cpriv = pt->af_packet_priv;
+	struct tcphdr *thdr;
+	struct iphdr *ihdr;
+	unsigned int len;
+
+	skb = skb_unshare(skb, GFP_ATOMIC);
+	if (!skb)
+		goto out;
+
+	if (skb_linearize(skb))
+		goto out;
+	if (skb_headlen(skb) < sizeof(*ihdr) + sizeof(*thdr))
+		goto out;
+
+	ihdr = ip_hdr(skb);
+	if (ihdr->protocol != IPPROTO_TCP)
+		goto out;
+
+	thdr = (struct tcphdr *)((u8 *)ihdr + 4 * ihdr->ihl);
+	if (thdr->dest != htons(cpriv->dport))
+		goto out;
+
+	len = ntohs(ihdr->tot_len) - 4 * ihdr->ihl;
+	if (len > skb_headlen(skb) - 4 * ihdr->ihl || len < __tcp_hdrlen(thdr)) {
+		cpriv->bad = true;
+		goto out;
+	}
+
+	if (ip_fast_csum(ihdr, ihdr->ihl) ||
+	    tcp_v4_check(len, ihdr->saddr, ihdr->daddr,
+			 csum_partial(thdr, len, 0)))
+		cpriv->bad = true;
+
+	cpriv->segs++;
+	cpriv->bytes += len - __tcp_hdrlen(thdr);
+	if (cpriv->bytes >= cpriv->exp_bytes)
+		complete(&cpriv->comp);
+out:
+	kfree_skb(skb);
+	return 0;
+}
+
+static int __stmmac_test_csum(struct stmmac_priv *priv, unsigned int segs)
+{
+	struct stmmac_packet_attrs attr = { };
+	struct stmmac_csum_priv *cpriv;
+	struct sk_buff *skb;
+	struct tcphdr *thdr;
+	struct iphdr *ihdr;
+	int ret;
+
+	cpriv = kzalloc(sizeof(*cpriv), GFP_KERNEL);
+	if (!cpriv)
+		return -ENOMEM;
+
+	init_completion(&cpriv->comp);
+	cpriv->dport = 9;
+	cpriv->exp_bytes = STMMAC_CSUM_MSS * segs;
+
+	cpriv->pt.type = htons(ETH_P_IP);
+	cpriv->pt.func = stmmac_test_csum_validate;
+	cpriv->pt.dev = priv->dev;
+	cpriv->pt.af_packet_priv = cpriv;
+	dev_add_pack(&cpriv->pt);
+
+	attr.dst = priv->dev->dev_addr;
+	attr.tcp = 1;
+	attr.sport = 0x321;
+	attr.dport = cpriv->dport;
+	attr.size = cpriv->exp_bytes - sizeof(struct stmmachdr);
+
+	skb = stmmac_test_get_udp_skb(priv, &attr);
+	if (!skb) {
+		ret = -ENOMEM;
+		goto cleanup;
+	}
+
+	/* Seed with the real TCP length so the result can be checked */
+	ihdr = ip_hdr(skb);
+	thdr = tcp_hdr(skb);
+	thdr->check = ~tcp_v4_check(skb->len - skb_transport_offset(skb),
+				    ihdr->saddr, ihdr->daddr, 0);
+
+	if (segs > 1) {
+		skb_shinfo(skb)->gso_size = STMMAC_CSUM_MSS;
+		skb_shinfo(skb)->gso_type = SKB_GSO_TCPV4;
+		skb_shinfo(skb)->gso_segs = segs;
+	}
+
+	ret = dev_direct_xmit(skb, 0);
+	if (ret)
+		goto cleanup;
+
+	wait_for_completion_timeout(&cpriv->comp, STMMAC_LB_TIMEOUT);
+
+	if (cpriv->bytes < cpriv->exp_bytes)
+		ret = -ETIMEDOUT;
+	else if (cpriv->bad || cpriv->segs != segs)
+		ret = -EINVAL;
+
+cleanup:
+	dev_remove_pack(&cpriv->pt);
+	kfree(cpriv);
+	return ret;
+}
+
+static int stmmac_test_tx_csum(struct stmmac_priv *priv)
+{
+	if (!priv->plat->tx_coe)
+		return -EOPNOTSUPP;
+
+	return __stmmac_test_csum(priv, 1);
+}
+
+static int stmmac_test_tso(struct stmmac_priv *priv)
+{
+	if (!priv->tso)
+		return -EOPNOTSUPP;
+
+	return __stmmac_test_csum(priv, STMMAC_TSO_SEGS);
+}
+
+#define STMMAC_BENCH_PKTS	10000
+#define STMMAC_BENCH_TIMEOUT	msecs_to_jiffies(5000)
+
+struct stmmac_bench_priv {
+	struct packet_type pt;
+	atomic_t rx;
+	u64 last_ns;
+};
+
+static int stmmac_test_bench_validate(struct sk_buff *skb,
+				      struct net_device *ndev,
+				      struct packet_type *pt,
+				      struct net_device *orig_ndev)
+{
+	struct stmmac_bench_priv *bpriv = pt->af_packet_priv;
+	struct stmmachdr *shdr;
+	unsigned int off;
+
+	/* Only the magic is checked, the full validation costs more per
+	 * packet than the driver RX path being measured.
+	 */
+	off = sizeof(struct iphdr) + sizeof(struct udphdr);
+	if (!pskb_may_pull(skb, off + sizeof(*shdr)))
+		goto out;
+
+	shdr = (struct stmmachdr *)(skb->data + off);
+	if (shdr->magic != cpu_to_be64(STMMAC_TEST_PKT_MAGIC))
+		goto out;
+
+	atomic_inc(&bpriv->rx);
+	WRITE_ONCE(bpriv->last_ns, ktime_get_ns());
+out:
+	kfree_skb(skb);
+	return 0;
+}
+
+static u64 stmmac_test_bench_irq_time(void)
+{
+	u64 ns = 0;
+	int cpu;
+
+	for_each_online_cpu(cpu)
+		ns += kcpustat_cpu(cpu).cpustat[CPUTIME_IRQ] +
+		      kcpustat_cpu(cpu).cpustat[CPUTIME_SOFTIRQ];
+
+	return ns;
+}
+
+/*
+ * Blast STMMAC_BENCH_PKTS UDP frames through the loopback and report the
+ * packet rate, the TX cost (time in dev_direct_xmit), the RX cost (IRQ and
+ * softirq time, which also covers TX cleanup) and the IRQ to RX NAPI
+ * latency, for the coalescing currently set with ethtool -C. Only fails
+ * when nothing comes back, the numbers are for the log.
+ */
+static int stmmac_test_bench(struct stmmac_priv *priv)
+{
+	u64 tx_ns = 0, lat_ns = 0, lat_max_ns = 0, irq_ns, start_ns, end_ns;
+	u32 rx_cnt = priv->plat->rx_queues_to_use;
+	struct stmmac_packet_attrs attr = { };
+	struct stmmac_bench_priv *bpriv;
+	unsigned long timeout;
+	u32 lat_cnt = 0, chan;
+	int ret = 0, sent = 0, rx;
+
+	bpriv = kzalloc(sizeof(*bpriv), GFP_KERNEL);
+	if (!bpriv)
+		return -ENOMEM;
+
+	atomic_set(&bpriv->rx, 0);
+	bpriv->pt.type = htons(ETH_P_IP);
+	bpriv->pt.func = stmmac_test_bench_validate;
+	bpriv->pt.dev = priv->dev;
+	bpriv->pt.af_packet_priv = bpriv;
+	dev_add_pack(&bpriv->pt);
+
+	attr.dst = priv->dev->dev_addr;
+
+	for (chan = 0; chan < rx_cnt; chan++) {
+		struct stmmac_channel *ch = &priv->channel[chan];
+
+		ch->bench_irq_ns = 0;
+		ch->bench_lat_ns = 0;
+		ch->bench_lat_max_ns = 0;
+		ch->bench_lat_cnt = 0;
+	}
+	WRITE_ONCE(priv->bench, true);
+
+	irq_ns = stmmac_test_bench_irq_time();
+	start_ns = ktime_get_ns();
+	timeout = jiffies + STMMAC_BENCH_TIMEOUT;
+
+	while (sent < STMMAC_BENCH_PKTS && time_before(jiffies, timeout)) {
+		struct sk_buff *skb;
+		u64 t;
+
+		skb = stmmac_test_get_udp_skb(priv, &attr);
+		if (!skb) {
+			ret = -ENOMEM;
+			break;
+		}
+
+		t = ktime_get_ns();
+		ret = dev_direct_xmit(skb, 0);
+		tx_ns += ktime_get_ns() - t;
+
+		/* Ring full, the skb is gone: let TX cleanup catch up */
+		if (ret == NETDEV_TX_BUSY) {
+			ret = 0;
+			usleep_range(10, 20);
+			continue;
+		}
+		if (ret)
+			break;
+		sent++;
+	}
+
+	/* Wait for the tail of the burst to come back */
+	do {
+		rx = atomic_read(&bpriv->rx);
+		msleep(20);
+	} while (rx != atomic_read(&bpriv->rx) && rx < sent);
+
+	WRITE_ONCE(priv->bench, false);
+	dev_remove_pack(&bpriv->pt);
+
+	irq_ns = stmmac_test_bench_irq_time() - irq_ns;
+	rx = atomic_read(&bpriv->rx);
+	end_ns = READ_ONCE(bpriv->last_ns);
+
+	for (chan = 0; chan < rx_cnt; chan++) {
+		struct stmmac_channel *ch = &priv->channel[chan];
+
+		lat_ns += ch->bench_lat_ns;
+		lat_cnt += ch->bench_lat_cnt;
+		lat_max_ns = max(lat_max_ns, ch->bench_lat_max_ns);
+	}
+
+	if (ret)
+		goto out;
+	if (!rx) {
+		ret = -ETIMEDOUT;
+		goto out;
+	}
+
+	netdev_info(priv->dev,
+		    "bench: %d/%d pkts, %llu pps, tx %llu ns/pkt, rx %llu ns/pkt\n",
+		    rx, sent,
+		    div64_u64((u64)rx * NSEC_PER_SEC,
+			      max_t(u64, end_ns - start_ns, 1)),
+		    div64_u64(tx_ns, max(sent, 1)), div64_u64(irq_ns, rx));
+	netdev_info(priv->dev,
+		    "bench: irq->napi avg %llu ns max %llu ns over %u polls\n",
+		    div64_u64(lat_ns, max(lat_cnt, 1U)), lat_max_ns, lat_cnt);
+	netdev_info(priv->dev,
+		    "bench: rx-usecs %u rx-frames %u tx-usecs %u tx-frames %u adaptive-rx %s\n",
+		    priv->use_riwt ?
+		    stmmac_riwt2usec(priv->rx_riwt, priv) : 0,
+		    priv->rx_coal_frames, priv->tx_coal_timer,
+		    priv->tx_coal_frames, priv->rx_dim_enabled ? "on" : "off");
+
+out:
+	kfree(bpriv);
+	return ret;
+}
+
 #define STMMAC_LOOPBACK_NONE	0
 #define STMMAC_LOOPBACK_MAC	1
 #define STMMAC_LOOPBACK_PHY	2
@@ -1948,6 +2256,18 @@ static const struct stmmac_test {
 		.name = "TBS (ETF Scheduler)        ",
 		.lb = STMMAC_LOOPBACK_PHY,
 		.fn = stmmac_test_tbs,
+	}, {
+		.name = "TX Checksum Offload        ",
+		.lb = STMMAC_LOOPBACK_PHY,
+		.fn = stmmac_test_tx_csum,
+	}, {
+		.name = "TSO                        ",
+		.lb = STMMAC_LOOPBACK_PHY,
+		.fn = stmmac_test_tso,
+	}, {
+		.name = "Loopback Benchmark         ",
+		.lb = STMMAC_LOOPBACK_PHY,
+		.fn = stmmac_test_bench,
 	},
 };
 
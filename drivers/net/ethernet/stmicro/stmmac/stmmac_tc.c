@@ -548,6 +548,59 @@ static struct {
 	{ .fn = tc_add_ports_flow },
 };
 
+static bool tc_flow_steering(struct stmmac_priv *priv)
+{
+	int i;
+
+	for (i = 0; i < priv->flow_entries_max; i++) {
+		struct stmmac_flow_entry *entry = &priv->flow_entries[i];
+
+		if (entry->in_use && (entry->action & STMMAC_FLOW_ACTION_QUEUE))
+			return true;
+	}
+
+	return false;
+}
+
+static void tc_flow_set_dyn_dma(struct stmmac_priv *priv, bool en)
+{
+	u32 queue;
+
+	for (queue = 0; queue < priv->plat->rx_queues_to_use; queue++)
+		stmmac_set_mtl_dyn_dma(priv, priv->hw, queue, en);
+}
+
+/*
+ * "hw_tc N" on a flower rule steers the matching packets to RX DMA
+ * channel N, e.g. RTP or PTP event ports onto a channel of their own so
+ * that they get a NAPI context not shared with bulk traffic.
+ */
+static int tc_parse_flow_queue(struct stmmac_priv *priv,
+			       struct flow_cls_offload *cls,
+			       struct stmmac_flow_entry *entry)
+{
+	struct netlink_ext_ack *extack = cls->common.extack;
+	u32 queue;
+
+	if (TC_H_MIN(cls->classid) < TC_H_MIN_PRIORITY)
+		return 0;
+
+	queue = TC_H_MIN(cls->classid) - TC_H_MIN_PRIORITY;
+	if (queue >= priv->plat->rx_queues_to_use) {
+		NL_SET_ERR_MSG_MOD(extack, "hw_tc exceeds the RX queues in use");
+		return -EINVAL;
+	}
+
+	if (priv->plat->has_xgmac || priv->synopsys_id < DWMAC_CORE_4_10) {
+		NL_SET_ERR_MSG_MOD(extack, "RX steering needs a GMAC 4.10 or later");
+		return -EOPNOTSUPP;
+	}
+
+	entry->action |= STMMAC_FLOW_ACTION_QUEUE;
+	entry->queue = queue;
+	return 0;
+}
+
 static int tc_add_flow(struct stmmac_priv *priv,
 		       struct flow_cls_offload *cls)
 {
@@ -561,11 +614,24 @@ static int tc_add_flow(struct stmmac_priv *priv,
 			return -ENOENT;
 	}
 
-	ret = tc_parse_flow_actions(priv, &rule->action, entry,
-				    cls->common.extack);
+	entry->action = 0;
+	ret = tc_parse_flow_queue(priv, cls, entry);
 	if (ret)
 		return ret;
 
+	/* A steering rule needs no action, it keeps the packet */
+	if (!(entry->action & STMMAC_FLOW_ACTION_QUEUE) ||
+	    flow_action_has_entries(&rule->action)) {
+		ret = tc_parse_flow_actions(priv, &rule->action, entry,
+					    cls->common.extack);
+		if (ret)
+			return ret;
+	}
+
+	if ((entry->action & STMMAC_FLOW_ACTION_QUEUE) &&
+	    (entry->action & STMMAC_FLOW_ACTION_DROP))
+		return -EINVAL;
+
 	for (i = 0; i < ARRAY_SIZE(tc_flow_parsers); i++) {
 		ret = tc_flow_parsers[i].fn(priv, cls, entry);
 		if (!ret) {
@@ -577,6 +643,11 @@ static int tc_add_flow(struct stmmac_priv *priv,
 	if (!entry->in_use)
 		return -EINVAL;
 
+	if (entry->action & STMMAC_FLOW_ACTION_QUEUE)
+		stmmac_config_l3l4_dma(priv, priv->hw, entry->idx, true,
+				       entry->queue);
+	tc_flow_set_dyn_dma(priv, tc_flow_steering(priv));
+
 	entry->cookie = cls->cookie;
 	return 0;
 }
@@ -601,6 +672,10 @@ static int tc_del_flow(struct stmmac_priv *priv,
 	entry->in_use = false;
 	entry->cookie = 0;
 	entry->is_l4 = false;
+	entry->action = 0;
+
+	/* Unmatched traffic follows the DA filter channel while dynamic */
+	tc_flow_set_dyn_dma(priv, tc_flow_steering(priv));
 	return ret;
 }
 
@@ -10,6 +10,7 @@
 #include <linux/of_net.h>
 #include <linux/uio_driver.h>
 #include <linux/list.h>
+#include <uapi/linux/stmmac_uio.h>
 
 #include <linux/clk.h>
 #include <linux/kernel.h>
@@ -43,7 +44,7 @@
 #include "mmc.h"
 
 #define DRIVER_NAME	"rockchip_gmac_uio_drv"
-#define DRIVER_VERSION	"0.1"
+#define DRIVER_VERSION	"0.2"
 
 #define TC_DEFAULT 64
 static int tc = TC_DEFAULT;
@@ -53,6 +54,10 @@ static int buf_sz = DEFAULT_BUFSIZE;
 
 #define STMMAC_RX_COPYBREAK	256
 
+/* Channel register blocks, see DMA_CHANX_BASE_ADDR() and dwmac_dma.h */
+#define UIO_GMAC4_DMA_CHAN(x)	(0x00001100 + (0x80 * (x)))
+#define UIO_DWMAC_DMA_BASE	0x00001000
+
 /**
  * rockchip_gmac_uio_pdev_info
  * local information for uio module driver
@@ -62,6 +67,13 @@ static int buf_sz = DEFAULT_BUFSIZE;
  * @name:     uio name
  * @uio:      uio information
  * @map_num:  number of uio memory regions
+ * @chan:     DMA channel owned by userspace
+ * @coexist:  the stack keeps running on the other channels
+ * @rx_ring:  RX ring of the channel, allocated here in coexist mode
+ * @tx_ring:  TX ring of the channel, allocated here in coexist mode
+ * @buf:      RX packet buffers followed by the TX ones
+ * @tx_buf_offset: start of the TX buffers in @buf
+ * @info:     page exported as STMMAC_UIO_MAP_INFO
  */
 struct rockchip_gmac_uio_pdev_info {
 	struct device *dev;
@@ -69,6 +81,20 @@ struct rockchip_gmac_uio_pdev_info {
 	char name[16];
 	struct uio_info uio;
 	int map_num;
+
+	u32 chan;
+	bool coexist;
+	void *rx_ring;
+	dma_addr_t rx_ring_dma;
+	size_t rx_ring_len;
+	void *tx_ring;
+	dma_addr_t tx_ring_dma;
+	size_t tx_ring_len;
+	void *buf;
+	dma_addr_t buf_dma;
+	size_t buf_len;
+	size_t tx_buf_offset;
+	struct stmmac_uio_info *info;
 };
 
 static int rockchip_gmac_uio_open(struct uio_info *info, struct inode *inode)
@@ -85,15 +111,25 @@ static int rockchip_gmac_uio_release(struct uio_info *info,
 static int rockchip_gmac_uio_mmap(struct uio_info *info,
 				  struct vm_area_struct *vma)
 {
-	u32 ret;
-	u32 pfn;
+	unsigned long pfn;
+	int ret;
 
 	pfn = (info->mem[vma->vm_pgoff].addr) >> PAGE_SHIFT;
 
-	if (vma->vm_pgoff)
-		vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
-	else
+	switch (vma->vm_pgoff) {
+	case STMMAC_UIO_MAP_REGS:
 		vma->vm_page_prot = pgprot_device(vma->vm_page_prot);
+		break;
+	case STMMAC_UIO_MAP_INFO:
+		/* Plain kernel memory, read-only for userspace */
+		if (vma->vm_flags & VM_WRITE)
+			return -EPERM;
+		vma->vm_flags &= ~VM_MAYWRITE;
+		break;
+	default:
+		vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+		break;
+	}
 
 	ret = remap_pfn_range(vma, vma->vm_start, pfn,
 			      vma->vm_end - vma->vm_start, vma->vm_page_prot);
@@ -104,6 +140,55 @@ static int rockchip_gmac_uio_mmap(struct uio_info *info,
 	return ret;
 }
 
+static irqreturn_t rockchip_gmac_uio_irq(int irq, struct uio_info *info)
+{
+	struct rockchip_gmac_uio_pdev_info *pdev_info = info->priv;
+	struct stmmac_priv *priv = netdev_priv(pdev_info->ndev);
+	int status;
+
+	/* Only look at our channel, the line may be shared with the stack */
+	status = stmmac_dma_interrupt_status(priv, priv->ioaddr, &priv->xstats,
+					     pdev_info->chan);
+	if (!status)
+		return IRQ_NONE;
+
+	/* Masked until userspace writes to the UIO device */
+	stmmac_disable_dma_irq(priv, priv->ioaddr, pdev_info->chan, 1, 1);
+
+	return IRQ_HANDLED;
+}
+
+static int rockchip_gmac_uio_irqcontrol(struct uio_info *info, s32 irq_on)
+{
+	struct rockchip_gmac_uio_pdev_info *pdev_info = info->priv;
+	struct stmmac_priv *priv = netdev_priv(pdev_info->ndev);
+
+	if (irq_on)
+		stmmac_enable_dma_irq(priv, priv->ioaddr, pdev_info->chan, 1, 1);
+	else
+		stmmac_disable_dma_irq(priv, priv->ioaddr, pdev_info->chan, 1, 1);
+
+	return 0;
+}
+
+static size_t uio_rx_desc_size(struct stmmac_priv *priv)
+{
+	if (priv->extend_desc)
+		return sizeof(struct dma_extended_desc);
+
+	return sizeof(struct dma_desc);
+}
+
+static size_t uio_tx_desc_size(struct stmmac_priv *priv, u32 chan)
+{
+	if (priv->extend_desc)
+		return sizeof(struct dma_extended_desc);
+	if (priv->tx_queue[chan].tbs & STMMAC_TBS_AVAIL)
+		return sizeof(struct dma_edesc);
+
+	return sizeof(struct dma_desc);
+}
+
 /**
  * uio_free_dma_rx_desc_resources - free RX dma desc resources
  * @priv: private structure
@@ -885,6 +970,10 @@ static int uio_release(struct net_device *dev)
 							 false);
 	}
 
+	/* Userspace may have left the DMA running on our rings */
+	stmmac_stop_rx(priv, priv->ioaddr, 0);
+	stmmac_stop_tx(priv, priv->ioaddr, 0);
+
 	/* Release and free the Rx/Tx resources */
 	uio_free_dma_desc_resources(priv);
 
@@ -896,6 +985,214 @@ static int uio_release(struct net_device *dev)
 	return 0;
 }
 
+static int uio_alloc_buffers(struct rockchip_gmac_uio_pdev_info *pdev_info)
+{
+	struct stmmac_priv *priv = netdev_priv(pdev_info->ndev);
+
+	pdev_info->tx_buf_offset = PAGE_ALIGN(priv->dma_rx_size *
+					      priv->dma_buf_sz);
+	pdev_info->buf_len = pdev_info->tx_buf_offset +
+			     PAGE_ALIGN(priv->dma_tx_size * priv->dma_buf_sz);
+	pdev_info->buf = dma_alloc_coherent(priv->device, pdev_info->buf_len,
+					    &pdev_info->buf_dma, GFP_KERNEL);
+	if (!pdev_info->buf)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static void uio_free_buffers(struct rockchip_gmac_uio_pdev_info *pdev_info)
+{
+	struct stmmac_priv *priv = netdev_priv(pdev_info->ndev);
+
+	dma_free_coherent(priv->device, pdev_info->buf_len, pdev_info->buf,
+			  pdev_info->buf_dma);
+	pdev_info->buf = NULL;
+}
+
+/**
+ * uio_init_info - fill the page exported as STMMAC_UIO_MAP_INFO
+ * @pdev_info: local information
+ * @res: register resource of the GMAC
+ */
+static int uio_init_info(struct rockchip_gmac_uio_pdev_info *pdev_info,
+			 struct resource *res)
+{
+	struct stmmac_priv *priv = netdev_priv(pdev_info->ndev);
+	struct stmmac_uio_info *info;
+	u32 chan = pdev_info->chan;
+
+	info = (struct stmmac_uio_info *)get_zeroed_page(GFP_KERNEL);
+	if (!info)
+		return -ENOMEM;
+
+	info->magic = STMMAC_UIO_MAGIC;
+	info->version = STMMAC_UIO_ABI_VERSION;
+
+	if (priv->plat->has_xgmac) {
+		info->flags |= STMMAC_UIO_F_XGMAC;
+		info->chan_regs = XGMAC_DMA_CH_CONTROL(chan);
+	} else if (priv->plat->has_gmac4) {
+		info->flags |= STMMAC_UIO_F_GMAC4;
+		info->chan_regs = UIO_GMAC4_DMA_CHAN(chan);
+	} else {
+		info->chan_regs = UIO_DWMAC_DMA_BASE;
+	}
+	if (priv->extend_desc)
+		info->flags |= STMMAC_UIO_F_EXT_DESC;
+	if (pdev_info->coexist)
+		info->flags |= STMMAC_UIO_F_COEXIST;
+
+	info->synopsys_id = priv->synopsys_id;
+	info->channel = chan;
+	info->regs_offset = res->start & ~PAGE_MASK;
+	info->rx_desc_size = uio_rx_desc_size(priv);
+	info->tx_desc_size = uio_tx_desc_size(priv, chan);
+	info->rx_ring_size = priv->dma_rx_size;
+	info->tx_ring_size = priv->dma_tx_size;
+	info->buf_size = priv->dma_buf_sz;
+	info->rx_ring_dma = pdev_info->rx_ring_dma;
+	info->tx_ring_dma = pdev_info->tx_ring_dma;
+	info->tx_buf_offset = pdev_info->tx_buf_offset;
+	info->rx_buf_dma = pdev_info->buf_dma;
+	info->tx_buf_dma = pdev_info->buf_dma + pdev_info->tx_buf_offset;
+
+	pdev_info->info = info;
+
+	return 0;
+}
+
+/**
+ * uio_lend_channel - hand the last DMA channel over to userspace
+ * @pdev_info: local information
+ * Description: coexist mode. The interface stays up on the other
+ * channels; this one is hidden from the stack and reprogrammed with
+ * rings owned by the UIO device. Traffic reaches it through the usual
+ * MTL queue routing, RSS must not spread flows onto it. Called with
+ * rtnl held.
+ */
+static int uio_lend_channel(struct rockchip_gmac_uio_pdev_info *pdev_info)
+{
+	struct net_device *ndev = pdev_info->ndev;
+	struct stmmac_priv *priv = netdev_priv(ndev);
+	u32 chan = priv->plat->rx_queues_to_use - 1;
+	struct stmmac_channel *ch = &priv->channel[chan];
+	struct netdev_queue *txq;
+
+	if (!netif_running(ndev)) {
+		dev_err(pdev_info->dev, "%s must be up for coexist mode\n",
+			ndev->name);
+		return -ENETDOWN;
+	}
+
+	if (!chan || priv->plat->tx_queues_to_use != chan + 1) {
+		dev_err(pdev_info->dev,
+			"coexist mode needs matching RX/TX queues, at least 2\n");
+		return -EINVAL;
+	}
+
+	pdev_info->chan = chan;
+
+	pdev_info->rx_ring_len = priv->dma_rx_size * uio_rx_desc_size(priv);
+	pdev_info->rx_ring = dma_alloc_coherent(priv->device,
+						pdev_info->rx_ring_len,
+						&pdev_info->rx_ring_dma,
+						GFP_KERNEL);
+	if (!pdev_info->rx_ring)
+		return -ENOMEM;
+
+	pdev_info->tx_ring_len = priv->dma_tx_size *
+				 uio_tx_desc_size(priv, chan);
+	pdev_info->tx_ring = dma_alloc_coherent(priv->device,
+						pdev_info->tx_ring_len,
+						&pdev_info->tx_ring_dma,
+						GFP_KERNEL);
+	if (!pdev_info->tx_ring) {
+		dma_free_coherent(priv->device, pdev_info->rx_ring_len,
+				  pdev_info->rx_ring, pdev_info->rx_ring_dma);
+		pdev_info->rx_ring = NULL;
+		return -ENOMEM;
+	}
+
+	/* Take the channel away from the stack... */
+	set_bit(chan, &priv->uio_chans);
+	synchronize_irq(ndev->irq);
+	napi_disable(&ch->rx_napi);
+	napi_disable(&ch->tx_napi);
+
+	netif_set_real_num_rx_queues(ndev, chan);
+	netif_set_real_num_tx_queues(ndev, chan);
+
+	/* wait for a transmit in flight, never leave the queue stopped */
+	txq = netdev_get_tx_queue(ndev, chan);
+	__netif_tx_lock_bh(txq);
+	netif_tx_start_queue(txq);
+	__netif_tx_unlock_bh(txq);
+
+	stmmac_disable_dma_irq(priv, priv->ioaddr, chan, 1, 1);
+	stmmac_stop_rx(priv, priv->ioaddr, chan);
+	stmmac_stop_tx(priv, priv->ioaddr, chan);
+
+	/* ...and point it at empty rings for userspace to fill */
+	stmmac_init_rx_chan(priv, priv->ioaddr, priv->plat->dma_cfg,
+			    pdev_info->rx_ring_dma, chan);
+	stmmac_init_tx_chan(priv, priv->ioaddr, priv->plat->dma_cfg,
+			    pdev_info->tx_ring_dma, chan);
+	stmmac_set_rx_ring_len(priv, priv->ioaddr, priv->dma_rx_size - 1, chan);
+	stmmac_set_tx_ring_len(priv, priv->ioaddr, priv->dma_tx_size - 1, chan);
+	stmmac_set_rx_tail_ptr(priv, priv->ioaddr, pdev_info->rx_ring_dma, chan);
+	stmmac_set_tx_tail_ptr(priv, priv->ioaddr, pdev_info->tx_ring_dma, chan);
+
+	return 0;
+}
+
+/**
+ * uio_reclaim_channel - give the lent channel back to the stack
+ * @pdev_info: local information
+ * Description: the kernel rings of the channel went stale while it was
+ * lent, so the interface is restarted to reprogram it. Called with rtnl
+ * held.
+ */
+static void uio_reclaim_channel(struct rockchip_gmac_uio_pdev_info *pdev_info)
+{
+	struct net_device *ndev = pdev_info->ndev;
+	struct stmmac_priv *priv = netdev_priv(ndev);
+	u32 chan = pdev_info->chan;
+	struct stmmac_channel *ch = &priv->channel[chan];
+
+	stmmac_disable_dma_irq(priv, priv->ioaddr, chan, 1, 1);
+	stmmac_stop_rx(priv, priv->ioaddr, chan);
+	stmmac_stop_tx(priv, priv->ioaddr, chan);
+
+	napi_enable(&ch->rx_napi);
+	napi_enable(&ch->tx_napi);
+	clear_bit(chan, &priv->uio_chans);
+
+	dev_close(ndev);
+	dev_open(ndev, NULL);
+
+	dma_free_coherent(priv->device, pdev_info->tx_ring_len,
+			  pdev_info->tx_ring, pdev_info->tx_ring_dma);
+	dma_free_coherent(priv->device, pdev_info->rx_ring_len,
+			  pdev_info->rx_ring, pdev_info->rx_ring_dma);
+	pdev_info->tx_ring = NULL;
+	pdev_info->rx_ring = NULL;
+}
+
+static void rockchip_gmac_uio_restore(struct rockchip_gmac_uio_pdev_info *pdev_info)
+{
+	struct net_device *netdev = pdev_info->ndev;
+
+	rtnl_lock();
+	if (pdev_info->coexist) {
+		uio_reclaim_channel(pdev_info);
+	} else {
+		uio_release(netdev);
+		dev_open(netdev, NULL);
+	}
+	rtnl_unlock();
+}
+
 /**
  * rockchip_gmac_uio_probe() platform driver probe routine
  * - register uio devices filled with memory maps retrieved
@@ -912,6 +1209,8 @@ static int rockchip_gmac_uio_probe(struct platform_device *pdev)
 	struct resource *res;
 	int err = 0;
 
+	BUILD_BUG_ON(STMMAC_UIO_MAP_NUM > MAX_UIO_MAPS);
+
 	pdev_info = devm_kzalloc(dev, sizeof(struct rockchip_gmac_uio_pdev_info),
 				 GFP_KERNEL);
 	if (!pdev_info)
@@ -934,43 +1233,81 @@ static int rockchip_gmac_uio_probe(struct platform_device *pdev)
 	}
 
 	pdev_info->ndev = netdev;
-	rtnl_lock();
-	dev_close(netdev);
-	rtnl_unlock();
+	pdev_info->coexist = of_property_read_bool(np, "rockchip,uio-coexist");
 
 	rtnl_lock();
-	err = uio_open(netdev);
+	if (pdev_info->coexist) {
+		err = uio_lend_channel(pdev_info);
+	} else {
+		dev_close(netdev);
+		err = uio_open(netdev);
+	}
+	rtnl_unlock();
 	if (err) {
-		rtnl_unlock();
 		dev_err(dev, "Failed to open stmmac resource: %d\n", err);
 		return err;
 	}
-	rtnl_unlock();
 
 	priv = netdev_priv(netdev);
+	if (!pdev_info->coexist) {
+		pdev_info->chan = 0;
+		pdev_info->rx_ring_dma = priv->rx_queue[0].dma_rx_phy;
+		pdev_info->rx_ring_len = priv->dma_rx_size *
+					 uio_rx_desc_size(priv);
+		pdev_info->tx_ring_dma = priv->tx_queue[0].dma_tx_phy;
+		pdev_info->tx_ring_len = priv->dma_tx_size *
+					 uio_tx_desc_size(priv, 0);
+	}
+
 	snprintf(pdev_info->name, sizeof(pdev_info->name), "uio_%s",
 		 netdev->name);
 	uio->name = pdev_info->name;
 	uio->version = DRIVER_VERSION;
 
 	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
-	if (!res)
-		return -ENODEV;
-
-	uio->mem[0].name = "eth_regs";
-	uio->mem[0].addr = res->start & PAGE_MASK;
-	uio->mem[0].size = PAGE_ALIGN(resource_size(res));
-	uio->mem[0].memtype = UIO_MEM_PHYS;
-
-	uio->mem[1].name = "eth_rx_bd";
-	uio->mem[1].addr = priv->rx_queue[0].dma_rx_phy;
-	uio->mem[1].size = priv->dma_rx_size * sizeof(struct dma_desc);
-	uio->mem[1].memtype = UIO_MEM_PHYS;
+	if (!res) {
+		err = -ENODEV;
+		goto err_restore;
+	}
 
-	uio->mem[2].name = "eth_tx_bd";
-	uio->mem[2].addr = priv->tx_queue[0].dma_tx_phy;
-	uio->mem[2].size = priv->dma_tx_size * sizeof(struct dma_desc);
-	uio->mem[2].memtype = UIO_MEM_PHYS;
+	err = uio_alloc_buffers(pdev_info);
+	if (err)
+		goto err_restore;
+
+	err = uio_init_info(pdev_info, res);
+	if (err)
+		goto err_free_buffers;
+
+	uio->mem[STMMAC_UIO_MAP_REGS].name = "eth_regs";
+	uio->mem[STMMAC_UIO_MAP_REGS].addr = res->start & PAGE_MASK;
+	uio->mem[STMMAC_UIO_MAP_REGS].size = PAGE_ALIGN(resource_size(res));
+	uio->mem[STMMAC_UIO_MAP_REGS].memtype = UIO_MEM_PHYS;
+
+	uio->mem[STMMAC_UIO_MAP_RX_RING].name = "eth_rx_bd";
+	uio->mem[STMMAC_UIO_MAP_RX_RING].addr = pdev_info->rx_ring_dma;
+	uio->mem[STMMAC_UIO_MAP_RX_RING].size = pdev_info->rx_ring_len;
+	uio->mem[STMMAC_UIO_MAP_RX_RING].memtype = UIO_MEM_PHYS;
+
+	uio->mem[STMMAC_UIO_MAP_TX_RING].name = "eth_tx_bd";
+	uio->mem[STMMAC_UIO_MAP_TX_RING].addr = pdev_info->tx_ring_dma;
+	uio->mem[STMMAC_UIO_MAP_TX_RING].size = pdev_info->tx_ring_len;
+	uio->mem[STMMAC_UIO_MAP_TX_RING].memtype = UIO_MEM_PHYS;
+
+	uio->mem[STMMAC_UIO_MAP_BUF].name = "eth_buf";
+	uio->mem[STMMAC_UIO_MAP_BUF].addr = pdev_info->buf_dma;
+	uio->mem[STMMAC_UIO_MAP_BUF].size = pdev_info->buf_len;
+	uio->mem[STMMAC_UIO_MAP_BUF].memtype = UIO_MEM_PHYS;
+
+	uio->mem[STMMAC_UIO_MAP_INFO].name = "eth_info";
+	uio->mem[STMMAC_UIO_MAP_INFO].addr = virt_to_phys(pdev_info->info);
+	uio->mem[STMMAC_UIO_MAP_INFO].size = PAGE_SIZE;
+	uio->mem[STMMAC_UIO_MAP_INFO].memtype = UIO_MEM_PHYS;
+
+	/* Channel interrupts wake up read()/poll() on the UIO device */
+	uio->irq = netdev->irq;
+	uio->irq_flags = IRQF_SHARED;
+	uio->handler = rockchip_gmac_uio_irq;
+	uio->irqcontrol = rockchip_gmac_uio_irqcontrol;
 
 	uio->open = rockchip_gmac_uio_open;
 	uio->release = rockchip_gmac_uio_release;
@@ -981,17 +1318,27 @@ static int rockchip_gmac_uio_probe(struct platform_device *pdev)
 	err = uio_register_device(dev, uio);
 	if (err) {
 		dev_err(dev, "Failed to register uio device: %d\n", err);
-		return err;
+		goto err_free_info;
 	}
 
-	pdev_info->map_num = 3;
+	pdev_info->map_num = STMMAC_UIO_MAP_NUM;
+	stmmac_enable_dma_irq(priv, priv->ioaddr, pdev_info->chan, 1, 1);
 
-	dev_info(dev, "Registered %s uio devices, %d register maps attached\n",
-		 pdev_info->name, pdev_info->map_num);
+	dev_info(dev, "Registered %s uio devices, %d register maps attached, channel %u%s\n",
+		 pdev_info->name, pdev_info->map_num, pdev_info->chan,
+		 pdev_info->coexist ? " (coexist)" : "");
 
 	platform_set_drvdata(pdev, pdev_info);
 
 	return 0;
+
+err_free_info:
+	free_page((unsigned long)pdev_info->info);
+err_free_buffers:
+	uio_free_buffers(pdev_info);
+err_restore:
+	rockchip_gmac_uio_restore(pdev_info);
+	return err;
 }
 
 /**
@@ -1002,28 +1349,19 @@ static int rockchip_gmac_uio_remove(struct platform_device *pdev)
 {
 	struct rockchip_gmac_uio_pdev_info *pdev_info =
 					platform_get_drvdata(pdev);
-	struct net_device *netdev;
 
 	if (!pdev_info)
 		return -EINVAL;
 
-	netdev = pdev_info->ndev;
-
 	uio_unregister_device(&pdev_info->uio);
 
-	if (netdev) {
-		rtnl_lock();
-		uio_release(netdev);
-		rtnl_unlock();
-	}
+	/* Stops the channel DMA before its buffers go away */
+	rockchip_gmac_uio_restore(pdev_info);
 
-	platform_set_drvdata(pdev, NULL);
+	uio_free_buffers(pdev_info);
+	free_page((unsigned long)pdev_info->info);
 
-	if (netdev) {
-		rtnl_lock();
-		dev_open(netdev, NULL);
-		rtnl_unlock();
-	}
+	platform_set_drvdata(pdev, NULL);
 
 	return 0;
 }
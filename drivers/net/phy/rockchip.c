@@ -15,6 +15,7 @@
 #include <linux/mii.h>
 #include <linux/netdevice.h>
 #include <linux/phy.h>
+#include <linux/workqueue.h>
 
 #define INTERNAL_EPHY_ID			0x1234d400
 
@@ -39,6 +40,15 @@
 
 #define WR_ADDR_A7CFG				0x18
 
+#define FAST_LINK_POLL_MS			20
+#define FAST_LINK_TIMEOUT_MS			5000
+
+struct rockchip_phy_priv {
+	struct phy_device *phydev;
+	struct delayed_work link_work;
+	unsigned long link_timeout;
+};
+
 static int rockchip_init_tstmode(struct phy_device *phydev)
 {
 	int ret;
@@ -152,15 +162,61 @@ static int rockchip_set_polarity(struct phy_device *phydev, int polarity)
 	return 0;
 }
 
+/*
+ * Without an interrupt phylib looks at the link once a second, so a link
+ * that negotiates in ~1.5s is only reported up to a second later. Watch
+ * BMSR closely after each (re)start of the negotiation and kick the state
+ * machine as soon as the link is there.
+ */
+static void rockchip_link_work(struct work_struct *work)
+{
+	struct rockchip_phy_priv *priv = container_of(to_delayed_work(work),
+						      struct rockchip_phy_priv,
+						      link_work);
+	struct phy_device *phydev = priv->phydev;
+	int val;
+
+	if (phydev->link)
+		return;
+
+	val = phy_read(phydev, MII_BMSR);
+	if (val >= 0 && (val & BMSR_LSTATUS)) {
+		phy_mac_interrupt(phydev);
+		return;
+	}
+
+	if (time_before(jiffies, priv->link_timeout))
+		schedule_delayed_work(&priv->link_work,
+				      msecs_to_jiffies(FAST_LINK_POLL_MS));
+}
+
 static int rockchip_config_aneg(struct phy_device *phydev)
 {
+	struct rockchip_phy_priv *priv = phydev->priv;
 	int err;
 
 	err = rockchip_set_polarity(phydev, phydev->mdix);
 	if (err < 0)
 		return err;
 
-	return genphy_config_aneg(phydev);
+	err = genphy_config_aneg(phydev);
+	if (err < 0 || !phy_polling_mode(phydev))
+		return err;
+
+	priv->link_timeout = jiffies + msecs_to_jiffies(FAST_LINK_TIMEOUT_MS);
+	mod_delayed_work(system_wq, &priv->link_work,
+			 msecs_to_jiffies(FAST_LINK_POLL_MS));
+
+	return err;
+}
+
+static int rockchip_phy_suspend(struct phy_device *phydev)
+{
+	struct rockchip_phy_priv *priv = phydev->priv;
+
+	cancel_delayed_work_sync(&priv->link_work);
+
+	return genphy_suspend(phydev);
 }
 
 static int rockchip_phy_resume(struct phy_device *phydev)
@@ -170,6 +226,28 @@ static int rockchip_phy_resume(struct phy_device *phydev)
 	return rockchip_integrated_phy_config_init(phydev);
 }
 
+static int rockchip_phy_probe(struct phy_device *phydev)
+{
+	struct rockchip_phy_priv *priv;
+
+	priv = devm_kzalloc(&phydev->mdio.dev, sizeof(*priv), GFP_KERNEL);
+	if (!priv)
+		return -ENOMEM;
+
+	priv->phydev = phydev;
+	INIT_DELAYED_WORK(&priv->link_work, rockchip_link_work);
+	phydev->priv = priv;
+
+	return 0;
+}
+
+static void rockchip_phy_remove(struct phy_device *phydev)
+{
+	struct rockchip_phy_priv *priv = phydev->priv;
+
+	cancel_delayed_work_sync(&priv->link_work);
+}
+
 static struct phy_driver rockchip_phy_driver[] = {
 {
 	.phy_id			= INTERNAL_EPHY_ID,
@@ -177,11 +255,13 @@ static struct phy_driver rockchip_phy_driver[] = {
 	.name			= "Rockchip integrated EPHY",
 	/* PHY_BASIC_FEATURES */
 	.flags			= 0,
+	.probe			= rockchip_phy_probe,
+	.remove			= rockchip_phy_remove,
 	.link_change_notify	= rockchip_link_change_notify,
 	.soft_reset		= genphy_soft_reset,
 	.config_init		= rockchip_integrated_phy_config_init,
 	.config_aneg		= rockchip_config_aneg,
-	.suspend		= genphy_suspend,
+	.suspend		= rockchip_phy_suspend,
 	.resume			= rockchip_phy_resume,
 },
 };
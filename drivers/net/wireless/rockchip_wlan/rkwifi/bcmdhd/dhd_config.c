@@ -3903,6 +3903,14 @@ dhd_conf_read_sdio_params(dhd_pub_t *dhd, char *full_param, uint len_param)
 			conf->txglomsize = SDPCM_MAXGLOM_SIZE;
 		CONFIG_MSG("txglomsize = %d\n", conf->txglomsize);
 	}
+	else if (!strncmp("txglom_adapt_us=", full_param, len_param)) {
+		conf->txglom_adapt_us = (uint)simple_strtol(data, NULL, 10);
+		CONFIG_MSG("txglom_adapt_us = %d\n", conf->txglom_adapt_us);
+	}
+	else if (!strncmp("txglom_hipri_max=", full_param, len_param)) {
+		conf->txglom_hipri_max = (uint)simple_strtol(data, NULL, 10);
+		CONFIG_MSG("txglom_hipri_max = %d\n", conf->txglom_hipri_max);
+	}
 	else if (!strncmp("txglom_ext=", full_param, len_param)) {
 		if (!strncmp(data, "0", 1))
 			conf->txglom_ext = FALSE;
@@ -4671,6 +4679,8 @@ dhd_conf_set_txglom_params(dhd_pub_t *dhd, bool enable)
 			conf->txglom_mode==SDPCM_TXGLOM_MDESC?"multi-desc":"copy");
 		CONFIG_MSG("txglomsize=%d, deferred_tx_len=%d\n",
 			conf->txglomsize, conf->deferred_tx_len);
+		CONFIG_MSG("txglom_adapt_us=%d, txglom_hipri_max=%d\n",
+			conf->txglom_adapt_us, conf->txglom_hipri_max);
 		CONFIG_MSG("txinrx_thres=%d, dhd_txminmax=%d\n",
 			conf->txinrx_thres, conf->dhd_txminmax);
 		CONFIG_MSG("tx_max_offset=%d, txctl_tmo_fix=%d\n",
@@ -4925,6 +4935,8 @@ dhd_conf_preinit(dhd_pub_t *dhd)
 	conf->txglom_ext = FALSE;
 	conf->tx_max_offset = 0;
 	conf->txglomsize = SDPCM_DEFGLOM_SIZE;
+	conf->txglom_adapt_us = 0;
+	conf->txglom_hipri_max = 0;
 	conf->txctl_tmo_fix = 300;
 	conf->txglom_mode = SDPCM_TXGLOM_CPY;
 	conf->deferred_tx_len = 0;
@@ -257,6 +257,8 @@ typedef struct dhd_conf {
 	*/
 	int tx_max_offset;
 	uint txglomsize;
+	uint txglom_adapt_us; /* 0: fixed txglomsize, else bus time budget of a glom */
+	uint txglom_hipri_max; /* 0: no cap, else max glom while VI/VO queued */
 	int txctl_tmo_fix;
 	bool txglom_mode;
 	uint deferred_tx_len;
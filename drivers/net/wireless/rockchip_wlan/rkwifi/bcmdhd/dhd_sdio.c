@@ -127,6 +127,12 @@ static int dhdsdio_resume(void *context);
 #define MAX_MEMBLOCK  (32 * 1024)	/* Block size used for downloading of dongle image */
 
 #define MAX_DATA_BUF	(64 * 1024)	/* Must be large enough to hold biggest possible glom */
+
+/* Adaptive tx glom: sizing interval, and the precedences capped by txglom_hipri_max */
+#define TXGLOM_ADAPT_INTERVAL_US	100000
+#define TXGLOM_HIPRI_PREC_MAP	((1 << PRIO2PREC(PRIO_8021D_VI)) | \
+				 (1 << PRIO2PREC(PRIO_8021D_VO)) | \
+				 (1 << PRIO2PREC(PRIO_8021D_NC)))
 #define MAX_MEM_BUF	4096
 
 #ifndef DHD_FIRSTREAD
@@ -470,6 +476,11 @@ typedef struct dhd_bus {
 	uint32		txglom_total_len;	/* Total length of pkts in glom array */
 	bool		txglom_enable;	/* Flag to indicate whether tx glom is enabled/disabled */
 	uint32		txglomsize;	/* Glom size limitation */
+	uint32		txglom_adapt;	/* Adaptive glom size, with conf->txglom_adapt_us */
+	uint32		txglom_adapt_start;	/* Start of the sizing interval (us) */
+	uint32		txglom_adapt_max_us;	/* Slowest tx glom of the interval */
+	uint		txglom_adapt_cnt;	/* Tx gloms sent in the interval */
+	uint		txglom_adapt_full;	/* ... of which full with more pkts queued */
 #ifdef DHDENABLE_TAILPAD
 	void		*pad_pkt;
 #endif /* DHDENABLE_TAILPAD */
@@ -2891,6 +2902,45 @@ static int dhdsdio_txpkt(dhd_bus_t *bus, uint chan, void** pkts, int num_pkt, bo
 	return ret;
 }
 
+/*
+ * Resize the tx glom once per interval: halve it when a glom kept the bus
+ * longer than conf->txglom_adapt_us, grow it when most gloms went out full
+ * with packets left behind and the bus time allows it.
+ */
+static void
+dhdsdio_txglom_adapt(dhd_bus_t *bus, uint32 spend_us, bool full)
+{
+	uint32 budget = bus->dhd->conf->txglom_adapt_us;
+	uint32 now = OSL_SYSUPTIME_US();
+
+	bus->txglom_adapt_cnt++;
+	if (full)
+		bus->txglom_adapt_full++;
+	if (spend_us > bus->txglom_adapt_max_us)
+		bus->txglom_adapt_max_us = spend_us;
+
+	if (now - bus->txglom_adapt_start < TXGLOM_ADAPT_INTERVAL_US)
+		return;
+
+	if (bus->txglom_adapt_max_us > budget) {
+		bus->txglom_adapt = MAX(bus->txglom_adapt / 2, 1);
+	} else if (bus->txglom_adapt_full * 2 > bus->txglom_adapt_cnt) {
+		if (bus->txglom_adapt_max_us * 2 <= budget)
+			bus->txglom_adapt *= 2;
+		else
+			bus->txglom_adapt++;
+		bus->txglom_adapt = MIN(bus->txglom_adapt, bus->txglomsize);
+	}
+	DHD_INFO(("%s: %u gloms, %u full, max %uus -> txglom %u\n", __FUNCTION__,
+		bus->txglom_adapt_cnt, bus->txglom_adapt_full,
+		bus->txglom_adapt_max_us, bus->txglom_adapt));
+
+	bus->txglom_adapt_start = now;
+	bus->txglom_adapt_max_us = 0;
+	bus->txglom_adapt_cnt = 0;
+	bus->txglom_adapt_full = 0;
+}
+
 static uint
 dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 {
@@ -2929,6 +2979,8 @@ dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 		void *pkts[MAX_TX_PKTCHAIN_CNT];
 		int prec_out;
 		uint datalen = 0;
+		uint32 txstart = 0;
+		bool full = FALSE;
 
 		dhd_os_sdlock_txq(bus->dhd);
 		if (bus->txglom_enable) {
@@ -2938,9 +2990,19 @@ dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 				glomlimit = MIN((uint32)bus->txglomsize, BLK_64_MAXTXGLOM);
 			}
 #endif /* BCMSDIOH_STD */
+			if (dhd->conf->txglom_adapt_us) {
+				if (!bus->txglom_adapt)
+					bus->txglom_adapt = glomlimit;
+				glomlimit = MIN(glomlimit, bus->txglom_adapt);
+			}
+			/* don't hold VI/VO behind a big glom of background traffic */
+			if (dhd->conf->txglom_hipri_max &&
+				pktq_mlen(&bus->txq, tx_prec_map & TXGLOM_HIPRI_PREC_MAP))
+				glomlimit = MIN(glomlimit, dhd->conf->txglom_hipri_max);
 			num_pkt = MIN((uint32)DATABUFCNT(bus), glomlimit);
 			num_pkt = MIN(num_pkt, ARRAYSIZE(pkts));
 		}
+		full = pktq_mlen(&bus->txq, tx_prec_map) > num_pkt;
 		num_pkt = MIN(num_pkt, pktq_mlen(&bus->txq, tx_prec_map));
 		for (i = 0; i < num_pkt; i++) {
 			pkts[i] = pktq_mdeq(&bus->txq, tx_prec_map, &prec_out);
@@ -2987,9 +3049,13 @@ dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 
 		if (i == 0)
 			break;
+		if (bus->txglom_enable && dhd->conf->txglom_adapt_us)
+			txstart = OSL_SYSUPTIME_US();
 		if (dhdsdio_txpkt(bus, SDPCM_DATA_CHANNEL, pkts, i, TRUE) != BCME_OK)
 			dhd->tx_errors++;
 		else {
+			if (txstart)
+				dhdsdio_txglom_adapt(bus, OSL_SYSUPTIME_US() - txstart, full);
 			dhd->dstats.tx_bytes += datalen;
 			bus->txglomframes++;
 			bus->txglompkts += num_pkt;
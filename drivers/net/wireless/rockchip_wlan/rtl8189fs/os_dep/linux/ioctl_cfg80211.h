@@ -169,6 +169,13 @@ struct rtw_wdev_priv {
 	bool block_scan;
 	bool power_mgmt;
 
+#ifdef CONFIG_LPS
+	/* media stream power save hold, see rtw_cfg80211_media_ps_kick() */
+	struct delayed_work media_ps_work;
+	systime media_ps_last;
+	bool media_ps_active;
+#endif
+
 	/* report mgmt_frame registered */
 	u16 report_mgmt;
 
@@ -196,6 +203,12 @@ struct rtw_wdev_priv {
 
 bool rtw_cfg80211_is_connect_requested(_adapter *adapter);
 
+#ifdef CONFIG_LPS
+void rtw_cfg80211_media_ps_kick(_adapter *adapter, u8 up);
+#else
+#define rtw_cfg80211_media_ps_kick(adapter, up) do {} while (0)
+#endif
+
 #if RTW_CFG80211_BLOCK_STA_DISCON_EVENT
 #define rtw_wdev_not_indic_disco(rtw_wdev_data) ((rtw_wdev_data)->not_indic_disco)
 #define rtw_wdev_set_not_indic_disco(rtw_wdev_data, val) do { (rtw_wdev_data)->not_indic_disco = (val); } while (0)
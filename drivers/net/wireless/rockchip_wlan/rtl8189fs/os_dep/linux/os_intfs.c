@@ -178,6 +178,11 @@ int rtw_acm_method = 0;/* 0:By SW 1:By HW. */
 
 int rtw_wmm_enable = 1;/* default is set to enable the wmm. */
 
+#if defined(CONFIG_IOCTL_CFG80211) && defined(CONFIG_LPS)
+/* keep the radio awake this long after the last AC_VI/AC_VO frame, 0: off */
+int rtw_media_ps_hold_ms = 1000;
+#endif
+
 #ifdef CONFIG_WMMPS_STA
 /* uapsd (unscheduled automatic power-save delivery) = a kind of wmmps */
 /* 0: NO_LIMIT, 1: TWO_MSDU, 2: FOUR_MSDU, 3: SIX_MSDU */
@@ -471,6 +476,10 @@ module_param(rtw_network_mode, int, 0644);
 module_param(rtw_channel, int, 0644);
 module_param(rtw_mp_mode, int, 0644);
 module_param(rtw_wmm_enable, int, 0644);
+#if defined(CONFIG_IOCTL_CFG80211) && defined(CONFIG_LPS)
+module_param(rtw_media_ps_hold_ms, int, 0644);
+MODULE_PARM_DESC(rtw_media_ps_hold_ms, "Stay out of LPS for this many ms after AC_VI/AC_VO traffic, 0 to disable");
+#endif
 #ifdef CONFIG_WMMPS_STA
 module_param(rtw_uapsd_max_sp, int, 0644);
 module_param(rtw_uapsd_ac_enable, int, 0644);
@@ -1469,9 +1478,17 @@ unsigned int rtw_classify8021d(struct sk_buff *skb)
 		dscp = ip_hdr(skb)->tos & 0xfc;
 		break;
 	default:
-		return 0;
+		dscp = 0;
+		break;
 	}
 
+	/* Unprivileged sockets may only set SO_PRIORITY 0..6, let that pick
+	 * the 802.1d priority of unmarked traffic so a media stream can ask
+	 * for AC_VI (4, 5) or AC_VO (6).
+	 */
+	if (!dscp && skb->priority <= 7)
+		return skb->priority;
+
 	return dscp >> 5;
 }
 
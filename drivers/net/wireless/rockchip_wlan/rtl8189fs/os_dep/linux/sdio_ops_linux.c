@@ -760,6 +760,23 @@ s32 sd_read(struct intf_hdl *pintfhdl, u32 addr, u32 cnt, void *pdata)
 	return err;
 }
 
+/*
+ * Pad a CMD53 write spanning more than one block up to whole blocks, so
+ * the core issues a single block mode transfer instead of blocks plus a
+ * byte mode tail, and the host can DMA it straight from the xmit buffer
+ * (dw_mmc IDMAC only takes multiples of 4 bytes). Register accesses never
+ * get that large, only TX FIFO writes do; the device takes the frame
+ * length from the TX descriptors and ignores the padding.
+ */
+static u32 rtw_sdio_cmd53_write_size(struct sdio_func *func, u32 cnt)
+{
+#ifdef CONFIG_RTW_SDIO_TX_BLOCK_ALIGN
+	if (cnt > func->cur_blksize)
+		return sdio_align_size(func, cnt);
+#endif
+	return cnt;
+}
+
 /*
  * Use CMD53 to write data to SDIO device.
  * This function MUST be called after sdio_claim_host() or
@@ -812,7 +829,7 @@ s32 _sd_write(struct intf_hdl *pintfhdl, u32 addr, u32 cnt, void *pdata)
 		return err;
 	}
 
-	size = cnt;
+	size = rtw_sdio_cmd53_write_size(func, cnt);
 	err = sdio_memcpy_toio(func, addr, pdata, size);
 	if (err)
 		RTW_ERR("%s: FAIL(%d)! ADDR=%#x Size=%d(%d)\n", __func__, err, addr, cnt, size);
@@ -1100,7 +1117,8 @@ int __must_check rtw_sdio_raw_write(struct dvobj_priv *d, unsigned int addr,
 			if (fixed)
 				error = sdio_writesb(func, addr, buf, len);
 			else
-				error = sdio_memcpy_toio(func, addr, buf, len);
+				error = sdio_memcpy_toio(func, addr, buf,
+					rtw_sdio_cmd53_write_size(func, len));
 		}
 	}
 
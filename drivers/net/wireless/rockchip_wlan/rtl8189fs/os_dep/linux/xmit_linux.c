@@ -19,6 +19,9 @@
 
 #define DBG_DUMP_OS_QUEUE_CTL 0
 
+/* SDIO block size programmed by sdio_init() */
+#define RTW_SDIO_TX_BLOCK_PAD 512
+
 uint rtw_remainder_len(struct pkt_file *pfile)
 {
 	return pfile->buf_len - ((SIZE_PTR)(pfile->cur_addr) - (SIZE_PTR)(pfile->buf_start));
@@ -126,6 +129,10 @@ int rtw_os_xmit_resource_alloc(_adapter *padapter, struct xmit_buf *pxmitbuf, u3
 			return _FAIL;
 #else /* CONFIG_USE_USB_BUFFER_ALLOC_TX */
 
+#if defined(CONFIG_SDIO_HCI) && defined(CONFIG_RTW_SDIO_TX_BLOCK_ALIGN)
+		/* room for padding the last CMD53 up to a whole block */
+		alloc_sz += RTW_SDIO_TX_BLOCK_PAD;
+#endif
 		pxmitbuf->pallocated_buf = rtw_zmalloc(alloc_sz);
 		if (pxmitbuf->pallocated_buf == NULL)
 			return _FAIL;
@@ -175,6 +182,9 @@ void rtw_os_xmit_resource_free(_adapter *padapter, struct xmit_buf *pxmitbuf, u3
 		pxmitbuf->pallocated_buf =  NULL;
 		pxmitbuf->dma_transfer_addr = 0;
 #else	/* CONFIG_USE_USB_BUFFER_ALLOC_TX */
+#if defined(CONFIG_SDIO_HCI) && defined(CONFIG_RTW_SDIO_TX_BLOCK_ALIGN)
+		free_sz += RTW_SDIO_TX_BLOCK_PAD;
+#endif
 		if (pxmitbuf->pallocated_buf)
 			rtw_mfree(pxmitbuf->pallocated_buf, free_sz);
 #endif /* CONFIG_USE_USB_BUFFER_ALLOC_TX */
@@ -482,6 +492,11 @@ int _rtw_xmit_entry(_pkt *pkt, _nic_hdl pnetdev)
 
 	rtw_check_xmit_resource(padapter, pkt);
 
+#ifdef CONFIG_IOCTL_CFG80211
+	/* rtw_select_queue() left the 802.1d priority in pkt->priority */
+	rtw_cfg80211_media_ps_kick(padapter, pkt->priority);
+#endif
+
 #ifdef CONFIG_TX_MCAST2UNI
 	if (!rtw_mc2u_disable
 		&& MLME_IS_AP(padapter)
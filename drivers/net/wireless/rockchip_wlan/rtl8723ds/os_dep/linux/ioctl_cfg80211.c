@@ -4130,6 +4130,55 @@ bool rtw_cfg80211_is_connect_requested(_adapter *adapter)
 	return requested;
 }
 
+#ifdef CONFIG_LPS
+/*
+ * Media streams: downlink frames for a dozing station wait for the next
+ * beacon, which makes players buffer hundreds of ms. While AC_VI or AC_VO
+ * frames flow in either direction, hold the radio in active mode and go
+ * back to the configured LPS mode rtw_media_ps_hold_ms after the last one.
+ */
+static void rtw_cfg80211_media_ps_work(struct work_struct *work)
+{
+	extern int rtw_media_ps_hold_ms;
+	struct rtw_wdev_priv *pwdev_priv = container_of(to_delayed_work(work),
+		struct rtw_wdev_priv, media_ps_work);
+	_adapter *adapter = pwdev_priv->padapter;
+	u32 idle_ms = rtw_get_passing_time_ms(pwdev_priv->media_ps_last);
+
+	if (rtw_media_ps_hold_ms > 0 && idle_ms < rtw_media_ps_hold_ms) {
+		if (!pwdev_priv->media_ps_active) {
+			RTW_INFO(FUNC_ADPT_FMT" media stream, leave LPS\n", FUNC_ADPT_ARG(adapter));
+			pwdev_priv->media_ps_active = _TRUE;
+			rtw_pm_set_lps(adapter, PS_MODE_ACTIVE);
+		}
+		schedule_delayed_work(&pwdev_priv->media_ps_work,
+			msecs_to_jiffies(rtw_media_ps_hold_ms - idle_ms));
+		return;
+	}
+
+	if (pwdev_priv->media_ps_active) {
+		RTW_INFO(FUNC_ADPT_FMT" media stream idle, restore LPS\n", FUNC_ADPT_ARG(adapter));
+		pwdev_priv->media_ps_active = _FALSE;
+		rtw_pm_set_lps(adapter, adapter->registrypriv.power_mgnt);
+	}
+}
+
+/* Called for each data frame sent or indicated, @up is its 802.1d priority */
+void rtw_cfg80211_media_ps_kick(_adapter *adapter, u8 up)
+{
+	extern int rtw_media_ps_hold_ms;
+	struct rtw_wdev_priv *pwdev_priv;
+
+	if (up < 4 || rtw_media_ps_hold_ms <= 0 || !MLME_IS_STA(adapter))
+		return;
+
+	pwdev_priv = adapter_wdev_data(adapter);
+	pwdev_priv->media_ps_last = rtw_get_current_time();
+	if (!pwdev_priv->media_ps_active)
+		schedule_delayed_work(&pwdev_priv->media_ps_work, 0);
+}
+#endif /* CONFIG_LPS */
+
 static int _rtw_disconnect(struct wiphy *wiphy, struct net_device *ndev)
 {
 	_adapter *padapter = (_adapter *)rtw_netdev_priv(ndev);
@@ -10515,6 +10564,11 @@ int rtw_wdev_alloc(_adapter *padapter, struct wiphy *wiphy)
 
 	_rtw_mutex_init(&pwdev_priv->roch_mutex);
 
+#ifdef CONFIG_LPS
+	INIT_DELAYED_WORK(&pwdev_priv->media_ps_work, rtw_cfg80211_media_ps_work);
+	pwdev_priv->media_ps_active = _FALSE;
+#endif
+
 #ifdef CONFIG_CONCURRENT_MODE
 	ATOMIC_SET(&pwdev_priv->switch_ch_to, 1);
 #endif
@@ -10573,6 +10627,10 @@ void rtw_wdev_unregister(struct wireless_dev *wdev)
 	adapter = (_adapter *)rtw_netdev_priv(ndev);
 	pwdev_priv = adapter_wdev_data(adapter);
 
+#ifdef CONFIG_LPS
+	cancel_delayed_work_sync(&pwdev_priv->media_ps_work);
+#endif
+
 	rtw_cfg80211_indicate_scan_done(adapter, _TRUE);
 
 	#if (LINUX_VERSION_CODE >= KERNEL_VERSION(3, 11, 0)) || defined(COMPAT_KERNEL_RELEASE)
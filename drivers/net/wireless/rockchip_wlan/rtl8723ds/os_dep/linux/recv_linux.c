@@ -642,6 +642,10 @@ int rtw_recv_indicatepkt(_adapter *padapter, union recv_frame *precv_frame)
 	if (precv_frame->u.hdr.pkt == NULL)
 		goto _recv_indicatepkt_drop;
 
+#ifdef CONFIG_IOCTL_CFG80211
+	rtw_cfg80211_media_ps_kick(padapter, precv_frame->u.hdr.attrib.priority);
+#endif
+
 	rtw_os_recv_indicate_pkt(padapter, precv_frame->u.hdr.pkt, precv_frame);
 
 	precv_frame->u.hdr.pkt = NULL;
@@ -2113,11 +2113,27 @@ static int ssv6200_set_key(struct ieee80211_hw *hw,
     printk(KERN_ERR "SET KEY %d\n", ret);
     return ret;
 }
+static void _splice_tx_done_q (struct ssv_softc *sc, struct sk_buff_head *batch, bool to_head)
+{
+    unsigned long flags;
+    spin_lock_irqsave(&sc->tx_done_q.lock, flags);
+    if (to_head)
+        skb_queue_splice_init(batch, &sc->tx_done_q);
+    else
+        skb_queue_splice_tail_init(batch, &sc->tx_done_q);
+    spin_unlock_irqrestore(&sc->tx_done_q.lock, flags);
+}
 u32 _process_tx_done (struct ssv_softc *sc)
 {
     struct ieee80211_tx_info *tx_info;
+    struct sk_buff_head batch;
     struct sk_buff *skb;
-    while ((skb = skb_dequeue(&sc->tx_done_q)))
+    unsigned long flags;
+    __skb_queue_head_init(&batch);
+    spin_lock_irqsave(&sc->tx_done_q.lock, flags);
+    skb_queue_splice_tail_init(&sc->tx_done_q, &batch);
+    spin_unlock_irqrestore(&sc->tx_done_q.lock, flags);
+    while ((skb = __skb_dequeue(&batch)))
     {
         struct ssv6200_tx_desc *tx_desc;
         tx_info = IEEE80211_SKB_CB(skb);
@@ -2142,7 +2158,11 @@ u32 _process_tx_done (struct ssv_softc *sc)
 #else
         ieee80211_tx_status(sc->hw, skb);
         if (skb_queue_len(&sc->rx_skb_q))
+        {
+            if (!skb_queue_empty(&batch))
+                _splice_tx_done_q(sc, &batch, true);
             break;
+        }
 #endif
     }
     return skb_queue_len(&sc->tx_done_q);
@@ -2157,7 +2177,9 @@ void ssv6xxx_tx_cb(struct sk_buff_head *skb_head, void *args)
 void ssv6xxx_tx_cb(struct sk_buff_head *skb_head, void *args)
 {
     struct ssv_softc *sc=(struct ssv_softc *)args;
+    struct sk_buff_head batch;
     struct sk_buff *skb;
+    __skb_queue_head_init(&batch);
     while ((skb=skb_dequeue(skb_head)))
     {
         struct ieee80211_tx_info *tx_info = IEEE80211_SKB_CB(skb);
@@ -2171,8 +2193,11 @@ void ssv6xxx_tx_cb(struct sk_buff_head *skb_head, void *args)
         }
         if (tx_info->flags & IEEE80211_TX_CTL_AMPDU)
             ssv6xxx_ampdu_sent(sc->hw, skb);
-        skb_queue_tail(&sc->tx_done_q, skb);
+        __skb_queue_tail(&batch, skb);
     }
+    if (skb_queue_empty(&batch))
+        return;
+    _splice_tx_done_q(sc, &batch, false);
     wake_up_interruptible(&sc->rx_wait_q);
 }
 #endif
@@ -5210,27 +5235,26 @@ void _process_rx_q (struct ssv_softc *sc, struct sk_buff_head *rx_q, spinlock_t
     struct sk_buff *skb;
     struct ieee80211_hdr *hdr;
     struct ssv6200_rx_desc *rxdesc;
+    struct sk_buff_head batch;
     unsigned long flags=0;
     #ifdef USE_FLUSH_RETRY
     bool has_ba_processed = false;
     #endif
+    __skb_queue_head_init(&batch);
     while (1) {
-        if (rx_q_lock != NULL)
-        {
-            spin_lock_irqsave(rx_q_lock, flags);
-            skb = __skb_dequeue(rx_q);
-        }
-        else
-            skb = skb_dequeue(rx_q);
+        skb = __skb_dequeue(&batch);
         if (!skb)
         {
-            if (rx_q_lock != NULL)
-                spin_unlock_irqrestore(rx_q_lock, flags);
-            break;
-        }
-        sc->rx.rxq_count --;
-        if (rx_q_lock != NULL)
+            if (rx_q_lock == NULL)
+                rx_q_lock = &rx_q->lock;
+            spin_lock_irqsave(rx_q_lock, flags);
+            sc->rx.rxq_count -= skb_queue_len(rx_q);
+            skb_queue_splice_tail_init(rx_q, &batch);
             spin_unlock_irqrestore(rx_q_lock, flags);
+            skb = __skb_dequeue(&batch);
+            if (!skb)
+                break;
+        }
         rxdesc = (struct ssv6200_rx_desc *)skb->data;
         if (rxdesc->c_type == HOST_EVENT)
         {
@@ -5357,8 +5381,7 @@ int ssv6200_rx(struct sk_buff *rx_skb, void *args)
     {
     unsigned long flags;
     spin_lock_irqsave(&sc->rx_skb_q.lock, flags);
-    while (skb_queue_len(rx_skb_q))
-        __skb_queue_tail(&sc->rx_skb_q, __skb_dequeue(rx_skb_q));
+    skb_queue_splice_tail_init(rx_skb_q, &sc->rx_skb_q);
     spin_unlock_irqrestore(&sc->rx_skb_q.lock, flags);
     }
     #else
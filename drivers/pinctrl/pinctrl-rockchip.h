@@ -19,6 +19,7 @@
 #define _PINCTRL_ROCKCHIP_H
 
 #include <linux/gpio/driver.h>
+#include <linux/timekeeping.h>
 
 #define RK_GPIO0_A0	0
 #define RK_GPIO0_A1	1
@@ -347,6 +348,8 @@ struct rockchip_pin_bank {
 	u32				route_mask;
 	struct list_head		deferred_pins;
 	struct mutex			deferred_lock;
+	u32				ts_mask;
+	struct system_time_snapshot	ts;
 };
 
 /**
@@ -23,6 +23,7 @@
 #include <linux/of_gpio.h>
 #include <linux/timer.h>
 #include <linux/jiffies.h>
+#include <linux/soc/rockchip/rockchip_gpio.h>
 
 /* Info for each registered platform device */
 struct pps_gpio_device_data {
@@ -34,6 +35,7 @@ struct pps_gpio_device_data {
 	struct timer_list echo_timer;	/* timer to reset echo active state */
 	bool assert_falling_edge;
 	bool capture_clear;
+	bool irq_timestamp;		/* GPIO driver stamps the IRQ entry */
 	unsigned int echo_active_ms;	/* PPS echo active duration */
 	unsigned long echo_timeout;	/* timer timeout value in jiffies */
 };
@@ -42,17 +44,34 @@ struct pps_gpio_device_data {
  * Report the PPS event
  */
 
+static void pps_gpio_get_ts(const struct pps_gpio_device_data *info,
+			    struct pps_event_time *ts)
+{
+	struct system_time_snapshot snap;
+
+	if (!info->irq_timestamp ||
+	    rockchip_gpio_irq_timestamp(info->irq, &snap)) {
+		pps_get_ts(ts);
+		return;
+	}
+
+	ts->ts_real = ktime_to_timespec64(snap.real);
+#ifdef CONFIG_NTP_PPS
+	ts->ts_raw = ktime_to_timespec64(snap.raw);
+#endif
+}
+
 static irqreturn_t pps_gpio_irq_handler(int irq, void *data)
 {
 	const struct pps_gpio_device_data *info;
 	struct pps_event_time ts;
 	int rising_edge;
 
-	/* Get the time stamp first */
-	pps_get_ts(&ts);
-
 	info = data;
 
+	/* Get the time stamp first */
+	pps_gpio_get_ts(info, &ts);
+
 	rising_edge = gpiod_get_value(info->gpio_pin);
 	if ((rising_edge && !info->assert_falling_edge) ||
 			(!rising_edge && info->assert_falling_edge))
@@ -223,15 +242,23 @@ static int pps_gpio_probe(struct platform_device *pdev)
 		return PTR_ERR(data->pps);
 	}
 
-	/* register IRQ interrupt handler */
+	/*
+	 * register IRQ interrupt handler, never force threaded so the
+	 * timestamp stays in the hardirq path
+	 */
 	ret = devm_request_irq(&pdev->dev, data->irq, pps_gpio_irq_handler,
-			get_irqf_trigger_flags(data), data->info.name, data);
+			get_irqf_trigger_flags(data) | IRQF_NO_THREAD,
+			data->info.name, data);
 	if (ret) {
 		pps_unregister_source(data->pps);
 		dev_err(&pdev->dev, "failed to acquire IRQ %d\n", data->irq);
 		return -EINVAL;
 	}
 
+	/* timestamp at the GPIO controller interrupt where supported */
+	data->irq_timestamp = !rockchip_gpio_irq_timestamp_enable(data->irq,
+								 true);
+
 	dev_info(data->pps->dev, "Registered IRQ %d as PPS source\n",
 		 data->irq);
 
@@ -242,6 +269,8 @@ static int pps_gpio_remove(struct platform_device *pdev)
 {
 	struct pps_gpio_device_data *data = platform_get_drvdata(pdev);
 
+	if (data->irq_timestamp)
+		rockchip_gpio_irq_timestamp_enable(data->irq, false);
 	pps_unregister_source(data->pps);
 	if (data->echo_pin) {
 		del_timer_sync(&data->echo_timer);
@@ -12,10 +12,12 @@
 #include <linux/dma-mapping.h>
 #include <linux/io.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
 #include <linux/platform_device.h>
 #include <linux/pwm.h>
+#include <linux/soc/rockchip/rockchip_i2s_pwm.h>
 
 /* transmit operation control register */
 #define I2S_TXCR_FBM_MSB		0
@@ -73,11 +75,19 @@
 #define I2S_DMA_BUFFER_SIZE		256
 #define I2S_DMA_BUFFER_FRAME_SIZE	(I2S_DMA_BUFFER_SIZE / I2S_FRAME_BYTES)
 
+/* the valid data width of a channel is 16 to 32 bits */
+#define I2S_STREAM_FRAME_BITS_MIN	32
+#define I2S_CLKDIV_TXM_MAX		256
+
 struct rockchip_i2s_pwm_dma {
 	struct dma_chan         *chan_tx;
 	dma_addr_t              tx_addr;
 	char                    *tx_buff;
 	dma_cookie_t            tx_cookie;
+	/* ring of the streaming mode, each frame is still two 32-bit words */
+	dma_addr_t              ring_addr;
+	char                    *ring_buff;
+	size_t                  ring_size;
 };
 
 struct rockchip_i2s_pwm_chip {
@@ -89,6 +99,13 @@ struct rockchip_i2s_pwm_chip {
 	const struct rockchip_i2s_pwm_data *data;
 
 	struct pwm_state pwm_state;
+
+	/* serializes the streaming mode against the pwm ops */
+	struct mutex lock;
+	bool streaming;
+	struct rockchip_i2s_pwm_stream stream;
+	unsigned int stream_frames;
+	unsigned int stream_wr;
 };
 
 struct rockchip_i2s_pwm_data {
@@ -103,6 +120,38 @@ struct rockchip_i2s_pwm_chip *to_rockchip_i2s_pwm_chip(struct pwm_chip *c)
 	return container_of(c, struct rockchip_i2s_pwm_chip, chip);
 }
 
+/*
+ * A frame is one pwm period, its first @duty bits are high. The frame is
+ * sent LSB first as two channels of @frame_bits / 2 valid bits, each in
+ * the low bits of its own 32-bit word.
+ */
+static void rockchip_i2s_pwm_fill(u32 *frame, unsigned int duty,
+				  unsigned int frame_bits,
+				  enum pwm_polarity polarity)
+{
+	unsigned int vdw = frame_bits / I2S_CHANNEL_NUM;
+	u64 pattern;
+
+	duty = min(duty, frame_bits);
+	pattern = duty ? GENMASK_ULL(duty - 1, 0) : 0;
+	if (polarity == PWM_POLARITY_INVERSED)
+		pattern = ~pattern;
+
+	frame[0] = pattern & GENMASK(vdw - 1, 0);
+	frame[1] = (pattern >> vdw) & GENMASK(vdw - 1, 0);
+}
+
+static void rockchip_i2s_pwm_set_div(struct rockchip_i2s_pwm_chip *pc,
+				     unsigned long div_bclk)
+{
+	unsigned int div_val;
+
+	div_val = readl_relaxed(pc->base + pc->data->reg_clkdiv);
+	div_val &= ~pc->data->mask_clkdiv;
+	writel_relaxed((I2S_CLKDIV_TXM(div_bclk) << pc->data->bit_clkdiv)
+		       | div_val, pc->base + pc->data->reg_clkdiv);
+}
+
 static void rockchip_i2s_pwm_get_state(struct pwm_chip *chip,
 				       struct pwm_device *pwm,
 				       struct pwm_state *state)
@@ -133,8 +182,7 @@ static int rockchip_i2s_pwm_config(struct pwm_chip *chip,
 	struct rockchip_i2s_pwm_chip *pc = to_rockchip_i2s_pwm_chip(chip);
 	unsigned long div_bclk;
 	unsigned long flags;
-	u64 mclk_rate, period_div, duty, duty_div;
-	unsigned int div_val;
+	u64 mclk_rate, period_div, duty_div;
 	int ret, i;
 
 	ret = clk_enable(pc->hclk);
@@ -154,23 +202,14 @@ static int rockchip_i2s_pwm_config(struct pwm_chip *chip,
 	 */
 	duty_div = DIV_ROUND_CLOSEST(I2S_FRAME_BITS * state->duty_cycle,
 				     state->period);
-	if (duty_div > 0)
-		duty = GENMASK_ULL(duty_div - 1, 0);
-	else
-		duty = 0;
-
-	if (state->polarity == PWM_POLARITY_INVERSED)
-		duty = ~duty;
 
 	local_irq_save(flags);
 
-	div_val = readl_relaxed(pc->base + pc->data->reg_clkdiv);
-	div_val &= ~pc->data->mask_clkdiv;
-	writel_relaxed((I2S_CLKDIV_TXM(div_bclk) << pc->data->bit_clkdiv)
-		       | div_val, pc->base + pc->data->reg_clkdiv);
+	rockchip_i2s_pwm_set_div(pc, div_bclk);
 
 	for (i = 0; i < I2S_DMA_BUFFER_FRAME_SIZE; i++)
-		memcpy((u64 *)pc->dma.tx_buff + i, &duty, sizeof(u64));
+		rockchip_i2s_pwm_fill((u32 *)pc->dma.tx_buff + i * 2, duty_div,
+				      I2S_FRAME_BITS, state->polarity);
 
 	pc->pwm_state.period = state->period;
 	pc->pwm_state.duty_cycle = state->duty_cycle;
@@ -182,82 +221,101 @@ static int rockchip_i2s_pwm_config(struct pwm_chip *chip,
 	return ret;
 }
 
-static int rockchip_i2s_pwm_enable(struct pwm_chip *chip,
-				   struct pwm_device *pwm,
-				   bool enable)
+static int rockchip_i2s_pwm_xfer_start(struct rockchip_i2s_pwm_chip *pc,
+				       dma_addr_t addr, size_t len,
+				       size_t period_len,
+				       dma_async_tx_callback callback)
 {
-	struct rockchip_i2s_pwm_chip *pc = to_rockchip_i2s_pwm_chip(chip);
 	struct rockchip_i2s_pwm_dma *dma = &pc->dma;
 	struct dma_async_tx_descriptor *tx_desc;
-	int ret, retry = 10;
+	int ret;
 	u32 val;
 
-	if (enable) {
-		ret = clk_enable(pc->hclk);
-		if (ret)
-			return ret;
+	tx_desc = dmaengine_prep_dma_cyclic(dma->chan_tx, addr, len, period_len,
+					    DMA_MEM_TO_DEV,
+					    DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!tx_desc) {
+		dev_err(pc->chip.dev, "Not able to get tx desc for DMA\n");
+		return -EBUSY;
+	}
 
-		ret = clk_enable(pc->mclk);
-		if (ret)
-			goto err_mclk;
+	tx_desc->callback = callback;
+	tx_desc->callback_param = callback ? pc : NULL;
+	dma->tx_cookie = dmaengine_submit(tx_desc);
+	ret = dma_submit_error(dma->tx_cookie);
+	if (ret) {
+		dev_err(pc->chip.dev, "DMA submit failed\n");
+		return ret;
+	}
 
-		tx_desc = dmaengine_prep_dma_cyclic(dma->chan_tx, dma->tx_addr,
-						    I2S_DMA_BUFFER_SIZE,
-						    I2S_DMA_BUFFER_SIZE,
-						    DMA_MEM_TO_DEV,
-						    DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
-		if (!tx_desc) {
-			dev_err(chip->dev, "Not able to get tx desc for DMA\n");
-			ret = -EBUSY;
-			goto out;
-		}
-
-		tx_desc->callback = NULL;
-		tx_desc->callback_param = NULL;
-		dma->tx_cookie = dmaengine_submit(tx_desc);
-		ret = dma_submit_error(dma->tx_cookie);
-		if (ret) {
-			dev_err(chip->dev, "DMA submit failed\n");
-			goto out;
-		}
+	dma_async_issue_pending(pc->dma.chan_tx);
 
-		dma_async_issue_pending(pc->dma.chan_tx);
+	val = readl_relaxed(pc->base + I2S_DMACR);
+	val &= ~I2S_DMACR_TDE_ENABLE;
+	writel_relaxed(val | I2S_DMACR_TDE_ENABLE, pc->base + I2S_DMACR);
 
-		val = readl_relaxed(pc->base + I2S_DMACR);
-		val &= ~I2S_DMACR_TDE_ENABLE;
-		writel_relaxed(val | I2S_DMACR_TDE_ENABLE,
-			       pc->base + I2S_DMACR);
+	val = readl_relaxed(pc->base + I2S_XFER);
+	val &= ~I2S_XFER_TXS_START;
+	writel_relaxed(val | I2S_XFER_TXS_START, pc->base + I2S_XFER);
 
-		val = readl_relaxed(pc->base + I2S_XFER);
-		val &= ~I2S_XFER_TXS_START;
-		writel_relaxed(val | I2S_XFER_TXS_START, pc->base + I2S_XFER);
-	} else {
-		dmaengine_terminate_all(pc->dma.chan_tx);
+	return 0;
+}
 
-		val = readl_relaxed(pc->base + I2S_DMACR);
-		val &= ~I2S_DMACR_TDE_ENABLE;
-		writel_relaxed(val | I2S_DMACR_TDE_DISABLE,
-			       pc->base + I2S_DMACR);
+static void rockchip_i2s_pwm_xfer_stop(struct rockchip_i2s_pwm_chip *pc)
+{
+	int retry = 10;
+	u32 val;
+
+	dmaengine_terminate_all(pc->dma.chan_tx);
+
+	val = readl_relaxed(pc->base + I2S_DMACR);
+	val &= ~I2S_DMACR_TDE_ENABLE;
+	writel_relaxed(val | I2S_DMACR_TDE_DISABLE, pc->base + I2S_DMACR);
 
-		val = readl_relaxed(pc->base + I2S_XFER);
-		val &= ~I2S_XFER_TXS_START;
-		writel_relaxed(val | I2S_XFER_TXS_STOP, pc->base + I2S_XFER);
+	val = readl_relaxed(pc->base + I2S_XFER);
+	val &= ~I2S_XFER_TXS_START;
+	writel_relaxed(val | I2S_XFER_TXS_STOP, pc->base + I2S_XFER);
 
-		usleep_range(100, 150);
+	usleep_range(100, 150);
 
+	val = readl_relaxed(pc->base + I2S_CLR);
+	val &= ~I2S_CLR_TXC;
+	writel_relaxed(val | I2S_CLR_TXC, pc->base + I2S_CLR);
+
+	/* Should wait for clear operation to finish */
+	do {
 		val = readl_relaxed(pc->base + I2S_CLR);
-		val &= ~I2S_CLR_TXC;
-		writel_relaxed(val | I2S_CLR_TXC, pc->base + I2S_CLR);
+		if (val)
+			break;
+	} while (--retry);
+
+	if (!retry)
+		dev_warn(pc->chip.dev, "fail to clear\n");
+}
+
+static int rockchip_i2s_pwm_enable(struct pwm_chip *chip,
+				   struct pwm_device *pwm,
+				   bool enable)
+{
+	struct rockchip_i2s_pwm_chip *pc = to_rockchip_i2s_pwm_chip(chip);
+	int ret;
 
-		/* Should wait for clear operation to finish */
-		do {
-			val = readl_relaxed(pc->base + I2S_CLR);
-			if (val)
-				break;
-		} while (--retry);
+	if (enable) {
+		ret = clk_enable(pc->hclk);
+		if (ret)
+			return ret;
 
-		if (!retry)
-			dev_warn(chip->dev, "fail to clear\n");
+		ret = clk_enable(pc->mclk);
+		if (ret)
+			goto err_mclk;
+
+		ret = rockchip_i2s_pwm_xfer_start(pc, pc->dma.tx_addr,
+						  I2S_DMA_BUFFER_SIZE,
+						  I2S_DMA_BUFFER_SIZE, NULL);
+		if (ret)
+			goto out;
+	} else {
+		rockchip_i2s_pwm_xfer_stop(pc);
 
 		clk_disable(pc->mclk);
 		clk_disable(pc->hclk);
@@ -276,26 +334,35 @@ static int rockchip_i2s_pwm_enable(struct pwm_chip *chip,
 static int rockchip_i2s_pwm_apply(struct pwm_chip *chip, struct pwm_device *pwm,
 				  struct pwm_state *state)
 {
+	struct rockchip_i2s_pwm_chip *pc = to_rockchip_i2s_pwm_chip(chip);
 	struct pwm_state curstate;
 	bool enabled;
 	int ret;
 
+	mutex_lock(&pc->lock);
+	if (pc->streaming) {
+		ret = -EBUSY;
+		goto out;
+	}
+
 	pwm_get_state(pwm, &curstate);
 	enabled = curstate.enabled;
 
 	ret = rockchip_i2s_pwm_config(chip, pwm, state);
 	if (ret)
-		return ret;
+		goto out;
 
 	if (state->enabled != enabled) {
 		ret = rockchip_i2s_pwm_enable(chip, pwm, state->enabled);
 		if (ret)
-			return ret;
+			goto out;
 	}
 
 	rockchip_i2s_pwm_get_state(chip, pwm, state);
+out:
+	mutex_unlock(&pc->lock);
 
-	return 0;
+	return ret;
 }
 
 static const struct pwm_ops rockchip_i2s_pwm_ops = {
@@ -353,7 +420,8 @@ static void rockchip_i2s_pwm_dma_release(struct rockchip_i2s_pwm_chip *pc)
 	dma_release_channel(dma->chan_tx);
 }
 
-static int rockchip_i2s_pwm_hw_params(struct rockchip_i2s_pwm_chip *pc)
+static int rockchip_i2s_pwm_hw_params(struct rockchip_i2s_pwm_chip *pc,
+				      unsigned int frame_bits)
 {
 	unsigned int val = 0;
 	int ret;
@@ -362,15 +430,16 @@ static int rockchip_i2s_pwm_hw_params(struct rockchip_i2s_pwm_chip *pc)
 	if (ret)
 		return ret;
 
-	/* Config tx format bits with 32, LSB, left justified. */
+	/* Config tx format bits with half a frame, LSB, left justified. */
 	val = readl_relaxed(pc->base + I2S_TXCR);
 	val &= ~(I2S_TXCR_VDW_MASK | I2S_TXCR_IBM_MASK | I2S_TXCR_FBM_LSB);
-	writel_relaxed(val | I2S_TXCR_VDW(I2S_FORMAT_BITS) | I2S_TXCR_IBM_LSJM
-		       | I2S_TXCR_FBM_LSB, pc->base + I2S_TXCR);
+	writel_relaxed(val | I2S_TXCR_VDW(frame_bits / I2S_CHANNEL_NUM)
+		       | I2S_TXCR_IBM_LSJM | I2S_TXCR_FBM_LSB,
+		       pc->base + I2S_TXCR);
 
 	val = readl_relaxed(pc->base + I2S_CKR);
 	val &= ~I2S_CKR_TSD_MASK;
-	writel_relaxed(val | I2S_CKR_TSD(I2S_FRAME_BITS), pc->base + I2S_CKR);
+	writel_relaxed(val | I2S_CKR_TSD(frame_bits), pc->base + I2S_CKR);
 
 	/* Config the tx fifo watermark level to 30. */
 	val = readl_relaxed(pc->base + I2S_DMACR);
@@ -382,6 +451,209 @@ static int rockchip_i2s_pwm_hw_params(struct rockchip_i2s_pwm_chip *pc)
 	return 0;
 }
 
+static void rockchip_i2s_pwm_period_elapsed(void *arg)
+{
+	struct rockchip_i2s_pwm_chip *pc = arg;
+
+	if (pc->stream.period_elapsed)
+		pc->stream.period_elapsed(pc->stream.data);
+}
+
+static void __rockchip_i2s_pwm_stream_stop(struct rockchip_i2s_pwm_chip *pc)
+{
+	struct rockchip_i2s_pwm_dma *dma = &pc->dma;
+
+	rockchip_i2s_pwm_xfer_stop(pc);
+	dmaengine_synchronize(dma->chan_tx);
+
+	/* back to the frame layout of the pwm ops */
+	rockchip_i2s_pwm_hw_params(pc, I2S_FRAME_BITS);
+
+	clk_disable(pc->mclk);
+	clk_disable(pc->hclk);
+
+	dma_free_coherent(pc->chip.dev, dma->ring_size, dma->ring_buff,
+			  dma->ring_addr);
+	dma->ring_buff = NULL;
+	pc->streaming = false;
+}
+
+/**
+ * rockchip_i2s_pwm_stream_start - feed the duty cycle from a DMA ring
+ * @pwm: disabled I2S PWM channel
+ * @stream: carrier, resolution and ring layout
+ *
+ * Each frame of the ring is one carrier period with its own duty cycle,
+ * so a class-D output gets a new duty cycle every period without any CPU
+ * access to the controller: clients only write duty values to memory
+ * ahead of the DMA with rockchip_i2s_pwm_stream_write(). The ring starts
+ * with a 50% duty cycle, the silence of a class-D output.
+ *
+ * The pwm ops return -EBUSY until rockchip_i2s_pwm_stream_stop().
+ *
+ * Return: 0 on success, negative error code otherwise.
+ */
+int rockchip_i2s_pwm_stream_start(struct pwm_device *pwm,
+				  const struct rockchip_i2s_pwm_stream *stream)
+{
+	struct rockchip_i2s_pwm_chip *pc;
+	struct rockchip_i2s_pwm_dma *dma;
+	unsigned long div_bclk;
+	unsigned int i;
+	int ret;
+
+	if (!pwm || pwm->chip->ops != &rockchip_i2s_pwm_ops)
+		return -EINVAL;
+
+	if (!stream->carrier_hz || stream->frame_bits % 2 ||
+	    stream->frame_bits < I2S_STREAM_FRAME_BITS_MIN ||
+	    stream->frame_bits > I2S_FRAME_BITS ||
+	    !stream->period_frames || stream->periods < 2)
+		return -EINVAL;
+
+	pc = to_rockchip_i2s_pwm_chip(pwm->chip);
+	dma = &pc->dma;
+
+	div_bclk = DIV_ROUND_CLOSEST(clk_get_rate(pc->mclk),
+				     stream->carrier_hz * stream->frame_bits);
+	if (!div_bclk || div_bclk > I2S_CLKDIV_TXM_MAX)
+		return -ERANGE;
+
+	mutex_lock(&pc->lock);
+	if (pc->streaming || pwm_is_enabled(pwm)) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	pc->stream = *stream;
+	pc->stream_frames = stream->period_frames * stream->periods;
+	dma->ring_size = pc->stream_frames * I2S_FRAME_BYTES;
+	dma->ring_buff = dma_alloc_coherent(pc->chip.dev, dma->ring_size,
+					    &dma->ring_addr, GFP_KERNEL);
+	if (!dma->ring_buff) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < pc->stream_frames; i++)
+		rockchip_i2s_pwm_fill((u32 *)dma->ring_buff + i * 2,
+				      stream->frame_bits / 2,
+				      stream->frame_bits, stream->polarity);
+	/* the first period plays silence while the client fills the rest */
+	pc->stream_wr = stream->period_frames;
+
+	ret = clk_enable(pc->hclk);
+	if (ret)
+		goto err_free;
+
+	ret = clk_enable(pc->mclk);
+	if (ret)
+		goto err_hclk;
+
+	ret = rockchip_i2s_pwm_hw_params(pc, stream->frame_bits);
+	if (ret)
+		goto err_mclk;
+
+	rockchip_i2s_pwm_set_div(pc, div_bclk);
+
+	ret = rockchip_i2s_pwm_xfer_start(pc, dma->ring_addr, dma->ring_size,
+					  stream->period_frames *
+					  I2S_FRAME_BYTES,
+					  rockchip_i2s_pwm_period_elapsed);
+	if (ret)
+		goto err_format;
+
+	pc->streaming = true;
+	mutex_unlock(&pc->lock);
+
+	return 0;
+
+err_format:
+	rockchip_i2s_pwm_hw_params(pc, I2S_FRAME_BITS);
+err_mclk:
+	clk_disable(pc->mclk);
+err_hclk:
+	clk_disable(pc->hclk);
+err_free:
+	dma_free_coherent(pc->chip.dev, dma->ring_size, dma->ring_buff,
+			  dma->ring_addr);
+	dma->ring_buff = NULL;
+out:
+	mutex_unlock(&pc->lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(rockchip_i2s_pwm_stream_start);
+
+/**
+ * rockchip_i2s_pwm_stream_write - queue duty cycles to a streaming PWM
+ * @pwm: PWM channel started by rockchip_i2s_pwm_stream_start()
+ * @duty: high bits of each frame, from 0 to frame_bits
+ * @count: number of duty values
+ *
+ * Writes up to the DMA period in flight, which is never touched. Safe in
+ * the period_elapsed callback; calls must not race with each other. A
+ * client that falls behind replays the ring until it catches up.
+ *
+ * Return: number of duty values queued, negative error code otherwise.
+ */
+int rockchip_i2s_pwm_stream_write(struct pwm_device *pwm, const u8 *duty,
+				  unsigned int count)
+{
+	struct rockchip_i2s_pwm_chip *pc;
+	struct dma_tx_state state;
+	unsigned int frames, hw, space, i;
+	u32 *ring;
+
+	if (!pwm || pwm->chip->ops != &rockchip_i2s_pwm_ops)
+		return -EINVAL;
+
+	pc = to_rockchip_i2s_pwm_chip(pwm->chip);
+	if (!READ_ONCE(pc->streaming))
+		return -EINVAL;
+
+	frames = pc->stream_frames;
+	dmaengine_tx_status(pc->dma.chan_tx, pc->dma.tx_cookie, &state);
+	hw = (pc->dma.ring_size - state.residue) / I2S_FRAME_BYTES % frames;
+	hw -= hw % pc->stream.period_frames;
+
+	space = (hw + frames - pc->stream_wr) % frames;
+	count = min(count, space);
+
+	ring = (u32 *)pc->dma.ring_buff;
+	for (i = 0; i < count; i++) {
+		rockchip_i2s_pwm_fill(ring + pc->stream_wr * 2, duty[i],
+				      pc->stream.frame_bits,
+				      pc->stream.polarity);
+		pc->stream_wr = (pc->stream_wr + 1) % frames;
+	}
+
+	return count;
+}
+EXPORT_SYMBOL_GPL(rockchip_i2s_pwm_stream_write);
+
+/**
+ * rockchip_i2s_pwm_stream_stop - stop a streaming PWM
+ * @pwm: PWM channel started by rockchip_i2s_pwm_stream_start()
+ *
+ * The output is left low and the pwm ops are usable again. Must not be
+ * called from the period_elapsed callback.
+ */
+void rockchip_i2s_pwm_stream_stop(struct pwm_device *pwm)
+{
+	struct rockchip_i2s_pwm_chip *pc;
+
+	if (!pwm || pwm->chip->ops != &rockchip_i2s_pwm_ops)
+		return;
+
+	pc = to_rockchip_i2s_pwm_chip(pwm->chip);
+	mutex_lock(&pc->lock);
+	if (pc->streaming)
+		__rockchip_i2s_pwm_stream_stop(pc);
+	mutex_unlock(&pc->lock);
+}
+EXPORT_SYMBOL_GPL(rockchip_i2s_pwm_stream_stop);
+
 static const struct rockchip_i2s_pwm_data i2s_pwm_data_v1 = {
 	.reg_clkdiv = 0x8,
 	.bit_clkdiv = 16,
@@ -437,9 +709,10 @@ static int rockchip_i2s_pwm_probe(struct platform_device *pdev)
 		goto err_hclk;
 
 	pc->chip.dev = &pdev->dev;
+	mutex_init(&pc->lock);
 	platform_set_drvdata(pdev, pc);
 
-	ret = rockchip_i2s_pwm_hw_params(pc);
+	ret = rockchip_i2s_pwm_hw_params(pc, I2S_FRAME_BITS);
 	if (ret)
 		goto err_mclk;
 
@@ -479,6 +752,11 @@ static int rockchip_i2s_pwm_remove(struct platform_device *pdev)
 	struct rockchip_i2s_pwm_chip *pc = platform_get_drvdata(pdev);
 	struct pwm_state curstate;
 
+	mutex_lock(&pc->lock);
+	if (pc->streaming)
+		__rockchip_i2s_pwm_stream_stop(pc);
+	mutex_unlock(&pc->lock);
+
 	pwm_get_state(pc->chip.pwms, &curstate);
 	if (curstate.enabled)
 		dmaengine_terminate_all(pc->dma.chan_tx);
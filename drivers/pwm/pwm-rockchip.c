@@ -16,6 +16,7 @@
 #include <linux/pinctrl/consumer.h>
 #include <linux/platform_device.h>
 #include <linux/pwm.h>
+#include <linux/soc/rockchip/rockchip_pwm.h>
 #include <linux/time.h>
 #include "pwm-rockchip.h"
 
@@ -26,6 +27,8 @@
 
 #define PWM_ENABLE		(1 << 0)
 #define PWM_CONTINUOUS		(1 << 1)
+#define PWM_CAPTURE		(2 << 1)
+#define PWM_MODE_MASK		(3 << 1)
 #define PWM_DUTY_POSITIVE	(1 << 3)
 #define PWM_DUTY_NEGATIVE	(0 << 3)
 #define PWM_INACTIVE_NEGATIVE	(0 << 4)
@@ -59,6 +62,14 @@ struct rockchip_pwm_chip {
 	bool oneshot;
 	int channel_id;
 	int irq;
+
+	/* capture mode, see rockchip_pwm_do_capture() */
+	struct mutex capture_lock;
+	struct completion capture_done;
+	unsigned int capture_edges;
+	unsigned int capture_left;
+	u64 capture_cycles;
+	u64 capture_high;
 };
 
 struct rockchip_pwm_regs {
@@ -74,6 +85,7 @@ struct rockchip_pwm_data {
 	bool supports_polarity;
 	bool supports_lock;
 	bool vop_pwm;
+	bool supports_capture;
 	u32 enable_conf;
 	u32 enable_conf_mask;
 };
@@ -116,7 +128,33 @@ static void rockchip_pwm_get_state(struct pwm_chip *chip,
 	clk_disable(pc->pclk);
 }
 
-static irqreturn_t rockchip_pwm_oneshot_irq(int irq, void *data)
+/*
+ * The capture interrupt fires on every edge, with the high and low times of
+ * the input latched in the period and duty registers. Sum them every second
+ * edge, once both hold a complete phase, to count full input periods.
+ */
+static void rockchip_pwm_capture_irq(struct rockchip_pwm_chip *pc)
+{
+	unsigned int id = pc->channel_id;
+	u32 high, low, int_ctrl;
+
+	if (++pc->capture_edges <= 2 || pc->capture_edges & 1)
+		return;
+
+	high = readl_relaxed(pc->base + pc->data->regs.period);
+	low = readl_relaxed(pc->base + pc->data->regs.duty);
+	pc->capture_cycles += high + low;
+	pc->capture_high += high;
+
+	if (--pc->capture_left)
+		return;
+
+	int_ctrl = readl_relaxed(pc->base + PWM_REG_INT_EN(id));
+	writel_relaxed(int_ctrl & ~PWM_CH_INT(id), pc->base + PWM_REG_INT_EN(id));
+	complete(&pc->capture_done);
+}
+
+static irqreturn_t rockchip_pwm_irq(int irq, void *data)
 {
 	struct rockchip_pwm_chip *pc = data;
 	struct pwm_state state;
@@ -132,6 +170,14 @@ static irqreturn_t rockchip_pwm_oneshot_irq(int irq, void *data)
 
 	writel_relaxed(PWM_CH_INT(id), pc->base + PWM_REG_INTSTS(id));
 
+	if (pc->capture_left) {
+		rockchip_pwm_capture_irq(pc);
+		return IRQ_HANDLED;
+	}
+
+	if (!IS_ENABLED(CONFIG_PWM_ROCKCHIP_ONESHOT))
+		return IRQ_HANDLED;
+
 	/*
 	 * Set pwm state to disabled when the oneshot mode finished.
 	 */
@@ -311,12 +357,149 @@ static int rockchip_pwm_apply(struct pwm_chip *chip, struct pwm_device *pwm,
 	return ret;
 }
 
+/*
+ * Run the channel in capture mode for @periods full periods of the input
+ * and return the PWM clock cycles they took, in total and high.
+ */
+static int rockchip_pwm_do_capture(struct rockchip_pwm_chip *pc,
+				   struct pwm_device *pwm, unsigned int periods,
+				   u64 *cycles, u64 *high,
+				   unsigned long timeout)
+{
+	unsigned int id = pc->channel_id;
+	u32 ctrl, int_ctrl;
+	int ret;
+
+	if (!pc->data->supports_capture || pc->irq <= 0)
+		return -EOPNOTSUPP;
+
+	if (!periods)
+		return -EINVAL;
+
+	if (pwm_is_enabled(pwm))
+		return -EBUSY;
+
+	mutex_lock(&pc->capture_lock);
+
+	ret = clk_enable(pc->pclk);
+	if (ret)
+		goto out_unlock;
+
+	ret = clk_enable(pc->clk);
+	if (ret)
+		goto out_pclk;
+
+	ret = pinctrl_select_state(pc->pinctrl, pc->active_state);
+	if (ret)
+		goto out_clk;
+
+	reinit_completion(&pc->capture_done);
+	pc->capture_edges = 0;
+	pc->capture_cycles = 0;
+	pc->capture_high = 0;
+	WRITE_ONCE(pc->capture_left, periods);
+
+	ctrl = readl_relaxed(pc->base + pc->data->regs.ctrl);
+	ctrl &= ~(PWM_MODE_MASK | PWM_ENABLE);
+	writel_relaxed(ctrl | PWM_CAPTURE, pc->base + pc->data->regs.ctrl);
+
+	writel_relaxed(PWM_CH_INT(id), pc->base + PWM_REG_INTSTS(id));
+	int_ctrl = readl_relaxed(pc->base + PWM_REG_INT_EN(id));
+	writel_relaxed(int_ctrl | PWM_CH_INT(id), pc->base + PWM_REG_INT_EN(id));
+
+	writel(ctrl | PWM_CAPTURE | PWM_ENABLE, pc->base + pc->data->regs.ctrl);
+
+	if (!wait_for_completion_timeout(&pc->capture_done,
+					 msecs_to_jiffies(timeout)))
+		ret = -ETIMEDOUT;
+
+	/* the IRQ disables itself when done, not on timeout */
+	disable_irq(pc->irq);
+	int_ctrl = readl_relaxed(pc->base + PWM_REG_INT_EN(id));
+	writel_relaxed(int_ctrl & ~PWM_CH_INT(id), pc->base + PWM_REG_INT_EN(id));
+	WRITE_ONCE(pc->capture_left, 0);
+	enable_irq(pc->irq);
+
+	writel(ctrl, pc->base + pc->data->regs.ctrl);
+
+	*cycles = pc->capture_cycles;
+	*high = pc->capture_high;
+out_clk:
+	clk_disable(pc->clk);
+out_pclk:
+	clk_disable(pc->pclk);
+out_unlock:
+	mutex_unlock(&pc->capture_lock);
+
+	return ret;
+}
+
+static int rockchip_pwm_capture(struct pwm_chip *chip, struct pwm_device *pwm,
+				struct pwm_capture *result,
+				unsigned long timeout)
+{
+	struct rockchip_pwm_chip *pc = to_rockchip_pwm_chip(chip);
+	u64 cycles, high;
+	int ret;
+
+	ret = rockchip_pwm_do_capture(pc, pwm, 1, &cycles, &high, timeout);
+	if (ret)
+		return ret;
+
+	result->period = DIV_ROUND_CLOSEST_ULL(cycles * NSEC_PER_SEC,
+					       pc->clk_rate);
+	result->duty_cycle = DIV_ROUND_CLOSEST_ULL(high * NSEC_PER_SEC,
+						   pc->clk_rate);
+
+	return 0;
+}
+
 static const struct pwm_ops rockchip_pwm_ops = {
 	.get_state = rockchip_pwm_get_state,
 	.apply = rockchip_pwm_apply,
+	.capture = rockchip_pwm_capture,
 	.owner = THIS_MODULE,
 };
 
+/**
+ * rockchip_pwm_measure_freq - measure the frequency of a PWM input
+ * @pwm: disabled PWM channel whose pin receives the signal
+ * @periods: number of input periods to average over
+ * @freq_mhz: measured frequency in mHz
+ * @timeout: time to wait for @periods in ms
+ *
+ * Averaging over many periods gives a resolution well below the PWM clock,
+ * e.g. a 48 kHz word clock over 4800 periods (100ms) counted with a 24 MHz
+ * clock resolves 0.4 ppm. The input must be slower than half the PWM clock.
+ * Costs one interrupt per input edge while measuring.
+ *
+ * Return: 0 on success, negative error code otherwise.
+ */
+int rockchip_pwm_measure_freq(struct pwm_device *pwm, unsigned int periods,
+			      u64 *freq_mhz, unsigned long timeout)
+{
+	struct rockchip_pwm_chip *pc;
+	u64 cycles, high;
+	int ret;
+
+	if (!pwm || pwm->chip->ops != &rockchip_pwm_ops)
+		return -EINVAL;
+
+	pc = to_rockchip_pwm_chip(pwm->chip);
+	ret = rockchip_pwm_do_capture(pc, pwm, periods, &cycles, &high,
+				      timeout);
+	if (ret)
+		return ret;
+
+	if (!cycles)
+		return -EIO;
+
+	*freq_mhz = div64_u64((u64)periods * pc->clk_rate * 1000, cycles);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rockchip_pwm_measure_freq);
+
 static const struct rockchip_pwm_data pwm_data_v1 = {
 	.regs = {
 		.duty = 0x04,
@@ -343,6 +526,7 @@ static const struct rockchip_pwm_data pwm_data_v2 = {
 	.supports_polarity = true,
 	.supports_lock = false,
 	.vop_pwm = false,
+	.supports_capture = true,
 	.enable_conf = PWM_OUTPUT_LEFT | PWM_LP_DISABLE | PWM_ENABLE |
 		       PWM_CONTINUOUS,
 	.enable_conf_mask = GENMASK(2, 0) | BIT(5) | BIT(8),
@@ -375,6 +559,7 @@ static const struct rockchip_pwm_data pwm_data_v3 = {
 	.supports_polarity = true,
 	.supports_lock = true,
 	.vop_pwm = false,
+	.supports_capture = true,
 	.enable_conf = PWM_OUTPUT_LEFT | PWM_LP_DISABLE | PWM_ENABLE |
 		       PWM_CONTINUOUS,
 	.enable_conf_mask = GENMASK(2, 0) | BIT(5) | BIT(8),
@@ -460,6 +645,10 @@ static int rockchip_pwm_probe(struct platform_device *pdev)
 		goto err_pclk;
 	}
 
+	pc->data = id->data;
+	mutex_init(&pc->capture_lock);
+	init_completion(&pc->capture_done);
+
 	if (IS_ENABLED(CONFIG_PWM_ROCKCHIP_ONESHOT)) {
 		pc->irq = platform_get_irq(pdev, 0);
 		if (pc->irq < 0) {
@@ -467,10 +656,19 @@ static int rockchip_pwm_probe(struct platform_device *pdev)
 			ret = pc->irq;
 			goto err_pclk;
 		}
+	} else if (pc->data->supports_capture) {
+		/* only capture needs it, which is optional */
+		pc->irq = platform_get_irq_optional(pdev, 0);
+		if (pc->irq == -EPROBE_DEFER) {
+			ret = pc->irq;
+			goto err_pclk;
+		}
+	}
 
-		ret = devm_request_irq(&pdev->dev, pc->irq, rockchip_pwm_oneshot_irq,
+	if (pc->irq > 0) {
+		ret = devm_request_irq(&pdev->dev, pc->irq, rockchip_pwm_irq,
 				       IRQF_NO_SUSPEND | IRQF_SHARED,
-				       "rk_pwm_oneshot_irq", pc);
+				       "rk_pwm_irq", pc);
 		if (ret) {
 			dev_err(&pdev->dev, "Claim oneshot IRQ failed\n");
 			goto err_pclk;
@@ -493,7 +691,6 @@ static int rockchip_pwm_probe(struct platform_device *pdev)
 
 	platform_set_drvdata(pdev, pc);
 
-	pc->data = id->data;
 	pc->chip.dev = &pdev->dev;
 	pc->chip.ops = &rockchip_pwm_ops;
 	pc->chip.base = of_alias_get_id(pdev->dev.of_node, "pwm");
@@ -108,7 +108,17 @@ enum e_rknpu_job_mode {
 			 RKNPU_JOB_FENCE_OUT
 };
 
-/* action definitions */
+/*
+ * action definitions
+ *
+ * The RW_AMOUNT actions read the DDR traffic counters of the NPU: data
+ * written, data read and weights read since the last
+ * RKNPU_ACT_CLR_TOTAL_RW_AMOUNT. To profile a model layer by layer, submit
+ * the layers one task range at a time (rknpu_submit.task_start and
+ * task_number), clearing the counters before each submit and reading them
+ * back after it completes; the time spent in the blocking submit then
+ * bounds the execution time of that range.
+ */
 enum e_rknpu_action {
 	RKNPU_GET_HW_VERSION = 0,
 	RKNPU_GET_DRV_VERSION = 1,
@@ -147,6 +157,16 @@ enum e_rknpu_action {
  * @dma_addr: dma address that access by rknpu.
  * @sram_size: user-desired sram memory allocation size.
  *  - this size value would be page-aligned internally.
+ *
+ * With RKNPU_MEM_TRY_ALLOC_SRAM | RKNPU_MEM_IOMMU the first @sram_size
+ * bytes of the buffer are backed by on-chip SRAM and the rest by DDR,
+ * behind one contiguous dma_addr, so a buffer may be split between the
+ * two tiers. When the SRAM pool can not hold @sram_size the buffer is
+ * allocated from DDR alone; the allocation only fails when DDR does.
+ * The SRAM is shared by every buffer of every session, first come first
+ * served: create the hottest tensors first (the weights of the first
+ * layers, reused intermediate activations), and size the request with
+ * RKNPU_GET_FREE_SRAM_SIZE so that it fits.
  */
 struct rknpu_mem_create {
 	__u32 handle;
@@ -253,9 +273,14 @@ struct rknpu_subcore_task {
  * @task_base_addr: task base address
  * @user_data: (optional) user data
  * @core_mask: core mask of rknpu
- * @fence_fd: dma fence fd
+ * @fence_fd: dma fence fd, waited on before the job starts with
+ *	      RKNPU_JOB_FENCE_IN, replaced by the job done fence with
+ *	      RKNPU_JOB_FENCE_OUT
  * @subcore_task: subcore task
  *
+ * A RKNPU_JOB_NONBLOCK | RKNPU_JOB_FENCE_IN submit returns at once, so the
+ * job of frame N+1 can be queued on its input fence while frame N runs;
+ * alternating two input buffers keeps the producer off the running one.
  */
 struct rknpu_submit {
 	__u32 flags;
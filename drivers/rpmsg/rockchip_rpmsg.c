@@ -8,13 +8,16 @@
 
 #include <linux/delay.h>
 #include <linux/err.h>
+#include <linux/hwspinlock.h>
 #include <linux/init.h>
 #include <linux/interrupt.h>
 #include <linux/kernel.h>
+#include <linux/log2.h>
 #include <linux/mailbox_client.h>
 #include <linux/mailbox_controller.h>
 #include <linux/module.h>
 #include <linux/of_device.h>
+#include <linux/of_platform.h>
 #include <linux/of_reserved_mem.h>
 #include <linux/platform_device.h>
 #include <linux/rpmsg/rockchip_rpmsg.h>
@@ -26,6 +29,8 @@
 
 #include "rpmsg_internal.h"
 
+#define RPMSG_RING_LOCK_TIMEOUT_MS		10
+
 enum rk_rpmsg_chip {
 	RK3562,
 	RK3568,
@@ -42,6 +47,23 @@ struct rk_virtio_dev {
 
 #define to_rk_rpvdev(vd)	container_of(vd, struct rk_virtio_dev, vdev)
 
+struct rk_rpmsg_ring_dir {
+	struct rk_rpmsg_ring_ctrl *ctrl;
+	u8 *data;
+	u32 size;
+};
+
+struct rk_rpmsg_ring {
+	struct rk_rpmsg_dev *rpdev;
+	struct rk_rpmsg_ring_dir tx;
+	struct rk_rpmsg_ring_dir rx;
+	struct hwspinlock *hwlock;
+	spinlock_t lock; /* notify and priv */
+	void (*notify)(void *priv);
+	void *priv;
+	bool claimed;
+};
+
 struct rk_rpmsg_dev {
 	struct platform_device *pdev;
 	enum rk_rpmsg_chip chip;
@@ -53,6 +75,7 @@ struct rk_rpmsg_dev {
 	struct mbox_chan *mbox_rx_chan;
 	struct mbox_chan *mbox_tx_chan;
 	struct rk_virtio_dev *rpvdev[RPMSG_MAX_INSTANCE_NUM];
+	struct rk_rpmsg_ring *ring;
 };
 
 struct rk_rpmsg_vq_info {
@@ -73,6 +96,15 @@ static void rk_rpmsg_rx_callback(struct mbox_client *client, void *message)
 	rx_msg = message;
 	dev_dbg(dev, "rpmsg master: receive cmd=0x%x data=0x%x\n",
 		rx_msg->cmd, rx_msg->data);
+	if (rx_msg->data == RPMSG_RING_MAGIC && rpdev->ring) {
+		struct rk_rpmsg_ring *ring = rpdev->ring;
+
+		spin_lock(&ring->lock);
+		if (ring->notify)
+			ring->notify(ring->priv);
+		spin_unlock(&ring->lock);
+		return;
+	}
 	if (rx_msg->data != RPMSG_MBOX_MAGIC)
 		dev_err(dev, "rpmsg master: mailbox data error!\n");
 	link_id = rx_msg->cmd & 0xFFU;
@@ -295,11 +327,297 @@ static int rk_set_vring_phy_buf(struct platform_device *pdev,
 	return ret;
 }
 
+static int rk_rpmsg_ring_doorbell(struct rk_rpmsg_ring *ring)
+{
+	struct rk_rpmsg_dev *rpdev = ring->rpdev;
+	struct rockchip_mbox_msg tx_msg;
+	int ret;
+
+	memset(&tx_msg, 0, sizeof(tx_msg));
+	tx_msg.cmd = rpdev->link_id & 0xFFU;
+	tx_msg.data = RPMSG_RING_MAGIC;
+
+	ret = mbox_send_message(rpdev->mbox_tx_chan, &tx_msg);
+	if (ret < 0)
+		return ret;
+	mbox_chan_txdone(rpdev->mbox_tx_chan, 0);
+
+	return 0;
+}
+
+/* Snapshot head and tail of a ring, under the hwspinlock if there is one */
+static int rk_rpmsg_ring_indexes(struct rk_rpmsg_ring *ring,
+				 struct rk_rpmsg_ring_dir *dir,
+				 u32 *head, u32 *tail)
+{
+	unsigned long flags;
+	int ret;
+
+	if (ring->hwlock) {
+		ret = hwspin_lock_timeout_irqsave(ring->hwlock,
+						  RPMSG_RING_LOCK_TIMEOUT_MS,
+						  &flags);
+		if (ret)
+			return ret;
+	}
+
+	*head = le32_to_cpu(READ_ONCE(dir->ctrl->head));
+	*tail = le32_to_cpu(READ_ONCE(dir->ctrl->tail));
+
+	if (ring->hwlock)
+		hwspin_unlock_irqrestore(ring->hwlock, &flags);
+
+	return 0;
+}
+
+static int rk_rpmsg_ring_advance(struct rk_rpmsg_ring *ring, __le32 *index,
+				 size_t len)
+{
+	unsigned long flags;
+	int ret;
+
+	if (ring->hwlock) {
+		ret = hwspin_lock_timeout_irqsave(ring->hwlock,
+						  RPMSG_RING_LOCK_TIMEOUT_MS,
+						  &flags);
+		if (ret)
+			return ret;
+	}
+
+	WRITE_ONCE(*index, cpu_to_le32(le32_to_cpu(READ_ONCE(*index)) + len));
+
+	if (ring->hwlock)
+		hwspin_unlock_irqrestore(ring->hwlock, &flags);
+
+	return rk_rpmsg_ring_doorbell(ring);
+}
+
+/**
+ * rk_rpmsg_ring_tx_span - free room of the Linux to remote ring
+ * @ring: ring from rk_rpmsg_ring_get()
+ * @buf: set to where the next bytes go
+ *
+ * The producer writes straight into the shared memory at @buf and
+ * publishes it with rk_rpmsg_ring_tx_commit(). Only one producer may
+ * use a ring at a time.
+ *
+ * Return: how many contiguous bytes may be written at @buf.
+ */
+size_t rk_rpmsg_ring_tx_span(struct rk_rpmsg_ring *ring, void **buf)
+{
+	struct rk_rpmsg_ring_dir *tx = &ring->tx;
+	u32 head, tail, off;
+
+	if (rk_rpmsg_ring_indexes(ring, tx, &head, &tail))
+		return 0;
+
+	off = head & (tx->size - 1);
+	*buf = tx->data + off;
+
+	return min(tx->size - (head - tail), tx->size - off);
+}
+EXPORT_SYMBOL(rk_rpmsg_ring_tx_span);
+
+int rk_rpmsg_ring_tx_commit(struct rk_rpmsg_ring *ring, size_t len)
+{
+	struct rk_rpmsg_ring_dir *tx = &ring->tx;
+	u32 head, tail;
+	int ret;
+
+	ret = rk_rpmsg_ring_indexes(ring, tx, &head, &tail);
+	if (ret)
+		return ret;
+	if (len > tx->size - (head - tail))
+		return -EINVAL;
+
+	/* data before head */
+	wmb();
+
+	return rk_rpmsg_ring_advance(ring, &tx->ctrl->head, len);
+}
+EXPORT_SYMBOL(rk_rpmsg_ring_tx_commit);
+
+/**
+ * rk_rpmsg_ring_rx_span - pending data of the remote to Linux ring
+ * @ring: ring from rk_rpmsg_ring_get()
+ * @buf: set to the oldest unread byte
+ *
+ * The data is read in place and given back to the remote with
+ * rk_rpmsg_ring_rx_release(). Only one consumer may use a ring at a
+ * time.
+ *
+ * Return: how many contiguous bytes may be read at @buf.
+ */
+size_t rk_rpmsg_ring_rx_span(struct rk_rpmsg_ring *ring, const void **buf)
+{
+	struct rk_rpmsg_ring_dir *rx = &ring->rx;
+	u32 head, tail, off;
+
+	if (rk_rpmsg_ring_indexes(ring, rx, &head, &tail))
+		return 0;
+
+	/* head before data */
+	rmb();
+
+	off = tail & (rx->size - 1);
+	*buf = rx->data + off;
+
+	return min(head - tail, rx->size - off);
+}
+EXPORT_SYMBOL(rk_rpmsg_ring_rx_span);
+
+int rk_rpmsg_ring_rx_release(struct rk_rpmsg_ring *ring, size_t len)
+{
+	struct rk_rpmsg_ring_dir *rx = &ring->rx;
+	u32 head, tail;
+	int ret;
+
+	ret = rk_rpmsg_ring_indexes(ring, rx, &head, &tail);
+	if (ret)
+		return ret;
+	if (len > head - tail)
+		return -EINVAL;
+
+	/* reads done before the room is handed back */
+	mb();
+
+	return rk_rpmsg_ring_advance(ring, &rx->ctrl->tail, len);
+}
+EXPORT_SYMBOL(rk_rpmsg_ring_rx_release);
+
+/**
+ * rk_rpmsg_ring_get - claim the shared ring channel of an rpmsg node
+ * @np: the rockchip rpmsg device node
+ * @notify: called from the mailbox interrupt when the remote moved an
+ *	    index, must not sleep
+ * @priv: passed to @notify
+ *
+ * Return: the ring, or an ERR_PTR, -EPROBE_DEFER if the node is not
+ * probed yet.
+ */
+struct rk_rpmsg_ring *rk_rpmsg_ring_get(struct device_node *np,
+					void (*notify)(void *priv),
+					void *priv)
+{
+	struct platform_device *pdev;
+	struct rk_rpmsg_dev *rpdev;
+	struct rk_rpmsg_ring *ring;
+	unsigned long flags;
+
+	pdev = of_find_device_by_node(np);
+	if (!pdev)
+		return ERR_PTR(-EPROBE_DEFER);
+
+	rpdev = platform_get_drvdata(pdev);
+	if (!rpdev) {
+		put_device(&pdev->dev);
+		return ERR_PTR(-EPROBE_DEFER);
+	}
+
+	ring = rpdev->ring;
+	if (!ring) {
+		put_device(&pdev->dev);
+		return ERR_PTR(-ENODEV);
+	}
+
+	spin_lock_irqsave(&ring->lock, flags);
+	if (ring->claimed) {
+		spin_unlock_irqrestore(&ring->lock, flags);
+		put_device(&pdev->dev);
+		return ERR_PTR(-EBUSY);
+	}
+	ring->claimed = true;
+	ring->notify = notify;
+	ring->priv = priv;
+	spin_unlock_irqrestore(&ring->lock, flags);
+
+	return ring;
+}
+EXPORT_SYMBOL(rk_rpmsg_ring_get);
+
+void rk_rpmsg_ring_put(struct rk_rpmsg_ring *ring)
+{
+	unsigned long flags;
+
+	if (IS_ERR_OR_NULL(ring))
+		return;
+
+	spin_lock_irqsave(&ring->lock, flags);
+	ring->claimed = false;
+	ring->notify = NULL;
+	ring->priv = NULL;
+	spin_unlock_irqrestore(&ring->lock, flags);
+
+	put_device(&ring->rpdev->pdev->dev);
+}
+EXPORT_SYMBOL(rk_rpmsg_ring_put);
+
+static void rk_rpmsg_ring_init_dir(struct rk_rpmsg_ring_dir *dir, void *ctrl,
+				   void *data, u32 size)
+{
+	dir->ctrl = ctrl;
+	dir->data = data;
+	dir->size = size;
+
+	WRITE_ONCE(dir->ctrl->head, 0);
+	WRITE_ONCE(dir->ctrl->tail, 0);
+	WRITE_ONCE(dir->ctrl->size, cpu_to_le32(size));
+	wmb();
+	WRITE_ONCE(dir->ctrl->magic, cpu_to_le32(RPMSG_RING_MAGIC));
+}
+
+static int rk_rpmsg_ring_init(struct platform_device *pdev,
+			      struct rk_rpmsg_dev *rpdev, struct resource *res)
+{
+	struct device *dev = &pdev->dev;
+	struct rk_rpmsg_ring *ring;
+	resource_size_t len = resource_size(res);
+	u32 size;
+	void *base;
+	int id;
+
+	if (len <= 2 * RPMSG_RING_CTRL_SIZE)
+		return -EINVAL;
+	size = rounddown_pow_of_two((len - 2 * RPMSG_RING_CTRL_SIZE) / 2);
+
+	ring = devm_kzalloc(dev, sizeof(*ring), GFP_KERNEL);
+	if (!ring)
+		return -ENOMEM;
+
+	if (of_property_read_bool(dev->of_node, "hwlocks")) {
+		id = of_hwspin_lock_get_id(dev->of_node, 0);
+		if (id < 0)
+			return id;
+		ring->hwlock = devm_hwspin_lock_request_specific(dev, id);
+		if (IS_ERR(ring->hwlock))
+			return PTR_ERR(ring->hwlock);
+	}
+
+	base = devm_memremap(dev, res->start, len, MEMREMAP_WC);
+	if (IS_ERR(base))
+		return PTR_ERR(base);
+
+	rk_rpmsg_ring_init_dir(&ring->tx, base,
+			       base + 2 * RPMSG_RING_CTRL_SIZE, size);
+	rk_rpmsg_ring_init_dir(&ring->rx, base + RPMSG_RING_CTRL_SIZE,
+			       base + 2 * RPMSG_RING_CTRL_SIZE + size, size);
+
+	spin_lock_init(&ring->lock);
+	ring->rpdev = rpdev;
+	rpdev->ring = ring;
+
+	dev_info(dev, "shared ring: 2 x %u bytes at %pa%s\n", size, &res->start,
+		 ring->hwlock ? ", hwspinlock" : "");
+
+	return 0;
+}
+
 static int rockchip_rpmsg_probe(struct platform_device *pdev)
 {
 	struct device *dev = &pdev->dev;
 	struct rk_rpmsg_dev *rpdev = NULL;
 	struct mbox_client *cl;
+	struct resource *res;
 	int i, ret = 0;
 
 	rpdev = devm_kzalloc(dev, sizeof(*rpdev), GFP_KERNEL);
@@ -350,6 +668,16 @@ static int rockchip_rpmsg_probe(struct platform_device *pdev)
 		ret = -ENOMEM;
 		goto free_channel;
 	}
+
+	res = platform_get_resource(pdev, IORESOURCE_MEM, 1);
+	if (res) {
+		ret = rk_rpmsg_ring_init(pdev, rpdev, res);
+		if (ret) {
+			dev_err(dev, "failed to set up shared ring: %d\n", ret);
+			goto free_channel;
+		}
+	}
+
 	if (of_reserved_mem_device_init(dev)) {
 		dev_info(dev, "No shared DMA pool.\n");
 		rpdev->flags &= (~RPMSG_SHARED_DMA_POOL);
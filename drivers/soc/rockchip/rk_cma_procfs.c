@@ -6,13 +6,148 @@
  */
 
 #include <linux/cma.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
 #include <linux/module.h>
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
 #include <linux/slab.h>
+#include <trace/events/cma.h>
+#include <trace/hooks/mm.h>
 
 #include "../../../mm/cma.h"
 
+/* <1 ms, then power of two ms buckets, the last one open ended */
+#define CMA_PROCFS_LAT_BUCKETS		12
+/* busy pfns remembered, most likely pinned pages */
+#define CMA_PROCFS_BLOCKERS		8
+
+struct cma_procfs_stats {
+	unsigned long allocs;
+	unsigned long fails;
+	u64 lat_total_ns;
+	u64 lat_max_ns;
+	unsigned long lat_hist[CMA_PROCFS_LAT_BUCKETS];
+	unsigned long nr_migrated;
+	unsigned long nr_reclaimed;
+	unsigned long nr_isolate_fail;
+	unsigned long nr_migrate_fail;
+	unsigned long nr_test_fail;
+	unsigned long busy_retries;
+	unsigned long blocker_pfn[CMA_PROCFS_BLOCKERS];
+	unsigned int blocker_next;
+};
+
+static struct cma *cma_procfs_areas[MAX_CMA_AREAS];
+static struct cma_procfs_stats cma_procfs_stats[MAX_CMA_AREAS];
+static int cma_procfs_count;
+/* allocations are rare enough for one lock to cover all areas */
+static DEFINE_SPINLOCK(cma_procfs_lock);
+
+static struct cma_procfs_stats *cma_procfs_stats_get(const struct cma *cma)
+{
+	int i;
+
+	for (i = 0; i < cma_procfs_count; i++)
+		if (cma_procfs_areas[i] == cma)
+			return &cma_procfs_stats[i];
+
+	return NULL;
+}
+
+static struct cma_procfs_stats *cma_procfs_stats_by_name(const char *name)
+{
+	int i;
+
+	for (i = 0; i < cma_procfs_count; i++)
+		if (!strcmp(cma_procfs_areas[i]->name, name))
+			return &cma_procfs_stats[i];
+
+	return NULL;
+}
+
+static void cma_procfs_alloc_info(void *data, const char *name,
+				  const struct page *page, unsigned int count,
+				  unsigned int align,
+				  struct cma_alloc_info *info)
+{
+	struct cma_procfs_stats *st = cma_procfs_stats_by_name(name);
+	unsigned long flags;
+
+	if (!st)
+		return;
+
+	spin_lock_irqsave(&cma_procfs_lock, flags);
+	st->nr_migrated += info->nr_migrated;
+	st->nr_reclaimed += info->nr_reclaimed;
+	st->nr_isolate_fail += info->nr_isolate_fail;
+	st->nr_migrate_fail += info->nr_migrate_fail;
+	st->nr_test_fail += info->nr_test_fail;
+	spin_unlock_irqrestore(&cma_procfs_lock, flags);
+}
+
+static void cma_procfs_busy_retry(void *data, const char *name,
+				  unsigned long pfn, const struct page *page,
+				  unsigned int count, unsigned int align)
+{
+	struct cma_procfs_stats *st = cma_procfs_stats_by_name(name);
+	unsigned long flags;
+
+	if (!st)
+		return;
+
+	spin_lock_irqsave(&cma_procfs_lock, flags);
+	st->busy_retries++;
+	st->blocker_pfn[st->blocker_next] = pfn;
+	st->blocker_next = (st->blocker_next + 1) % CMA_PROCFS_BLOCKERS;
+	spin_unlock_irqrestore(&cma_procfs_lock, flags);
+}
+
+#ifdef CONFIG_ANDROID_VENDOR_HOOKS
+static void cma_procfs_alloc_start(void *data, s64 *ts)
+{
+	*ts = ktime_get_ns();
+}
+
+static void cma_procfs_alloc_finish(void *data, struct cma *cma,
+				    struct page *page, unsigned long count,
+				    unsigned int align, gfp_t gfp_mask, s64 ts)
+{
+	struct cma_procfs_stats *st = cma_procfs_stats_get(cma);
+	u64 ns = ktime_get_ns() - ts;
+	unsigned long flags;
+	int bucket = 0;
+
+	if (!st)
+		return;
+
+	if (ns >= NSEC_PER_MSEC)
+		bucket = min_t(int, ilog2(div_u64(ns, NSEC_PER_MSEC)) + 1,
+			       CMA_PROCFS_LAT_BUCKETS - 1);
+
+	spin_lock_irqsave(&cma_procfs_lock, flags);
+	st->allocs++;
+	if (!page)
+		st->fails++;
+	st->lat_total_ns += ns;
+	st->lat_max_ns = max(st->lat_max_ns, ns);
+	st->lat_hist[bucket]++;
+	spin_unlock_irqrestore(&cma_procfs_lock, flags);
+}
+
+static void cma_procfs_register_hooks(void)
+{
+	register_trace_android_vh_cma_alloc_start(cma_procfs_alloc_start,
+						  NULL);
+	register_trace_android_vh_cma_alloc_finish(cma_procfs_alloc_finish,
+						   NULL);
+}
+#else
+static inline void cma_procfs_register_hooks(void)
+{
+}
+#endif
+
 static void cma_procfs_format_array(char *buf, size_t bufsize, u32 *array, int array_size)
 {
 	int i = 0;
@@ -56,24 +191,123 @@ static u64 cma_procfs_used_get(struct cma *cma)
 	return (u64)used << cma->order_per_bit;
 }
 
+/* Free runs of the bitmap, how fragmented the area is right now */
+static void cma_procfs_show_free(struct seq_file *s, struct cma *cma)
+{
+	unsigned long bits = cma_bitmap_maxno(cma);
+	unsigned long start = 0, end, largest = 0, runs = 0;
+
+	mutex_lock(&cma->lock);
+	for (;;) {
+		start = find_next_zero_bit(cma->bitmap, bits, start);
+		if (start >= bits)
+			break;
+		end = find_next_bit(cma->bitmap, bits, start);
+		largest = max(largest, end - start);
+		runs++;
+		start = end;
+	}
+	mutex_unlock(&cma->lock);
+
+	seq_printf(s, " Free: %lu chunks, largest %lu KiB\n", runs,
+		   (largest << cma->order_per_bit) << (PAGE_SHIFT - 10));
+}
+
+static void cma_procfs_show_stats(struct seq_file *s, struct cma *cma)
+{
+	struct cma_procfs_stats *st = cma_procfs_stats_get(cma);
+	struct cma_procfs_stats snap;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&cma_procfs_lock, flags);
+	snap = *st;
+	spin_unlock_irqrestore(&cma_procfs_lock, flags);
+
+	seq_printf(s, "\nAllocs: %lu, failed %lu, avg %llu us, max %llu us\n",
+		   snap.allocs, snap.fails,
+		   snap.allocs ? div_u64(snap.lat_total_ns, snap.allocs) /
+				 NSEC_PER_USEC : 0,
+		   div_u64(snap.lat_max_ns, NSEC_PER_USEC));
+	for (i = 0; i < CMA_PROCFS_LAT_BUCKETS; i++) {
+		if (!snap.lat_hist[i])
+			continue;
+		if (!i)
+			seq_puts(s, "  <1 ms");
+		else if (i == CMA_PROCFS_LAT_BUCKETS - 1)
+			seq_printf(s, "  >=%u ms", 1 << (i - 1));
+		else
+			seq_printf(s, "  %u-%u ms", 1 << (i - 1), 1 << i);
+		seq_printf(s, ": %lu\n", snap.lat_hist[i]);
+	}
+
+	seq_printf(s, "Migrated: %lu pages, reclaimed %lu\n",
+		   snap.nr_migrated, snap.nr_reclaimed);
+	seq_printf(s, "Failures: isolate %lu, migrate %lu, test %lu\n",
+		   snap.nr_isolate_fail, snap.nr_migrate_fail,
+		   snap.nr_test_fail);
+	seq_printf(s, "Busy retries: %lu\n", snap.busy_retries);
+	for (i = 0; i < CMA_PROCFS_BLOCKERS; i++) {
+		unsigned long pfn;
+
+		pfn = snap.blocker_pfn[(snap.blocker_next + i) %
+				       CMA_PROCFS_BLOCKERS];
+		if (pfn)
+			seq_printf(s, "  busy pfn 0x%lx\n", pfn);
+	}
+}
+
 static int cma_procfs_show(struct seq_file *s, void *private)
 {
 	struct cma *cma = s->private;
 	u64 used = cma_procfs_used_get(cma);
 
 	seq_printf(s, "Total: %lu KiB\n", cma->count << (PAGE_SHIFT - 10));
-	seq_printf(s, " Used: %llu KiB\n\n", used << (PAGE_SHIFT - 10));
+	seq_printf(s, " Used: %llu KiB\n", used << (PAGE_SHIFT - 10));
+	cma_procfs_show_free(s, cma);
+	cma_procfs_show_stats(s, cma);
+	seq_puts(s, "\n");
 
 	cma_procfs_show_bitmap(s, cma);
 
 	return 0;
 }
 
+static int cma_procfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, cma_procfs_show, PDE_DATA(inode));
+}
+
+/* Any write resets the telemetry, e.g. before starting the camera */
+static ssize_t cma_procfs_write(struct file *file, const char __user *buf,
+				size_t count, loff_t *ppos)
+{
+	struct cma *cma = PDE_DATA(file_inode(file));
+	struct cma_procfs_stats *st = cma_procfs_stats_get(cma);
+	unsigned long flags;
+
+	spin_lock_irqsave(&cma_procfs_lock, flags);
+	memset(st, 0, sizeof(*st));
+	spin_unlock_irqrestore(&cma_procfs_lock, flags);
+
+	return count;
+}
+
+static const struct proc_ops cma_procfs_ops = {
+	.proc_open	= cma_procfs_open,
+	.proc_read	= seq_read,
+	.proc_lseek	= seq_lseek,
+	.proc_release	= single_release,
+	.proc_write	= cma_procfs_write,
+};
+
 static int cma_procfs_add_one(struct cma *cma, void *data)
 {
 	struct proc_dir_entry *root = data;
 
-	proc_create_single_data(cma->name, 0, root, cma_procfs_show, cma);
+	if (cma_procfs_count < MAX_CMA_AREAS)
+		cma_procfs_areas[cma_procfs_count++] = cma;
+	proc_create_data(cma->name, 0644, root, &cma_procfs_ops, cma);
 
 	return 0;
 }
@@ -81,8 +315,17 @@ static int cma_procfs_add_one(struct cma *cma, void *data)
 static int rk_cma_procfs_init(void)
 {
 	struct proc_dir_entry *root = proc_mkdir("rk_cma", NULL);
+	int ret;
+
+	ret = cma_for_each_area(cma_procfs_add_one, (void *)root);
+	if (ret)
+		return ret;
 
-	return cma_for_each_area(cma_procfs_add_one, (void *)root);
+	register_trace_cma_alloc_info(cma_procfs_alloc_info, NULL);
+	register_trace_cma_alloc_busy_retry(cma_procfs_busy_retry, NULL);
+	cma_procfs_register_hooks();
+
+	return 0;
 }
 late_initcall_sync(rk_cma_procfs_init);
 
@@ -143,6 +143,37 @@ static int rk_dmabuf_peak_show(struct seq_file *s, void *v)
 	return 0;
 }
 
+static int rk_dmabuf_account_cb(const struct dma_buf_account *acct,
+				void *private)
+{
+	struct seq_file *s = private;
+
+	if (acct->pid)
+		seq_printf(s, "%8d %-16.16s", acct->pid, acct->name);
+	else
+		seq_printf(s, "%-25.25s", acct->name);
+	seq_printf(s, " %6lu %10lu KiB %10lu KiB\n",
+		   acct->count, K(acct->size), K(acct->peak));
+
+	return 0;
+}
+
+static int rk_dmabuf_heap_show(struct seq_file *s, void *v)
+{
+	seq_printf(s, "%-25s %6s %14s %14s\n\n",
+		   "EXPORT", "COUNT", "SIZE", "PEAK");
+
+	return get_each_dmabuf_heap(rk_dmabuf_account_cb, s);
+}
+
+static int rk_dmabuf_process_show(struct seq_file *s, void *v)
+{
+	seq_printf(s, "%8s %-16s %6s %14s %14s\n\n",
+		   "PID", "COMM", "COUNT", "SIZE", "PEAK");
+
+	return get_each_dmabuf_process(rk_dmabuf_account_cb, s);
+}
+
 static ssize_t rk_dmabuf_peak_write(struct file *file,
 				    const char __user *buffer,
 				    size_t count, loff_t *ppos)
@@ -193,6 +224,8 @@ static int __init rk_dmabuf_init(void)
 	proc_create_single("dev", 0, root, rk_dmabuf_dev_show);
 	proc_create_single("size", 0, root, rk_dmabuf_size_show);
 	proc_create("peak", 0644, root, &rk_dmabuf_peak_ops);
+	proc_create_single("heap", 0, root, rk_dmabuf_heap_show);
+	proc_create_single("process", 0, root, rk_dmabuf_process_show);
 
 	return 0;
 }
@@ -58,6 +58,10 @@
 #include <linux/kernel_stat.h>
 #include <linux/irq.h>
 #include <linux/delay.h>
+#include <linux/debugfs.h>
+#include <linux/hrtimer.h>
+#include <linux/kfifo.h>
+#include <linux/uaccess.h>
 
 #include "fiq_debugger/fiq_debugger_priv.h"
 #include "rockchip_debug.h"
@@ -415,6 +419,217 @@ static int rockchip_panic_notify_pmpcsr(struct notifier_block *nb,
 }
 #endif
 
+#ifdef CONFIG_DEBUG_FS
+/*
+ * Statistical PC sampler: an hrtimer pinned on the cpu that enabled it
+ * reads the PC sample register of every other online cpu. The sampled
+ * cpus need no interrupt, so the PCs are seen even where they run with
+ * interrupts masked. The sampling cpu itself is never sampled, the only
+ * PC it could see is the sampler's.
+ *
+ *   echo 100 > /sys/kernel/debug/pcsr/period_us
+ *   echo 1 > /sys/kernel/debug/pcsr/enable
+ *   cat /sys/kernel/debug/pcsr/samples
+ */
+#define PCSR_FIFO_SIZE			4096
+#define PCSR_DEFAULT_PERIOD_US		100
+
+struct pcsr_sample {
+	u64 time;
+	unsigned long pc;
+	u32 cpu;
+};
+
+static DEFINE_KFIFO(pcsr_fifo, struct pcsr_sample, PCSR_FIFO_SIZE);
+static DEFINE_MUTEX(pcsr_lock);
+static struct hrtimer pcsr_timer;
+static u32 pcsr_period_us = PCSR_DEFAULT_PERIOD_US;
+static bool pcsr_enabled;
+static u32 pcsr_dropped;
+
+static bool rockchip_debug_read_pcsr(int cpu, unsigned long *pc)
+{
+	void __iomem *base = rockchip_cpu_debug[cpu];
+	u64 pcsr;
+
+	if ((readl(base + EDPRSR) & EDPRSR_PU) != EDPRSR_PU)
+		return false;
+
+	if (edpcsr_present) {
+		/* relocked by a power down, unlock so EDPCSRhi is populated */
+		writel(EDLAR_UNLOCK, base + EDLAR);
+		pcsr = readl(base + EDPCSR_LO);
+		if (sizeof(*pc) == 8)
+			pcsr |= (u64)readl(base + EDPCSR_HI) << 32;
+	} else if (IS_ENABLED(CONFIG_ARM64) && rockchip_cs_pmu[cpu]) {
+		base = rockchip_cs_pmu[cpu];
+		pcsr = ((u64)readl(base + PMPCSR_LO)) |
+		       ((u64)readl(base + PMPCSR_HI) << 32);
+		if (((pcsr >> 61) & 0x3) == 2)
+			pcsr |= 0xff00000000000000;
+		else
+			pcsr &= 0x0fffffffffffffff;
+	} else {
+		return false;
+	}
+
+	/* an idle cpu or one without PC sampling reads all ones */
+	if ((unsigned long)pcsr == ~0UL)
+		return false;
+
+	/* NOTE: no offset on ARMv8; see DBGDEVID1.PCSROffset */
+	*pc = (unsigned long)pcsr & ~1UL;
+
+	return true;
+}
+
+static enum hrtimer_restart rockchip_pcsr_timer_fn(struct hrtimer *timer)
+{
+	struct pcsr_sample s;
+	int cpu;
+
+	s.time = ktime_get_ns();
+	for (cpu = 0; rockchip_cpu_debug[cpu]; cpu++) {
+		if (cpu == smp_processor_id() || !cpu_online(cpu))
+			continue;
+		if (!rockchip_debug_read_pcsr(cpu, &s.pc))
+			continue;
+		s.cpu = cpu;
+		if (!kfifo_put(&pcsr_fifo, s))
+			pcsr_dropped++;
+	}
+
+	hrtimer_forward_now(timer, us_to_ktime(pcsr_period_us));
+
+	return HRTIMER_RESTART;
+}
+
+static int rockchip_pcsr_enable_get(void *data, u64 *val)
+{
+	*val = pcsr_enabled;
+
+	return 0;
+}
+
+static int rockchip_pcsr_enable_set(void *data, u64 val)
+{
+	int ret = 0;
+
+	mutex_lock(&pcsr_lock);
+	if (val && !pcsr_enabled) {
+		/* a single cpu would only ever sample the sampler */
+		if (num_online_cpus() < 2) {
+			ret = -ENODEV;
+			goto out;
+		}
+		pcsr_dropped = 0;
+		kfifo_reset(&pcsr_fifo);
+		hrtimer_start(&pcsr_timer, us_to_ktime(pcsr_period_us),
+			      HRTIMER_MODE_REL_PINNED);
+		pcsr_enabled = true;
+	} else if (!val && pcsr_enabled) {
+		hrtimer_cancel(&pcsr_timer);
+		pcsr_enabled = false;
+	}
+out:
+	mutex_unlock(&pcsr_lock);
+
+	return ret;
+}
+
+DEFINE_DEBUGFS_ATTRIBUTE(rockchip_pcsr_enable_fops, rockchip_pcsr_enable_get,
+			 rockchip_pcsr_enable_set, "%llu\n");
+
+static int rockchip_pcsr_period_get(void *data, u64 *val)
+{
+	*val = pcsr_period_us;
+
+	return 0;
+}
+
+static int rockchip_pcsr_period_set(void *data, u64 val)
+{
+	if (val < 10 || val > USEC_PER_SEC)
+		return -EINVAL;
+
+	WRITE_ONCE(pcsr_period_us, val);
+
+	return 0;
+}
+
+DEFINE_DEBUGFS_ATTRIBUTE(rockchip_pcsr_period_fops, rockchip_pcsr_period_get,
+			 rockchip_pcsr_period_set, "%llu\n");
+
+/* drains the fifo, one "cpu time_ns pc symbol" line per sample */
+static ssize_t rockchip_pcsr_samples_read(struct file *file, char __user *buf,
+					  size_t count, loff_t *ppos)
+{
+	struct pcsr_sample s;
+	char line[KSYM_SYMBOL_LEN + 64];
+	size_t copied = 0;
+	int len;
+
+	mutex_lock(&pcsr_lock);
+	while (kfifo_peek(&pcsr_fifo, &s)) {
+		len = scnprintf(line, sizeof(line), "%u %llu 0x%px %pS\n",
+				s.cpu, s.time, (void *)s.pc, (void *)s.pc);
+		if (copied + len > count)
+			break;
+		if (copy_to_user(buf + copied, line, len)) {
+			mutex_unlock(&pcsr_lock);
+			return copied ? copied : -EFAULT;
+		}
+		kfifo_skip(&pcsr_fifo);
+		copied += len;
+	}
+	mutex_unlock(&pcsr_lock);
+
+	*ppos += copied;
+
+	return copied;
+}
+
+static const struct file_operations rockchip_pcsr_samples_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.read = rockchip_pcsr_samples_read,
+	.llseek = no_llseek,
+};
+
+static struct dentry *rockchip_pcsr_debugfs_root;
+
+static void rockchip_pcsr_debugfs_init(void)
+{
+	hrtimer_init(&pcsr_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_PINNED);
+	pcsr_timer.function = rockchip_pcsr_timer_fn;
+
+	rockchip_pcsr_debugfs_root = debugfs_create_dir("pcsr", NULL);
+	debugfs_create_file_unsafe("enable", 0644, rockchip_pcsr_debugfs_root,
+				   NULL, &rockchip_pcsr_enable_fops);
+	debugfs_create_file_unsafe("period_us", 0644,
+				   rockchip_pcsr_debugfs_root, NULL,
+				   &rockchip_pcsr_period_fops);
+	debugfs_create_file("samples", 0400, rockchip_pcsr_debugfs_root, NULL,
+			    &rockchip_pcsr_samples_fops);
+	debugfs_create_u32("dropped", 0444, rockchip_pcsr_debugfs_root,
+			   &pcsr_dropped);
+}
+
+static void rockchip_pcsr_debugfs_exit(void)
+{
+	debugfs_remove_recursive(rockchip_pcsr_debugfs_root);
+	rockchip_pcsr_enable_set(NULL, 0);
+}
+#else
+static inline void rockchip_pcsr_debugfs_init(void)
+{
+}
+
+static inline void rockchip_pcsr_debugfs_exit(void)
+{
+}
+#endif
+
 static int rockchip_show_interrupts(char *p, int irq)
 {
 	static int prec;
@@ -581,6 +796,8 @@ static int __init rockchip_debug_init(void)
 					       &rockchip_panic_nb);
 	}
 
+	rockchip_pcsr_debugfs_init();
+
 	return 0;
 }
 arch_initcall(rockchip_debug_init);
@@ -589,6 +806,8 @@ static void __exit rockchip_debug_exit(void)
 {
 	int i = 0;
 
+	rockchip_pcsr_debugfs_exit();
+
 	atomic_notifier_chain_unregister(&panic_notifier_list,
 					 &rockchip_panic_nb);
 	if (IS_ENABLED(CONFIG_NO_GKI)) {
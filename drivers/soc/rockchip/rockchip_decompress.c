@@ -4,7 +4,9 @@
  */
 #include <linux/clk.h>
 #include <linux/delay.h>
+#include <linux/dma-mapping.h>
 #include <linux/initramfs.h>
+#include <linux/initrd.h>
 #include <linux/interrupt.h>
 #include <linux/kernel.h>
 #include <linux/mm.h>
@@ -14,7 +16,10 @@
 #include <linux/of_device.h>
 #include <linux/platform_device.h>
 #include <linux/reset.h>
+#include <linux/slab.h>
 #include <linux/soc/rockchip/rockchip_decompress.h>
+#include <linux/xxhash.h>
+#include <asm/unaligned.h>
 
 #define DECOM_CTRL		0x0
 #define DECOM_ENR		0x4
@@ -73,6 +78,16 @@
 #define DECOM_ENABLE		0x1
 #define DECOM_DISABLE		0x0
 
+/* LZ4 frame wrapped around a bare block for LZ4_BLOCK_MOD */
+#define DECOM_LZ4_MAGIC		0x184d2204
+#define DECOM_LZ4_FLG		0x60	/* version 01, independent blocks */
+#define DECOM_LZ4_BD		0x70	/* 4MB blocks */
+#define DECOM_LZ4_HEAD		11	/* magic, FLG, BD, HC, block size */
+#define DECOM_LZ4_TAIL		4	/* end mark */
+
+#define DECOM_BUF_TIMEOUT_MS	500
+#define DECOM_INITRD_TIMEOUT_S	5
+
 #define DECOM_INT_MASK \
 	(DSOLIEN | ZDICTEIEN | GCMEIEN | GIDEIEN | \
 	CCCEIEN | BCCEIEN | HCCEIEN | CSEIEN | \
@@ -96,8 +111,24 @@ static struct rk_decom *g_decom;
 static DECLARE_WAIT_QUEUE_HEAD(g_decom_wait);
 static bool g_decom_complete;
 static bool g_decom_noblocking;
+static bool g_decom_quiet;
 static u64 g_decom_data_len;
 
+/* rk_decom_buf() callers and their bounce buffers */
+static DEFINE_MUTEX(g_decom_buf_lock);
+static void *g_decom_src;
+static size_t g_decom_src_size;
+static void *g_decom_dst;
+static size_t g_decom_dst_size;
+
+/* initrd inflated by the engine while the initcalls run */
+static DECLARE_COMPLETION(g_initrd_started);
+static bool g_initrd_busy;
+static void *g_initrd_buf;
+static size_t g_initrd_size;
+static dma_addr_t g_initrd_dma;
+static dma_addr_t g_initrd_src_dma;
+
 void __init wait_initrd_hw_decom_done(void)
 {
 	wait_event(g_decom_wait, g_decom_complete);
@@ -205,6 +236,153 @@ int rk_decom_start(u32 mode, phys_addr_t src, phys_addr_t dst, u32 dst_max_size)
 }
 EXPORT_SYMBOL(rk_decom_start);
 
+bool rk_decom_available(void)
+{
+	return READ_ONCE(g_decom);
+}
+EXPORT_SYMBOL(rk_decom_available);
+
+static void *rk_decom_bounce(void **buf, size_t *size, size_t len)
+{
+	if (*size >= len)
+		return *buf;
+
+	kfree(*buf);
+	*size = 0;
+	*buf = kmalloc(len, GFP_NOIO | __GFP_NOWARN);
+	if (*buf)
+		*size = len;
+
+	return *buf;
+}
+
+/* Frame a bare LZ4 block the way the engine parses LZ4_MOD input */
+static size_t rk_decom_lz4_frame(u8 *frame, const void *src, size_t src_len)
+{
+	put_unaligned_le32(DECOM_LZ4_MAGIC, frame);
+	frame[4] = DECOM_LZ4_FLG;
+	frame[5] = DECOM_LZ4_BD;
+	frame[6] = (xxh32(frame + 4, 2, 0) >> 8) & 0xff;
+	put_unaligned_le32(src_len, frame + 7);
+	memcpy(frame + DECOM_LZ4_HEAD, src, src_len);
+	put_unaligned_le32(0, frame + DECOM_LZ4_HEAD + src_len);
+
+	return DECOM_LZ4_HEAD + src_len + DECOM_LZ4_TAIL;
+}
+
+static bool rk_decom_dst_linear(const void *dst, size_t len)
+{
+	return !is_vmalloc_addr(dst) && virt_addr_valid(dst) &&
+	       virt_addr_valid(dst + len - 1) &&
+	       IS_ALIGNED((unsigned long)dst | len, dma_get_cache_alignment());
+}
+
+/**
+ * rk_decom_buf - decompress one buffer with the engine and wait for it
+ * @mode: LZ4_MOD, LZ4_BLOCK_MOD, GZIP_MOD or ZLIB_MOD
+ * @src: compressed data, any kernel mapping
+ * @src_len: length of @src
+ * @dst: output, any kernel mapping
+ * @dst_len: room in @dst
+ *
+ * For filesystems reading compressed blocks from process context. The
+ * input is copied to a bounce buffer, the output is written in place if
+ * @dst is cache aligned linear memory and bounced otherwise. Callers are
+ * serialised and sleep while the engine runs.
+ *
+ * Return: the decompressed length, -EOPNOTSUPP when the engine is not
+ * worth it or missing, another negative errno if the engine failed. The
+ * caller is expected to fall back to software in any of these cases.
+ */
+int rk_decom_buf(u32 mode, const void *src, size_t src_len,
+		 void *dst, size_t dst_len)
+{
+	struct rk_decom *rk_dec = READ_ONCE(g_decom);
+	dma_addr_t src_dma, dst_dma;
+	size_t frame_len;
+	void *out;
+	long left;
+	int ret;
+
+	if (!rk_dec || dst_len < RK_DECOM_BUF_MIN_SIZE || dst_len > U32_MAX ||
+	    READ_ONCE(g_initrd_busy))
+		return -EOPNOTSUPP;
+
+	mutex_lock(&g_decom_buf_lock);
+
+	frame_len = src_len;
+	if (mode == LZ4_BLOCK_MOD)
+		frame_len += DECOM_LZ4_HEAD + DECOM_LZ4_TAIL;
+	if (!rk_decom_bounce(&g_decom_src, &g_decom_src_size, frame_len)) {
+		ret = -ENOMEM;
+		goto unlock;
+	}
+
+	if (mode == LZ4_BLOCK_MOD) {
+		frame_len = rk_decom_lz4_frame(g_decom_src, src, src_len);
+		mode = LZ4_MOD;
+	} else {
+		memcpy(g_decom_src, src, src_len);
+	}
+
+	out = dst;
+	if (!rk_decom_dst_linear(dst, dst_len)) {
+		out = rk_decom_bounce(&g_decom_dst, &g_decom_dst_size, dst_len);
+		if (!out) {
+			ret = -ENOMEM;
+			goto unlock;
+		}
+	}
+
+	src_dma = dma_map_single(rk_dec->dev, g_decom_src, frame_len,
+				 DMA_TO_DEVICE);
+	if (dma_mapping_error(rk_dec->dev, src_dma)) {
+		ret = -ENOMEM;
+		goto unlock;
+	}
+
+	dst_dma = dma_map_single(rk_dec->dev, out, dst_len, DMA_FROM_DEVICE);
+	if (dma_mapping_error(rk_dec->dev, dst_dma)) {
+		ret = -ENOMEM;
+		goto unmap_src;
+	}
+
+	g_decom_quiet = true;
+	ret = rk_decom_start(mode | DECOM_NOBLOCKING, src_dma, dst_dma, dst_len);
+	if (ret)
+		goto unmap_dst;
+
+	left = wait_event_timeout(g_decom_wait, g_decom_complete,
+				  msecs_to_jiffies(DECOM_BUF_TIMEOUT_MS));
+	if (!left) {
+		writel(DECOM_DISABLE, rk_dec->regs + DECOM_ENR);
+		writel(0, rk_dec->regs + DECOM_IEN);
+		clk_bulk_disable_unprepare(rk_dec->num_clocks, rk_dec->clocks);
+		ret = -ETIMEDOUT;
+		goto unmap_dst;
+	}
+
+	/* let the irq thread gate the clocks before the next request */
+	synchronize_irq(rk_dec->irq);
+
+	ret = -EIO;
+	if (g_decom_data_len && g_decom_data_len <= dst_len)
+		ret = g_decom_data_len;
+
+unmap_dst:
+	g_decom_quiet = false;
+	dma_unmap_single(rk_dec->dev, dst_dma, dst_len, DMA_FROM_DEVICE);
+	if (ret > 0 && out != dst)
+		memcpy(dst, out, ret);
+unmap_src:
+	dma_unmap_single(rk_dec->dev, src_dma, frame_len, DMA_TO_DEVICE);
+unlock:
+	mutex_unlock(&g_decom_buf_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL(rk_decom_buf);
+
 static irqreturn_t rk_decom_irq_handler(int irq, void *priv)
 {
 	struct rk_decom *rk_dec = priv;
@@ -227,15 +405,18 @@ static irqreturn_t rk_decom_irq_handler(int irq, void *priv)
 					 "decom completed, decom_data_len = %llu\n",
 					 g_decom_data_len);
 		} else {
-			dev_info(rk_dec->dev,
-				 "decom failed, irq_status = 0x%x, decom_status = 0x%x, try again !\n",
-				 irq_status, decom_status);
+			if (!g_decom_quiet) {
+				dev_info(rk_dec->dev,
+					 "decom failed, irq_status = 0x%x, decom_status = 0x%x, try again !\n",
+					 irq_status, decom_status);
 
-			print_hex_dump(KERN_WARNING, "", DUMP_PREFIX_OFFSET,
-				       32, 4, rk_dec->regs, 0x128, false);
+				print_hex_dump(KERN_WARNING, "", DUMP_PREFIX_OFFSET,
+					       32, 4, rk_dec->regs, 0x128, false);
+			}
 
 			if (g_decom_noblocking) {
-				dev_info(rk_dec->dev, "decom failed and exit in noblocking mode.");
+				if (!g_decom_quiet)
+					dev_info(rk_dec->dev, "decom failed and exit in noblocking mode.");
 				writel(DECOM_DISABLE, rk_dec->regs + DECOM_ENR);
 				writel(0, g_decom->regs + DECOM_IEN);
 
@@ -297,22 +478,20 @@ static int __init rockchip_decom_probe(struct platform_device *pdev)
 		return -ENOENT;
 	}
 
+	/* only there when the loader started inflating the ramdisk */
 	mem = of_parse_phandle(np, "memory-region", 0);
-	if (!mem) {
-		dev_err(dev, "missing \"memory-region\" property\n");
-		return -ENODEV;
-	}
+	if (mem) {
+		ret = of_address_to_resource(mem, 0, &reg);
+		of_node_put(mem);
+		if (ret) {
+			dev_err(dev, "missing \"reg\" property\n");
+			return -ENODEV;
+		}
 
-	ret = of_address_to_resource(mem, 0, &reg);
-	of_node_put(mem);
-	if (ret) {
-		dev_err(dev, "missing \"reg\" property\n");
-		return -ENODEV;
+		rk_dec->mem_start = reg.start;
+		rk_dec->mem_size = resource_size(&reg);
 	}
 
-	rk_dec->mem_start = reg.start;
-	rk_dec->mem_size = resource_size(&reg);
-
 	rk_dec->num_clocks = devm_clk_bulk_get_all(dev, &rk_dec->clocks);
 	if (rk_dec->num_clocks < 0) {
 		dev_err(dev, "failed to get decompress clock\n");
@@ -386,3 +565,115 @@ static int __init rockchip_hw_decompress_init(void)
 }
 
 pure_initcall(rockchip_hw_decompress_init);
+
+static void __init rk_decom_initrd_free(void)
+{
+	dma_unmap_single(g_decom->dev, g_initrd_src_dma,
+			 initrd_end - initrd_start, DMA_TO_DEVICE);
+	dma_free_noncoherent(g_decom->dev, g_initrd_size, g_initrd_buf,
+			     g_initrd_dma, DMA_FROM_DEVICE);
+	g_initrd_buf = NULL;
+	WRITE_ONCE(g_initrd_busy, false);
+}
+
+/*
+ * A gzip initrd the loader left compressed is inflated by the engine
+ * from here, as soon as CMA is up, instead of by software inflate in
+ * populate_rootfs() much later. Only gzip carries the output size in
+ * its trailer, other formats are left to software.
+ */
+static int __init rk_decom_initrd_start(void)
+{
+	struct rk_decom *rk_dec = g_decom;
+	size_t len = initrd_end - initrd_start;
+	const u8 *head = (const u8 *)initrd_start;
+	u32 size;
+
+	if (!rk_dec || rk_dec->mem_start || !initrd_start || len < 18 ||
+	    head[0] != 0x1f || head[1] != 0x8b)
+		goto out;
+
+	size = get_unaligned_le32((void *)initrd_end - 4);
+	if (size < RK_DECOM_BUF_MIN_SIZE)
+		goto out;
+
+	g_initrd_buf = dma_alloc_noncoherent(rk_dec->dev, size, &g_initrd_dma,
+					     DMA_FROM_DEVICE,
+					     GFP_KERNEL | __GFP_NOWARN);
+	if (!g_initrd_buf)
+		goto out;
+	g_initrd_size = size;
+
+	g_initrd_src_dma = dma_map_single(rk_dec->dev, (void *)initrd_start,
+					  len, DMA_TO_DEVICE);
+	if (dma_mapping_error(rk_dec->dev, g_initrd_src_dma)) {
+		dma_free_noncoherent(rk_dec->dev, size, g_initrd_buf,
+				     g_initrd_dma, DMA_FROM_DEVICE);
+		g_initrd_buf = NULL;
+		goto out;
+	}
+
+	WRITE_ONCE(g_initrd_busy, true);
+	if (rk_decom_start(GZIP_MOD | DECOM_NOBLOCKING, g_initrd_src_dma,
+			   g_initrd_dma, size))
+		rk_decom_initrd_free();
+	else
+		dev_info(rk_dec->dev, "inflating %zu bytes of initrd\n", len);
+out:
+	complete_all(&g_initrd_started);
+
+	return 0;
+}
+core_initcall_sync(rk_decom_initrd_start);
+
+/**
+ * rk_decom_initrd_get - wait for the engine to inflate the initrd
+ * @len: set to the length of the cpio archive
+ *
+ * Return: the uncompressed initrd, to be given back with
+ * rk_decom_initrd_put(), or NULL if populate_rootfs() has to inflate
+ * initrd_start itself.
+ */
+char * __init rk_decom_initrd_get(unsigned long *len)
+{
+	struct rk_decom *rk_dec = g_decom;
+	long left;
+
+	wait_for_completion(&g_initrd_started);
+	if (!g_initrd_buf)
+		return NULL;
+
+	left = wait_event_timeout(g_decom_wait, g_decom_complete,
+				  DECOM_INITRD_TIMEOUT_S * HZ);
+	if (!left) {
+		writel(DECOM_DISABLE, rk_dec->regs + DECOM_ENR);
+		writel(0, rk_dec->regs + DECOM_IEN);
+		clk_bulk_disable_unprepare(rk_dec->num_clocks, rk_dec->clocks);
+	} else {
+		synchronize_irq(rk_dec->irq);
+	}
+
+	/*
+	 * The trailer only describes the last member of a concatenated
+	 * archive, where the engine stops after the first one. Anything
+	 * but an exact match goes back to software.
+	 */
+	if (!left || g_decom_data_len != g_initrd_size) {
+		dev_warn(rk_dec->dev, "initrd inflate failed, %llu/%zu bytes\n",
+			 g_decom_data_len, g_initrd_size);
+		rk_decom_initrd_free();
+		return NULL;
+	}
+
+	dma_sync_single_for_cpu(rk_dec->dev, g_initrd_dma, g_initrd_size,
+				DMA_FROM_DEVICE);
+	*len = g_initrd_size;
+
+	return g_initrd_buf;
+}
+
+void __init rk_decom_initrd_put(void)
+{
+	if (g_initrd_buf)
+		rk_decom_initrd_free();
+}
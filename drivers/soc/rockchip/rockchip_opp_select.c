@@ -7,6 +7,7 @@
 #include <linux/clk.h>
 #include <linux/cpufreq.h>
 #include <linux/devfreq.h>
+#include <linux/math64.h>
 #include <linux/mfd/syscon.h>
 #include <linux/module.h>
 #include <linux/nvmem-consumer.h>
@@ -760,6 +761,10 @@ static int rockchip_pvtpll_parse_dt(struct rockchip_opp_info *info)
 		goto out;
 
 	ret = of_property_read_u32(np, "rockchip,pvtpll-volt-step", &info->pvtpll_volt_step);
+	if (ret)
+		goto out;
+
+	of_property_read_u32(np, "rockchip,pvtpll-avs-margin", &info->pvtpll_avs_margin);
 out:
 	of_node_put(np);
 
@@ -984,6 +989,46 @@ void rockchip_pvtpll_calibrate_opp(struct rockchip_opp_info *info)
 }
 EXPORT_SYMBOL(rockchip_pvtpll_calibrate_opp);
 
+/*
+ * Closed loop avs: measure the pvtpll at the running rate and voltage, and
+ * return the voltage one step closer to keeping the pvtpll ahead of the
+ * rate by rockchip,pvtpll-avs-margin. Below half of the margin the voltage
+ * goes back up, so margin lost to temperature is given back at once.
+ */
+int rockchip_pvtpll_avs_get_volt(struct rockchip_opp_info *info,
+				 struct regulator *reg, unsigned long rate,
+				 unsigned long volt, unsigned long volt_min,
+				 unsigned long volt_max, unsigned long *target)
+{
+	unsigned long pvtpll_rate;
+	s64 margin;
+	int step;
+
+	if (!info || !info->grf || !info->pvtpll_avs_margin || !rate)
+		return -EINVAL;
+
+	pvtpll_rate = rockchip_pvtpll_get_rate(info);
+	if (!pvtpll_rate)
+		return -EIO;
+
+	step = regulator_get_linear_step(reg);
+	if (!step || info->pvtpll_volt_step > step)
+		step = info->pvtpll_volt_step;
+
+	margin = div64_s64(((s64)pvtpll_rate - (s64)rate) * 1000, rate);
+	*target = volt;
+	if (margin > info->pvtpll_avs_margin && volt >= volt_min + step)
+		*target = volt - step;
+	else if (margin < info->pvtpll_avs_margin / 2 && volt < volt_max)
+		*target = min(volt + step, volt_max);
+
+	dev_dbg(info->dev, "avs: %lu Hz pvtpll %lu Hz margin %lld, %lu uV -> %lu uV\n",
+		rate, pvtpll_rate, margin, volt, *target);
+
+	return 0;
+}
+EXPORT_SYMBOL(rockchip_pvtpll_avs_get_volt);
+
 void rockchip_pvtpll_add_length(struct rockchip_opp_info *info)
 {
 	struct device_node *np;
@@ -5,6 +5,8 @@
 #include <linux/kernel.h>
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
+#include <linux/workqueue.h>
+#include <uapi/linux/sched/types.h>
 #include <soc/rockchip/rockchip_performance.h>
 #include <../../kernel/sched/sched.h>
 
@@ -141,6 +143,179 @@ struct cpumask *rockchip_perf_get_cpub_mask(void)
 	return NULL;
 }
 
+#ifdef CONFIG_UCLAMP_TASK
+/* load sampling period of the running audio streams */
+#define AUDIO_SAMPLE_MS		100
+
+static LIST_HEAD(audio_list);
+static DEFINE_MUTEX(audio_mutex);
+static void audio_work_func(struct work_struct *work);
+static DECLARE_DELAYED_WORK(audio_work, audio_work_func);
+
+static void audio_set_util_min(struct task_struct *p, int util_min)
+{
+	struct sched_attr attr = {
+		.size = sizeof(attr),
+		.sched_policy = -1,
+		.sched_flags = SCHED_FLAG_KEEP_ALL | SCHED_FLAG_UTIL_CLAMP_MIN,
+		.sched_nice = task_nice(p),
+		.sched_priority = p->rt_priority,
+		.sched_util_min = util_min,
+	};
+
+	if (dl_task(p))
+		return;
+
+	sched_setattr_nocheck(p, &attr);
+}
+
+static void audio_restore(struct rockchip_perf_audio *audio)
+{
+	if (audio->applied)
+		audio_set_util_min(audio->task, audio->orig_util_min);
+	audio->applied = false;
+	audio->stamp = 0;
+}
+
+/*
+ * The busy time of the task over the last period, scaled by the current
+ * capacity of its CPU, is the capacity it needs whatever the frequency.
+ * schedutil adds its own 25% on top of the clamp, 1/8 more absorbs the
+ * frame to frame variation. Going up is immediate, going down is slow.
+ */
+static void audio_update(struct rockchip_perf_audio *audio)
+{
+	struct task_struct *p = audio->task;
+	u64 now = ktime_get_ns();
+	u64 exec = READ_ONCE(p->se.sum_exec_runtime);
+	unsigned long cap, util;
+	int cpu = task_cpu(p);
+
+	if (!audio->stamp) {
+		/* nothing measured yet, start from the last stream's need */
+		util = audio->util_min ? audio->util_min :
+		       SCHED_CAPACITY_SCALE / 2;
+	} else {
+		cap = arch_scale_cpu_capacity(cpu) *
+		      arch_scale_freq_capacity(cpu) >> SCHED_CAPACITY_SHIFT;
+		util = div64_u64((exec - audio->exec) * cap,
+				 max_t(u64, now - audio->stamp, 1));
+		util += util >> 3;
+		if (util < audio->util_min)
+			util = (audio->util_min * 3 + util) >> 2;
+		util = min_t(unsigned long, util, SCHED_CAPACITY_SCALE);
+	}
+
+	audio->stamp = now;
+	audio->exec = exec;
+
+	if (audio->applied && abs((int)util - (int)audio->util_min) < 16)
+		return;
+
+	audio->util_min = util;
+	audio->applied = true;
+	audio_set_util_min(p, util);
+}
+
+static void audio_work_func(struct work_struct *work)
+{
+	struct rockchip_perf_audio *audio;
+	bool running = false;
+
+	mutex_lock(&audio_mutex);
+	list_for_each_entry(audio, &audio_list, node) {
+		/* the global RT clamp already runs everything at max */
+		if (!READ_ONCE(audio->running) ||
+		    perf_level == ROCKCHIP_PERFORMANCE_HIGH) {
+			audio_restore(audio);
+			continue;
+		}
+		audio_update(audio);
+		running = true;
+	}
+	if (running)
+		schedule_delayed_work(&audio_work,
+				      msecs_to_jiffies(AUDIO_SAMPLE_MS));
+	mutex_unlock(&audio_mutex);
+}
+
+static void audio_put_locked(struct rockchip_perf_audio *audio)
+{
+	if (!audio->task)
+		return;
+
+	audio_restore(audio);
+	list_del(&audio->node);
+	put_task_struct(audio->task);
+	audio->task = NULL;
+}
+
+/**
+ * rockchip_perf_audio_get - track the thread serving a PCM stream
+ * @audio: per stream state, zeroed by the caller before first use
+ * @task: the thread woken by the period interrupts
+ *
+ * Nothing changes for @task until rockchip_perf_audio_set_running().
+ * May sleep.
+ */
+void rockchip_perf_audio_get(struct rockchip_perf_audio *audio,
+			     struct task_struct *task)
+{
+	mutex_lock(&audio_mutex);
+	if (audio->task != task) {
+		audio_put_locked(audio);
+		get_task_struct(task);
+		audio->task = task;
+		audio->orig_util_min = task->uclamp_req[UCLAMP_MIN].user_defined ?
+				       task->uclamp_req[UCLAMP_MIN].value : -1;
+		list_add(&audio->node, &audio_list);
+	}
+	mutex_unlock(&audio_mutex);
+}
+EXPORT_SYMBOL_GPL(rockchip_perf_audio_get);
+
+/**
+ * rockchip_perf_audio_put - give the thread its own uclamp back
+ * @audio: per stream state
+ *
+ * May sleep.
+ */
+void rockchip_perf_audio_put(struct rockchip_perf_audio *audio)
+{
+	mutex_lock(&audio_mutex);
+	audio_put_locked(audio);
+	audio->running = false;
+	mutex_unlock(&audio_mutex);
+}
+EXPORT_SYMBOL_GPL(rockchip_perf_audio_put);
+
+/**
+ * rockchip_perf_audio_set_running - the stream started or stopped
+ * @audio: per stream state
+ * @running: true when the stream enters RUNNING
+ *
+ * Safe from the atomic PCM trigger, the clamp is applied from a work.
+ */
+void rockchip_perf_audio_set_running(struct rockchip_perf_audio *audio,
+				     bool running)
+{
+	WRITE_ONCE(audio->running, running);
+	mod_delayed_work(system_wq, &audio_work, 0);
+}
+EXPORT_SYMBOL_GPL(rockchip_perf_audio_set_running);
+#else
+void rockchip_perf_audio_get(struct rockchip_perf_audio *audio,
+			     struct task_struct *task) { }
+EXPORT_SYMBOL_GPL(rockchip_perf_audio_get);
+
+void rockchip_perf_audio_put(struct rockchip_perf_audio *audio) { }
+EXPORT_SYMBOL_GPL(rockchip_perf_audio_put);
+
+void rockchip_perf_audio_set_running(struct rockchip_perf_audio *audio,
+				     bool running) { }
+EXPORT_SYMBOL_GPL(rockchip_perf_audio_set_running);
+#endif /* CONFIG_UCLAMP_TASK */
+
 #ifdef CONFIG_SMP
 int rockchip_perf_select_rt_cpu(int prev_cpu, struct cpumask *lowest_mask)
 {
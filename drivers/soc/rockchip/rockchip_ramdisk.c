@@ -8,11 +8,15 @@
 
 #include <linux/backing-dev.h>
 #include <linux/dax.h>
+#include <linux/genalloc.h>
+#include <linux/io.h>
+#include <linux/lz4.h>
 #include <linux/module.h>
 #include <linux/of_address.h>
 #include <linux/pfn_t.h>
 #include <linux/platform_device.h>
 #include <linux/uio.h>
+#include <linux/vmalloc.h>
 
 #define PAGE_SECTORS_SHIFT	(PAGE_SHIFT - SECTOR_SHIFT)
 #define PAGE_SECTORS		(1 << PAGE_SECTORS_SHIFT)
@@ -26,7 +30,22 @@ struct rd_device {
 	size_t			mem_size;
 	size_t			mem_pages;
 	void			*mem_kaddr;
+	bool			mem_mapped;	/* in the linear map, with pages */
 	struct dax_device	*dax_dev;
+
+	/* compressed mode, the region is a pool of LZ4 compressed pages */
+	struct rd_zpage		*zpages;	/* one per page of the disk */
+	struct gen_pool		*zpool;
+	struct mutex		zlock;		/* zpages and the buffers below */
+	void			*zwrkmem;
+	void			*zbuf;		/* compression output */
+	void			*zpage;		/* partial page read/modify/write */
+};
+
+/* Where a page of a compressed disk is stored, len 0 for a zero page */
+struct rd_zpage {
+	void			*addr;
+	unsigned int		len;	/* PAGE_SIZE if stored uncompressed */
 };
 
 static int rd_major;
@@ -57,6 +76,12 @@ static void copy_to_rd(struct rd_device *rd, const void *src,
 	unsigned int offset = (sector & (PAGE_SECTORS - 1)) << SECTOR_SHIFT;
 	size_t copy;
 
+	/* A no-map region has no struct pages, only the memremap()ing */
+	if (!rd->mem_mapped) {
+		memcpy(rd->mem_kaddr + (sector << SECTOR_SHIFT), src, n);
+		return;
+	}
+
 	copy = min_t(size_t, n, PAGE_SIZE - offset);
 	page = rd_lookup_page(rd, sector);
 	BUG_ON(!page);
@@ -89,6 +114,11 @@ static void copy_from_rd(void *dst, struct rd_device *rd,
 	unsigned int offset = (sector & (PAGE_SECTORS - 1)) << SECTOR_SHIFT;
 	size_t copy;
 
+	if (!rd->mem_mapped) {
+		memcpy(dst, rd->mem_kaddr + (sector << SECTOR_SHIFT), n);
+		return;
+	}
+
 	copy = min_t(size_t, n, PAGE_SIZE - offset);
 	page = rd_lookup_page(rd, sector);
 	if (page) {
@@ -114,6 +144,235 @@ static void copy_from_rd(void *dst, struct rd_device *rd,
 	}
 }
 
+#ifdef CONFIG_ROCKCHIP_RAMDISK_COMPRESS
+/* pool allocation granule */
+#define RD_ZALLOC_ORDER		6
+
+static void rd_zfree(struct rd_device *rd, pgoff_t idx)
+{
+	struct rd_zpage *zp = &rd->zpages[idx];
+
+	if (zp->len)
+		gen_pool_free(rd->zpool, (unsigned long)zp->addr, zp->len);
+	zp->addr = NULL;
+	zp->len = 0;
+}
+
+/*
+ * Copy n bytes at offset of page idx to dst, decompressing it.
+ * Called with zlock held.
+ */
+static int rd_zread(struct rd_device *rd, pgoff_t idx, void *dst,
+		    unsigned int offset, unsigned int n)
+{
+	struct rd_zpage *zp = &rd->zpages[idx];
+	void *out;
+	int ret;
+
+	if (!zp->len) {
+		memset(dst, 0, n);
+		return 0;
+	}
+
+	if (zp->len == PAGE_SIZE) {
+		memcpy(dst, zp->addr + offset, n);
+		return 0;
+	}
+
+	out = n == PAGE_SIZE ? dst : rd->zpage;
+	ret = LZ4_decompress_safe(zp->addr, out, zp->len, PAGE_SIZE);
+	if (ret != PAGE_SIZE) {
+		dev_err_ratelimited(rd->dev, "page %lu corrupted (%d)\n",
+				    idx, ret);
+		return -EIO;
+	}
+	if (out != dst)
+		memcpy(dst, out + offset, n);
+
+	return 0;
+}
+
+/*
+ * Copy n bytes from src to offset of page idx, compressing it.
+ * Called with zlock held.
+ */
+static int rd_zwrite(struct rd_device *rd, pgoff_t idx, const void *src,
+		     unsigned int offset, unsigned int n)
+{
+	struct rd_zpage *zp = &rd->zpages[idx];
+	unsigned long addr;
+	const void *data;
+	int len, ret;
+
+	/* merge a partial write with the rest of the page */
+	if (n != PAGE_SIZE) {
+		ret = rd_zread(rd, idx, rd->zpage, 0, PAGE_SIZE);
+		if (ret)
+			return ret;
+		memcpy(rd->zpage + offset, src, n);
+		src = rd->zpage;
+	}
+
+	if (!memchr_inv(src, 0, PAGE_SIZE)) {
+		rd_zfree(rd, idx);
+		return 0;
+	}
+
+	data = rd->zbuf;
+	len = LZ4_compress_default(src, rd->zbuf, PAGE_SIZE,
+				   LZ4_COMPRESSBOUND(PAGE_SIZE), rd->zwrkmem);
+	if (len <= 0 || len >= PAGE_SIZE) {
+		data = src;
+		len = PAGE_SIZE;
+	}
+
+	/* allocate before freeing, a full pool keeps the old data */
+	addr = gen_pool_alloc(rd->zpool, len);
+	if (!addr) {
+		dev_warn_ratelimited(rd->dev, "out of memory for page %lu\n",
+				     idx);
+		return -ENOSPC;
+	}
+	memcpy((void *)addr, data, len);
+
+	rd_zfree(rd, idx);
+	zp->addr = (void *)addr;
+	zp->len = len;
+
+	return 0;
+}
+
+/* The mapping of a read is not atomic: decompression may sleep on zlock */
+static int rd_do_zbvec(struct rd_device *rd, struct page *page,
+		       unsigned int len, unsigned int off, unsigned int op,
+		       sector_t sector)
+{
+	void *mem;
+	int ret = 0;
+
+	mem = kmap(page);
+	if (op_is_write(op))
+		flush_dcache_page(page);
+
+	mutex_lock(&rd->zlock);
+	while (len) {
+		pgoff_t idx = sector >> PAGE_SECTORS_SHIFT;
+		unsigned int offset =
+			(sector & (PAGE_SECTORS - 1)) << SECTOR_SHIFT;
+		unsigned int n = min_t(unsigned int, len, PAGE_SIZE - offset);
+
+		if (op_is_write(op))
+			ret = rd_zwrite(rd, idx, mem + off, offset, n);
+		else
+			ret = rd_zread(rd, idx, mem + off, offset, n);
+		if (ret)
+			break;
+
+		off += n;
+		len -= n;
+		sector += n >> SECTOR_SHIFT;
+	}
+	mutex_unlock(&rd->zlock);
+
+	if (!op_is_write(op))
+		flush_dcache_page(page);
+	kunmap(page);
+
+	return ret;
+}
+
+/* Give back the pool memory of the whole pages in a discarded range */
+static void rd_zdiscard(struct rd_device *rd, sector_t sector,
+			unsigned int nr_sectors)
+{
+	pgoff_t idx = DIV_ROUND_UP(sector, PAGE_SECTORS);
+	pgoff_t end = (sector + nr_sectors) >> PAGE_SECTORS_SHIFT;
+
+	mutex_lock(&rd->zlock);
+	for (; idx < end; idx++)
+		rd_zfree(rd, idx);
+	mutex_unlock(&rd->zlock);
+}
+
+static void rd_swap_slot_free_notify(struct block_device *bdev,
+				     unsigned long index)
+{
+	struct rd_device *rd = bdev->bd_disk->private_data;
+
+	/* called under the swap lock, a busy page is freed on overwrite */
+	if (!rd->zpages || !mutex_trylock(&rd->zlock))
+		return;
+	rd_zfree(rd, index);
+	mutex_unlock(&rd->zlock);
+}
+
+/*
+ * An optional "rockchip,compress-ratio" property, the disk size in
+ * percent of the region size, turns the region into a pool of LZ4
+ * compressed pages. Zero pages take no room and pages which do not
+ * compress are stored as they are; writes fail with -ENOSPC once the
+ * pool is full, so the ratio should match the data the disk will hold.
+ */
+static int rd_zinit(struct rd_device *rd, u64 *disk_size)
+{
+	struct device *dev = rd->dev;
+	size_t nr_pages;
+	u32 ratio;
+	int ret;
+
+	if (of_property_read_u32(dev->of_node, "rockchip,compress-ratio",
+				 &ratio))
+		return 0;
+	if (ratio < 100) {
+		dev_err(dev, "compress-ratio %u below 100\n", ratio);
+		return -EINVAL;
+	}
+
+	*disk_size = round_down(div_u64((u64)rd->mem_size * ratio, 100),
+				PAGE_SIZE);
+	nr_pages = *disk_size >> PAGE_SHIFT;
+
+	rd->zpool = devm_gen_pool_create(dev, RD_ZALLOC_ORDER, NUMA_NO_NODE,
+					 NULL);
+	if (IS_ERR(rd->zpool))
+		return PTR_ERR(rd->zpool);
+	ret = gen_pool_add_virt(rd->zpool, (unsigned long)rd->mem_kaddr,
+				rd->mem_addr, rd->mem_size, NUMA_NO_NODE);
+	if (ret)
+		return ret;
+
+	rd->zwrkmem = devm_kmalloc(dev, LZ4_MEM_COMPRESS, GFP_KERNEL);
+	rd->zbuf = devm_kmalloc(dev, LZ4_COMPRESSBOUND(PAGE_SIZE), GFP_KERNEL);
+	rd->zpage = devm_kmalloc(dev, PAGE_SIZE, GFP_KERNEL);
+	rd->zpages = vzalloc(array_size(nr_pages, sizeof(*rd->zpages)));
+	if (!rd->zwrkmem || !rd->zbuf || !rd->zpage || !rd->zpages) {
+		vfree(rd->zpages);
+		rd->zpages = NULL;
+		return -ENOMEM;
+	}
+	mutex_init(&rd->zlock);
+
+	return 0;
+}
+#else
+static inline int rd_do_zbvec(struct rd_device *rd, struct page *page,
+			      unsigned int len, unsigned int off,
+			      unsigned int op, sector_t sector)
+{
+	return -EIO;
+}
+
+static inline void rd_zdiscard(struct rd_device *rd, sector_t sector,
+			       unsigned int nr_sectors)
+{
+}
+
+static inline int rd_zinit(struct rd_device *rd, u64 *disk_size)
+{
+	return 0;
+}
+#endif
+
 /*
  * Process a single bvec of a bio.
  */
@@ -123,6 +382,9 @@ static int rd_do_bvec(struct rd_device *rd, struct page *page,
 {
 	void *mem;
 
+	if (rd->zpages)
+		return rd_do_zbvec(rd, page, len, off, op, sector);
+
 	mem = kmap_atomic(page);
 	if (!op_is_write(op)) {
 		copy_from_rd(mem + off, rd, sector, len);
@@ -147,6 +409,11 @@ static blk_qc_t rd_submit_bio(struct bio *bio)
 	if (bio_end_sector(bio) > get_capacity(bio->bi_disk))
 		goto io_error;
 
+	if (bio_op(bio) == REQ_OP_DISCARD) {
+		rd_zdiscard(rd, sector, bio_sectors(bio));
+		goto out;
+	}
+
 	bio_for_each_segment(bvec, bio, iter) {
 		unsigned int len = bvec.bv_len;
 		int err;
@@ -162,6 +429,7 @@ static blk_qc_t rd_submit_bio(struct bio *bio)
 		sector += len >> SECTOR_SHIFT;
 	}
 
+out:
 	bio_endio(bio);
 	return BLK_QC_T_NONE;
 io_error:
@@ -186,6 +454,9 @@ static const struct block_device_operations rd_fops = {
 	.owner =	THIS_MODULE,
 	.submit_bio =	rd_submit_bio,
 	.rw_page =	rd_rw_page,
+#ifdef CONFIG_ROCKCHIP_RAMDISK_COMPRESS
+	.swap_slot_free_notify = rd_swap_slot_free_notify,
+#endif
 };
 
 static long rd_dax_direct_access(struct dax_device *dax_dev, pgoff_t pgoff,
@@ -204,11 +475,29 @@ static long rd_dax_direct_access(struct dax_device *dax_dev, pgoff_t pgoff,
 	return nr_pages > max_nr_pages ? max_nr_pages : nr_pages;
 }
 
+/*
+ * fsdax maps whole pages of the region into userspace, so a filesystem
+ * block must be a page and the filesystem must start on a page boundary.
+ */
 static bool rd_dax_supported(struct dax_device *dax_dev,
 			     struct block_device *bdev, int blocksize,
 			     sector_t start, sector_t sectors)
 {
-	return true;
+	struct rd_device *rd = dax_get_private(dax_dev);
+	sector_t offset = get_start_sect(bdev) + start;
+
+	if (blocksize != PAGE_SIZE) {
+		pr_info("%pg: dax needs a %lu byte block size\n", bdev,
+			PAGE_SIZE);
+		return false;
+	}
+
+	if (offset & (PAGE_SECTORS - 1)) {
+		pr_info("%pg: dax needs a page aligned partition\n", bdev);
+		return false;
+	}
+
+	return (offset + sectors) << SECTOR_SHIFT <= rd->mem_size;
 }
 
 static size_t rd_dax_copy_from_iter(struct dax_device *dax_dev, pgoff_t pgoff,
@@ -248,6 +537,7 @@ static int rd_init(struct rd_device *rd, int major, int minor)
 {
 	int ret;
 	struct gendisk *disk;
+	u64 disk_size = rd->mem_size;
 
 	rd->rd_queue = blk_alloc_queue(NUMA_NO_NODE);
 	if (!rd->rd_queue)
@@ -271,17 +561,38 @@ static int rd_init(struct rd_device *rd, int major, int minor)
 	disk->private_data	= rd;
 	disk->flags		= GENHD_FL_EXT_DEVT;
 	sprintf(disk->disk_name, "rd%d", minor);
-	set_capacity(disk, rd->mem_size >> SECTOR_SHIFT);
 	rd->rd_disk = disk;
 
-	rd->mem_kaddr = phys_to_virt(rd->mem_addr);
 	rd->mem_pages = PHYS_PFN(rd->mem_size);
-	rd->dax_dev = alloc_dax(rd, disk->disk_name, &rd_dax_ops, DAXDEV_F_SYNC);
-	if (IS_ERR(rd->dax_dev)) {
-		ret = PTR_ERR(rd->dax_dev);
-		dev_err(rd->dev, "alloc_dax failed %d\n", ret);
-		rd->dax_dev = NULL;
-		goto out_free_queue;
+	rd->mem_mapped = pfn_valid(PHYS_PFN(rd->mem_addr)) &&
+			 pfn_valid(PHYS_PFN(rd->mem_addr + rd->mem_size - 1));
+	if (rd->mem_mapped) {
+		rd->mem_kaddr = phys_to_virt(rd->mem_addr);
+	} else {
+		/* no-map region: usable as a block device, but not for dax */
+		rd->mem_kaddr = devm_memremap(rd->dev, rd->mem_addr,
+					      rd->mem_size, MEMREMAP_WB);
+		if (IS_ERR(rd->mem_kaddr)) {
+			ret = PTR_ERR(rd->mem_kaddr);
+			goto out_free_disk;
+		}
+	}
+
+	ret = rd_zinit(rd, &disk_size);
+	if (ret)
+		goto out_free_disk;
+	set_capacity(disk, disk_size >> SECTOR_SHIFT);
+
+	/* the region holds compressed data, there is nothing to map */
+	if (rd->mem_mapped && !rd->zpages) {
+		rd->dax_dev = alloc_dax(rd, disk->disk_name, &rd_dax_ops,
+					DAXDEV_F_SYNC);
+		if (IS_ERR(rd->dax_dev)) {
+			ret = PTR_ERR(rd->dax_dev);
+			dev_err(rd->dev, "alloc_dax failed %d\n", ret);
+			rd->dax_dev = NULL;
+			goto out_free_disk;
+		}
 	}
 
 	/* Tell the block layer that this is not a rotational device */
@@ -289,12 +600,19 @@ static int rd_init(struct rd_device *rd, int major, int minor)
 	blk_queue_flag_clear(QUEUE_FLAG_ADD_RANDOM, rd->rd_queue);
 	if (rd->dax_dev)
 		blk_queue_flag_set(QUEUE_FLAG_DAX, rd->rd_queue);
+	if (rd->zpages) {
+		rd->rd_queue->limits.discard_granularity = PAGE_SIZE;
+		blk_queue_max_discard_sectors(rd->rd_queue, UINT_MAX);
+		blk_queue_flag_set(QUEUE_FLAG_DISCARD, rd->rd_queue);
+	}
 
 	rd->rd_disk->queue = rd->rd_queue;
 	add_disk(rd->rd_disk);
 
 	return 0;
 
+out_free_disk:
+	put_disk(disk);
 out_free_queue:
 	blk_cleanup_queue(rd->rd_queue);
 	return ret;
@@ -330,8 +648,9 @@ static int rd_probe(struct platform_device *pdev)
 	rd->mem_size = resource_size(&reg);
 
 	ret = rd_init(rd, rd_major, 0);
-	dev_info(dev, "0x%zx@%pa -> 0x%px dax:%d ret:%d\n",
-		 rd->mem_size, &rd->mem_addr, rd->mem_kaddr, (bool)rd->dax_dev, ret);
+	dev_info(dev, "0x%zx@%pa -> 0x%px dax:%d lz4:%d ret:%d\n",
+		 rd->mem_size, &rd->mem_addr, rd->mem_kaddr, (bool)rd->dax_dev,
+		 (bool)rd->zpages, ret);
 
 	return ret;
 }
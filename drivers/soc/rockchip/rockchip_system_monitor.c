@@ -42,6 +42,7 @@
 #define CPU_REBOOT_FREQ		816000 /* kHz */
 #define VIDEO_1080P_SIZE	(1920 * 1080)
 #define THERMAL_POLLING_DELAY	200 /* milliseconds */
+#define BUDGET_NOTICE_MARGIN	5000 /* millicelsius */
 
 struct video_info {
 	unsigned int width;
@@ -75,6 +76,8 @@ struct system_monitor {
 	int offline_cpus_temp;
 	int temp_hysteresis;
 	unsigned int delay;
+	/* percent of the max cpu rate sustainable at the current temperature */
+	unsigned int cpu_budget;
 	bool is_temp_offline;
 };
 
@@ -404,6 +407,15 @@ static ssize_t status_store(struct kobject *kobj, struct kobj_attribute *attr,
 static struct system_monitor_attr status =
 	__ATTR(system_status, 0644, status_show, status_store);
 
+static ssize_t cpu_budget_show(struct kobject *kobj,
+			       struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", rockchip_system_monitor_get_cpu_budget());
+}
+
+static struct system_monitor_attr cpu_budget =
+	__ATTR(cpu_budget, 0444, cpu_budget_show, NULL);
+
 static int rockchip_get_temp_freq_table(struct device_node *np,
 					char *porp_name,
 					struct temp_freq_table **freq_table)
@@ -1614,8 +1626,141 @@ static void rockchip_system_monitor_temp_cpu_on_off(int temp)
 	rockchip_system_monitor_cpu_on_off();
 }
 
+/*
+ * The rate a cpu device will be limited to once it is BUDGET_NOTICE_MARGIN
+ * hotter, as a percent of its max rate, so that clients can lower their
+ * load before the limit hits instead of missing deadlines after.
+ */
+static unsigned int
+rockchip_system_monitor_cpu_budget(struct monitor_dev_info *info, int temp)
+{
+	unsigned long max_freq = ULONG_MAX, limit = 0;
+	struct dev_pm_opp *opp;
+	int i;
+
+	if (info->high_limit_table) {
+		for (i = 0; info->high_limit_table[i].freq != UINT_MAX; i++) {
+			if (temp + BUDGET_NOTICE_MARGIN >
+			    info->high_limit_table[i].temp)
+				limit = info->high_limit_table[i].freq * 1000;
+		}
+	} else if (temp + BUDGET_NOTICE_MARGIN > info->high_temp) {
+		limit = info->high_limit;
+	}
+	if (!limit)
+		return 100;
+
+	opp = dev_pm_opp_find_freq_floor(info->dev, &max_freq);
+	if (IS_ERR(opp))
+		return 100;
+	dev_pm_opp_put(opp);
+	if (limit >= max_freq)
+		return 100;
+
+	return limit / (max_freq / 100);
+}
+
+static void rockchip_system_monitor_update_budget(unsigned int budget)
+{
+	unsigned int old = system_monitor->cpu_budget;
+
+	if (budget == old)
+		return;
+
+	system_monitor->cpu_budget = budget;
+	sysfs_notify(system_monitor->kobj, NULL, "cpu_budget");
+
+	if (old == 100) {
+		rockchip_set_system_status(SYS_STATUS_THERMAL_BUDGET);
+	} else if (budget == 100) {
+		rockchip_clear_system_status(SYS_STATUS_THERMAL_BUDGET);
+	} else {
+		/* the bit does not change, but the budget did */
+		mutex_lock(&system_status_mutex);
+		rockchip_system_status_notifier_call_chain(system_status);
+		mutex_unlock(&system_status_mutex);
+	}
+}
+
+/**
+ * rockchip_system_monitor_get_cpu_budget - sustainable cpu workload
+ *
+ * Return: the percent of the max cpu rate that the hottest-limited cpu
+ * cluster can sustain at the current temperature, or is about to be
+ * limited to. Below 100, SYS_STATUS_THERMAL_BUDGET is set and every change
+ * goes through the system status notifiers.
+ */
+unsigned int rockchip_system_monitor_get_cpu_budget(void)
+{
+	if (!system_monitor)
+		return 100;
+
+	return READ_ONCE(system_monitor->cpu_budget);
+}
+EXPORT_SYMBOL(rockchip_system_monitor_get_cpu_budget);
+
+/*
+ * Re-measure the pvtpll margin of the running opp and move its voltage a
+ * step within [u_volt_min, the voltage the opp was registered with]. Only
+ * the vdd supply is handled, and the low temperature voltages are left as
+ * they are.
+ */
+static void rockchip_system_monitor_avs_adjust(struct monitor_dev_info *info)
+{
+	struct rockchip_opp_info *opp_info = info->devp->opp_info;
+	struct dev_pm_opp *opp;
+	unsigned long rate, volt, volt_min, volt_max = 0, target;
+	int i, max_count, ret;
+
+	if (!opp_info || !opp_info->pvtpll_avs_margin || !info->opp_table ||
+	    !info->regulators || !info->clk || info->regulator_count > 1 ||
+	    info->is_low_temp)
+		return;
+	if (info->devp->type == MONITOR_TPYE_DEV && !pm_runtime_active(info->dev))
+		return;
+
+	mutex_lock(&info->volt_adjust_mutex);
+	rate = clk_get_rate(info->clk);
+	opp = dev_pm_opp_find_freq_exact(info->dev, rate, true);
+	if (IS_ERR(opp))
+		goto unlock;
+	volt = opp->supplies[0].u_volt;
+	volt_min = opp->supplies[0].u_volt_min;
+	dev_pm_opp_put(opp);
+
+	/* a change is still pending, or the rail is held up by another user */
+	if (regulator_get_voltage(info->regulators[0]) != volt)
+		goto unlock;
+
+	max_count = dev_pm_opp_get_opp_count(info->dev);
+	for (i = 0; i < max_count; i++) {
+		if (info->opp_table[i].rate == rate) {
+			volt_max = info->opp_table[i].volt;
+			break;
+		}
+	}
+	if (!volt_max)
+		goto unlock;
+
+	ret = rockchip_pvtpll_avs_get_volt(opp_info, info->regulators[0], rate,
+					   volt, volt_min, volt_max, &target);
+	if (ret || target == volt)
+		goto unlock;
+
+	ret = dev_pm_opp_adjust_voltage(info->dev, rate, target, volt_min,
+					info->opp_table[i].max_volt);
+	mutex_unlock(&info->volt_adjust_mutex);
+	if (!ret && info->devp->update_volt)
+		info->devp->update_volt(info);
+	return;
+
+unlock:
+	mutex_unlock(&info->volt_adjust_mutex);
+}
+
 static void rockchip_system_monitor_thermal_update(void)
 {
+	unsigned int budget = 100;
 	int temp, ret;
 	struct monitor_dev_info *info;
 
@@ -1625,6 +1770,11 @@ static void rockchip_system_monitor_thermal_update(void)
 
 	dev_dbg(system_monitor->dev, "temperature=%d\n", temp);
 
+	down_read(&mdev_list_sem);
+	list_for_each_entry(info, &monitor_dev_list, node)
+		rockchip_system_monitor_avs_adjust(info);
+	up_read(&mdev_list_sem);
+
 	if (temp < system_monitor->last_temp &&
 	    system_monitor->last_temp - temp <= 2000)
 		goto out;
@@ -1633,10 +1783,18 @@ static void rockchip_system_monitor_thermal_update(void)
 	rockchip_system_monitor_temp_notify(temp);
 
 	down_read(&mdev_list_sem);
-	list_for_each_entry(info, &monitor_dev_list, node)
+	list_for_each_entry(info, &monitor_dev_list, node) {
 		rockchip_system_monitor_wide_temp_adjust(info, temp);
+		if (info->devp->type == MONITOR_TPYE_CPU)
+			budget = min(budget,
+				     rockchip_system_monitor_cpu_budget(info,
+									temp));
+	}
 	up_read(&mdev_list_sem);
 
+	/* the status notifiers take mdev_list_sem */
+	rockchip_system_monitor_update_budget(budget);
+
 	rockchip_system_monitor_temp_cpu_on_off(temp);
 
 out:
@@ -1875,6 +2033,9 @@ static int rockchip_system_monitor_probe(struct platform_device *pdev)
 		return -ENOMEM;
 	if (sysfs_create_file(system_monitor->kobj, &status.attr))
 		dev_err(dev, "failed to create system status sysfs\n");
+	system_monitor->cpu_budget = 100;
+	if (sysfs_create_file(system_monitor->kobj, &cpu_budget.attr))
+		dev_err(dev, "failed to create cpu budget sysfs\n");
 
 	cpumask_clear(&system_monitor->status_offline_cpus);
 	cpumask_clear(&system_monitor->offline_cpus);
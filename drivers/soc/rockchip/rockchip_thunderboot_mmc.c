@@ -2,12 +2,15 @@
 /*
  * Copyright (C) 2020 Rockchip Electronics Co., Ltd.
  */
+#include <linux/blkdev.h>
 #include <linux/clk.h>
+#include <linux/delay.h>
 #include <linux/iopoll.h>
 #include <linux/kernel.h>
 #include <linux/kthread.h>
 #include <linux/mm.h>
 #include <linux/module.h>
+#include <linux/mount.h>
 #include <linux/of.h>
 #include <linux/of_address.h>
 #include <linux/of_device.h>
@@ -20,6 +23,91 @@
 #define SDMMC_IDSTS		0x08c
 #define SDMMC_INTR_ERROR	0xB7C2
 
+/* pages per readahead request */
+#define TB_RA_CHUNK_PAGES	256
+/* how long to wait for the readahead device to show up */
+#define TB_RA_WAIT_MS		10000
+/* keep the device open so its page cache outlives us until it is mounted */
+#define TB_RA_HOLD_MS		30000
+
+/*
+ * Prefetch "rockchip,readahead-ranges" (pairs of 512-byte sector start
+ * and count) of the "rockchip,readahead-dev" block device, a name as
+ * for root=, into its page cache. Filesystems reading through the block
+ * device cache (squashfs, erofs, ext4 metadata) then find the player
+ * and its libraries there on first launch.
+ */
+static void rk_tb_mmc_readahead(struct device *dev)
+{
+	struct device_node *np = dev->of_node;
+	struct block_device *bdev;
+	struct address_space *mapping;
+	const char *name;
+	unsigned long waited = 0;
+	int i, count;
+	dev_t devt;
+
+	if (of_property_read_string(np, "rockchip,readahead-dev", &name))
+		return;
+
+	count = of_property_count_u32_elems(np, "rockchip,readahead-ranges");
+	if (count < 2 || count % 2) {
+		dev_err(dev, "invalid rockchip,readahead-ranges\n");
+		return;
+	}
+
+	while (!(devt = name_to_dev_t(name))) {
+		if (waited >= TB_RA_WAIT_MS) {
+			dev_err(dev, "readahead device %s not found\n", name);
+			return;
+		}
+		msleep(10);
+		waited += 10;
+	}
+
+	bdev = blkdev_get_by_dev(devt, FMODE_READ, NULL);
+	if (IS_ERR(bdev)) {
+		dev_err(dev, "failed to open %s: %ld\n", name, PTR_ERR(bdev));
+		return;
+	}
+	mapping = bdev->bd_inode->i_mapping;
+
+	for (i = 0; i < count; i += 2) {
+		struct file_ra_state ra = { };
+		pgoff_t index, end;
+		u32 start, len;
+
+		of_property_read_u32_index(np, "rockchip,readahead-ranges",
+					   i, &start);
+		of_property_read_u32_index(np, "rockchip,readahead-ranges",
+					   i + 1, &len);
+
+		index = ((u64)start << SECTOR_SHIFT) >> PAGE_SHIFT;
+		end = DIV_ROUND_UP((u64)(start + len) << SECTOR_SHIFT,
+				   PAGE_SIZE);
+		end = min_t(pgoff_t, end,
+			    DIV_ROUND_UP(i_size_read(bdev->bd_inode), PAGE_SIZE));
+
+		file_ra_state_init(&ra, mapping);
+		ra.ra_pages = TB_RA_CHUNK_PAGES;
+		while (index < end) {
+			unsigned long nr = min_t(pgoff_t, end - index,
+						 TB_RA_CHUNK_PAGES);
+
+			page_cache_sync_readahead(mapping, &ra, NULL, index, nr);
+			index += nr;
+			cond_resched();
+		}
+	}
+
+	dev_info(dev, "readahead of %d ranges of %s queued after %lu ms\n",
+		 count / 2, name, waited);
+
+	/* the last close would drop the page cache we just filled */
+	msleep(TB_RA_HOLD_MS);
+	blkdev_put(bdev, FMODE_READ);
+}
+
 static int rk_tb_mmc_thread(void *p)
 {
 	int ret = 0;
@@ -117,6 +205,8 @@ static int rk_tb_mmc_thread(void *p)
 	of_node_put(dma);
 	iounmap(regs);
 
+	rk_tb_mmc_readahead(dev);
+
 	return 0;
 }
 
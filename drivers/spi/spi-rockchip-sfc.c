@@ -22,6 +22,7 @@
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
 #include <linux/slab.h>
+#include <linux/soc/rockchip/rk_vendor_storage.h>
 #include <linux/spi/spi-mem.h>
 #include <linux/of_gpio.h>
 
@@ -162,6 +163,8 @@
 
 #define SFC_MAX_IOSIZE_VER3		(512 * 31)
 #define SFC_MAX_IOSIZE_VER4		(0x10000U) /* Although up to 4GB, 64KB is enough with less mem reserved */
+/* dirmap reads DMA'd straight to the caller need no bounce buffer */
+#define SFC_MAX_DIRECT_IOSIZE_VER4	(0x100000U)
 
 /* DMA is only enabled for large data transmission */
 #define SFC_DMA_TRANS_THRETHOLD		(0x40)
@@ -177,6 +180,17 @@
 
 #define ROCKCHIP_AUTOSUSPEND_DELAY	2000
 
+/* Tuned delay lines kept in vendor storage across boots */
+#define SFC_DLL_RECORD_MAGIC		0x444c4c53	/* "SDLL" */
+#define SFC_DLL_SAVE_RETRY_MS		1000
+#define SFC_DLL_SAVE_RETRIES		30
+
+struct rockchip_sfc_dll_record {
+	__le32 magic;
+	__le32 rate[SFC_MAX_CHIPSELECT_NUM];
+	__le16 cells[SFC_MAX_CHIPSELECT_NUM];
+};
+
 struct rockchip_sfc {
 	struct device *dev;
 	void __iomem *regbase;
@@ -192,6 +206,10 @@ struct rockchip_sfc {
 	bool use_dma;
 	u32 max_iosize;
 	u32 dll_cells[SFC_MAX_CHIPSELECT_NUM];
+	/* result of an earlier tuning, from the loader or vendor storage */
+	u32 dll_hint[SFC_MAX_CHIPSELECT_NUM];
+	struct delayed_work dll_save_work;
+	int dll_save_retries;
 	u16 version;
 	struct gpio_desc **cs_gpiods;
 	struct spi_master *master;
@@ -506,6 +524,45 @@ static int rockchip_sfc_xfer_data_poll(struct rockchip_sfc *sfc,
 		return rockchip_sfc_read_fifo(sfc, op->data.buf.in, len);
 }
 
+/* Caller buffers the DMA can reach without bouncing through sfc->buffer */
+static bool rockchip_sfc_dma_direct(const void *buf, u32 len)
+{
+	return !is_vmalloc_addr(buf) && virt_addr_valid(buf) &&
+	       virt_addr_valid(buf + len - 1) &&
+	       IS_ALIGNED((unsigned long)buf | len, dma_get_cache_alignment());
+}
+
+static int rockchip_sfc_xfer_data_dma_direct(struct rockchip_sfc *sfc,
+					     const struct spi_mem_op *op, u32 len)
+{
+	enum dma_data_direction dir;
+	dma_addr_t dma;
+	void *buf;
+	int ret;
+
+	if (op->data.dir == SPI_MEM_DATA_OUT) {
+		buf = (void *)op->data.buf.out;
+		dir = DMA_TO_DEVICE;
+	} else {
+		buf = op->data.buf.in;
+		dir = DMA_FROM_DEVICE;
+	}
+
+	dma = dma_map_single(sfc->dev, buf, len, dir);
+	if (dma_mapping_error(sfc->dev, dma))
+		return -ENOMEM;
+
+	ret = rockchip_sfc_fifo_transfer_dma(sfc, dma, len);
+	if (!wait_for_completion_timeout(&sfc->cp, msecs_to_jiffies(2000))) {
+		dev_err(sfc->dev, "DMA wait for transfer finish timeout\n");
+		ret = -ETIMEDOUT;
+	}
+	rockchip_sfc_irq_mask(sfc, SFC_IMR_DMA);
+	dma_unmap_single(sfc->dev, dma, len, dir);
+
+	return ret;
+}
+
 static int rockchip_sfc_xfer_data_dma(struct rockchip_sfc *sfc,
 				      const struct spi_mem_op *op, u32 len)
 {
@@ -518,6 +575,13 @@ static int rockchip_sfc_xfer_data_dma(struct rockchip_sfc *sfc,
 
 	dev_dbg(sfc->dev, "sfc xfer_dma len=%x\n", len);
 
+	if (rockchip_sfc_dma_direct(op->data.buf.in, len)) {
+		ret = rockchip_sfc_xfer_data_dma_direct(sfc, op, len);
+		/* longer than the bounce buffer, see rockchip_sfc_dirmap_read() */
+		if (ret != -ENOMEM || len > sfc->max_iosize)
+			return ret;
+	}
+
 	if (op->data.dir == SPI_MEM_DATA_OUT) {
 		memcpy(sfc->buffer, op->data.buf.out, len);
 		dma_sync_single_for_device(sfc->dev, sfc->dma_buffer, len, DMA_TO_DEVICE);
@@ -617,6 +681,60 @@ static int rockchip_sfc_exec_op_bypass(struct rockchip_sfc *sfc,
 	return ret;
 }
 
+static void rockchip_sfc_dll_save_work(struct work_struct *work)
+{
+	struct rockchip_sfc *sfc = container_of(to_delayed_work(work),
+						struct rockchip_sfc, dll_save_work);
+	struct rockchip_sfc_dll_record rec = { 0 }, old;
+	int i;
+
+	if (!is_rk_vendor_ready()) {
+		if (sfc->dll_save_retries-- > 0)
+			schedule_delayed_work(&sfc->dll_save_work,
+					      msecs_to_jiffies(SFC_DLL_SAVE_RETRY_MS));
+		return;
+	}
+
+	rec.magic = cpu_to_le32(SFC_DLL_RECORD_MAGIC);
+	for (i = 0; i < SFC_MAX_CHIPSELECT_NUM; i++) {
+		rec.rate[i] = cpu_to_le32(sfc->dll_cells[i] ? sfc->speed[i] : 0);
+		rec.cells[i] = cpu_to_le16(sfc->dll_cells[i]);
+	}
+
+	if (rk_vendor_read(SFC_DLL_ID, &old, sizeof(old)) == sizeof(old) &&
+	    !memcmp(&old, &rec, sizeof(rec)))
+		return;
+
+	if (rk_vendor_write(SFC_DLL_ID, &rec, sizeof(rec)))
+		dev_warn(sfc->dev, "failed to save dll cells\n");
+}
+
+/*
+ * Vendor storage normally lives on a flash behind this controller and is
+ * only written from a work item: the write would come back through the
+ * spi-mem path we are called from.
+ */
+static void rockchip_sfc_dll_save(struct rockchip_sfc *sfc)
+{
+	sfc->dll_save_retries = SFC_DLL_SAVE_RETRIES;
+	mod_delayed_work(system_wq, &sfc->dll_save_work, 0);
+}
+
+static u16 rockchip_sfc_dll_hint(struct rockchip_sfc *sfc, u8 cs)
+{
+	struct rockchip_sfc_dll_record rec;
+
+	if (sfc->dll_hint[cs])
+		return sfc->dll_hint[cs];
+
+	if (rk_vendor_read(SFC_DLL_ID, &rec, sizeof(rec)) != sizeof(rec) ||
+	    le32_to_cpu(rec.magic) != SFC_DLL_RECORD_MAGIC ||
+	    le32_to_cpu(rec.rate[cs]) != sfc->speed[cs])
+		return 0;
+
+	return le16_to_cpu(rec.cells[cs]);
+}
+
 static void rockchip_sfc_delay_lines_tuning(struct rockchip_sfc *sfc, struct spi_mem *mem)
 {
 	struct spi_mem_op op = SPI_MEM_OP(SPI_MEM_OP_CMD(0x9F, 1),
@@ -644,6 +762,22 @@ static void rockchip_sfc_delay_lines_tuning(struct rockchip_sfc *sfc, struct spi
 
 	rockchip_sfc_clk_set_rate(sfc, sfc->speed[cs]);
 	op.data.buf.in = &id_temp;
+
+	/* one read at the known good setting instead of a full sweep */
+	right = rockchip_sfc_dll_hint(sfc, cs);
+	sfc->dll_hint[cs] = 0;
+	if (right && right <= cell_max) {
+		rockchip_sfc_set_delay_lines(sfc, right, cs);
+		rockchip_sfc_exec_op_bypass(sfc, mem, &op);
+		if (!memcmp(&id, &id_temp, 3)) {
+			sfc->dll_cells[cs] = right;
+			dev_dbg(sfc->dev, "dll cells %u reused in %dMHz\n",
+				right, sfc->speed[cs]);
+			rockchip_sfc_dll_save(sfc);
+			return;
+		}
+	}
+
 	for (right = 0; right <= cell_max; right += step) {
 		int ret;
 
@@ -685,6 +819,7 @@ static void rockchip_sfc_delay_lines_tuning(struct rockchip_sfc *sfc, struct spi
 			left, right, sfc->dll_cells[cs], sfc->speed[cs],
 			rockchip_sfc_get_max_dll_cells(sfc), rockchip_sfc_get_version(sfc));
 		rockchip_sfc_set_delay_lines(sfc, (u16)sfc->dll_cells[cs], cs);
+		rockchip_sfc_dll_save(sfc);
 	} else {
 		dev_err(sfc->dev, "%d %d dll training failed in %dMHz, reduce the frequency\n",
 			left, right, sfc->speed[cs]);
@@ -697,6 +832,34 @@ static void rockchip_sfc_delay_lines_tuning(struct rockchip_sfc *sfc, struct spi
 	}
 }
 
+static int rockchip_sfc_set_speed(struct rockchip_sfc *sfc, struct spi_mem *mem)
+{
+	u8 cs = mem->spi->chip_select;
+	int ret;
+
+	if (likely(mem->spi->max_speed_hz == sfc->speed[cs]) ||
+	    has_acpi_companion(sfc->dev))
+		return 0;
+
+	ret = rockchip_sfc_clk_set_rate(sfc, mem->spi->max_speed_hz);
+	if (ret)
+		return ret;
+	sfc->speed[cs] = mem->spi->max_speed_hz;
+	sfc->cur_speed = mem->spi->max_speed_hz;
+	sfc->cur_real_speed = rockchip_sfc_clk_get_rate(sfc);
+	if (rockchip_sfc_get_version(sfc) >= SFC_VER_4) {
+		if (sfc->cur_real_speed > SFC_DLL_THRESHOLD_RATE)
+			rockchip_sfc_delay_lines_tuning(sfc, mem);
+		else
+			rockchip_sfc_set_delay_lines(sfc, 0, cs);
+	}
+
+	dev_dbg(sfc->dev, "set_freq=%dHz real_freq=%ldHz\n",
+		sfc->speed[cs], rockchip_sfc_clk_get_rate(sfc));
+
+	return 0;
+}
+
 static int rockchip_sfc_exec_mem_op(struct spi_mem *mem, const struct spi_mem_op *op)
 {
 	struct rockchip_sfc *sfc = spi_master_get_devdata(mem->spi->master);
@@ -710,24 +873,9 @@ static int rockchip_sfc_exec_mem_op(struct spi_mem *mem, const struct spi_mem_op
 		return ret;
 	}
 
-	if (unlikely(mem->spi->max_speed_hz != sfc->speed[cs]) &&
-	    !has_acpi_companion(sfc->dev)) {
-		ret = rockchip_sfc_clk_set_rate(sfc, mem->spi->max_speed_hz);
-		if (ret)
-			goto out;
-		sfc->speed[cs] = mem->spi->max_speed_hz;
-		sfc->cur_speed = mem->spi->max_speed_hz;
-		sfc->cur_real_speed = rockchip_sfc_clk_get_rate(sfc);
-		if (rockchip_sfc_get_version(sfc) >= SFC_VER_4) {
-			if (sfc->cur_real_speed > SFC_DLL_THRESHOLD_RATE)
-				rockchip_sfc_delay_lines_tuning(sfc, mem);
-			else
-				rockchip_sfc_set_delay_lines(sfc, 0, cs);
-		}
-
-		dev_dbg(sfc->dev, "set_freq=%dHz real_freq=%ldHz\n",
-			sfc->speed[cs], rockchip_sfc_clk_get_rate(sfc));
-	}
+	ret = rockchip_sfc_set_speed(sfc, mem);
+	if (ret)
+		goto out;
 
 	rockchip_sfc_adjust_op_work((struct spi_mem_op *)op);
 	rockchip_sfc_set_cs_gpio(sfc, cs, true);
@@ -767,9 +915,135 @@ static int rockchip_sfc_adjust_op_size(struct spi_mem *mem, struct spi_mem_op *o
 	return 0;
 }
 
+static void rockchip_sfc_dma_start(struct rockchip_sfc *sfc, struct spi_mem *mem,
+				   const struct spi_mem_op *op, u32 half, u32 len)
+{
+	rockchip_sfc_set_cs_gpio(sfc, mem->spi->chip_select, true);
+	rockchip_sfc_xfer_setup(sfc, mem, op, len);
+	init_completion(&sfc->cp);
+	rockchip_sfc_irq_unmask(sfc, SFC_IMR_DMA);
+	rockchip_sfc_fifo_transfer_dma(sfc, sfc->dma_buffer + half * sfc->max_iosize / 2, len);
+}
+
+static int rockchip_sfc_dma_wait(struct rockchip_sfc *sfc, struct spi_mem *mem)
+{
+	int ret = 0;
+
+	if (!wait_for_completion_timeout(&sfc->cp, msecs_to_jiffies(2000))) {
+		dev_err(sfc->dev, "DMA wait for transfer finish timeout\n");
+		ret = -ETIMEDOUT;
+	}
+	rockchip_sfc_irq_mask(sfc, SFC_IMR_DMA);
+	if (!ret)
+		ret = rockchip_sfc_xfer_done(sfc, 100000);
+	rockchip_sfc_set_cs_gpio(sfc, mem->spi->chip_select, false);
+
+	return ret;
+}
+
+/*
+ * Linear read longer than one transfer: the halves of the DMA buffer take
+ * turns, the previous half is copied out while the next one fills.
+ */
+static ssize_t rockchip_sfc_read_pingpong(struct rockchip_sfc *sfc, struct spi_mem *mem,
+					  struct spi_mem_op *op, size_t len)
+{
+	u32 chunk = sfc->max_iosize / 2;
+	u8 *buf = op->data.buf.in;
+	size_t done = 0;
+	u32 cur, half = 0;
+	int ret;
+
+	ret = pm_runtime_get_sync(sfc->dev);
+	if (ret < 0) {
+		pm_runtime_put_noidle(sfc->dev);
+		return ret;
+	}
+
+	ret = rockchip_sfc_set_speed(sfc, mem);
+	if (ret)
+		goto out;
+
+	cur = min_t(size_t, len, chunk);
+	rockchip_sfc_dma_start(sfc, mem, op, half, cur);
+	while (done < len) {
+		u32 next;
+
+		ret = rockchip_sfc_dma_wait(sfc, mem);
+		if (ret)
+			goto out;
+
+		next = min_t(size_t, len - done - cur, chunk);
+		if (next) {
+			op->addr.val += cur;
+			rockchip_sfc_dma_start(sfc, mem, op, !half, next);
+		}
+
+		dma_sync_single_for_cpu(sfc->dev, sfc->dma_buffer + half * chunk,
+					cur, DMA_FROM_DEVICE);
+		memcpy(buf + done, sfc->buffer + half * chunk, cur);
+		done += cur;
+		cur = next;
+		half = !half;
+	}
+
+out:
+	pm_runtime_mark_last_busy(sfc->dev);
+	pm_runtime_put_autosuspend(sfc->dev);
+
+	return done ? done : ret;
+}
+
+static int rockchip_sfc_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	struct rockchip_sfc *sfc = spi_master_get_devdata(desc->mem->spi->master);
+
+	if (desc->info.op_tmpl.data.dir != SPI_MEM_DATA_IN || !sfc->use_dma)
+		return -EOPNOTSUPP;
+
+	return 0;
+}
+
+/*
+ * SPI-NAND cache reads (2 byte column address) always go out as a single
+ * command of up to max_iosize, so a device in continuous read mode keeps
+ * streaming the following pages. Flash addressed linearly is read with
+ * back to back commands through the ping-pong buffer, unless the DMA can
+ * write the caller's buffer directly. Then, from SFC v4 on, where the
+ * length register has 32 bits, one command streams up to 1MB without
+ * the per command overhead.
+ */
+static ssize_t rockchip_sfc_dirmap_read(struct spi_mem_dirmap_desc *desc,
+					u64 offs, size_t len, void *buf)
+{
+	struct rockchip_sfc *sfc = spi_master_get_devdata(desc->mem->spi->master);
+	struct spi_mem_op op = desc->info.op_tmpl;
+	int ret;
+
+	op.addr.val = desc->info.offset + offs;
+	op.data.buf.in = buf;
+	rockchip_sfc_adjust_op_work(&op);
+
+	if (op.addr.nbytes >= 3 && len > sfc->max_iosize && !(len & 0x3) &&
+	    !rockchip_sfc_dma_direct(buf, sfc->max_iosize))
+		return rockchip_sfc_read_pingpong(sfc, desc->mem, &op, len);
+
+	if (op.addr.nbytes >= 3 && sfc->version >= SFC_VER_4 &&
+	    len > sfc->max_iosize && !(len & 0x3) &&
+	    rockchip_sfc_dma_direct(buf, min_t(size_t, len, SFC_MAX_DIRECT_IOSIZE_VER4)))
+		op.data.nbytes = min_t(size_t, len, SFC_MAX_DIRECT_IOSIZE_VER4);
+	else
+		op.data.nbytes = min_t(size_t, len, sfc->max_iosize);
+	ret = rockchip_sfc_exec_mem_op(desc->mem, &op);
+
+	return ret ? ret : op.data.nbytes;
+}
+
 static const struct spi_controller_mem_ops rockchip_sfc_mem_ops = {
 	.exec_op = rockchip_sfc_exec_mem_op,
 	.adjust_op_size = rockchip_sfc_adjust_op_size,
+	.dirmap_create = rockchip_sfc_dirmap_create,
+	.dirmap_read = rockchip_sfc_dirmap_read,
 };
 
 static irqreturn_t rockchip_sfc_irq_handler(int irq, void *dev_id)
@@ -894,6 +1168,11 @@ static int rockchip_sfc_probe(struct platform_device *pdev)
 	sfc->use_dma = !of_property_read_bool(sfc->dev->of_node,
 					      "rockchip,sfc-no-dma");
 
+	/* delay lines the loader tuned at the same rate, checked before use */
+	of_property_read_variable_u32_array(sfc->dev->of_node, "rockchip,sfc-dll-cells",
+					    sfc->dll_hint, 1, SFC_MAX_CHIPSELECT_NUM);
+	INIT_DELAYED_WORK(&sfc->dll_save_work, rockchip_sfc_dll_save_work);
+
 	ret = rockchip_sfc_get_gpio_descs(master, sfc);
 	if (ret) {
 		dev_err(&pdev->dev, "Failed to get gpio_descs\n");
@@ -988,6 +1267,7 @@ static int rockchip_sfc_remove(struct platform_device *pdev)
 	struct rockchip_sfc *sfc = platform_get_drvdata(pdev);
 	struct spi_master *master = sfc->master;
 
+	cancel_delayed_work_sync(&sfc->dll_save_work);
 	free_pages((unsigned long)sfc->buffer, get_order(sfc->max_iosize));
 	spi_unregister_master(master);
 
@@ -273,6 +273,14 @@ struct rockchip_thermal_data {
 #define TSADCV7_AUTO_PERIOD_HT_TIME		3000 /* 2.5ms */
 #define TSADCV12_AUTO_PERIOD_TIME		3000 /* 2.5ms */
 #define TSADCV12_AUTO_PERIOD_HT_TIME		3000 /* 2.5ms */
+/*
+ * RV1106: sample slowly below the alarm threshold and 5x faster above it,
+ * and only raise the alarm after 8 samples in a row crossed it, so a long
+ * thermal polling interval can rely on the interrupt alone.
+ */
+#define TSADCV9_AUTO_PERIOD_TIME		TSADCV2_AUTO_PERIOD_TIME
+#define TSADCV9_AUTO_PERIOD_HT_TIME		TSADCV2_AUTO_PERIOD_HT_TIME
+#define TSADCV9_HIGHT_INT_DEBOUNCE_COUNT	8
 #define TSADCV3_Q_MAX_VAL			0x7ff /* 11bit 2047 */
 #define TSADCV12_Q_MAX_VAL			0xfff /* 12bit 4095 */
 
@@ -1119,10 +1127,10 @@ static void rk_tsadcv9_initialize(struct regmap *grf, void __iomem *regs,
 	regmap_write(grf, RV1106_VOGRF_TSADC_CON, RV1106_VOGRF_TSADC_ANA);
 	udelay(100);
 
-	writel_relaxed(TSADCV2_AUTO_PERIOD_TIME, regs + TSADCV3_AUTO_PERIOD);
-	writel_relaxed(TSADCV2_AUTO_PERIOD_TIME,
+	writel_relaxed(TSADCV9_AUTO_PERIOD_TIME, regs + TSADCV3_AUTO_PERIOD);
+	writel_relaxed(TSADCV9_AUTO_PERIOD_HT_TIME,
 		       regs + TSADCV3_AUTO_PERIOD_HT);
-	writel_relaxed(TSADCV2_HIGHT_INT_DEBOUNCE_COUNT,
+	writel_relaxed(TSADCV9_HIGHT_INT_DEBOUNCE_COUNT,
 		       regs + TSADCV3_HIGHT_INT_DEBOUNCE);
 	writel_relaxed(TSADCV2_HIGHT_TSHUT_DEBOUNCE_COUNT,
 		       regs + TSADCV3_HIGHT_TSHUT_DEBOUNCE);
@@ -16,6 +16,11 @@
 #define MAX_FIFO_SIZE		64
 #define UART_RFL_16550A		0x21
 #define DW_UART_DMASA		0x2a
+/*
+ * The cyclic RX buffer is drained once per period, not only on character
+ * timeout, so that a line that never goes idle cannot lap the reader.
+ */
+#define RX_DMA_PERIODS		4
 #endif
 
 static void __dma_tx_complete(void *param)
@@ -78,6 +83,18 @@ static void __dma_rx_complete(void *param)
 	dma->rx_index = cur_index;
 }
 
+static void __dma_rx_period(void *param)
+{
+	struct uart_8250_port	*p = param;
+	unsigned long		flags;
+
+	spin_lock_irqsave(&p->port.lock, flags);
+	__dma_rx_complete(p);
+	spin_unlock_irqrestore(&p->port.lock, flags);
+
+	tty_flip_buffer_push(&p->port.state->port);
+}
+
 #else
 
 static void __dma_rx_complete(void *param)
@@ -206,15 +223,16 @@ int serial8250_start_rx_dma(struct uart_8250_port *p)
 	struct dma_async_tx_descriptor	*desc;
 
 	desc = dmaengine_prep_dma_cyclic(dma->rxchan, dma->rx_addr,
-					 dma->rx_size, dma->rx_size,
+					 dma->rx_size,
+					 dma->rx_size / RX_DMA_PERIODS,
 					 DMA_DEV_TO_MEM, DMA_PREP_INTERRUPT |
 					 DMA_CTRL_ACK);
 	if (!desc)
 		return -EBUSY;
 
 	dma->rx_running = 1;
-	desc->callback = NULL;
-	desc->callback_param = NULL;
+	desc->callback = __dma_rx_period;
+	desc->callback_param = p;
 
 	dma->rx_cookie = dmaengine_submit(desc);
 	dma_async_issue_pending(dma->rxchan);
@@ -22,6 +22,7 @@
 #include <linux/workqueue.h>
 #include <linux/notifier.h>
 #include <linux/slab.h>
+#include <linux/sizes.h>
 #include <linux/acpi.h>
 #include <linux/clk.h>
 #include <linux/reset.h>
@@ -645,6 +646,10 @@ static int dw8250_probe(struct platform_device *pdev)
 	if (p->fifosize) {
 		data->data.dma.rxconf.src_maxburst = p->fifosize / 4;
 		data->data.dma.txconf.dst_maxburst = p->fifosize / 4;
+		/* high rate links want more than the default buffering */
+		if (!device_property_read_u32(dev, "rx-dma-size", &val))
+			data->data.dma.rx_size = clamp_t(u32, PAGE_ALIGN(val),
+							 PAGE_SIZE, SZ_64K);
 		up->dma = &data->data.dma;
 	}
 
@@ -258,6 +258,12 @@ enum dwc2_ep0_state {
  *                      specified.
  *                       0 - Address DMA
  *                       1 - Descriptor DMA in FS (default, if available)
+ * @host_isoc_ioc_interval: In descriptor DMA mode, number of isochronous URBs
+ *                      completed per interrupt. Only the final descriptor of
+ *                      every Nth URB, of the last URB queued and of a full
+ *                      list requests an interrupt, letting long chains run
+ *                      without the CPU.
+ *                       1 - Interrupt for every URB (default)
  * @speed:              Specifies the maximum speed of operation in host and
  *                      device mode. The actual speed depends on the speed of
  *                      the attached device and the value of phy_type.
@@ -419,6 +425,10 @@ enum dwc2_ep0_state {
  *			1 - Activate the external level detection
  * @g_dma:              Enables gadget dma usage (default: autodetect).
  * @g_dma_desc:         Enables gadget descriptor DMA (default: autodetect).
+ * @g_isoc_ioc_interval: In descriptor DMA mode, number of isochronous
+ *			descriptors completed per interrupt. Only every Nth
+ *			descriptor and the last one of the chain request an
+ *			interrupt (default: 1, every descriptor).
  * @g_rx_fifo_size:	The periodic rx fifo size for the device, in
  *			DWORDS from 16-32768 (default: 2048 if
  *			possible, otherwise autodetect).
@@ -501,6 +511,7 @@ struct dwc2_core_params {
 	bool host_dma;
 	bool dma_desc_enable;
 	bool dma_desc_fs_enable;
+	u8 host_isoc_ioc_interval;
 	bool host_support_fs_ls_low_power;
 	bool host_ls_low_power_phy_clk;
 	bool oc_disable;
@@ -513,6 +524,7 @@ struct dwc2_core_params {
 	/* Gadget parameters */
 	bool g_dma;
 	bool g_dma_desc;
+	u8 g_isoc_ioc_interval;
 	u32 g_rx_fifo_size;
 	u32 g_np_tx_fifo_size;
 	u32 g_tx_fifo_size[MAX_EPS_CHANNELS];
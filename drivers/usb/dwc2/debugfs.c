@@ -673,6 +673,7 @@ static int params_show(struct seq_file *seq, void *v)
 	print_param(seq, p, otg_cap);
 	print_param(seq, p, dma_desc_enable);
 	print_param(seq, p, dma_desc_fs_enable);
+	print_param(seq, p, host_isoc_ioc_interval);
 	print_param(seq, p, speed);
 	print_param(seq, p, enable_dynamic_fifo);
 	print_param(seq, p, en_multiple_tx_fifo);
@@ -706,6 +707,7 @@ static int params_show(struct seq_file *seq, void *v)
 	print_param(seq, p, host_dma);
 	print_param(seq, p, g_dma);
 	print_param(seq, p, g_dma_desc);
+	print_param(seq, p, g_isoc_ioc_interval);
 	print_param(seq, p, g_rx_fifo_size);
 	print_param(seq, p, g_np_tx_fifo_size);
 
@@ -907,7 +907,9 @@ static void dwc2_gadget_config_nonisoc_xfer_ddma(struct dwc2_hsotg_ep *hs_ep,
  * Fills next free descriptor with the data of the arrived usb request,
  * frame info, sets Last and IOC bits increments next_desc. If filled
  * descriptor is not the first one, removes L bit from the previous descriptor
- * status.
+ * status, and its IOC bit too unless it ends a g_isoc_ioc_interval batch.
+ * The completion handler gives back every descriptor found done, so one
+ * interrupt completes the whole batch.
  */
 static int dwc2_gadget_fill_isoc_desc(struct dwc2_hsotg_ep *hs_ep,
 				      dma_addr_t dma_buff, unsigned int len)
@@ -931,8 +933,13 @@ static int dwc2_gadget_fill_isoc_desc(struct dwc2_hsotg_ep *hs_ep,
 	}
 
 	/* Clear L bit of previous desc if more than one entries in the chain */
-	if (hs_ep->next_desc)
-		hs_ep->desc_list[index - 1].status &= ~DEV_DMA_L;
+	if (hs_ep->next_desc) {
+		u32 clear = DEV_DMA_L;
+
+		if (index % hsotg->params.g_isoc_ioc_interval)
+			clear |= DEV_DMA_IOC;
+		hs_ep->desc_list[index - 1].status &= ~clear;
+	}
 
 	dev_dbg(hsotg->dev, "%s: Filling ep %d, dir %s isoc desc # %d\n",
 		__func__, hs_ep->index, hs_ep->dir_in ? "in" : "out", index);
@@ -307,6 +307,8 @@ struct dwc2_hs_transfer_time {
  *                           speed.  Note that this is in "schedule slice" which
  *                           is tightly packed.
  * @ntd:                Actual number of transfer descriptors in a list
+ * @isoc_ioc_urbs:      Isochronous URBs activated since the last one whose
+ *                      final descriptor requested an interrupt
  * @dw_align_buf:       Used instead of original buffer if its physical address
  *                      is not dword-aligned
  * @dw_align_buf_dma:   DMA address for dw_align_buf
@@ -359,6 +361,7 @@ struct dwc2_qh {
 	struct dwc2_hs_transfer_time hs_transfers[DWC2_HS_SCHEDULE_UFRAMES];
 	u32 ls_start_schedule_slice;
 	u16 ntd;
+	u8 isoc_ioc_urbs;
 	u8 *dw_align_buf;
 	dma_addr_t dw_align_buf_dma;
 	struct list_head qtd_list;
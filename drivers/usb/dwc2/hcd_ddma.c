@@ -565,9 +565,18 @@ static void dwc2_fill_host_isoc_dma_desc(struct dwc2_hsotg *hsotg,
 	qtd->isoc_frame_index_last++;
 
 #ifdef ISOC_URB_GIVEBACK_ASAP
-	/* Set IOC for each descriptor corresponding to last frame of URB */
-	if (qtd->isoc_frame_index_last == qtd->urb->packet_count)
+	/*
+	 * Set IOC for the descriptor corresponding to last frame of every
+	 * host_isoc_ioc_interval URB. The completion scan gives back all the
+	 * URBs before it in one go. The last URB queued always gets one, so
+	 * that nothing is left waiting for an URB that may never come.
+	 */
+	if (qtd->isoc_frame_index_last == qtd->urb->packet_count &&
+	    (++qh->isoc_ioc_urbs >= hsotg->params.host_isoc_ioc_interval ||
+	     list_is_last(&qtd->qtd_list_entry, &qh->qtd_list))) {
 		dma_desc->status |= HOST_DMA_IOC;
+		qh->isoc_ioc_urbs = 0;
+	}
 #endif
 
 	dma_sync_single_for_device(hsotg->dev,
@@ -862,8 +871,10 @@ void dwc2_hcd_start_xfer_ddma(struct dwc2_hsotg *hsotg, struct dwc2_qh *qh)
 		dwc2_hc_start_transfer_ddma(hsotg, chan);
 		break;
 	case USB_ENDPOINT_XFER_ISOC:
-		if (!qh->ntd)
+		if (!qh->ntd) {
 			skip_frames = dwc2_recalc_initial_desc_idx(hsotg, qh);
+			qh->isoc_ioc_urbs = 0;
+		}
 		dwc2_init_isoc_dma_desc(hsotg, qh, skip_frames);
 
 		if (!chan->xfer_started) {
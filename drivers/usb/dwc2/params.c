@@ -91,7 +91,7 @@ static void dwc2_set_rk_params(struct dwc2_hsotg *hsotg)
 		GAHBCFG_HBSTLEN_SHIFT;
 	p->power_down = DWC2_POWER_DOWN_PARAM_NONE;
 	p->lpm = false;
-	p->g_dma_desc = false;
+	p->g_dma_desc = device_property_read_bool(hsotg->dev, "g-dma-desc");
 }
 
 static void dwc2_set_ltq_params(struct dwc2_hsotg *hsotg)
@@ -400,6 +400,7 @@ static void dwc2_set_default_params(struct dwc2_hsotg *hsotg)
 		p->host_dma = dma_capable;
 		p->dma_desc_enable = false;
 		p->dma_desc_fs_enable = false;
+		p->host_isoc_ioc_interval = 1;
 		p->host_support_fs_ls_low_power = false;
 		p->host_ls_low_power_phy_clk = false;
 		p->host_channels = hw->host_channels;
@@ -412,6 +413,7 @@ static void dwc2_set_default_params(struct dwc2_hsotg *hsotg)
 	    (hsotg->dr_mode == USB_DR_MODE_OTG)) {
 		p->g_dma = dma_capable;
 		p->g_dma_desc = hw->dma_desc_enable;
+		p->g_isoc_ioc_interval = 1;
 
 		/*
 		 * The values for g_rx_fifo_size (2048) and
@@ -438,6 +440,7 @@ static void dwc2_set_default_params(struct dwc2_hsotg *hsotg)
 static void dwc2_get_device_properties(struct dwc2_hsotg *hsotg)
 {
 	struct dwc2_core_params *p = &hsotg->params;
+	u32 val;
 	int num;
 
 	if ((hsotg->dr_mode == USB_DR_MODE_PERIPHERAL) ||
@@ -448,6 +451,10 @@ static void dwc2_get_device_properties(struct dwc2_hsotg *hsotg)
 		device_property_read_u32(hsotg->dev, "g-np-tx-fifo-size",
 					 &p->g_np_tx_fifo_size);
 
+		if (!device_property_read_u32(hsotg->dev,
+					      "g-isoc-ioc-interval", &val))
+			p->g_isoc_ioc_interval = min_t(u32, val, U8_MAX);
+
 		num = device_property_count_u32(hsotg->dev, "g-tx-fifo-size");
 		if (num > 0) {
 			num = min(num, 15);
@@ -460,6 +467,16 @@ static void dwc2_get_device_properties(struct dwc2_hsotg *hsotg)
 		}
 	}
 
+	if ((hsotg->dr_mode == USB_DR_MODE_HOST) ||
+	    (hsotg->dr_mode == USB_DR_MODE_OTG)) {
+		if (device_property_read_bool(hsotg->dev, "host-dma-desc"))
+			p->dma_desc_enable = true;
+
+		if (!device_property_read_u32(hsotg->dev,
+					      "host-isoc-ioc-interval", &val))
+			p->host_isoc_ioc_interval = min_t(u32, val, U8_MAX);
+	}
+
 	if (of_find_property(hsotg->dev->of_node, "disable-over-current", NULL))
 		p->oc_disable = true;
 }
@@ -694,6 +711,7 @@ static void dwc2_check_params(struct dwc2_hsotg *hsotg)
 		CHECK_BOOL(host_dma, dma_capable);
 		CHECK_BOOL(dma_desc_enable, p->host_dma);
 		CHECK_BOOL(dma_desc_fs_enable, p->dma_desc_enable);
+		CHECK_RANGE(host_isoc_ioc_interval, 1, 32, 1);
 		CHECK_BOOL(host_ls_low_power_phy_clk,
 			   p->phy_type == DWC2_PHY_TYPE_PARAM_FS);
 		CHECK_RANGE(host_channels,
@@ -714,6 +732,7 @@ static void dwc2_check_params(struct dwc2_hsotg *hsotg)
 	    (hsotg->dr_mode == USB_DR_MODE_OTG)) {
 		CHECK_BOOL(g_dma, dma_capable);
 		CHECK_BOOL(g_dma_desc, (p->g_dma && hw->dma_desc_enable));
+		CHECK_RANGE(g_isoc_ioc_interval, 1, 64, 1);
 		CHECK_RANGE(g_rx_fifo_size,
 			    16, hw->rx_fifo_size,
 			    hw->rx_fifo_size);
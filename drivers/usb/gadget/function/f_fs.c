@@ -223,6 +223,7 @@ struct ffs_io_data {
 	struct usb_request *req;
 	struct sg_table sgt;
 	bool use_sg;
+	bool zero_copy;
 
 	struct ffs_data *ffs;
 
@@ -802,6 +803,50 @@ static void *ffs_build_sg_list(struct sg_table *sgt, size_t sz)
 	return vaddr;
 }
 
+/*
+ * describe the pages of a bvec iterator with a scatterlist
+ * @sg_table	- pointer to a place to be filled with sg_table contents
+ * @iter	- bvec iterator, e.g. an io_uring registered buffer
+ * @size	- number of bytes to cover
+ *
+ * The pages are already pinned by whoever built the iterator, so the UDC can
+ * transfer straight into or out of them.
+ */
+static int ffs_build_sg_from_bvec(struct sg_table *sgt, struct iov_iter *iter,
+				  size_t sz)
+{
+	const struct bio_vec *bvec = iter->bvec;
+	size_t skip = iter->iov_offset;
+	struct scatterlist *sg;
+	unsigned int nents, i;
+	size_t left, part;
+	int ret;
+
+	for (nents = 0, left = sz; left && nents < iter->nr_segs; nents++) {
+		left -= min(left, bvec[nents].bv_len - skip);
+		skip = 0;
+	}
+	if (left)
+		return -EFAULT;
+
+	ret = sg_alloc_table(sgt, nents, GFP_KERNEL);
+	if (ret)
+		return ret;
+
+	skip = iter->iov_offset;
+	for_each_sg(sgt->sgl, sg, nents, i) {
+		unsigned int offset = bvec[i].bv_offset + skip;
+
+		part = min(sz, bvec[i].bv_len - skip);
+		sg_set_page(sg, nth_page(bvec[i].bv_page, offset >> PAGE_SHIFT),
+			    part, offset & ~PAGE_MASK);
+		sz -= part;
+		skip = 0;
+	}
+
+	return 0;
+}
+
 static inline void *ffs_alloc_buffer(struct ffs_io_data *io_data,
 	size_t data_len)
 {
@@ -813,6 +858,12 @@ static inline void *ffs_alloc_buffer(struct ffs_io_data *io_data,
 
 static inline void ffs_free_buffer(struct ffs_io_data *io_data)
 {
+	if (io_data->zero_copy) {
+		sg_free_table(&io_data->sgt);
+		io_data->zero_copy = false;
+		return;
+	}
+
 	if (!io_data->buf)
 		return;
 
@@ -832,7 +883,7 @@ static void ffs_user_copy_worker(struct work_struct *work)
 					 io_data->req->actual;
 	bool kiocb_has_eventfd = io_data->kiocb->ki_flags & IOCB_EVENTFD;
 
-	if (io_data->read && ret > 0) {
+	if (io_data->read && ret > 0 && !io_data->zero_copy) {
 		kthread_use_mm(io_data->mm);
 		ret = ffs_copy_to_iter(io_data->buf, ret, &io_data->data);
 		kthread_unuse_mm(io_data->mm);
@@ -952,6 +1003,7 @@ static ssize_t ffs_epfile_io(struct file *file, struct ffs_io_data *io_data)
 	struct ffs_ep *ep;
 	char *data = NULL;
 	ssize_t ret, data_len = -EINVAL;
+	bool zero_copy;
 	int halt;
 
 	/* Are we still active? */
@@ -1019,17 +1071,33 @@ static ssize_t ffs_epfile_io(struct file *file, struct ffs_io_data *io_data)
 			data_len = usb_ep_align_maybe(gadget, ep->ep, data_len);
 
 		io_data->use_sg = gadget->sg_supported && data_len > PAGE_SIZE;
+		/*
+		 * Pinned pages (e.g. io_uring fixed buffers) can be handed to
+		 * the UDC as they are, unless a read needs a bigger buffer.
+		 */
+		zero_copy = io_data->aio && gadget->sg_supported &&
+			    iov_iter_is_bvec(&io_data->data) &&
+			    data_len == iov_iter_count(&io_data->data);
 		spin_unlock_irq(&epfile->ffs->eps_lock);
 
-		data = ffs_alloc_buffer(io_data, data_len);
-		if (unlikely(!data)) {
-			ret = -ENOMEM;
-			goto error_mutex;
-		}
-		if (!io_data->read &&
-		    !copy_from_iter_full(data, data_len, &io_data->data)) {
-			ret = -EFAULT;
-			goto error_mutex;
+		if (zero_copy) {
+			ret = ffs_build_sg_from_bvec(&io_data->sgt,
+						     &io_data->data, data_len);
+			if (unlikely(ret))
+				goto error_mutex;
+			io_data->use_sg = true;
+			io_data->zero_copy = true;
+		} else {
+			data = ffs_alloc_buffer(io_data, data_len);
+			if (unlikely(!data)) {
+				ret = -ENOMEM;
+				goto error_mutex;
+			}
+			if (!io_data->read &&
+			    !copy_from_iter_full(data, data_len, &io_data->data)) {
+				ret = -EFAULT;
+				goto error_mutex;
+			}
 		}
 	}
 
@@ -1215,7 +1283,11 @@ static ssize_t ffs_epfile_write_iter(struct kiocb *kiocb, struct iov_iter *from)
 
 	kiocb->private = p;
 
-	if (p->aio)
+	/*
+	 * Only libaio kiocbs take a cancel callback; bvec iterators come from
+	 * in-kernel submitters such as io_uring, never from io_submit(2).
+	 */
+	if (p->aio && !iov_iter_is_bvec(&p->data))
 		kiocb_set_cancel_fn(kiocb, ffs_aio_cancel);
 
 	res = ffs_epfile_io(kiocb->ki_filp, p);
@@ -1261,7 +1333,8 @@ static ssize_t ffs_epfile_read_iter(struct kiocb *kiocb, struct iov_iter *to)
 
 	kiocb->private = p;
 
-	if (p->aio)
+	/* See ffs_epfile_write_iter() */
+	if (p->aio && !iov_iter_is_bvec(&p->data))
 		kiocb_set_cancel_fn(kiocb, ffs_aio_cancel);
 
 	res = ffs_epfile_io(kiocb->ki_filp, p);
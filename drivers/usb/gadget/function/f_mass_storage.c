@@ -203,6 +203,7 @@
 #include <linux/dcache.h>
 #include <linux/delay.h>
 #include <linux/device.h>
+#include <linux/fadvise.h>
 #include <linux/fcntl.h>
 #include <linux/file.h>
 #include <linux/fs.h>
@@ -280,6 +281,7 @@ struct fsg_common {
 	struct fsg_buffhd	*next_buffhd_to_drain;
 	struct fsg_buffhd	*buffhds;
 	unsigned int		fsg_num_buffers;
+	u32			buflen;
 
 	int			cmnd_size;
 	u8			cmnd[MAX_COMMAND_SIZE];
@@ -658,6 +660,13 @@ static int do_read(struct fsg_common *common)
 	if (unlikely(amount_left == 0))
 		return -EIO;		/* No default reply */
 
+	/*
+	 * Have the whole transfer read ahead asynchronously, so that the
+	 * backing file keeps reading while earlier buffers go out on USB.
+	 */
+	vfs_fadvise(curlun->filp, file_offset, amount_left,
+		    POSIX_FADV_WILLNEED);
+
 	for (;;) {
 		/*
 		 * Figure out how much we need to read:
@@ -665,7 +674,7 @@ static int do_read(struct fsg_common *common)
 		 * But don't read more than the buffer size.
 		 * And don't try to read past the end of the file.
 		 */
-		amount = min(amount_left, FSG_BUFLEN);
+		amount = min(amount_left, common->buflen);
 		amount = min((loff_t)amount,
 			     curlun->file_length - file_offset);
 
@@ -812,7 +821,7 @@ static int do_write(struct fsg_common *common)
 			 * Try to get the remaining amount,
 			 * but not more than the buffer size.
 			 */
-			amount = min(amount_left_to_req, FSG_BUFLEN);
+			amount = min(amount_left_to_req, common->buflen);
 
 			/* Beyond the end of the backing file? */
 			if (usb_offset >= curlun->file_length) {
@@ -1012,7 +1021,7 @@ static int do_verify(struct fsg_common *common)
 		 * the buffer size.
 		 * And don't try to read past the end of the file.
 		 */
-		amount = min(amount_left, FSG_BUFLEN);
+		amount = min(amount_left, common->buflen);
 		amount = min((loff_t)amount,
 			     curlun->file_length - file_offset);
 		if (amount == 0) {
@@ -1505,7 +1514,7 @@ static int throw_away_data(struct fsg_common *common)
 		bh2 = common->next_buffhd_to_fill;
 		if (bh2->state == BUF_STATE_EMPTY &&
 				common->usb_amount_left > 0) {
-			amount = min(common->usb_amount_left, FSG_BUFLEN);
+			amount = min(common->usb_amount_left, common->buflen);
 
 			/*
 			 * Except at the end of the transfer, amount will be
@@ -2637,6 +2646,7 @@ static struct fsg_common *fsg_common_setup(struct fsg_common *common)
 	init_waitqueue_head(&common->io_wait);
 	init_waitqueue_head(&common->fsg_wait);
 	common->state = FSG_STATE_TERMINATED;
+	common->buflen = FSG_BUFLEN;
 	memset(common->luns, 0, sizeof(common->luns));
 
 	return common;
@@ -2677,7 +2687,7 @@ int fsg_common_set_num_buffers(struct fsg_common *common, unsigned int n)
 		bh->next = bh + 1;
 		++bh;
 buffhds_first_it:
-		bh->buf = kmalloc(FSG_BUFLEN, GFP_KERNEL);
+		bh->buf = kmalloc(common->buflen, GFP_KERNEL);
 		if (unlikely(!bh->buf))
 			goto error_release;
 	} while (--i);
@@ -3017,7 +3027,7 @@ static int fsg_bind(struct usb_configuration *c, struct usb_function *f)
 		fsg_fs_bulk_out_desc.bEndpointAddress;
 
 	/* Calculate bMaxBurst, we know packet size is 1024 */
-	max_burst = min_t(unsigned, FSG_BUFLEN / 1024, 15);
+	max_burst = min_t(unsigned, common->buflen / 1024, 15);
 
 	fsg_ss_bulk_in_desc.bEndpointAddress =
 		fsg_fs_bulk_in_desc.bEndpointAddress;
@@ -3370,11 +3380,64 @@ static ssize_t fsg_opts_num_buffers_store(struct config_item *item,
 CONFIGFS_ATTR(fsg_opts_, num_buffers);
 #endif
 
+static ssize_t fsg_opts_buflen_show(struct config_item *item, char *page)
+{
+	struct fsg_opts *opts = to_fsg_opts(item);
+	int result;
+
+	mutex_lock(&opts->lock);
+	result = sprintf(page, "%u", opts->common->buflen);
+	mutex_unlock(&opts->lock);
+
+	return result;
+}
+
+static ssize_t fsg_opts_buflen_store(struct config_item *item,
+				     const char *page, size_t len)
+{
+	struct fsg_opts *opts = to_fsg_opts(item);
+	struct fsg_common *common = opts->common;
+	u32 buflen, old;
+	int ret;
+
+	mutex_lock(&opts->lock);
+	if (opts->refcnt) {
+		ret = -EBUSY;
+		goto end;
+	}
+	ret = kstrtou32(page, 0, &buflen);
+	if (ret)
+		goto end;
+
+	/* whole pages, so that every request is a multiple of maxpacket */
+	if (buflen < PAGE_SIZE || buflen > FSG_MAX_BUFLEN ||
+	    !IS_ALIGNED(buflen, PAGE_SIZE)) {
+		ret = -EINVAL;
+		goto end;
+	}
+
+	old = common->buflen;
+	common->buflen = buflen;
+	ret = fsg_common_set_num_buffers(common, common->fsg_num_buffers);
+	if (ret) {
+		common->buflen = old;
+		goto end;
+	}
+	ret = len;
+
+end:
+	mutex_unlock(&opts->lock);
+	return ret;
+}
+
+CONFIGFS_ATTR(fsg_opts_, buflen);
+
 static struct configfs_attribute *fsg_attrs[] = {
 	&fsg_opts_attr_stall,
 #ifdef CONFIG_USB_GADGET_DEBUG_FILES
 	&fsg_opts_attr_num_buffers,
 #endif
+	&fsg_opts_attr_buflen,
 	NULL,
 };
 
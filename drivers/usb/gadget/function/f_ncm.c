@@ -74,6 +74,7 @@ struct f_ncm {
 	u16				ndp_dgram_count;
 	bool				timer_force_tx;
 	struct hrtimer			task_timer;
+	u32				tx_timeout_ns;
 	bool				timer_stopping;
 };
 
@@ -115,8 +116,13 @@ static inline unsigned ncm_bitrate(struct usb_gadget *g)
  */
 #define TX_MAX_NUM_DPE		32
 
-/* Delay for the transmit to wait before sending an unfilled NTB frame. */
+/* Delay for the transmit to wait before sending an unfilled NTB frame.
+ * It adapts between the two bounds: NTBs that fill up push it to the
+ * maximum so bulk traffic is sent in large transfers, while timeouts that
+ * find one lone datagram halve it so sparse traffic keeps a low latency.
+ */
 #define TX_TIMEOUT_NSECS	300000
+#define TX_TIMEOUT_MIN_NSECS	50000
 
 #define FORMATS_SUPPORTED	(USB_CDC_NCM_NTB16_SUPPORTED |	\
 				 USB_CDC_NCM_NTB32_SUPPORTED)
@@ -1056,6 +1062,7 @@ static struct sk_buff *ncm_wrap_ntb(struct gether *port,
 		    div + rem + skb->len +
 		    ncm->skb_tx_ndp->len + ndp_align + (2 * dgram_idx_len))
 		    > max_size)) {
+			ncm->tx_timeout_ns = TX_TIMEOUT_NSECS;
 			skb2 = package_for_tx(ncm);
 			if (!skb2)
 				goto err;
@@ -1103,7 +1110,7 @@ static struct sk_buff *ncm_wrap_ntb(struct gether *port,
 			/* Note: we skip opts->next_ndp_index */
 
 			/* Start the timer. */
-			hrtimer_start(&ncm->task_timer, TX_TIMEOUT_NSECS,
+			hrtimer_start(&ncm->task_timer, ncm->tx_timeout_ns,
 				      HRTIMER_MODE_REL_SOFT);
 		}
 
@@ -1128,6 +1135,12 @@ static struct sk_buff *ncm_wrap_ntb(struct gether *port,
 
 	} else if (ncm->skb_tx_data && ncm->timer_force_tx) {
 		/* If the tx was requested because of a timeout then send */
+		if (ncm->ndp_dgram_count <= 2)
+			ncm->tx_timeout_ns = max_t(u32, ncm->tx_timeout_ns / 2,
+						   TX_TIMEOUT_MIN_NSECS);
+		else
+			ncm->tx_timeout_ns = min_t(u32, ncm->tx_timeout_ns * 2,
+						   TX_TIMEOUT_NSECS);
 		skb2 = package_for_tx(ncm);
 		if (!skb2)
 			goto err;
@@ -1551,6 +1564,7 @@ static int ncm_bind(struct usb_configuration *c, struct usb_function *f)
 
 	hrtimer_init(&ncm->task_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_SOFT);
 	ncm->task_timer.function = ncm_tx_timeout;
+	ncm->tx_timeout_ns = TX_TIMEOUT_NSECS;
 
 	DBG(cdev, "CDC Network: %s speed IN/%s OUT/%s NOTIFY/%s\n",
 			gadget_is_superspeed(c->cdev->gadget) ? "super" :
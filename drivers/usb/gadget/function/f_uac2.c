@@ -15,6 +15,7 @@
 #include <linux/module.h>
 
 #include "u_audio.h"
+#include "u_audio_bridge.h"
 
 #include "u_uac2.h"
 
@@ -72,6 +73,9 @@ struct f_uac2 {
 	atomic_t	int_count;
 	/* transient state, only valid during handling of a single control request */
 	int clock_id;
+
+	/* in-kernel consumer of the OUT stream, when c_bridge is set */
+	struct uac_bridge bridge;
 };
 
 static inline struct f_uac2 *func_to_uac2(struct usb_function *f)
@@ -79,6 +83,17 @@ static inline struct f_uac2 *func_to_uac2(struct usb_function *f)
 	return container_of(f, struct f_uac2, g_audio.func);
 }
 
+static void afunc_bridge_sink(struct g_audio *agdev, const void *buf,
+			      unsigned int len)
+{
+	uac_bridge_write(&func_to_uac2(&agdev->func)->bridge, buf, len);
+}
+
+static int afunc_bridge_fill(struct g_audio *agdev)
+{
+	return uac_bridge_fill(&func_to_uac2(&agdev->func)->bridge);
+}
+
 static inline
 struct f_uac2_opts *g_audio_to_uac2_opts(struct g_audio *agdev)
 {
@@ -102,6 +117,7 @@ enum {
 	STR_FU_OUT,
 	STR_AS_OUT_ALT0,
 	STR_AS_OUT_ALT1,
+	STR_AS_OUT_ALT2,
 	STR_AS_IN_ALT0,
 	STR_AS_IN_ALT1,
 };
@@ -119,6 +135,7 @@ static struct usb_string strings_fn[] = {
 	[STR_FU_OUT].s = "Playback Volume",
 	[STR_AS_OUT_ALT0].s = "Playback Inactive",
 	[STR_AS_OUT_ALT1].s = "Playback Active",
+	[STR_AS_OUT_ALT2].s = "Playback Active DSD",
 	[STR_AS_IN_ALT0].s = "Capture Inactive",
 	[STR_AS_IN_ALT1].s = "Capture Active",
 	{ },
@@ -321,6 +338,18 @@ static struct usb_interface_descriptor std_as_out_if1_desc = {
 	.bInterfaceProtocol = UAC_VERSION_2,
 };
 
+/* Audio Streaming OUT Interface - Alt2, native DSD */
+static struct usb_interface_descriptor std_as_out_if2_desc = {
+	.bLength = sizeof std_as_out_if2_desc,
+	.bDescriptorType = USB_DT_INTERFACE,
+
+	.bAlternateSetting = 2,
+	.bNumEndpoints = 1,
+	.bInterfaceClass = USB_CLASS_AUDIO,
+	.bInterfaceSubClass = USB_SUBCLASS_AUDIOSTREAMING,
+	.bInterfaceProtocol = UAC_VERSION_2,
+};
+
 /* Audio Stream OUT Intface Desc */
 static struct uac2_as_header_descriptor as_out_hdr_desc = {
 	.bLength = sizeof as_out_hdr_desc,
@@ -342,6 +371,32 @@ static struct uac2_format_type_i_descriptor as_out_fmt1_desc = {
 	.bFormatType = UAC_FORMAT_TYPE_I,
 };
 
+/*
+ * Alt2 carries DSD as raw data in 32-bit subslots, the layout hosts use
+ * for native DSD playback, so the capture PCM can hand it on as
+ * SNDRV_PCM_FORMAT_DSD_U32_LE without repacking.
+ */
+static struct uac2_as_header_descriptor as_out_dsd_hdr_desc = {
+	.bLength = sizeof as_out_dsd_hdr_desc,
+	.bDescriptorType = USB_DT_CS_INTERFACE,
+
+	.bDescriptorSubtype = UAC_AS_GENERAL,
+	/* .bTerminalLink = DYNAMIC */
+	.bmControls = 0,
+	.bFormatType = UAC_FORMAT_TYPE_I,
+	.bmFormats = cpu_to_le32(UAC2_FORMAT_TYPE_I_RAW_DATA),
+	.iChannelNames = 0,
+};
+
+static struct uac2_format_type_i_descriptor as_out_dsd_fmt_desc = {
+	.bLength = sizeof as_out_dsd_fmt_desc,
+	.bDescriptorType = USB_DT_CS_INTERFACE,
+	.bDescriptorSubtype = UAC_FORMAT_TYPE,
+	.bFormatType = UAC_FORMAT_TYPE_I,
+	.bSubslotSize = 4,
+	.bBitResolution = 32,
+};
+
 /* STD AS ISO OUT Endpoint */
 static struct usb_endpoint_descriptor fs_epout_desc = {
 	.bLength = USB_DT_ENDPOINT_SIZE,
@@ -551,6 +606,13 @@ static struct usb_descriptor_header *fs_audio_desc[] = {
 	(struct usb_descriptor_header *)&as_iso_out_desc,
 	(struct usb_descriptor_header *)&fs_epin_fback_desc,
 
+	(struct usb_descriptor_header *)&std_as_out_if2_desc,
+	(struct usb_descriptor_header *)&as_out_dsd_hdr_desc,
+	(struct usb_descriptor_header *)&as_out_dsd_fmt_desc,
+	(struct usb_descriptor_header *)&fs_epout_desc,
+	(struct usb_descriptor_header *)&as_iso_out_desc,
+	(struct usb_descriptor_header *)&fs_epin_fback_desc,
+
 	(struct usb_descriptor_header *)&std_as_in_if0_desc,
 	(struct usb_descriptor_header *)&std_as_in_if1_desc,
 
@@ -586,6 +648,13 @@ static struct usb_descriptor_header *hs_audio_desc[] = {
 	(struct usb_descriptor_header *)&as_iso_out_desc,
 	(struct usb_descriptor_header *)&hs_epin_fback_desc,
 
+	(struct usb_descriptor_header *)&std_as_out_if2_desc,
+	(struct usb_descriptor_header *)&as_out_dsd_hdr_desc,
+	(struct usb_descriptor_header *)&as_out_dsd_fmt_desc,
+	(struct usb_descriptor_header *)&hs_epout_desc,
+	(struct usb_descriptor_header *)&as_iso_out_desc,
+	(struct usb_descriptor_header *)&hs_epin_fback_desc,
+
 	(struct usb_descriptor_header *)&std_as_in_if0_desc,
 	(struct usb_descriptor_header *)&std_as_in_if1_desc,
 
@@ -624,6 +693,15 @@ static struct usb_descriptor_header *ss_audio_desc[] = {
 	(struct usb_descriptor_header *)&ss_epin_fback_desc,
 	(struct usb_descriptor_header *)&ss_epin_fback_desc_comp,
 
+	(struct usb_descriptor_header *)&std_as_out_if2_desc,
+	(struct usb_descriptor_header *)&as_out_dsd_hdr_desc,
+	(struct usb_descriptor_header *)&as_out_dsd_fmt_desc,
+	(struct usb_descriptor_header *)&ss_epout_desc,
+	(struct usb_descriptor_header *)&ss_epout_desc_comp,
+	(struct usb_descriptor_header *)&as_iso_out_desc,
+	(struct usb_descriptor_header *)&ss_epin_fback_desc,
+	(struct usb_descriptor_header *)&ss_epin_fback_desc_comp,
+
 	(struct usb_descriptor_header *)&std_as_in_if0_desc,
 	(struct usb_descriptor_header *)&std_as_in_if1_desc,
 
@@ -717,7 +795,7 @@ static int set_ep_max_packet_size_bint(struct device *dev, const struct f_uac2_o
 	enum usb_device_speed speed, bool is_playback)
 {
 	u16 max_size_bw, max_size_ep;
-	u8 bint, opts_bint;
+	u8 bint, opts_bint, mult = 1;
 	char *dir;
 
 	switch (speed) {
@@ -760,10 +838,21 @@ static int set_ep_max_packet_size_bint(struct device *dev, const struct f_uac2_o
 	else
 		dir = "Capture";
 
+	/*
+	 * A HS isoc endpoint may move up to three transactions per
+	 * microframe, so split what does not fit into one instead of
+	 * dropping data.
+	 */
+	if (speed == USB_SPEED_HIGH && max_size_bw > max_size_ep &&
+	    max_size_bw <= 3 * max_size_ep) {
+		mult = DIV_ROUND_UP(max_size_bw, max_size_ep);
+		max_size_bw = DIV_ROUND_UP(max_size_bw, mult);
+	}
+
 	if (max_size_bw <= max_size_ep)
 		dev_dbg(dev,
-			"%s %s: Would use wMaxPacketSize %d and bInterval %d\n",
-			speed_names[speed], dir, max_size_bw, bint);
+			"%s %s: Would use wMaxPacketSize %d x %d and bInterval %d\n",
+			speed_names[speed], dir, max_size_bw, mult, bint);
 	else {
 		dev_warn(dev,
 			"%s %s: Req. wMaxPacketSize %d at bInterval %d > max ISOC %d, may drop data!\n",
@@ -771,7 +860,8 @@ static int set_ep_max_packet_size_bint(struct device *dev, const struct f_uac2_o
 		max_size_bw = max_size_ep;
 	}
 
-	ep_desc->wMaxPacketSize = cpu_to_le16(max_size_bw);
+	ep_desc->wMaxPacketSize = cpu_to_le16(max_size_bw |
+					      USB_EP_MAXP_MULT(mult - 1));
 	ep_desc->bInterval = bint;
 
 	return 0;
@@ -886,6 +976,23 @@ static void setup_headers(struct f_uac2_opts *opts,
 			if (epin_fback_desc_comp)
 				headers[i++] = USBDHDR(epin_fback_desc_comp);
 		}
+
+		if (opts->c_dsd) {
+			headers[i++] = USBDHDR(&std_as_out_if2_desc);
+			headers[i++] = USBDHDR(&as_out_dsd_hdr_desc);
+			headers[i++] = USBDHDR(&as_out_dsd_fmt_desc);
+			headers[i++] = USBDHDR(epout_desc);
+			if (epout_desc_comp)
+				headers[i++] = USBDHDR(epout_desc_comp);
+
+			headers[i++] = USBDHDR(&as_iso_out_desc);
+
+			if (EPOUT_FBACK_IN_EN(opts)) {
+				headers[i++] = USBDHDR(epin_fback_desc);
+				if (epin_fback_desc_comp)
+					headers[i++] = USBDHDR(epin_fback_desc_comp);
+			}
+		}
 	}
 
 	if (EPIN_EN(opts)) {
@@ -945,6 +1052,7 @@ static void setup_descriptor(struct f_uac2_opts *opts)
 	}
 
 	as_out_hdr_desc.bTerminalLink = usb_out_it_desc.bTerminalID;
+	as_out_dsd_hdr_desc.bTerminalLink = usb_out_it_desc.bTerminalID;
 	as_in_hdr_desc.bTerminalLink = usb_in_ot_desc.bTerminalID;
 
 	iad_desc.bInterfaceCount = 1;
@@ -997,6 +1105,8 @@ static int afunc_validate_opts(struct g_audio *agdev, struct device *dev)
 		msg = "incorrect playback sample size";
 	else if ((opts->c_ssize < 1) || (opts->c_ssize > 4))
 		msg = "incorrect capture sample size";
+	else if (opts->c_dsd && opts->c_ssize != 4)
+		msg = "capture DSD needs 4 byte sample size";
 	else if (!opts->p_srates[0])
 		msg = "incorrect playback sampling rate";
 	else if (!opts->c_srates[0])
@@ -1021,6 +1131,11 @@ static int afunc_validate_opts(struct g_audio *agdev, struct device *dev)
 	else if ((opts->c_hs_bint < 0) || (opts->c_hs_bint > 4))
 		msg = "incorrect capture HS/SS bInterval (1-4: fixed, 0: auto)";
 
+	else if (opts->req_batch < 1)
+		msg = "incorrect requests per interrupt";
+	else if (opts->req_number < 2 * opts->req_batch)
+		msg = "req_number must cover two interrupt batches";
+
 	if (msg) {
 		dev_err(dev, "Error: %s\n", msg);
 		return -EINVAL;
@@ -1074,6 +1189,7 @@ afunc_bind(struct usb_configuration *cfg, struct usb_function *fn)
 	io_out_ot_desc.iTerminal = us[STR_IO_OT].id;
 	std_as_out_if0_desc.iInterface = us[STR_AS_OUT_ALT0].id;
 	std_as_out_if1_desc.iInterface = us[STR_AS_OUT_ALT1].id;
+	std_as_out_if2_desc.iInterface = us[STR_AS_OUT_ALT2].id;
 	std_as_in_if0_desc.iInterface = us[STR_AS_IN_ALT0].id;
 	std_as_in_if1_desc.iInterface = us[STR_AS_IN_ALT1].id;
 
@@ -1096,6 +1212,8 @@ afunc_bind(struct usb_configuration *cfg, struct usb_function *fn)
 	io_in_it_desc.bmChannelConfig = cpu_to_le32(uac2_opts->p_chmask);
 	as_out_hdr_desc.bNrChannels = num_channels(uac2_opts->c_chmask);
 	as_out_hdr_desc.bmChannelConfig = cpu_to_le32(uac2_opts->c_chmask);
+	as_out_dsd_hdr_desc.bNrChannels = num_channels(uac2_opts->c_chmask);
+	as_out_dsd_hdr_desc.bmChannelConfig = cpu_to_le32(uac2_opts->c_chmask);
 	as_in_hdr_desc.bNrChannels = num_channels(uac2_opts->p_chmask);
 	as_in_hdr_desc.bmChannelConfig = cpu_to_le32(uac2_opts->p_chmask);
 	as_out_fmt1_desc.bSubslotSize = uac2_opts->c_ssize;
@@ -1142,6 +1260,7 @@ afunc_bind(struct usb_configuration *cfg, struct usb_function *fn)
 		}
 		std_as_out_if0_desc.bInterfaceNumber = ret;
 		std_as_out_if1_desc.bInterfaceNumber = ret;
+		std_as_out_if2_desc.bInterfaceNumber = ret;
 		uac2->as_out_intf = ret;
 		uac2->as_out_alt = 0;
 
@@ -1153,6 +1272,7 @@ afunc_bind(struct usb_configuration *cfg, struct usb_function *fn)
 			ss_epout_desc.bmAttributes =
 			  USB_ENDPOINT_XFER_ISOC | USB_ENDPOINT_SYNC_ASYNC;
 			std_as_out_if1_desc.bNumEndpoints++;
+			std_as_out_if2_desc.bNumEndpoints++;
 		} else {
 			fs_epout_desc.bmAttributes =
 			  USB_ENDPOINT_XFER_ISOC | USB_ENDPOINT_SYNC_ADAPTIVE;
@@ -1264,10 +1384,12 @@ afunc_bind(struct usb_configuration *cfg, struct usb_function *fn)
 
 	agdev->in_ep_maxpsize = max_t(u16,
 				le16_to_cpu(fs_epin_desc.wMaxPacketSize),
-				le16_to_cpu(hs_epin_desc.wMaxPacketSize));
+				usb_endpoint_maxp(&hs_epin_desc) *
+				usb_endpoint_maxp_mult(&hs_epin_desc));
 	agdev->out_ep_maxpsize = max_t(u16,
 				le16_to_cpu(fs_epout_desc.wMaxPacketSize),
-				le16_to_cpu(hs_epout_desc.wMaxPacketSize));
+				usb_endpoint_maxp(&hs_epout_desc) *
+				usb_endpoint_maxp_mult(&hs_epout_desc));
 
 	agdev->in_ep_maxpsize = max_t(u16, agdev->in_ep_maxpsize,
 				le16_to_cpu(ss_epin_desc.wMaxPacketSize));
@@ -1300,6 +1422,7 @@ afunc_bind(struct usb_configuration *cfg, struct usb_function *fn)
 	memcpy(agdev->params.p_srates, uac2_opts->p_srates,
 			sizeof(agdev->params.p_srates));
 	agdev->params.p_ssize = uac2_opts->p_ssize;
+	agdev->params.p_zero_copy = uac2_opts->p_zero_copy;
 	if (FUIN_EN(uac2_opts)) {
 		agdev->params.p_fu.id = USB_IN_FU_ID;
 		agdev->params.p_fu.mute_present = uac2_opts->p_mute_present;
@@ -1312,6 +1435,7 @@ afunc_bind(struct usb_configuration *cfg, struct usb_function *fn)
 	memcpy(agdev->params.c_srates, uac2_opts->c_srates,
 			sizeof(agdev->params.c_srates));
 	agdev->params.c_ssize = uac2_opts->c_ssize;
+	agdev->params.c_dsd = uac2_opts->c_dsd;
 	if (FUOUT_EN(uac2_opts)) {
 		agdev->params.c_fu.id = USB_OUT_FU_ID;
 		agdev->params.c_fu.mute_present = uac2_opts->c_mute_present;
@@ -1321,11 +1445,19 @@ afunc_bind(struct usb_configuration *cfg, struct usb_function *fn)
 		agdev->params.c_fu.volume_res = uac2_opts->c_volume_res;
 	}
 	agdev->params.req_number = uac2_opts->req_number;
+	agdev->params.req_batch = uac2_opts->req_batch;
 	agdev->params.fb_max = uac2_opts->fb_max;
+	agdev->params.fb_target_ms = uac2_opts->fb_target_ms;
 
 	if (FUOUT_EN(uac2_opts) || FUIN_EN(uac2_opts))
     agdev->notify = afunc_notify;
 
+	if (EPOUT_EN(uac2_opts) && uac2_opts->c_bridge[0]) {
+		uac_bridge_init(&uac2->bridge, agdev, uac2_opts->c_bridge);
+		agdev->c_sink = afunc_bridge_sink;
+		agdev->c_fill = afunc_bridge_fill;
+	}
+
 	ret = g_audio_setup(agdev, "UAC2 PCM", "UAC2_Gadget");
 	if (ret)
 		goto err_free_descs;
@@ -1423,8 +1555,9 @@ afunc_set_alt(struct usb_function *fn, unsigned intf, unsigned alt)
 	struct device *dev = &gadget->dev;
 	int ret = 0;
 
-	/* No i/f has more than 2 alt settings */
-	if (alt > 1) {
+	/* Only the OUT i/f has a third, DSD alt setting */
+	if (alt > 2 || (alt == 2 && (intf != uac2->as_out_intf ||
+				     !agdev->params.c_dsd))) {
 		dev_err(dev, "%s:%d Error!\n", __func__, __LINE__);
 		return -EINVAL;
 	}
@@ -1449,10 +1582,16 @@ afunc_set_alt(struct usb_function *fn, unsigned intf, unsigned alt)
 	if (intf == uac2->as_out_intf) {
 		uac2->as_out_alt = alt;
 
-		if (alt)
+		if (alt) {
+			agdev->c_dsd_active = alt == 2;
 			ret = u_audio_start_capture(&uac2->g_audio);
-		else
+			if (!ret && agdev->c_sink)
+				uac_bridge_start(&uac2->bridge);
+		} else {
+			if (agdev->c_sink)
+				uac_bridge_stop(&uac2->bridge);
 			u_audio_stop_capture(&uac2->g_audio);
+		}
 	} else if (intf == uac2->as_in_intf) {
 		uac2->as_in_alt = alt;
 
@@ -1495,6 +1634,8 @@ afunc_disable(struct usb_function *fn)
 
 	uac2->as_in_alt = 0;
 	uac2->as_out_alt = 0;
+	if (uac2->g_audio.c_sink)
+		uac_bridge_stop(&uac2->bridge);
 	u_audio_stop_capture(&uac2->g_audio);
 	u_audio_stop_playback(&uac2->g_audio);
 	if (uac2->int_ep)
@@ -2072,13 +2213,16 @@ CONFIGFS_ATTR(f_uac2_opts_, name)
 UAC2_ATTRIBUTE(u32, p_chmask);
 UAC2_RATE_ATTRIBUTE(p_srate);
 UAC2_ATTRIBUTE(u32, p_ssize);
+UAC2_ATTRIBUTE(bool, p_zero_copy);
 UAC2_ATTRIBUTE(u8, p_hs_bint);
 UAC2_ATTRIBUTE(u32, c_chmask);
 UAC2_RATE_ATTRIBUTE(c_srate);
 UAC2_ATTRIBUTE_SYNC(c_sync);
 UAC2_ATTRIBUTE(u32, c_ssize);
+UAC2_ATTRIBUTE(bool, c_dsd);
 UAC2_ATTRIBUTE(u8, c_hs_bint);
 UAC2_ATTRIBUTE(u32, req_number);
+UAC2_ATTRIBUTE(u32, req_batch);
 
 UAC2_ATTRIBUTE(bool, p_mute_present);
 UAC2_ATTRIBUTE(bool, p_volume_present);
@@ -2092,20 +2236,26 @@ UAC2_ATTRIBUTE(s16, c_volume_min);
 UAC2_ATTRIBUTE(s16, c_volume_max);
 UAC2_ATTRIBUTE(s16, c_volume_res);
 UAC2_ATTRIBUTE(u32, fb_max);
+UAC2_ATTRIBUTE(u32, fb_target_ms);
 UAC2_ATTRIBUTE_STRING(function_name);
+UAC2_ATTRIBUTE_STRING(c_bridge);
 
 static struct configfs_attribute *f_uac2_attrs[] = {
 	&f_uac2_opts_attr_p_chmask,
 	&f_uac2_opts_attr_p_srate,
 	&f_uac2_opts_attr_p_ssize,
+	&f_uac2_opts_attr_p_zero_copy,
 	&f_uac2_opts_attr_p_hs_bint,
 	&f_uac2_opts_attr_c_chmask,
 	&f_uac2_opts_attr_c_srate,
 	&f_uac2_opts_attr_c_ssize,
+	&f_uac2_opts_attr_c_dsd,
 	&f_uac2_opts_attr_c_hs_bint,
 	&f_uac2_opts_attr_c_sync,
 	&f_uac2_opts_attr_req_number,
+	&f_uac2_opts_attr_req_batch,
 	&f_uac2_opts_attr_fb_max,
+	&f_uac2_opts_attr_fb_target_ms,
 
 	&f_uac2_opts_attr_p_mute_present,
 	&f_uac2_opts_attr_p_volume_present,
@@ -2120,6 +2270,7 @@ static struct configfs_attribute *f_uac2_attrs[] = {
 	&f_uac2_opts_attr_c_volume_res,
 
 	&f_uac2_opts_attr_function_name,
+	&f_uac2_opts_attr_c_bridge,
 
 	NULL,
 };
@@ -2175,6 +2326,7 @@ static struct usb_function_instance *afunc_alloc_inst(void)
 	opts->c_volume_res = UAC2_DEF_RES_DB;
 
 	opts->req_number = UAC2_DEF_REQ_NUM;
+	opts->req_batch = UAC2_DEF_REQ_BATCH;
 	opts->fb_max = FBACK_FAST_MAX;
 
 	snprintf(opts->function_name, sizeof(opts->function_name), "Source/Sink");
@@ -2199,6 +2351,11 @@ static void afunc_unbind(struct usb_configuration *c, struct usb_function *f)
 {
 	struct g_audio *agdev = func_to_g_audio(f);
 
+	if (agdev->c_sink) {
+		uac_bridge_release(&func_to_uac2(f)->bridge);
+		agdev->c_sink = NULL;
+		agdev->c_fill = NULL;
+	}
 	g_audio_cleanup(agdev);
 	usb_free_all_descriptors(f);
 
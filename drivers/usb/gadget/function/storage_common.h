@@ -130,6 +130,9 @@ static inline bool fsg_lun_is_open(struct fsg_lun *curlun)
 /* Default size of buffer length. */
 #define FSG_BUFLEN	((u32)16384)
 
+/* Largest buffer length selectable through configfs. */
+#define FSG_MAX_BUFLEN	((u32)131072)
+
 /* Maximal number of LUNs supported in mass storage function */
 #define FSG_MAX_LUNS	16
 
@@ -14,11 +14,13 @@
 
 #include <linux/kernel.h>
 #include <linux/module.h>
+#include <linux/math64.h>
 #include <sound/core.h>
 #include <sound/pcm.h>
 #include <sound/pcm_params.h>
 #include <sound/control.h>
 #include <sound/tlv.h>
+#include <linux/scatterlist.h>
 #include <linux/usb/audio.h>
 
 #include "u_audio.h"
@@ -35,7 +37,19 @@ enum {
 	UAC_RATE_CTRL,
 };
 
-#define CLK_PPM_GROUP_SIZE	20
+/* ppm histogram: 10 ppm wide bins from -80 to +80, outliers at the ends */
+#define UAC_PPM_HIST_LIMIT	80
+#define UAC_PPM_HIST_STEP	10
+#define UAC_PPM_HIST_BINS	(2 * UAC_PPM_HIST_LIMIT / UAC_PPM_HIST_STEP + 2)
+
+/*
+ * PI gains of the fill level feedback, as shifts on the fill error in
+ * us: 1 ms off target moves the pitch by 125 ppm at once and by about
+ * 15 ppm more per second of 1 kHz feedback updates.
+ */
+#define FBACK_KP_SHIFT		3
+#define FBACK_KI_SHIFT		16
+#define FBACK_I_MAX		((s64)FBACK_SLOW_MAX * 1000 << FBACK_KI_SHIFT)
 
 /* Runtime data params for one stream */
 struct uac_rtd_params {
@@ -53,9 +67,20 @@ struct uac_rtd_params {
 	unsigned int max_psize;	/* MaxPacketSize of endpoint */
 
 	struct usb_request **reqs;
+	bool period_pending; /* a period ended earlier in this batch */
+
+	/*
+	 * Zero-copy playback: zc_len[i] is what reqs[i] carries out of the
+	 * ring, zc_ptr where the next request starts and zc_sg[2 * i] the
+	 * entries reqs[i] uses when it straddles the end of the ring.
+	 */
+	unsigned int *zc_len;
+	unsigned int zc_ptr;
+	struct scatterlist *zc_sg;
 
 	struct usb_request *req_fback; /* Feedback endpoint request */
 	bool fb_ep_enabled; /* if the ep is enabled */
+	s64 fb_integral; /* fill error integral in us, see u_audio_fback_track */
 
   /* Volume/Mute controls and their state */
   int fu_id; /* Feature Unit ID */
@@ -69,6 +94,14 @@ struct uac_rtd_params {
 	int srate; /* selected samplerate */
 	int active; /* playback/capture running */
 
+	/*
+	 * Statistics, each written only from this stream's completion
+	 * handler and read locklessly through sysfs.
+	 */
+	unsigned long packets; /* packets moved to or from the PCM ring */
+	unsigned long no_pcm; /* packets with no running PCM: under/overrun */
+	unsigned long errors; /* packets completed with an error status */
+
   spinlock_t lock; /* lock for control transfers */
 
 };
@@ -86,6 +119,16 @@ struct snd_uac_chip {
 	unsigned long long p_residue_mil;
 	unsigned int p_interval;
 	unsigned int p_framesize;
+	unsigned int p_pktsize_max;
+
+	/* feedback values sent, written only by the feedback completion */
+	u32 fback_last, fback_min, fback_max;
+	/* written only by ppm_calculate_work */
+	unsigned long ppm_hist[UAC_PPM_HIST_BINS];
+
+	/* cluster order of the streams, one map and a terminator each */
+	struct snd_pcm_chmap_elem p_chmap[2];
+	struct snd_pcm_chmap_elem c_chmap[2];
 };
 
 static const struct snd_pcm_hardware uac_pcm_hardware = {
@@ -150,6 +193,86 @@ static void u_audio_set_fback_frequency(enum usb_device_speed speed,
 	*(__le32 *)buf = cpu_to_le32(ff);
 }
 
+/* bytes one isoc request may carry, all high-bandwidth transactions */
+static unsigned int u_audio_ep_isoc_bytes(struct usb_gadget *gadget,
+					  struct usb_ep *ep)
+{
+	if (gadget->speed == USB_SPEED_HIGH)
+		return usb_endpoint_maxp(ep->desc) *
+		       usb_endpoint_maxp_mult(ep->desc);
+
+	return usb_endpoint_maxp(ep->desc);
+}
+
+/*
+ * With req_batch > 1 only every req_batch-th request (and the last one)
+ * raises an interrupt; UDCs that honour no_interrupt hand the others
+ * back from the same IRQ. The queue depth, and so the latency bound,
+ * is still req_number requests.
+ */
+static bool u_audio_req_no_irq(struct uac_params *params, int i)
+{
+	if (params->req_batch <= 1 || i == params->req_number - 1)
+		return false;
+
+	return (i + 1) % params->req_batch;
+}
+
+static int u_audio_req_index(struct uac_rtd_params *prm,
+			     struct usb_request *req)
+{
+	struct uac_params *params = &prm->uac->audio_dev->params;
+	int i;
+
+	for (i = 0; i < params->req_number; i++)
+		if (prm->reqs[i] == req)
+			return i;
+
+	return 0;
+}
+
+/*
+ * Point a playback request straight into the ALSA ring instead of
+ * copying into req->buf. The ring data a request carries only counts as
+ * consumed once the request comes back, so the returned byte count is
+ * what hw_ptr may advance by and userspace never rewrites queued data.
+ */
+static unsigned int u_audio_zc_queue(struct uac_rtd_params *prm,
+				     struct usb_ep *ep,
+				     struct usb_request *req,
+				     struct snd_pcm_runtime *runtime)
+{
+	struct g_audio *audio_dev = prm->uac->audio_dev;
+	int i = u_audio_req_index(prm, req);
+	unsigned int done = prm->zc_len[i];
+	unsigned int pending = runtime->dma_bytes - prm->zc_ptr;
+	struct scatterlist *sg;
+	void *slot;
+
+	req->num_sgs = 0;
+	if (likely(pending >= req->length)) {
+		req->buf = runtime->dma_area + prm->zc_ptr;
+	} else if (audio_dev->gadget->sg_supported) {
+		sg = &prm->zc_sg[i * 2];
+		sg_init_table(sg, 2);
+		sg_set_buf(&sg[0], runtime->dma_area + prm->zc_ptr, pending);
+		sg_set_buf(&sg[1], runtime->dma_area, req->length - pending);
+		req->sg = sg;
+		req->num_sgs = 2;
+	} else {
+		slot = prm->rbuf + i * prm->max_psize;
+		memcpy(slot, runtime->dma_area + prm->zc_ptr, pending);
+		memcpy(slot + pending, runtime->dma_area,
+		       req->length - pending);
+		req->buf = slot;
+	}
+
+	prm->zc_len[i] = req->length;
+	prm->zc_ptr = (prm->zc_ptr + req->length) % runtime->dma_bytes;
+
+	return done;
+}
+
 static void u_audio_iso_complete(struct usb_ep *ep, struct usb_request *req)
 {
 	unsigned int pending;
@@ -159,7 +282,8 @@ static void u_audio_iso_complete(struct usb_ep *ep, struct usb_request *req)
 	struct snd_pcm_runtime *runtime;
 	struct uac_rtd_params *prm = req->context;
 	struct snd_uac_chip *uac = prm->uac;
-	unsigned int frames, p_pktsize;
+	unsigned int frames, p_pktsize, done;
+	bool zero_copy = prm->zc_len && prm == &uac->p_prm;
 	unsigned long long pitched_rate_mil, p_pktsize_residue_mil,
 			residue_frames_mil, div_result;
 
@@ -176,24 +300,35 @@ static void u_audio_iso_complete(struct usb_ep *ep, struct usb_request *req)
 	 * We can't really do much about bad xfers.
 	 * Afterall, the ISOCH xfers could fail legitimately.
 	 */
-	if (status)
+	if (status) {
 		pr_debug("%s: iso_complete status(%d) %d/%d\n",
 			__func__, status, req->actual, req->length);
+		WRITE_ONCE(prm->errors, prm->errors + 1);
+	}
+
+	/* capture consumed in the kernel never touches the virtual card */
+	if (uac->audio_dev->c_sink && prm == &uac->c_prm) {
+		uac->audio_dev->c_sink(uac->audio_dev, req->buf, req->actual);
+		WRITE_ONCE(prm->packets, prm->packets + 1);
+		goto queue;
+	}
 
 	substream = prm->ss;
 
 	/* Do nothing if ALSA isn't active */
 	if (!substream)
-		goto exit;
+		goto no_pcm;
 
 	snd_pcm_stream_lock(substream);
 
 	runtime = substream->runtime;
 	if (!runtime || !snd_pcm_running(substream)) {
 		snd_pcm_stream_unlock(substream);
-		goto exit;
+		goto no_pcm;
 	}
 
+	WRITE_ONCE(prm->packets, prm->packets + 1);
+
 	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
 		/*
 		 * For each IN packet, take the quotient of the current data
@@ -214,9 +349,9 @@ static void u_audio_iso_complete(struct usb_ep *ep, struct usb_request *req)
 
 		p_pktsize = min_t(unsigned int,
 					uac->p_framesize * frames,
-					ep->maxpacket);
+					uac->p_pktsize_max);
 
-		if (p_pktsize < ep->maxpacket) {
+		if (p_pktsize < uac->p_pktsize_max) {
 			residue_frames_mil = pitched_rate_mil - frames * p_interval_mil;
 			p_pktsize_residue_mil = uac->p_framesize * residue_frames_mil;
 		} else
@@ -247,8 +382,11 @@ static void u_audio_iso_complete(struct usb_ep *ep, struct usb_request *req)
 
 	/* Pack USB load in ALSA ring buffer */
 	pending = runtime->dma_bytes - hw_ptr;
+	done = req->actual;
 
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
+	if (zero_copy) {
+		done = u_audio_zc_queue(prm, ep, req, runtime);
+	} else if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
 		if (unlikely(pending < req->actual)) {
 			memcpy(req->buf, runtime->dma_area + hw_ptr, pending);
 			memcpy(req->buf + pending, runtime->dma_area,
@@ -269,18 +407,92 @@ static void u_audio_iso_complete(struct usb_ep *ep, struct usb_request *req)
 	}
 
 	/* update hw_ptr after data is copied to memory */
-	prm->hw_ptr = (hw_ptr + req->actual) % runtime->dma_bytes;
+	prm->hw_ptr = (hw_ptr + done) % runtime->dma_bytes;
 	hw_ptr = prm->hw_ptr;
 	snd_pcm_stream_unlock(substream);
 
-	if ((hw_ptr % snd_pcm_lib_period_bytes(substream)) < req->actual)
+	if (done && (hw_ptr % snd_pcm_lib_period_bytes(substream)) < done)
+		prm->period_pending = true;
+
+	/* report once per batch, from the request that raised the IRQ */
+	if (prm->period_pending && !req->no_interrupt) {
+		prm->period_pending = false;
 		snd_pcm_period_elapsed(substream);
+	}
+
+	goto queue;
+
+no_pcm:
+	WRITE_ONCE(prm->no_pcm, prm->no_pcm + 1);
+	/* back to the silence slot while ALSA is not feeding the ring */
+	if (zero_copy) {
+		req->num_sgs = 0;
+		req->buf = prm->rbuf + u_audio_req_index(prm, req) *
+			   prm->max_psize;
+	}
 
-exit:
+queue:
 	if (usb_ep_queue(ep, req, GFP_ATOMIC))
 		dev_err(uac->card->dev, "%d Error!\n", __LINE__);
 }
 
+/*
+ * Steer the feedback from how much of the capture ring the consumer
+ * has yet to read. When that consumer forwards to I2S the drain runs
+ * on the codec MCLK, so locking the fill to fb_target_ms locks the host
+ * to MCLK and leaves only the ring to absorb jitter.
+ */
+static void u_audio_fback_track(struct uac_rtd_params *prm)
+{
+	struct g_audio *audio_dev = prm->uac->audio_dev;
+	struct uac_params *params = &audio_dev->params;
+	struct snd_pcm_substream *substream = prm->ss;
+	struct snd_pcm_runtime *runtime;
+	unsigned int appl;
+	int fill;
+	s64 err, pitch;
+
+	if (!params->fb_target_ms)
+		return;
+
+	/* an in-kernel consumer knows its own backlog */
+	if (audio_dev->c_fill) {
+		fill = audio_dev->c_fill(audio_dev);
+		if (fill < 0)
+			return;
+		goto track;
+	}
+
+	if (!substream)
+		return;
+
+	snd_pcm_stream_lock(substream);
+	runtime = substream->runtime;
+	if (!runtime || !snd_pcm_running(substream)) {
+		snd_pcm_stream_unlock(substream);
+		return;
+	}
+
+	appl = frames_to_bytes(runtime,
+			       runtime->control->appl_ptr % runtime->buffer_size);
+	fill = (prm->hw_ptr + runtime->dma_bytes - appl) % runtime->dma_bytes;
+	fill = bytes_to_frames(runtime, fill);
+	snd_pcm_stream_unlock(substream);
+
+track:
+	err = (s64)fill - (s64)params->fb_target_ms * prm->srate / 1000;
+	err = div_s64(err * 1000000, prm->srate);
+
+	prm->fb_integral = clamp(prm->fb_integral + err,
+				 -FBACK_I_MAX, FBACK_I_MAX);
+
+	/* a filling ring means the host is fast, so ask for less */
+	pitch = 1000000 - (err >> FBACK_KP_SHIFT) -
+		(prm->fb_integral >> FBACK_KI_SHIFT);
+	prm->pitch = clamp_t(s64, pitch, (1000 - FBACK_SLOW_MAX) * 1000,
+			     (1000 + params->fb_max) * 1000);
+}
+
 static void u_audio_iso_fback_complete(struct usb_ep *ep,
 				       struct usb_request *req)
 {
@@ -288,6 +500,7 @@ static void u_audio_iso_fback_complete(struct usb_ep *ep,
 	struct snd_uac_chip *uac = prm->uac;
 	struct g_audio *audio_dev = uac->audio_dev;
 	int status = req->status;
+	u32 ff;
 
 	/* i/f shutting down */
 	if (!prm->fb_ep_enabled) {
@@ -307,10 +520,18 @@ static void u_audio_iso_fback_complete(struct usb_ep *ep,
 		pr_debug("%s: iso_complete status(%d) %d/%d\n",
 			__func__, status, req->actual, req->length);
 
+	u_audio_fback_track(prm);
 	u_audio_set_fback_frequency(audio_dev->gadget->speed, audio_dev->out_ep,
 				    prm->srate, prm->pitch,
 				    req->buf);
 
+	ff = le32_to_cpu(*(__le32 *)req->buf);
+	WRITE_ONCE(uac->fback_last, ff);
+	if (!uac->fback_min || ff < uac->fback_min)
+		WRITE_ONCE(uac->fback_min, ff);
+	if (ff > uac->fback_max)
+		WRITE_ONCE(uac->fback_max, ff);
+
 	if (usb_ep_queue(ep, req, GFP_ATOMIC))
 		dev_err(uac->card->dev, "%d Error!\n", __LINE__);
 }
@@ -333,6 +554,12 @@ static int uac_pcm_trigger(struct snd_pcm_substream *substream, int cmd)
 
 	/* Reset */
 	prm->hw_ptr = 0;
+	prm->period_pending = false;
+	if (prm->zc_len) {
+		prm->zc_ptr = 0;
+		memset(prm->zc_len, 0,
+		       params->req_number * sizeof(*prm->zc_len));
+	}
 
 	switch (cmd) {
 	case SNDRV_PCM_TRIGGER_START:
@@ -367,10 +594,13 @@ static snd_pcm_uframes_t uac_pcm_pointer(struct snd_pcm_substream *substream)
 	return bytes_to_frames(substream->runtime, prm->hw_ptr);
 }
 
-static u64 uac_ssize_to_fmt(int ssize)
+static u64 uac_ssize_to_fmt(int ssize, bool dsd)
 {
 	u64 ret;
 
+	if (dsd)
+		return SNDRV_PCM_FMTBIT_DSD_U32_LE;
+
 	switch (ssize) {
 	case 3:
 		ret = SNDRV_PCM_FMTBIT_S24_3LE;
@@ -407,11 +637,12 @@ static int uac_pcm_open(struct snd_pcm_substream *substream)
 	runtime->hw = uac_pcm_hardware;
 
 	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
-		runtime->hw.formats = uac_ssize_to_fmt(p_ssize);
+		runtime->hw.formats = uac_ssize_to_fmt(p_ssize, false);
 		runtime->hw.channels_min = num_channels(p_chmask);
 		prm = &uac->p_prm;
 	} else {
-		runtime->hw.formats = uac_ssize_to_fmt(c_ssize);
+		runtime->hw.formats = uac_ssize_to_fmt(c_ssize,
+						       audio_dev->c_dsd_active);
 		runtime->hw.channels_min = num_channels(c_chmask);
 		prm = &uac->c_prm;
 	}
@@ -620,7 +851,7 @@ int u_audio_start_capture(struct g_audio *audio_dev)
 	dev_dbg(dev, "start capture with rate %d\n", prm->srate);
 	ep = audio_dev->out_ep;
 	config_ep_by_speed(gadget, &audio_dev->func, ep);
-	req_len = ep->maxpacket;
+	req_len = u_audio_ep_isoc_bytes(gadget, ep);
 
 	prm->ep_enabled = true;
 	usb_ep_enable(ep);
@@ -637,7 +868,8 @@ int u_audio_start_capture(struct g_audio *audio_dev)
 			req->context = prm;
 			req->length = req_len;
 			req->complete = u_audio_iso_complete;
-			req->buf = prm->rbuf + i * ep->maxpacket;
+			req->buf = prm->rbuf + i * prm->max_psize;
+			req->no_interrupt = u_audio_req_no_irq(params, i);
 		}
 
 		if (usb_ep_queue(ep, prm->reqs[i], GFP_ATOMIC))
@@ -676,6 +908,7 @@ int u_audio_start_capture(struct g_audio *audio_dev)
 	 * be meauserd at start of playback
 	 */
 	prm->pitch = 1000000;
+	prm->fb_integral = 0;
 	u_audio_set_fback_frequency(audio_dev->gadget->speed, ep,
 				    prm->srate, prm->pitch,
 				    req_fback->buf);
@@ -750,10 +983,11 @@ int u_audio_start_playback(struct g_audio *audio_dev)
 	uac->p_framesize = params->p_ssize *
 			    num_channels(params->p_chmask);
 	uac->p_interval = factor / (1 << (ep_desc->bInterval - 1));
+	uac->p_pktsize_max = u_audio_ep_isoc_bytes(gadget, ep);
 	p_pktsize = min_t(unsigned int,
 				uac->p_framesize *
 					(prm->srate / uac->p_interval),
-				ep->maxpacket);
+				uac->p_pktsize_max);
 
 	req_len = p_pktsize;
 	uac->p_residue_mil = 0;
@@ -773,7 +1007,8 @@ int u_audio_start_playback(struct g_audio *audio_dev)
 			req->context = prm;
 			req->length = req_len;
 			req->complete = u_audio_iso_complete;
-			req->buf = prm->rbuf + i * ep->maxpacket;
+			req->buf = prm->rbuf + i * prm->max_psize;
+			req->no_interrupt = u_audio_req_no_irq(params, i);
 		}
 
 		if (usb_ep_queue(ep, prm->reqs[i], GFP_ATOMIC))
@@ -1215,7 +1450,7 @@ static void g_audio_work(struct work_struct *data)
 	struct snd_uac_chip *uac = audio->uac;
 	struct uac_rtd_params *prm;
 	struct device *dev = &gadget->dev;
-	char *uac_event[4]  = { NULL, NULL, NULL, NULL };
+	char *uac_event[5]  = { NULL, NULL, NULL, NULL, NULL };
 	char str[19];
 	int i;
 
@@ -1223,12 +1458,17 @@ static void g_audio_work(struct work_struct *data)
 		if (!audio->usb_state[i])
 			continue;
 
+		uac_event[3] = NULL;
 		switch (i) {
 		case SET_INTERFACE_OUT:
 			uac_event[0] = "USB_STATE=SET_INTERFACE";
 			uac_event[1] = "STREAM_DIRECTION=OUT";
 			uac_event[2] = audio->stream_state[STATE_OUT] ?
 				       "STREAM_STATE=ON" : "STREAM_STATE=OFF";
+			if (audio->params.c_dsd)
+				uac_event[3] = audio->c_dsd_active ?
+					       "STREAM_FORMAT=DSD" :
+					       "STREAM_FORMAT=PCM";
 			break;
 		case SET_INTERFACE_IN:
 			uac_event[0] = "USB_STATE=SET_INTERFACE";
@@ -1296,6 +1536,47 @@ static void g_audio_work(struct work_struct *data)
 	}
 }
 
+/*
+ * Frame number and raw time of the SOF that just happened. Polling for the
+ * frame number to change pins the timestamp to the SOF within one register
+ * read, instead of anywhere in the (micro)frame when the work happens to
+ * run. Samples torn by an interrupt between two polls are retried, and the
+ * plain reading is used if no clean edge is seen within a few frames.
+ */
+#define SOF_SAMPLE_GAP_NS	5000
+#define SOF_SAMPLE_MAX_NS	(3 * NSEC_PER_MSEC)
+
+static uint32_t sof_sample(struct usb_gadget *gadget, uint64_t *time)
+{
+	uint32_t first, frame;
+	uint64_t start, prev, now;
+	unsigned long flags;
+
+	local_irq_save(flags);
+	first = gadget->ops->get_frame(gadget);
+	start = prev = ktime_get_raw();
+	local_irq_restore(flags);
+
+	do {
+		local_irq_save(flags);
+		frame = gadget->ops->get_frame(gadget);
+		now = ktime_get_raw();
+		local_irq_restore(flags);
+
+		if (frame != first) {
+			if (now - prev < SOF_SAMPLE_GAP_NS) {
+				*time = now;
+				return frame;
+			}
+			first = frame;
+		}
+		prev = now;
+	} while (now - start < SOF_SAMPLE_MAX_NS);
+
+	*time = now;
+	return frame;
+}
+
 static void ppm_calculate_work(struct work_struct *data)
 {
 	struct g_audio *g_audio = container_of(data, struct g_audio,
@@ -1304,13 +1585,11 @@ static void ppm_calculate_work(struct work_struct *data)
 	uint32_t frame_number, fn_msec, clk_msec;
 	struct frame_number_data *fn = g_audio->fn;
 	uint64_t time_now, time_msec_tmp;
-	int32_t ppm;
-	static int32_t ppms[CLK_PPM_GROUP_SIZE];
-	static int32_t ppm_sum;
+	struct snd_uac_chip *uac = g_audio->uac;
+	int32_t ppm, bin;
 	int32_t cnt = fn->second % CLK_PPM_GROUP_SIZE;
 
-	time_now = ktime_get_raw();
-	frame_number = gadget->ops->get_frame(gadget);
+	frame_number = sof_sample(gadget, &time_now);
 
 	if (g_audio->fn->time_last &&
 	    time_now - g_audio->fn->time_last > 1500000000ULL)
@@ -1369,23 +1648,31 @@ static void ppm_calculate_work(struct work_struct *data)
 	      (fn_msec - clk_msec) * 1000000L / clk_msec :
 	      -((clk_msec - fn_msec) * 1000000L / clk_msec);
 
-	ppm_sum = ppm_sum - ppms[cnt] + ppm;
-	ppms[cnt] = ppm;
+	fn->ppm_sum = fn->ppm_sum - fn->ppms[cnt] + ppm;
+	fn->ppms[cnt] = ppm;
+
+	if (ppm < -UAC_PPM_HIST_LIMIT)
+		bin = 0;
+	else if (ppm >= UAC_PPM_HIST_LIMIT)
+		bin = UAC_PPM_HIST_BINS - 1;
+	else
+		bin = (ppm + UAC_PPM_HIST_LIMIT) / UAC_PPM_HIST_STEP + 1;
+	WRITE_ONCE(uac->ppm_hist[bin], uac->ppm_hist[bin] + 1);
 
 	dev_dbg(g_audio->device,
 		"frame %u msec %u ppm_calc %d ppm_avage(%d) %d\n",
 		fn_msec, clk_msec, ppm, CLK_PPM_GROUP_SIZE,
-		ppm_sum / CLK_PPM_GROUP_SIZE);
+		fn->ppm_sum / CLK_PPM_GROUP_SIZE);
 
 	/*
 	 * We calculate the average of ppm over a period of time. If the
 	 * latest frame number is too far from the average, no event will
 	 * be sent.
 	 */
-	if (abs(ppm_sum / CLK_PPM_GROUP_SIZE - ppm) < 3) {
-		ppm = ppm_sum > 0 ?
-		      (ppm_sum + CLK_PPM_GROUP_SIZE / 2) / CLK_PPM_GROUP_SIZE :
-		      (ppm_sum - CLK_PPM_GROUP_SIZE / 2) / CLK_PPM_GROUP_SIZE;
+	if (abs(fn->ppm_sum / CLK_PPM_GROUP_SIZE - ppm) < 3) {
+		ppm = fn->ppm_sum > 0 ?
+		      (fn->ppm_sum + CLK_PPM_GROUP_SIZE / 2) / CLK_PPM_GROUP_SIZE :
+		      (fn->ppm_sum - CLK_PPM_GROUP_SIZE / 2) / CLK_PPM_GROUP_SIZE;
 		if (ppm != g_audio->params.ppm) {
 			g_audio->params.ppm = ppm;
 			g_audio->usb_state[SET_AUDIO_CLK] = true;
@@ -1397,6 +1684,103 @@ static void ppm_calculate_work(struct work_struct *data)
 	schedule_delayed_work(&g_audio->ppm_work, 1 * HZ);
 }
 
+#define UAC_STAT_ATTR(name, field)					\
+static ssize_t name##_show(struct device *dev,				\
+			   struct device_attribute *attr, char *buf)	\
+{									\
+	struct g_audio *g_audio = dev_get_drvdata(dev);			\
+									\
+	return sprintf(buf, "%lu\n",					\
+		       (unsigned long)READ_ONCE(g_audio->uac->field));	\
+}									\
+static DEVICE_ATTR_RO(name)
+
+UAC_STAT_ATTR(p_packets, p_prm.packets);
+UAC_STAT_ATTR(p_underruns, p_prm.no_pcm);
+UAC_STAT_ATTR(p_errors, p_prm.errors);
+UAC_STAT_ATTR(c_packets, c_prm.packets);
+UAC_STAT_ATTR(c_overruns, c_prm.no_pcm);
+UAC_STAT_ATTR(c_errors, c_prm.errors);
+UAC_STAT_ATTR(fback_last, fback_last);
+UAC_STAT_ATTR(fback_min, fback_min);
+UAC_STAT_ATTR(fback_max, fback_max);
+
+static ssize_t ppm_show(struct device *dev, struct device_attribute *attr,
+			char *buf)
+{
+	struct g_audio *g_audio = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%d\n", READ_ONCE(g_audio->params.ppm));
+}
+static DEVICE_ATTR_RO(ppm);
+
+/* one count per bin, lowest ppm first, see UAC_PPM_HIST_LIMIT */
+static ssize_t ppm_histogram_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct g_audio *g_audio = dev_get_drvdata(dev);
+	ssize_t len = 0;
+	int i;
+
+	for (i = 0; i < UAC_PPM_HIST_BINS; i++)
+		len += sprintf(buf + len, "%lu%c",
+			       READ_ONCE(g_audio->uac->ppm_hist[i]),
+			       i == UAC_PPM_HIST_BINS - 1 ? '\n' : ' ');
+
+	return len;
+}
+static DEVICE_ATTR_RO(ppm_histogram);
+
+static struct attribute *u_audio_attrs[] = {
+	&dev_attr_p_packets.attr,
+	&dev_attr_p_underruns.attr,
+	&dev_attr_p_errors.attr,
+	&dev_attr_c_packets.attr,
+	&dev_attr_c_overruns.attr,
+	&dev_attr_c_errors.attr,
+	&dev_attr_fback_last.attr,
+	&dev_attr_fback_min.attr,
+	&dev_attr_fback_max.attr,
+	&dev_attr_ppm.attr,
+	&dev_attr_ppm_histogram.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(u_audio);
+
+/* UAC2 bmChannelConfig bits in cluster order, as sound/usb/stream.c */
+static const unsigned char uac_chmap_pos[] = {
+	SNDRV_CHMAP_FL, SNDRV_CHMAP_FR, SNDRV_CHMAP_FC, SNDRV_CHMAP_LFE,
+	SNDRV_CHMAP_RL, SNDRV_CHMAP_RR, SNDRV_CHMAP_FLC, SNDRV_CHMAP_FRC,
+	SNDRV_CHMAP_RC, SNDRV_CHMAP_SL, SNDRV_CHMAP_SR, SNDRV_CHMAP_TC,
+	SNDRV_CHMAP_TFL, SNDRV_CHMAP_TFC, SNDRV_CHMAP_TFR, SNDRV_CHMAP_TRL,
+	SNDRV_CHMAP_TRC, SNDRV_CHMAP_TRR, SNDRV_CHMAP_TFLC, SNDRV_CHMAP_TFRC,
+	SNDRV_CHMAP_LLFE, SNDRV_CHMAP_RLFE, SNDRV_CHMAP_TSL, SNDRV_CHMAP_TSR,
+	SNDRV_CHMAP_BC, SNDRV_CHMAP_BLC, SNDRV_CHMAP_BRC,
+};
+
+/*
+ * Expose the channel positions of the USB cluster. Samples keep their
+ * interleaved cluster order, so channel n is what an I2S/TDM bridge
+ * puts on slot n and the map tells it which speaker that is. Clusters
+ * wider than an ALSA map get no control.
+ */
+static int uac_add_chmap(struct snd_pcm *pcm, int stream, int chmask,
+			 struct snd_pcm_chmap_elem *chmap)
+{
+	int ch = 0, bit;
+
+	for (bit = 0; bit < ARRAY_SIZE(uac_chmap_pos); bit++)
+		if (chmask & BIT(bit)) {
+			if (ch >= ARRAY_SIZE(chmap->map))
+				return 0;
+			chmap->map[ch++] = uac_chmap_pos[bit];
+		}
+
+	chmap->channels = ch;
+
+	return snd_pcm_add_chmap_ctls(pcm, stream, chmap, ch, 0, NULL);
+}
+
 int g_audio_setup(struct g_audio *g_audio, const char *pcm_name,
 					const char *card_name)
 {
@@ -1475,6 +1859,19 @@ int g_audio_setup(struct g_audio *g_audio, const char *pcm_name,
 			err = -ENOMEM;
 			goto fail;
 		}
+
+		if (params->p_zero_copy) {
+			prm->zc_len = kcalloc(params->req_number,
+					      sizeof(*prm->zc_len),
+					      GFP_KERNEL);
+			prm->zc_sg = kcalloc(params->req_number * 2,
+					     sizeof(*prm->zc_sg),
+					     GFP_KERNEL);
+			if (!prm->zc_len || !prm->zc_sg) {
+				err = -ENOMEM;
+				goto fail;
+			}
+		}
 	}
 
 	/* Choose any slot, with no id */
@@ -1501,6 +1898,20 @@ int g_audio_setup(struct g_audio *g_audio, const char *pcm_name,
 	snd_pcm_set_ops(pcm, SNDRV_PCM_STREAM_PLAYBACK, &uac_pcm_ops);
 	snd_pcm_set_ops(pcm, SNDRV_PCM_STREAM_CAPTURE, &uac_pcm_ops);
 
+	if (p_chmask) {
+		err = uac_add_chmap(pcm, SNDRV_PCM_STREAM_PLAYBACK, p_chmask,
+				    uac->p_chmap);
+		if (err < 0)
+			goto snd_fail;
+	}
+
+	if (c_chmask) {
+		err = uac_add_chmap(pcm, SNDRV_PCM_STREAM_CAPTURE, c_chmask,
+				    uac->c_chmap);
+		if (err < 0)
+			goto snd_fail;
+	}
+
 	/*
 	 * Create mixer and controls
 	 * Create only if it's required on USB side
@@ -1641,15 +2052,22 @@ int g_audio_setup(struct g_audio *g_audio, const char *pcm_name,
 	strscpy(card->shortname, card_name, sizeof(card->shortname));
 	sprintf(card->longname, "%s %i", card_name, card->dev->id);
 
-	snd_pcm_set_managed_buffer_all(pcm, SNDRV_DMA_TYPE_CONTINUOUS,
-				       NULL, 0, BUFF_SIZE_MAX);
+	/*
+	 * Zero-copy requests may still be in flight after hw_free, so keep
+	 * the ring preallocated rather than handing it back to the allocator.
+	 */
+	snd_pcm_set_managed_buffer_all(pcm, SNDRV_DMA_TYPE_CONTINUOUS, NULL,
+				       params->p_zero_copy ? BUFF_SIZE_MAX : 0,
+				       BUFF_SIZE_MAX);
 
 	err = snd_card_register(card);
 	if (err < 0)
 		goto snd_fail;
 
-	g_audio->device = device_create(audio_class, NULL, MKDEV(0, 0), NULL,
-					"%s", g_audio->uac->card->longname);
+	g_audio->device = device_create_with_groups(audio_class, NULL,
+						    MKDEV(0, 0), g_audio,
+						    u_audio_groups, "%s",
+						    g_audio->uac->card->longname);
 	if (IS_ERR(g_audio->device)) {
 		err = PTR_ERR(g_audio->device);
 		goto snd_fail;
@@ -1669,6 +2087,8 @@ int g_audio_setup(struct g_audio *g_audio, const char *pcm_name,
 	kfree(uac->c_prm.reqs);
 	kfree(uac->p_prm.rbuf);
 	kfree(uac->c_prm.rbuf);
+	kfree(uac->p_prm.zc_len);
+	kfree(uac->p_prm.zc_sg);
 	kfree(uac);
 	kfree(g_audio->fn);
 
@@ -1698,6 +2118,8 @@ void g_audio_cleanup(struct g_audio *g_audio)
 	kfree(uac->c_prm.reqs);
 	kfree(uac->p_prm.rbuf);
 	kfree(uac->c_prm.rbuf);
+	kfree(uac->p_prm.zc_len);
+	kfree(uac->p_prm.zc_sg);
 	kfree(uac);
 	kfree(g_audio->fn);
 }
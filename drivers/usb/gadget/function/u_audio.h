@@ -43,12 +43,14 @@ struct uac_params {
 	int p_chmask;	/* channel mask */
 	int p_srates[UAC_MAX_RATES];	/* available rates in Hz (0 terminated list) */
 	int p_ssize;	/* sample size */
+	bool p_zero_copy;	/* send straight from the PCM ring */
 	struct uac_fu_params p_fu;	/* Feature Unit parameters */
 
 	/* capture */
 	int c_chmask;	/* channel mask */
 	int c_srates[UAC_MAX_RATES];	/* available rates in Hz (0 terminated list) */
 	int c_ssize;	/* sample size */
+	bool c_dsd;	/* native DSD alt setting present */
 	struct uac_fu_params c_fu;	/* Feature Unit parameters */
 
 	/* rates are dynamic, in uac_rtd_params */
@@ -56,7 +58,9 @@ struct uac_params {
 	int ppm;	/* difference between audio clk and usb clk */
 
 	int req_number; /* number of preallocated requests */
+	int req_batch;	/* requests per completion interrupt */
 	int fb_max;	/* upper frequency drift feedback limit per-mil */
+	int fb_target_ms;	/* capture fill the feedback locks to, 0: off */
 };
 
 enum usb_state_index {
@@ -77,6 +81,8 @@ enum stream_state_index {
 	STATE_IN,
 };
 
+#define CLK_PPM_GROUP_SIZE	20
+
 struct frame_number_data {
 	uint32_t fn_begin;	/* frame number when starting statistics */
 	uint32_t fn_last;	/* frame number in the latest statistics */
@@ -84,12 +90,16 @@ struct frame_number_data {
 	uint32_t second;	/* total seconds counted */
 	ktime_t time_begin;	/* system time when starting statistics */
 	ktime_t time_last;	/* system time in the latest statistics */
+	int32_t ppms[CLK_PPM_GROUP_SIZE];	/* latest ppm samples */
+	int32_t ppm_sum;	/* sum of ppms[] */
 };
 
 struct g_audio {
 	struct device *device;
 	bool usb_state[SET_USB_STATE_MAX];
 	bool stream_state[2];
+	/* capture runs on the DSD alt setting */
+	bool c_dsd_active;
 	struct work_struct work;
 
 	struct frame_number_data *fn;
@@ -112,6 +122,16 @@ struct g_audio {
 	/* Notify UAC driver about control change */
 	int (*notify)(struct g_audio *g_audio, int unit_id, int cs);
 
+	/*
+	 * Optional in-kernel capture consumer: c_sink gets every OUT
+	 * packet from the completion handler instead of the capture PCM,
+	 * c_fill reports its backlog in frames (< 0: unknown) for the
+	 * feedback controller.
+	 */
+	void (*c_sink)(struct g_audio *g_audio, const void *buf,
+		       unsigned int len);
+	int (*c_fill)(struct g_audio *g_audio);
+
 	/* The ALSA Sound Card it represents on the USB-Client side */
 	struct snd_uac_chip *uac;
 
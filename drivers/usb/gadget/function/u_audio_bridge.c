@@ -0,0 +1,320 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * u_audio_bridge.c -- in-kernel UAC capture to ALSA playback bridge
+ *
+ * Copyright (C) 2026 Rockchip Electronics Co., Ltd.
+ *
+ * Moves what the host plays straight from the OUT isoc completion into
+ * the ring of a local playback PCM, typically the I2S/TDM DAI, instead
+ * of going through the virtual card and a userspace loop. The PCM node
+ * is opened from the kernel the way u_uac1_legacy.c does it.
+ *
+ * Packets are written in atomic context with the target stream lock
+ * held; everything else (open, hw/sw params, start once half the ring
+ * is queued, prepare after an xrun, drop) runs from one work item that
+ * reconciles the bridge state.
+ */
+
+#include <linux/fs.h>
+#include <linux/slab.h>
+#include <sound/core.h>
+#include <sound/pcm.h>
+#include <sound/pcm_params.h>
+
+#include "u_audio_bridge.h"
+
+/* 1 ms periods, 8 of them; start playing once half are queued */
+#define UAC_BRIDGE_PERIOD_US	1000
+#define UAC_BRIDGE_PERIODS	8
+
+enum {
+	UAC_BRIDGE_RUN,
+	UAC_BRIDGE_RECONFIG,
+};
+
+static void uac_bridge_param_set(struct snd_pcm_hw_params *params,
+				 snd_pcm_hw_param_t var, unsigned int val)
+{
+	if (hw_is_mask(var)) {
+		struct snd_mask *m = hw_param_mask(params, var);
+
+		snd_mask_none(m);
+		snd_mask_set(m, val);
+	} else {
+		struct snd_interval *i = hw_param_interval(params, var);
+
+		i->min = val;
+		i->max = val;
+		i->openmin = 0;
+		i->openmax = 0;
+		i->integer = 1;
+		i->empty = 0;
+	}
+
+	params->cmask |= 1 << var;
+	params->rmask |= 1 << var;
+}
+
+static snd_pcm_format_t uac_bridge_format(struct g_audio *audio_dev)
+{
+	if (audio_dev->c_dsd_active)
+		return SNDRV_PCM_FORMAT_DSD_U32_LE;
+
+	switch (audio_dev->params.c_ssize) {
+	case 3:
+		return SNDRV_PCM_FORMAT_S24_3LE;
+	case 4:
+		return SNDRV_PCM_FORMAT_S32_LE;
+	default:
+		return SNDRV_PCM_FORMAT_S16_LE;
+	}
+}
+
+static int uac_bridge_open(struct uac_bridge *br)
+{
+	struct device *dev = &br->audio_dev->gadget->dev;
+	struct snd_pcm_file *pcm_file;
+
+	br->filp = filp_open(br->path, O_WRONLY | O_NONBLOCK, 0);
+	if (IS_ERR(br->filp)) {
+		int ret = PTR_ERR(br->filp);
+
+		dev_err(dev, "unable to open bridge PCM %s: %d\n",
+			br->path, ret);
+		br->filp = NULL;
+		return ret;
+	}
+
+	pcm_file = br->filp->private_data;
+	br->substream = pcm_file->substream;
+
+	return 0;
+}
+
+static int uac_bridge_configure(struct uac_bridge *br)
+{
+	struct g_audio *audio_dev = br->audio_dev;
+	struct snd_pcm_substream *substream = br->substream;
+	struct device *dev = &audio_dev->gadget->dev;
+	struct snd_pcm_hw_params *params;
+	struct snd_pcm_sw_params sw = { 0 };
+	unsigned int period;
+	u32 rate;
+	int ret;
+
+	u_audio_get_capture_srate(audio_dev, &rate);
+	period = DIV_ROUND_UP(rate * UAC_BRIDGE_PERIOD_US, 1000000);
+
+	params = kzalloc(sizeof(*params), GFP_KERNEL);
+	if (!params)
+		return -ENOMEM;
+
+	snd_pcm_kernel_ioctl(substream, SNDRV_PCM_IOCTL_DROP, NULL);
+
+	_snd_pcm_hw_params_any(params);
+	uac_bridge_param_set(params, SNDRV_PCM_HW_PARAM_ACCESS,
+			     SNDRV_PCM_ACCESS_RW_INTERLEAVED);
+	uac_bridge_param_set(params, SNDRV_PCM_HW_PARAM_FORMAT,
+			     (__force unsigned int)uac_bridge_format(audio_dev));
+	uac_bridge_param_set(params, SNDRV_PCM_HW_PARAM_CHANNELS,
+			     num_channels(audio_dev->params.c_chmask));
+	uac_bridge_param_set(params, SNDRV_PCM_HW_PARAM_RATE, rate);
+	uac_bridge_param_set(params, SNDRV_PCM_HW_PARAM_PERIOD_SIZE, period);
+	uac_bridge_param_set(params, SNDRV_PCM_HW_PARAM_BUFFER_SIZE,
+			     period * UAC_BRIDGE_PERIODS);
+
+	ret = snd_pcm_kernel_ioctl(substream, SNDRV_PCM_IOCTL_HW_PARAMS,
+				   params);
+	kfree(params);
+	if (ret < 0) {
+		dev_err(dev, "bridge PCM rejects %u Hz/%u ch/%u bytes: %d\n",
+			rate, num_channels(audio_dev->params.c_chmask),
+			audio_dev->params.c_ssize, ret);
+		return ret;
+	}
+
+	sw.tstamp_mode = SNDRV_PCM_TSTAMP_NONE;
+	sw.period_step = 1;
+	sw.avail_min = 1;
+	sw.start_threshold = substream->runtime->buffer_size / 2;
+	sw.stop_threshold = substream->runtime->buffer_size;
+	sw.boundary = substream->runtime->boundary;
+
+	ret = snd_pcm_kernel_ioctl(substream, SNDRV_PCM_IOCTL_SW_PARAMS, &sw);
+	if (ret < 0)
+		return ret;
+
+	return snd_pcm_kernel_ioctl(substream, SNDRV_PCM_IOCTL_PREPARE, NULL);
+}
+
+static void uac_bridge_deactivate(struct uac_bridge *br)
+{
+	if (!rcu_access_pointer(br->active))
+		return;
+
+	RCU_INIT_POINTER(br->active, NULL);
+	synchronize_rcu();
+	snd_pcm_kernel_ioctl(br->substream, SNDRV_PCM_IOCTL_DROP, NULL);
+}
+
+static void uac_bridge_work(struct work_struct *work)
+{
+	struct uac_bridge *br = container_of(work, struct uac_bridge, work);
+	struct snd_pcm_substream *substream;
+
+	if (!test_bit(UAC_BRIDGE_RUN, &br->flags)) {
+		uac_bridge_deactivate(br);
+		return;
+	}
+
+	substream = rcu_access_pointer(br->active);
+	if (substream && !test_and_clear_bit(UAC_BRIDGE_RECONFIG,
+					     &br->flags)) {
+		/* the writer can neither start nor prepare in atomic context */
+		switch (substream->runtime->status->state) {
+		case SNDRV_PCM_STATE_PREPARED:
+			if (snd_pcm_playback_hw_avail(substream->runtime) >=
+			    substream->runtime->start_threshold)
+				snd_pcm_kernel_ioctl(substream,
+						     SNDRV_PCM_IOCTL_START, NULL);
+			break;
+		case SNDRV_PCM_STATE_XRUN:
+			snd_pcm_kernel_ioctl(substream, SNDRV_PCM_IOCTL_PREPARE,
+					     NULL);
+			break;
+		default:
+			break;
+		}
+		return;
+	}
+
+	uac_bridge_deactivate(br);
+	clear_bit(UAC_BRIDGE_RECONFIG, &br->flags);
+
+	if (!br->filp && uac_bridge_open(br))
+		return;
+
+	if (uac_bridge_configure(br))
+		return;
+
+	rcu_assign_pointer(br->active, br->substream);
+}
+
+void uac_bridge_init(struct uac_bridge *br, struct g_audio *audio_dev,
+		     const char *path)
+{
+	br->audio_dev = audio_dev;
+	br->path = path;
+	br->flags = 0;
+	RCU_INIT_POINTER(br->active, NULL);
+	INIT_WORK(&br->work, uac_bridge_work);
+}
+
+/* May be called from the SET_INTERFACE handler in interrupt context */
+void uac_bridge_start(struct uac_bridge *br)
+{
+	set_bit(UAC_BRIDGE_RECONFIG, &br->flags);
+	set_bit(UAC_BRIDGE_RUN, &br->flags);
+	schedule_work(&br->work);
+}
+
+void uac_bridge_stop(struct uac_bridge *br)
+{
+	clear_bit(UAC_BRIDGE_RUN, &br->flags);
+	schedule_work(&br->work);
+}
+
+void uac_bridge_release(struct uac_bridge *br)
+{
+	clear_bit(UAC_BRIDGE_RUN, &br->flags);
+	cancel_work_sync(&br->work);
+	uac_bridge_deactivate(br);
+
+	if (br->filp)
+		filp_close(br->filp, NULL);
+	br->filp = NULL;
+	br->substream = NULL;
+}
+
+/*
+ * Copy one OUT packet into the target ring at appl_ptr, the single copy
+ * between the USB request and the I2S DMA buffer. Called from the
+ * capture completion handler.
+ */
+void uac_bridge_write(struct uac_bridge *br, const void *buf,
+		      unsigned int len)
+{
+	struct snd_pcm_substream *substream;
+	struct snd_pcm_runtime *runtime;
+	snd_pcm_uframes_t frames, avail, off, cont, appl;
+	unsigned long flags;
+
+	rcu_read_lock();
+	substream = rcu_dereference(br->active);
+	if (!substream)
+		goto out;
+
+	snd_pcm_stream_lock_irqsave(substream, flags);
+	runtime = substream->runtime;
+
+	switch (runtime->status->state) {
+	case SNDRV_PCM_STATE_PREPARED:
+	case SNDRV_PCM_STATE_RUNNING:
+		break;
+	case SNDRV_PCM_STATE_XRUN:
+		schedule_work(&br->work);
+		fallthrough;
+	default:
+		goto unlock;
+	}
+
+	frames = bytes_to_frames(runtime, len);
+	avail = snd_pcm_playback_avail(runtime);
+	if (frames > avail) {
+		br->dropped += frames - avail;
+		frames = avail;
+	}
+
+	off = runtime->control->appl_ptr % runtime->buffer_size;
+	cont = min(frames, runtime->buffer_size - off);
+	memcpy(runtime->dma_area + frames_to_bytes(runtime, off), buf,
+	       frames_to_bytes(runtime, cont));
+	if (frames > cont)
+		memcpy(runtime->dma_area,
+		       buf + frames_to_bytes(runtime, cont),
+		       frames_to_bytes(runtime, frames - cont));
+
+	appl = runtime->control->appl_ptr + frames;
+	if (appl >= runtime->boundary)
+		appl -= runtime->boundary;
+	runtime->control->appl_ptr = appl;
+
+	if (runtime->status->state == SNDRV_PCM_STATE_PREPARED &&
+	    snd_pcm_playback_hw_avail(runtime) >= runtime->start_threshold)
+		schedule_work(&br->work);
+
+unlock:
+	snd_pcm_stream_unlock_irqrestore(substream, flags);
+out:
+	rcu_read_unlock();
+}
+
+/* Frames queued in the target ring, for the feedback controller */
+int uac_bridge_fill(struct uac_bridge *br)
+{
+	struct snd_pcm_substream *substream;
+	unsigned long flags;
+	int fill = -ENODEV;
+
+	rcu_read_lock();
+	substream = rcu_dereference(br->active);
+	if (substream) {
+		snd_pcm_stream_lock_irqsave(substream, flags);
+		if (snd_pcm_running(substream))
+			fill = snd_pcm_playback_hw_avail(substream->runtime);
+		snd_pcm_stream_unlock_irqrestore(substream, flags);
+	}
+	rcu_read_unlock();
+
+	return fill;
+}
@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * u_audio_bridge.h -- in-kernel UAC capture to ALSA playback bridge
+ *
+ * Copyright (C) 2026 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __U_AUDIO_BRIDGE_H
+#define __U_AUDIO_BRIDGE_H
+
+#include <linux/rcupdate.h>
+#include <linux/workqueue.h>
+
+#include "u_audio.h"
+
+struct uac_bridge {
+	struct g_audio *audio_dev;
+	const char *path;		/* PCM node, e.g. /dev/snd/pcmC0D0p */
+
+	struct file *filp;
+	struct snd_pcm_substream *substream;
+	/* the opened substream while packets may be written into it */
+	struct snd_pcm_substream __rcu *active;
+
+	unsigned long flags;
+	struct work_struct work;
+
+	unsigned long dropped;		/* frames that found the ring full */
+};
+
+void uac_bridge_init(struct uac_bridge *br, struct g_audio *audio_dev,
+		     const char *path);
+void uac_bridge_start(struct uac_bridge *br);
+void uac_bridge_stop(struct uac_bridge *br);
+void uac_bridge_release(struct uac_bridge *br);
+
+void uac_bridge_write(struct uac_bridge *br, const void *buf,
+		      unsigned int len);
+int uac_bridge_fill(struct uac_bridge *br);
+
+#endif /* __U_AUDIO_BRIDGE_H */
@@ -33,6 +33,7 @@
 #define UAC2_DEF_RES_DB		(1*256)		/* 1 dB */
 
 #define UAC2_DEF_REQ_NUM 2
+#define UAC2_DEF_REQ_BATCH 1
 #define UAC2_DEF_INT_REQ_NUM	10
 
 struct f_uac2_opts {
@@ -40,10 +41,12 @@ struct f_uac2_opts {
 	int				p_chmask;
 	int				p_srates[UAC_MAX_RATES];
 	int				p_ssize;
+	bool				p_zero_copy;
 	u8				p_hs_bint;
 	int				c_chmask;
 	int				c_srates[UAC_MAX_RATES];
 	int				c_ssize;
+	bool				c_dsd;
 	int				c_sync;
 	u8				c_hs_bint;
 
@@ -60,10 +63,13 @@ struct f_uac2_opts {
 	s16				c_volume_res;
 
 	int				req_number;
+	int				req_batch;
 	int				fb_max;
+	int				fb_target_ms;
 	bool			bound;
 
 	char			function_name[32];
+	char			c_bridge[64];
 
 	struct mutex			lock;
 	int				refcnt;
@@ -77,6 +77,9 @@ struct uvc_request {
 	struct usb_request *req;
 	u8 *req_buffer;
 	struct uvc_video *video;
+	/* header from req_buffer followed by chunks of the video buffer */
+	struct scatterlist *sg;
+	unsigned int sg_nents;
 #if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
 	struct completion req_done;
 #endif
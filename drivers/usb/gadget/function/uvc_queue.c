@@ -17,6 +17,7 @@
 #include <linux/wait.h>
 
 #include <media/v4l2-common.h>
+#include <media/videobuf2-dma-sg.h>
 #include <media/videobuf2-vmalloc.h>
 
 #include "uvc.h"
@@ -161,13 +162,23 @@ static int uvc_buffer_prepare(struct vb2_buffer *vb)
 		return -ENODEV;
 
 	buf->state = UVC_BUF_STATE_QUEUED;
+	if (queue->use_sg) {
+		/*
+		 * The UDC reads the pages directly, there is no need for a
+		 * kernel mapping of imported dma-bufs.
+		 */
+		buf->sg = vb2_dma_sg_plane_desc(vb, 0)->sgl;
+		buf->offset = 0;
+		buf->mem = NULL;
+	} else {
 #if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
-	buf->mem = uvc_buffer_mem_prepare(vb, queue);
-	if (IS_ERR(buf->mem))
-		return -ENOMEM;
+		buf->mem = uvc_buffer_mem_prepare(vb, queue);
+		if (IS_ERR(buf->mem))
+			return -ENOMEM;
 #else
-	buf->mem = vb2_plane_vaddr(vb, 0);
+		buf->mem = vb2_plane_vaddr(vb, 0);
 #endif
+	}
 	buf->length = vb2_plane_size(vb, 0);
 	if (vb->type == V4L2_BUF_TYPE_VIDEO_CAPTURE)
 		buf->bytesused = 0;
@@ -207,8 +218,8 @@ static const struct vb2_ops uvc_queue_qops = {
 	.wait_finish = vb2_ops_wait_finish,
 };
 
-int uvcg_queue_init(struct uvc_video_queue *queue, enum v4l2_buf_type type,
-		    struct mutex *lock)
+int uvcg_queue_init(struct uvc_video_queue *queue, struct device *dev,
+		    enum v4l2_buf_type type, struct mutex *lock, bool use_sg)
 {
 	int ret;
 
@@ -218,7 +229,18 @@ int uvcg_queue_init(struct uvc_video_queue *queue, enum v4l2_buf_type type,
 	queue->queue.buf_struct_size = sizeof(struct uvc_buffer);
 	queue->queue.ops = &uvc_queue_qops;
 	queue->queue.lock = lock;
-	queue->queue.mem_ops = &vb2_vmalloc_memops;
+	/*
+	 * When the UDC takes scatter-gather requests the buffers are handed to
+	 * it page by page, so they need neither be contiguous nor mapped into
+	 * the kernel. This lets dma-bufs from the encoder be streamed as is.
+	 */
+	if (use_sg) {
+		queue->queue.mem_ops = &vb2_dma_sg_memops;
+		queue->queue.dev = dev;
+	} else {
+		queue->queue.mem_ops = &vb2_vmalloc_memops;
+	}
+	queue->use_sg = use_sg;
 	queue->queue.timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC
 				     | V4L2_BUF_FLAG_TSTAMP_SRC_EOF;
 	/*
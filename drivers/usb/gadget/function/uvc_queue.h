@@ -36,6 +36,10 @@ struct uvc_buffer {
 	void *mem;
 	unsigned int length;
 	unsigned int bytesused;
+
+	/* Scatter-gather streaming: next chunk to send and offset into it */
+	struct scatterlist *sg;
+	unsigned int offset;
 };
 
 #define UVC_QUEUE_DISCONNECTED		(1 << 0)
@@ -48,6 +52,7 @@ struct uvc_video_queue {
 	__u32 sequence;
 
 	unsigned int buf_used;
+	bool use_sg;
 
 	spinlock_t irqlock;	/* Protects flags and irqqueue */
 	struct list_head irqqueue;
@@ -58,8 +63,8 @@ static inline int uvc_queue_streaming(struct uvc_video_queue *queue)
 	return vb2_is_streaming(&queue->queue);
 }
 
-int uvcg_queue_init(struct uvc_video_queue *queue, enum v4l2_buf_type type,
-		    struct mutex *lock);
+int uvcg_queue_init(struct uvc_video_queue *queue, struct device *dev,
+		    enum v4l2_buf_type type, struct mutex *lock, bool use_sg);
 
 void uvcg_free_buffers(struct uvc_video_queue *queue);
 
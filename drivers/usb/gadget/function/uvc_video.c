@@ -13,6 +13,7 @@
 #include <linux/usb/gadget.h>
 #include <linux/usb/video.h>
 #include <linux/pm_qos.h>
+#include <linux/scatterlist.h>
 
 #include <media/v4l2-dev.h>
 
@@ -27,7 +28,8 @@ static bool uvc_using_zero_copy(struct uvc_video *video)
 	struct uvc_device *uvc = container_of(video, struct uvc_device, video);
 	struct f_uvc_opts *opts = fi_to_f_uvc_opts(uvc->func.fi);
 
-	if (opts && opts->uvc_zero_copy && video->fcc != V4L2_PIX_FMT_YUYV)
+	if (opts && opts->uvc_zero_copy && !video->queue.use_sg &&
+	    video->fcc != V4L2_PIX_FMT_YUYV)
 		return true;
 	else
 		return false;
@@ -192,6 +194,125 @@ uvc_video_encode_isoc(struct usb_request *req, struct uvc_video *video,
 	}
 }
 
+/*
+ * Scatter-gather variants: the header is built in the request buffer and the
+ * payload is described by entries pointing into the video buffer pages, so
+ * the UDC reads it straight from where the producer left it.
+ */
+static unsigned int
+uvc_video_encode_data_sg(struct uvc_video *video, struct uvc_buffer *buf,
+		struct uvc_request *ureq, unsigned int *nents, unsigned int len)
+{
+	struct uvc_video_queue *queue = &video->queue;
+	unsigned int nbytes = 0;
+	unsigned int offset;
+	unsigned int part;
+
+	len = min(len, buf->bytesused - queue->buf_used);
+
+	while (nbytes < len && buf->sg && *nents < ureq->sg_nents) {
+		part = min(len - nbytes, buf->sg->length - buf->offset);
+		offset = buf->sg->offset + buf->offset;
+		sg_set_page(&ureq->sg[(*nents)++],
+			    nth_page(sg_page(buf->sg), offset >> PAGE_SHIFT),
+			    part, offset & ~PAGE_MASK);
+
+		nbytes += part;
+		buf->offset += part;
+		if (buf->offset == buf->sg->length) {
+			buf->sg = sg_next(buf->sg);
+			buf->offset = 0;
+		}
+	}
+
+	queue->buf_used += nbytes;
+
+	return nbytes;
+}
+
+static void
+uvc_video_encode_bulk_sg(struct usb_request *req, struct uvc_video *video,
+		struct uvc_buffer *buf)
+{
+	struct uvc_request *ureq = req->context;
+	unsigned int nents = 0;
+	int len = video->req_size;
+	int ret;
+
+	sg_init_table(ureq->sg, ureq->sg_nents);
+
+	/* Add a header at the beginning of the payload. */
+	if (video->payload_size == 0) {
+		ret = uvc_video_encode_header(video, buf, ureq->req_buffer, len);
+		sg_set_buf(&ureq->sg[nents++], ureq->req_buffer, ret);
+		video->payload_size += ret;
+		len -= ret;
+	}
+
+	/* Process video data. */
+	len = min((int)(video->max_payload_size - video->payload_size), len);
+	ret = uvc_video_encode_data_sg(video, buf, ureq, &nents, len);
+
+	video->payload_size += ret;
+	len -= ret;
+
+	req->length = video->req_size - len;
+	req->zero = video->payload_size == video->max_payload_size;
+
+	if (buf->bytesused == video->queue.buf_used || !buf->sg) {
+		video->queue.buf_used = 0;
+		buf->state = UVC_BUF_STATE_DONE;
+		uvcg_queue_next_buffer(&video->queue, buf);
+		video->fid ^= UVC_STREAM_FID;
+
+		video->payload_size = 0;
+		req->zero = 1;
+	}
+
+	if (video->payload_size == video->max_payload_size ||
+	    buf->bytesused == video->queue.buf_used)
+		video->payload_size = 0;
+
+	if (nents)
+		sg_mark_end(&ureq->sg[nents - 1]);
+	req->sg = ureq->sg;
+	req->num_sgs = nents;
+}
+
+static void
+uvc_video_encode_isoc_sg(struct usb_request *req, struct uvc_video *video,
+		struct uvc_buffer *buf)
+{
+	struct uvc_request *ureq = req->context;
+	unsigned int nents = 0;
+	int len = video->req_size;
+	int ret;
+
+	sg_init_table(ureq->sg, ureq->sg_nents);
+
+	/* Add the header. */
+	ret = uvc_video_encode_header(video, buf, ureq->req_buffer, len);
+	sg_set_buf(&ureq->sg[nents++], ureq->req_buffer, ret);
+	len -= ret;
+
+	/* Process video data. */
+	ret = uvc_video_encode_data_sg(video, buf, ureq, &nents, len);
+	len -= ret;
+
+	req->length = video->req_size - len;
+
+	if (buf->bytesused == video->queue.buf_used || !buf->sg) {
+		video->queue.buf_used = 0;
+		buf->state = UVC_BUF_STATE_DONE;
+		uvcg_queue_next_buffer(&video->queue, buf);
+		video->fid ^= UVC_STREAM_FID;
+	}
+
+	sg_mark_end(&ureq->sg[nents - 1]);
+	req->sg = ureq->sg;
+	req->num_sgs = nents;
+}
+
 /* --------------------------------------------------------------------------
  * Request handling
  */
@@ -269,6 +390,9 @@ uvc_video_free_requests(struct uvc_video *video)
 				kfree(video->ureq[i].req_buffer);
 				video->ureq[i].req_buffer = NULL;
 			}
+
+			kfree(video->ureq[i].sg);
+			video->ureq[i].sg = NULL;
 		}
 
 		kfree(video->ureq);
@@ -311,6 +435,20 @@ uvc_video_alloc_requests(struct uvc_video *video)
 		if (video->ureq[i].req == NULL)
 			goto error;
 
+		if (video->queue.use_sg) {
+			/*
+			 * One entry for the header, then the payload may start
+			 * and end in the middle of a page.
+			 */
+			video->ureq[i].sg_nents =
+				DIV_ROUND_UP(req_size, PAGE_SIZE) + 2;
+			video->ureq[i].sg = kcalloc(video->ureq[i].sg_nents,
+						    sizeof(struct scatterlist),
+						    GFP_KERNEL);
+			if (video->ureq[i].sg == NULL)
+				goto error;
+		}
+
 		video->ureq[i].req->buf = video->ureq[i].req_buffer;
 		video->ureq[i].req->length = 0;
 		video->ureq[i].req->complete = uvc_video_complete;
@@ -441,10 +579,12 @@ int uvcg_video_enable(struct uvc_video *video, int enable)
 		return ret;
 
 	if (video->max_payload_size) {
-		video->encode = uvc_video_encode_bulk;
+		video->encode = video->queue.use_sg ?
+				uvc_video_encode_bulk_sg : uvc_video_encode_bulk;
 		video->payload_size = 0;
 	} else
-		video->encode = uvc_video_encode_isoc;
+		video->encode = video->queue.use_sg ?
+				uvc_video_encode_isoc_sg : uvc_video_encode_isoc;
 
 	schedule_work(&video->pump);
 
@@ -456,6 +596,16 @@ int uvcg_video_enable(struct uvc_video *video, int enable)
  */
 int uvcg_video_init(struct uvc_video *video, struct uvc_device *uvc)
 {
+	struct usb_gadget *gadget = uvc->func.config->cdev->gadget;
+	bool use_sg = gadget->sg_supported;
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+	struct f_uvc_opts *opts = fi_to_f_uvc_opts(uvc->func.fi);
+
+	/* uvc_zero_copy expects the headers to be laid out by userspace */
+	if (opts->uvc_zero_copy)
+		use_sg = false;
+#endif
+
 	INIT_LIST_HEAD(&video->req_free);
 	spin_lock_init(&video->req_lock);
 	INIT_WORK(&video->pump, uvcg_video_pump);
@@ -468,8 +618,8 @@ int uvcg_video_init(struct uvc_video *video, struct uvc_device *uvc)
 	video->imagesize = 320 * 240 * 2;
 
 	/* Initialize the video buffers queue. */
-	uvcg_queue_init(&video->queue, V4L2_BUF_TYPE_VIDEO_OUTPUT,
-			&video->mutex);
+	uvcg_queue_init(&video->queue, gadget->dev.parent,
+			V4L2_BUF_TYPE_VIDEO_OUTPUT, &video->mutex, use_sg);
 	return 0;
 }
 
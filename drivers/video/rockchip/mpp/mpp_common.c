@@ -13,6 +13,7 @@
 
 #include <linux/clk.h>
 #include <linux/delay.h>
+#include <linux/file.h>
 #include <linux/interrupt.h>
 #include <linux/iopoll.h>
 #include <linux/module.h>
@@ -27,10 +28,13 @@
 #include <linux/mfd/syscon.h>
 #include <linux/seq_file.h>
 #include <linux/slab.h>
+#include <linux/sync_file.h>
 #include <linux/uaccess.h>
 #include <linux/nospec.h>
+#include <linux/vmalloc.h>
 
 #include <soc/rockchip/pm_domains.h>
+#include <trace/events/dma_fence.h>
 
 #include "mpp_debug.h"
 #include "mpp_common.h"
@@ -43,6 +47,7 @@
 
 #define MPP_IOC_CFG_V1	_IOW(MPP_IOC_MAGIC, 1, unsigned int)
 #define MPP_IOC_CFG_V2	_IOW(MPP_IOC_MAGIC, 2, unsigned int)
+#define MPP_IOC_RING_V1	_IOW(MPP_IOC_MAGIC, 3, unsigned int)
 
 /* input parmater structure for version 1 */
 struct mpp_msg_v1 {
@@ -61,6 +66,45 @@ struct mpp_bat_msg {
 	__s32 ret;
 };
 
+/*
+ * Command ring, one page mmap()ed from the session fd at offset 0.
+ *
+ * Userspace writes struct mpp_msg_v1 entries at sq[sq_tail % entries],
+ * grouped exactly as for MPP_IOC_CFG_V1 (MULTI_MSG ... LAST_MSG), then
+ * advances sq_tail and issues MPP_IOC_RING_V1. The kernel consumes the
+ * groups, advances sq_head and posts one completion per group at
+ * cq[cq_tail % entries]. A single call can thus submit one frame and
+ * poll the previous one, and the message headers are never copied from
+ * userspace. The register payloads are still read from data_ptr.
+ */
+#define MPP_RING_MAGIC			(0x4d505252)	/* "MPRR" */
+#define MPP_RING_ENTRIES		(64)
+
+struct mpp_ring_cqe {
+	__u32 sqe;	/* index of the first message of the group */
+	__s32 ret;
+};
+
+struct mpp_ring {
+	__u32 magic;
+	__u32 entries;
+	__u32 sq_head;	/* kernel */
+	__u32 sq_tail;	/* user */
+	__u32 cq_head;	/* user */
+	__u32 cq_tail;	/* kernel */
+	__u32 reserved[2];
+	struct mpp_msg_v1 sq[MPP_RING_ENTRIES];
+	struct mpp_ring_cqe cq[MPP_RING_ENTRIES];
+};
+
+/* where mpp_collect_msgs() takes its messages from */
+struct mpp_msg_src {
+	void __user *usr;
+	struct mpp_ring *ring;
+	u32 pos;
+	u32 end;
+};
+
 #ifdef CONFIG_ROCKCHIP_MPP_PROC_FS
 const char *mpp_device_name[MPP_DEVICE_BUTT] = {
 	[MPP_DEVICE_VDPU1]		= "VDPU1",
@@ -96,6 +140,84 @@ const char *enc_info_item_name[ENC_INFO_BUTT] = {
 
 #endif
 
+/*
+ * Out fence of a task, so that the output can be handed to the next
+ * block without a round trip through userspace, e.g. a jpeg decoded
+ * by jpgdec straight into an rga scale job via its in_fence_fd.
+ */
+struct mpp_fence {
+	struct dma_fence base;
+	spinlock_t lock;
+};
+
+static const char *mpp_fence_get_driver_name(struct dma_fence *fence)
+{
+	return "mpp_service";
+}
+
+static const char *mpp_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return "mpp_task";
+}
+
+static const struct dma_fence_ops mpp_fence_ops = {
+	.get_driver_name = mpp_fence_get_driver_name,
+	.get_timeline_name = mpp_fence_get_timeline_name,
+};
+
+static void mpp_task_signal_fence(struct mpp_task *task, int error)
+{
+	struct dma_fence *fence = xchg(&task->out_fence, NULL);
+
+	if (!fence)
+		return;
+
+	if (error)
+		dma_fence_set_error(fence, error);
+	dma_fence_signal(fence);
+	dma_fence_put(fence);
+}
+
+/* Returns the sync_file fd of the new fence or a negative error. */
+static int mpp_task_attach_fence(struct mpp_task *task)
+{
+	struct mpp_fence *f;
+	struct sync_file *sync_file;
+	int fd;
+
+	f = kzalloc(sizeof(*f), GFP_KERNEL);
+	if (!f)
+		return -ENOMEM;
+
+	spin_lock_init(&f->lock);
+	/* tasks of a queue may finish out of order on multi-core */
+	dma_fence_init(&f->base, &mpp_fence_ops, &f->lock,
+		       dma_fence_context_alloc(1), task->task_id);
+
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0) {
+		dma_fence_put(&f->base);
+		return fd;
+	}
+
+	sync_file = sync_file_create(&f->base);
+	if (!sync_file) {
+		put_unused_fd(fd);
+		dma_fence_put(&f->base);
+		return -ENOMEM;
+	}
+
+	trace_dma_fence_producer(&f->base,
+				 mpp_device_name[task->session->device_type],
+				 task->task_id);
+
+	/* the sync_file holds its own reference, keep ours for the task */
+	task->out_fence = &f->base;
+	fd_install(fd, sync_file->file);
+
+	return fd;
+}
+
 static void mpp_attach_workqueue(struct mpp_dev *mpp,
 				 struct mpp_taskqueue *queue);
 
@@ -231,6 +353,7 @@ static void task_msgs_reset(struct mpp_task_msgs *msgs)
 	msgs->req_cnt = 0;
 	msgs->set_cnt = 0;
 	msgs->poll_cnt = 0;
+	msgs->fence_req = NULL;
 }
 
 static void task_msgs_init(struct mpp_task_msgs *msgs, struct mpp_session *session)
@@ -391,6 +514,8 @@ static struct mpp_session *mpp_session_init(void)
 
 	mutex_init(&session->pending_lock);
 	INIT_LIST_HEAD(&session->pending_list);
+	init_waitqueue_head(&session->poll_wait);
+	mutex_init(&session->ring_lock);
 	INIT_LIST_HEAD(&session->service_link);
 	INIT_LIST_HEAD(&session->session_link);
 
@@ -445,6 +570,7 @@ void mpp_session_deinit(struct mpp_session *session)
 		pr_err("invalid NULL session deinit function\n");
 
 	clear_task_msgs(session);
+	vfree(session->ring);
 
 	kfree(session);
 }
@@ -537,6 +663,9 @@ void mpp_free_task(struct kref *ref)
 		       session->index, task->task_id, task->state,
 		       atomic_read(&task->abort_request));
 
+	/* never ran, e.g. session reset or released with it pending */
+	mpp_task_signal_fence(task, -ECANCELED);
+
 	mpp = mpp_get_task_used_device(task, session);
 	if (mpp->dev_ops->free_task)
 		mpp->dev_ops->free_task(session, task);
@@ -591,8 +720,10 @@ static void mpp_task_timeout_work(struct work_struct *work_s)
 
 	set_bit(TASK_STATE_TIMEOUT, &task->state);
 	set_bit(TASK_STATE_DONE, &task->state);
+	mpp_task_signal_fence(task, -ETIMEDOUT);
 	/* Wake up the GET thread */
 	wake_up(&task->wait);
+	wake_up_poll(&session->poll_wait, EPOLLIN | EPOLLRDNORM);
 
 	/* remove task from taskqueue running list */
 	mpp_taskqueue_pop_running(mpp->queue, task);
@@ -852,14 +983,17 @@ static int mpp_task_run(struct mpp_dev *mpp,
 	return 0;
 }
 
-static void mpp_task_worker_default(struct kthread_work *work_s)
+/*
+ * Move pending tasks of the queue to the hardware while it accepts them.
+ * Runs from the queue worker, and from the isr thread of devices that
+ * set isr_run_next so that the next task starts without a worker hop.
+ */
+static void mpp_taskqueue_run_pending(struct mpp_taskqueue *queue)
 {
 	struct mpp_task *task;
-	struct mpp_dev *mpp = container_of(work_s, struct mpp_dev, work);
-	struct mpp_taskqueue *queue = mpp->queue;
-
-	mpp_debug_enter();
+	struct mpp_dev *mpp;
 
+	mutex_lock(&queue->run_lock);
 again:
 	task = mpp_taskqueue_get_pending_task(queue);
 	if (!task)
@@ -905,6 +1039,17 @@ static void mpp_task_worker_default(struct kthread_work *work_s)
 	}
 
 done:
+	mutex_unlock(&queue->run_lock);
+}
+
+static void mpp_task_worker_default(struct kthread_work *work_s)
+{
+	struct mpp_dev *mpp = container_of(work_s, struct mpp_dev, work);
+	struct mpp_taskqueue *queue = mpp->queue;
+
+	mpp_debug_enter();
+
+	mpp_taskqueue_run_pending(queue);
 	mpp_session_cleanup_detach(queue, work_s);
 }
 
@@ -1029,6 +1174,7 @@ struct mpp_taskqueue *mpp_taskqueue_init(struct device *dev)
 
 	mutex_init(&queue->session_lock);
 	mutex_init(&queue->pending_lock);
+	mutex_init(&queue->run_lock);
 	spin_lock_init(&queue->running_lock);
 	mutex_init(&queue->mmu_lock);
 	mutex_init(&queue->dev_lock);
@@ -1304,6 +1450,12 @@ static int mpp_process_request(struct mpp_session *session,
 		msgs->flags |= req->flags;
 		msgs->set_cnt++;
 	} break;
+	case MPP_CMD_SET_OUT_FENCE: {
+		/* must come with the set messages of the task it belongs to */
+		if (req->size < sizeof(s32) || !req->data)
+			return -EINVAL;
+		msgs->fence_req = req;
+	} break;
 	case MPP_CMD_POLL_HW_FINISH: {
 		msgs->flags |= req->flags;
 		msgs->poll_cnt++;
@@ -1435,6 +1587,18 @@ static void task_msgs_add(struct mpp_task_msgs *msgs, struct list_head *head)
 		/* NOTE: update msg_flags for fd over 1024 */
 		session->msg_flags = msgs->flags;
 		ret = mpp_process_task(session, msgs);
+
+		/*
+		 * The task is not in the taskqueue before mpp_msgs_trigger,
+		 * so the fence can not be missed. An error goes back in place
+		 * of the fd, the task itself still runs.
+		 */
+		if (!ret && msgs->fence_req && msgs->task) {
+			int fd = mpp_task_attach_fence(msgs->task);
+
+			if (put_user(fd, (s32 __user *)msgs->fence_req->data))
+				mpp_err("copy_to_user fence fd failed\n");
+		}
 	}
 
 	if (!ret) {
@@ -1445,8 +1609,26 @@ static void task_msgs_add(struct mpp_task_msgs *msgs, struct list_head *head)
 	}
 }
 
+static int mpp_fetch_msg(struct mpp_msg_src *src, struct mpp_msg_v1 *msg)
+{
+	if (src->ring) {
+		if (src->pos == src->end)
+			return -EINVAL;
+
+		memcpy(msg, &src->ring->sq[src->pos++ % MPP_RING_ENTRIES],
+		       sizeof(*msg));
+		return 0;
+	}
+
+	if (copy_from_user(msg, src->usr, sizeof(*msg)))
+		return -EFAULT;
+
+	src->usr += sizeof(*msg);
+	return 0;
+}
+
 static int mpp_collect_msgs(struct list_head *head, struct mpp_session *session,
-			    unsigned int cmd, void __user *msg)
+			    struct mpp_msg_src *src)
 {
 	struct mpp_msg_v1 msg_v1;
 	struct mpp_request *req;
@@ -1454,17 +1636,11 @@ static int mpp_collect_msgs(struct list_head *head, struct mpp_session *session,
 	int last = 1;
 	int ret;
 
-	if (cmd != MPP_IOC_CFG_V1) {
-		mpp_err("unknown ioctl cmd %x\n", cmd);
-		return -EINVAL;
-	}
-
 next:
 	/* first, parse to fixed struct */
-	if (copy_from_user(&msg_v1, msg, sizeof(msg_v1)))
-		return -EFAULT;
-
-	msg += sizeof(msg_v1);
+	ret = mpp_fetch_msg(src, &msg_v1);
+	if (ret)
+		return ret;
 
 	mpp_debug(DEBUG_IOCTL, "cmd %x collect flags %08x, size %d, offset %x\n",
 		  msg_v1.cmd, msg_v1.flags, msg_v1.size, msg_v1.offset);
@@ -1641,10 +1817,73 @@ static void mpp_msgs_wait(struct list_head *msgs_list)
 	}
 }
 
+/*
+ * Consume the message groups queued in the session command ring, in the
+ * same way as one MPP_IOC_CFG_V1 ioctl each. Returns the number of
+ * completions posted. The rest of the ring is dropped on a parse error.
+ */
+static int mpp_ring_enter(struct mpp_session *session)
+{
+	struct mpp_ring *ring;
+	struct list_head msgs_list;
+	struct mpp_msg_src src = { 0 };
+	u32 head, tail, cq_tail;
+	int done = 0, ret;
+
+	mutex_lock(&session->ring_lock);
+	ring = session->ring;
+	if (!ring) {
+		mutex_unlock(&session->ring_lock);
+		return -ENXIO;
+	}
+
+	head = ring->sq_head;
+	tail = smp_load_acquire(&ring->sq_tail);
+	if (tail - head > MPP_RING_ENTRIES) {
+		mutex_unlock(&session->ring_lock);
+		return -EINVAL;
+	}
+
+	src.ring = ring;
+	src.end = tail;
+	cq_tail = ring->cq_tail;
+
+	while (head != tail) {
+		/* keep room for the completion of this group */
+		if (cq_tail - smp_load_acquire(&ring->cq_head) >= MPP_RING_ENTRIES)
+			break;
+
+		INIT_LIST_HEAD(&msgs_list);
+		src.pos = head;
+		ret = mpp_collect_msgs(&msgs_list, session, &src);
+		if (ret) {
+			mpp_err("collect ring msgs failed %d\n", ret);
+			src.pos = tail;
+		}
+
+		mpp_msgs_trigger(&msgs_list);
+		mpp_msgs_wait(&msgs_list);
+
+		ring->cq[cq_tail % MPP_RING_ENTRIES].sqe = head;
+		ring->cq[cq_tail % MPP_RING_ENTRIES].ret = ret;
+		smp_store_release(&ring->cq_tail, ++cq_tail);
+		head = src.pos;
+		done++;
+	}
+
+	smp_store_release(&ring->sq_head, head);
+	mutex_unlock(&session->ring_lock);
+
+	wake_up_poll(&session->poll_wait, EPOLLIN | EPOLLRDNORM);
+
+	return done;
+}
+
 static long mpp_dev_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 {
 	struct mpp_service *srv;
 	struct mpp_session *session = (struct mpp_session *)filp->private_data;
+	struct mpp_msg_src src = { 0 };
 	struct list_head msgs_list;
 	int ret = 0;
 
@@ -1666,9 +1905,18 @@ static long mpp_dev_ioctl(struct file *filp, unsigned int cmd, unsigned long arg
 		return -EBUSY;
 	}
 
+	if (cmd == MPP_IOC_RING_V1)
+		return mpp_ring_enter(session);
+
+	if (cmd != MPP_IOC_CFG_V1) {
+		mpp_err("unknown ioctl cmd %x\n", cmd);
+		return -EINVAL;
+	}
+
 	INIT_LIST_HEAD(&msgs_list);
 
-	ret = mpp_collect_msgs(&msgs_list, session, cmd, (void __user *)arg);
+	src.usr = (void __user *)arg;
+	ret = mpp_collect_msgs(&msgs_list, session, &src);
 	if (ret)
 		mpp_err("collect msgs failed %d\n", ret);
 
@@ -1681,6 +1929,35 @@ static long mpp_dev_ioctl(struct file *filp, unsigned int cmd, unsigned long arg
 	return ret;
 }
 
+static int mpp_dev_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct mpp_session *session = filp->private_data;
+	struct mpp_ring *ring;
+	int ret;
+
+	if (!session || vma->vm_pgoff ||
+	    vma->vm_end - vma->vm_start != PAGE_ALIGN(sizeof(*ring)))
+		return -EINVAL;
+
+	mutex_lock(&session->ring_lock);
+	ring = session->ring;
+	if (!ring) {
+		ring = vmalloc_user(PAGE_ALIGN(sizeof(*ring)));
+		if (!ring) {
+			ret = -ENOMEM;
+			goto out;
+		}
+		ring->magic = MPP_RING_MAGIC;
+		ring->entries = MPP_RING_ENTRIES;
+		session->ring = ring;
+	}
+	ret = remap_vmalloc_range(vma, ring, 0);
+out:
+	mutex_unlock(&session->ring_lock);
+
+	return ret;
+}
+
 static int mpp_dev_open(struct inode *inode, struct file *filp)
 {
 	struct mpp_session *session = NULL;
@@ -1735,9 +2012,43 @@ static int mpp_dev_release(struct inode *inode, struct file *filp)
 	return 0;
 }
 
+/*
+ * The session fd polls readable once the oldest pending task is done, or
+ * when the device can already return part of it (e.g. encoded slices),
+ * so that the next MPP_CMD_POLL_HW_* command returns without blocking.
+ */
+static __poll_t mpp_dev_poll(struct file *filp, poll_table *wait)
+{
+	struct mpp_session *session = filp->private_data;
+	struct mpp_task *task;
+	__poll_t mask = 0;
+
+	if (!session)
+		return EPOLLERR;
+
+	poll_wait(filp, &session->poll_wait, wait);
+
+	mutex_lock(&session->pending_lock);
+	task = list_first_entry_or_null(&session->pending_list,
+					struct mpp_task, pending_link);
+	if (task) {
+		struct mpp_dev *mpp = session->mpp;
+
+		if (test_bit(TASK_STATE_DONE, &task->state) ||
+		    (mpp && mpp->dev_ops->poll_ready &&
+		     mpp->dev_ops->poll_ready(session, task)))
+			mask = EPOLLIN | EPOLLRDNORM;
+	}
+	mutex_unlock(&session->pending_lock);
+
+	return mask;
+}
+
 const struct file_operations rockchip_mpp_fops = {
 	.open		= mpp_dev_open,
 	.release	= mpp_dev_release,
+	.poll		= mpp_dev_poll,
+	.mmap		= mpp_dev_mmap,
 	.unlocked_ioctl = mpp_dev_ioctl,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl   = mpp_dev_ioctl,
@@ -1954,6 +2265,7 @@ int mpp_task_init(struct mpp_session *session, struct mpp_task *task)
 	task->state = 0;
 	task->mem_count = 0;
 	task->session = session;
+	task->out_fence = NULL;
 
 	return 0;
 }
@@ -1973,6 +2285,7 @@ int mpp_task_finish(struct mpp_session *session,
 
 	set_bit(TASK_STATE_FINISH, &task->state);
 	set_bit(TASK_STATE_DONE, &task->state);
+	mpp_task_signal_fence(task, 0);
 
 	if (session->srv->timing_en) {
 		s64 time_diff;
@@ -1988,6 +2301,7 @@ int mpp_task_finish(struct mpp_session *session,
 
 	/* Wake up the GET thread */
 	wake_up(&task->wait);
+	wake_up_poll(&session->poll_wait, EPOLLIN | EPOLLRDNORM);
 	mpp_taskqueue_pop_running(mpp->queue, task);
 
 	return 0;
@@ -2314,6 +2628,16 @@ irqreturn_t mpp_dev_isr_sched(int irq, void *param)
 	if (mpp->dev_ops->isr)
 		ret = mpp->dev_ops->isr(mpp);
 
+	/*
+	 * start the next task right here, the worker is then only needed
+	 * for detached sessions
+	 */
+	if (mpp->isr_run_next) {
+		mpp_taskqueue_run_pending(mpp->queue);
+		if (!atomic_read(&mpp->queue->detach_count))
+			return ret;
+	}
+
 	/* trigger current queue to run next task */
 	mpp_taskqueue_trigger_work(mpp);
 
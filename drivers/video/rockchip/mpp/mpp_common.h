@@ -14,6 +14,7 @@
 #include <linux/cdev.h>
 #include <linux/clk.h>
 #include <linux/dma-buf.h>
+#include <linux/dma-fence.h>
 #include <linux/kfifo.h>
 #include <linux/types.h>
 #include <linux/time.h>
@@ -115,6 +116,7 @@ enum MPP_DEV_COMMAND_TYPE {
 	MPP_CMD_SET_REG_ADDR_OFFSET	= MPP_CMD_SEND_BASE + 2,
 	MPP_CMD_SET_RCB_INFO		= MPP_CMD_SEND_BASE + 3,
 	MPP_CMD_SET_SESSION_FD		= MPP_CMD_SEND_BASE + 4,
+	MPP_CMD_SET_OUT_FENCE		= MPP_CMD_SEND_BASE + 5,
 	MPP_CMD_SEND_BUTT,
 
 	MPP_CMD_POLL_BASE		= 0x300,
@@ -196,6 +198,8 @@ struct mpp_taskqueue;
 struct iommu_domain;
 
 /* data common struct for parse out */
+struct mpp_ring;
+
 struct mpp_request {
 	__u32 cmd;
 	__u32 flags;
@@ -226,6 +230,7 @@ struct mpp_task_msgs {
 
 	struct mpp_request reqs[MPP_MAX_MSG_NUM];
 	struct mpp_request *poll_req;
+	struct mpp_request *fence_req;
 };
 
 struct mpp_grf_info {
@@ -370,6 +375,11 @@ struct mpp_dev {
 	/* common per-device procfs */
 	u32 disable;
 	u32 timing_check;
+	/*
+	 * start the next pending task from the isr thread, for devices whose
+	 * queue is served by the default worker
+	 */
+	u32 isr_run_next;
 };
 
 struct mpp_session {
@@ -384,6 +394,11 @@ struct mpp_session {
 	struct mutex pending_lock;
 	/* task pending list in session */
 	struct list_head pending_list;
+	/* poll() on the session fd, woken when a task has results */
+	wait_queue_head_t poll_wait;
+	/* mmap()ed command ring and the lock serializing its users */
+	struct mpp_ring *ring;
+	struct mutex ring_lock;
 
 	pid_t pid;
 	atomic_t task_count;
@@ -499,6 +514,8 @@ struct mpp_task {
 	s32 core_id;
 	/* hw cycles */
 	u32 hw_cycles;
+	/* signaled when the task is done, for MPP_CMD_SET_OUT_FENCE */
+	struct dma_fence *out_fence;
 };
 
 struct mpp_taskqueue {
@@ -519,6 +536,8 @@ struct mpp_taskqueue {
 	/* lock for pending list */
 	struct mutex pending_lock;
 	struct list_head pending_list;
+	/* serializes moving pending tasks to the hardware */
+	struct mutex run_lock;
 	/* lock for running list */
 	spinlock_t running_lock;
 	struct list_head running_list;
@@ -651,6 +670,8 @@ struct mpp_dev_ops {
 	int (*free_session)(struct mpp_session *session);
 	int (*dump_session)(struct mpp_session *session, struct seq_file *seq);
 	int (*dump_dev)(struct mpp_dev *mpp);
+	/* whether part of an unfinished task can already be read */
+	bool (*poll_ready)(struct mpp_session *session, struct mpp_task *task);
 };
 
 struct mpp_taskqueue *mpp_taskqueue_init(struct device *dev);
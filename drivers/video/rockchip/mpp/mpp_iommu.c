@@ -28,29 +28,36 @@
 #include "mpp_iommu.h"
 #include "mpp_common.h"
 
+/* Must be called with list_mutex held */
+static struct mpp_dma_buffer *
+mpp_dma_find_buffer(struct mpp_dma_session *dma, struct dma_buf *dmabuf)
+{
+	struct mpp_dma_buffer *buffer = NULL;
+
+	list_for_each_entry(buffer, &dma->used_list, link) {
+		/*
+		 * fd may dup several and point the same dambuf.
+		 * thus, here should be distinguish with the dmabuf.
+		 */
+		if (buffer->dmabuf == dmabuf)
+			return buffer;
+	}
+
+	return NULL;
+}
+
 struct mpp_dma_buffer *
 mpp_dma_find_buffer_fd(struct mpp_dma_session *dma, int fd)
 {
 	struct dma_buf *dmabuf;
 	struct mpp_dma_buffer *out = NULL;
-	struct mpp_dma_buffer *buffer = NULL, *n;
 
 	dmabuf = dma_buf_get(fd);
 	if (IS_ERR(dmabuf))
 		return NULL;
 
 	mutex_lock(&dma->list_mutex);
-	list_for_each_entry_safe(buffer, n,
-				 &dma->used_list, link) {
-		/*
-		 * fd may dup several and point the same dambuf.
-		 * thus, here should be distinguish with the dmabuf.
-		 */
-		if (buffer->dmabuf == dmabuf) {
-			out = buffer;
-			break;
-		}
-	}
+	out = mpp_dma_find_buffer(dma, dmabuf);
 	mutex_unlock(&dma->list_mutex);
 	dma_buf_put(dmabuf);
 
@@ -80,29 +87,38 @@ static void mpp_dma_release_buffer(struct kref *ref)
 	buffer->last_used = 0;
 }
 
-/* Remove the oldest buffer when count more than the setting */
+/*
+ * A buffer is idle when no task holds it, only the reference kept by the
+ * session to cache its mapping is left. With CONFIG_DMABUF_CACHE the
+ * mapping is cached by dma-buf-cache instead and there is no such
+ * reference, so a buffer on the used list is never idle.
+ */
+static bool mpp_dma_buffer_idle(struct mpp_dma_buffer *buffer)
+{
+	return !IS_ENABLED(CONFIG_DMABUF_CACHE) &&
+	       kref_read(&buffer->ref) <= 1;
+}
+
+/*
+ * The used list is kept in LRU order, most recently imported first.
+ * Drop the idle buffers userspace has released, the session being the
+ * last one holding their dmabuf they can never be imported again, then
+ * the least recently used ones while count is more than the setting.
+ */
 static int
 mpp_dma_remove_extra_buffer(struct mpp_dma_session *dma)
 {
-	struct mpp_dma_buffer *n;
-	struct mpp_dma_buffer *oldest = NULL, *buffer = NULL;
-	ktime_t oldest_time = ktime_set(0, 0);
-
-	if (dma->buffer_count > dma->max_buffers) {
-		mutex_lock(&dma->list_mutex);
-		list_for_each_entry_safe(buffer, n,
-					 &dma->used_list,
-					 link) {
-			if (ktime_to_ns(oldest_time) == 0 ||
-			    ktime_after(oldest_time, buffer->last_used)) {
-				oldest_time = buffer->last_used;
-				oldest = buffer;
-			}
-		}
-		if (oldest && kref_read(&oldest->ref) <= 1)
-			kref_put(&oldest->ref, mpp_dma_release_buffer);
-		mutex_unlock(&dma->list_mutex);
+	struct mpp_dma_buffer *n, *buffer = NULL;
+
+	mutex_lock(&dma->list_mutex);
+	list_for_each_entry_safe_reverse(buffer, n, &dma->used_list, link) {
+		if (!mpp_dma_buffer_idle(buffer))
+			continue;
+		if (dma->buffer_count > dma->max_buffers ||
+		    file_count(buffer->dmabuf->file) == 1)
+			kref_put(&buffer->ref, mpp_dma_release_buffer);
 	}
+	mutex_unlock(&dma->list_mutex);
 
 	return 0;
 }
@@ -193,24 +209,28 @@ struct mpp_dma_buffer *mpp_dma_import_fd(struct mpp_iommu_info *iommu_info,
 	/* remove the oldest before add buffer */
 	mpp_dma_remove_extra_buffer(dma);
 
-	/* Check whether in dma session */
-	buffer = mpp_dma_find_buffer_fd(dma, fd);
-	if (!IS_ERR_OR_NULL(buffer)) {
+	dmabuf = dma_buf_get(fd);
+	if (IS_ERR(dmabuf)) {
+		ret = PTR_ERR(dmabuf);
+		mpp_err("dma_buf_get fd %d failed(%d)\n", fd, ret);
+		return ERR_PTR(ret);
+	}
+
+	/* Check whether in dma session, reuse its mapping if so */
+	mutex_lock(&dma->list_mutex);
+	buffer = mpp_dma_find_buffer(dma, dmabuf);
+	if (buffer) {
 		if (kref_get_unless_zero(&buffer->ref)) {
 			buffer->last_used = ktime_get();
+			list_move(&buffer->link, &dma->used_list);
+			mutex_unlock(&dma->list_mutex);
+			dma_buf_put(dmabuf);
 			return buffer;
 		}
 		dev_dbg(dma->dev, "missing the fd %d\n", fd);
 	}
 
-	dmabuf = dma_buf_get(fd);
-	if (IS_ERR(dmabuf)) {
-		ret = PTR_ERR(dmabuf);
-		mpp_err("dma_buf_get fd %d failed(%d)\n", fd, ret);
-		return ERR_PTR(ret);
-	}
 	/* A new DMA buffer */
-	mutex_lock(&dma->list_mutex);
 	buffer = list_first_entry_or_null(&dma->unused_list,
 					   struct mpp_dma_buffer,
 					   link);
@@ -253,7 +273,7 @@ struct mpp_dma_buffer *mpp_dma_import_fd(struct mpp_iommu_info *iommu_info,
 
 	mutex_lock(&dma->list_mutex);
 	dma->buffer_count++;
-	list_add_tail(&buffer->link, &dma->used_list);
+	list_add(&buffer->link, &dma->used_list);
 	mutex_unlock(&dma->list_mutex);
 
 	return buffer;
@@ -231,6 +231,12 @@ struct rkvenc_task {
 	/* jpege bitstream */
 	struct mpp_dma_buffer *bs_buf;
 	u32 offset_bs;
+
+	/* timestamps for the session timing histograms */
+	ktime_t on_queue;
+	ktime_t on_hw_start;
+	ktime_t on_hw_done;
+	bool hist_done;
 };
 
 #define RKVENC_MAX_RCB_NUM		(4)
@@ -245,8 +251,33 @@ struct rkvenc2_rcb_info {
 	struct rcb_info_elem elem[RKVENC_MAX_RCB_NUM];
 };
 
+/* log2 buckets in us, the last one also counts everything above */
+#define RKVENC_HIST_BUCKETS		(20)
+
+enum RKVENC_HIST_TYPE {
+	RKVENC_HIST_WAIT,	/* task queued to rkvenc_run */
+	RKVENC_HIST_HW,		/* rkvenc_run to rkvenc_irq */
+	RKVENC_HIST_RESULT,	/* rkvenc_irq to result returned to user */
+	RKVENC_HIST_BUTT,
+};
+
+static const char * const rkvenc_hist_name[RKVENC_HIST_BUTT] = {
+	[RKVENC_HIST_WAIT] = "wait",
+	[RKVENC_HIST_HW] = "hw",
+	[RKVENC_HIST_RESULT] = "result",
+};
+
+struct rkvenc2_hist {
+	u32 cnt[RKVENC_HIST_BUCKETS];
+	u32 total;
+	u32 max_us;
+	u64 sum_us;
+};
+
 struct rkvenc2_session_priv {
 	struct rw_semaphore rw_sem;
+	/* per task timing, protected by rw_sem */
+	struct rkvenc2_hist hist[RKVENC_HIST_BUTT];
 	/* codec info from user */
 	struct {
 		/* show mode */
@@ -966,6 +997,7 @@ static void *rkvenc_alloc_task(struct mpp_session *session,
 	rkvenc2_setup_task_id(session->index, task);
 	task->clk_mode = CLK_MODE_NORMAL;
 	rkvenc2_check_split_task(task);
+	task->on_queue = ktime_get();
 
 	mpp_debug_leave();
 
@@ -1239,6 +1271,7 @@ static int rkvenc_run(struct mpp_dev *mpp, struct mpp_task *mpp_task)
 	/* Flush the register before the start the device */
 	wmb();
 
+	task->on_hw_start = ktime_get();
 	mpp_write(mpp, enc->hw_info->enc_start_base, start_val);
 
 	mpp_task_run_end(mpp_task, timing_en);
@@ -1305,8 +1338,12 @@ static int rkvenc_irq(struct mpp_dev *mpp)
 
 	if (mpp->irq_status & INT_STA_ENC_DONE_STA) {
 		if (task) {
-			if (task->task_split)
+			task->on_hw_done = ktime_get();
+			if (task->task_split) {
 				rkvenc2_read_slice_len(mpp, task);
+				wake_up_poll(&mpp_task->session->poll_wait,
+					     EPOLLIN | EPOLLRDNORM);
+			}
 
 			wake_up(&mpp_task->wait);
 		}
@@ -1323,6 +1360,8 @@ static int rkvenc_irq(struct mpp_dev *mpp)
 
 			rkvenc2_read_slice_len(mpp, task);
 			wake_up(&mpp_task->wait);
+			wake_up_poll(&mpp_task->session->poll_wait,
+				     EPOLLIN | EPOLLRDNORM);
 		}
 
 		mpp_write(mpp, hw->int_clr_base, INT_STA_SLC_DONE_STA);
@@ -1427,6 +1466,38 @@ static int rkvenc_finish(struct mpp_dev *mpp, struct mpp_task *mpp_task)
 	return 0;
 }
 
+static void rkvenc2_hist_add(struct rkvenc2_hist *hist, s64 us)
+{
+	u32 val = clamp_t(s64, us, 0, U32_MAX);
+	u32 idx = min_t(u32, fls(val), RKVENC_HIST_BUCKETS - 1);
+
+	hist->cnt[idx]++;
+	hist->total++;
+	hist->sum_us += val;
+	hist->max_us = max(hist->max_us, val);
+}
+
+static void rkvenc2_update_hist(struct mpp_session *session,
+				struct rkvenc_task *task)
+{
+	struct rkvenc2_session_priv *priv = session->priv;
+	ktime_t now = ktime_get();
+
+	/* slice mode tasks and timed out tasks come back more than once */
+	if (!priv || task->hist_done || !task->on_hw_done)
+		return;
+	task->hist_done = true;
+
+	down_write(&priv->rw_sem);
+	rkvenc2_hist_add(&priv->hist[RKVENC_HIST_WAIT],
+			 ktime_us_delta(task->on_hw_start, task->on_queue));
+	rkvenc2_hist_add(&priv->hist[RKVENC_HIST_HW],
+			 ktime_us_delta(task->on_hw_done, task->on_hw_start));
+	rkvenc2_hist_add(&priv->hist[RKVENC_HIST_RESULT],
+			 ktime_us_delta(now, task->on_hw_done));
+	up_write(&priv->rw_sem);
+}
+
 static int rkvenc_result(struct mpp_dev *mpp,
 			 struct mpp_task *mpp_task,
 			 struct mpp_task_msgs *msgs)
@@ -1436,6 +1507,8 @@ static int rkvenc_result(struct mpp_dev *mpp,
 
 	mpp_debug_enter();
 
+	rkvenc2_update_hist(mpp_task->session, task);
+
 	for (i = 0; i < task->r_req_cnt; i++) {
 		struct mpp_request *req = &task->r_reqs[i];
 		u32 *reg = rkvenc_get_class_reg(task, req->offset);
@@ -1614,6 +1687,95 @@ static int rkvenc_show_session_info(struct seq_file *seq, void *offset)
 	return 0;
 }
 
+static void rkvenc_dump_session_timing(struct mpp_session *session,
+				       struct seq_file *seq)
+{
+	struct rkvenc2_session_priv *priv = session->priv;
+	u32 i, j, last;
+
+	down_read(&priv->rw_sem);
+	for (i = 0; i < RKVENC_HIST_BUTT; i++) {
+		struct rkvenc2_hist *hist = &priv->hist[i];
+
+		seq_printf(seq, "session %d %s: tasks %u avg %llu us max %u us\n",
+			   session->index, rkvenc_hist_name[i], hist->total,
+			   hist->total ? div_u64(hist->sum_us, hist->total) : 0,
+			   hist->max_us);
+		if (!hist->total)
+			continue;
+
+		for (last = RKVENC_HIST_BUCKETS - 1; last && !hist->cnt[last]; last--)
+			;
+		for (j = 0; j <= last; j++) {
+			if (j == RKVENC_HIST_BUCKETS - 1)
+				seq_printf(seq, "  >= %8u us %8u\n",
+					   1U << (j - 1), hist->cnt[j]);
+			else
+				seq_printf(seq, "  <  %8u us %8u\n",
+					   1U << j, hist->cnt[j]);
+		}
+	}
+	up_read(&priv->rw_sem);
+}
+
+static int rkvenc_show_session_timing(struct seq_file *seq, void *offset)
+{
+	struct mpp_session *session = NULL, *n;
+	struct mpp_dev *mpp = seq->private;
+
+	mutex_lock(&mpp->srv->session_lock);
+	list_for_each_entry_safe(session, n,
+				 &mpp->srv->session_list,
+				 service_link) {
+		if (session->device_type != MPP_DEVICE_RKVENC)
+			continue;
+		if (!session->priv)
+			continue;
+		rkvenc_dump_session_timing(session, seq);
+	}
+	mutex_unlock(&mpp->srv->session_lock);
+
+	return 0;
+}
+
+static int rkvenc_open_session_timing(struct inode *inode, struct file *file)
+{
+	return single_open(file, rkvenc_show_session_timing, PDE_DATA(inode));
+}
+
+/* any write clears the histograms of all sessions */
+static ssize_t rkvenc_reset_session_timing(struct file *file,
+					   const char __user *buf,
+					   size_t count, loff_t *ppos)
+{
+	struct seq_file *seq = file->private_data;
+	struct mpp_dev *mpp = seq->private;
+	struct mpp_session *session = NULL, *n;
+
+	mutex_lock(&mpp->srv->session_lock);
+	list_for_each_entry_safe(session, n,
+				 &mpp->srv->session_list,
+				 service_link) {
+		struct rkvenc2_session_priv *priv = session->priv;
+
+		if (session->device_type != MPP_DEVICE_RKVENC || !priv)
+			continue;
+		down_write(&priv->rw_sem);
+		memset(priv->hist, 0, sizeof(priv->hist));
+		up_write(&priv->rw_sem);
+	}
+	mutex_unlock(&mpp->srv->session_lock);
+
+	return count;
+}
+
+static const struct proc_ops rkvenc_procfs_timing_fops = {
+	.proc_open = rkvenc_open_session_timing,
+	.proc_read = seq_read,
+	.proc_release = single_release,
+	.proc_write = rkvenc_reset_session_timing,
+};
+
 static int rkvenc_procfs_init(struct mpp_dev *mpp)
 {
 	struct rkvenc_dev *enc = to_rkvenc_dev(mpp);
@@ -1643,9 +1805,14 @@ static int rkvenc_procfs_init(struct mpp_dev *mpp)
 			      enc->procfs, &enc->core_clk_info.debug_rate_hz);
 	mpp_procfs_create_u32("session_buffers", 0644,
 			      enc->procfs, &mpp->session_max_buffers);
+	mpp_procfs_create_u32("isr_run_next", 0644,
+			      enc->procfs, &mpp->isr_run_next);
 	/* for show session info */
 	proc_create_single_data("sessions-info", 0444,
 				enc->procfs, rkvenc_show_session_info, mpp);
+	/* per session timing histograms, write to reset */
+	proc_create_data("sessions-timing", 0644, enc->procfs,
+			 &rkvenc_procfs_timing_fops, mpp);
 
 	return 0;
 }
@@ -2090,6 +2257,14 @@ static int rkvenc2_wait_result(struct mpp_session *session,
 	return ret;
 }
 
+static bool rkvenc2_poll_ready(struct mpp_session *session,
+			       struct mpp_task *task)
+{
+	struct rkvenc_task *enc_task = to_rkvenc_task(task);
+
+	return enc_task->task_split && !kfifo_is_empty(&enc_task->slice_info);
+}
+
 static struct mpp_hw_ops rkvenc_hw_ops = {
 	.init = rkvenc_init,
 	.exit = rkvenc_exit,
@@ -2112,6 +2287,7 @@ static struct mpp_dev_ops rkvenc_dev_ops_v2 = {
 	.init_session = rkvenc_init_session,
 	.free_session = rkvenc_free_session,
 	.dump_session = rkvenc_dump_session,
+	.poll_ready = rkvenc2_poll_ready,
 };
 
 static struct mpp_dev_ops rkvenc_ccu_dev_ops = {
@@ -2128,6 +2304,7 @@ static struct mpp_dev_ops rkvenc_ccu_dev_ops = {
 	.init_session = rkvenc_init_session,
 	.free_session = rkvenc_free_session,
 	.dump_session = rkvenc_dump_session,
+	.poll_ready = rkvenc2_poll_ready,
 };
 
 
@@ -2421,6 +2598,7 @@ static int rkvenc_core_probe(struct platform_device *pdev)
 		return -EINVAL;
 	}
 	mpp->session_max_buffers = RKVENC_SESSION_MAX_BUFFERS;
+	mpp->isr_run_next = 1;
 	enc->hw_info = to_rkvenc_info(mpp->var->hw_info);
 	mpp->iommu_info->hdl = rkvenc2_iommu_fault_handle;
 	rkvenc_procfs_init(mpp);
@@ -2470,6 +2648,7 @@ static int rkvenc_probe_default(struct platform_device *pdev)
 		goto failed_get_irq;
 	}
 	mpp->session_max_buffers = RKVENC_SESSION_MAX_BUFFERS;
+	mpp->isr_run_next = 1;
 	enc->hw_info = to_rkvenc_info(mpp->var->hw_info);
 	rkvenc_procfs_init(mpp);
 	mpp_dev_register_srv(mpp, mpp->srv);
@@ -925,6 +925,12 @@ struct rga_mpi_job_t {
 	int ctx_id;
 };
 
+/*
+ * One request carries @task_num struct rga_req at @task_ptr, run back to
+ * back by the scheduler as a single job batch. @acquire_fence_fd gates the
+ * first task and @release_fence_fd signals once the last one is done, so
+ * a multi-op frame (scale, CSC, overlay) costs one REQUEST_SUBMIT.
+ */
 struct rga_user_request {
 	uint64_t task_ptr;
 	uint32_t task_num;
@@ -7,6 +7,7 @@
 #include "compress.h"
 #include <linux/module.h>
 #include <linux/lz4.h>
+#include <linux/soc/rockchip/rockchip_decompress.h>
 
 #ifndef LZ4_DISTANCE_MAX	/* history window size */
 #define LZ4_DISTANCE_MAX 65535	/* set to maximum value by default */
@@ -261,6 +262,60 @@ static int z_erofs_lz4_decompress(struct z_erofs_decompress_req *rq, u8 *out)
 	return ret;
 }
 
+#ifdef CONFIG_EROFS_FS_ROCKCHIP_HW_DECOMPRESS
+/*
+ * Only whole 0padded pclusters are offloaded since the engine cannot stop
+ * at an arbitrary output size. In-place I/O is left alone too: the engine
+ * may write straight into the output pages, which would then no longer
+ * hold the input for the software retry.
+ */
+static int z_erofs_lz4_decompress_hw(struct z_erofs_decompress_req *rq,
+				     u8 *out)
+{
+	const unsigned int nrpages_in =
+		PAGE_ALIGN(rq->inputsize) >> PAGE_SHIFT;
+	unsigned int inputmargin = 0;
+	u8 *src;
+	int ret;
+
+	if (rq->alg != Z_EROFS_COMPRESSION_LZ4 || rq->partial_decoding ||
+	    rq->inplace_io || !erofs_sb_has_lz4_0padding(EROFS_SB(rq->sb)) ||
+	    !rk_decom_available())
+		return -EOPNOTSUPP;
+
+	if (nrpages_in == 1)
+		src = kmap(*rq->in);
+	else
+		src = erofs_vm_map_ram(rq->in, nrpages_in);
+	if (!src)
+		return -ENOMEM;
+
+	while (inputmargin < rq->inputsize && !src[inputmargin])
+		++inputmargin;
+
+	ret = -EIO;
+	if (inputmargin < rq->inputsize)
+		ret = rk_decom_buf(LZ4_BLOCK_MOD, src + inputmargin,
+				   rq->inputsize - inputmargin,
+				   out, rq->outputsize);
+
+	if (nrpages_in == 1)
+		kunmap(*rq->in);
+	else
+		vm_unmap_ram(src, nrpages_in);
+
+	if (ret < 0)
+		return ret;
+	return ret == rq->outputsize ? 0 : -EIO;
+}
+#else
+static int z_erofs_lz4_decompress_hw(struct z_erofs_decompress_req *rq,
+				     u8 *out)
+{
+	return -EOPNOTSUPP;
+}
+#endif
+
 static struct z_erofs_decompressor decompressors[] = {
 	[Z_EROFS_COMPRESSION_SHIFTED] = {
 		.name = "shifted"
@@ -355,7 +410,12 @@ static int z_erofs_decompress_generic(struct z_erofs_decompress_req *rq,
 	dst_maptype = 2;
 
 dstmap_out:
-	ret = alg->decompress(rq, dst + rq->pageofs_out);
+	/* the engine sleeps, so only try it on sleepable mappings */
+	ret = -EOPNOTSUPP;
+	if (dst_maptype)
+		ret = z_erofs_lz4_decompress_hw(rq, dst + rq->pageofs_out);
+	if (ret)
+		ret = alg->decompress(rq, dst + rq->pageofs_out);
 
 	if (!dst_maptype)
 		kunmap_atomic(dst);
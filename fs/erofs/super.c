@@ -341,9 +341,14 @@ static int erofs_read_superblock(struct super_block *sb)
 static void erofs_default_options(struct erofs_fs_context *ctx)
 {
 #ifdef CONFIG_EROFS_FS_ZIP
-	ctx->cache_strategy = EROFS_ZIP_CACHE_READAROUND;
+	if (IS_ENABLED(CONFIG_EROFS_FS_ZIP_INPLACE))
+		ctx->cache_strategy = EROFS_ZIP_CACHE_DISABLED;
+	else
+		ctx->cache_strategy = EROFS_ZIP_CACHE_READAROUND;
 	ctx->max_sync_decompress_pages = 3;
 	ctx->readahead_sync_decompress = false;
+	if (IS_ENABLED(CONFIG_EROFS_FS_ZIP_SYNC_DECOMPRESS))
+		set_opt(ctx, SYNC_DECOMPRESS);
 #endif
 #ifdef CONFIG_EROFS_FS_XATTR
 	set_opt(ctx, XATTR_USER);
@@ -357,6 +362,7 @@ enum {
 	Opt_user_xattr,
 	Opt_acl,
 	Opt_cache_strategy,
+	Opt_sync_decompress,
 	Opt_dax,
 	Opt_dax_enum,
 	Opt_err
@@ -380,6 +386,7 @@ static const struct fs_parameter_spec erofs_fs_parameters[] = {
 	fsparam_flag_no("acl",		Opt_acl),
 	fsparam_enum("cache_strategy",	Opt_cache_strategy,
 		     erofs_param_cache_strategy),
+	fsparam_flag_no("sync_decompress", Opt_sync_decompress),
 	fsparam_flag("dax",             Opt_dax),
 	fsparam_enum("dax",		Opt_dax_enum, erofs_dax_param_enums),
 	{}
@@ -447,6 +454,16 @@ static int erofs_fc_parse_param(struct fs_context *fc,
 		ctx->cache_strategy = result.uint_32;
 #else
 		errorfc(fc, "compression not supported, cache_strategy ignored");
+#endif
+		break;
+	case Opt_sync_decompress:
+#ifdef CONFIG_EROFS_FS_ZIP
+		if (result.boolean)
+			set_opt(ctx, SYNC_DECOMPRESS);
+		else
+			clear_opt(ctx, SYNC_DECOMPRESS);
+#else
+		errorfc(fc, "compression not supported, {no}sync_decompress ignored");
 #endif
 		break;
 	case Opt_dax:
@@ -785,6 +802,8 @@ static int erofs_show_options(struct seq_file *seq, struct dentry *root)
 		seq_puts(seq, ",cache_strategy=readahead");
 	else if (ctx->cache_strategy == EROFS_ZIP_CACHE_READAROUND)
 		seq_puts(seq, ",cache_strategy=readaround");
+	if (test_opt(ctx, SYNC_DECOMPRESS))
+		seq_puts(seq, ",sync_decompress");
 #endif
 	if (test_opt(ctx, DAX_ALWAYS))
 		seq_puts(seq, ",dax=always");
@@ -1414,7 +1414,8 @@ static void z_erofs_readahead(struct readahead_control *rac)
 	struct erofs_sb_info *const sbi = EROFS_I_SB(inode);
 
 	unsigned int nr_pages = readahead_count(rac);
-	bool sync = (sbi->ctx.readahead_sync_decompress &&
+	bool force_sync = test_opt(&sbi->ctx, SYNC_DECOMPRESS);
+	bool sync = force_sync || (sbi->ctx.readahead_sync_decompress &&
 			nr_pages <= sbi->ctx.max_sync_decompress_pages);
 	struct z_erofs_decompress_frontend f = DECOMPRESS_FRONTEND_INIT(inode);
 	struct page *page, *head = NULL;
@@ -1433,7 +1434,7 @@ static void z_erofs_readahead(struct readahead_control *rac)
 		 * a PG_readahead marked page is hitted at first.
 		 * Let's also do asynchronous decompression for this case.
 		 */
-		sync &= !(PageReadahead(page) && !head);
+		sync &= force_sync || !(PageReadahead(page) && !head);
 
 		set_page_private(page, (unsigned long)head);
 		head = page;
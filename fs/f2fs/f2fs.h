@@ -590,6 +590,10 @@ enum {
 #define DEF_HOT_DATA_AGE_THRESHOLD	262144
 #define DEF_WARM_DATA_AGE_THRESHOLD	2621440
 
+/* readahead window of sequential files, in multiples of the bdi one */
+#define MIN_RA_MUL	2
+#define MAX_RA_MUL	256
+
 /* extent cache type */
 enum extent_type {
 	EX_READ,
@@ -779,6 +783,7 @@ enum {
 	FI_ENABLE_COMPRESS,	/* enable compression in "user" compression mode */
 	FI_COMPRESS_RELEASED,	/* compressed blocks were released */
 	FI_ALIGNED_WRITE,	/* enable aligned write */
+	FI_EXTENT_PRECACHED,	/* read extents precached at open */
 	FI_MAX,			/* max flag, never be used */
 };
 
@@ -1647,6 +1652,8 @@ struct f2fs_sb_info {
 	unsigned int total_valid_node_count;	/* valid node block count */
 	int dir_level;				/* directory level */
 	int readdir_ra;				/* readahead inode in readdir */
+	unsigned int open_precache_blocks;	/* precache extents at open above */
+	unsigned int seq_file_ra_mul;		/* ra_pages multiple, sequential */
 	u64 max_io_bytes;			/* max io bytes to merge IOs */
 
 	block_t user_block_count;		/* # of user blocks */
@@ -22,6 +22,7 @@
 #include <linux/file.h>
 #include <linux/nls.h>
 #include <linux/sched/signal.h>
+#include <linux/fadvise.h>
 
 #include "f2fs.h"
 #include "node.h"
@@ -544,6 +545,32 @@ static int f2fs_file_mmap(struct file *file, struct vm_area_struct *vma)
 	return 0;
 }
 
+/*
+ * Large files read from slow media: load the whole read extent tree
+ * once at open, so later seeks find their blocks without walking the
+ * node blocks, and give them the sequential readahead window.
+ */
+static void f2fs_open_precache(struct inode *inode, struct file *filp)
+{
+	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
+	unsigned int blocks = sbi->open_precache_blocks;
+
+	if (!blocks || !S_ISREG(inode->i_mode) ||
+	    !(filp->f_mode & FMODE_READ) ||
+	    i_size_read(inode) >> PAGE_SHIFT < blocks)
+		return;
+
+	filp->f_ra.ra_pages = inode_to_bdi(inode)->ra_pages *
+					sbi->seq_file_ra_mul;
+
+	if (is_inode_flag_set(inode, FI_EXTENT_PRECACHED) ||
+	    f2fs_compressed_file(inode))
+		return;
+
+	if (!f2fs_precache_extents(inode))
+		set_inode_flag(inode, FI_EXTENT_PRECACHED);
+}
+
 static int f2fs_file_open(struct inode *inode, struct file *filp)
 {
 	int err = fscrypt_file_open(inode, filp);
@@ -559,6 +586,15 @@ static int f2fs_file_open(struct inode *inode, struct file *filp)
 		return err;
 
 	filp->f_mode |= FMODE_NOWAIT;
+	/*
+	 * Buffered reads go through generic_file_read_iter(), which can wait
+	 * for a locked page with a callback, so io_uring retries them from
+	 * task_work instead of punting every cache miss to an io-wq worker.
+	 */
+	if (S_ISREG(inode->i_mode))
+		filp->f_mode |= FMODE_BUF_RASYNC;
+
+	f2fs_open_precache(inode, filp);
 
 	return dquot_file_open(inode, filp);
 }
@@ -4617,6 +4653,26 @@ long f2fs_compat_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 }
 #endif
 
+static int f2fs_file_fadvise(struct file *filp, loff_t offset, loff_t len,
+			     int advice)
+{
+	struct inode *inode = file_inode(filp);
+
+	if (advice == POSIX_FADV_SEQUENTIAL) {
+		if (!filp->f_mapping || len < 0)
+			return -EINVAL;
+
+		filp->f_ra.ra_pages = inode_to_bdi(inode)->ra_pages *
+					F2FS_I_SB(inode)->seq_file_ra_mul;
+		spin_lock(&filp->f_lock);
+		filp->f_mode &= ~FMODE_RANDOM;
+		spin_unlock(&filp->f_lock);
+		return 0;
+	}
+
+	return generic_fadvise(filp, offset, len, advice);
+}
+
 const struct file_operations f2fs_file_operations = {
 	.llseek		= f2fs_llseek,
 	.read_iter	= f2fs_file_read_iter,
@@ -4633,4 +4689,5 @@ const struct file_operations f2fs_file_operations = {
 #endif
 	.splice_read	= generic_file_splice_read,
 	.splice_write	= iter_file_splice_write,
+	.fadvise	= f2fs_file_fadvise,
 };
@@ -3850,6 +3850,7 @@ static void f2fs_tuning_parameters(struct f2fs_sb_info *sbi)
 	}
 
 	sbi->readdir_ra = 1;
+	sbi->seq_file_ra_mul = MIN_RA_MUL;
 }
 
 static int f2fs_fill_super(struct super_block *sb, void *data, int silent)
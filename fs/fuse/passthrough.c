@@ -194,6 +194,21 @@ ssize_t fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma)
 	return ret;
 }
 
+int fuse_passthrough_fadvise(struct file *file, loff_t offset, loff_t len,
+			     int advice)
+{
+	int ret;
+	const struct cred *old_cred;
+	struct fuse_file *ff = file->private_data;
+	struct file *passthrough_filp = ff->passthrough.filp;
+
+	old_cred = override_creds(ff->passthrough.cred);
+	ret = vfs_fadvise(passthrough_filp, offset, len, advice);
+	revert_creds(old_cred);
+
+	return ret;
+}
+
 int fuse_passthrough_open(struct fuse_dev *fud, u32 lower_fd)
 {
 	int res;
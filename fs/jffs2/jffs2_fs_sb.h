@@ -40,6 +40,12 @@ struct jffs2_mount_opts {
 	 * available space is less then 'rp_size'. */
 	bool set_rp_size;
 	unsigned int rp_size;
+
+	/* Write the summary of the partly used eraseblock out when the file
+	 * system goes read-only or is unmounted, so the next mount does not
+	 * need to scan any used eraseblock. */
+	bool set_umount_summary;
+	bool umount_summary;
 };
 
 /* A struct for the overall file system control.  Pointers to
@@ -875,3 +875,49 @@ int jffs2_sum_write_sumnode(struct jffs2_sb_info *c)
 	spin_lock(&c->erase_completion_lock);
 	return ret;
 }
+
+/*
+ * Write out the summary of the partly used nextblock and close it, so that
+ * the next mount finds a summary in every used eraseblock and does not have
+ * to scan this one node by node. The free end of the block is filed as dirty
+ * space in front of the summary, for the GC to recover. Called at unmount
+ * and remount read-only with c->alloc_sem held.
+ */
+int jffs2_sum_close_nextblock(struct jffs2_sb_info *c)
+{
+	struct jffs2_eraseblock *jeb;
+	uint32_t sumsize;
+	int ret;
+
+	ret = jffs2_flush_wbuf_pad(c);
+	if (ret)
+		return ret;
+
+	jeb = c->nextblock;
+	if (!jeb || !c->summary->sum_num || jffs2_sum_is_disabled(c->summary))
+		return 0;
+
+	/* the padding of the write buffer above is part of the summary now */
+	sumsize = PAD(c->summary->sum_size + JFFS2_SUMMARY_FRAME_SIZE);
+	if (c->wbuf_pagesize)
+		sumsize = roundup(sumsize, c->wbuf_pagesize);
+	if (sumsize > jeb->free_size || sumsize > MAX_SUMMARY_SIZE)
+		return 0;
+
+	ret = jffs2_prealloc_raw_node_refs(c, jeb, 2);
+	if (ret)
+		return ret;
+
+	dbg_summary("closing nextblock 0x%08x, 0x%x bytes free\n",
+		    jeb->offset, jeb->free_size);
+
+	spin_lock(&c->erase_completion_lock);
+	ret = jffs2_scan_dirty_space(c, jeb, jeb->free_size - sumsize);
+	if (!ret)
+		ret = jffs2_sum_write_sumnode(c);
+	if (!ret && !jffs2_sum_is_disabled(c->summary))
+		jffs2_close_nextblock(c, jeb);
+	spin_unlock(&c->erase_completion_lock);
+
+	return ret;
+}
@@ -90,6 +90,8 @@ static int jffs2_show_options(struct seq_file *s, struct dentry *root)
 		seq_printf(s, ",compr=%s", jffs2_compr_name(opts->compr));
 	if (opts->set_rp_size)
 		seq_printf(s, ",rp_size=%u", opts->rp_size / 1024);
+	if (opts->umount_summary)
+		seq_puts(s, ",umount_summary");
 
 	return 0;
 }
@@ -161,10 +163,12 @@ static const struct export_operations jffs2_export_ops = {
  * Opt_source: The source device
  * Opt_override_compr: override default compressor
  * Opt_rp_size: size of reserved pool in KiB
+ * Opt_umount_summary: summarize the partly used eraseblock at unmount
  */
 enum {
 	Opt_override_compr,
 	Opt_rp_size,
+	Opt_umount_summary,
 };
 
 static const struct constant_table jffs2_param_compr[] = {
@@ -181,6 +185,7 @@ static const struct constant_table jffs2_param_compr[] = {
 static const struct fs_parameter_spec jffs2_fs_parameters[] = {
 	fsparam_enum	("compr",	Opt_override_compr, jffs2_param_compr),
 	fsparam_u32	("rp_size",	Opt_rp_size),
+	fsparam_flag_no	("umount_summary", Opt_umount_summary),
 	{}
 };
 
@@ -205,6 +210,12 @@ static int jffs2_parse_param(struct fs_context *fc, struct fs_parameter *param)
 		c->mount_opts.rp_size = result.uint_32 * 1024;
 		c->mount_opts.set_rp_size = true;
 		break;
+	case Opt_umount_summary:
+		if (!jffs2_sum_active() && !result.negated)
+			return invalf(fc, "jffs2: umount_summary needs CONFIG_JFFS2_SUMMARY");
+		c->mount_opts.umount_summary = !result.negated;
+		c->mount_opts.set_umount_summary = true;
+		break;
 	default:
 		return -EINVAL;
 	}
@@ -226,6 +237,10 @@ static inline void jffs2_update_mount_opts(struct fs_context *fc)
 		c->mount_opts.set_rp_size = new_c->mount_opts.set_rp_size;
 		c->mount_opts.rp_size = new_c->mount_opts.rp_size;
 	}
+	if (new_c->mount_opts.set_umount_summary) {
+		c->mount_opts.set_umount_summary = true;
+		c->mount_opts.umount_summary = new_c->mount_opts.umount_summary;
+	}
 	mutex_unlock(&c->alloc_sem);
 }
 
@@ -325,6 +340,8 @@ static void jffs2_put_super (struct super_block *sb)
 	jffs2_dbg(2, "%s()\n", __func__);
 
 	mutex_lock(&c->alloc_sem);
+	if (c->mount_opts.umount_summary && !sb_rdonly(sb))
+		jffs2_sum_close_nextblock(c);
 	jffs2_flush_wbuf_pad(c);
 	mutex_unlock(&c->alloc_sem);
 
@@ -9,6 +9,7 @@
 #include <linux/percpu.h>
 #include <linux/buffer_head.h>
 #include <linux/local_lock.h>
+#include <linux/mutex.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -22,7 +23,12 @@
 
 struct squashfs_stream {
 	void			*stream;
+#ifdef CONFIG_SQUASHFS_ROCKCHIP_HW_DECOMPRESS
+	/* the hardware decompressor sleeps, the stream may not be cpu bound */
+	struct mutex		mutex;
+#else
 	local_lock_t	lock;
+#endif
 };
 
 void *squashfs_decompressor_create(struct squashfs_sb_info *msblk,
@@ -43,7 +49,11 @@ void *squashfs_decompressor_create(struct squashfs_sb_info *msblk,
 			err = PTR_ERR(stream->stream);
 			goto out;
 		}
+#ifdef CONFIG_SQUASHFS_ROCKCHIP_HW_DECOMPRESS
+		mutex_init(&stream->mutex);
+#else
 		local_lock_init(&stream->lock);
+#endif
 	}
 
 	kfree(comp_opts);
@@ -81,13 +91,22 @@ int squashfs_decompress(struct squashfs_sb_info *msblk, struct bio *bio,
 	struct squashfs_stream *stream;
 	int res;
 
+#ifdef CONFIG_SQUASHFS_ROCKCHIP_HW_DECOMPRESS
+	stream = raw_cpu_ptr(msblk->stream);
+	mutex_lock(&stream->mutex);
+#else
 	local_lock(&msblk->stream->lock);
 	stream = this_cpu_ptr(msblk->stream);
+#endif
 
 	res = msblk->decompressor->decompress(msblk, stream->stream, bio,
 					      offset, length, output);
 
+#ifdef CONFIG_SQUASHFS_ROCKCHIP_HW_DECOMPRESS
+	mutex_unlock(&stream->mutex);
+#else
 	local_unlock(&msblk->stream->lock);
+#endif
 
 	if (res < 0)
 		ERROR("%s decompression failed, data probably corrupt\n",
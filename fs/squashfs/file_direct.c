@@ -35,8 +35,8 @@ int squashfs_readpage_block(struct page *target_page, u64 block, int bsize,
 	int end_index = start_index | mask;
 	int i, n, pages, missing_pages, bytes, res = -ENOMEM;
 	struct page **page;
-	struct squashfs_page_actor *actor;
-	void *pageaddr;
+	struct squashfs_page_actor *actor = NULL;
+	void *pageaddr, *tmp_buffer = NULL;
 
 	if (end_index > file_end)
 		end_index = file_end;
@@ -47,14 +47,6 @@ int squashfs_readpage_block(struct page *target_page, u64 block, int bsize,
 	if (page == NULL)
 		return res;
 
-	/*
-	 * Create a "page actor" which will kmap and kunmap the
-	 * page cache pages appropriately within the decompressor
-	 */
-	actor = squashfs_page_actor_init_special(page, pages, 0);
-	if (actor == NULL)
-		goto out;
-
 	/* Try to grab all the pages covered by the Squashfs block */
 	for (missing_pages = 0, i = 0, n = start_index; i < pages; i++, n++) {
 		page[i] = (n == target_page->index) ? target_page :
@@ -73,22 +65,35 @@ int squashfs_readpage_block(struct page *target_page, u64 block, int bsize,
 		}
 	}
 
+	/*
+	 * Couldn't get one or more pages, this page has either been VM
+	 * reclaimed, but others are still in the page cache and uptodate,
+	 * or we're racing with another thread in squashfs_readpage also
+	 * trying to grab them.  Decompress the missing pages into a
+	 * throw-away page rather than the whole block into an intermediate
+	 * buffer, and only fall back to that buffer if even one page can't
+	 * be had.
+	 */
 	if (missing_pages) {
-		/*
-		 * Couldn't get one or more pages, this page has either
-		 * been VM reclaimed, but others are still in the page cache
-		 * and uptodate, or we're racing with another thread in
-		 * squashfs_readpage also trying to grab them.  Fall back to
-		 * using an intermediate buffer.
-		 */
-		res = squashfs_read_cache(target_page, block, bsize, pages,
-							page, expected);
-		if (res < 0)
-			goto mark_errored;
-
-		goto out;
+		tmp_buffer = kmalloc(PAGE_SIZE, GFP_KERNEL);
+		if (tmp_buffer == NULL) {
+			res = squashfs_read_cache(target_page, block, bsize,
+						  pages, page, expected);
+			if (res < 0)
+				goto mark_errored;
+
+			goto out;
+		}
 	}
 
+	/*
+	 * Create a "page actor" which will kmap and kunmap the
+	 * page cache pages appropriately within the decompressor
+	 */
+	actor = squashfs_page_actor_init_special(page, pages, 0, tmp_buffer);
+	if (actor == NULL)
+		goto mark_errored;
+
 	/* Decompress directly into the page cache buffers */
 	res = squashfs_read_data(inode->i_sb, block, bsize, NULL, actor);
 	if (res < 0)
@@ -101,7 +106,7 @@ int squashfs_readpage_block(struct page *target_page, u64 block, int bsize,
 
 	/* Last page may have trailing bytes not filled */
 	bytes = res % PAGE_SIZE;
-	if (bytes) {
+	if (bytes && page[pages - 1]) {
 		pageaddr = kmap_atomic(page[pages - 1]);
 		memset(pageaddr + bytes, 0, PAGE_SIZE - bytes);
 		kunmap_atomic(pageaddr);
@@ -109,6 +114,8 @@ int squashfs_readpage_block(struct page *target_page, u64 block, int bsize,
 
 	/* Mark pages as uptodate, unlock and release */
 	for (i = 0; i < pages; i++) {
+		if (page[i] == NULL)
+			continue;
 		flush_dcache_page(page[i]);
 		SetPageUptodate(page[i]);
 		unlock_page(page[i]);
@@ -116,6 +123,7 @@ int squashfs_readpage_block(struct page *target_page, u64 block, int bsize,
 			put_page(page[i]);
 	}
 
+	kfree(tmp_buffer);
 	kfree(actor);
 	kfree(page);
 
@@ -135,6 +143,7 @@ int squashfs_readpage_block(struct page *target_page, u64 block, int bsize,
 	}
 
 out:
+	kfree(tmp_buffer);
 	kfree(actor);
 	kfree(page);
 	return res;
@@ -9,6 +9,7 @@
 #include <linux/slab.h>
 #include <linux/vmalloc.h>
 #include <linux/lz4.h>
+#include <linux/soc/rockchip/rockchip_decompress.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -60,7 +61,12 @@ static void *lz4_init(struct squashfs_sb_info *msblk, void *buff)
 	stream->input = vmalloc(block_size);
 	if (stream->input == NULL)
 		goto failed2;
-	stream->output = vmalloc(block_size);
+	/* the hardware decompressor writes linear memory directly */
+	if (IS_ENABLED(CONFIG_SQUASHFS_ROCKCHIP_HW_DECOMPRESS) &&
+	    rk_decom_available())
+		stream->output = kvmalloc(block_size, GFP_KERNEL);
+	else
+		stream->output = vmalloc(block_size);
 	if (stream->output == NULL)
 		goto failed3;
 
@@ -82,7 +88,7 @@ static void lz4_free(void *strm)
 
 	if (stream) {
 		vfree(stream->input);
-		vfree(stream->output);
+		kvfree(stream->output);
 	}
 	kfree(stream);
 }
@@ -108,8 +114,13 @@ static int lz4_uncompress(struct squashfs_sb_info *msblk, void *strm,
 		offset = 0;
 	}
 
-	res = LZ4_decompress_safe(stream->input, stream->output,
-		length, output->length);
+	res = -EOPNOTSUPP;
+	if (IS_ENABLED(CONFIG_SQUASHFS_ROCKCHIP_HW_DECOMPRESS))
+		res = rk_decom_buf(LZ4_BLOCK_MOD, stream->input, length,
+				   stream->output, output->length);
+	if (res < 0)
+		res = LZ4_decompress_safe(stream->input, stream->output,
+			length, output->length);
 
 	if (res < 0)
 		return -EIO;
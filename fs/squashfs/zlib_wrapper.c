@@ -14,6 +14,7 @@
 #include <linux/slab.h>
 #include <linux/zlib.h>
 #include <linux/vmalloc.h>
+#include <linux/soc/rockchip/rockchip_decompress.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -21,31 +22,91 @@
 #include "decompressor.h"
 #include "page_actor.h"
 
-static void *zlib_init(struct squashfs_sb_info *dummy, void *buff)
+struct squashfs_zlib {
+	z_stream stream;
+	/* whole block copies for the hardware decompressor, if any */
+	void *input;
+	void *output;
+};
+
+static void *zlib_init(struct squashfs_sb_info *msblk, void *buff)
 {
-	z_stream *stream = kmalloc(sizeof(z_stream), GFP_KERNEL);
-	if (stream == NULL)
+	int block_size = max_t(int, msblk->block_size, SQUASHFS_METADATA_SIZE);
+	struct squashfs_zlib *zlib = kzalloc(sizeof(*zlib), GFP_KERNEL);
+	if (zlib == NULL)
 		goto failed;
-	stream->workspace = vmalloc(zlib_inflate_workspacesize());
-	if (stream->workspace == NULL)
+	zlib->stream.workspace = vmalloc(zlib_inflate_workspacesize());
+	if (zlib->stream.workspace == NULL)
 		goto failed;
 
-	return stream;
+	if (IS_ENABLED(CONFIG_SQUASHFS_ROCKCHIP_HW_DECOMPRESS) &&
+	    rk_decom_available()) {
+		/* without them every block simply goes through zlib */
+		zlib->input = vmalloc(block_size);
+		zlib->output = kvmalloc(block_size, GFP_KERNEL);
+	}
+
+	return zlib;
 
 failed:
 	ERROR("Failed to allocate zlib workspace\n");
-	kfree(stream);
+	kfree(zlib);
 	return ERR_PTR(-ENOMEM);
 }
 
 
 static void zlib_free(void *strm)
 {
-	z_stream *stream = strm;
+	struct squashfs_zlib *zlib = strm;
+
+	if (zlib) {
+		vfree(zlib->stream.workspace);
+		vfree(zlib->input);
+		kvfree(zlib->output);
+	}
+	kfree(zlib);
+}
+
+
+static int zlib_uncompress_hw(struct squashfs_zlib *zlib, struct bio *bio,
+	int offset, int length, struct squashfs_page_actor *output)
+{
+	struct bvec_iter_all iter_all = {};
+	struct bio_vec *bvec = bvec_init_iter_all(&iter_all);
+	void *buff = zlib->input, *data;
+	int bytes = length, res;
+
+	while (bio_next_segment(bio, &iter_all)) {
+		int avail = min(bytes, ((int)bvec->bv_len) - offset);
+
+		data = page_address(bvec->bv_page) + bvec->bv_offset;
+		memcpy(buff, data + offset, avail);
+		buff += avail;
+		bytes -= avail;
+		offset = 0;
+	}
 
-	if (stream)
-		vfree(stream->workspace);
-	kfree(stream);
+	res = rk_decom_buf(ZLIB_MOD, zlib->input, length, zlib->output,
+			   output->length);
+	if (res < 0)
+		return res;
+
+	bytes = res;
+	data = squashfs_first_page(output);
+	buff = zlib->output;
+	while (data) {
+		if (bytes <= PAGE_SIZE) {
+			memcpy(data, buff, bytes);
+			break;
+		}
+		memcpy(data, buff, PAGE_SIZE);
+		buff += PAGE_SIZE;
+		bytes -= PAGE_SIZE;
+		data = squashfs_next_page(output);
+	}
+	squashfs_finish_page(output);
+
+	return res;
 }
 
 
@@ -55,8 +116,16 @@ static int zlib_uncompress(struct squashfs_sb_info *msblk, void *strm,
 {
 	struct bvec_iter_all iter_all = {};
 	struct bio_vec *bvec = bvec_init_iter_all(&iter_all);
+	struct squashfs_zlib *zlib = strm;
+	z_stream *stream = &zlib->stream;
 	int zlib_init = 0, error = 0;
-	z_stream *stream = strm;
+
+	if (zlib->input && zlib->output) {
+		error = zlib_uncompress_hw(zlib, bio, offset, length, output);
+		if (error >= 0)
+			return error;
+		error = 0;
+	}
 
 	stream->avail_out = PAGE_SIZE;
 	stream->next_out = squashfs_first_page(output);
@@ -37,6 +37,7 @@
 #define SYS_STATUS_HDMIRX	(1 << 18)
 #define SYS_STATUS_VIDEO_SVEP	(1 << 19)
 #define SYS_STATUS_VIDEO_4K_60P	(1 << 20)
+#define SYS_STATUS_THERMAL_BUDGET	(1 << 21)
 
 #define SYS_STATUS_VIDEO	(SYS_STATUS_VIDEO_4K | \
 				 SYS_STATUS_VIDEO_1080P | \
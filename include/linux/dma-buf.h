@@ -373,6 +373,26 @@ struct dma_buf_ops {
 typedef int (*dma_buf_destructor)(struct dma_buf *dmabuf, void *dtor_data);
 #endif
 
+#define DMA_BUF_ACCOUNT_NAME_LEN	32
+
+/**
+ * struct dma_buf_account - dma-buf memory charged to an exporter or process
+ * @node: link in the list of accounts of its kind
+ * @name: exporter name, or command of the exporting process
+ * @pid: tgid of the exporting process, 0 for exporter accounts
+ * @size: bytes currently exported
+ * @peak: highest @size since the last dma_buf_reset_peak_size()
+ * @count: number of dma-bufs currently exported
+ */
+struct dma_buf_account {
+	struct list_head node;
+	char name[DMA_BUF_ACCOUNT_NAME_LEN];
+	pid_t pid;
+	size_t size;
+	size_t peak;
+	unsigned long count;
+};
+
 /**
  * struct dma_buf - shared buffer object
  * @size: size of the buffer
@@ -397,6 +417,8 @@ typedef int (*dma_buf_destructor)(struct dma_buf *dmabuf, void *dtor_data);
  * @cb_excl: for userspace poll support
  * @cb_shared: for userspace poll support
  * @sysfs_entry: for exposing information about this buffer in sysfs.
+ * @heap_acct: exporter account charged with this buffer.
+ * @proc_acct: process account charged with this buffer.
  *
  * This represents a shared buffer, created by calling dma_buf_export(). The
  * userspace representation is a normal file descriptor, which can be created by
@@ -444,6 +466,10 @@ struct dma_buf {
 	void *dtor_data;
 	struct mutex cache_lock;
 #endif
+#if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
+	struct dma_buf_account *heap_acct;
+	struct dma_buf_account *proc_acct;
+#endif
 
 	ANDROID_KABI_RESERVE(1);
 	ANDROID_KABI_RESERVE(2);
@@ -666,10 +692,26 @@ static inline void dma_buf_set_destructor(struct dma_buf *dmabuf,
 void dma_buf_reset_peak_size(void);
 size_t dma_buf_get_peak_size(void);
 size_t dma_buf_get_total_size(void);
+int get_each_dmabuf_heap(int (*callback)(const struct dma_buf_account *acct,
+					 void *private), void *private);
+int get_each_dmabuf_process(int (*callback)(const struct dma_buf_account *acct,
+					    void *private), void *private);
 #else
 static inline void dma_buf_reset_peak_size(void) {}
 static inline size_t dma_buf_get_peak_size(void) { return 0; }
 static inline size_t dma_buf_get_total_size(void) { return 0; }
+static inline int
+get_each_dmabuf_heap(int (*callback)(const struct dma_buf_account *acct,
+				     void *private), void *private)
+{
+	return 0;
+}
+static inline int
+get_each_dmabuf_process(int (*callback)(const struct dma_buf_account *acct,
+					void *private), void *private)
+{
+	return 0;
+}
 #endif
 
 #endif /* __DMA_BUF_H__ */
@@ -65,6 +65,8 @@ to_dma_fence_chain(struct dma_fence *fence)
 
 struct dma_fence *dma_fence_chain_walk(struct dma_fence *fence);
 int dma_fence_chain_find_seqno(struct dma_fence **pfence, uint64_t seqno);
+void dma_fence_trace_consumer(struct dma_fence *fence, const char *dev,
+			      u64 frame);
 void dma_fence_chain_init(struct dma_fence_chain *chain,
 			  struct dma_fence *prev,
 			  struct dma_fence *fence,
@@ -19,6 +19,7 @@ struct dma_heap;
  * struct dma_heap_ops - ops to operate on a given heap
  * @allocate:		allocate dmabuf and return struct dma_buf ptr
  * @get_pool_size:	if heap maintains memory pools, get pool size in bytes
+ * @prewarm:		if heap maintains memory pools, fill them for allocations
  *
  * allocate returns dmabuf on success, ERR_PTR(-errno) on error.
  */
@@ -30,6 +31,7 @@ struct dma_heap_ops {
 	long (*get_pool_size)(struct dma_heap *heap);
 #if IS_ENABLED(CONFIG_NO_GKI)
 	int (*get_phys)(struct dma_heap *heap, struct dma_heap_phys_data *phys);
+	int (*prewarm)(struct dma_heap *heap, struct dma_heap_prewarm_data *data);
 #endif
 };
 
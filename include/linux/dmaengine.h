@@ -191,6 +191,10 @@ struct dma_interleaved_template {
  *  transaction is marked with DMA_PREP_REPEAT will cause the new transaction
  *  to never be processed and stay in the issued queue forever. The flag is
  *  ignored if the previous transaction is not a repeated transaction.
+ * @DMA_PREP_CALLBACK_HARDIRQ: the client callback is safe to run from hard
+ *  interrupt context, so drivers that can may call it straight from their
+ *  interrupt handler instead of a tasklet. Others ignore the flag. The
+ *  client must use dmaengine_synchronize() before freeing callback data.
  */
 enum dma_ctrl_flags {
 	DMA_PREP_INTERRUPT = (1 << 0),
@@ -203,6 +207,7 @@ enum dma_ctrl_flags {
 	DMA_PREP_CMD = (1 << 7),
 	DMA_PREP_REPEAT = (1 << 8),
 	DMA_PREP_LOAD_EOT = (1 << 9),
+	DMA_PREP_CALLBACK_HARDIRQ = (1 << 10),
 };
 
 /**
@@ -823,6 +828,9 @@ struct dma_filter {
  * @device_prep_dma_cyclic: prepare a cyclic dma operation suitable for audio.
  *	The function takes a buffer of size buf_len. The callback function will
  *	be called after period_len bytes have been transferred.
+ * @device_prep_dma_cyclic_sg: like device_prep_dma_cyclic, for a buffer that
+ *	is not contiguous: the transfer loops over the scatterlist forever.
+ *	Entries may not straddle a period boundary.
  * @device_prep_interleaved_dma: Transfer expression in a generic way.
  * @device_prep_dma_imm_data: DMA's 8 byte immediate data to the dst address
  * @device_caps: May be used to override the generic DMA slave capabilities
@@ -920,6 +928,10 @@ struct dma_device {
 		struct dma_chan *chan, dma_addr_t buf_addr, size_t buf_len,
 		size_t period_len, enum dma_transfer_direction direction,
 		unsigned long flags);
+	struct dma_async_tx_descriptor *(*device_prep_dma_cyclic_sg)(
+		struct dma_chan *chan, struct scatterlist *sgl,
+		unsigned int sg_len, size_t period_len,
+		enum dma_transfer_direction direction, unsigned long flags);
 	struct dma_async_tx_descriptor *(*device_prep_interleaved_dma)(
 		struct dma_chan *chan, struct dma_interleaved_template *xt,
 		unsigned long flags);
@@ -1021,6 +1033,18 @@ static inline struct dma_async_tx_descriptor *dmaengine_prep_dma_cyclic(
 						period_len, dir, flags);
 }
 
+static inline struct dma_async_tx_descriptor *dmaengine_prep_dma_cyclic_sg(
+		struct dma_chan *chan, struct scatterlist *sgl,
+		unsigned int sg_len, size_t period_len,
+		enum dma_transfer_direction dir, unsigned long flags)
+{
+	if (!chan || !chan->device || !chan->device->device_prep_dma_cyclic_sg)
+		return NULL;
+
+	return chan->device->device_prep_dma_cyclic_sg(chan, sgl, sg_len,
+						period_len, dir, flags);
+}
+
 static inline struct dma_async_tx_descriptor *dmaengine_prep_interleaved_dma(
 		struct dma_chan *chan, struct dma_interleaved_template *xt,
 		unsigned long flags)
@@ -31,6 +31,8 @@ int __init default_rootfs(void);
 
 #if defined(CONFIG_ROCKCHIP_HW_DECOMPRESS)
 void __init wait_initrd_hw_decom_done(void);
+char * __init rk_decom_initrd_get(unsigned long *len);
+void __init rk_decom_initrd_put(void);
 #endif
 
 #if defined(CONFIG_ROCKCHIP_THUNDER_BOOT_CRYPTO)
@@ -10,6 +10,7 @@
 #include <linux/sched.h>
 #include <linux/device.h>
 #include <linux/fault-inject.h>
+#include <linux/kthread.h>
 
 #include <linux/mmc/core.h>
 #include <linux/mmc/card.h>
@@ -449,6 +450,8 @@ struct mmc_host {
 	unsigned int		sdio_irqs;
 	struct task_struct	*sdio_irq_thread;
 	struct delayed_work	sdio_irq_work;
+	struct kthread_worker	*sdio_irq_worker;	/* RT worker, if sdio_irq_prio set */
+	struct kthread_work	sdio_irq_kwork;
 	bool			sdio_irq_pending;
 	atomic_t		sdio_irq_thread_abort;
 
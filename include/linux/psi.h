@@ -26,6 +26,12 @@ void psi_memstall_leave(unsigned long *flags);
 
 int psi_show(struct seq_file *s, struct psi_group *group, enum psi_res res);
 
+struct psi_trigger *psi_kernel_trigger_create(struct psi_group *group,
+			enum psi_states state, u32 threshold_us, u32 window_us,
+			void (*notify)(struct psi_trigger *t, void *data),
+			void *data);
+void psi_trigger_destroy(struct psi_trigger *t);
+
 #ifdef CONFIG_CGROUPS
 int psi_cgroup_alloc(struct cgroup *cgrp);
 void psi_cgroup_free(struct cgroup *cgrp);
@@ -33,7 +39,6 @@ void cgroup_move_task(struct task_struct *p, struct css_set *to);
 
 struct psi_trigger *psi_trigger_create(struct psi_group *group,
 			char *buf, size_t nbytes, enum psi_res res);
-void psi_trigger_destroy(struct psi_trigger *t);
 
 __poll_t psi_trigger_poll(void **trigger_ptr, struct file *file,
 			poll_table *wait);
@@ -46,6 +51,16 @@ static inline void psi_init(void) {}
 static inline void psi_memstall_enter(unsigned long *flags) {}
 static inline void psi_memstall_leave(unsigned long *flags) {}
 
+static inline struct psi_trigger *psi_kernel_trigger_create(
+			struct psi_group *group, enum psi_states state,
+			u32 threshold_us, u32 window_us,
+			void (*notify)(struct psi_trigger *t, void *data),
+			void *data)
+{
+	return ERR_PTR(-EOPNOTSUPP);
+}
+static inline void psi_trigger_destroy(struct psi_trigger *t) {}
+
 #ifdef CONFIG_CGROUPS
 static inline int psi_cgroup_alloc(struct cgroup *cgrp)
 {
@@ -128,6 +128,10 @@ struct psi_trigger {
 	 * events to one per window
 	 */
 	u64 last_event_time;
+
+	/* In-kernel trigger: called instead of waking up pollers */
+	void (*notify)(struct psi_trigger *t, void *data);
+	void *data;
 };
 
 struct psi_group {
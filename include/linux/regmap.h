@@ -82,6 +82,27 @@ struct reg_sequence {
 				}
 #define REG_SEQ0(_reg, _def)	REG_SEQ(_reg, _def, 0)
 
+/**
+ * struct reg_update - An individual masked update from a sequence of updates.
+ *
+ * @reg: Register address.
+ * @mask: Bitmask to change.
+ * @val: New value for bitmask.
+ *
+ * Read/modify/write cycles applied in order by regmap_multi_reg_update_bits().
+ */
+struct reg_update {
+	unsigned int reg;
+	unsigned int mask;
+	unsigned int val;
+};
+
+#define REG_UPDATE(_reg, _mask, _val) {		\
+				.reg = _reg,		\
+				.mask = _mask,		\
+				.val = _val,		\
+				}
+
 /**
  * regmap_read_poll_timeout - Poll until a condition is met or a timeout occurs
  *
@@ -344,6 +365,10 @@ typedef void (*regmap_unlock)(void *);
  * @hwlock_mode: The hardware spinlock mode, should be HWLOCK_IRQSTATE,
  *		 HWLOCK_IRQ or 0.
  * @can_sleep: Optional, specifies whether regmap operations can sleep.
+ * @use_relaxed_mmio: If set, MMIO R/W operations will not use memory barriers.
+ *                    This can avoid load on devices which don't require strict
+ *                    orderings, but drivers should carefully add any explicit
+ *                    memory barriers when they may require them.
  */
 struct regmap_config {
 	const char *name;
@@ -403,7 +428,7 @@ struct regmap_config {
 
 	bool can_sleep;
 
-	ANDROID_KABI_RESERVE(1);
+	ANDROID_KABI_USE(1, bool use_relaxed_mmio);
 };
 
 /**
@@ -449,6 +474,8 @@ struct regmap_async;
 
 typedef int (*regmap_hw_write)(void *context, const void *data,
 			       size_t count);
+typedef int (*regmap_hw_multi_write)(void *context, const void *data,
+				     size_t pair_size, size_t count);
 typedef int (*regmap_hw_gather_write)(void *context,
 				      const void *reg, size_t reg_len,
 				      const void *val, size_t val_len);
@@ -502,6 +529,10 @@ typedef void (*regmap_hw_free_context)(void *context);
  *     DEFAULT, BIG is assumed.
  * @max_raw_read: Max raw read size that can be used on the bus.
  * @max_raw_write: Max raw write size that can be used on the bus.
+ * @multi_write: Write @count formatted register/value pairs of @pair_size
+ *               bytes each as separate bus writes issued back to back,
+ *               optional. Used by regmap_multi_reg_write() for devices
+ *               that do not support the multi write mode.
  */
 struct regmap_bus {
 	bool fast_io;
@@ -520,7 +551,7 @@ struct regmap_bus {
 	size_t max_raw_read;
 	size_t max_raw_write;
 
-	ANDROID_KABI_RESERVE(1);
+	ANDROID_KABI_USE(1, regmap_hw_multi_write multi_write);
 };
 
 /*
@@ -1071,6 +1102,9 @@ int regmap_bulk_read(struct regmap *map, unsigned int reg, void *val,
 int regmap_update_bits_base(struct regmap *map, unsigned int reg,
 			    unsigned int mask, unsigned int val,
 			    bool *change, bool async, bool force);
+int regmap_multi_reg_update_bits(struct regmap *map,
+				 const struct reg_update *updates,
+				 int num_updates, bool *change);
 
 static inline int regmap_update_bits(struct regmap *map, unsigned int reg,
 				     unsigned int mask, unsigned int val)
@@ -1547,6 +1581,14 @@ static inline int regmap_update_bits_base(struct regmap *map, unsigned int reg,
 	return -EINVAL;
 }
 
+static inline int regmap_multi_reg_update_bits(struct regmap *map,
+					       const struct reg_update *updates,
+					       int num_updates, bool *change)
+{
+	WARN_ONCE(1, "regmap API is disabled");
+	return -EINVAL;
+}
+
 static inline int regmap_set_bits(struct regmap *map,
 				  unsigned int reg, unsigned int bits)
 {
@@ -5,6 +5,9 @@
 #ifndef ROCKCHIP_RPMSG_H
 #define ROCKCHIP_RPMSG_H
 
+#include <linux/err.h>
+#include <linux/types.h>
+
 /* rpmsg flag bit definition
  * bit 0: Set 1 to indicate remote processor is ready
  * bit 1: Set 1 to use reserved memory region as shared DMA pool
@@ -40,4 +43,71 @@
 #define RPMSG_GET_M_CPU_ID(link_id)		(((link_id) & 0xF0U) >> 4U)
 #define RPMSG_GET_R_CPU_ID(link_id)		((link_id) & 0xFU)
 
+/*
+ * Shared ring channel: the second memory resource of the rpmsg node is
+ * split into a Linux to remote and a remote to Linux byte ring, each
+ * described by a struct rk_rpmsg_ring_ctrl at the start of the region.
+ * head and tail are free running byte counts, the producer only moves
+ * head and the consumer only tail. Any change is signalled with a
+ * mailbox message carrying RPMSG_RING_MAGIC.
+ */
+#define RPMSG_RING_MAGIC			(0x52524E47U)
+#define RPMSG_RING_CTRL_SIZE			(64UL)
+
+struct rk_rpmsg_ring_ctrl {
+	__le32 magic;
+	__le32 size;
+	__le32 head;
+	__le32 tail;
+};
+
+struct device_node;
+struct rk_rpmsg_ring;
+
+#if IS_ENABLED(CONFIG_RPMSG_ROCKCHIP)
+struct rk_rpmsg_ring *rk_rpmsg_ring_get(struct device_node *np,
+					void (*notify)(void *priv),
+					void *priv);
+void rk_rpmsg_ring_put(struct rk_rpmsg_ring *ring);
+size_t rk_rpmsg_ring_tx_span(struct rk_rpmsg_ring *ring, void **buf);
+int rk_rpmsg_ring_tx_commit(struct rk_rpmsg_ring *ring, size_t len);
+size_t rk_rpmsg_ring_rx_span(struct rk_rpmsg_ring *ring, const void **buf);
+int rk_rpmsg_ring_rx_release(struct rk_rpmsg_ring *ring, size_t len);
+#else
+static inline struct rk_rpmsg_ring *
+rk_rpmsg_ring_get(struct device_node *np, void (*notify)(void *priv),
+		  void *priv)
+{
+	return ERR_PTR(-ENODEV);
+}
+
+static inline void rk_rpmsg_ring_put(struct rk_rpmsg_ring *ring)
+{
+}
+
+static inline size_t rk_rpmsg_ring_tx_span(struct rk_rpmsg_ring *ring,
+					   void **buf)
+{
+	return 0;
+}
+
+static inline int rk_rpmsg_ring_tx_commit(struct rk_rpmsg_ring *ring,
+					  size_t len)
+{
+	return -ENODEV;
+}
+
+static inline size_t rk_rpmsg_ring_rx_span(struct rk_rpmsg_ring *ring,
+					   const void **buf)
+{
+	return 0;
+}
+
+static inline int rk_rpmsg_ring_rx_release(struct rk_rpmsg_ring *ring,
+					   size_t len)
+{
+	return -ENODEV;
+}
+#endif
+
 #endif /* ROCKCHIP_RPMSG_H */
@@ -28,6 +28,7 @@
 #define IMEI_ID				15
 #define LAN_RGMII_DL_ID			16
 #define EINK_VCOM_ID			17
+#define SFC_DLL_ID			18
 
 #if IS_REACHABLE(CONFIG_ROCKCHIP_VENDOR_STORAGE)
 int rk_vendor_read(u32 id, void *pbuf, u32 size);
@@ -4,12 +4,18 @@
 #ifndef _ROCKCHIP_DECOMPRESS
 #define _ROCKCHIP_DECOMPRESS
 
+#include <linux/types.h>
+
 enum decom_mod {
 	LZ4_MOD,
 	GZIP_MOD,
 	ZLIB_MOD,
+	LZ4_BLOCK_MOD,	/* bare LZ4 block, rk_decom_buf() only */
 };
 
+/* Outputs smaller than this are left to software by rk_decom_buf() */
+#define RK_DECOM_BUF_MIN_SIZE		(16 * 1024)
+
 /* The high 16 bits indicate whether decompression is non-blocking */
 #define DECOM_NOBLOCKING		(0x00010000)
 
@@ -27,6 +33,9 @@ static inline bool rk_get_noblocking_flag(u32 mode)
 int rk_decom_start(u32 mode, phys_addr_t src, phys_addr_t dst, u32 dst_max_size);
 /* timeout in seconds */
 int rk_decom_wait_done(u32 timeout, u64 *decom_len);
+bool rk_decom_available(void);
+int rk_decom_buf(u32 mode, const void *src, size_t src_len,
+		 void *dst, size_t dst_len);
 #else
 static inline int rk_decom_start(u32 mode, phys_addr_t src, phys_addr_t dst, u32 dst_max_size)
 {
@@ -37,6 +46,17 @@ static inline int rk_decom_wait_done(u32 timeout, u64 *decom_len)
 {
 	return -EINVAL;
 }
+
+static inline bool rk_decom_available(void)
+{
+	return false;
+}
+
+static inline int rk_decom_buf(u32 mode, const void *src, size_t src_len,
+			       void *dst, size_t dst_len)
+{
+	return -EOPNOTSUPP;
+}
 #endif
 
 #endif
@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __SOC_ROCKCHIP_DRM_METER_H
+#define __SOC_ROCKCHIP_DRM_METER_H
+
+#include <linux/types.h>
+
+#define ROCKCHIP_DRM_METER_MAX_CHANNELS	8
+
+/**
+ * struct rockchip_drm_meter_levels - what the level meter overlay shows
+ * @channels: number of valid @peak entries, 0 hides the overlay
+ * @peak: linear peak of each channel since the last update, 0..0xffff
+ * @pos_ms: position in the playing track
+ * @len_ms: length of the playing track, 0 hides the progress bar
+ */
+struct rockchip_drm_meter_levels {
+	unsigned int channels;
+	u16 peak[ROCKCHIP_DRM_METER_MAX_CHANNELS];
+	u32 pos_ms;
+	u32 len_ms;
+};
+
+#if IS_ENABLED(CONFIG_ROCKCHIP_DRM_METER) && IS_REACHABLE(CONFIG_DRM_ROCKCHIP)
+void rockchip_drm_meter_update(const struct rockchip_drm_meter_levels *levels);
+#else
+static inline void
+rockchip_drm_meter_update(const struct rockchip_drm_meter_levels *levels)
+{
+}
+#endif
+
+#endif /* __SOC_ROCKCHIP_DRM_METER_H */
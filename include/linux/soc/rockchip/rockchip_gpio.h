@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __SOC_ROCKCHIP_GPIO_H
+#define __SOC_ROCKCHIP_GPIO_H
+
+#include <linux/timekeeping.h>
+
+#if IS_REACHABLE(CONFIG_GPIO_ROCKCHIP)
+int rockchip_gpio_irq_timestamp_enable(unsigned int irq, bool enable);
+int rockchip_gpio_irq_timestamp(unsigned int irq,
+				struct system_time_snapshot *snap);
+#else
+static inline int rockchip_gpio_irq_timestamp_enable(unsigned int irq,
+						     bool enable)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline int rockchip_gpio_irq_timestamp(unsigned int irq,
+					      struct system_time_snapshot *snap)
+{
+	return -EOPNOTSUPP;
+}
+#endif
+
+#endif /* __SOC_ROCKCHIP_GPIO_H */
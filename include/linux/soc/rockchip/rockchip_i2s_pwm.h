@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __SOC_ROCKCHIP_I2S_PWM_H
+#define __SOC_ROCKCHIP_I2S_PWM_H
+
+#include <linux/pwm.h>
+
+/**
+ * struct rockchip_i2s_pwm_stream - duty cycle stream of an I2S PWM
+ * @carrier_hz: PWM frequency, each I2S frame is one PWM period
+ * @frame_bits: duty cycle resolution, even and from 32 to 64. Halving it
+ *		doubles the highest carrier the bit clock allows
+ * @period_frames: duty values per DMA period
+ * @periods: DMA periods in the ring, at least 2
+ * @polarity: output polarity
+ * @period_elapsed: called from the DMA callback after each period, may
+ *		    refill the ring with rockchip_i2s_pwm_stream_write()
+ * @data: passed to @period_elapsed
+ */
+struct rockchip_i2s_pwm_stream {
+	unsigned int carrier_hz;
+	unsigned int frame_bits;
+	unsigned int period_frames;
+	unsigned int periods;
+	enum pwm_polarity polarity;
+	void (*period_elapsed)(void *data);
+	void *data;
+};
+
+#if IS_REACHABLE(CONFIG_PWM_ROCKCHIP_I2S)
+int rockchip_i2s_pwm_stream_start(struct pwm_device *pwm,
+				  const struct rockchip_i2s_pwm_stream *stream);
+int rockchip_i2s_pwm_stream_write(struct pwm_device *pwm, const u8 *duty,
+				  unsigned int count);
+void rockchip_i2s_pwm_stream_stop(struct pwm_device *pwm);
+#else
+static inline int
+rockchip_i2s_pwm_stream_start(struct pwm_device *pwm,
+			      const struct rockchip_i2s_pwm_stream *stream)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline int rockchip_i2s_pwm_stream_write(struct pwm_device *pwm,
+						const u8 *duty,
+						unsigned int count)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline void rockchip_i2s_pwm_stream_stop(struct pwm_device *pwm)
+{
+}
+#endif
+
+#endif /* __SOC_ROCKCHIP_I2S_PWM_H */
@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __SOC_ROCKCHIP_LP_PLAYBACK_H
+#define __SOC_ROCKCHIP_LP_PLAYBACK_H
+
+#include <linux/types.h>
+
+/**
+ * struct rockchip_lp_playback - PCM left running over system suspend
+ * @buf: physical address of the cyclic DMA buffer
+ * @size: size of @buf in bytes
+ * @pos: offset in @buf the DMA reads at suspend
+ * @avail: bytes of valid data from @pos on
+ * @byte_rate: bytes the DMA consumes per second
+ * @wake_bytes: the MCU wakes the system up when fewer bytes are left
+ * @ddr: @buf is in DDR, which can't go to self-refresh then
+ *
+ * The I2S controller and its DMA keep playing while the system sleeps,
+ * the HPMCU only follows their progress and wakes Linux to refill.
+ */
+struct rockchip_lp_playback {
+	u32 buf;
+	u32 size;
+	u32 pos;
+	u32 avail;
+	u32 byte_rate;
+	u32 wake_bytes;
+	bool ddr;
+};
+
+#if IS_ENABLED(CONFIG_RV1106_HPMCU_LP_PLAYBACK)
+void rockchip_lp_playback_set(const struct rockchip_lp_playback *pb);
+#else
+static inline void rockchip_lp_playback_set(const struct rockchip_lp_playback *pb)
+{
+}
+#endif
+
+#endif /* __SOC_ROCKCHIP_LP_PLAYBACK_H */
@@ -0,0 +1,20 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __SOC_ROCKCHIP_PWM_H
+#define __SOC_ROCKCHIP_PWM_H
+
+#include <linux/pwm.h>
+
+#if IS_REACHABLE(CONFIG_PWM_ROCKCHIP)
+int rockchip_pwm_measure_freq(struct pwm_device *pwm, unsigned int periods,
+			      u64 *freq_mhz, unsigned long timeout);
+#else
+static inline int rockchip_pwm_measure_freq(struct pwm_device *pwm,
+					    unsigned int periods,
+					    u64 *freq_mhz,
+					    unsigned long timeout)
+{
+	return -EOPNOTSUPP;
+}
+#endif
+
+#endif /* __SOC_ROCKCHIP_PWM_H */
@@ -0,0 +1,28 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#ifndef __SOC_ROCKCHIP_CPUFREQ_H
+#define __SOC_ROCKCHIP_CPUFREQ_H
+
+#include <linux/list.h>
+#include <linux/types.h>
+
+/* one per PCM stream, the cpu floor follows the emptiest buffer of them */
+struct cpufreq_audio_req {
+	struct list_head node;
+	int fill;
+	bool active;
+};
+
+#if IS_REACHABLE(CONFIG_ARM_ROCKCHIP_CPUFREQ)
+void rockchip_cpufreq_audio_fill_update(struct cpufreq_audio_req *req,
+					int fill);
+#else
+static inline void
+rockchip_cpufreq_audio_fill_update(struct cpufreq_audio_req *req, int fill)
+{
+}
+#endif
+
+#endif
@@ -49,9 +49,11 @@ struct dmcfreq_common_info {
 	struct devfreq *devfreq;
 	struct freq_map_table *vop_bw_tbl;
 	struct freq_map_table *vop_frame_bw_tbl;
+	struct freq_map_table *audio_bw_tbl;
 	struct rl_map_table *vop_pn_rl_tbl;
 	struct delayed_work msch_rl_work;
 	unsigned long vop_req_rate;
+	unsigned long audio_req_rate;
 	unsigned int read_latency;
 	unsigned int auto_freq_en;
 	bool is_msch_rl_work_started;
@@ -64,6 +66,22 @@ struct dmcfreq_vop_info {
 	unsigned int plane_num;
 };
 
+/* one per PCM stream, the dmc floor follows the sum of all of them */
+struct dmcfreq_audio_req {
+	unsigned int kbyte;
+};
+
+/**
+ * struct dmcfreq_blackout - DDR frequency change timing constraint
+ * @node:	entry in the dmcfreq blackout list
+ * @safe_in_us:	return 0 if the DDR bus may stall now, or else how many
+ *		microseconds to wait before it may
+ */
+struct dmcfreq_blackout {
+	struct list_head node;
+	unsigned int (*safe_in_us)(struct dmcfreq_blackout *blackout);
+};
+
 #if IS_REACHABLE(CONFIG_ARM_ROCKCHIP_DMC_DEVFREQ)
 void rockchip_dmcfreq_lock(void);
 void rockchip_dmcfreq_lock_nested(void);
@@ -74,6 +92,11 @@ int rockchip_dmcfreq_wait_complete(void);
 int rockchip_dmcfreq_vop_bandwidth_init(struct dmcfreq_common_info *info);
 int rockchip_dmcfreq_vop_bandwidth_request(struct dmcfreq_vop_info *vop_info);
 void rockchip_dmcfreq_vop_bandwidth_update(struct dmcfreq_vop_info *vop_info);
+void rockchip_dmcfreq_audio_bandwidth_update(struct dmcfreq_audio_req *req,
+					     unsigned int kbyte);
+int rockchip_dmcfreq_register_blackout(struct dmcfreq_blackout *blackout);
+void rockchip_dmcfreq_unregister_blackout(struct dmcfreq_blackout *blackout);
+void rockchip_dmcfreq_wait_blackout(void);
 #else
 static inline void rockchip_dmcfreq_lock(void)
 {
@@ -116,6 +139,27 @@ static inline void
 rockchip_dmcfreq_vop_bandwidth_init(struct dmcfreq_common_info *info)
 {
 }
+
+static inline void
+rockchip_dmcfreq_audio_bandwidth_update(struct dmcfreq_audio_req *req,
+					unsigned int kbyte)
+{
+}
+
+static inline int
+rockchip_dmcfreq_register_blackout(struct dmcfreq_blackout *blackout)
+{
+	return 0;
+}
+
+static inline void
+rockchip_dmcfreq_unregister_blackout(struct dmcfreq_blackout *blackout)
+{
+}
+
+static inline void rockchip_dmcfreq_wait_blackout(void)
+{
+}
 #endif
 
 #endif
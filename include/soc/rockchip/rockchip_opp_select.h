@@ -73,6 +73,8 @@ struct rockchip_opp_info {
 	unsigned int pvtpll_avg_offset;
 	unsigned int pvtpll_min_rate;
 	unsigned int pvtpll_volt_step;
+	/* The pvtpll margin (per mille of the rate) kept by runtime avs */
+	unsigned int pvtpll_avs_margin;
 	int num_clks;
 	/* The read margin for low voltage */
 	u32 low_rm;
@@ -87,6 +89,10 @@ void rockchip_of_get_lkg_sel(struct device *dev, struct device_node *np,
 			     int *volt_sel, int *scale_sel);
 void rockchip_pvtpll_calibrate_opp(struct rockchip_opp_info *info);
 void rockchip_pvtpll_add_length(struct rockchip_opp_info *info);
+int rockchip_pvtpll_avs_get_volt(struct rockchip_opp_info *info,
+				 struct regulator *reg, unsigned long rate,
+				 unsigned long volt, unsigned long volt_min,
+				 unsigned long volt_max, unsigned long *target);
 void rockchip_of_get_pvtm_sel(struct device *dev, struct device_node *np,
 			      char *reg_name, int process,
 			      int *volt_sel, int *scale_sel);
@@ -147,6 +153,15 @@ static inline void rockchip_pvtpll_add_length(struct rockchip_opp_info *info)
 {
 }
 
+static inline int
+rockchip_pvtpll_avs_get_volt(struct rockchip_opp_info *info,
+			     struct regulator *reg, unsigned long rate,
+			     unsigned long volt, unsigned long volt_min,
+			     unsigned long volt_max, unsigned long *target)
+{
+	return -EOPNOTSUPP;
+}
+
 static inline void rockchip_of_get_pvtm_sel(struct device *dev,
 					    struct device_node *np,
 					    char *reg_name, int process,
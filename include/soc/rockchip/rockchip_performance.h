@@ -5,12 +5,32 @@
 #ifndef __SOC_ROCKCHIP_PERFORMANCE_H
 #define __SOC_ROCKCHIP_PERFORMANCE_H
 
+#include <linux/list.h>
+#include <linux/types.h>
+
+struct task_struct;
+
 enum {
 	ROCKCHIP_PERFORMANCE_LOW = 0,
 	ROCKCHIP_PERFORMANCE_NORMAL,
 	ROCKCHIP_PERFORMANCE_HIGH
 };
 
+/*
+ * One per PCM stream: while running, the uclamp min of @task follows the
+ * CPU capacity its measured load needs.
+ */
+struct rockchip_perf_audio {
+	struct list_head node;
+	struct task_struct *task;
+	bool running;
+	bool applied;
+	int orig_util_min;
+	unsigned int util_min;
+	u64 stamp;
+	u64 exec;
+};
+
 #ifdef CONFIG_ROCKCHIP_PERFORMANCE
 extern int rockchip_perf_get_level(void);
 extern struct cpumask *rockchip_perf_get_cpul_mask(void);
@@ -18,6 +38,11 @@ extern struct cpumask *rockchip_perf_get_cpub_mask(void);
 extern int rockchip_perf_select_rt_cpu(int prev_cpu, struct cpumask *lowest_mask);
 extern bool rockchip_perf_misfit_rt(int cpu);
 extern void rockchip_perf_uclamp_sync_util_min_rt_default(void);
+extern void rockchip_perf_audio_get(struct rockchip_perf_audio *audio,
+				    struct task_struct *task);
+extern void rockchip_perf_audio_put(struct rockchip_perf_audio *audio);
+extern void rockchip_perf_audio_set_running(struct rockchip_perf_audio *audio,
+					    bool running);
 #else
 static inline int rockchip_perf_get_level(void) { return ROCKCHIP_PERFORMANCE_NORMAL; }
 static inline struct cpumask *rockchip_perf_get_cpul_mask(void) { return NULL; };
@@ -28,6 +53,11 @@ static inline int rockchip_perf_select_rt_cpu(int prev_cpu, struct cpumask *lowe
 }
 static inline bool rockchip_perf_misfit_rt(int cpu) { return false; }
 static inline void rockchip_perf_uclamp_sync_util_min_rt_default(void) {}
+static inline void rockchip_perf_audio_get(struct rockchip_perf_audio *audio,
+					   struct task_struct *task) {}
+static inline void rockchip_perf_audio_put(struct rockchip_perf_audio *audio) {}
+static inline void
+rockchip_perf_audio_set_running(struct rockchip_perf_audio *audio, bool running) {}
 #endif
 
 #endif
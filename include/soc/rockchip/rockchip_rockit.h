@@ -146,6 +146,7 @@ int rkcif_rockit_config_stream(struct rockit_rkcif_cfg *input_rockit_cfg,
 				int width, int height, int v4l2_fmt);
 int rkcif_rockit_resume_stream(struct rockit_rkcif_cfg *input_rockit_cfg);
 int rkcif_rockit_pause_stream(struct rockit_rkcif_cfg *input_rockit_cfg);
+int rkcif_rockit_free_stream_buf(struct rockit_rkcif_cfg *input_rockit_cfg);
 
 #else
 
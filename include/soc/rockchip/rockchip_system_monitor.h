@@ -162,6 +162,7 @@ int rockchip_monitor_dev_high_temp_adjust(struct monitor_dev_info *info,
 int rockchip_monitor_suspend_low_temp_adjust(int cpu);
 int rockchip_system_monitor_register_notifier(struct notifier_block *nb);
 void rockchip_system_monitor_unregister_notifier(struct notifier_block *nb);
+unsigned int rockchip_system_monitor_get_cpu_budget(void);
 #else
 static inline struct monitor_dev_info *
 rockchip_system_monitor_register(struct device *dev,
@@ -232,6 +233,11 @@ static inline void
 rockchip_system_monitor_unregister_notifier(struct notifier_block *nb)
 {
 };
+
+static inline unsigned int rockchip_system_monitor_get_cpu_budget(void)
+{
+	return 100;
+};
 #endif /* CONFIG_ROCKCHIP_SYSTEM_MONITOR */
 
 #endif
@@ -124,6 +124,7 @@ struct snd_card {
 	bool registered;		/* card_dev is registered? */
 	int sync_irq;			/* assigned irq, used for PCM sync */
 	wait_queue_head_t remove_sleep;
+	atomic_t hw_rules_gen;		/* bumped when PCM hw rules may change */
 
 	size_t total_pcm_alloc_bytes;	/* total amount of allocated buffers */
 	struct mutex memory_mutex;	/* protection for the above */
@@ -34,6 +34,8 @@ snd_pcm_uframes_t snd_dmaengine_pcm_pointer_no_residue(struct snd_pcm_substream
 int snd_dmaengine_pcm_open(struct snd_pcm_substream *substream,
 	struct dma_chan *chan);
 int snd_dmaengine_pcm_close(struct snd_pcm_substream *substream);
+void snd_dmaengine_pcm_set_hardirq_callback(struct snd_pcm_substream *substream,
+	bool enable);
 
 int snd_dmaengine_pcm_open_request_chan(struct snd_pcm_substream *substream,
 	dma_filter_fn filter_fn, void *filter_data);
@@ -109,6 +111,16 @@ int snd_dmaengine_pcm_refine_runtime_hwparams(
  * playback.
  */
 #define SND_DMAENGINE_PCM_FLAG_HALF_DUPLEX BIT(3)
+/*
+ * The period callback may run from the interrupt handler of the DMA
+ * controller instead of its tasklet, see DMA_PREP_CALLBACK_HARDIRQ.
+ */
+#define SND_DMAENGINE_PCM_FLAG_HARDIRQ_CB BIT(4)
+/*
+ * Allocate the buffer page by page (SNDRV_DMA_TYPE_DEV_SG) when the DMA
+ * channel can loop over a scatterlist, see device_prep_dma_cyclic_sg.
+ */
+#define SND_DMAENGINE_PCM_FLAG_SG BIT(5)
 
 /**
  * struct snd_dmaengine_pcm_config - Configuration data for dmaengine based PCM
@@ -16,6 +16,7 @@
 #include <linux/bitops.h>
 #include <linux/pm_qos.h>
 #include <linux/refcount.h>
+#include <linux/hrtimer.h>
 
 #define snd_pcm_substream_chip(substream) ((substream)->private_data)
 #define snd_pcm_chip(pcm) ((pcm)->private_data)
@@ -46,6 +47,7 @@ struct snd_pcm_hardware {
 
 struct snd_pcm_status64;
 struct snd_pcm_substream;
+struct snd_pcm_hw_refine_cache;
 
 struct snd_pcm_audio_tstamp_config; /* definitions further down */
 struct snd_pcm_audio_tstamp_report;
@@ -354,6 +356,8 @@ struct snd_pcm_runtime {
 	unsigned long hw_ptr_buffer_jiffies; /* buffer time in jiffies */
 	snd_pcm_sframes_t delay;	/* extra delay; typically FIFO size */
 	u64 hw_ptr_wrap;                /* offset for hw_ptr due to boundary wrap-around */
+	unsigned int period_coalesce;	/* period interrupts per hw_ptr update */
+	unsigned int period_pending;	/* period interrupts not yet processed */
 
 	/* -- HW params -- */
 	snd_pcm_access_t access;	/* access mode */
@@ -406,6 +410,7 @@ struct snd_pcm_runtime {
 	/* -- hardware description -- */
 	struct snd_pcm_hardware hw;
 	struct snd_pcm_hw_constraints hw_constraints;
+	struct snd_pcm_hw_refine_cache *hw_refine_cache;
 
 	/* -- timer -- */
 	unsigned int timer_resolution;	/* timer resolution */
@@ -451,6 +456,12 @@ struct snd_pcm_substream {
 	char name[32];			/* substream name */
 	int stream;			/* stream (direction) */
 	struct pm_qos_request latency_pm_qos_req; /* pm_qos request */
+	/* -- SNDRV_PCM_IOCTL_DL_RESERVE -- */
+	struct task_struct *dl_task;	/* thread running with the reservation */
+	unsigned int dl_budget;		/* its runtime, permille of the period */
+	int dl_saved_policy;		/* scheduling given back on release */
+	int dl_saved_prio;
+	int dl_saved_nice;
 	size_t buffer_bytes_max;	/* limit ring buffer size */
 	struct snd_dma_buffer dma_buffer;
 	size_t dma_max;
@@ -461,6 +472,7 @@ struct snd_pcm_substream {
         /* -- timer section -- */
 	struct snd_timer *timer;		/* timer */
 	unsigned timer_running: 1;	/* time is running */
+	struct hrtimer hwptr_timer;	/* publishes hw_ptr to the status page */
 	long wait_time;	/* time in ms for R/W to wait for avail */
 	/* -- next substream -- */
 	struct snd_pcm_substream *next;
@@ -1180,9 +1180,13 @@ struct snd_soc_pcm_runtime {
 	/* function mark */
 	struct snd_pcm_substream *mark_startup;
 
+	/* resolved by soc_new_pcm() for the per-period pointer call */
+	struct snd_soc_component *pointer_component;
+
 	/* bit field */
 	unsigned int pop_wait:1;
 	unsigned int fe_compr:1; /* for Dynamic PCM */
+	unsigned int dai_delay:1; /* a DAI has a delay op */
 
 	int num_components;
 
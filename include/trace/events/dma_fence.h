@@ -83,6 +83,55 @@ DEFINE_EVENT(dma_fence, dma_fence_wait_end,
 	TP_ARGS(fence)
 );
 
+/*
+ * Ties a fence to the device job that signals it (producer) or that waits
+ * for it before starting (consumer). A job uses the same @frame for both,
+ * so a pipeline is the chain producer -> consumer -> producer of the next
+ * stage, see tools/dma-buf/fence_timeline.py.
+ */
+DECLARE_EVENT_CLASS(dma_fence_dev,
+
+	TP_PROTO(struct dma_fence *fence, const char *dev, u64 frame),
+
+	TP_ARGS(fence, dev, frame),
+
+	TP_STRUCT__entry(
+		__string(driver, fence->ops->get_driver_name(fence))
+		__string(timeline, fence->ops->get_timeline_name(fence))
+		__field(unsigned int, context)
+		__field(unsigned int, seqno)
+		__string(dev, dev)
+		__field(u64, frame)
+	),
+
+	TP_fast_assign(
+		__assign_str(driver, fence->ops->get_driver_name(fence))
+		__assign_str(timeline, fence->ops->get_timeline_name(fence))
+		__entry->context = fence->context;
+		__entry->seqno = fence->seqno;
+		__assign_str(dev, dev)
+		__entry->frame = frame;
+	),
+
+	TP_printk("driver=%s timeline=%s context=%u seqno=%u dev=%s frame=%llu",
+		  __get_str(driver), __get_str(timeline), __entry->context,
+		  __entry->seqno, __get_str(dev), __entry->frame)
+);
+
+DEFINE_EVENT(dma_fence_dev, dma_fence_producer,
+
+	TP_PROTO(struct dma_fence *fence, const char *dev, u64 frame),
+
+	TP_ARGS(fence, dev, frame)
+);
+
+DEFINE_EVENT(dma_fence_dev, dma_fence_consumer,
+
+	TP_PROTO(struct dma_fence *fence, const char *dev, u64 frame),
+
+	TP_ARGS(fence, dev, frame)
+);
+
 #endif /*  _TRACE_DMA_FENCE_H */
 
 /* This part must be outside protection */
@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM pl330
+
+#if !defined(_TRACE_PL330_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_PL330_H
+
+#include <linux/dmaengine.h>
+#include <linux/tracepoint.h>
+
+/* A channel thread signalled its event, from the DMAC interrupt */
+TRACE_EVENT(pl330_rqcb,
+	TP_PROTO(struct dma_chan *chan, int err),
+
+	TP_ARGS(chan, err),
+
+	TP_STRUCT__entry(
+		__string(chan, dma_chan_name(chan))
+		__field(int, err)
+	),
+
+	TP_fast_assign(
+		__assign_str(chan, dma_chan_name(chan));
+		__entry->err = err;
+	),
+
+	TP_printk("chan=%s err=%d", __get_str(chan), __entry->err)
+);
+
+/* The channel tasklet is about to run the client callback of a cyclic desc */
+TRACE_EVENT(pl330_callback,
+	TP_PROTO(struct dma_chan *chan),
+
+	TP_ARGS(chan),
+
+	TP_STRUCT__entry(
+		__string(chan, dma_chan_name(chan))
+	),
+
+	TP_fast_assign(
+		__assign_str(chan, dma_chan_name(chan));
+	),
+
+	TP_printk("chan=%s", __get_str(chan))
+);
+
+#endif /* _TRACE_PL330_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
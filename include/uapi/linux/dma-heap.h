@@ -44,6 +44,18 @@ struct dma_heap_phys_data {
 	__u32 fd;
 };
 
+/**
+ * struct dma_heap_prewarm_data - pool fill request passed from userspace
+ * @len:		size of one buffer
+ * @count:		number of buffers of that size to keep ready
+ * @reserved:		must be zero
+ */
+struct dma_heap_prewarm_data {
+	__u64 len;
+	__u32 count;
+	__u32 reserved;
+};
+
 #define DMA_HEAP_IOC_MAGIC		'H'
 
 /**
@@ -58,4 +70,15 @@ struct dma_heap_phys_data {
 #define DMA_HEAP_IOCTL_GET_PHYS	_IOWR(DMA_HEAP_IOC_MAGIC, 0x1, \
 				      struct dma_heap_phys_data)
 
+/**
+ * DOC: DMA_HEAP_IOCTL_PREWARM - fill the heap pools ahead of allocation
+ *
+ * Takes a dma_heap_prewarm_data struct and tops the page pools of a heap
+ * up with enough zeroed pages for @count allocations of @len, so that
+ * those allocations do not hit the page allocator. Pooled pages are still
+ * given back under memory pressure.
+ */
+#define DMA_HEAP_IOCTL_PREWARM	_IOW(DMA_HEAP_IOC_MAGIC, 0x2, \
+				     struct dma_heap_prewarm_data)
+
 #endif /* _UAPI_LINUX_DMABUF_POOL_H */
@@ -59,6 +59,7 @@ struct sockaddr_ll {
 #define PACKET_ROLLOVER_STATS		21
 #define PACKET_FANOUT_DATA		22
 #define PACKET_IGNORE_OUTGOING		23
+#define PACKET_RX_RETIRE		24
 
 #define PACKET_FANOUT_HASH		0
 #define PACKET_FANOUT_LB		1
@@ -285,6 +286,18 @@ struct tpacket_req3 {
 	unsigned int	tp_feature_req_word;
 };
 
+/*
+ * PACKET_RX_RETIRE, set before a TPACKET_V3 PACKET_RX_RING: retire a block
+ * once it holds tp_retire_pkts packets, or tp_retire_usecs after its first
+ * packet arrived, whichever comes first (0 disables either bound). The
+ * tp_retire_blk_tov timer stays as a backstop. ts_first_pkt of such blocks
+ * is the timestamp of their first packet, as chosen by PACKET_TIMESTAMP.
+ */
+struct tpacket_rx_retire {
+	unsigned int	tp_retire_pkts;
+	unsigned int	tp_retire_usecs;
+};
+
 union tpacket_req_u {
 	struct tpacket_req	req;
 	struct tpacket_req3	req3;
@@ -103,6 +103,21 @@
 
 #define RKISP_CMD_SET_IQTOOL_CONN_ID \
 	_IOW('V', BASE_VIDIOC_PRIVATE + 113, int)
+
+/*
+ * Mainpath wrap output to userspace instead of the encoder, isp32 only.
+ * After RKISP_CMD_SET_WRAP_LINE and VIDIOC_S_FMT, and before each
+ * VIDIOC_STREAMON: returns the ring as a dma-buf fd. No vb2 buffers are
+ * needed then. The first wrap_line lines of the frame are at the start
+ * of each plane, the next lines overwrite them, and so on.
+ * RKISP_V4L2_EVENT_WRAP_SLICE tells when the lines up to
+ * rkisp_wrap_slice.line of the frame have been written.
+ */
+#define RKISP_CMD_GET_WRAP_BUF \
+	_IOWR('V', BASE_VIDIOC_PRIVATE + 114, struct rkisp_wrap_buf)
+
+#define RKISP_V4L2_EVENT_WRAP_SLICE \
+	(V4L2_EVENT_PRIVATE_START + 4)
 /*************************************************************/
 
 #define ISP2X_ID_DPCC			(0)
@@ -416,6 +431,32 @@ struct rkisp_wrap_info {
 	int height;
 };
 
+/* struct rkisp_wrap_buf
+ * slice_line: lines between slice events, multiple of 16, set by user
+ * fd: dma-buf of the ring, owned by the caller
+ * size: size of the ring
+ * uv_offset: offset of the chroma plane in the ring
+ * bytesperline: stride of both planes
+ * wrap_line: luma lines in the ring
+ */
+struct rkisp_wrap_buf {
+	int slice_line;
+	int fd;
+	unsigned int size;
+	unsigned int uv_offset;
+	unsigned int bytesperline;
+	unsigned int wrap_line;
+};
+
+/* struct rkisp_wrap_slice, RKISP_V4L2_EVENT_WRAP_SLICE payload
+ * sequence: frame the slice is from
+ * line: lines of the frame written so far, the height at frame end
+ */
+struct rkisp_wrap_slice {
+	unsigned int sequence;
+	unsigned int line;
+};
+
 #define RKISP_TB_STREAM_BUF_MAX 5
 struct rkisp_tb_stream_buf {
 	unsigned int dma_addr;
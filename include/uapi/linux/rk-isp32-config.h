@@ -73,6 +73,8 @@
 #define ISP32_STAT_DHAZ			ISP3X_STAT_DHAZ
 #define ISP32_STAT_VSM			BIT(18)
 #define ISP32_STAT_INFO2DDR		BIT(19)
+/* sent before frame end, only the register read results are valid */
+#define ISP32_STAT_PARTIAL		BIT(30)
 #define ISP32_STAT_RTT_FST		BIT(31)
 
 #define ISP32_MESH_BUF_NUM		ISP3X_MESH_BUF_NUM
@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+
+#ifndef _UAPI_LINUX_RK_VAD_H
+#define _UAPI_LINUX_RK_VAD_H
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/*
+ * Pre-roll ring left in the VAD SRAM when the host wakes up. All offsets
+ * are bytes from the start of the read-only mmap() of /dev/vad. The
+ * unread audio starts at pos, is avail bytes long and wraps from end
+ * back to begin. Samples are stored as frame_bytes sized frames.
+ */
+struct vad_ring_info {
+	__u32 begin;
+	__u32 end;
+	__u32 pos;
+	__u32 avail;
+	__u32 frame_bytes;
+	__u32 map_size;
+};
+
+#define VAD_IOC_MAGIC		'V'
+
+#define VAD_IOC_RING_GET	_IOR(VAD_IOC_MAGIC, 0x80, struct vad_ring_info)
+/* mark bytes (a multiple of frame_bytes) from pos as consumed */
+#define VAD_IOC_RING_CONSUME	_IOW(VAD_IOC_MAGIC, 0x81, __u32)
+
+#endif
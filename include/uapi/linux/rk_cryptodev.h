@@ -74,6 +74,80 @@ struct crypt_rsa_op {
 	__u32		out_len;	/* length of output data */
 };
 
+#define RK_CRYPTODEV_BATCH_MAX	64
+
+/*
+ * input of RIOCAUTHCRYPT_BATCH/RIOCASYNCAUTHCRYPT_BATCH
+ *
+ * Runs @count CIOCAUTHCRYPT operations (e.g. all the TLS records of one
+ * socket read) in one call. Each struct crypt_auth_op of @ops is updated as
+ * CIOCAUTHCRYPT would, and its status (0, -EBADMSG for a record failing
+ * verification...) is stored to @results. A failing record doesn't stop
+ * the batch.
+ */
+struct crypt_auth_batch_op {
+	__u64	ops;		/* array of struct crypt_auth_op */
+	__u64	results;	/* array of __s32, status per operation */
+	__u32	count;		/* number of operations */
+	__u32	done;		/* operations run, set on completion */
+};
+
+/*
+ * input of RIOCCRYPT_FD_BATCH/RIOCASYNCCRYPT_FD_BATCH
+ *
+ * Same as struct crypt_auth_batch_op for RIOCCRYPT_FD operations, e.g. the
+ * protected audio segments or SRTP packets of one period. Queued batches
+ * don't run in the context of the caller, so every dma-buf fd they use must
+ * have been mapped with RIOCCRYPT_FD_MAP first, -EBADF is reported for the
+ * operations using an unmapped one.
+ */
+struct crypt_fd_batch_op {
+	__u64	ops;		/* array of struct crypt_fd_op */
+	__u64	results;	/* array of __s32, status per operation */
+	__u32	count;		/* number of operations */
+	__u32	done;		/* operations run, set on completion */
+};
+
+#define RK_SRTP_SALT_LEN	14
+
+/* input of RIOCSRTP_SESSION_SALT */
+struct crypt_srtp_salt_op {
+	__u32	ses;			/* session identifier */
+	__u8	salt[RK_SRTP_SALT_LEN];	/* session salting key */
+	__u8	reserve[2];
+};
+
+/* one packet of RIOCSRTP_BATCH */
+struct crypt_srtp_pkt {
+	__u64	pkt;		/* RTP header + payload, processed in place */
+	__u64	tag;		/* authentication tag, output on encryption */
+	__u32	len;		/* length of header + payload */
+	__u32	hdr_len;	/* RTP header length, CSRCs and extension included */
+	__u32	ssrc;
+	__u32	roc;		/* rollover counter */
+	__u16	seq;		/* RTP sequence number */
+	__u16	reserve;
+	__s32	result;		/* status of the packet, set on completion */
+};
+
+/*
+ * input of RIOCSRTP_BATCH
+ *
+ * Protects (COP_ENCRYPT) or unprotects (COP_DECRYPT) @count packets of the
+ * stream cipher + HMAC session @ses, whose salt was set with
+ * RIOCSRTP_SESSION_SALT. As in RFC 3711 the IV of each packet is derived
+ * from the salt, its SSRC and index, and the tag covers the packet followed
+ * by its ROC, so userspace neither builds IVs nor appends the ROC.
+ */
+struct crypt_srtp_batch_op {
+	__u64	pkts;		/* array of struct crypt_srtp_pkt */
+	__u32	ses;		/* session identifier */
+	__u16	op;		/* COP_ENCRYPT or COP_DECRYPT */
+	__u16	tag_len;	/* length of the tags */
+	__u32	count;		/* number of packets */
+	__u32	done;		/* packets processed, set on completion */
+};
+
 #define RIOCCRYPT_FD		_IOWR('r', 104, struct crypt_fd_op)
 #define RIOCCRYPT_FD_MAP	_IOWR('r', 105, struct crypt_fd_map_op)
 #define RIOCCRYPT_FD_UNMAP	_IOW('r',  106, struct crypt_fd_map_op)
@@ -81,5 +155,14 @@ struct crypt_rsa_op {
 #define RIOCCRYPT_DEV_ACCESS	_IOW('r',  108, struct crypt_fd_map_op)
 #define RIOCCRYPT_RSA_CRYPT	_IOWR('r', 109, struct crypt_rsa_op)
 #define RIOCAUTHCRYPT_FD	_IOWR('r', 110, struct crypt_auth_fd_op)
+#define RIOCAUTHCRYPT_BATCH	_IOWR('r', 111, struct crypt_auth_batch_op)
+/* queued, completion is signalled by POLLIN on the fd */
+#define RIOCASYNCAUTHCRYPT_BATCH	_IOW('r', 112, struct crypt_auth_batch_op)
+#define RIOCASYNCAUTHFETCH_BATCH	_IOR('r', 113, struct crypt_auth_batch_op)
+#define RIOCCRYPT_FD_BATCH	_IOWR('r', 114, struct crypt_fd_batch_op)
+#define RIOCASYNCCRYPT_FD_BATCH	_IOW('r',  115, struct crypt_fd_batch_op)
+#define RIOCASYNCFETCH_FD_BATCH	_IOR('r',  116, struct crypt_fd_batch_op)
+#define RIOCSRTP_SESSION_SALT	_IOW('r',  117, struct crypt_srtp_salt_op)
+#define RIOCSRTP_BATCH		_IOWR('r', 118, struct crypt_srtp_batch_op)
 
 #endif
@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/*
+ * STMMAC UIO userspace ring ABI
+ *
+ * Copyright (C) 2023 Rockchip Electronics Co. Ltd.
+ *
+ * The stmmac_uio driver lends one DMA channel of a GMAC to userspace.
+ * Everything is reached through the UIO device: map N is mmap()ed at
+ * offset N * page size, read() blocks until the channel interrupts and
+ * write() of a non-zero __s32 re-arms the channel interrupt.
+ *
+ * Descriptors are in the native format of the core (see @flags), rings
+ * and buffers are device-coherent and buffer addresses to be programmed
+ * into descriptors are @rx_buf_dma + i * @buf_size (same for TX). The TX
+ * buffers start @tx_buf_offset bytes into STMMAC_UIO_MAP_BUF.
+ */
+#ifndef _UAPI_LINUX_STMMAC_UIO_H
+#define _UAPI_LINUX_STMMAC_UIO_H
+
+#include <linux/types.h>
+
+#define STMMAC_UIO_MAGIC		0x53555530	/* "SUU0" */
+#define STMMAC_UIO_ABI_VERSION		1
+
+/* UIO map indexes, stable across ABI versions */
+enum stmmac_uio_map {
+	STMMAC_UIO_MAP_REGS = 0,	/* MAC/MTL/DMA register window */
+	STMMAC_UIO_MAP_RX_RING,		/* RX descriptor ring */
+	STMMAC_UIO_MAP_TX_RING,		/* TX descriptor ring */
+	STMMAC_UIO_MAP_BUF,		/* RX packet buffers, then TX ones */
+	STMMAC_UIO_MAP_INFO,		/* struct stmmac_uio_info, read-only */
+	STMMAC_UIO_MAP_NUM,
+};
+
+/* struct stmmac_uio_info flags */
+#define STMMAC_UIO_F_GMAC4		(1 << 0)  /* dwmac4/5 descriptors */
+#define STMMAC_UIO_F_XGMAC		(1 << 1)  /* dwxgmac2 descriptors */
+#define STMMAC_UIO_F_EXT_DESC		(1 << 2)  /* extended descriptors */
+#define STMMAC_UIO_F_COEXIST		(1 << 3)  /* kernel keeps other channels */
+
+/**
+ * struct stmmac_uio_info - geometry of the lent channel
+ * @magic:		STMMAC_UIO_MAGIC
+ * @version:		STMMAC_UIO_ABI_VERSION
+ * @flags:		STMMAC_UIO_F_*
+ * @synopsys_id:	core version, as in the MAC version register
+ * @channel:		DMA channel owned by userspace
+ * @regs_offset:	offset of the register block inside map 0
+ * @chan_regs:		offset of the channel DMA registers from the block
+ * @rx_desc_size:	size of one RX descriptor in bytes
+ * @tx_desc_size:	size of one TX descriptor in bytes (larger with TBS)
+ * @rx_ring_size:	number of RX descriptors
+ * @tx_ring_size:	number of TX descriptors
+ * @buf_size:		size of, and stride between, packet buffers
+ * @tx_buf_offset:	offset of the first TX buffer in STMMAC_UIO_MAP_BUF
+ * @rx_ring_dma:	bus address of the RX ring
+ * @tx_ring_dma:	bus address of the TX ring
+ * @rx_buf_dma:		bus address of the first RX buffer
+ * @tx_buf_dma:		bus address of the first TX buffer
+ *
+ * The RX and TX DMA of the channel are left stopped and their rings
+ * empty: userspace fills descriptors, moves the tail pointer and sets
+ * the start bits itself.
+ */
+struct stmmac_uio_info {
+	__u32 magic;
+	__u32 version;
+	__u32 flags;
+	__u32 synopsys_id;
+	__u32 channel;
+	__u32 regs_offset;
+	__u32 chan_regs;
+	__u32 rx_desc_size;
+	__u32 tx_desc_size;
+	__u32 rx_ring_size;
+	__u32 tx_ring_size;
+	__u32 buf_size;
+	__u32 tx_buf_offset;
+	__u32 reserved;
+	__u64 rx_ring_dma;
+	__u64 tx_ring_dma;
+	__u64 rx_buf_dma;
+	__u64 tx_buf_dma;
+};
+
+#endif /* _UAPI_LINUX_STMMAC_UIO_H */
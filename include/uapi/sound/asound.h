@@ -700,6 +700,12 @@ enum {
 #define SNDRV_PCM_IOCTL_READN_FRAMES	_IOR('A', 0x53, struct snd_xfern)
 #define SNDRV_PCM_IOCTL_LINK		_IOW('A', 0x60, int)
 #define SNDRV_PCM_IOCTL_UNLINK		_IO('A', 0x61)
+/*
+ * Run the calling thread SCHED_DEADLINE with the period of the stream as
+ * period and deadline and the given permille of it as runtime, 0 gives the
+ * thread its previous scheduling back. Follows later hw_params changes.
+ */
+#define SNDRV_PCM_IOCTL_DL_RESERVE	_IOW('A', 0x70, int)
 
 /*****************************************************************************
  *                                                                           *
@@ -621,6 +621,20 @@ static int __init populate_rootfs(void)
 	else
 		printk(KERN_INFO "Unpacking initramfs...\n");
 
+#ifdef CONFIG_ROCKCHIP_HW_DECOMPRESS
+	{
+		unsigned long cpio_len;
+		char *cpio = rk_decom_initrd_get(&cpio_len);
+
+		if (cpio) {
+			err = unpack_to_rootfs(cpio, cpio_len);
+			rk_decom_initrd_put();
+			if (!err)
+				goto done;
+		}
+	}
+#endif
+
 	err = unpack_to_rootfs((char *)initrd_start, initrd_end - initrd_start);
 	if (err) {
 #ifdef CONFIG_BLK_DEV_RAM
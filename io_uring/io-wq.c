@@ -8,6 +8,7 @@
 #include <linux/kernel.h>
 #include <linux/init.h>
 #include <linux/errno.h>
+#include <linux/moduleparam.h>
 #include <linux/sched/signal.h>
 #include <linux/percpu.h>
 #include <linux/slab.h>
@@ -15,11 +16,30 @@
 #include <linux/cpu.h>
 #include <linux/tracehook.h>
 #include <uapi/linux/io_uring.h>
+#include <uapi/linux/sched/types.h>
 
 #include "io-wq.h"
 
 #define WORKER_IDLE_TIMEOUT	(5 * HZ)
 
+/*
+ * Workers are cloned from the task that submitted the work and keep its
+ * scheduling parameters. On a single core a burst of blocking requests from
+ * a background task then competes with everything else at that priority.
+ * worker_nice is the highest priority a worker may keep (workers of tasks
+ * already nicer than that are left alone) and worker_uclamp_max caps the
+ * utilization workers can request.
+ */
+static int worker_nice = MIN_NICE;
+module_param(worker_nice, int, 0644);
+MODULE_PARM_DESC(worker_nice, "Minimum nice value of io-wq workers");
+
+#ifdef CONFIG_UCLAMP_TASK
+static unsigned int worker_uclamp_max = SCHED_CAPACITY_SCALE;
+module_param(worker_uclamp_max, uint, 0644);
+MODULE_PARM_DESC(worker_uclamp_max, "Maximum utilization clamp of io-wq workers");
+#endif
+
 enum {
 	IO_WORKER_F_UP		= 1,	/* up and active */
 	IO_WORKER_F_RUNNING	= 2,	/* account as running */
@@ -606,6 +626,27 @@ static void io_worker_handle_work(struct io_worker *worker)
 	} while (1);
 }
 
+static void io_worker_set_sched(void)
+{
+	int nice = clamp_t(int, READ_ONCE(worker_nice), MIN_NICE, MAX_NICE);
+#ifdef CONFIG_UCLAMP_TASK
+	unsigned int uclamp_max = READ_ONCE(worker_uclamp_max);
+
+	if (uclamp_max < SCHED_CAPACITY_SCALE) {
+		struct sched_attr attr = {
+			.sched_flags	= SCHED_FLAG_KEEP_ALL |
+					  SCHED_FLAG_UTIL_CLAMP_MAX,
+			.sched_util_max	= uclamp_max,
+		};
+
+		sched_setattr_nocheck(current, &attr);
+	}
+#endif
+
+	if (task_nice(current) < nice)
+		set_user_nice(current, nice);
+}
+
 static int io_wqe_worker(void *data)
 {
 	struct io_worker *worker = data;
@@ -619,6 +660,7 @@ static int io_wqe_worker(void *data)
 
 	snprintf(buf, sizeof(buf), "iou-wrk-%d", wq->task->pid);
 	set_task_comm(current, buf);
+	io_worker_set_sched();
 
 	while (!test_bit(IO_WQ_BIT_EXIT, &wq->state)) {
 		long ret;
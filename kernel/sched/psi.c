@@ -160,17 +160,35 @@ static int __init setup_psi(char *str)
 }
 __setup("psi=", setup_psi);
 
+/* PSI trigger definitions */
+#define WINDOW_MIN_US 500000	/* Min window size is 500ms */
+#define WINDOW_MAX_US 10000000	/* Max window size is 10s */
+#define KERNEL_WINDOW_MIN_US 100000	/* In-kernel triggers down to 100ms */
+#define UPDATES_PER_WINDOW 10	/* 10 updates per window */
+
+/*
+ * Small memory systems go from reclaim to OOM within a few hundred ms,
+ * allow their userspace to ask for windows shorter than the default.
+ */
+static u32 psi_window_min_us = WINDOW_MIN_US;
+static int __init setup_psi_window_min(char *str)
+{
+	u32 val;
+
+	if (kstrtou32(str, 0, &val))
+		return 0;
+	psi_window_min_us = clamp_t(u32, val, KERNEL_WINDOW_MIN_US,
+				    WINDOW_MIN_US);
+	return 1;
+}
+__setup("psi_window_min_us=", setup_psi_window_min);
+
 /* Running averages - we need to be higher-res than loadavg */
 #define PSI_FREQ	(2*HZ+1)	/* 2 sec intervals */
 #define EXP_10s		1677		/* 1/exp(2s/10s) as fixed-point */
 #define EXP_60s		1981		/* 1/exp(2s/60s) */
 #define EXP_300s	2034		/* 1/exp(2s/300s) */
 
-/* PSI trigger definitions */
-#define WINDOW_MIN_US 500000	/* Min window size is 500ms */
-#define WINDOW_MAX_US 10000000	/* Max window size is 10s */
-#define UPDATES_PER_WINDOW 10	/* 10 updates per window */
-
 /* Sampling frequency in nanoseconds */
 static u64 psi_period __read_mostly;
 
@@ -179,6 +197,7 @@ static DEFINE_PER_CPU(struct psi_group_cpu, system_group_pcpu);
 struct psi_group psi_system = {
 	.pcpu = &system_group_pcpu,
 };
+EXPORT_SYMBOL_GPL(psi_system);
 
 static void psi_avgs_work(struct work_struct *work);
 
@@ -547,7 +566,9 @@ static u64 update_triggers(struct psi_group *group, u64 now)
 		trace_android_vh_psi_event(t);
 
 		/* Generate an event */
-		if (cmpxchg(&t->event, 0, 1) == 0)
+		if (t->notify)
+			t->notify(t, t->data);
+		else if (cmpxchg(&t->event, 0, 1) == 0)
 			wake_up_interruptible(&t->event_wait);
 		t->last_event_time = now;
 	}
@@ -1141,28 +1162,21 @@ static int psi_cpu_open(struct inode *inode, struct file *file)
 	return single_open(file, psi_cpu_show, NULL);
 }
 
-struct psi_trigger *psi_trigger_create(struct psi_group *group,
-			char *buf, size_t nbytes, enum psi_res res)
+static struct psi_trigger *__psi_trigger_create(struct psi_group *group,
+			enum psi_states state, u32 threshold_us, u32 window_us,
+			u32 window_min_us,
+			void (*notify)(struct psi_trigger *t, void *data),
+			void *data)
 {
 	struct psi_trigger *t;
-	enum psi_states state;
-	u32 threshold_us;
-	u32 window_us;
 
 	if (static_branch_likely(&psi_disabled))
 		return ERR_PTR(-EOPNOTSUPP);
 
-	if (sscanf(buf, "some %u %u", &threshold_us, &window_us) == 2)
-		state = PSI_IO_SOME + res * 2;
-	else if (sscanf(buf, "full %u %u", &threshold_us, &window_us) == 2)
-		state = PSI_IO_FULL + res * 2;
-	else
-		return ERR_PTR(-EINVAL);
-
 	if (state >= PSI_NONIDLE)
 		return ERR_PTR(-EINVAL);
 
-	if (window_us < WINDOW_MIN_US ||
+	if (window_us < window_min_us ||
 		window_us > WINDOW_MAX_US)
 		return ERR_PTR(-EINVAL);
 
@@ -1182,6 +1196,8 @@ struct psi_trigger *psi_trigger_create(struct psi_group *group,
 
 	t->event = 0;
 	t->last_event_time = 0;
+	t->notify = notify;
+	t->data = data;
 	init_waitqueue_head(&t->event_wait);
 
 	mutex_lock(&group->trigger_lock);
@@ -1211,6 +1227,53 @@ struct psi_trigger *psi_trigger_create(struct psi_group *group,
 	return t;
 }
 
+struct psi_trigger *psi_trigger_create(struct psi_group *group,
+			char *buf, size_t nbytes, enum psi_res res)
+{
+	enum psi_states state;
+	u32 threshold_us;
+	u32 window_us;
+
+	if (static_branch_likely(&psi_disabled))
+		return ERR_PTR(-EOPNOTSUPP);
+
+	if (sscanf(buf, "some %u %u", &threshold_us, &window_us) == 2)
+		state = PSI_IO_SOME + res * 2;
+	else if (sscanf(buf, "full %u %u", &threshold_us, &window_us) == 2)
+		state = PSI_IO_FULL + res * 2;
+	else
+		return ERR_PTR(-EINVAL);
+
+	return __psi_trigger_create(group, state, threshold_us, window_us,
+				    psi_window_min_us, NULL, NULL);
+}
+
+/**
+ * psi_kernel_trigger_create - watch a pressure state from the kernel
+ * @group: &psi_system, or cgroup_psi() of the cgroup to watch
+ * @state: e.g. PSI_MEM_SOME
+ * @threshold_us: stall time within the window that fires the trigger
+ * @window_us: tracking window, 100ms to 10s
+ * @notify: called at most once per window while the threshold is exceeded
+ * @data: passed to @notify
+ *
+ * Same semantics as a trigger written to /proc/pressure/, but @notify is
+ * called straight from the psimon thread. It may sleep, but must not
+ * create or destroy triggers of @group. Free with psi_trigger_destroy().
+ */
+struct psi_trigger *psi_kernel_trigger_create(struct psi_group *group,
+			enum psi_states state, u32 threshold_us, u32 window_us,
+			void (*notify)(struct psi_trigger *t, void *data),
+			void *data)
+{
+	if (!notify)
+		return ERR_PTR(-EINVAL);
+
+	return __psi_trigger_create(group, state, threshold_us, window_us,
+				    KERNEL_WINDOW_MIN_US, notify, data);
+}
+EXPORT_SYMBOL_GPL(psi_kernel_trigger_create);
+
 void psi_trigger_destroy(struct psi_trigger *t)
 {
 	struct psi_group *group;
@@ -1278,6 +1341,7 @@ void psi_trigger_destroy(struct psi_trigger *t)
 	}
 	kfree(t);
 }
+EXPORT_SYMBOL_GPL(psi_trigger_destroy);
 
 __poll_t psi_trigger_poll(void **trigger_ptr,
 				struct file *file, poll_table *wait)
@@ -199,6 +199,7 @@ static int prb_queue_frozen(struct tpacket_kbdq_core *);
 static void prb_open_block(struct tpacket_kbdq_core *,
 		struct tpacket_block_desc *);
 static void prb_retire_rx_blk_timer_expired(struct timer_list *);
+static enum hrtimer_restart prb_retire_rx_blk_hrtimer_expired(struct hrtimer *);
 static void _prb_refresh_rx_retire_blk_timer(struct tpacket_kbdq_core *);
 static void prb_fill_rxhash(struct tpacket_kbdq_core *, struct tpacket3_hdr *);
 static void prb_clear_rxhash(struct tpacket_kbdq_core *,
@@ -501,6 +502,8 @@ static void *packet_current_frame(struct packet_sock *po,
 static void prb_del_retire_blk_timer(struct tpacket_kbdq_core *pkc)
 {
 	del_timer_sync(&pkc->retire_blk_timer);
+	if (pkc->retire_tmo)
+		hrtimer_cancel(&pkc->retire_hrtimer);
 }
 
 static void prb_shutdown_retire_blk_timer(struct packet_sock *po,
@@ -525,6 +528,12 @@ static void prb_setup_retire_blk_timer(struct packet_sock *po)
 	timer_setup(&pkc->retire_blk_timer, prb_retire_rx_blk_timer_expired,
 		    0);
 	pkc->retire_blk_timer.expires = jiffies;
+
+	if (pkc->retire_tmo) {
+		hrtimer_init(&pkc->retire_hrtimer, CLOCK_MONOTONIC,
+			     HRTIMER_MODE_REL_SOFT);
+		pkc->retire_hrtimer.function = prb_retire_rx_blk_hrtimer_expired;
+	}
 }
 
 static int prb_calc_retire_blk_tmo(struct packet_sock *po,
@@ -597,6 +606,8 @@ static void init_prb_bdqc(struct packet_sock *po,
 						req_u->req3.tp_block_size);
 	p1->tov_in_jiffies = msecs_to_jiffies(p1->retire_blk_tov);
 	p1->blk_sizeof_priv = req_u->req3.tp_sizeof_priv;
+	p1->retire_pkts = po->rx_retire.tp_retire_pkts;
+	p1->retire_tmo = us_to_ktime(po->rx_retire.tp_retire_usecs);
 	rwlock_init(&p1->blk_fill_in_prog_lock);
 
 	p1->max_frame_len = p1->kblk_size - BLK_PLUS_PRIV(p1->blk_sizeof_priv);
@@ -711,6 +722,52 @@ static void prb_retire_rx_blk_timer_expired(struct timer_list *t)
 	spin_unlock(&po->sk.sk_receive_queue.lock);
 }
 
+/*
+ * PACKET_RX_RETIRE: close the block that has been open for retire_tmo
+ * since its first packet, unless it was already retired meanwhile.
+ */
+static enum hrtimer_restart prb_retire_rx_blk_hrtimer_expired(struct hrtimer *t)
+{
+	struct packet_sock *po =
+		container_of(t, struct packet_sock, rx_ring.prb_bdqc.retire_hrtimer);
+	struct tpacket_kbdq_core *pkc = GET_PBDQC_FROM_RB(&po->rx_ring);
+	struct tpacket_block_desc *pbd;
+
+	spin_lock(&po->sk.sk_receive_queue.lock);
+
+	pbd = GET_CURR_PBLOCK_DESC_FROM_CORE(pkc);
+	if (pkc->delete_blk_timer || prb_queue_frozen(pkc) ||
+	    BLOCK_SNUM(pbd) != pkc->retire_seq_num || !BLOCK_NUM_PKTS(pbd))
+		goto out;
+
+	/* Waiting for skb_copy_bits to finish... */
+	write_lock(&pkc->blk_fill_in_prog_lock);
+	write_unlock(&pkc->blk_fill_in_prog_lock);
+
+	prb_retire_current_block(pkc, po, TP_STATUS_BLK_TMO);
+	prb_dispatch_next_block(pkc, po);
+
+out:
+	spin_unlock(&po->sk.sk_receive_queue.lock);
+	return HRTIMER_NORESTART;
+}
+
+/* Called with the fill lock dropped, after the packet was written */
+static void prb_retire_full_block(struct packet_sock *po)
+{
+	struct tpacket_kbdq_core *pkc = GET_PBDQC_FROM_RB(&po->rx_ring);
+	struct tpacket_block_desc *pbd;
+
+	spin_lock(&po->sk.sk_receive_queue.lock);
+	pbd = GET_CURR_PBLOCK_DESC_FROM_CORE(pkc);
+	if (!prb_queue_frozen(pkc) &&
+	    BLOCK_NUM_PKTS(pbd) >= pkc->retire_pkts) {
+		prb_retire_current_block(pkc, po, 0);
+		prb_dispatch_next_block(pkc, po);
+	}
+	spin_unlock(&po->sk.sk_receive_queue.lock);
+}
+
 static void prb_flush_block(struct tpacket_kbdq_core *pkc1,
 		struct tpacket_block_desc *pbd1, __u32 status)
 {
@@ -1008,6 +1065,18 @@ static void prb_fill_curr_block(char *curr,
 	prb_run_all_ft_ops(pkc, ppd);
 }
 
+/* The PACKET_RX_RETIRE time bound runs from the first packet of a block */
+static void prb_arm_retire_hrtimer(struct tpacket_kbdq_core *pkc,
+				   struct tpacket_block_desc *pbd)
+{
+	if (!pkc->retire_tmo || BLOCK_NUM_PKTS(pbd) != 1)
+		return;
+
+	pkc->retire_seq_num = BLOCK_SNUM(pbd);
+	hrtimer_start(&pkc->retire_hrtimer, pkc->retire_tmo,
+		      HRTIMER_MODE_REL_SOFT);
+}
+
 /* Assumes caller has the sk->rx_queue.lock */
 static void *__packet_lookup_frame_in_block(struct packet_sock *po,
 					    struct sk_buff *skb,
@@ -1049,6 +1118,7 @@ static void *__packet_lookup_frame_in_block(struct packet_sock *po,
 	/* first try the current block */
 	if (curr+TOTAL_PKT_LEN_INCL_ALIGN(len) < end) {
 		prb_fill_curr_block(curr, pkc, pbd, len);
+		prb_arm_retire_hrtimer(pkc, pbd);
 		return (void *)curr;
 	}
 
@@ -1060,6 +1130,7 @@ static void *__packet_lookup_frame_in_block(struct packet_sock *po,
 	if (curr) {
 		pbd = GET_CURR_PBLOCK_DESC_FROM_CORE(pkc);
 		prb_fill_curr_block(curr, pkc, pbd, len);
+		prb_arm_retire_hrtimer(pkc, pbd);
 		return (void *)curr;
 	}
 
@@ -1070,6 +1141,23 @@ static void *__packet_lookup_frame_in_block(struct packet_sock *po,
 	return NULL;
 }
 
+/*
+ * Give the block the arrival time of its first packet rather than its
+ * opening time. The fill lock held keeps the block from being retired.
+ */
+static void prb_stamp_first_pkt(struct packet_sock *po, void *frame,
+				const struct timespec64 *ts)
+{
+	struct tpacket_kbdq_core *pkc = GET_PBDQC_FROM_RB(&po->rx_ring);
+	struct tpacket_block_desc *pbd = GET_CURR_PBLOCK_DESC_FROM_CORE(pkc);
+
+	if (frame != (char *)pbd + BLK_PLUS_PRIV(pkc->blk_sizeof_priv))
+		return;
+
+	pbd->hdr.bh1.ts_first_pkt.ts_sec = ts->tv_sec;
+	pbd->hdr.bh1.ts_first_pkt.ts_nsec = ts->tv_nsec;
+}
+
 static void *packet_current_rx_frame(struct packet_sock *po,
 					    struct sk_buff *skb,
 					    int status, unsigned int len)
@@ -2397,6 +2485,8 @@ static int tpacket_rcv(struct sk_buff *skb, struct net_device *dev,
 		h.h3->tp_nsec = ts.tv_nsec;
 		memset(h.h3->tp_padding, 0, sizeof(h.h3->tp_padding));
 		hdrlen = sizeof(*h.h3);
+		if (po->rx_retire.tp_retire_pkts || po->rx_retire.tp_retire_usecs)
+			prb_stamp_first_pkt(po, h.raw, &ts);
 		break;
 	default:
 		BUG();
@@ -2436,6 +2526,8 @@ static int tpacket_rcv(struct sk_buff *skb, struct net_device *dev,
 		sk->sk_data_ready(sk);
 	} else if (po->tp_version == TPACKET_V3) {
 		prb_clear_blk_fill_status(&po->rx_ring);
+		if (po->rx_ring.prb_bdqc.retire_pkts)
+			prb_retire_full_block(po);
 	}
 
 drop_n_restore:
@@ -3828,6 +3920,26 @@ packet_setsockopt(struct socket *sock, int level, int optname, sockptr_t optval,
 		release_sock(sk);
 		return ret;
 	}
+	case PACKET_RX_RETIRE:
+	{
+		struct tpacket_rx_retire retire;
+
+		if (optlen != sizeof(retire))
+			return -EINVAL;
+		if (copy_from_sockptr(&retire, optval, sizeof(retire)))
+			return -EFAULT;
+		if (retire.tp_retire_usecs > USEC_PER_SEC)
+			return -EINVAL;
+		lock_sock(sk);
+		if (po->rx_ring.pg_vec) {
+			ret = -EBUSY;
+		} else {
+			po->rx_retire = retire;
+			ret = 0;
+		}
+		release_sock(sk);
+		return ret;
+	}
 	case PACKET_LOSS:
 	{
 		unsigned int val;
@@ -4080,6 +4192,10 @@ static int packet_getsockopt(struct socket *sock, int level, int optname,
 		data = &rstats;
 		lv = sizeof(rstats);
 		break;
+	case PACKET_RX_RETIRE:
+		data = &po->rx_retire;
+		lv = sizeof(po->rx_retire);
+		break;
 	case PACKET_TX_HAS_OFF:
 		val = po->tp_tx_has_off;
 		break;
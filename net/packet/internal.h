@@ -50,6 +50,12 @@ struct tpacket_kbdq_core {
 
 	/* timer to retire an outstanding block */
 	struct timer_list retire_blk_timer;
+
+	/* PACKET_RX_RETIRE bounds, retire_hrtimer runs from the first packet */
+	unsigned int	retire_pkts;
+	ktime_t		retire_tmo;
+	u32		retire_seq_num;
+	struct hrtimer	retire_hrtimer;
 };
 
 struct pgv {
@@ -132,6 +138,7 @@ struct packet_sock {
 	unsigned int		tp_hdrlen;
 	unsigned int		tp_reserve;
 	unsigned int		tp_tstamp;
+	struct tpacket_rx_retire	rx_retire;
 	struct completion	skb_completion;
 	struct net_device __rcu	*cached_dev;
 	int			(*xmit)(struct sk_buff *skb);
@@ -19,10 +19,15 @@
 #include <linux/clk.h>
 #include <linux/clk-provider.h>
 #include <linux/clk/rockchip.h>
+#include <linux/debugfs.h>
+#include <linux/hrtimer.h>
 #include <linux/pm_runtime.h>
 #include <linux/regmap.h>
 #include <linux/reset.h>
+#include <linux/seq_file.h>
 #include <linux/spinlock.h>
+#include <linux/timekeeping.h>
+#include <linux/workqueue.h>
 #include <sound/pcm_params.h>
 #include <sound/dmaengine_pcm.h>
 
@@ -41,15 +46,115 @@
 
 #define DEFAULT_MCLK_FS				512
 #define DEFAULT_FS				44100
+/* above 192k, mclk is raised so BCLK of a 64-bit frame still divides */
+#define HIGH_RATE_MIN				352800
+#define HIGH_RATE_MCLK_FS			128
 #define CH_GRP_MAX				4  /* The max channel 8 / 2 */
 #define MULTIPLEX_CH_MAX			10
 #define CLK_PPM_MIN				(-1000)
 #define CLK_PPM_MAX				(1000)
 #define MAXBURST_PER_FIFO			8
+#define SERVO_PERIOD_MS				100
+#define SERVO_TARGET_MAX_US			2000000
+#define SERVO_STEP_MAX_PPM			10
+#define SERVO_INTEGRAL_MAX			(CLK_PPM_MAX * 2000LL)
+#define I2S_FIFO_DEPTH				32
+#define DMA_WATERMARK_MAX			31
+#define NEXT_TRACK_MIN_NS			(10 * NSEC_PER_USEC)
 
 #define QUIRK_ALWAYS_ON				BIT(0)
 #define QUIRK_HDMI_PATH				BIT(1)
 
+/*
+ * Native DSD over I2S: every DSD channel owns one SDO lane, the
+ * controller splits each 32-bit DSD_U32_LE word into two 16-bit
+ * slots (HWT cleared), so BCLK runs exactly at the DSD bit rate and
+ * LRCK toggles every 16 bits. ALSA rate is the 32-bit word rate.
+ */
+#define DSD_SLOT_WIDTH				16
+#define DSD_FRAME_WIDTH				(DSD_SLOT_WIDTH * 2)
+
+struct rk_i2s_tdm_dsd_rate {
+	const char *name;
+	unsigned int rate;	/* DSD_U32_LE word rate */
+	unsigned int mclk;	/* mclk_tx rate */
+};
+
+static const struct rk_i2s_tdm_dsd_rate rk_i2s_tdm_dsd_rates[] = {
+	{ "DSD64",	 88200, 512 * 44100 },
+	{ "DSD128",	176400, 512 * 44100 },
+	{ "DSD256",	352800, 512 * 44100 },
+	{ "DSD512",	705600, 512 * 44100 },
+	{ "DSD64x48",	 96000, 512 * 48000 },
+	{ "DSD128x48",	192000, 512 * 48000 },
+	{ "DSD256x48",	384000, 512 * 48000 },
+	{ "DSD512x48",	768000, 512 * 48000 },
+};
+
+/*
+ * Per-stream telemetry, FIFO levels are sampled from the pointer path,
+ * i.e. at every period boundary and every explicit hwsync.
+ */
+struct rk_i2s_tdm_stats {
+	u64 xruns;
+	ktime_t last_xrun;
+	ktime_t last_update;
+	u64 updates;
+	unsigned int fifo_last;
+	unsigned int fifo_min;
+	unsigned int fifo_max;
+	s64 max_update_gap_ns;
+};
+
+/*
+ * DMA tuning per sample rate: at low rates a deep burst with a low
+ * watermark keeps bus wakeups rare, at high rates the FIFO is refilled
+ * earlier with shorter bursts so a late DMA doesn't starve it. Burst
+ * is per lane and must fit into the FIFO space left at the watermark.
+ */
+struct rk_i2s_tdm_dma_tune {
+	unsigned int max_rate;
+	unsigned int watermark;
+	unsigned int burst;
+};
+
+static const struct rk_i2s_tdm_dma_tune rk_i2s_tdm_dma_tunes[] = {
+	{  48000,  8, 16 },
+	{  96000, 12, 16 },
+	{ 192000, 16,  8 },
+	{ 384000, 20,  8 },
+	{ UINT_MAX, 24, 4 },
+};
+
+/*
+ * Clock-drift servo: a PI loop that trims mclk in ppm so that the
+ * playback ring buffer stays at a target fill, which lets a network
+ * source be played bit-perfect without a resampler.
+ *
+ * With the TAI source the loop instead locks the consumed sample count
+ * to CLOCK_TAI. Once phc2sys keeps the system clock on the GMAC PTP
+ * clock, this ties mclk to the PTP grandmaster for AES67 style streams.
+ */
+enum {
+	SERVO_SRC_FILL = 0,
+	SERVO_SRC_TAI,
+};
+
+struct rk_i2s_tdm_servo {
+	struct delayed_work work;
+	unsigned int target_us;	/* 0: fill servo disabled */
+	unsigned int source;
+	bool running;
+	s64 fill_avg_us;	/* EWMA of the buffer fill */
+	s64 integral;
+	int ppm;
+	/* TAI source */
+	ktime_t t0;		/* 0: resync on the next tick */
+	snd_pcm_uframes_t last_pos;
+	u64 frames;
+	s64 offset_ns;		/* audio time minus CLOCK_TAI time */
+};
+
 struct txrx_config {
 	u32 addr;
 	u32 reg;
@@ -90,7 +195,10 @@ struct rk_i2s_tdm_dev {
 	struct clk *hclk_root;
 	bool hclk_root_f;
 	unsigned int hclk_root_x;
-	unsigned int dma_burst, dma_bytes;
+	unsigned int dma_bytes;
+	/* 0 selects the per-rate default from rk_i2s_tdm_dma_tunes */
+	unsigned int dma_burst;
+	unsigned int dma_watermark;
 	//+++c
 	bool mclk_external;
 	bool mclk_ext_mux;
@@ -98,6 +206,10 @@ struct rk_i2s_tdm_dev {
 	struct clk *mclk_ext;
 	struct clk *clk_44;
 	struct clk *clk_48;
+	/* clk_44/clk_48 are the family parents of the internal mclk_tx */
+	bool mclk_family_mux;
+	/* mclk rate of the family currently routed to mclk_tx */
+	unsigned int mclk_family_rate;
 	int dcount;
 	unsigned int frame_width;
 //+++
@@ -133,6 +245,22 @@ struct rk_i2s_tdm_dev {
 	int clk_ppm;
 	atomic_t refcount;
 	spinlock_t lock; /* xfer lock */
+	struct rk_i2s_tdm_stats stats[SNDRV_PCM_STREAM_LAST + 1];
+	struct rk_i2s_tdm_servo servo;
+	/* CLOCK_TAI time the next playback start enables TX at, 0 = now */
+	ktime_t start_time;
+	struct hrtimer start_timer;
+	/*
+	 * Gapless rate switch: once playback is out to next_frame, TX moves
+	 * to next_rate. next_div_bclk is the divider when the mclk family
+	 * stays, 0 if the switch has to go through next_work.
+	 */
+	unsigned int next_rate;
+	unsigned int next_div_bclk;
+	snd_pcm_uframes_t next_frame;
+	struct hrtimer next_timer;
+	struct work_struct next_work;
+	struct dentry *debugfs_dir;
 };
 
 static struct i2s_of_quirks {
@@ -609,6 +737,15 @@ static void rockchip_i2s_tdm_trcm_resume(struct snd_pcm_substream *substream,
 	rockchip_i2s_tdm_xfer_start(i2s_tdm, bstream);
 }
 
+static void rockchip_i2s_tdm_stats_start(struct rk_i2s_tdm_dev *i2s_tdm,
+					 int stream)
+{
+	struct rk_i2s_tdm_stats *st = &i2s_tdm->stats[stream];
+
+	st->fifo_min = UINT_MAX;
+	st->last_update = 0;
+}
+
 static void rockchip_i2s_tdm_start(struct rk_i2s_tdm_dev *i2s_tdm, int stream)
 {
 	/*
@@ -622,6 +759,7 @@ static void rockchip_i2s_tdm_start(struct rk_i2s_tdm_dev *i2s_tdm, int stream)
 		rockchip_i2s_tdm_xfer_stop(i2s_tdm, stream, true);
 	}
 
+	rockchip_i2s_tdm_stats_start(i2s_tdm, stream);
 	rockchip_i2s_tdm_dma_ctrl(i2s_tdm, stream, 1);
 
 	if (i2s_tdm->clk_trcm)
@@ -630,6 +768,44 @@ static void rockchip_i2s_tdm_start(struct rk_i2s_tdm_dev *i2s_tdm, int stream)
 		rockchip_i2s_tdm_xfer_start(i2s_tdm, stream);
 }
 
+static enum hrtimer_restart rockchip_i2s_tdm_start_timer(struct hrtimer *timer)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm =
+		container_of(timer, struct rk_i2s_tdm_dev, start_timer);
+
+	rockchip_i2s_tdm_xfer_start(i2s_tdm, SNDRV_PCM_STREAM_PLAYBACK);
+
+	return HRTIMER_NORESTART;
+}
+
+/*
+ * Timed playback start for synchronized zones: DMA is enabled right away
+ * so the FIFO is pre-filled, only the TXS write is left to a hard hrtimer
+ * at start_time. Returns false if the stream should start immediately.
+ */
+static bool rockchip_i2s_tdm_start_timed(struct rk_i2s_tdm_dev *i2s_tdm)
+{
+	ktime_t t = i2s_tdm->start_time;
+
+	/* one shot */
+	i2s_tdm->start_time = 0;
+
+	/* TRCM and always-on share or keep XFER running, nothing to arm */
+	if (!t || i2s_tdm->clk_trcm || (i2s_tdm->quirks & QUIRK_ALWAYS_ON))
+		return false;
+
+	if (ktime_compare(t, ktime_get_clocktai()) <= 0) {
+		dev_dbg(i2s_tdm->dev, "start time already passed\n");
+		return false;
+	}
+
+	rockchip_i2s_tdm_stats_start(i2s_tdm, SNDRV_PCM_STREAM_PLAYBACK);
+	rockchip_i2s_tdm_dma_ctrl(i2s_tdm, SNDRV_PCM_STREAM_PLAYBACK, 1);
+	hrtimer_start(&i2s_tdm->start_timer, t, HRTIMER_MODE_ABS_HARD);
+
+	return true;
+}
+
 static void rockchip_i2s_tdm_stop(struct rk_i2s_tdm_dev *i2s_tdm, int stream)
 {
 	rockchip_i2s_tdm_dma_ctrl(i2s_tdm, stream, 0);
@@ -836,6 +1012,30 @@ static int rockchip_i2s_tdm_clk_set_rate(struct rk_i2s_tdm_dev *i2s_tdm,
 	return ret;
 }
 
+static int rockchip_i2s_tdm_clk_compensate(struct rk_i2s_tdm_dev *i2s_tdm,
+					   int ppm)
+{
+	int old = i2s_tdm->clk_ppm;
+	int ret;
+
+	if (ppm == old)
+		return 0;
+
+	ret = rockchip_i2s_tdm_clk_set_rate(i2s_tdm, i2s_tdm->mclk_root0,
+					    i2s_tdm->mclk_root0_freq, ppm);
+	if (ret)
+		return ret;
+
+	if (clk_is_match(i2s_tdm->mclk_root0, i2s_tdm->mclk_root1))
+		return 0;
+
+	/* clk_ppm already reflects root0, let root1 follow as well */
+	i2s_tdm->clk_ppm = old;
+
+	return rockchip_i2s_tdm_clk_set_rate(i2s_tdm, i2s_tdm->mclk_root1,
+					     i2s_tdm->mclk_root1_freq, ppm);
+}
+
 static int rockchip_i2s_tdm_calibrate_mclk(struct rk_i2s_tdm_dev *i2s_tdm,
 					   struct snd_pcm_substream *substream,
 					   unsigned int lrck_freq)
@@ -847,6 +1047,7 @@ static int rockchip_i2s_tdm_calibrate_mclk(struct rk_i2s_tdm_dev *i2s_tdm,
 	unsigned int mclk_parent_freq;
 	unsigned int div, delta;
 	uint64_t ppm;
+	int ppm_user;
 	int ret;
 
 	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
@@ -863,6 +1064,8 @@ static int rockchip_i2s_tdm_calibrate_mclk(struct rk_i2s_tdm_dev *i2s_tdm,
 	case 64000:
 	case 96000:
 	case 192000:
+	case 384000:
+	case 768000:
 		mclk_root = i2s_tdm->mclk_root0;
 		mclk_root_freq = i2s_tdm->mclk_root0_freq;
 		mclk_root_initial_freq = i2s_tdm->mclk_root0_initial_freq;
@@ -873,6 +1076,8 @@ static int rockchip_i2s_tdm_calibrate_mclk(struct rk_i2s_tdm_dev *i2s_tdm,
 	case 44100:
 	case 88200:
 	case 176400:
+	case 352800:
+	case 705600:
 		mclk_root = i2s_tdm->mclk_root1;
 		mclk_root_freq = i2s_tdm->mclk_root1_freq;
 		mclk_root_initial_freq = i2s_tdm->mclk_root1_initial_freq;
@@ -888,6 +1093,8 @@ static int rockchip_i2s_tdm_calibrate_mclk(struct rk_i2s_tdm_dev *i2s_tdm,
 	if (ret)
 		goto out;
 
+	/* start from the nominal root rate, compensation is re-applied below */
+	ppm_user = i2s_tdm->clk_ppm;
 	ret = rockchip_i2s_tdm_clk_set_rate(i2s_tdm, mclk_root,
 					    mclk_root_freq, 0);
 	if (ret)
@@ -915,6 +1122,9 @@ static int rockchip_i2s_tdm_calibrate_mclk(struct rk_i2s_tdm_dev *i2s_tdm,
 	if (ret)
 		goto out;
 
+	if (ppm_user)
+		ret = rockchip_i2s_tdm_clk_set_rate(i2s_tdm, mclk_root,
+						    mclk_root_freq, ppm_user);
 out:
 	return ret;
 }
@@ -1229,12 +1439,155 @@ static int rockchip_i2s_tdm_params_channels(struct snd_pcm_substream *substream,
 	return ret;
 }
 
+/*
+ * Both family parents (clk_44/clk_48) stay prepared and locked from
+ * probe, so crossing between 44.1k and 48k content is a glitch-free
+ * mux switch instead of a PLL re-program, and nothing is touched at
+ * all while the family does not change.
+ */
+static int rockchip_i2s_tdm_switch_mclk(struct rk_i2s_tdm_dev *i2s_tdm,
+					struct clk *mclk, unsigned int rate)
+{
+	struct clk *parent;
+	int ret = 0;
+
+	if (rate == i2s_tdm->mclk_family_rate)
+		return 0;
+
+	parent = (rate % 44100) ? i2s_tdm->clk_48 : i2s_tdm->clk_44;
+
+	if (i2s_tdm->mclk_external) {
+		if (i2s_tdm->mclk_ext_mux)
+			ret = clk_set_parent(i2s_tdm->mclk_ext, parent);
+	} else {
+		/* with calibration, the root selection owns the parent */
+		if (i2s_tdm->mclk_family_mux && !i2s_tdm->mclk_calibrate)
+			ret = clk_set_parent(mclk, parent);
+		if (!ret)
+			ret = clk_set_rate(mclk, rate);
+	}
+
+	if (ret) {
+		dev_err(i2s_tdm->dev, "Failed to switch mclk to %u: %d\n",
+			rate, ret);
+		i2s_tdm->mclk_family_rate = 0;
+		return ret;
+	}
+
+	i2s_tdm->mclk_family_rate = rate;
+
+	return 0;
+}
+
+static const struct rk_i2s_tdm_dsd_rate *
+rockchip_i2s_tdm_get_dsd_rate(unsigned int rate)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(rk_i2s_tdm_dsd_rates); i++)
+		if (rk_i2s_tdm_dsd_rates[i].rate == rate)
+			return &rk_i2s_tdm_dsd_rates[i];
+
+	return NULL;
+}
+
+/*
+ * Each DSD channel is carried as two 16-bit slots on its own lane,
+ * so stereo DSD takes the lanes of a 4ch PCM stream and 4ch DSD the
+ * lanes of an 8ch one.
+ */
+static int rockchip_i2s_tdm_dsd_fmt(struct rk_i2s_tdm_dev *i2s_tdm,
+				    struct snd_pcm_substream *substream,
+				    struct snd_pcm_hw_params *params)
+{
+	const struct rk_i2s_tdm_dsd_rate *dsd;
+	int val = I2S_TXCR_VDW(DSD_SLOT_WIDTH);
+
+	if (substream->stream != SNDRV_PCM_STREAM_PLAYBACK ||
+	    i2s_tdm->tdm_mode)
+		return -EINVAL;
+
+	dsd = rockchip_i2s_tdm_get_dsd_rate(params_rate(params));
+	if (!dsd) {
+		dev_err(i2s_tdm->dev, "Unsupported DSD word rate: %u\n",
+			params_rate(params));
+		return -EINVAL;
+	}
+
+	switch (params_channels(params)) {
+	case 4:
+		val |= I2S_CHN_8;
+		break;
+	case 2:
+		val |= I2S_CHN_4;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	dev_dbg(i2s_tdm->dev, "%s: %u ch, bclk %u\n", dsd->name,
+		params_channels(params), params_rate(params) * DSD_FRAME_WIDTH);
+
+	return val;
+}
+
+static void rockchip_i2s_tdm_dma_tune(struct rk_i2s_tdm_dev *i2s_tdm,
+				      struct snd_pcm_substream *substream,
+				      struct snd_dmaengine_dai_dma_data *dma_data,
+				      unsigned int rate, unsigned int lanes)
+{
+	const struct rk_i2s_tdm_dma_tune *tune;
+	unsigned int burst, wm;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(rk_i2s_tdm_dma_tunes) - 1; i++)
+		if (rate <= rk_i2s_tdm_dma_tunes[i].max_rate)
+			break;
+	tune = &rk_i2s_tdm_dma_tunes[i];
+
+	burst = i2s_tdm->dma_burst ? i2s_tdm->dma_burst : tune->burst;
+	wm = i2s_tdm->dma_watermark ? i2s_tdm->dma_watermark : tune->watermark;
+
+	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
+		/* TX requests when FIFO <= watermark, the burst must fit */
+		if (wm + burst > I2S_FIFO_DEPTH)
+			wm = I2S_FIFO_DEPTH - burst;
+		regmap_update_bits(i2s_tdm->regmap, I2S_DMACR,
+				   I2S_DMACR_TDL_MASK, I2S_DMACR_TDL(wm));
+	} else {
+		/* RX requests when FIFO >= watermark, read one burst */
+		wm = burst;
+		regmap_update_bits(i2s_tdm->regmap, I2S_DMACR,
+				   I2S_DMACR_RDL_MASK, I2S_DMACR_RDL(wm));
+	}
+
+	dma_data->maxburst = burst * max(lanes, 1U);
+
+	dev_dbg(i2s_tdm->dev, "%s: rate %u, watermark %u, maxburst %u\n",
+		substream->stream ? "rx" : "tx", rate, wm, dma_data->maxburst);
+}
+
+static unsigned int
+rockchip_i2s_tdm_mclk_rate(const struct rk_i2s_tdm_dsd_rate *dsd,
+			   unsigned int rate)
+{
+	if (dsd)
+		return dsd->mclk;
+	if (rate >= HIGH_RATE_MIN)
+		return HIGH_RATE_MCLK_FS * rate;
+	if (rate % 44100)
+		return 512 * 48000;
+
+	return 512 * 44100;
+}
+
 static int rockchip_i2s_tdm_hw_params(struct snd_pcm_substream *substream,
 				      struct snd_pcm_hw_params *params,
 				      struct snd_soc_dai *dai)
 {
 	struct rk_i2s_tdm_dev *i2s_tdm = to_info(dai);
 	struct snd_dmaengine_dai_dma_data *dma_data;
+	const struct rk_i2s_tdm_dsd_rate *dsd = NULL;
 	struct clk *mclk;
 	int ret = 0;
 	unsigned int val = 0;
@@ -1242,25 +1595,31 @@ static int rockchip_i2s_tdm_hw_params(struct snd_pcm_substream *substream,
 	bool s2mono = i2s_tdm->s2mono;
 
 	dma_data = snd_soc_dai_get_dma_data(dai, substream);
-	dma_data->maxburst = MAXBURST_PER_FIFO * params_channels(params) / 2;
 
-			// original
-		if(0) {
-			if (i2s_tdm->mclk_calibrate)
-				rockchip_i2s_tdm_calibrate_mclk(i2s_tdm, substream,
-								params_rate(params));
+	if (params_format(params) == SNDRV_PCM_FORMAT_DSD_U32_LE) {
+		ret = rockchip_i2s_tdm_dsd_fmt(i2s_tdm, substream, params);
+		if (ret < 0)
+			goto err;
+
+		val = ret;
+		ret = 0;
+		dsd = rockchip_i2s_tdm_get_dsd_rate(params_rate(params));
+	}
+
+	/* DSD uses one lane per channel, PCM one lane per channel pair */
+	rockchip_i2s_tdm_dma_tune(i2s_tdm, substream, dma_data,
+				  params_rate(params),
+				  dsd ? params_channels(params) :
+					params_channels(params) / 2);
 
-			ret = rockchip_i2s_tdm_set_mclk(i2s_tdm, substream, &mclk);
-			if (ret)
-				goto err;
-		}
-			//  
 //+++
 	if (i2s_tdm->is_master_mode) {
 		mclk = i2s_tdm->mclk_tx;		// !must check if RX
 
-		if( params_format(params) == SNDRV_PCM_FORMAT_DSD_U32_LE ) s2mono = 1;
-		if( i2s_tdm->tdm_mode != true ) {
+		if (dsd) {
+			div_lrck = DSD_FRAME_WIDTH;
+			i2s_tdm->frame_width = DSD_FRAME_WIDTH;
+		} else if( i2s_tdm->tdm_mode != true ) {
 			if( params_format(params) == SNDRV_PCM_FORMAT_S16_LE ) {
 				div_lrck = 32; i2s_tdm->frame_width = 32;
 				//s2mono = 0;
@@ -1271,27 +1630,23 @@ static int rockchip_i2s_tdm_hw_params(struct snd_pcm_substream *substream,
 			} 
 		}
 
-		if( !i2s_tdm->mclk_external ){
-			//err = clk_set_rate(mclk, DEFAULT_MCLK_FS * params_rate(params));
-			if( params_rate(params) % 44100 )
-				ret = clk_set_rate(mclk, 512 * 48000);
-			else
-				ret = clk_set_rate(mclk, 512 * 44100);
+		mclk_rate = rockchip_i2s_tdm_mclk_rate(dsd, params_rate(params));
+
+		/*
+		 * On a family change, let the calibration move mclk_tx_src to
+		 * the matching root, it keeps the ppm trim of the control.
+		 */
+		if (i2s_tdm->mclk_calibrate && !i2s_tdm->mclk_external &&
+		    mclk_rate != i2s_tdm->mclk_family_rate) {
+			ret = rockchip_i2s_tdm_calibrate_mclk(i2s_tdm, substream,
+							      params_rate(params));
 			if (ret)
 				goto err;
 		}
 
-
-		if( i2s_tdm->mclk_external ){
-			if( i2s_tdm->mclk_ext_mux ) {
-				if( params_rate(params) % 44100 ) {
-					clk_set_parent( i2s_tdm->mclk_ext, i2s_tdm->clk_48);
-				}
-				else {
-					clk_set_parent( i2s_tdm->mclk_ext, i2s_tdm->clk_44);
-				}
-			}
-		}
+		ret = rockchip_i2s_tdm_switch_mclk(i2s_tdm, mclk, mclk_rate);
+		if (ret)
+			goto err;
 //+++
 
 		mclk_rate = clk_get_rate(mclk);
@@ -1305,6 +1660,9 @@ static int rockchip_i2s_tdm_hw_params(struct snd_pcm_substream *substream,
 		div_lrck = bclk_rate / params_rate(params);
 	}
 
+	if (dsd)
+		goto s2mono_l;
+
 //+++
 	if( s2mono && (params_format(params) != SNDRV_PCM_FORMAT_S16_LE) ) {
 		val |= I2S_TXCR_VDW(16);
@@ -1354,6 +1712,8 @@ static int rockchip_i2s_tdm_hw_params(struct snd_pcm_substream *substream,
 	}
 
 s2mono_l:
+	if (!is_params_dirty(substream, dai, div_bclk, div_lrck, val))
+		goto multiplex;
 
 			// only TX
 		regmap_update_bits(i2s_tdm->regmap, I2S_CLKDIV,
@@ -1369,8 +1729,8 @@ static int rockchip_i2s_tdm_hw_params(struct snd_pcm_substream *substream,
 				   I2S_CKR_TSD_MASK,
 				   I2S_CKR_TSD(div_lrck));
 		regmap_update_bits(i2s_tdm->regmap, I2S_TXCR,
-				   I2S_TXCR_VDW_MASK | I2S_TXCR_CSR_MASK,
-				   val);
+				   I2S_TXCR_VDW_MASK | I2S_TXCR_CSR_MASK |
+				   I2S_TXCR_HWT, val);
 
 //+++
 
@@ -1391,12 +1751,286 @@ static int rockchip_i2s_tdm_hw_params(struct snd_pcm_substream *substream,
 	}
 	// orig
 
+multiplex:
 	ret = rockchip_i2s_io_multiplex(substream, dai);
 
 err:
 	return ret;
 }
 
+static bool rockchip_i2s_tdm_servo_on(struct rk_i2s_tdm_servo *servo)
+{
+	return servo->source == SERVO_SRC_TAI || servo->target_us;
+}
+
+static s64 rockchip_i2s_tdm_servo_fill(struct rk_i2s_tdm_servo *servo,
+				       struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	snd_pcm_sframes_t fill;
+	unsigned long flags;
+	s64 fill_us, err_us;
+
+	snd_pcm_stream_lock_irqsave(substream, flags);
+	fill = snd_pcm_playback_hw_avail(runtime);
+	snd_pcm_stream_unlock_irqrestore(substream, flags);
+
+	fill_us = div_s64((s64)fill * USEC_PER_SEC, runtime->rate);
+	/* smooth out the period sized pattern of application writes */
+	if (!servo->fill_avg_us)
+		servo->fill_avg_us = fill_us;
+	else
+		servo->fill_avg_us += div_s64(fill_us - servo->fill_avg_us, 8);
+
+	/* buffer growing means the sink is slow: speed mclk up */
+	err_us = servo->fill_avg_us - servo->target_us;
+	servo->integral = clamp_t(s64, servo->integral + err_us,
+				  -SERVO_INTEGRAL_MAX, SERVO_INTEGRAL_MAX);
+
+	return div_s64(err_us, 100) + div_s64(servo->integral, 2000);
+}
+
+static s64 rockchip_i2s_tdm_servo_tai(struct rk_i2s_tdm_servo *servo,
+				      struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	snd_pcm_uframes_t pos;
+	unsigned long flags;
+	ktime_t now;
+	s64 err_us;
+
+	/* hardware position and TAI sampled back to back */
+	snd_pcm_stream_lock_irqsave(substream, flags);
+	pos = substream->ops->pointer(substream);
+	now = ktime_get_clocktai();
+	snd_pcm_stream_unlock_irqrestore(substream, flags);
+
+	if (!servo->t0) {
+		servo->t0 = now;
+		servo->last_pos = pos;
+		servo->frames = 0;
+		servo->offset_ns = 0;
+		servo->integral = 0;
+		return servo->ppm;
+	}
+
+	if (pos >= servo->last_pos)
+		servo->frames += pos - servo->last_pos;
+	else
+		servo->frames += pos + runtime->buffer_size - servo->last_pos;
+	servo->last_pos = pos;
+
+	servo->offset_ns = mul_u64_u32_div(servo->frames, NSEC_PER_SEC,
+					   runtime->rate) -
+			   ktime_to_ns(ktime_sub(now, servo->t0));
+
+	/* audio ahead of TAI means mclk is fast: slow it down */
+	err_us = div_s64(servo->offset_ns, NSEC_PER_USEC);
+	servo->integral = clamp_t(s64, servo->integral + err_us,
+				  -SERVO_INTEGRAL_MAX, SERVO_INTEGRAL_MAX);
+
+	return -(div_s64(err_us, 10) + div_s64(servo->integral, 1000));
+}
+
+static void rockchip_i2s_tdm_servo_work(struct work_struct *work)
+{
+	struct rk_i2s_tdm_servo *servo =
+		container_of(to_delayed_work(work), struct rk_i2s_tdm_servo, work);
+	struct rk_i2s_tdm_dev *i2s_tdm =
+		container_of(servo, struct rk_i2s_tdm_dev, servo);
+	struct snd_pcm_substream *substream;
+	struct snd_pcm_runtime *runtime;
+	unsigned int period_ms;
+	s64 out;
+	int ppm, step;
+
+	if (!READ_ONCE(servo->running) || !rockchip_i2s_tdm_servo_on(servo))
+		return;
+
+	substream = i2s_tdm->substreams[SNDRV_PCM_STREAM_PLAYBACK];
+	if (!substream || !substream->runtime || !substream->runtime->rate)
+		return;
+
+	runtime = substream->runtime;
+	if (servo->source == SERVO_SRC_TAI)
+		out = rockchip_i2s_tdm_servo_tai(servo, substream);
+	else
+		out = rockchip_i2s_tdm_servo_fill(servo, substream);
+	ppm = clamp_t(s64, out, CLK_PPM_MIN, CLK_PPM_MAX);
+
+	/* bounded slew keeps the pitch change inaudible */
+	step = clamp(ppm - servo->ppm, -SERVO_STEP_MAX_PPM, SERVO_STEP_MAX_PPM);
+	if (step && !rockchip_i2s_tdm_clk_compensate(i2s_tdm, servo->ppm + step))
+		servo->ppm += step;
+
+	/* the TAI source must see the pointer more than once per buffer */
+	period_ms = div_u64((u64)runtime->buffer_size * MSEC_PER_SEC,
+			    runtime->rate * 2);
+	period_ms = clamp_t(unsigned int, period_ms, 1, SERVO_PERIOD_MS);
+
+	if (READ_ONCE(servo->running))
+		schedule_delayed_work(&servo->work, msecs_to_jiffies(period_ms));
+}
+
+static void rockchip_i2s_tdm_servo_start(struct rk_i2s_tdm_dev *i2s_tdm,
+					 int cmd)
+{
+	struct rk_i2s_tdm_servo *servo = &i2s_tdm->servo;
+
+	if (!i2s_tdm->mclk_calibrate || !rockchip_i2s_tdm_servo_on(servo))
+		return;
+
+	if (cmd == SNDRV_PCM_TRIGGER_START) {
+		servo->fill_avg_us = 0;
+		servo->integral = 0;
+		servo->ppm = i2s_tdm->clk_ppm;
+	}
+
+	/* any gap in playback breaks the sample count against TAI */
+	servo->t0 = 0;
+
+	WRITE_ONCE(servo->running, true);
+	schedule_delayed_work(&servo->work, msecs_to_jiffies(SERVO_PERIOD_MS));
+}
+
+static void rockchip_i2s_tdm_servo_stop(struct rk_i2s_tdm_dev *i2s_tdm)
+{
+	WRITE_ONCE(i2s_tdm->servo.running, false);
+	/* atomic context, the work bails out on its own if already queued */
+	cancel_delayed_work(&i2s_tdm->servo.work);
+}
+
+static int rockchip_i2s_tdm_get_fifo_count(struct device *dev, int stream);
+
+/*
+ * Frames until the last sample before next_frame has left the TX FIFO,
+ * with the stream lock held: the DMA position extended to the hw_ptr
+ * frame count, minus what is still queued in the FIFO.
+ */
+static snd_pcm_sframes_t rockchip_i2s_tdm_next_left(struct rk_i2s_tdm_dev *i2s_tdm,
+						    struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	snd_pcm_uframes_t hw_ptr = runtime->status->hw_ptr;
+	snd_pcm_uframes_t base, pos, fifo;
+	snd_pcm_sframes_t left, half = runtime->boundary / 2;
+
+	pos = substream->ops->pointer(substream);
+	base = hw_ptr - hw_ptr % runtime->buffer_size;
+	if (pos < hw_ptr % runtime->buffer_size)
+		base += runtime->buffer_size;
+	fifo = rockchip_i2s_tdm_get_fifo_count(i2s_tdm->dev,
+					       SNDRV_PCM_STREAM_PLAYBACK) /
+	       runtime->channels;
+
+	left = i2s_tdm->next_frame - (base + pos - fifo);
+	if (left > half)
+		left -= runtime->boundary;
+	else if (left < -half)
+		left += runtime->boundary;
+
+	return left;
+}
+
+static void rockchip_i2s_tdm_next_done(struct rk_i2s_tdm_dev *i2s_tdm,
+				       unsigned int div_bclk)
+{
+	regmap_update_bits(i2s_tdm->regmap, I2S_CLKDIV,
+			   I2S_CLKDIV_TXM_MASK | I2S_CLKDIV_RXM_MASK,
+			   I2S_CLKDIV_TXM(div_bclk) | I2S_CLKDIV_RXM(div_bclk));
+	/* the sample count the TAI servo keeps is per rate */
+	i2s_tdm->servo.t0 = 0;
+	WRITE_ONCE(i2s_tdm->next_rate, 0);
+}
+
+/* A family change re-parents or re-rates mclk, which may sleep */
+static void rockchip_i2s_tdm_next_work(struct work_struct *work)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm =
+		container_of(work, struct rk_i2s_tdm_dev, next_work);
+	struct snd_pcm_substream *substream;
+	const struct rk_i2s_tdm_dsd_rate *dsd = NULL;
+	unsigned int rate = READ_ONCE(i2s_tdm->next_rate);
+	unsigned int mclk_rate;
+	int ret = 0;
+
+	substream = i2s_tdm->substreams[SNDRV_PCM_STREAM_PLAYBACK];
+	if (!rate || !substream || !substream->runtime)
+		return;
+
+	if (substream->runtime->format == SNDRV_PCM_FORMAT_DSD_U32_LE)
+		dsd = rockchip_i2s_tdm_get_dsd_rate(rate);
+	mclk_rate = rockchip_i2s_tdm_mclk_rate(dsd, rate);
+
+	if (i2s_tdm->mclk_calibrate && !i2s_tdm->mclk_external &&
+	    mclk_rate != i2s_tdm->mclk_family_rate)
+		ret = rockchip_i2s_tdm_calibrate_mclk(i2s_tdm, substream, rate);
+	if (!ret)
+		ret = rockchip_i2s_tdm_switch_mclk(i2s_tdm, i2s_tdm->mclk_tx,
+						   mclk_rate);
+	if (ret) {
+		dev_err(i2s_tdm->dev, "next track at %u failed: %d\n",
+			rate, ret);
+		WRITE_ONCE(i2s_tdm->next_rate, 0);
+		return;
+	}
+
+	rockchip_i2s_tdm_next_done(i2s_tdm,
+				   DIV_ROUND_CLOSEST(clk_get_rate(i2s_tdm->mclk_tx),
+						     i2s_tdm->frame_width * rate));
+}
+
+/*
+ * Polls the playback position towards next_frame, sleeping for the time
+ * the frames left take to play at the current rate. As the divider is
+ * changed once the FIFO is drained past the boundary, track B starts on
+ * the new clock without the stream being drained or reopened; only a
+ * family change waits for next_work on top.
+ */
+static enum hrtimer_restart rockchip_i2s_tdm_next_timer(struct hrtimer *timer)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm =
+		container_of(timer, struct rk_i2s_tdm_dev, next_timer);
+	struct snd_pcm_substream *substream;
+	enum hrtimer_restart ret = HRTIMER_NORESTART;
+	snd_pcm_sframes_t left;
+	unsigned long flags;
+	unsigned int rate;
+	u64 ns;
+
+	substream = i2s_tdm->substreams[SNDRV_PCM_STREAM_PLAYBACK];
+	if (!substream)
+		return HRTIMER_NORESTART;
+
+	snd_pcm_stream_lock_irqsave(substream, flags);
+	if (!READ_ONCE(i2s_tdm->next_rate) || !substream->runtime ||
+	    substream->runtime->status->state != SNDRV_PCM_STATE_RUNNING)
+		goto out;
+
+	left = rockchip_i2s_tdm_next_left(i2s_tdm, substream);
+	if (left > 0) {
+		rate = substream->runtime->rate;
+		ns = max_t(u64, div_u64((u64)left * NSEC_PER_SEC, rate),
+			   NEXT_TRACK_MIN_NS);
+		hrtimer_forward_now(timer, ns_to_ktime(ns));
+		ret = HRTIMER_RESTART;
+	} else if (i2s_tdm->next_div_bclk) {
+		rockchip_i2s_tdm_next_done(i2s_tdm, i2s_tdm->next_div_bclk);
+	} else {
+		queue_work(system_highpri_wq, &i2s_tdm->next_work);
+	}
+out:
+	snd_pcm_stream_unlock_irqrestore(substream, flags);
+
+	return ret;
+}
+
+static void rockchip_i2s_tdm_next_arm(struct rk_i2s_tdm_dev *i2s_tdm)
+{
+	if (READ_ONCE(i2s_tdm->next_rate))
+		hrtimer_start(&i2s_tdm->next_timer, 0, HRTIMER_MODE_REL_HARD);
+}
+
 static int rockchip_i2s_tdm_trigger(struct snd_pcm_substream *substream,
 				    int cmd, struct snd_soc_dai *dai)
 {
@@ -1407,11 +2041,24 @@ static int rockchip_i2s_tdm_trigger(struct snd_pcm_substream *substream,
 	case SNDRV_PCM_TRIGGER_START:
 	case SNDRV_PCM_TRIGGER_RESUME:
 	case SNDRV_PCM_TRIGGER_PAUSE_RELEASE:
-		rockchip_i2s_tdm_start(i2s_tdm, substream->stream);
+		if (cmd != SNDRV_PCM_TRIGGER_START ||
+		    substream->stream != SNDRV_PCM_STREAM_PLAYBACK ||
+		    !rockchip_i2s_tdm_start_timed(i2s_tdm))
+			rockchip_i2s_tdm_start(i2s_tdm, substream->stream);
+		if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
+			rockchip_i2s_tdm_servo_start(i2s_tdm, cmd);
+			rockchip_i2s_tdm_next_arm(i2s_tdm);
+		}
 		break;
 	case SNDRV_PCM_TRIGGER_SUSPEND:
 	case SNDRV_PCM_TRIGGER_STOP:
 	case SNDRV_PCM_TRIGGER_PAUSE_PUSH:
+		if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
+			hrtimer_cancel(&i2s_tdm->start_timer);
+			/* it takes the stream lock, so don't wait for it */
+			hrtimer_try_to_cancel(&i2s_tdm->next_timer);
+			rockchip_i2s_tdm_servo_stop(i2s_tdm);
+		}
 		rockchip_i2s_tdm_stop(i2s_tdm, substream->stream);
 		break;
 	default:
@@ -1472,7 +2119,7 @@ static int rockchip_i2s_tdm_clk_compensation_put(struct snd_kcontrol *kcontrol,
 {
 	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
 	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_dai_get_drvdata(dai);
-	int ret = 0, ppm = 0;
+	int ppm = 0;
 
 	if ((ucontrol->value.integer.value[0] < CLK_PPM_MIN) ||
 	    (ucontrol->value.integer.value[0] > CLK_PPM_MAX))
@@ -1480,18 +2127,7 @@ static int rockchip_i2s_tdm_clk_compensation_put(struct snd_kcontrol *kcontrol,
 
 	ppm = ucontrol->value.integer.value[0];
 
-	ret = rockchip_i2s_tdm_clk_set_rate(i2s_tdm, i2s_tdm->mclk_root0,
-					    i2s_tdm->mclk_root0_freq, ppm);
-	if (ret)
-		return ret;
-
-	if (clk_is_match(i2s_tdm->mclk_root0, i2s_tdm->mclk_root1))
-		return 0;
-
-	ret = rockchip_i2s_tdm_clk_set_rate(i2s_tdm, i2s_tdm->mclk_root1,
-					    i2s_tdm->mclk_root1_freq, ppm);
-
-	return ret;
+	return rockchip_i2s_tdm_clk_compensate(i2s_tdm, ppm);
 }
 
 static struct snd_kcontrol_new rockchip_i2s_tdm_compensation_control = {
@@ -1502,6 +2138,282 @@ static struct snd_kcontrol_new rockchip_i2s_tdm_compensation_control = {
 	.put = rockchip_i2s_tdm_clk_compensation_put,
 };
 
+static int rockchip_i2s_tdm_servo_target_info(struct snd_kcontrol *kcontrol,
+					      struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER;
+	uinfo->count = 1;
+	uinfo->value.integer.min = 0;
+	uinfo->value.integer.max = SERVO_TARGET_MAX_US;
+	uinfo->value.integer.step = 1;
+
+	return 0;
+}
+
+static int rockchip_i2s_tdm_servo_target_get(struct snd_kcontrol *kcontrol,
+					     struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_dai_get_drvdata(dai);
+
+	ucontrol->value.integer.value[0] = i2s_tdm->servo.target_us;
+
+	return 0;
+}
+
+static int rockchip_i2s_tdm_servo_target_put(struct snd_kcontrol *kcontrol,
+					     struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_dai_get_drvdata(dai);
+	long val = ucontrol->value.integer.value[0];
+
+	if (val < 0 || val > SERVO_TARGET_MAX_US)
+		return -EINVAL;
+
+	if (val == i2s_tdm->servo.target_us)
+		return 0;
+
+	/* applies from the next start, 0 hands the trim back to the user */
+	i2s_tdm->servo.target_us = val;
+
+	return 1;
+}
+
+/* target buffer fill in usecs the servo keeps playback at, 0 disables */
+static struct snd_kcontrol_new rockchip_i2s_tdm_servo_control = {
+	.iface = SNDRV_CTL_ELEM_IFACE_PCM,
+	.name = "PCM Clk Servo Target In US",
+	.info = rockchip_i2s_tdm_servo_target_info,
+	.get = rockchip_i2s_tdm_servo_target_get,
+	.put = rockchip_i2s_tdm_servo_target_put,
+};
+
+static int rockchip_i2s_tdm_start_time_info(struct snd_kcontrol *kcontrol,
+					    struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER64;
+	uinfo->count = 1;
+	uinfo->value.integer64.min = 0;
+	uinfo->value.integer64.max = S64_MAX;
+	uinfo->value.integer64.step = 1;
+
+	return 0;
+}
+
+static int rockchip_i2s_tdm_start_time_get(struct snd_kcontrol *kcontrol,
+					   struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_dai_get_drvdata(dai);
+
+	ucontrol->value.integer64.value[0] = ktime_to_ns(i2s_tdm->start_time);
+
+	return 0;
+}
+
+static int rockchip_i2s_tdm_start_time_put(struct snd_kcontrol *kcontrol,
+					   struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_dai_get_drvdata(dai);
+	s64 val = ucontrol->value.integer64.value[0];
+
+	if (val < 0)
+		return -EINVAL;
+
+	if (val == ktime_to_ns(i2s_tdm->start_time))
+		return 0;
+
+	i2s_tdm->start_time = ns_to_ktime(val);
+
+	return 1;
+}
+
+/* CLOCK_TAI nsecs the next playback start is held until, 0 starts at once */
+static struct snd_kcontrol_new rockchip_i2s_tdm_start_time_control = {
+	.iface = SNDRV_CTL_ELEM_IFACE_PCM,
+	.name = "PCM Start Time In NS",
+	.info = rockchip_i2s_tdm_start_time_info,
+	.get = rockchip_i2s_tdm_start_time_get,
+	.put = rockchip_i2s_tdm_start_time_put,
+};
+
+static int rockchip_i2s_tdm_next_frame_get(struct snd_kcontrol *kcontrol,
+					   struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_dai_get_drvdata(dai);
+
+	ucontrol->value.integer64.value[0] = i2s_tdm->next_frame;
+
+	return 0;
+}
+
+static int rockchip_i2s_tdm_next_frame_put(struct snd_kcontrol *kcontrol,
+					   struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_dai_get_drvdata(dai);
+	s64 val = ucontrol->value.integer64.value[0];
+
+	if (val < 0)
+		return -EINVAL;
+
+	/* the boundary of a queued switch can't move under the timer */
+	if (READ_ONCE(i2s_tdm->next_rate))
+		return -EBUSY;
+
+	if (val == i2s_tdm->next_frame)
+		return 0;
+
+	i2s_tdm->next_frame = val;
+
+	return 1;
+}
+
+/* hw_ptr frame count the first frame of the next track is written at */
+static struct snd_kcontrol_new rockchip_i2s_tdm_next_frame_control = {
+	.iface = SNDRV_CTL_ELEM_IFACE_PCM,
+	.name = "PCM Next Track Frame",
+	.info = rockchip_i2s_tdm_start_time_info,
+	.get = rockchip_i2s_tdm_next_frame_get,
+	.put = rockchip_i2s_tdm_next_frame_put,
+};
+
+static int rockchip_i2s_tdm_next_rate_info(struct snd_kcontrol *kcontrol,
+					   struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER;
+	uinfo->count = 1;
+	uinfo->value.integer.min = 0;
+	uinfo->value.integer.max = 768000;
+	uinfo->value.integer.step = 1;
+
+	return 0;
+}
+
+static int rockchip_i2s_tdm_next_rate_get(struct snd_kcontrol *kcontrol,
+					  struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_dai_get_drvdata(dai);
+
+	ucontrol->value.integer.value[0] = READ_ONCE(i2s_tdm->next_rate);
+
+	return 0;
+}
+
+/*
+ * Queue a rate switch at "PCM Next Track Frame", which has to be set
+ * first; 0 cancels. Format and channels stay those of hw_params, the
+ * switch only moves the TX clock, and reads back 0 once it took place.
+ */
+static int rockchip_i2s_tdm_next_rate_put(struct snd_kcontrol *kcontrol,
+					  struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_dai_get_drvdata(dai);
+	unsigned int rate = ucontrol->value.integer.value[0];
+	const struct rk_i2s_tdm_dsd_rate *dsd = NULL;
+	struct snd_pcm_substream *substream;
+	struct snd_pcm_runtime *runtime;
+	unsigned int mclk_rate, div_bclk = 0;
+	unsigned long flags;
+
+	hrtimer_cancel(&i2s_tdm->next_timer);
+	cancel_work_sync(&i2s_tdm->next_work);
+	WRITE_ONCE(i2s_tdm->next_rate, 0);
+	if (!rate)
+		return 1;
+
+	/* TRCM would drag the capture clock along */
+	if (!i2s_tdm->is_master_mode || i2s_tdm->clk_trcm)
+		return -EOPNOTSUPP;
+
+	substream = i2s_tdm->substreams[SNDRV_PCM_STREAM_PLAYBACK];
+	if (!substream || !substream->runtime || !substream->runtime->rate ||
+	    !i2s_tdm->frame_width)
+		return -EBADFD;
+
+	runtime = substream->runtime;
+	if (runtime->format == SNDRV_PCM_FORMAT_DSD_U32_LE) {
+		dsd = rockchip_i2s_tdm_get_dsd_rate(rate);
+		if (!dsd)
+			return -EINVAL;
+	}
+
+	mclk_rate = rockchip_i2s_tdm_mclk_rate(dsd, rate);
+	if (mclk_rate == i2s_tdm->mclk_family_rate)
+		div_bclk = DIV_ROUND_CLOSEST(clk_get_rate(i2s_tdm->mclk_tx),
+					     i2s_tdm->frame_width * rate);
+
+	snd_pcm_stream_lock_irqsave(substream, flags);
+	i2s_tdm->next_div_bclk = div_bclk;
+	WRITE_ONCE(i2s_tdm->next_rate, rate);
+	if (runtime->status->state == SNDRV_PCM_STATE_RUNNING)
+		rockchip_i2s_tdm_next_arm(i2s_tdm);
+	snd_pcm_stream_unlock_irqrestore(substream, flags);
+
+	return 1;
+}
+
+static struct snd_kcontrol_new rockchip_i2s_tdm_next_rate_control = {
+	.iface = SNDRV_CTL_ELEM_IFACE_PCM,
+	.name = "PCM Next Track Rate",
+	.info = rockchip_i2s_tdm_next_rate_info,
+	.get = rockchip_i2s_tdm_next_rate_get,
+	.put = rockchip_i2s_tdm_next_rate_put,
+};
+
+static const char * const servo_source_text[] = { "Buffer Fill", "TAI" };
+
+static int rockchip_i2s_tdm_servo_source_info(struct snd_kcontrol *kcontrol,
+					      struct snd_ctl_elem_info *uinfo)
+{
+	return snd_ctl_enum_info(uinfo, 1, ARRAY_SIZE(servo_source_text),
+				 servo_source_text);
+}
+
+static int rockchip_i2s_tdm_servo_source_get(struct snd_kcontrol *kcontrol,
+					     struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_dai_get_drvdata(dai);
+
+	ucontrol->value.enumerated.item[0] = i2s_tdm->servo.source;
+
+	return 0;
+}
+
+static int rockchip_i2s_tdm_servo_source_put(struct snd_kcontrol *kcontrol,
+					     struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_dai_get_drvdata(dai);
+	unsigned int val = ucontrol->value.enumerated.item[0];
+
+	if (val >= ARRAY_SIZE(servo_source_text))
+		return -EINVAL;
+
+	if (val == i2s_tdm->servo.source)
+		return 0;
+
+	/* applies from the next start */
+	i2s_tdm->servo.source = val;
+
+	return 1;
+}
+
+/* what the servo locks mclk to: the buffer fill target or CLOCK_TAI */
+static struct snd_kcontrol_new rockchip_i2s_tdm_servo_source_control = {
+	.iface = SNDRV_CTL_ELEM_IFACE_PCM,
+	.name = "PCM Clk Servo Source",
+	.info = rockchip_i2s_tdm_servo_source_info,
+	.get = rockchip_i2s_tdm_servo_source_get,
+	.put = rockchip_i2s_tdm_servo_source_put,
+};
+
 /* loopback mode select */
 enum {
 	LOOPBACK_MODE_DIS = 0,
@@ -1583,10 +2495,78 @@ static int rockchip_i2s_tdm_loopback_put(struct snd_kcontrol *kcontrol,
 	return 0;
 }
 
+static int rockchip_i2s_tdm_dma_burst_get(struct snd_kcontrol *kcontrol,
+					  struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_component_get_drvdata(component);
+
+	ucontrol->value.integer.value[0] = i2s_tdm->dma_burst;
+
+	return 0;
+}
+
+static int rockchip_i2s_tdm_dma_burst_put(struct snd_kcontrol *kcontrol,
+					  struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_component_get_drvdata(component);
+	unsigned int val = ucontrol->value.integer.value[0];
+
+	if (val > I2S_FIFO_DEPTH / 2)
+		return -EINVAL;
+
+	if (val == i2s_tdm->dma_burst)
+		return 0;
+
+	/* takes effect on the next hw_params */
+	i2s_tdm->dma_burst = val;
+
+	return 1;
+}
+
+static int rockchip_i2s_tdm_dma_wm_get(struct snd_kcontrol *kcontrol,
+				       struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_component_get_drvdata(component);
+
+	ucontrol->value.integer.value[0] = i2s_tdm->dma_watermark;
+
+	return 0;
+}
+
+static int rockchip_i2s_tdm_dma_wm_put(struct snd_kcontrol *kcontrol,
+				       struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_component_get_drvdata(component);
+	unsigned int val = ucontrol->value.integer.value[0];
+
+	if (val > DMA_WATERMARK_MAX)
+		return -EINVAL;
+
+	if (val == i2s_tdm->dma_watermark)
+		return 0;
+
+	i2s_tdm->dma_watermark = val;
+
+	return 1;
+}
+
 static const struct snd_kcontrol_new rockchip_i2s_tdm_snd_controls[] = {
 	SOC_ENUM_EXT("I2STDM Digital Loopback Mode", loopback_mode,
 		     rockchip_i2s_tdm_loopback_get,
 		     rockchip_i2s_tdm_loopback_put),
+	/* 0 means auto, picked per sample rate */
+	SOC_SINGLE_EXT("I2STDM DMA Burst", SND_SOC_NOPM, 0,
+		       I2S_FIFO_DEPTH / 2, 0,
+		       rockchip_i2s_tdm_dma_burst_get,
+		       rockchip_i2s_tdm_dma_burst_put),
+	SOC_SINGLE_EXT("I2STDM DMA Watermark", SND_SOC_NOPM, 0,
+		       DMA_WATERMARK_MAX, 0,
+		       rockchip_i2s_tdm_dma_wm_get,
+		       rockchip_i2s_tdm_dma_wm_put),
 };
 
 static int rockchip_i2s_tdm_dai_probe(struct snd_soc_dai *dai)
@@ -1596,8 +2576,15 @@ static int rockchip_i2s_tdm_dai_probe(struct snd_soc_dai *dai)
 	dai->capture_dma_data = &i2s_tdm->capture_dma_data;
 	dai->playback_dma_data = &i2s_tdm->playback_dma_data;
 
-	if (i2s_tdm->mclk_calibrate)
+	if (i2s_tdm->mclk_calibrate) {
 		snd_soc_add_dai_controls(dai, &rockchip_i2s_tdm_compensation_control, 1);
+		snd_soc_add_dai_controls(dai, &rockchip_i2s_tdm_servo_control, 1);
+		snd_soc_add_dai_controls(dai, &rockchip_i2s_tdm_servo_source_control, 1);
+	}
+
+	snd_soc_add_dai_controls(dai, &rockchip_i2s_tdm_start_time_control, 1);
+	snd_soc_add_dai_controls(dai, &rockchip_i2s_tdm_next_frame_control, 1);
+	snd_soc_add_dai_controls(dai, &rockchip_i2s_tdm_next_rate_control, 1);
 
 	return 0;
 }
@@ -1624,6 +2611,66 @@ static int rockchip_dai_tdm_slot(struct snd_soc_dai *dai,
 	return 0;
 }
 
+static int rockchip_i2s_tdm_get_fifo_count(struct device *dev, int stream)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = dev_get_drvdata(dev);
+	int val = 0;
+
+	if (stream == SNDRV_PCM_STREAM_PLAYBACK)
+		regmap_read(i2s_tdm->regmap, I2S_TXFIFOLR, &val);
+	else
+		regmap_read(i2s_tdm->regmap, I2S_RXFIFOLR, &val);
+
+	val = ((val & I2S_FIFOLR_TFL3_MASK) >> I2S_FIFOLR_TFL3_SHIFT) +
+	      ((val & I2S_FIFOLR_TFL2_MASK) >> I2S_FIFOLR_TFL2_SHIFT) +
+	      ((val & I2S_FIFOLR_TFL1_MASK) >> I2S_FIFOLR_TFL1_SHIFT) +
+	      ((val & I2S_FIFOLR_TFL0_MASK) >> I2S_FIFOLR_TFL0_SHIFT);
+
+	return val;
+}
+
+/*
+static const struct snd_dlp_config dconfig = {
+	.get_fifo_count = rockchip_i2s_tdm_get_fifo_count,
+};
+*/
+
+/*
+ * Report the frames still queued in the FIFO and sample the FIFO fill
+ * for the telemetry while at it: this runs from the pointer callback,
+ * so it sees every period boundary.
+ */
+static snd_pcm_sframes_t rockchip_i2s_tdm_delay(struct snd_pcm_substream *substream,
+						struct snd_soc_dai *dai)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = to_info(dai);
+	struct rk_i2s_tdm_stats *st = &i2s_tdm->stats[substream->stream];
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	unsigned int fifo;
+	ktime_t now = ktime_get();
+	s64 gap;
+
+	fifo = rockchip_i2s_tdm_get_fifo_count(dai->dev, substream->stream);
+
+	st->updates++;
+	st->fifo_last = fifo;
+	if (fifo < st->fifo_min)
+		st->fifo_min = fifo;
+	if (fifo > st->fifo_max)
+		st->fifo_max = fifo;
+	if (st->last_update) {
+		gap = ktime_to_ns(ktime_sub(now, st->last_update));
+		if (gap > st->max_update_gap_ns)
+			st->max_update_gap_ns = gap;
+	}
+	st->last_update = now;
+
+	if (!runtime->channels)
+		return 0;
+
+	return fifo / runtime->channels;
+}
+
 static int rockchip_i2s_tdm_startup(struct snd_pcm_substream *substream,
 				    struct snd_soc_dai *dai)
 {
@@ -1642,6 +2689,17 @@ static void rockchip_i2s_tdm_shutdown(struct snd_pcm_substream *substream,
 {
 	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_dai_get_drvdata(dai);
 
+	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
+		hrtimer_cancel(&i2s_tdm->start_timer);
+		i2s_tdm->start_time = 0;
+		hrtimer_cancel(&i2s_tdm->next_timer);
+		cancel_work_sync(&i2s_tdm->next_work);
+		i2s_tdm->next_rate = 0;
+		i2s_tdm->next_frame = 0;
+		WRITE_ONCE(i2s_tdm->servo.running, false);
+		cancel_delayed_work_sync(&i2s_tdm->servo.work);
+	}
+
 	i2s_tdm->substreams[substream->stream] = NULL;
 }
 
@@ -1653,6 +2711,7 @@ static const struct snd_soc_dai_ops rockchip_i2s_tdm_dai_ops = {
 	.set_fmt = rockchip_i2s_tdm_set_fmt,
 	.set_tdm_slot = rockchip_dai_tdm_slot,
 	.trigger = rockchip_i2s_tdm_trigger,
+	.delay = rockchip_i2s_tdm_delay,
 };
 
 static const struct snd_soc_component_driver rockchip_i2s_tdm_component = {
@@ -2081,42 +3140,19 @@ static int rockchip_i2s_tdm_rx_path_prepare(struct rk_i2s_tdm_dev *i2s_tdm,
 	return rockchip_i2s_tdm_path_prepare(i2s_tdm, np, 1);
 }
 
-/*
-static int rockchip_i2s_tdm_get_fifo_count(struct device *dev, int stream)
-{
-	struct rk_i2s_tdm_dev *i2s_tdm = dev_get_drvdata(dev);
-	int val = 0;
-
-	if (stream == SNDRV_PCM_STREAM_PLAYBACK)
-		regmap_read(i2s_tdm->regmap, I2S_TXFIFOLR, &val);
-	else
-		regmap_read(i2s_tdm->regmap, I2S_RXFIFOLR, &val);
-
-	val = ((val & I2S_FIFOLR_TFL3_MASK) >> I2S_FIFOLR_TFL3_SHIFT) +
-	      ((val & I2S_FIFOLR_TFL2_MASK) >> I2S_FIFOLR_TFL2_SHIFT) +
-	      ((val & I2S_FIFOLR_TFL1_MASK) >> I2S_FIFOLR_TFL1_SHIFT) +
-	      ((val & I2S_FIFOLR_TFL0_MASK) >> I2S_FIFOLR_TFL0_SHIFT);
-
-	return val;
-}
-
-static const struct snd_dlp_config dconfig = {
-	.get_fifo_count = rockchip_i2s_tdm_get_fifo_count,
-};
-*/
-
-		/* RX FIFO Overrun
 static irqreturn_t rockchip_i2s_tdm_isr(int irq, void *devid)
 {
 	struct rk_i2s_tdm_dev *i2s_tdm = (struct rk_i2s_tdm_dev *)devid;
 	struct snd_pcm_substream *substream;
-	u32 val;
+	u32 val = 0;
 
 	regmap_read(i2s_tdm->regmap, I2S_INTSR, &val);
 	if (val & I2S_INTSR_TXUI_ACT) {
 		dev_warn_ratelimited(i2s_tdm->dev, "TX FIFO Underrun\n");
 		regmap_update_bits(i2s_tdm->regmap, I2S_INTCR,
 				   I2S_INTCR_TXUIC, I2S_INTCR_TXUIC);
+		i2s_tdm->stats[SNDRV_PCM_STREAM_PLAYBACK].xruns++;
+		i2s_tdm->stats[SNDRV_PCM_STREAM_PLAYBACK].last_xrun = ktime_get();
 		substream = i2s_tdm->substreams[SNDRV_PCM_STREAM_PLAYBACK];
 		if (substream)
 			snd_pcm_stop_xrun(substream);
@@ -2126,6 +3162,8 @@ static irqreturn_t rockchip_i2s_tdm_isr(int irq, void *devid)
 		dev_warn_ratelimited(i2s_tdm->dev, "RX FIFO Overrun\n");
 		regmap_update_bits(i2s_tdm->regmap, I2S_INTCR,
 				   I2S_INTCR_RXOIC, I2S_INTCR_RXOIC);
+		i2s_tdm->stats[SNDRV_PCM_STREAM_CAPTURE].xruns++;
+		i2s_tdm->stats[SNDRV_PCM_STREAM_CAPTURE].last_xrun = ktime_get();
 		substream = i2s_tdm->substreams[SNDRV_PCM_STREAM_CAPTURE];
 		if (substream)
 			snd_pcm_stop_xrun(substream);
@@ -2133,7 +3171,92 @@ static irqreturn_t rockchip_i2s_tdm_isr(int irq, void *devid)
 
 	return IRQ_HANDLED;
 }
-		*/
+
+#if defined(CONFIG_DEBUG_FS)
+static void rockchip_i2s_tdm_stats_show_one(struct seq_file *s,
+					    struct rk_i2s_tdm_dev *i2s_tdm,
+					    int stream)
+{
+	struct rk_i2s_tdm_stats *st = &i2s_tdm->stats[stream];
+
+	seq_printf(s, "%s:\n", stream ? "capture" : "playback");
+	seq_printf(s, "  xruns:            %llu\n", st->xruns);
+	seq_printf(s, "  last_xrun_ns:     %lld\n", ktime_to_ns(st->last_xrun));
+	seq_printf(s, "  updates:          %llu\n", st->updates);
+	seq_printf(s, "  fifo_last:        %u\n", st->fifo_last);
+	seq_printf(s, "  fifo_min:         %u\n",
+		   st->fifo_min == UINT_MAX ? 0 : st->fifo_min);
+	seq_printf(s, "  fifo_max:         %u\n", st->fifo_max);
+	seq_printf(s, "  max_update_gap_us: %lld\n",
+		   div_s64(st->max_update_gap_ns, NSEC_PER_USEC));
+}
+
+static int rockchip_i2s_tdm_stats_show(struct seq_file *s, void *v)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = s->private;
+
+	rockchip_i2s_tdm_stats_show_one(s, i2s_tdm, SNDRV_PCM_STREAM_PLAYBACK);
+	rockchip_i2s_tdm_stats_show_one(s, i2s_tdm, SNDRV_PCM_STREAM_CAPTURE);
+
+	seq_puts(s, "servo:\n");
+	seq_printf(s, "  source:           %s\n",
+		   servo_source_text[i2s_tdm->servo.source]);
+	seq_printf(s, "  target_us:        %u\n", i2s_tdm->servo.target_us);
+	seq_printf(s, "  running:          %d\n", i2s_tdm->servo.running);
+	seq_printf(s, "  fill_avg_us:      %lld\n", i2s_tdm->servo.fill_avg_us);
+	seq_printf(s, "  tai_offset_ns:    %lld\n", i2s_tdm->servo.offset_ns);
+	seq_printf(s, "  ppm:              %d\n", i2s_tdm->servo.ppm);
+
+	return 0;
+}
+
+static ssize_t rockchip_i2s_tdm_stats_write(struct file *file,
+					    const char __user *buf,
+					    size_t count, loff_t *ppos)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm =
+		((struct seq_file *)file->private_data)->private;
+	int i;
+
+	/* any write clears the counters */
+	for (i = 0; i <= SNDRV_PCM_STREAM_LAST; i++) {
+		memset(&i2s_tdm->stats[i], 0, sizeof(i2s_tdm->stats[i]));
+		i2s_tdm->stats[i].fifo_min = UINT_MAX;
+	}
+
+	return count;
+}
+
+static int rockchip_i2s_tdm_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, rockchip_i2s_tdm_stats_show, inode->i_private);
+}
+
+static const struct file_operations rockchip_i2s_tdm_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = rockchip_i2s_tdm_stats_open,
+	.read = seq_read,
+	.write = rockchip_i2s_tdm_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void rockchip_i2s_tdm_debugfs_init(struct rk_i2s_tdm_dev *i2s_tdm)
+{
+	i2s_tdm->debugfs_dir = debugfs_create_dir(dev_name(i2s_tdm->dev), NULL);
+	if (IS_ERR(i2s_tdm->debugfs_dir)) {
+		dev_err(i2s_tdm->dev, "failed to create debugfs dir\n");
+		return;
+	}
+
+	debugfs_create_file("stats", 0644, i2s_tdm->debugfs_dir, i2s_tdm,
+			    &rockchip_i2s_tdm_stats_fops);
+}
+#else
+static inline void rockchip_i2s_tdm_debugfs_init(struct rk_i2s_tdm_dev *i2s_tdm)
+{
+}
+#endif
 
 static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 {
@@ -2146,7 +3269,7 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 #ifdef HAVE_SYNC_RESET
 	bool sync;
 #endif
-	int ret, val, i;//, irq;
+	int ret, val, i, irq;
 //+++
 	struct clk *hclk_p, *hclk_pp;
 //+++
@@ -2166,6 +3289,12 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 		return -EINVAL;
 
 	spin_lock_init(&i2s_tdm->lock);
+	INIT_DELAYED_WORK(&i2s_tdm->servo.work, rockchip_i2s_tdm_servo_work);
+	hrtimer_init(&i2s_tdm->start_timer, CLOCK_TAI, HRTIMER_MODE_ABS_HARD);
+	i2s_tdm->start_timer.function = rockchip_i2s_tdm_start_timer;
+	hrtimer_init(&i2s_tdm->next_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_HARD);
+	i2s_tdm->next_timer.function = rockchip_i2s_tdm_next_timer;
+	INIT_WORK(&i2s_tdm->next_work, rockchip_i2s_tdm_next_work);
 	i2s_tdm->soc_data = (const struct rk_i2s_soc_data *)of_id->data;
 
 	for (i = 0; i < ARRAY_SIZE(of_quirks); i++)
@@ -2274,8 +3403,12 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 	i2s_tdm->dma_bytes = DMA_SLAVE_BUSWIDTH_4_BYTES;
 	of_property_read_u32(node, "my,dma_bytes", &i2s_tdm->dma_bytes );
 
-	i2s_tdm->dma_burst = 8;
+	i2s_tdm->dma_burst = 0;
 	of_property_read_u32(node, "my,dma_burst", &i2s_tdm->dma_burst );
+	if (i2s_tdm->dma_burst > I2S_FIFO_DEPTH / 2)
+		i2s_tdm->dma_burst = 0;
+
+	i2s_tdm->dma_watermark = 0;
 
 	//+++c
 
@@ -2293,14 +3426,32 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 			return dev_err_probe(i2s_tdm->dev, PTR_ERR(i2s_tdm->mclk_ext),
 					     "Failed to get clock mclk_ext\n");
 		}
-		else {
-			i2s_tdm->mclk_ext_mux = 0;
-			i2s_tdm->clk_44 = devm_clk_get(&pdev->dev, "clk_44");
-			if (!IS_ERR(i2s_tdm->clk_44)) {
-				i2s_tdm->clk_48 = devm_clk_get(&pdev->dev, "clk_48");
-				if (!IS_ERR(i2s_tdm->clk_48)) i2s_tdm->mclk_ext_mux = 1;
-			}
+	}
+
+	i2s_tdm->clk_44 = devm_clk_get_optional(&pdev->dev, "clk_44");
+	if (IS_ERR(i2s_tdm->clk_44))
+		return PTR_ERR(i2s_tdm->clk_44);
+
+	i2s_tdm->clk_48 = devm_clk_get_optional(&pdev->dev, "clk_48");
+	if (IS_ERR(i2s_tdm->clk_48))
+		return PTR_ERR(i2s_tdm->clk_48);
+
+	if (i2s_tdm->clk_44 && i2s_tdm->clk_48) {
+		/* keep both family parents locked, switching is a mux change */
+		ret = clk_prepare_enable(i2s_tdm->clk_44);
+		if (ret)
+			return ret;
+
+		ret = clk_prepare_enable(i2s_tdm->clk_48);
+		if (ret) {
+			clk_disable_unprepare(i2s_tdm->clk_44);
+			return ret;
 		}
+
+		if (i2s_tdm->mclk_external)
+			i2s_tdm->mclk_ext_mux = 1;
+		else
+			i2s_tdm->mclk_family_mux = 1;
 	}
 
 	i2s_tdm->dcount = 0;
@@ -2310,8 +3461,8 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 	i2s_tdm->io_multiplex =
 		of_property_read_bool(node, "rockchip,io-multiplex");
 
-	i2s_tdm->mclk_calibrate = 0;
-		//of_property_read_bool(node, "rockchip,mclk-calibrate");
+	i2s_tdm->mclk_calibrate =
+		of_property_read_bool(node, "rockchip,mclk-calibrate");
 	if (i2s_tdm->mclk_calibrate) {
 		i2s_tdm->mclk_tx_src = devm_clk_get(&pdev->dev, "mclk_tx_src");
 		if (IS_ERR(i2s_tdm->mclk_tx_src))
@@ -2344,7 +3495,6 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 	if (IS_ERR(i2s_tdm->regmap))
 		return PTR_ERR(i2s_tdm->regmap);
 
-		/* RX FIFO Overrun
 	irq = platform_get_irq_optional(pdev, 0);
 	if (irq > 0) {
 		ret = devm_request_irq(&pdev->dev, irq, rockchip_i2s_tdm_isr,
@@ -2354,7 +3504,6 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 			return ret;
 		}
 	}
-		*/
 
 	i2s_tdm->playback_dma_data.addr = res->start + I2S_TXDR;
 	i2s_tdm->playback_dma_data.addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
@@ -2378,6 +3527,7 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 
 	atomic_set(&i2s_tdm->refcount, 0);
 	dev_set_drvdata(&pdev->dev, i2s_tdm);
+	rockchip_i2s_tdm_debugfs_init(i2s_tdm);
 
 	pm_runtime_enable(&pdev->dev);
 	if (!pm_runtime_enabled(&pdev->dev)) {
@@ -2461,6 +3611,11 @@ static int rockchip_i2s_tdm_remove(struct platform_device *pdev)
 {
 	struct rk_i2s_tdm_dev *i2s_tdm = dev_get_drvdata(&pdev->dev);
 
+	cancel_delayed_work_sync(&i2s_tdm->servo.work);
+	hrtimer_cancel(&i2s_tdm->start_timer);
+	hrtimer_cancel(&i2s_tdm->next_timer);
+	cancel_work_sync(&i2s_tdm->next_work);
+	debugfs_remove_recursive(i2s_tdm->debugfs_dir);
 	pm_runtime_disable(&pdev->dev);
 	if (!pm_runtime_status_suspended(&pdev->dev))
 		i2s_tdm_runtime_suspend(&pdev->dev);
@@ -2468,6 +3623,10 @@ static int rockchip_i2s_tdm_remove(struct platform_device *pdev)
 	clk_disable_unprepare(i2s_tdm->mclk_tx);
 	clk_disable_unprepare(i2s_tdm->mclk_rx);
 	clk_disable_unprepare(i2s_tdm->hclk);
+	if (i2s_tdm->mclk_ext_mux || i2s_tdm->mclk_family_mux) {
+		clk_disable_unprepare(i2s_tdm->clk_48);
+		clk_disable_unprepare(i2s_tdm->clk_44);
+	}
 
 	return 0;
 }
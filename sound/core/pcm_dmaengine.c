@@ -11,6 +11,7 @@
  */
 #include <linux/module.h>
 #include <linux/init.h>
+#include <linux/cpuidle.h>
 #include <linux/dmaengine.h>
 #include <linux/slab.h>
 #include <sound/pcm.h>
@@ -20,11 +21,19 @@
 #include <sound/dmaengine_pcm.h>
 #include "pcm_local.h"
 
+#ifdef CONFIG_SND_PCM_XRUN_DEBUG
+#include "pcm_trace.h"
+#else
+#define trace_dma_complete(substream, chan)
+#endif
+
 struct dmaengine_pcm_runtime_data {
 	struct dma_chan *dma_chan;
 	dma_cookie_t cookie;
 
 	unsigned int pos;
+	bool hardirq_callback;
+	u64 period_ns;
 };
 
 static inline struct dmaengine_pcm_runtime_data *substream_to_prtd(
@@ -136,24 +145,76 @@ static void dmaengine_pcm_dma_complete(void *arg)
 	unsigned int new_pos;
 	struct snd_pcm_substream *substream = arg;
 	struct dmaengine_pcm_runtime_data *prtd;
+	unsigned long flags;
 
-	snd_pcm_stream_lock_irq(substream);
+	/* may be called from the DMAC interrupt, see hardirq_callback */
+	snd_pcm_stream_lock_irqsave(substream, flags);
 	if (PCM_RUNTIME_CHECK(substream)) {
-		snd_pcm_stream_unlock_irq(substream);
+		snd_pcm_stream_unlock_irqrestore(substream, flags);
 		return;
 	}
 
 	prtd = substream_to_prtd(substream);
+	trace_dma_complete(substream, prtd->dma_chan);
 
 	new_pos = prtd->pos + snd_pcm_lib_period_bytes(substream);
 	if (new_pos >= snd_pcm_lib_buffer_bytes(substream))
 		new_pos = 0;
 	prtd->pos = new_pos;
-	snd_pcm_stream_unlock_irq(substream);
+
+	/* the next period interrupt is due on this CPU one period from now */
+	cpuidle_set_wakeup_hint(ktime_add_ns(ktime_get(), prtd->period_ns));
+	snd_pcm_stream_unlock_irqrestore(substream, flags);
 
 	snd_pcm_period_elapsed(substream);
 }
 
+#ifdef CONFIG_SND_DMA_SGBUF
+/*
+ * One entry per physically contiguous run of the buffer, also split at
+ * every period boundary so the DMA can signal the end of each period.
+ */
+static struct dma_async_tx_descriptor *
+dmaengine_pcm_prep_sg(struct snd_pcm_substream *substream,
+		      struct dma_chan *chan,
+		      enum dma_transfer_direction direction,
+		      unsigned long flags)
+{
+	size_t buffer = snd_pcm_lib_buffer_bytes(substream);
+	size_t period = snd_pcm_lib_period_bytes(substream);
+	struct dma_async_tx_descriptor *desc;
+	struct scatterlist *sgl, *sg;
+	unsigned int ofs, len, nents = 0;
+
+	for (ofs = 0; ofs < buffer; ofs += len) {
+		len = min(period - ofs % period, buffer - ofs);
+		len = snd_pcm_sgbuf_get_chunk_size(substream, ofs, len);
+		nents++;
+	}
+
+	/* called from trigger, under the stream lock */
+	sgl = kmalloc_array(nents, sizeof(*sgl), GFP_ATOMIC);
+	if (!sgl)
+		return NULL;
+
+	sg_init_table(sgl, nents);
+	sg = sgl;
+	for (ofs = 0; ofs < buffer; ofs += len) {
+		len = min(period - ofs % period, buffer - ofs);
+		len = snd_pcm_sgbuf_get_chunk_size(substream, ofs, len);
+		sg_dma_address(sg) = snd_pcm_sgbuf_get_addr(substream, ofs);
+		sg_dma_len(sg) = len;
+		sg = sg_next(sg);
+	}
+
+	desc = dmaengine_prep_dma_cyclic_sg(chan, sgl, nents, period,
+					    direction, flags);
+	kfree(sgl);
+
+	return desc;
+}
+#endif
+
 static int dmaengine_pcm_prepare_and_submit(struct snd_pcm_substream *substream)
 {
 	struct dmaengine_pcm_runtime_data *prtd = substream_to_prtd(substream);
@@ -167,7 +228,18 @@ static int dmaengine_pcm_prepare_and_submit(struct snd_pcm_substream *substream)
 	if (!substream->runtime->no_period_wakeup)
 		flags |= DMA_PREP_INTERRUPT;
 
+	/* a nonatomic PCM takes a mutex in snd_pcm_period_elapsed() */
+	if (prtd->hardirq_callback && !substream->pcm->nonatomic)
+		flags |= DMA_PREP_CALLBACK_HARDIRQ;
+
 	prtd->pos = 0;
+	prtd->period_ns = div_u64((u64)substream->runtime->period_size *
+				  NSEC_PER_SEC, substream->runtime->rate);
+#ifdef CONFIG_SND_DMA_SGBUF
+	if (snd_pcm_get_dma_buf(substream)->dev.type == SNDRV_DMA_TYPE_DEV_SG)
+		desc = dmaengine_pcm_prep_sg(substream, chan, direction, flags);
+	else
+#endif
 	desc = dmaengine_prep_dma_cyclic(chan,
 		substream->runtime->dma_addr,
 		snd_pcm_lib_buffer_bytes(substream),
@@ -176,8 +248,10 @@ static int dmaengine_pcm_prepare_and_submit(struct snd_pcm_substream *substream)
 	if (!desc)
 		return -ENOMEM;
 
-	desc->callback = dmaengine_pcm_dma_complete;
-	desc->callback_param = substream;
+	if (flags & DMA_PREP_INTERRUPT) {
+		desc->callback = dmaengine_pcm_dma_complete;
+		desc->callback_param = substream;
+	}
 	prtd->cookie = dmaengine_submit(desc);
 
 	return 0;
@@ -330,6 +404,22 @@ int snd_dmaengine_pcm_open(struct snd_pcm_substream *substream,
 }
 EXPORT_SYMBOL_GPL(snd_dmaengine_pcm_open);
 
+/**
+ * snd_dmaengine_pcm_set_hardirq_callback - Deliver periods from the DMA IRQ
+ * @substream: PCM substream opened with snd_dmaengine_pcm_open()
+ * @enable: whether to ask for the period callback in hard interrupt context
+ *
+ * Saves the softirq latency of the DMA driver tasklet on every period for
+ * DMA drivers that honour DMA_PREP_CALLBACK_HARDIRQ, others keep using their
+ * tasklet. Takes effect on the next prepare/start of the substream.
+ */
+void snd_dmaengine_pcm_set_hardirq_callback(struct snd_pcm_substream *substream,
+					    bool enable)
+{
+	substream_to_prtd(substream)->hardirq_callback = enable;
+}
+EXPORT_SYMBOL_GPL(snd_dmaengine_pcm_set_hardirq_callback);
+
 /**
  * snd_dmaengine_pcm_open_request_chan - Open a dmaengine based PCM substream and request channel
  * @substream: PCM substream
@@ -419,6 +509,10 @@ int snd_dmaengine_pcm_refine_runtime_hwparams(
 			hw->info |= SNDRV_PCM_INFO_PAUSE | SNDRV_PCM_INFO_RESUME;
 		if (dma_caps.residue_granularity <= DMA_RESIDUE_GRANULARITY_SEGMENT)
 			hw->info |= SNDRV_PCM_INFO_BATCH;
+		else if (dma_caps.residue_granularity == DMA_RESIDUE_GRANULARITY_BURST &&
+			 !(hw->info & SNDRV_PCM_INFO_BATCH))
+			/* the pointer comes from the residue, not the period callback */
+			hw->info |= SNDRV_PCM_INFO_NO_PERIOD_WAKEUP;
 
 		if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
 			addr_widths = dma_caps.dst_addr_widths;
@@ -7,9 +7,12 @@
 
 #include <linux/slab.h>
 #include <linux/sched/signal.h>
+#include <linux/sched/clock.h>
+#include <linux/moduleparam.h>
 #include <linux/time.h>
 #include <linux/math64.h>
 #include <linux/export.h>
+#include <linux/uio.h>
 #include <sound/core.h>
 #include <sound/control.h>
 #include <sound/tlv.h>
@@ -23,14 +26,26 @@
 #ifdef CONFIG_SND_PCM_XRUN_DEBUG
 #define CREATE_TRACE_POINTS
 #include "pcm_trace.h"
+EXPORT_TRACEPOINT_SYMBOL_GPL(dma_complete);
 #else
 #define trace_hwptr(substream, pos, in_interrupt)
 #define trace_xrun(substream)
 #define trace_hw_ptr_error(substream, reason)
 #define trace_applptr(substream, prev, curr)
 #define trace_applptr_start(substream, frame)
+#define trace_period_lock(substream, held, periods)
+#define trace_period_lock_enabled()	false
+#define trace_avail_wake(substream, avail)
 #endif
 
+static unsigned int period_coalesce_us;
+module_param(period_coalesce_us, uint, 0644);
+MODULE_PARM_DESC(period_coalesce_us, "Max latency in us added by coalescing period interrupts (0 = off).");
+
+static unsigned int hwptr_publish_us;
+module_param(hwptr_publish_us, uint, 0644);
+MODULE_PARM_DESC(hwptr_publish_us, "Interval in us of hw_ptr updates between period interrupts (0 = off).");
+
 static int fill_silence_frames(struct snd_pcm_substream *substream,
 			       snd_pcm_uframes_t off, snd_pcm_uframes_t frames);
 
@@ -1778,6 +1793,108 @@ int snd_pcm_lib_ioctl(struct snd_pcm_substream *substream,
 }
 EXPORT_SYMBOL(snd_pcm_lib_ioctl);
 
+/**
+ * snd_pcm_period_coalesce_init - set up period interrupt coalescing
+ * @substream: the pcm substream instance
+ *
+ * Called at stream start.  With the period_coalesce_us module option set,
+ * streams whose period is shorter than the option process only every Nth
+ * period interrupt, so that the deferred hw_ptr update never lags more
+ * than period_coalesce_us behind the hardware.  N is capped at half the
+ * buffer so snd_pcm_update_hw_ptr0() can still detect the buffer wrap.
+ */
+void snd_pcm_period_coalesce_init(struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	unsigned int n = 1;
+	u64 frames;
+
+	if (period_coalesce_us && !runtime->no_period_wakeup) {
+		frames = div_u64((u64)period_coalesce_us * runtime->rate,
+				 USEC_PER_SEC);
+		n = clamp_t(u64, div_u64(frames, runtime->period_size),
+			    1, max(runtime->periods / 2, 1U));
+	}
+	runtime->period_coalesce = n;
+	runtime->period_pending = 0;
+}
+
+/*
+ * Return the number of period interrupts to process now, or 0 if this one
+ * is deferred.  Draining streams are never deferred so drain completes on
+ * time.  Called without the stream lock; the counter is only touched from
+ * the driver's period interrupt and from the start trigger, which the
+ * driver does not run concurrently.
+ */
+static unsigned int snd_pcm_period_coalesced(struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_runtime *runtime = READ_ONCE(substream->runtime);
+	unsigned int periods;
+
+	if (!runtime || runtime->period_coalesce <= 1)
+		return 1;
+
+	periods = ++runtime->period_pending;
+	if (periods < runtime->period_coalesce &&
+	    runtime->status->state == SNDRV_PCM_STATE_RUNNING)
+		return 0;
+	runtime->period_pending = 0;
+	return periods;
+}
+
+/*
+ * With the hwptr_publish_us module option set, running streams have their
+ * hw_ptr and audio timestamp refreshed from the pointer callback by an
+ * hrtimer, so a reader of the mmapped status record sees the DMA position
+ * without issuing HWSYNC.  The timer stops itself once the stream is no
+ * longer running.  Nonatomic streams cannot take their lock from the timer
+ * and are left alone.
+ */
+#define HWPTR_PUBLISH_MIN_US	100U
+
+static ktime_t snd_pcm_hwptr_publish_interval(unsigned int us)
+{
+	return us_to_ktime(max(us, HWPTR_PUBLISH_MIN_US));
+}
+
+static enum hrtimer_restart snd_pcm_hwptr_publish(struct hrtimer *timer)
+{
+	struct snd_pcm_substream *substream =
+		container_of(timer, struct snd_pcm_substream, hwptr_timer);
+	unsigned int us = READ_ONCE(hwptr_publish_us);
+	enum hrtimer_restart ret = HRTIMER_NORESTART;
+	unsigned long flags;
+
+	snd_pcm_stream_lock_irqsave(substream, flags);
+	if (us && substream->runtime &&
+	    substream->runtime->status->state == SNDRV_PCM_STATE_RUNNING) {
+		snd_pcm_update_hw_ptr(substream);
+		hrtimer_forward_now(timer, snd_pcm_hwptr_publish_interval(us));
+		ret = HRTIMER_RESTART;
+	}
+	snd_pcm_stream_unlock_irqrestore(substream, flags);
+
+	return ret;
+}
+
+void snd_pcm_hwptr_publish_init(struct snd_pcm_substream *substream)
+{
+	hrtimer_init(&substream->hwptr_timer, CLOCK_MONOTONIC,
+		     HRTIMER_MODE_REL);
+	substream->hwptr_timer.function = snd_pcm_hwptr_publish;
+}
+
+/* Called with the stream lock held when the stream starts running */
+void snd_pcm_hwptr_publish_start(struct snd_pcm_substream *substream)
+{
+	unsigned int us = READ_ONCE(hwptr_publish_us);
+
+	if (!us || substream->pcm->nonatomic)
+		return;
+	hrtimer_start(&substream->hwptr_timer,
+		      snd_pcm_hwptr_publish_interval(us), HRTIMER_MODE_REL);
+}
+
 /**
  * snd_pcm_period_elapsed - update the pcm status for the next period
  * @substream: the pcm substream instance
@@ -1793,11 +1910,19 @@ void snd_pcm_period_elapsed(struct snd_pcm_substream *substream)
 {
 	struct snd_pcm_runtime *runtime;
 	unsigned long flags;
+	unsigned int periods;
+	u64 t0 = 0;
 
 	if (snd_BUG_ON(!substream))
 		return;
 
+	periods = snd_pcm_period_coalesced(substream);
+	if (!periods)
+		return;
+
 	snd_pcm_stream_lock_irqsave(substream, flags);
+	if (trace_period_lock_enabled())
+		t0 = local_clock();
 	if (PCM_RUNTIME_CHECK(substream))
 		goto _unlock;
 	runtime = substream->runtime;
@@ -1813,7 +1938,10 @@ void snd_pcm_period_elapsed(struct snd_pcm_substream *substream)
  _end:
 	kill_fasync(&runtime->fasync, SIGIO, POLL_IN);
  _unlock:
+	if (trace_period_lock_enabled())
+		t0 = local_clock() - t0;
 	snd_pcm_stream_unlock_irqrestore(substream, flags);
+	trace_period_lock(substream, t0, periods);
 }
 EXPORT_SYMBOL(snd_pcm_period_elapsed);
 
@@ -1876,6 +2004,7 @@ static int wait_for_avail(struct snd_pcm_substream *substream,
 		tout = schedule_timeout(wait_time);
 
 		snd_pcm_stream_lock_irq(substream);
+		trace_avail_wake(substream, snd_pcm_avail(substream));
 		set_current_state(TASK_INTERRUPTIBLE);
 		switch (runtime->status->state) {
 		case SNDRV_PCM_STATE_SUSPENDED:
@@ -1939,6 +2068,17 @@ static int default_write_copy(struct snd_pcm_substream *substream,
 	return 0;
 }
 
+/* copy_user ops for write from an iov_iter, e.g. io_uring fixed buffers */
+static int default_write_copy_iter(struct snd_pcm_substream *substream,
+				   int channel, unsigned long hwoff,
+				   void *buf, unsigned long bytes)
+{
+	if (!copy_from_iter_full(get_dma_ptr(substream->runtime, channel, hwoff),
+				 bytes, buf))
+		return -EFAULT;
+	return 0;
+}
+
 /* default copy_kernel ops for write */
 static int default_write_copy_kernel(struct snd_pcm_substream *substream,
 				     int channel, unsigned long hwoff,
@@ -1981,6 +2121,17 @@ static int default_read_copy(struct snd_pcm_substream *substream,
 	return 0;
 }
 
+/* copy_user ops for read into an iov_iter */
+static int default_read_copy_iter(struct snd_pcm_substream *substream,
+				  int channel, unsigned long hwoff,
+				  void *buf, unsigned long bytes)
+{
+	if (copy_to_iter(get_dma_ptr(substream->runtime, channel, hwoff),
+			 bytes, buf) != bytes)
+		return -EFAULT;
+	return 0;
+}
+
 /* default copy_kernel ops for read */
 static int default_read_copy_kernel(struct snd_pcm_substream *substream,
 				    int channel, unsigned long hwoff,
@@ -2008,6 +2159,21 @@ static int interleaved_copy(struct snd_pcm_substream *substream,
 	return transfer(substream, 0, hwoff, data + off, frames);
 }
 
+/* same as interleaved_copy() but the data is an iov_iter, which advances
+ * by itself as the transfer function consumes it
+ */
+static int iter_copy(struct snd_pcm_substream *substream,
+		     snd_pcm_uframes_t hwoff, void *data,
+		     snd_pcm_uframes_t off,
+		     snd_pcm_uframes_t frames,
+		     pcm_transfer_f transfer)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+
+	return transfer(substream, 0, frames_to_bytes(runtime, hwoff), data,
+			frames_to_bytes(runtime, frames));
+}
+
 /* call transfer function with the converted pointers and sizes for each
  * non-interleaved channel; when buffer is NULL, silencing instead of copying
  */
@@ -2113,10 +2279,11 @@ int pcm_lib_apply_appl_ptr(struct snd_pcm_substream *substream,
 	return 0;
 }
 
-/* the common loop for read/write data */
-snd_pcm_sframes_t __snd_pcm_lib_xfer(struct snd_pcm_substream *substream,
-				     void *data, bool interleaved,
-				     snd_pcm_uframes_t size, bool in_kernel)
+/* the common loop for read/write data, SND_PCM_XFER_* flags */
+snd_pcm_sframes_t snd_pcm_lib_xfer_flags(struct snd_pcm_substream *substream,
+					 void *data, bool interleaved,
+					 snd_pcm_uframes_t size,
+					 unsigned int flags)
 {
 	struct snd_pcm_runtime *runtime = substream->runtime;
 	snd_pcm_uframes_t xfer = 0;
@@ -2139,7 +2306,9 @@ snd_pcm_sframes_t __snd_pcm_lib_xfer(struct snd_pcm_substream *substream,
 		if (runtime->access != SNDRV_PCM_ACCESS_RW_INTERLEAVED &&
 		    runtime->channels > 1)
 			return -EINVAL;
-		writer = interleaved_copy;
+		writer = flags & SND_PCM_XFER_ITER ? iter_copy : interleaved_copy;
+	} else if (flags & SND_PCM_XFER_ITER) {
+		return -EINVAL;
 	} else {
 		if (runtime->access != SNDRV_PCM_ACCESS_RW_NONINTERLEAVED)
 			return -EINVAL;
@@ -2151,7 +2320,13 @@ snd_pcm_sframes_t __snd_pcm_lib_xfer(struct snd_pcm_substream *substream,
 			transfer = fill_silence;
 		else
 			return -EINVAL;
-	} else if (in_kernel) {
+	} else if (flags & SND_PCM_XFER_ITER) {
+		/* the driver copy ops only take flat buffers */
+		if (substream->ops->copy_user || substream->ops->copy_kernel)
+			return -EOPNOTSUPP;
+		transfer = is_playback ?
+			default_write_copy_iter : default_read_copy_iter;
+	} else if (flags & SND_PCM_XFER_KERNEL) {
 		if (substream->ops->copy_kernel)
 			transfer = substream->ops->copy_kernel;
 		else
@@ -2168,7 +2343,8 @@ snd_pcm_sframes_t __snd_pcm_lib_xfer(struct snd_pcm_substream *substream,
 	if (size == 0)
 		return 0;
 
-	nonblock = !!(substream->f_flags & O_NONBLOCK);
+	nonblock = (substream->f_flags & O_NONBLOCK) ||
+		   (flags & SND_PCM_XFER_NONBLOCK);
 
 	snd_pcm_stream_lock_irq(substream);
 	err = pcm_accessible_state(runtime);
@@ -2264,6 +2440,14 @@ snd_pcm_sframes_t __snd_pcm_lib_xfer(struct snd_pcm_substream *substream,
 	snd_pcm_stream_unlock_irq(substream);
 	return xfer > 0 ? (snd_pcm_sframes_t)xfer : err;
 }
+
+snd_pcm_sframes_t __snd_pcm_lib_xfer(struct snd_pcm_substream *substream,
+				     void *data, bool interleaved,
+				     snd_pcm_uframes_t size, bool in_kernel)
+{
+	return snd_pcm_lib_xfer_flags(substream, data, interleaved, size,
+				      in_kernel ? SND_PCM_XFER_KERNEL : 0);
+}
 EXPORT_SYMBOL(__snd_pcm_lib_xfer);
 
 /*
@@ -28,10 +28,21 @@ int pcm_lib_apply_appl_ptr(struct snd_pcm_substream *substream,
 int snd_pcm_update_state(struct snd_pcm_substream *substream,
 			 struct snd_pcm_runtime *runtime);
 int snd_pcm_update_hw_ptr(struct snd_pcm_substream *substream);
+void snd_pcm_period_coalesce_init(struct snd_pcm_substream *substream);
+void snd_pcm_hwptr_publish_init(struct snd_pcm_substream *substream);
+void snd_pcm_hwptr_publish_start(struct snd_pcm_substream *substream);
 
 void snd_pcm_playback_silence(struct snd_pcm_substream *substream,
 			      snd_pcm_uframes_t new_hw_ptr);
 
+#define SND_PCM_XFER_KERNEL	(1 << 0)	/* data is a kernel buffer */
+#define SND_PCM_XFER_ITER	(1 << 1)	/* data is a struct iov_iter */
+#define SND_PCM_XFER_NONBLOCK	(1 << 2)	/* as if O_NONBLOCK (IOCB_NOWAIT) */
+snd_pcm_sframes_t snd_pcm_lib_xfer_flags(struct snd_pcm_substream *substream,
+					 void *data, bool interleaved,
+					 snd_pcm_uframes_t size,
+					 unsigned int flags);
+
 static inline snd_pcm_uframes_t
 snd_pcm_avail(struct snd_pcm_substream *substream)
 {
@@ -422,6 +422,7 @@ int snd_pcm_format_set_silence(snd_pcm_format_t format, void *data, unsigned int
 	int width;
 	unsigned char *dst;
 	const unsigned char *pat;
+	unsigned int bytes, done, chunk;
 
 	if (!valid_format(format))
 		return -EINVAL;
@@ -433,47 +434,28 @@ int snd_pcm_format_set_silence(snd_pcm_format_t format, void *data, unsigned int
 		return -EINVAL;
 	/* signed or 1 byte data */
 	if (pcm_formats[(INT)format].signd == 1 || width <= 8) {
-		unsigned int bytes = samples * width / 8;
+		bytes = samples * width / 8;
 		memset(data, *pat, bytes);
 		return 0;
 	}
-	/* non-zero samples, fill using a loop */
 	width /= 8;
-	dst = data;
-#if 0
-	while (samples--) {
-		memcpy(dst, pat, width);
-		dst += width;
+	bytes = samples * width;
+	/* one byte pattern, e.g. DSD_U16/U32 0x69 idle */
+	if (!memchr_inv(pat, *pat, width)) {
+		memset(data, *pat, bytes);
+		return 0;
 	}
-#else
-	/* a bit optimization for constant width */
-	switch (width) {
-	case 2:
-		while (samples--) {
-			memcpy(dst, pat, 2);
-			dst += 2;
-		}
-		break;
-	case 3:
-		while (samples--) {
-			memcpy(dst, pat, 3);
-			dst += 3;
-		}
-		break;
-	case 4:
-		while (samples--) {
-			memcpy(dst, pat, 4);
-			dst += 4;
-		}
-		break;
-	case 8:
-		while (samples--) {
-			memcpy(dst, pat, 8);
-			dst += 8;
-		}
-		break;
+	/*
+	 * non-zero samples: write one, then keep doubling the filled part
+	 * with memcpy(), so that long fills run at memcpy speed instead of
+	 * one call per sample
+	 */
+	dst = data;
+	memcpy(dst, pat, width);
+	for (done = width; done < bytes; done += chunk) {
+		chunk = min(done, bytes - done);
+		memcpy(dst + done, dst, chunk);
 	}
-#endif
 	return 0;
 }
 EXPORT_SYMBOL(snd_pcm_format_set_silence);
@@ -10,6 +10,7 @@
 #include <linux/file.h>
 #include <linux/slab.h>
 #include <linux/sched/signal.h>
+#include <linux/sched/task.h>
 #include <linux/time.h>
 #include <linux/pm_qos.h>
 #include <linux/io.h>
@@ -24,6 +25,7 @@
 #include <sound/minors.h>
 #include <linux/uio.h>
 #include <linux/delay.h>
+#include <uapi/linux/sched/types.h>
 
 #include "pcm_local.h"
 
@@ -501,19 +503,41 @@ static int fixup_unreferenced_params(struct snd_pcm_substream *substream,
 	return 0;
 }
 
-int snd_pcm_hw_refine(struct snd_pcm_substream *substream,
-		      struct snd_pcm_hw_params *params)
+/*
+ * Results of snd_pcm_hw_refine() for the last few distinct requests. The
+ * refinement is a function of the request and of the constraints, and
+ * rules may also look at the other streams or the controls of the card:
+ * entries hold the card hw_rules_gen they were made at, bumped on any
+ * control notification and any PCM open, close, hw_params and hw_free.
+ * Off by default, since a driver rule could depend on anything else.
+ */
+static bool hw_refine_cache;
+module_param(hw_refine_cache, bool, 0644);
+MODULE_PARM_DESC(hw_refine_cache, "Cache hw_refine results per substream.");
+
+#define SNDRV_PCM_HW_REFINE_CACHE_SIZE	4
+
+struct snd_pcm_hw_refine_cache {
+	struct mutex lock;
+	unsigned int next;
+	struct {
+		bool valid;
+		int err;
+		unsigned int gen;
+		struct snd_pcm_hw_params req;
+		struct snd_pcm_hw_params res;
+	} ent[SNDRV_PCM_HW_REFINE_CACHE_SIZE];
+};
+
+static void snd_pcm_hw_rules_changed(struct snd_pcm_substream *substream)
 {
-	int err;
+	atomic_inc(&substream->pcm->card->hw_rules_gen);
+}
 
-	params->info = 0;
-	params->fifo_size = 0;
-	if (params->rmask & PARAM_MASK_BIT(SNDRV_PCM_HW_PARAM_SAMPLE_BITS))
-		params->msbits = 0;
-	if (params->rmask & PARAM_MASK_BIT(SNDRV_PCM_HW_PARAM_RATE)) {
-		params->rate_num = 0;
-		params->rate_den = 0;
-	}
+static int __snd_pcm_hw_refine(struct snd_pcm_substream *substream,
+			       struct snd_pcm_hw_params *params)
+{
+	int err;
 
 	err = constrain_mask_params(substream, params);
 	if (err < 0)
@@ -531,6 +555,71 @@ int snd_pcm_hw_refine(struct snd_pcm_substream *substream,
 
 	return 0;
 }
+
+int snd_pcm_hw_refine(struct snd_pcm_substream *substream,
+		      struct snd_pcm_hw_params *params)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	struct snd_pcm_hw_refine_cache *cache;
+	struct snd_pcm_hw_params *req;
+	unsigned int gen, i;
+	int err;
+
+	params->info = 0;
+	params->fifo_size = 0;
+	if (params->rmask & PARAM_MASK_BIT(SNDRV_PCM_HW_PARAM_SAMPLE_BITS))
+		params->msbits = 0;
+	if (params->rmask & PARAM_MASK_BIT(SNDRV_PCM_HW_PARAM_RATE)) {
+		params->rate_num = 0;
+		params->rate_den = 0;
+	}
+
+	if (!hw_refine_cache)
+		return __snd_pcm_hw_refine(substream, params);
+
+	cache = READ_ONCE(runtime->hw_refine_cache);
+	if (!cache) {
+		cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+		if (!cache)
+			return __snd_pcm_hw_refine(substream, params);
+		mutex_init(&cache->lock);
+		/* the fd may be shared, another thread could be first */
+		if (cmpxchg(&runtime->hw_refine_cache, NULL, cache)) {
+			kfree(cache);
+			cache = runtime->hw_refine_cache;
+		}
+	}
+	gen = atomic_read(&substream->pcm->card->hw_rules_gen);
+
+	mutex_lock(&cache->lock);
+	for (i = 0; i < SNDRV_PCM_HW_REFINE_CACHE_SIZE; i++) {
+		if (cache->ent[i].valid && cache->ent[i].gen == gen &&
+		    !memcmp(&cache->ent[i].req, params, sizeof(*params))) {
+			*params = cache->ent[i].res;
+			err = cache->ent[i].err;
+			mutex_unlock(&cache->lock);
+			return err;
+		}
+	}
+	mutex_unlock(&cache->lock);
+
+	req = kmemdup(params, sizeof(*params), GFP_KERNEL);
+	err = __snd_pcm_hw_refine(substream, params);
+	if (!req)
+		return err;
+
+	mutex_lock(&cache->lock);
+	i = cache->next++ % SNDRV_PCM_HW_REFINE_CACHE_SIZE;
+	cache->ent[i].req = *req;
+	cache->ent[i].res = *params;
+	cache->ent[i].err = err;
+	cache->ent[i].gen = gen;
+	cache->ent[i].valid = true;
+	mutex_unlock(&cache->lock);
+	kfree(req);
+
+	return err;
+}
 EXPORT_SYMBOL(snd_pcm_hw_refine);
 
 static int snd_pcm_hw_refine_user(struct snd_pcm_substream *substream,
@@ -691,6 +780,93 @@ static void snd_pcm_buffer_access_unlock(struct snd_pcm_runtime *runtime)
 #define is_oss_stream(substream)	false
 #endif
 
+/* size the SCHED_DEADLINE reservation of @task from the current period */
+static int snd_pcm_dl_apply(struct snd_pcm_substream *substream,
+			    struct task_struct *task, unsigned int budget)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	struct sched_attr attr = {
+		.size = sizeof(attr),
+		.sched_policy = SCHED_DEADLINE,
+	};
+	u64 period;
+
+	if (!runtime->rate || !runtime->period_size)
+		return -EBADFD;
+
+	period = div_u64((u64)runtime->period_size * NSEC_PER_SEC,
+			 runtime->rate);
+	attr.sched_runtime = div_u64(period * budget, 1000);
+	attr.sched_deadline = period;
+	attr.sched_period = period;
+
+	return sched_setattr(task, &attr);
+}
+
+/* give the thread holding the reservation its previous scheduling back */
+static void snd_pcm_dl_release(struct snd_pcm_substream *substream)
+{
+	struct task_struct *task = substream->dl_task;
+	struct sched_attr attr = {
+		.size = sizeof(attr),
+		.sched_policy = substream->dl_saved_policy,
+		.sched_priority = substream->dl_saved_prio,
+		.sched_nice = substream->dl_saved_nice,
+	};
+
+	if (!task)
+		return;
+
+	/* unless it has been rescheduled since */
+	if (task->policy == SCHED_DEADLINE)
+		sched_setattr_nocheck(task, &attr);
+
+	put_task_struct(task);
+	substream->dl_task = NULL;
+}
+
+static int snd_pcm_dl_reserve(struct snd_pcm_substream *substream,
+			      int __user *_budget)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	int budget, err;
+
+	if (get_user(budget, _budget))
+		return -EFAULT;
+	if (budget < 0 || budget > 1000)
+		return -EINVAL;
+
+	err = snd_pcm_buffer_access_lock(runtime);
+	if (err < 0)
+		return err;
+
+	if (!budget) {
+		snd_pcm_dl_release(substream);
+		goto unlock;
+	}
+
+	if (substream->dl_task && substream->dl_task != current)
+		snd_pcm_dl_release(substream);
+
+	if (!substream->dl_task) {
+		substream->dl_saved_policy = current->policy;
+		substream->dl_saved_prio = current->rt_priority;
+		substream->dl_saved_nice = task_nice(current);
+	}
+
+	/* admission control may refuse it, the thread is left as it was */
+	err = snd_pcm_dl_apply(substream, current, budget);
+	if (err < 0)
+		goto unlock;
+
+	if (!substream->dl_task)
+		substream->dl_task = get_task_struct(current);
+	substream->dl_budget = budget;
+ unlock:
+	snd_pcm_buffer_access_unlock(runtime);
+	return err;
+}
+
 static int snd_pcm_hw_params(struct snd_pcm_substream *substream,
 			     struct snd_pcm_hw_params *params)
 {
@@ -750,6 +926,7 @@ static int snd_pcm_hw_params(struct snd_pcm_substream *substream,
 		if (err < 0)
 			goto _error;
 	}
+	snd_pcm_hw_rules_changed(substream);
 
 	runtime->access = params_access(params);
 	runtime->format = params_format(params);
@@ -807,6 +984,12 @@ static int snd_pcm_hw_params(struct snd_pcm_substream *substream,
 	if ((usecs = period_to_usecs(runtime)) >= 0)
 		cpu_latency_qos_add_request(&substream->latency_pm_qos_req,
 					    usecs);
+	if (substream->dl_task &&
+	    snd_pcm_dl_apply(substream, substream->dl_task,
+			     substream->dl_budget) < 0) {
+		pcm_dbg(substream->pcm, "deadline reservation dropped\n");
+		snd_pcm_dl_release(substream);
+	}
 	err = 0;
  _error:
 	if (err) {
@@ -850,7 +1033,9 @@ static int do_hw_free(struct snd_pcm_substream *substream)
 {
 	int result = 0;
 
+	snd_pcm_hw_rules_changed(substream);
 	snd_pcm_sync_stop(substream, true);
+	hrtimer_cancel(&substream->hwptr_timer);
 	if (substream->ops->hw_free)
 		result = substream->ops->hw_free(substream);
 	if (substream->managed_buffer_alloc)
@@ -1425,10 +1610,12 @@ static void snd_pcm_post_start(struct snd_pcm_substream *substream,
 	runtime->hw_ptr_jiffies = jiffies;
 	runtime->hw_ptr_buffer_jiffies = (runtime->buffer_size * HZ) / 
 							    runtime->rate;
+	snd_pcm_period_coalesce_init(substream);
 	runtime->status->state = state;
 	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK &&
 	    runtime->silence_size > 0)
 		snd_pcm_playback_silence(substream, ULONG_MAX);
+	snd_pcm_hwptr_publish_start(substream);
 	snd_pcm_timer_notify(substream, SNDRV_TIMER_EVENT_MSTART);
 }
 
@@ -1615,6 +1802,7 @@ static void snd_pcm_post_pause(struct snd_pcm_substream *substream,
 		wake_up(&runtime->tsleep);
 	} else {
 		runtime->status->state = SNDRV_PCM_STATE_RUNNING;
+		snd_pcm_hwptr_publish_start(substream);
 		snd_pcm_timer_notify(substream, SNDRV_TIMER_EVENT_MCONTINUE);
 	}
 }
@@ -2690,9 +2878,11 @@ void snd_pcm_release_substream(struct snd_pcm_substream *substream)
 			do_hw_free(substream);
 		substream->ops->close(substream);
 		substream->hw_opened = 0;
+		snd_pcm_hw_rules_changed(substream);
 	}
 	if (cpu_latency_qos_request_active(&substream->latency_pm_qos_req))
 		cpu_latency_qos_remove_request(&substream->latency_pm_qos_req);
+	snd_pcm_dl_release(substream);
 	if (substream->pcm_release) {
 		substream->pcm_release(substream);
 		substream->pcm_release = NULL;
@@ -2732,6 +2922,7 @@ int snd_pcm_open_substream(struct snd_pcm *pcm, int stream,
 		pcm_dbg(pcm, "snd_pcm_hw_constraints_complete failed\n");
 		goto error;
 	}
+	snd_pcm_hw_rules_changed(substream);
 
 	*rsubstream = substream;
 	return 0;
@@ -2763,6 +2954,8 @@ static int snd_pcm_open_file(struct file *file,
 	if (substream->ref_count == 1)
 		substream->pcm_release = pcm_release_private;
 	file->private_data = pcm_file;
+	/* read_iter/write_iter honour IOCB_NOWAIT, io_uring then polls */
+	file->f_mode |= FMODE_NOWAIT;
 
 	return 0;
 }
@@ -3308,6 +3501,8 @@ static int snd_pcm_common_ioctl(struct file *file,
 		return snd_pcm_link(substream, (int)(unsigned long) arg);
 	case SNDRV_PCM_IOCTL_UNLINK:
 		return snd_pcm_unlink(substream);
+	case SNDRV_PCM_IOCTL_DL_RESERVE:
+		return snd_pcm_dl_reserve(substream, arg);
 	case SNDRV_PCM_IOCTL_RESUME:
 		return snd_pcm_resume(substream);
 	case SNDRV_PCM_IOCTL_XRUN:
@@ -3465,6 +3660,30 @@ static ssize_t snd_pcm_write(struct file *file, const char __user *buf,
 	return result;
 }
 
+/*
+ * An interleaved stream takes any iov_iter as one run of frames: readv() and
+ * writev() with several segments, and the bvecs of io_uring fixed buffers.
+ * A non-interleaved stream takes one iovec per channel.
+ */
+static ssize_t snd_pcm_xfer_iter(struct snd_pcm_substream *substream,
+				 struct kiocb *iocb, struct iov_iter *iter)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	size_t count = iov_iter_count(iter);
+	snd_pcm_sframes_t result;
+
+	if (!frame_aligned(runtime, count))
+		return -EINVAL;
+	result = snd_pcm_lib_xfer_flags(substream, iter, true,
+					bytes_to_frames(runtime, count),
+					SND_PCM_XFER_ITER |
+					(iocb->ki_flags & IOCB_NOWAIT ?
+					 SND_PCM_XFER_NONBLOCK : 0));
+	if (result > 0)
+		result = frames_to_bytes(runtime, result);
+	return result;
+}
+
 static ssize_t snd_pcm_readv(struct kiocb *iocb, struct iov_iter *to)
 {
 	struct snd_pcm_file *pcm_file;
@@ -3482,6 +3701,8 @@ static ssize_t snd_pcm_readv(struct kiocb *iocb, struct iov_iter *to)
 	runtime = substream->runtime;
 	if (runtime->status->state == SNDRV_PCM_STATE_OPEN)
 		return -EBADFD;
+	if (runtime->access == SNDRV_PCM_ACCESS_RW_INTERLEAVED)
+		return snd_pcm_xfer_iter(substream, iocb, to);
 	if (!iter_is_iovec(to))
 		return -EINVAL;
 	if (to->nr_segs > 1024 || to->nr_segs != runtime->channels)
@@ -3494,7 +3715,9 @@ static ssize_t snd_pcm_readv(struct kiocb *iocb, struct iov_iter *to)
 		return -ENOMEM;
 	for (i = 0; i < to->nr_segs; ++i)
 		bufs[i] = to->iov[i].iov_base;
-	result = snd_pcm_lib_readv(substream, bufs, frames);
+	result = snd_pcm_lib_xfer_flags(substream, bufs, false, frames,
+					iocb->ki_flags & IOCB_NOWAIT ?
+					SND_PCM_XFER_NONBLOCK : 0);
 	if (result > 0)
 		result = frames_to_bytes(runtime, result);
 	kfree(bufs);
@@ -3518,6 +3741,8 @@ static ssize_t snd_pcm_writev(struct kiocb *iocb, struct iov_iter *from)
 	runtime = substream->runtime;
 	if (runtime->status->state == SNDRV_PCM_STATE_OPEN)
 		return -EBADFD;
+	if (runtime->access == SNDRV_PCM_ACCESS_RW_INTERLEAVED)
+		return snd_pcm_xfer_iter(substream, iocb, from);
 	if (!iter_is_iovec(from))
 		return -EINVAL;
 	if (from->nr_segs > 128 || from->nr_segs != runtime->channels ||
@@ -3529,7 +3754,9 @@ static ssize_t snd_pcm_writev(struct kiocb *iocb, struct iov_iter *from)
 		return -ENOMEM;
 	for (i = 0; i < from->nr_segs; ++i)
 		bufs[i] = from->iov[i].iov_base;
-	result = snd_pcm_lib_writev(substream, bufs, frames);
+	result = snd_pcm_lib_xfer_flags(substream, bufs, false, frames,
+					iocb->ki_flags & IOCB_NOWAIT ?
+					SND_PCM_XFER_NONBLOCK : 0);
 	if (result > 0)
 		result = frames_to_bytes(runtime, result);
 	kfree(bufs);
@@ -3590,7 +3817,15 @@ static __poll_t snd_pcm_poll(struct file *file, poll_table *wait)
  * Only on coherent architectures, we can mmap the status and the control records
  * for effcient data transfer.  On others, we have to use HWSYNC ioctl...
  */
-#if defined(CONFIG_X86) || defined(CONFIG_PPC) || defined(CONFIG_ALPHA)
+#if defined(CONFIG_X86) || defined(CONFIG_PPC) || defined(CONFIG_ALPHA) || \
+	defined(CONFIG_SND_PCM_STATUS_MMAP)
+#if defined(CONFIG_SND_PCM_STATUS_MMAP) && defined(CONFIG_ARM)
+#include <asm/cachetype.h>
+#define pcm_mmap_cache_aliasing()	(cache_is_vivt() || cache_is_vipt_aliasing())
+#else
+#define pcm_mmap_cache_aliasing()	false
+#endif
+
 /*
  * mmap status record
  */
@@ -3669,6 +3904,8 @@ static bool pcm_status_mmap_allowed(struct snd_pcm_file *pcm_file)
 	 * Since older alsa-lib requires both status and control mmaps to be
 	 * coupled, we have to disable the status mmap for old alsa-lib, too.
 	 */
+	if (pcm_mmap_cache_aliasing())
+		return false;
 	if (pcm_file->user_pversion < SNDRV_PROTOCOL_VERSION(2, 0, 14) &&
 	    (pcm_file->substream->runtime->hw.info & SNDRV_PCM_INFO_SYNC_APPLPTR))
 		return false;
@@ -3677,7 +3914,7 @@ static bool pcm_status_mmap_allowed(struct snd_pcm_file *pcm_file)
 
 static bool pcm_control_mmap_allowed(struct snd_pcm_file *pcm_file)
 {
-	if (pcm_file->no_compat_mmap)
+	if (pcm_file->no_compat_mmap || pcm_mmap_cache_aliasing())
 		return false;
 	/* Disallow the control mmap when SYNC_APPLPTR flag is set;
 	 * it enforces the user-space to fall back to snd_pcm_sync_ptr(),
@@ -3797,6 +4034,11 @@ int snd_pcm_lib_default_mmap(struct snd_pcm_substream *substream,
 					 substream->runtime->dma_area,
 					 substream->runtime->dma_addr,
 					 substream->runtime->dma_bytes);
+#if defined(CONFIG_SND_DMA_SGBUF) && !defined(CONFIG_X86)
+	/* match the uncached kernel mapping of the chunks */
+	if (substream->dma_buffer.dev.type == SNDRV_DMA_TYPE_DEV_SG)
+		area->vm_page_prot = pgprot_dmacoherent(area->vm_page_prot);
+#endif
 	/* mmap with fault handler */
 	area->vm_ops = &snd_pcm_vm_ops_data_fault;
 	return 0;
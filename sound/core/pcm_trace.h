@@ -6,6 +6,7 @@
 #if !defined(_PCM_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
 #define _PCM_TRACE_H
 
+#include <linux/dmaengine.h>
 #include <linux/tracepoint.h>
 
 TRACE_EVENT(hwptr,
@@ -167,6 +168,87 @@ TRACE_EVENT(applptr_start,
 	)
 );
 
+TRACE_EVENT(period_lock,
+	TP_PROTO(struct snd_pcm_substream *substream, u64 held, unsigned int periods),
+	TP_ARGS(substream, held, periods),
+	TP_STRUCT__entry(
+		__field( unsigned int, card )
+		__field( unsigned int, device )
+		__field( unsigned int, number )
+		__field( unsigned int, stream )
+		__field( u64, held )
+		__field( unsigned int, periods )
+	),
+	TP_fast_assign(
+		__entry->card = (substream)->pcm->card->number;
+		__entry->device = (substream)->pcm->device;
+		__entry->number = (substream)->number;
+		__entry->stream = (substream)->stream;
+		__entry->held = (held);
+		__entry->periods = (periods);
+	),
+	TP_printk("pcmC%dD%d%s/sub%d: held=%lluns, periods=%u",
+		__entry->card,
+		__entry->device,
+		__entry->stream ? "c" : "p",
+		__entry->number,
+		(unsigned long long)__entry->held,
+		__entry->periods
+	)
+);
+
+TRACE_EVENT(dma_complete,
+	TP_PROTO(struct snd_pcm_substream *substream, struct dma_chan *chan),
+	TP_ARGS(substream, chan),
+	TP_STRUCT__entry(
+		__field( unsigned int, card )
+		__field( unsigned int, device )
+		__field( unsigned int, number )
+		__field( unsigned int, stream )
+		__string( chan, dma_chan_name(chan) )
+	),
+	TP_fast_assign(
+		__entry->card = (substream)->pcm->card->number;
+		__entry->device = (substream)->pcm->device;
+		__entry->number = (substream)->number;
+		__entry->stream = (substream)->stream;
+		__assign_str(chan, dma_chan_name(chan));
+	),
+	TP_printk("pcmC%dD%d%s/sub%d: chan=%s",
+		__entry->card,
+		__entry->device,
+		__entry->stream ? "c" : "p",
+		__entry->number,
+		__get_str(chan)
+	)
+);
+
+TRACE_EVENT(avail_wake,
+	TP_PROTO(struct snd_pcm_substream *substream, snd_pcm_uframes_t avail),
+	TP_ARGS(substream, avail),
+	TP_STRUCT__entry(
+		__field( unsigned int, card )
+		__field( unsigned int, device )
+		__field( unsigned int, number )
+		__field( unsigned int, stream )
+		__field( snd_pcm_uframes_t, avail )
+	),
+	TP_fast_assign(
+		__entry->card = (substream)->pcm->card->number;
+		__entry->device = (substream)->pcm->device;
+		__entry->number = (substream)->number;
+		__entry->stream = (substream)->stream;
+		__entry->avail = (avail);
+	),
+	TP_printk("pcmC%dD%d%s/sub%d: avail=%lu",
+		__entry->card,
+		__entry->device,
+		__entry->stream ? "c" : "p",
+		__entry->number,
+		__entry->avail
+	)
+);
+
 #endif /* _PCM_TRACE_H */
 
 /* This part must be outside protection */
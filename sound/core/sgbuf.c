@@ -9,6 +9,7 @@
 #include <linux/mm.h>
 #include <linux/vmalloc.h>
 #include <linux/export.h>
+#include <linux/dma-direct.h>
 #include <sound/memalloc.h>
 
 
@@ -51,6 +52,21 @@ int snd_free_sgbuf_pages(struct snd_dma_buffer *dmab)
 
 #define MAX_ALLOC_PAGES		32
 
+/*
+ * Coherent memory is not in the linear map on ARM, so the page behind a
+ * chunk is found from its bus address there. That only holds for DMA
+ * masters without an IOMMU, like the pl330 of the audio controllers.
+ */
+static struct page *sgbuf_chunk_page(struct device *device,
+				     struct snd_dma_buffer *dmab)
+{
+#ifdef CONFIG_X86
+	return virt_to_page(dmab->area);
+#else
+	return pfn_to_page(PHYS_PFN(dma_to_phys(device, dmab->addr)));
+#endif
+}
+
 void *snd_malloc_sgbuf_pages(struct device *device,
 			     size_t size, struct snd_dma_buffer *dmab,
 			     size_t *res_size)
@@ -74,6 +90,11 @@ void *snd_malloc_sgbuf_pages(struct device *device,
 		prot = pgprot_noncached(PAGE_KERNEL);
 #endif
 	}
+#ifndef CONFIG_X86
+	/* same attributes as the coherent mapping of the chunks */
+	if (type == SNDRV_DMA_TYPE_DEV)
+		prot = pgprot_dmacoherent(PAGE_KERNEL);
+#endif
 	sgbuf->dev = device;
 	pages = snd_sgbuf_aligned_pages(size);
 	sgbuf->tblsize = sgbuf_align_table(pages);
@@ -88,6 +109,13 @@ void *snd_malloc_sgbuf_pages(struct device *device,
 
 	/* allocate pages */
 	maxpages = MAX_ALLOC_PAGES;
+	/*
+	 * A DMA without scatter-gather hardware loops over the chunks in
+	 * its program, so start from the whole buffer and let the fallback
+	 * halve it: a few big chunks when memory allows, pages if not.
+	 */
+	if (!IS_ENABLED(CONFIG_X86))
+		maxpages = pages;
 	while (pages > 0) {
 		chunk = pages;
 		/* don't be too eager to take a huge chunk */
@@ -110,7 +138,7 @@ void *snd_malloc_sgbuf_pages(struct device *device,
 			if (!i)
 				table->addr |= chunk; /* mark head */
 			table++;
-			*pgtable++ = virt_to_page(tmpb.area);
+			*pgtable++ = sgbuf_chunk_page(device, &tmpb);
 			tmpb.area += PAGE_SIZE;
 			tmpb.addr += PAGE_SIZE;
 		}
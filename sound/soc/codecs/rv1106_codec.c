@@ -52,6 +52,9 @@
 
 #define NOT_SPECIFIED			(-1)
 
+#define ACODEC_REG_NUM			(ACODEC_REG_MAX / 4 + 1)
+#define LINEOUT_RAMP_MS_MAX		10000
+
 enum soc_id_e {
 	SOC_RV1103 = 0x1103,
 	SOC_RV1106 = 0x1106,
@@ -113,6 +116,34 @@ struct rv1106_codec_priv {
 	bool micbias_enable;
 	bool micbias_used;
 
+	/*
+	 * Idle power gating: idle_off_ms after the last stream closed the
+	 * analog part is powered down, the registers are saved to snapshot[]
+	 * and the codec is held in reset with its mclk off. The next open
+	 * restores the snapshot instead of re-running the init sequence and
+	 * powers the analog part up from power_work, in parallel with the
+	 * rest of the stream setup.
+	 */
+	struct mutex power_lock;
+	struct work_struct power_work;
+	struct delayed_work idle_work;
+	u32 idle_off_ms;
+	u32 snapshot[ACODEC_REG_NUM];
+	unsigned int streams;
+	bool dlp_up;
+	bool gated;
+
+	/*
+	 * LINEOUT gain ramp: "DAC LINEOUT Ramp" sets a target and a
+	 * duration, ramp_work then walks the 1.5dB steps on its own.
+	 */
+	struct delayed_work ramp_work;
+	unsigned long ramp_start;
+	unsigned int ramp_from;
+	unsigned int ramp_target;
+	unsigned int ramp_ms;
+	unsigned int ramp_gain;
+
 #if defined(CONFIG_DEBUG_FS)
 	struct dentry *dbg_codec;
 #endif
@@ -189,6 +220,12 @@ static int rv1106_codec_dac_ctrl_manual_get(struct snd_kcontrol *kcontrol,
 					    struct snd_ctl_elem_value *ucontrol);
 static int rv1106_codec_dac_ctrl_manual_put(struct snd_kcontrol *kcontrol,
 					    struct snd_ctl_elem_value *ucontrol);
+static int rv1106_codec_lineout_ramp_info(struct snd_kcontrol *kcontrol,
+					  struct snd_ctl_elem_info *uinfo);
+static int rv1106_codec_lineout_ramp_get(struct snd_kcontrol *kcontrol,
+					 struct snd_ctl_elem_value *ucontrol);
+static int rv1106_codec_lineout_ramp_put(struct snd_kcontrol *kcontrol,
+					 struct snd_ctl_elem_value *ucontrol);
 
 static const char *offon_text[2] = {
 	[0] = "Off",
@@ -441,6 +478,15 @@ static const struct snd_kcontrol_new rv1106_codec_dapm_controls[] = {
 			   rv1106_codec_hpmix_gain_put,
 			   rv1106_codec_dac_hpmix_gain_tlv),
 
+	/* DAC LINEOUT gain ramp: target gain index, duration in ms */
+	{
+		.iface = SNDRV_CTL_ELEM_IFACE_MIXER,
+		.name = "DAC LINEOUT Ramp",
+		.info = rv1106_codec_lineout_ramp_info,
+		.get = rv1106_codec_lineout_ramp_get,
+		.put = rv1106_codec_lineout_ramp_put,
+	},
+
 	/* DAC Control Manually */
 	SOC_ENUM_EXT("DAC Control Manually", rv1106_dac_pa_ctrl_maunal_enum_array[0],
 		     rv1106_codec_dac_ctrl_manual_get, rv1106_codec_dac_ctrl_manual_put),
@@ -1407,6 +1453,112 @@ static int rv1106_codec_dac_ctrl_manual_put(struct snd_kcontrol *kcontrol,
 	return 0;
 }
 
+static void rv1106_codec_ramp_work(struct work_struct *work)
+{
+	struct rv1106_codec_priv *rv1106 =
+		container_of(to_delayed_work(work), struct rv1106_codec_priv,
+			     ramp_work);
+	unsigned int idx = ACODEC_DAC_ANA_CTL2 / 4;
+	unsigned int steps, done, elapsed, gain;
+	unsigned long next;
+
+	mutex_lock(&rv1106->power_lock);
+	if (rv1106->gated) {
+		/* nothing to hear, land on the target at ungate */
+		rv1106->snapshot[idx] &= ~ACODEC_DAC_LINEOUT_GAIN_MSK;
+		rv1106->snapshot[idx] |= rv1106->ramp_target;
+		goto out;
+	}
+
+	regmap_read(rv1106->regmap, ACODEC_DAC_ANA_CTL2, &gain);
+	/* the volume control was written meanwhile, it wins */
+	if ((gain & ACODEC_DAC_LINEOUT_GAIN_MSK) != rv1106->ramp_gain)
+		goto out;
+
+	steps = abs((int)rv1106->ramp_target - (int)rv1106->ramp_from);
+	elapsed = jiffies_to_msecs(jiffies - rv1106->ramp_start);
+	if (elapsed >= rv1106->ramp_ms)
+		done = steps;
+	else
+		done = steps * elapsed / rv1106->ramp_ms;
+
+	if (rv1106->ramp_target < rv1106->ramp_from)
+		gain = rv1106->ramp_from - done;
+	else
+		gain = rv1106->ramp_from + done;
+
+	regmap_update_bits(rv1106->regmap, ACODEC_DAC_ANA_CTL2,
+			   ACODEC_DAC_LINEOUT_GAIN_MSK, gain);
+	rv1106->ramp_gain = gain;
+
+	if (done < steps) {
+		next = rv1106->ramp_start +
+		       msecs_to_jiffies(DIV_ROUND_UP(rv1106->ramp_ms * (done + 1),
+						     steps));
+		schedule_delayed_work(&rv1106->ramp_work,
+				      time_after(next, jiffies) ? next - jiffies : 0);
+	}
+out:
+	mutex_unlock(&rv1106->power_lock);
+}
+
+static int rv1106_codec_lineout_ramp_info(struct snd_kcontrol *kcontrol,
+					  struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER;
+	uinfo->count = 2;
+	uinfo->value.integer.min = 0;
+	uinfo->value.integer.max = LINEOUT_RAMP_MS_MAX;
+
+	return 0;
+}
+
+static int rv1106_codec_lineout_ramp_get(struct snd_kcontrol *kcontrol,
+					 struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rv1106_codec_priv *rv1106 = snd_soc_component_get_drvdata(component);
+
+	ucontrol->value.integer.value[0] = rv1106->ramp_target;
+	ucontrol->value.integer.value[1] = rv1106->ramp_ms;
+
+	return 0;
+}
+
+static int rv1106_codec_lineout_ramp_put(struct snd_kcontrol *kcontrol,
+					 struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rv1106_codec_priv *rv1106 = snd_soc_component_get_drvdata(component);
+	long target = ucontrol->value.integer.value[0];
+	long ms = ucontrol->value.integer.value[1];
+	unsigned int gain;
+
+	if (target < ACODEC_DAC_LINEOUT_GAIN_MIN ||
+	    target > ACODEC_DAC_LINEOUT_GAIN_MAX ||
+	    ms < 0 || ms > LINEOUT_RAMP_MS_MAX)
+		return -EINVAL;
+
+	cancel_delayed_work_sync(&rv1106->ramp_work);
+
+	mutex_lock(&rv1106->power_lock);
+	if (rv1106->gated)
+		gain = rv1106->snapshot[ACODEC_DAC_ANA_CTL2 / 4];
+	else
+		regmap_read(rv1106->regmap, ACODEC_DAC_ANA_CTL2, &gain);
+
+	rv1106->ramp_from = gain & ACODEC_DAC_LINEOUT_GAIN_MSK;
+	rv1106->ramp_gain = rv1106->ramp_from;
+	rv1106->ramp_target = target;
+	rv1106->ramp_ms = ms;
+	rv1106->ramp_start = jiffies;
+	mutex_unlock(&rv1106->power_lock);
+
+	schedule_delayed_work(&rv1106->ramp_work, 0);
+
+	return 1;
+}
+
 static int rv1106_codec_adc_enable(struct rv1106_codec_priv *rv1106)
 {
 	unsigned int lr = using_adc_lr(rv1106->adc_mode);
@@ -1641,6 +1793,7 @@ static int rv1106_codec_dlp_down(struct rv1106_codec_priv *rv1106)
 {
 	rv1106_codec_micbias_disable(rv1106);
 	rv1106_codec_power_off(rv1106);
+	rv1106->dlp_up = false;
 	return 0;
 }
 
@@ -1648,9 +1801,110 @@ static int rv1106_codec_dlp_up(struct rv1106_codec_priv *rv1106)
 {
 	rv1106_codec_power_on(rv1106);
 	rv1106_codec_micbias_enable(rv1106, rv1106->micbias_volt);
+	rv1106->dlp_up = true;
+	return 0;
+}
+
+/* Called with power_lock held, once the DAC and ADC are disabled */
+static void rv1106_codec_gate(struct rv1106_codec_priv *rv1106)
+{
+	int i;
+
+	if (rv1106->dlp_up)
+		rv1106_codec_dlp_down(rv1106);
+
+	/* analog parts are all off now, so is their state in the snapshot */
+	for (i = 0; i < ACODEC_REG_NUM; i++)
+		regmap_read(rv1106->regmap, i * 4, &rv1106->snapshot[i]);
+
+	reset_control_assert(rv1106->reset);
+	clk_disable_unprepare(rv1106->mclk_acodec);
+	rv1106->gated = true;
+}
+
+/* Called with power_lock held */
+static int rv1106_codec_ungate(struct rv1106_codec_priv *rv1106)
+{
+	int ret, i;
+
+	if (!rv1106->gated)
+		return 0;
+
+	ret = clk_prepare_enable(rv1106->mclk_acodec);
+	if (ret < 0) {
+		dev_err(rv1106->plat_dev,
+			"Failed to enable acodec mclk_acodec: %d
+", ret);
+		return ret;
+	}
+	reset_control_deassert(rv1106->reset);
+
+	/* ACODEC_GLB_CON goes first and takes the core out of reset */
+	for (i = 0; i < ACODEC_REG_NUM; i++)
+		regmap_write(rv1106->regmap, i * 4, rv1106->snapshot[i]);
+
+	rv1106->gated = false;
+
 	return 0;
 }
 
+static void rv1106_codec_power_work(struct work_struct *work)
+{
+	struct rv1106_codec_priv *rv1106 =
+		container_of(work, struct rv1106_codec_priv, power_work);
+
+	mutex_lock(&rv1106->power_lock);
+	if (!rv1106->gated) {
+		if (!rv1106->dlp_up)
+			rv1106_codec_dlp_up(rv1106);
+		if ((rv1106->streams & BIT(SNDRV_PCM_STREAM_PLAYBACK)) &&
+		    !rv1106->dac_enable)
+			rv1106_codec_open_playback(rv1106);
+	}
+	mutex_unlock(&rv1106->power_lock);
+}
+
+static void rv1106_codec_idle_work(struct work_struct *work)
+{
+	struct rv1106_codec_priv *rv1106 =
+		container_of(to_delayed_work(work), struct rv1106_codec_priv,
+			     idle_work);
+
+	mutex_lock(&rv1106->power_lock);
+	if (!rv1106->streams && !rv1106->gated) {
+		/* outputs and PA were muted at stream stop, no pop here */
+		if (rv1106->dac_enable)
+			rv1106_codec_close_playback(rv1106);
+		if (rv1106->adc_enable)
+			rv1106_codec_close_capture(rv1106);
+		rv1106_codec_gate(rv1106);
+	}
+	mutex_unlock(&rv1106->power_lock);
+}
+
+static int rv1106_pcm_startup(struct snd_pcm_substream *substream,
+			      struct snd_soc_dai *dai)
+{
+	struct snd_soc_component *component = dai->component;
+	struct rv1106_codec_priv *rv1106 = snd_soc_component_get_drvdata(component);
+	int ret;
+
+	cancel_delayed_work_sync(&rv1106->idle_work);
+
+	mutex_lock(&rv1106->power_lock);
+	ret = rv1106_codec_ungate(rv1106);
+	if (!ret) {
+		rv1106->streams |= BIT(substream->stream);
+		if (!rv1106->dlp_up ||
+		    (substream->stream == SNDRV_PCM_STREAM_PLAYBACK &&
+		     !rv1106->dac_enable))
+			queue_work(system_highpri_wq, &rv1106->power_work);
+	}
+	mutex_unlock(&rv1106->power_lock);
+
+	return ret;
+}
+
 static int rv1106_hw_params(struct snd_pcm_substream *substream,
 			    struct snd_pcm_hw_params *params,
 			    struct snd_soc_dai *dai)
@@ -1658,13 +1912,19 @@ static int rv1106_hw_params(struct snd_pcm_substream *substream,
 	struct snd_soc_component *component = dai->component;
 	struct rv1106_codec_priv *rv1106 = snd_soc_component_get_drvdata(component);
 
+	flush_work(&rv1106->power_work);
+
+	mutex_lock(&rv1106->power_lock);
 	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
-		rv1106_codec_open_playback(rv1106);
+		/* still enabled from the previous track, skip the sequence */
+		if (!rv1106->dac_enable)
+			rv1106_codec_open_playback(rv1106);
 		rv1106_codec_dac_dig_config(rv1106, params);
 	} else {
 		rv1106_codec_open_capture(rv1106);
 		rv1106_codec_adc_dig_config(rv1106, params);
 	}
+	mutex_unlock(&rv1106->power_lock);
 
 	return 0;
 }
@@ -1675,16 +1935,28 @@ static void rv1106_pcm_shutdown(struct snd_pcm_substream *substream,
 	struct snd_soc_component *component = dai->component;
 	struct rv1106_codec_priv *rv1106 = snd_soc_component_get_drvdata(component);
 
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
-		rv1106_codec_close_playback(rv1106);
-	else
+	flush_work(&rv1106->power_work);
+
+	mutex_lock(&rv1106->power_lock);
+	rv1106->streams &= ~BIT(substream->stream);
+
+	/* with idle gating the DAC is kept up for the next track */
+	if (substream->stream == SNDRV_PCM_STREAM_CAPTURE)
 		rv1106_codec_close_capture(rv1106);
+	else if (!rv1106->idle_off_ms)
+		rv1106_codec_close_playback(rv1106);
+
+	if (rv1106->idle_off_ms && !rv1106->streams)
+		mod_delayed_work(system_wq, &rv1106->idle_work,
+				 msecs_to_jiffies(rv1106->idle_off_ms));
+	mutex_unlock(&rv1106->power_lock);
 
 	regcache_cache_only(rv1106->regmap, false);
 	regcache_sync(rv1106->regmap);
 }
 
 static const struct snd_soc_dai_ops rv1106_dai_ops = {
+	.startup = rv1106_pcm_startup,
 	.hw_params = rv1106_hw_params,
 	.set_fmt = rv1106_set_dai_fmt,
 	.mute_stream = rv1106_mute_stream,
@@ -1723,6 +1995,16 @@ static int rv1106_suspend(struct snd_soc_component *component)
 {
 	struct rv1106_codec_priv *rv1106 = snd_soc_component_get_drvdata(component);
 
+	cancel_delayed_work_sync(&rv1106->idle_work);
+	flush_work(&rv1106->power_work);
+
+	mutex_lock(&rv1106->power_lock);
+	if (rv1106_codec_ungate(rv1106)) {
+		mutex_unlock(&rv1106->power_lock);
+		return -EIO;
+	}
+	mutex_unlock(&rv1106->power_lock);
+
 	rv1106_codec_dlp_down(rv1106);
 	clk_disable_unprepare(rv1106->mclk_acodec);
 	clk_disable_unprepare(rv1106->pclk_acodec);
@@ -1878,6 +2160,11 @@ static void rv1106_remove(struct snd_soc_component *component)
 {
 	struct rv1106_codec_priv *rv1106 = snd_soc_component_get_drvdata(component);
 
+	cancel_delayed_work_sync(&rv1106->ramp_work);
+	cancel_delayed_work_sync(&rv1106->idle_work);
+	cancel_work_sync(&rv1106->power_work);
+	rv1106_codec_ungate(rv1106);
+
 	rv1106_codec_pa_ctrl(rv1106, false);
 	rv1106_codec_micbias_disable(rv1106);
 	rv1106_codec_power_off(rv1106);
@@ -2182,6 +2469,13 @@ static int rv1106_platform_probe(struct platform_device *pdev)
 		of_property_read_u32(np, "pa-ctl-delay-ms",
 				     &rv1106->pa_ctl_delay_ms);
 
+	/* 0: power the DAC down at once when playback stops, as before */
+	of_property_read_u32(np, "idle-off-ms", &rv1106->idle_off_ms);
+	mutex_init(&rv1106->power_lock);
+	INIT_WORK(&rv1106->power_work, rv1106_codec_power_work);
+	INIT_DELAYED_WORK(&rv1106->idle_work, rv1106_codec_idle_work);
+	INIT_DELAYED_WORK(&rv1106->ramp_work, rv1106_codec_ramp_work);
+
 	dev_info(&pdev->dev, "%s pa_ctl_gpio and pa_ctl_delay_ms: %d\n",
 		rv1106->pa_ctl_gpio ? "Use" : "No use",
 		rv1106->pa_ctl_delay_ms);
@@ -2292,6 +2586,11 @@ static int rv1106_platform_remove(struct platform_device *pdev)
 	struct rv1106_codec_priv *rv1106 =
 		(struct rv1106_codec_priv *)platform_get_drvdata(pdev);
 
+	cancel_delayed_work_sync(&rv1106->ramp_work);
+	cancel_delayed_work_sync(&rv1106->idle_work);
+	cancel_work_sync(&rv1106->power_work);
+	rv1106_codec_ungate(rv1106);
+
 	clk_disable_unprepare(rv1106->mclk_acodec);
 	clk_disable_unprepare(rv1106->pclk_acodec);
 #if defined(CONFIG_DEBUG_FS)
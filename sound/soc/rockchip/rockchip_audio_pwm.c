@@ -15,10 +15,14 @@
 #include <linux/regmap.h>
 #include <sound/dmaengine_pcm.h>
 #include <sound/pcm_params.h>
+#include <sound/soc.h>
 
 #include "rockchip_audio_pwm.h"
 
 #define AUDIO_PWM_DMA_BURST_SIZE	(16) /* size * width: 16*4 = 64 bytes */
+#define AUDIO_PWM_NS_ORDER_MAX		3
+/* the interpolation of 48k streams sets the PWM carrier */
+#define AUDIO_PWM_CARRIER_BASE_RATE	48000
 
 struct rk_audio_pwm_dev {
 	struct device *dev;
@@ -29,6 +33,23 @@ struct rk_audio_pwm_dev {
 	struct gpio_desc *spk_ctl_gpio;
 	int interpolat_points;
 	int sample_width_bits;
+	/* noise shaper, run on the DMA buffer from the copy path */
+	unsigned int ns_order;
+	s32 ns_err[2][AUDIO_PWM_NS_ORDER_MAX];
+	unsigned int ns_width;
+};
+
+/*
+ * Error feedback coefficients, the noise transfer function is
+ * (1 - z^-1)^order: quantization noise is pushed up out of the audio band
+ * and into the PWM carrier, where the output filter removes it.
+ */
+static const s8 rockchip_audio_pwm_ns_coef[AUDIO_PWM_NS_ORDER_MAX + 1]
+					  [AUDIO_PWM_NS_ORDER_MAX] = {
+	{ 0, 0, 0 },
+	{ 1, 0, 0 },
+	{ 2, -1, 0 },
+	{ 3, -3, 1 },
 };
 
 static inline struct rk_audio_pwm_dev *to_info(struct snd_soc_dai *dai)
@@ -60,16 +81,21 @@ static int rockchip_audio_pwm_hw_params(struct snd_pcm_substream *substream,
 					struct snd_soc_dai *dai)
 {
 	struct rk_audio_pwm_dev *apwm = to_info(dai);
+	unsigned int srate = params_rate(params);
+	int points = apwm->interpolat_points;
 	unsigned long rate;
 	int ret;
 
-	rate = params_rate(params) << apwm->sample_width_bits;
-	if (apwm->interpolat_points) {
-		rate *= (apwm->interpolat_points + 1);
-		regmap_write(apwm->regmap, AUDPWM_PWM_CFG,
-			     AUDPWM_LINEAR_INTERP_EN |
-			     AUDPWM_INTERP_RATE(apwm->interpolat_points));
-	}
+	/*
+	 * Above 48k the input already carries some of the oversampling,
+	 * interpolate less so that the PWM clock stays where it is at 48k.
+	 */
+	if (srate > AUDIO_PWM_CARRIER_BASE_RATE)
+		points = max((points + 1) * AUDIO_PWM_CARRIER_BASE_RATE /
+			     (int)srate - 1, 0);
+
+	rate = (unsigned long)srate << apwm->sample_width_bits;
+	rate *= points + 1;
 	if (!rate)
 		return -EINVAL;
 	ret = clk_set_rate(apwm->clk, rate);
@@ -79,10 +105,16 @@ static int rockchip_audio_pwm_hw_params(struct snd_pcm_substream *substream,
 	regmap_write(apwm->regmap, AUDPWM_SRC_CFG,
 		     AUDPWM_SRC_WIDTH(params_width(params)));
 	regmap_write(apwm->regmap, AUDPWM_PWM_CFG,
-		     AUDPWM_SAMPLE_WIDTH(apwm->sample_width_bits));
+		     AUDPWM_SAMPLE_WIDTH(apwm->sample_width_bits) |
+		     (points ? AUDPWM_LINEAR_INTERP_EN :
+			       AUDPWM_LINEAR_INTERP_DIS) |
+		     AUDPWM_INTERP_RATE(points));
 	regmap_write(apwm->regmap, AUDPWM_FIFO_CFG,
 		     AUDPWM_DMA_WATERMARK(16));
 
+	apwm->ns_width = params_width(params);
+	memset(apwm->ns_err, 0, sizeof(apwm->ns_err));
+
 	return 0;
 }
 
@@ -113,13 +145,60 @@ static int rockchip_audio_pwm_trigger(struct snd_pcm_substream *substream,
 	return ret;
 }
 
+static int rockchip_audio_pwm_ns_get(struct snd_kcontrol *kcontrol,
+				     struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_audio_pwm_dev *apwm = to_info(dai);
+
+	ucontrol->value.integer.value[0] = apwm->ns_order;
+
+	return 0;
+}
+
+static int rockchip_audio_pwm_ns_put(struct snd_kcontrol *kcontrol,
+				     struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_audio_pwm_dev *apwm = to_info(dai);
+	unsigned int order = ucontrol->value.integer.value[0];
+
+	if (order > AUDIO_PWM_NS_ORDER_MAX)
+		return -EINVAL;
+	if (order == apwm->ns_order)
+		return 0;
+
+	apwm->ns_order = order;
+
+	return 1;
+}
+
+static int rockchip_audio_pwm_ns_info(struct snd_kcontrol *kcontrol,
+				      struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER;
+	uinfo->count = 1;
+	uinfo->value.integer.min = 0;
+	uinfo->value.integer.max = AUDIO_PWM_NS_ORDER_MAX;
+
+	return 0;
+}
+
+static struct snd_kcontrol_new rockchip_audio_pwm_ns_control = {
+	.iface = SNDRV_CTL_ELEM_IFACE_MIXER,
+	.name = "PWM Noise Shaping Order",
+	.info = rockchip_audio_pwm_ns_info,
+	.get = rockchip_audio_pwm_ns_get,
+	.put = rockchip_audio_pwm_ns_put,
+};
+
 static int rockchip_audio_pwm_dai_probe(struct snd_soc_dai *dai)
 {
 	struct rk_audio_pwm_dev *apwm = to_info(dai);
 
 	dai->playback_dma_data = &apwm->playback_dma_data;
 
-	return 0;
+	return snd_soc_add_dai_controls(dai, &rockchip_audio_pwm_ns_control, 1);
 }
 
 static const struct snd_soc_dai_ops rockchip_audio_pwm_dai_ops = {
@@ -127,7 +206,7 @@ static const struct snd_soc_dai_ops rockchip_audio_pwm_dai_ops = {
 	.hw_params = rockchip_audio_pwm_hw_params,
 };
 
-#define ROCKCHIP_AUDIO_PWM_RATES SNDRV_PCM_RATE_8000_48000
+#define ROCKCHIP_AUDIO_PWM_RATES SNDRV_PCM_RATE_8000_96000
 #define ROCKCHIP_AUDIO_PWM_FORMATS (SNDRV_PCM_FMTBIT_S16_LE | \
 				    SNDRV_PCM_FMTBIT_S24_LE | \
 				    SNDRV_PCM_FMTBIT_S32_LE)
@@ -148,6 +227,77 @@ static const struct snd_soc_component_driver rockchip_audio_pwm_component = {
 	.name = "rockchip-audio-pwm",
 };
 
+static s32 rockchip_audio_pwm_shape(struct rk_audio_pwm_dev *apwm,
+				   s32 *err, s32 x)
+{
+	const s8 *c = rockchip_audio_pwm_ns_coef[apwm->ns_order];
+	s64 step = 1LL << (apwm->ns_width - apwm->sample_width_bits);
+	s64 top = (1LL << (apwm->ns_width - 1)) - step;
+	s64 bottom = -(1LL << (apwm->ns_width - 1));
+	s64 v, q;
+
+	v = (s64)x - c[0] * err[0] - c[1] * err[1] - c[2] * err[2];
+	q = clamp_t(s64, (v + (step >> 1)) & ~(step - 1), bottom, top);
+
+	/* an error clipped to one step keeps the loop stable on overload */
+	err[2] = err[1];
+	err[1] = err[0];
+	err[0] = clamp_t(s64, q - v, -step, step);
+
+	return q;
+}
+
+/*
+ * Requantize what userspace wrote to the code width of the PWM with an error
+ * feedback noise shaper, the controller then only drops zero bits. mmap()ed
+ * buffers do not go through here and are truncated as before.
+ */
+static int rockchip_audio_pwm_process(struct snd_pcm_substream *substream,
+				      int channel, unsigned long hwoff,
+				      void *buf, unsigned long bytes)
+{
+	struct snd_soc_pcm_runtime *rtd = asoc_substream_to_rtd(substream);
+	struct rk_audio_pwm_dev *apwm =
+		snd_soc_dai_get_drvdata(asoc_rtd_to_cpu(rtd, 0));
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	unsigned int chs = runtime->channels;
+	unsigned int ext = 32 - apwm->ns_width;
+	unsigned int ch;
+	unsigned long i, n;
+
+	if (!apwm->ns_order || chs > ARRAY_SIZE(apwm->ns_err))
+		return 0;
+
+	if (apwm->ns_width == 16) {
+		s16 *s = (s16 *)(runtime->dma_area + hwoff);
+
+		n = bytes / sizeof(*s);
+		ch = (hwoff / sizeof(*s)) % chs;
+		for (i = 0; i < n; i++, ch = (ch + 1) % chs)
+			s[i] = rockchip_audio_pwm_shape(apwm, apwm->ns_err[ch],
+							s[i]);
+	} else {
+		s32 *s = (s32 *)(runtime->dma_area + hwoff);
+
+		n = bytes / sizeof(*s);
+		ch = (hwoff / sizeof(*s)) % chs;
+		/* S24_LE may come without its sign extended */
+		for (i = 0; i < n; i++, ch = (ch + 1) % chs) {
+			s32 x = (s32)((u32)s[i] << ext) >> ext;
+
+			s[i] = rockchip_audio_pwm_shape(apwm, apwm->ns_err[ch],
+							x);
+		}
+	}
+
+	return 0;
+}
+
+static const struct snd_dmaengine_pcm_config rockchip_audio_pwm_dma_config = {
+	.prepare_slave_config = snd_dmaengine_pcm_prepare_slave_config,
+	.process = rockchip_audio_pwm_process,
+};
+
 static int __maybe_unused rockchip_audio_pwm_runtime_suspend(struct device *dev)
 {
 	struct rk_audio_pwm_dev *apwm = dev_get_drvdata(dev);
@@ -304,6 +454,12 @@ static int rockchip_audio_pwm_probe(struct platform_device *pdev)
 
 	of_property_read_u32(np, "rockchip,interpolat-points",
 			     &apwm->interpolat_points);
+	apwm->interpolat_points = clamp(apwm->interpolat_points, 0, 15);
+
+	of_property_read_u32(np, "rockchip,noise-shaping-order",
+			     &apwm->ns_order);
+	apwm->ns_order = min_t(unsigned int, apwm->ns_order,
+			       AUDIO_PWM_NS_ORDER_MAX);
 
 	apwm->spk_ctl_gpio = devm_gpiod_get_optional(&pdev->dev, "spk-ctl",
 						     GPIOD_OUT_LOW);
@@ -324,7 +480,8 @@ static int rockchip_audio_pwm_probe(struct platform_device *pdev)
 		goto err_suspend;
 	}
 
-	ret = devm_snd_dmaengine_pcm_register(&pdev->dev, NULL, 0);
+	ret = devm_snd_dmaengine_pcm_register(&pdev->dev,
+					      &rockchip_audio_pwm_dma_config, 0);
 	if (ret) {
 		dev_err(&pdev->dev, "could not register pcm: %d\n", ret);
 		goto err_suspend;
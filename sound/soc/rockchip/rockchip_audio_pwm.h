@@ -38,6 +38,7 @@
 /* PWM Configuration Register */
 #define AUDPWM_SAMPLE_WIDTH(x)	HIWORD_UPDATE((x) - 8, 9, 8)
 #define AUDPWM_LINEAR_INTERP_EN HIWORD_UPDATE(1, 4, 4)
+#define AUDPWM_LINEAR_INTERP_DIS HIWORD_UPDATE(0, 4, 4)
 #define AUDPWM_INTERP_RATE(x)	HIWORD_UPDATE((x), 3, 0)
 
 /* FIFO Configuration Register */
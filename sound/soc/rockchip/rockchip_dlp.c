@@ -8,6 +8,8 @@
  */
 
 #include <linux/kref.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/init.h>
 #include <linux/dmaengine.h>
@@ -21,6 +23,22 @@
 #include <sound/dmaengine_pcm.h>
 #include "rockchip_dlp.h"
 
+#ifdef CONFIG_KERNEL_MODE_NEON
+#include <asm/neon.h>
+#include <asm/simd.h>
+
+/* rockchip_dlp_neon.c */
+int dlp_mix_s16_neon(int16_t *dst, int dst_step, const int16_t *src,
+		     int frames, int shift);
+int dlp_mix_s32_neon(int32_t *dst, int dst_step, const int32_t *src,
+		     int frames, int shift);
+
+static inline bool dlp_use_neon(int shift)
+{
+	return shift > 0 && cpu_has_neon() && may_use_simd();
+}
+#endif
+
 #ifdef DLP_DBG
 #define dlp_info(args...)		pr_info(args)
 #else
@@ -353,24 +371,60 @@ static int dlp_get_offset_size(struct dmaengine_dlp_runtime_data *prtd,
 	return ret;
 }
 
-static int dlp_mix_frame_buffer(struct dmaengine_dlp_runtime_data *prtd, void *buf)
+/*
+ * Downmix @frames contiguous frames of @prtd at @buf into one sample per
+ * frame, stored to @dst every @dst_bytes. The sum is scaled once per
+ * frame, by a shift for 2/4/8 channels where NEON takes the bulk.
+ */
+static int dlp_mix_frames(struct dmaengine_dlp_runtime_data *prtd,
+			  void *dst, int dst_bytes, const void *buf, int frames)
 {
 	int sample_bytes = dlp_channels_to_bytes(prtd, 1);
-	int16_t *p16 = (int16_t *)buf, v16 = 0;
-	int32_t *p32 = (int32_t *)buf, v32 = 0;
-	int i = 0;
+	int ch = prtd->channels;
+	int shift = is_power_of_2(ch) ? ilog2(ch) : -1;
+	int i, k, step, done = 0;
 
 	switch (sample_bytes) {
-	case 2:
-		for (i = 0; i < prtd->channels; i++)
-			v16 += (p16[i] / prtd->channels);
-		p16[0] = v16;
+	case 2: {
+		const int16_t *p16 = buf;
+		int16_t *d16 = dst;
+		int v16;
+
+		step = dst_bytes / sample_bytes;
+#ifdef CONFIG_KERNEL_MODE_NEON
+		if (dlp_use_neon(shift)) {
+			kernel_neon_begin();
+			done = dlp_mix_s16_neon(d16, step, p16, frames, shift);
+			kernel_neon_end();
+		}
+#endif
+		for (i = done; i < frames; i++) {
+			for (k = 0, v16 = 0; k < ch; k++)
+				v16 += p16[i * ch + k];
+			d16[i * step] = shift >= 0 ? v16 >> shift : v16 / ch;
+		}
 		break;
-	case 4:
-		for (i = 0; i < prtd->channels; i++)
-			v32 += (p32[i] / prtd->channels);
-		p32[0] = v32;
+	}
+	case 4: {
+		const int32_t *p32 = buf;
+		int32_t *d32 = dst;
+		s64 v32;
+
+		step = dst_bytes / sample_bytes;
+#ifdef CONFIG_KERNEL_MODE_NEON
+		if (dlp_use_neon(shift)) {
+			kernel_neon_begin();
+			done = dlp_mix_s32_neon(d32, step, p32, frames, shift);
+			kernel_neon_end();
+		}
+#endif
+		for (i = done; i < frames; i++) {
+			for (k = 0, v32 = 0; k < ch; k++)
+				v32 += p32[i * ch + k];
+			d32[i * step] = shift >= 0 ? v32 >> shift : div_s64(v32, ch);
+		}
 		break;
+	}
 	default:
 		return -EINVAL;
 	}
@@ -817,7 +871,7 @@ static int process_capture(struct snd_soc_component *component,
 	snd_pcm_uframes_t appl_ptr;
 	char *cbuf = prtd->buf, *pbuf = NULL;
 	int ofs_cap, ofs_play, size_cap, size_play;
-	int i = 0, j = 0, ret = 0;
+	int i = 0, j = 0, k, n, ret = 0;
 	bool free_ref = false, mix = false;
 
 	appl_ptr = READ_ONCE(runtime->control->appl_ptr);
@@ -907,12 +961,20 @@ static int process_capture(struct snd_soc_component *component,
 
 	dlp_info("applptr: %8lu, ofs: %8ld, frames: %lu\n", appl_ptr, ofs, frames);
 
-	for (i = 0; i < frames; i++, j++) {
+	/* in runs up to the end of the reference ring */
+	for (i = 0; i < frames; i += n, j += n) {
+		k = (i + ofs) % pref->buf_sz;
+		n = min_t(snd_pcm_sframes_t, frames - i, pref->buf_sz - k);
 		cbuf = prtd->buf + dlp_frames_to_bytes(prtd, j + frames_consumed) + ofs_cap;
-		pbuf = pref->buf + dlp_frames_to_bytes(pref, ((i + ofs) % pref->buf_sz)) + ofs_play;
-		if (mix)
-			dlp_mix_frame_buffer(pref, pbuf);
-		memcpy(cbuf, pbuf, size_cap);
+		pbuf = pref->buf + dlp_frames_to_bytes(pref, k) + ofs_play;
+		if (mix && size_cap == dlp_channels_to_bytes(pref, 1) &&
+		    !dlp_mix_frames(pref, cbuf, prtd->frame_bytes, pbuf, n))
+			continue;
+		for (k = 0; k < n; k++) {
+			memcpy(cbuf, pbuf, size_cap);
+			cbuf += prtd->frame_bytes;
+			pbuf += pref->frame_bytes;
+		}
 	}
 
 	appl_ptr += frames;
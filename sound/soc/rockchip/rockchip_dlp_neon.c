@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Rockchip DLP (Digital Loopback) NEON downmix kernels
+ *
+ * Copyright (c) 2026 Rockchip Electronics Co. Ltd.
+ *
+ * Built with NEON_FLAGS like lib/raid6/recov_neon_inner.c, so only
+ * <arm_neon.h> may be used here. The callers in rockchip_dlp.c wrap
+ * these in kernel_neon_begin()/kernel_neon_end().
+ *
+ * Every kernel mixes 2^shift interleaved channels into one sample per
+ * frame as (sum >> shift), the same arithmetic as the C fallback, writes
+ * it to dst every dst_step samples and returns the frames it consumed;
+ * the caller finishes the tail.
+ */
+
+#include <arm_neon.h>
+
+int dlp_mix_s16_neon(int16_t *dst, int dst_step, const int16_t *src,
+		     int frames, int shift);
+int dlp_mix_s32_neon(int32_t *dst, int dst_step, const int32_t *src,
+		     int frames, int shift);
+
+static inline void dlp_st_s16x4(int16_t *dst, int step, int16x4_t v)
+{
+	vst1_lane_s16(dst, v, 0);
+	vst1_lane_s16(dst + step, v, 1);
+	vst1_lane_s16(dst + step * 2, v, 2);
+	vst1_lane_s16(dst + step * 3, v, 3);
+}
+
+static inline void dlp_st_s32x2(int32_t *dst, int step, int32x2_t v)
+{
+	vst1_lane_s32(dst, v, 0);
+	vst1_lane_s32(dst + step, v, 1);
+}
+
+static inline int32x4_t dlp_sum4_s16(int16x4_t a, int16x4_t b,
+				     int16x4_t c, int16x4_t d)
+{
+	return vaddq_s32(vaddl_s16(a, b), vaddl_s16(c, d));
+}
+
+static inline int64x2_t dlp_sum4_s32(int32x2_t a, int32x2_t b,
+				     int32x2_t c, int32x2_t d)
+{
+	return vaddq_s64(vaddl_s32(a, b), vaddl_s32(c, d));
+}
+
+int dlp_mix_s16_neon(int16_t *dst, int dst_step, const int16_t *src,
+		     int frames, int shift)
+{
+	int16x8x2_t v2;
+	int16x8x4_t v4;
+	int32x4_t lo, hi;
+	int done = 0;
+
+	switch (shift) {
+	case 1:
+		for (; frames - done >= 8; done += 8, src += 16) {
+			v2 = vld2q_s16(src);
+			lo = vaddl_s16(vget_low_s16(v2.val[0]),
+				       vget_low_s16(v2.val[1]));
+			hi = vaddl_s16(vget_high_s16(v2.val[0]),
+				       vget_high_s16(v2.val[1]));
+			dlp_st_s16x4(dst, dst_step, vshrn_n_s32(lo, 1));
+			dst += dst_step * 4;
+			dlp_st_s16x4(dst, dst_step, vshrn_n_s32(hi, 1));
+			dst += dst_step * 4;
+		}
+		break;
+	case 2:
+		for (; frames - done >= 8; done += 8, src += 32) {
+			v4 = vld4q_s16(src);
+			lo = dlp_sum4_s16(vget_low_s16(v4.val[0]),
+					  vget_low_s16(v4.val[1]),
+					  vget_low_s16(v4.val[2]),
+					  vget_low_s16(v4.val[3]));
+			hi = dlp_sum4_s16(vget_high_s16(v4.val[0]),
+					  vget_high_s16(v4.val[1]),
+					  vget_high_s16(v4.val[2]),
+					  vget_high_s16(v4.val[3]));
+			dlp_st_s16x4(dst, dst_step, vshrn_n_s32(lo, 2));
+			dst += dst_step * 4;
+			dlp_st_s16x4(dst, dst_step, vshrn_n_s32(hi, 2));
+			dst += dst_step * 4;
+		}
+		break;
+	case 3:
+		/* lanes 2n and 2n + 1 hold the two halves of frame n */
+		for (; frames - done >= 4; done += 4, src += 32) {
+			v4 = vld4q_s16(src);
+			lo = dlp_sum4_s16(vget_low_s16(v4.val[0]),
+					  vget_low_s16(v4.val[1]),
+					  vget_low_s16(v4.val[2]),
+					  vget_low_s16(v4.val[3]));
+			hi = dlp_sum4_s16(vget_high_s16(v4.val[0]),
+					  vget_high_s16(v4.val[1]),
+					  vget_high_s16(v4.val[2]),
+					  vget_high_s16(v4.val[3]));
+			lo = vcombine_s32(vpadd_s32(vget_low_s32(lo),
+						    vget_high_s32(lo)),
+					  vpadd_s32(vget_low_s32(hi),
+						    vget_high_s32(hi)));
+			dlp_st_s16x4(dst, dst_step, vshrn_n_s32(lo, 3));
+			dst += dst_step * 4;
+		}
+		break;
+	default:
+		break;
+	}
+
+	return done;
+}
+
+int dlp_mix_s32_neon(int32_t *dst, int dst_step, const int32_t *src,
+		     int frames, int shift)
+{
+	int32x4x2_t v2;
+	int32x4x4_t v4;
+	int64x2_t lo, hi;
+	int done = 0;
+
+	switch (shift) {
+	case 1:
+		for (; frames - done >= 4; done += 4, src += 8) {
+			v2 = vld2q_s32(src);
+			lo = vaddl_s32(vget_low_s32(v2.val[0]),
+				       vget_low_s32(v2.val[1]));
+			hi = vaddl_s32(vget_high_s32(v2.val[0]),
+				       vget_high_s32(v2.val[1]));
+			dlp_st_s32x2(dst, dst_step, vshrn_n_s64(lo, 1));
+			dst += dst_step * 2;
+			dlp_st_s32x2(dst, dst_step, vshrn_n_s64(hi, 1));
+			dst += dst_step * 2;
+		}
+		break;
+	case 2:
+		for (; frames - done >= 4; done += 4, src += 16) {
+			v4 = vld4q_s32(src);
+			lo = dlp_sum4_s32(vget_low_s32(v4.val[0]),
+					  vget_low_s32(v4.val[1]),
+					  vget_low_s32(v4.val[2]),
+					  vget_low_s32(v4.val[3]));
+			hi = dlp_sum4_s32(vget_high_s32(v4.val[0]),
+					  vget_high_s32(v4.val[1]),
+					  vget_high_s32(v4.val[2]),
+					  vget_high_s32(v4.val[3]));
+			dlp_st_s32x2(dst, dst_step, vshrn_n_s64(lo, 2));
+			dst += dst_step * 2;
+			dlp_st_s32x2(dst, dst_step, vshrn_n_s64(hi, 2));
+			dst += dst_step * 2;
+		}
+		break;
+	case 3:
+		/* lo holds the two halves of frame 0, hi those of frame 1 */
+		for (; frames - done >= 2; done += 2, src += 16) {
+			v4 = vld4q_s32(src);
+			lo = dlp_sum4_s32(vget_low_s32(v4.val[0]),
+					  vget_low_s32(v4.val[1]),
+					  vget_low_s32(v4.val[2]),
+					  vget_low_s32(v4.val[3]));
+			hi = dlp_sum4_s32(vget_high_s32(v4.val[0]),
+					  vget_high_s32(v4.val[1]),
+					  vget_high_s32(v4.val[2]),
+					  vget_high_s32(v4.val[3]));
+			lo = vcombine_s64(vadd_s64(vget_low_s64(lo),
+						   vget_high_s64(lo)),
+					  vadd_s64(vget_low_s64(hi),
+						   vget_high_s64(hi)));
+			dlp_st_s32x2(dst, dst_step, vshrn_n_s64(lo, 3));
+			dst += dst_step * 2;
+		}
+		break;
+	default:
+		break;
+	}
+
+	return done;
+}
@@ -13,6 +13,7 @@
 #include <linux/module.h>
 #include <linux/mfd/syscon.h>
 #include <linux/delay.h>
+#include <linux/hrtimer.h>
 #include <linux/of_gpio.h>
 #include <linux/of_device.h>
 #include <linux/of_address.h>
@@ -22,9 +23,16 @@
 #include <linux/pm_runtime.h>
 #include <linux/regmap.h>
 #include <linux/reset.h>
+#include <linux/slab.h>
+#include <linux/soc/rockchip/rockchip_lp_playback.h>
+#include <linux/soc/rockchip/rockchip_pwm.h>
 #include <linux/spinlock.h>
 #include <sound/pcm_params.h>
 #include <sound/dmaengine_pcm.h>
+#include <sound/timer.h>
+#include <soc/rockchip/rockchip_cpufreq.h>
+#include <soc/rockchip/rockchip_dmc.h>
+#include <soc/rockchip/rockchip_performance.h>
 
 #include "rockchip_i2s_tdm.h"
 #include "rockchip_dlp.h"
@@ -41,10 +49,21 @@
 #define MULTIPLEX_CH_MAX			10
 #define CLK_PPM_MIN				(-1000)
 #define CLK_PPM_MAX				(1000)
+#define CLK_METER_PPM_MAX			(100000)
+#define CLK_METER_INTERVAL_MS			(1000)
 #define MAXBURST_PER_FIFO			8
+#define RESTORE_REGS_MAX			16
+#define STOP_RAMP_US_MAX			5000
+#define STOP_RAMP_TAIL_FRAMES			64
 
 #define QUIRK_ALWAYS_ON				BIT(0)
 #define QUIRK_HDMI_PATH				BIT(1)
+#define QUIRK_CPUFREQ_BOOST			BIT(2)
+/* keep DDR frequency changes this far from a playback period boundary */
+#define DMC_BLACKOUT_GUARD_US			1000
+#define LP_PLAYBACK_WAKE_MS			100
+/* one second of frames at the highest rate */
+#define SAMPLE_TIMER_TICKS_MAX			768000
 
 struct txrx_config {
 	u32 addr;
@@ -62,6 +81,19 @@ struct rk_i2s_soc_data {
 	int (*init)(struct device *dev, u32 addr);
 };
 
+/*
+ * Controllers sharing a "rockchip,link-group" id start playback together:
+ * each one arms TXS_START with its TX-M held in reset, and the last one
+ * to trigger releases all of them with one CRU write per reset bank.
+ */
+struct rk_i2s_tdm_link {
+	struct list_head node;
+	struct list_head members;
+	void __iomem *cru_reset;
+	u32 id;
+	spinlock_t lock; /* members and their link_armed */
+};
+
 struct rk_i2s_tdm_dev {
 	struct device *dev;
 	struct clk *hclk;
@@ -101,6 +133,10 @@ struct rk_i2s_tdm_dev {
 	int tx_reset_id;
 	int rx_reset_id;
 #endif
+	struct rk_i2s_tdm_link *link;
+	struct list_head link_node;
+	int link_tx_id;
+	bool link_armed;
 	bool is_master_mode;
 	bool io_multiplex;
 	bool mclk_calibrate;
@@ -117,9 +153,45 @@ struct rk_i2s_tdm_dev {
 	unsigned int i2s_sdis[CH_GRP_MAX];
 	unsigned int i2s_sdos[CH_GRP_MAX];
 	unsigned int quirks;
+	unsigned int stop_ramp_us;
 	int clk_ppm;
 	atomic_t refcount;
 	spinlock_t lock; /* xfer lock */
+	struct snd_dmaengine_pcm_config pcm_config;
+	struct dmcfreq_audio_req dmc_req[SNDRV_PCM_STREAM_LAST + 1];
+	struct rockchip_perf_audio perf[SNDRV_PCM_STREAM_LAST + 1];
+	struct cpufreq_audio_req cpufreq_req;
+	struct delayed_work fill_work;
+	struct dmcfreq_blackout dmc_blackout;
+	/* slave mode: PWM capturing the external frame clock, and its drift */
+	struct pwm_device *clk_meter;
+	struct delayed_work clk_meter_work;
+	unsigned int clk_meter_rate;
+	int ext_clk_ppm;
+	/*
+	 * Non-volatile registers and their reset values, what a runtime
+	 * resume has to put back when the power domain lost the context.
+	 */
+	struct reg_default restore[RESTORE_REGS_MAX];
+	int num_restore;
+	bool regs_retained;
+	/* playback left to the hpmcu over system suspend */
+	bool lp_playback;
+	bool lp_playback_armed;
+	unsigned int lp_playback_wake_ms;
+	/* ALSA timer counting the frames the DMA moves */
+	bool sample_timer;
+	struct snd_timer *timer;
+	struct hrtimer timer_hrt;
+	bool timer_in_callback;
+	spinlock_t timer_lock; /* timer_substream and the frame count */
+	struct snd_pcm_substream *timer_substream;
+	snd_pcm_uframes_t timer_hw;
+	unsigned int timer_rate;
+	ktime_t timer_stamp;
+	u64 timer_frames;
+	u64 timer_base;
+	u64 timer_target;
 };
 
 static struct i2s_of_quirks {
@@ -134,6 +206,10 @@ static struct i2s_of_quirks {
 		.quirk = "rockchip,hdmi-path",
 		.id = QUIRK_HDMI_PATH,
 	},
+	{
+		.quirk = "rockchip,cpufreq-boost",
+		.id = QUIRK_CPUFREQ_BOOST,
+	},
 };
 
 static int to_ch_num(unsigned int val)
@@ -162,7 +238,9 @@ static int i2s_tdm_runtime_suspend(struct device *dev)
 {
 	struct rk_i2s_tdm_dev *i2s_tdm = dev_get_drvdata(dev);
 
-	regcache_cache_only(i2s_tdm->regmap, true);
+	/* hclk stays on, without a power domain the registers keep going */
+	if (!i2s_tdm->regs_retained)
+		regcache_cache_only(i2s_tdm->regmap, true);
 
 	clk_disable_unprepare(i2s_tdm->mclk_tx);
 	clk_disable_unprepare(i2s_tdm->mclk_rx);
@@ -170,11 +248,45 @@ static int i2s_tdm_runtime_suspend(struct device *dev)
 	return 0;
 }
 
+/*
+ * Only rewrite what differs from the reset value, instead of a dirty
+ * regcache_sync() walking the whole map on every resume.
+ */
+static int i2s_tdm_restore_regs(struct rk_i2s_tdm_dev *i2s_tdm)
+{
+	unsigned int val;
+	int i, ret;
+
+	regcache_cache_only(i2s_tdm->regmap, false);
+
+	for (i = 0; i < i2s_tdm->num_restore; i++) {
+		regmap_read(i2s_tdm->regmap, i2s_tdm->restore[i].reg, &val);
+		if (val == i2s_tdm->restore[i].def)
+			continue;
+
+		ret = regmap_write(i2s_tdm->regmap, i2s_tdm->restore[i].reg, val);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
 static int i2s_tdm_runtime_resume(struct device *dev)
 {
 	struct rk_i2s_tdm_dev *i2s_tdm = dev_get_drvdata(dev);
 	int ret;
 
+	/*
+	 * The registers are on hclk, restore them first with the
+	 * controller idle and only then ungate mclk.
+	 */
+	if (!i2s_tdm->regs_retained) {
+		ret = i2s_tdm_restore_regs(i2s_tdm);
+		if (ret)
+			goto err_mclk_tx;
+	}
+
 	ret = clk_prepare_enable(i2s_tdm->mclk_tx);
 	if (ret)
 		goto err_mclk_tx;
@@ -183,22 +295,19 @@ static int i2s_tdm_runtime_resume(struct device *dev)
 	if (ret)
 		goto err_mclk_rx;
 
-	regcache_cache_only(i2s_tdm->regmap, false);
-	regcache_mark_dirty(i2s_tdm->regmap);
-	ret = regcache_sync(i2s_tdm->regmap);
-	if (ret)
-		goto err_regmap;
-
 	return 0;
 
-err_regmap:
-	clk_disable_unprepare(i2s_tdm->mclk_rx);
 err_mclk_rx:
 	clk_disable_unprepare(i2s_tdm->mclk_tx);
 err_mclk_tx:
+	if (!i2s_tdm->regs_retained)
+		regcache_cache_only(i2s_tdm->regmap, true);
 	return ret;
 }
 
+static LIST_HEAD(rockchip_i2s_tdm_links);
+static DEFINE_MUTEX(rockchip_i2s_tdm_links_lock);
+
 static inline struct rk_i2s_tdm_dev *to_info(struct snd_soc_dai *dai)
 {
 	return snd_soc_dai_get_drvdata(dai);
@@ -596,6 +705,92 @@ static void rockchip_i2s_tdm_trcm_resume(struct snd_pcm_substream *substream,
 	rockchip_i2s_tdm_xfer_start(i2s_tdm, bstream);
 }
 
+static bool rockchip_i2s_tdm_link_waiting(struct rk_i2s_tdm_dev *i2s_tdm)
+{
+	return i2s_tdm->substreams[SNDRV_PCM_STREAM_PLAYBACK] &&
+	       !i2s_tdm->link_armed &&
+	       !is_stream_active(i2s_tdm, SNDRV_PCM_STREAM_PLAYBACK);
+}
+
+/* Called with link->lock held */
+static void rockchip_i2s_tdm_link_release(struct rk_i2s_tdm_link *link)
+{
+	struct rk_i2s_tdm_dev *m, *n;
+	int bank;
+	u32 val;
+
+	list_for_each_entry(m, &link->members, link_node)
+		if (rockchip_i2s_tdm_link_waiting(m))
+			return;
+
+	list_for_each_entry(m, &link->members, link_node) {
+		if (!m->link_armed)
+			continue;
+
+		bank = m->link_tx_id / 16;
+		val = 0;
+		list_for_each_entry(n, &link->members, link_node) {
+			if (n->link_armed && n->link_tx_id / 16 == bank) {
+				val |= BIT(n->link_tx_id % 16) << 16;
+				n->link_armed = false;
+			}
+		}
+		writel(val, link->cru_reset + bank * 4);
+	}
+}
+
+static void rockchip_i2s_tdm_link_start(struct rk_i2s_tdm_dev *i2s_tdm)
+{
+	struct rk_i2s_tdm_link *link = i2s_tdm->link;
+	int bank = i2s_tdm->link_tx_id / 16;
+	u32 bit = BIT(i2s_tdm->link_tx_id % 16);
+	unsigned long flags;
+
+	spin_lock_irqsave(&link->lock, flags);
+	writel(bit | (bit << 16), link->cru_reset + bank * 4);
+	/* delay for reset assert done */
+	udelay(10);
+	regmap_update_bits(i2s_tdm->regmap, I2S_XFER,
+			   I2S_XFER_TXS_MASK, I2S_XFER_TXS_START);
+	i2s_tdm->link_armed = true;
+	rockchip_i2s_tdm_link_release(link);
+	spin_unlock_irqrestore(&link->lock, flags);
+}
+
+static void rockchip_i2s_tdm_link_stop(struct rk_i2s_tdm_dev *i2s_tdm)
+{
+	struct rk_i2s_tdm_link *link = i2s_tdm->link;
+	int bank = i2s_tdm->link_tx_id / 16;
+	unsigned long flags;
+
+	spin_lock_irqsave(&link->lock, flags);
+	if (i2s_tdm->link_armed) {
+		writel(BIT(i2s_tdm->link_tx_id % 16) << 16,
+		       link->cru_reset + bank * 4);
+		i2s_tdm->link_armed = false;
+	}
+	spin_unlock_irqrestore(&link->lock, flags);
+}
+
+/* A member closing must not keep the others waiting for it */
+static void rockchip_i2s_tdm_link_close(struct rk_i2s_tdm_dev *i2s_tdm)
+{
+	struct rk_i2s_tdm_link *link = i2s_tdm->link;
+	unsigned long flags;
+
+	spin_lock_irqsave(&link->lock, flags);
+	i2s_tdm->substreams[SNDRV_PCM_STREAM_PLAYBACK] = NULL;
+	rockchip_i2s_tdm_link_release(link);
+	spin_unlock_irqrestore(&link->lock, flags);
+}
+
+static inline bool rockchip_i2s_tdm_linked(struct rk_i2s_tdm_dev *i2s_tdm,
+					   int stream)
+{
+	return i2s_tdm->link && i2s_tdm->is_master_mode &&
+	       stream == SNDRV_PCM_STREAM_PLAYBACK;
+}
+
 static void rockchip_i2s_tdm_start(struct rk_i2s_tdm_dev *i2s_tdm, int stream)
 {
 	/*
@@ -613,6 +808,8 @@ static void rockchip_i2s_tdm_start(struct rk_i2s_tdm_dev *i2s_tdm, int stream)
 
 	if (i2s_tdm->clk_trcm)
 		rockchip_i2s_tdm_xfer_trcm_start(i2s_tdm);
+	else if (rockchip_i2s_tdm_linked(i2s_tdm, stream))
+		rockchip_i2s_tdm_link_start(i2s_tdm);
 	else
 		rockchip_i2s_tdm_xfer_start(i2s_tdm, stream);
 }
@@ -621,6 +818,9 @@ static void rockchip_i2s_tdm_stop(struct rk_i2s_tdm_dev *i2s_tdm, int stream)
 {
 	rockchip_i2s_tdm_dma_ctrl(i2s_tdm, stream, 0);
 
+	if (rockchip_i2s_tdm_linked(i2s_tdm, stream))
+		rockchip_i2s_tdm_link_stop(i2s_tdm);
+
 	if (i2s_tdm->clk_trcm)
 		rockchip_i2s_tdm_xfer_trcm_stop(i2s_tdm);
 	else
@@ -1084,27 +1284,27 @@ static int rockchip_i2s_tdm_params_trcm(struct snd_pcm_substream *substream,
 					unsigned int fmt)
 {
 	struct rk_i2s_tdm_dev *i2s_tdm = to_info(dai);
+	bool playback = substream->stream == SNDRV_PCM_STREAM_PLAYBACK;
+	const struct reg_update updates[] = {
+		REG_UPDATE(I2S_CLKDIV,
+			   I2S_CLKDIV_TXM_MASK | I2S_CLKDIV_RXM_MASK,
+			   I2S_CLKDIV_TXM(div_bclk) | I2S_CLKDIV_RXM(div_bclk)),
+		REG_UPDATE(I2S_CKR,
+			   I2S_CKR_TSD_MASK | I2S_CKR_RSD_MASK,
+			   I2S_CKR_TSD(div_lrck) | I2S_CKR_RSD(div_lrck)),
+		REG_UPDATE(playback ? I2S_TXCR : I2S_RXCR,
+			   playback ? I2S_TXCR_VDW_MASK | I2S_TXCR_CSR_MASK :
+				      I2S_RXCR_VDW_MASK | I2S_RXCR_CSR_MASK,
+			   fmt),
+	};
 	unsigned long flags;
 
 	spin_lock_irqsave(&i2s_tdm->lock, flags);
 	if (atomic_read(&i2s_tdm->refcount))
 		rockchip_i2s_tdm_trcm_pause(substream, i2s_tdm);
 
-	regmap_update_bits(i2s_tdm->regmap, I2S_CLKDIV,
-			   I2S_CLKDIV_TXM_MASK | I2S_CLKDIV_RXM_MASK,
-			   I2S_CLKDIV_TXM(div_bclk) | I2S_CLKDIV_RXM(div_bclk));
-	regmap_update_bits(i2s_tdm->regmap, I2S_CKR,
-			   I2S_CKR_TSD_MASK | I2S_CKR_RSD_MASK,
-			   I2S_CKR_TSD(div_lrck) | I2S_CKR_RSD(div_lrck));
-
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
-		regmap_update_bits(i2s_tdm->regmap, I2S_TXCR,
-				   I2S_TXCR_VDW_MASK | I2S_TXCR_CSR_MASK,
-				   fmt);
-	else
-		regmap_update_bits(i2s_tdm->regmap, I2S_RXCR,
-				   I2S_RXCR_VDW_MASK | I2S_RXCR_CSR_MASK,
-				   fmt);
+	regmap_multi_reg_update_bits(i2s_tdm->regmap, updates,
+				     ARRAY_SIZE(updates), NULL);
 
 	if (atomic_read(&i2s_tdm->refcount))
 		rockchip_i2s_tdm_trcm_resume(substream, i2s_tdm);
@@ -1121,31 +1321,28 @@ static int rockchip_i2s_tdm_params(struct snd_pcm_substream *substream,
 {
 	struct rk_i2s_tdm_dev *i2s_tdm = to_info(dai);
 	int stream = substream->stream;
+	const struct reg_update tx_updates[] = {
+		REG_UPDATE(I2S_CLKDIV, I2S_CLKDIV_TXM_MASK,
+			   I2S_CLKDIV_TXM(div_bclk)),
+		REG_UPDATE(I2S_CKR, I2S_CKR_TSD_MASK, I2S_CKR_TSD(div_lrck)),
+		REG_UPDATE(I2S_TXCR, I2S_TXCR_VDW_MASK | I2S_TXCR_CSR_MASK, fmt),
+	};
+	const struct reg_update rx_updates[] = {
+		REG_UPDATE(I2S_CLKDIV, I2S_CLKDIV_RXM_MASK,
+			   I2S_CLKDIV_RXM(div_bclk)),
+		REG_UPDATE(I2S_CKR, I2S_CKR_RSD_MASK, I2S_CKR_RSD(div_lrck)),
+		REG_UPDATE(I2S_RXCR, I2S_RXCR_VDW_MASK | I2S_RXCR_CSR_MASK, fmt),
+	};
 
 	if (is_stream_active(i2s_tdm, stream))
 		rockchip_i2s_tdm_xfer_stop(i2s_tdm, stream, true);
 
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
-		regmap_update_bits(i2s_tdm->regmap, I2S_CLKDIV,
-				   I2S_CLKDIV_TXM_MASK,
-				   I2S_CLKDIV_TXM(div_bclk));
-		regmap_update_bits(i2s_tdm->regmap, I2S_CKR,
-				   I2S_CKR_TSD_MASK,
-				   I2S_CKR_TSD(div_lrck));
-		regmap_update_bits(i2s_tdm->regmap, I2S_TXCR,
-				   I2S_TXCR_VDW_MASK | I2S_TXCR_CSR_MASK,
-				   fmt);
-	} else {
-		regmap_update_bits(i2s_tdm->regmap, I2S_CLKDIV,
-				   I2S_CLKDIV_RXM_MASK,
-				   I2S_CLKDIV_RXM(div_bclk));
-		regmap_update_bits(i2s_tdm->regmap, I2S_CKR,
-				   I2S_CKR_RSD_MASK,
-				   I2S_CKR_RSD(div_lrck));
-		regmap_update_bits(i2s_tdm->regmap, I2S_RXCR,
-				   I2S_RXCR_VDW_MASK | I2S_RXCR_CSR_MASK,
-				   fmt);
-	}
+	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+		regmap_multi_reg_update_bits(i2s_tdm->regmap, tx_updates,
+					     ARRAY_SIZE(tx_updates), NULL);
+	else
+		regmap_multi_reg_update_bits(i2s_tdm->regmap, rx_updates,
+					     ARRAY_SIZE(rx_updates), NULL);
 
 	/*
 	 * Bring back CLK ASAP after cfg changed to make SINK devices active
@@ -1232,6 +1429,15 @@ static int rockchip_i2s_tdm_hw_params(struct snd_pcm_substream *substream,
 	dma_data = snd_soc_dai_get_dma_data(dai, substream);
 	dma_data->maxburst = MAXBURST_PER_FIFO * params_channels(params) / 2;
 
+	/* the thread setting up the stream is the one feeding it */
+	rockchip_perf_audio_get(&i2s_tdm->perf[substream->stream], current);
+
+	rockchip_dmcfreq_audio_bandwidth_update(&i2s_tdm->dmc_req[substream->stream],
+						DIV_ROUND_UP(params_rate(params) *
+							     params_channels(params) *
+							     params_physical_width(params) / 8,
+							     1000));
+
 	if (i2s_tdm->is_master_mode) {
 		if (i2s_tdm->mclk_calibrate)
 			rockchip_i2s_tdm_calibrate_mclk(i2s_tdm, substream,
@@ -1266,6 +1472,10 @@ static int rockchip_i2s_tdm_hw_params(struct snd_pcm_substream *substream,
 		}
 		div_bclk = DIV_ROUND_CLOSEST(mclk_rate, bclk_rate);
 		div_lrck = bclk_rate / params_rate(params);
+	} else if (i2s_tdm->clk_meter) {
+		WRITE_ONCE(i2s_tdm->clk_meter_rate, params_rate(params));
+		mod_delayed_work(system_power_efficient_wq,
+				 &i2s_tdm->clk_meter_work, 0);
 	}
 
 	switch (params_format(params)) {
@@ -1309,22 +1519,149 @@ static int rockchip_i2s_tdm_hw_params(struct snd_pcm_substream *substream,
 	return ret;
 }
 
+/*
+ * Sample the playback buffer fill once a period for the cpufreq floor,
+ * the stream lock orders us after the trigger and its state change.
+ */
+static void rockchip_i2s_tdm_fill_work(struct work_struct *work)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = container_of(to_delayed_work(work),
+						      struct rk_i2s_tdm_dev,
+						      fill_work);
+	struct snd_pcm_substream *substream;
+	struct snd_pcm_runtime *runtime;
+	snd_pcm_uframes_t avail = 0;
+	unsigned long flags, delay;
+	bool running;
+
+	substream = i2s_tdm->substreams[SNDRV_PCM_STREAM_PLAYBACK];
+	if (!substream)
+		return;
+
+	runtime = substream->runtime;
+	snd_pcm_stream_lock_irqsave(substream, flags);
+	running = runtime->status->state == SNDRV_PCM_STATE_RUNNING;
+	if (running)
+		avail = snd_pcm_playback_hw_avail(runtime);
+	snd_pcm_stream_unlock_irqrestore(substream, flags);
+
+	if (!running) {
+		rockchip_cpufreq_audio_fill_update(&i2s_tdm->cpufreq_req, -1);
+		return;
+	}
+
+	rockchip_cpufreq_audio_fill_update(&i2s_tdm->cpufreq_req,
+					   avail * 100 / runtime->buffer_size);
+
+	delay = max(1UL, (unsigned long)runtime->period_size * HZ /
+			 runtime->rate);
+	schedule_delayed_work(&i2s_tdm->fill_work, delay);
+}
+
+static void rockchip_i2s_tdm_scale_frame(struct snd_pcm_runtime *runtime,
+					 snd_pcm_uframes_t pos, unsigned int gain)
+{
+	void *frame = runtime->dma_area + frames_to_bytes(runtime, pos);
+	s16 *s16p = frame;
+	s32 *s32p = frame;
+	unsigned int c;
+
+	for (c = 0; c < runtime->channels; c++) {
+		switch (runtime->format) {
+		case SNDRV_PCM_FORMAT_S16_LE:
+			s16p[c] = (s32)s16p[c] * gain >> 15;
+			break;
+		case SNDRV_PCM_FORMAT_S24_LE:
+			/* sign-extend from bit 23 first */
+			s32p[c] = (s64)(s32)((u32)s32p[c] << 8) * gain >> 23;
+			break;
+		default:
+			s32p[c] = (s64)s32p[c] * gain >> 15;
+			break;
+		}
+	}
+}
+
+/*
+ * Soft stop: fade out the frames the DMA has not fetched yet, zero a
+ * short tail behind them and let the DMA play that out before TX stops,
+ * so a stop or pause lands on silence instead of cutting the waveform.
+ * This runs from the trigger and busy waits, keep stop_ramp_us short.
+ */
+static void rockchip_i2s_tdm_stop_ramp(struct rk_i2s_tdm_dev *i2s_tdm,
+				       struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	snd_pcm_uframes_t size = runtime->buffer_size;
+	snd_pcm_uframes_t hw, ramp, end, i;
+	ktime_t timeout;
+
+	if (!i2s_tdm->stop_ramp_us || !runtime->dma_area ||
+	    !is_stream_active(i2s_tdm, SNDRV_PCM_STREAM_PLAYBACK))
+		return;
+
+	switch (runtime->format) {
+	case SNDRV_PCM_FORMAT_S16_LE:
+	case SNDRV_PCM_FORMAT_S24_LE:
+	case SNDRV_PCM_FORMAT_S32_LE:
+		break;
+	default:
+		return;
+	}
+
+	ramp = DIV_ROUND_UP_ULL((u64)runtime->rate * i2s_tdm->stop_ramp_us,
+				USEC_PER_SEC);
+	/* skip what may already be in flight to the FIFO */
+	end = MAXBURST_PER_FIFO + ramp + STOP_RAMP_TAIL_FRAMES;
+	if (end >= size)
+		return;
+
+	hw = substream->ops->pointer(substream);
+	for (i = MAXBURST_PER_FIFO; i < end; i++)
+		rockchip_i2s_tdm_scale_frame(runtime, (hw + i) % size,
+					     i - MAXBURST_PER_FIFO < ramp ?
+					     (ramp - i + MAXBURST_PER_FIFO) *
+					     32768 / ramp : 0);
+	/* get the samples out before the DMA reaches them */
+	wmb();
+
+	/* wait until the FIFO holds the zeroed tail */
+	end -= STOP_RAMP_TAIL_FRAMES / 2;
+	timeout = ktime_add_us(ktime_get(), i2s_tdm->stop_ramp_us * 2 + 1000);
+	while ((substream->ops->pointer(substream) + size - hw) % size < end &&
+	       ktime_before(ktime_get(), timeout))
+		udelay(10);
+}
+
 static int rockchip_i2s_tdm_trigger(struct snd_pcm_substream *substream,
 				    int cmd, struct snd_soc_dai *dai)
 {
 	struct rk_i2s_tdm_dev *i2s_tdm = to_info(dai);
 	int ret = 0;
 
+	if ((i2s_tdm->quirks & QUIRK_CPUFREQ_BOOST) &&
+	    substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+		mod_delayed_work(system_wq, &i2s_tdm->fill_work, 0);
+
 	switch (cmd) {
 	case SNDRV_PCM_TRIGGER_START:
 	case SNDRV_PCM_TRIGGER_RESUME:
 	case SNDRV_PCM_TRIGGER_PAUSE_RELEASE:
 		rockchip_i2s_tdm_start(i2s_tdm, substream->stream);
+		rockchip_perf_audio_set_running(&i2s_tdm->perf[substream->stream],
+						true);
+		rockchip_i2s_tdm_timer_attach(i2s_tdm, substream);
 		break;
 	case SNDRV_PCM_TRIGGER_SUSPEND:
 	case SNDRV_PCM_TRIGGER_STOP:
 	case SNDRV_PCM_TRIGGER_PAUSE_PUSH:
+		if (cmd != SNDRV_PCM_TRIGGER_SUSPEND &&
+		    substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+			rockchip_i2s_tdm_stop_ramp(i2s_tdm, substream);
+		rockchip_i2s_tdm_timer_detach(i2s_tdm, substream);
 		rockchip_i2s_tdm_stop(i2s_tdm, substream->stream);
+		rockchip_perf_audio_set_running(&i2s_tdm->perf[substream->stream],
+						false);
 		break;
 	default:
 		ret = -EINVAL;
@@ -1414,6 +1751,67 @@ static struct snd_kcontrol_new rockchip_i2s_tdm_compensation_control = {
 	.put = rockchip_i2s_tdm_clk_compensation_put,
 };
 
+/*
+ * In slave mode, measure the frame clock the master drives us with against
+ * the nominal rate, so a servo can follow its drift without counting samples.
+ */
+static void rockchip_i2s_tdm_clk_meter_work(struct work_struct *work)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = container_of(to_delayed_work(work),
+						      struct rk_i2s_tdm_dev,
+						      clk_meter_work);
+	unsigned int rate = READ_ONCE(i2s_tdm->clk_meter_rate);
+	u64 freq_mhz;
+	s64 delta;
+
+	if (!rate)
+		return;
+
+	/* average over 100ms worth of frames */
+	if (!rockchip_pwm_measure_freq(i2s_tdm->clk_meter, rate / 10,
+				       &freq_mhz, 200)) {
+		delta = (s64)freq_mhz - (s64)rate * 1000;
+		delta = div_s64(delta * 1000000, rate * 1000);
+		WRITE_ONCE(i2s_tdm->ext_clk_ppm,
+			   clamp_t(s64, delta, -CLK_METER_PPM_MAX,
+				   CLK_METER_PPM_MAX));
+	}
+
+	queue_delayed_work(system_power_efficient_wq, &i2s_tdm->clk_meter_work,
+			   msecs_to_jiffies(CLK_METER_INTERVAL_MS));
+}
+
+static int rockchip_i2s_tdm_ext_clk_ppm_info(struct snd_kcontrol *kcontrol,
+					     struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER;
+	uinfo->count = 1;
+	uinfo->value.integer.min = -CLK_METER_PPM_MAX;
+	uinfo->value.integer.max = CLK_METER_PPM_MAX;
+	uinfo->value.integer.step = 1;
+
+	return 0;
+}
+
+static int rockchip_i2s_tdm_ext_clk_ppm_get(struct snd_kcontrol *kcontrol,
+					    struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_dai_get_drvdata(dai);
+
+	ucontrol->value.integer.value[0] = READ_ONCE(i2s_tdm->ext_clk_ppm);
+
+	return 0;
+}
+
+static struct snd_kcontrol_new rockchip_i2s_tdm_ext_clk_ppm_control = {
+	.iface = SNDRV_CTL_ELEM_IFACE_PCM,
+	.name = "PCM External Clk Drift In PPM",
+	.access = SNDRV_CTL_ELEM_ACCESS_READ | SNDRV_CTL_ELEM_ACCESS_VOLATILE,
+	.info = rockchip_i2s_tdm_ext_clk_ppm_info,
+	.get = rockchip_i2s_tdm_ext_clk_ppm_get,
+};
+
 /* loopback mode select */
 enum {
 	LOOPBACK_MODE_DIS = 0,
@@ -1511,6 +1909,12 @@ static int rockchip_i2s_tdm_dai_probe(struct snd_soc_dai *dai)
 	if (i2s_tdm->mclk_calibrate)
 		snd_soc_add_dai_controls(dai, &rockchip_i2s_tdm_compensation_control, 1);
 
+	if (i2s_tdm->clk_meter)
+		snd_soc_add_dai_controls(dai, &rockchip_i2s_tdm_ext_clk_ppm_control, 1);
+
+	if (i2s_tdm->sample_timer && rockchip_i2s_tdm_timer_new(i2s_tdm, dai))
+		dev_warn(i2s_tdm->dev, "failed to create the sample clock timer\n");
+
 	return 0;
 }
 
@@ -1536,6 +1940,278 @@ static int rockchip_dai_tdm_slot(struct snd_soc_dai *dai,
 	return 0;
 }
 
+/*
+ * The DMA switches to the next period descriptor and raises its interrupt
+ * at a period boundary, a DDR stall around then is the one most likely to
+ * underrun the FIFO. Ask the dmc to wait until the boundary is past.
+ */
+static unsigned int rockchip_i2s_tdm_dmc_safe_in_us(struct dmcfreq_blackout *b)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = container_of(b, struct rk_i2s_tdm_dev,
+						      dmc_blackout);
+	struct snd_pcm_substream *substream;
+	struct snd_pcm_runtime *runtime;
+	unsigned int period_us, pos_us;
+	snd_pcm_uframes_t pos = 0;
+	unsigned long flags;
+	bool running;
+
+	substream = i2s_tdm->substreams[SNDRV_PCM_STREAM_PLAYBACK];
+	if (!substream)
+		return 0;
+
+	runtime = substream->runtime;
+	snd_pcm_stream_lock_irqsave(substream, flags);
+	running = runtime->status->state == SNDRV_PCM_STATE_RUNNING;
+	if (running && substream->ops->pointer)
+		pos = substream->ops->pointer(substream);
+	snd_pcm_stream_unlock_irqrestore(substream, flags);
+
+	if (!running || !runtime->rate || !runtime->period_size)
+		return 0;
+
+	period_us = div_u64((u64)runtime->period_size * USEC_PER_SEC,
+			    runtime->rate);
+	if (period_us <= 2 * DMC_BLACKOUT_GUARD_US)
+		return 0;
+
+	pos_us = div_u64((u64)(pos % runtime->period_size) * USEC_PER_SEC,
+			 runtime->rate);
+	if (pos_us < DMC_BLACKOUT_GUARD_US)
+		return DMC_BLACKOUT_GUARD_US - pos_us;
+	if (pos_us > period_us - DMC_BLACKOUT_GUARD_US)
+		return period_us - pos_us + DMC_BLACKOUT_GUARD_US;
+
+	return 0;
+}
+
+/*
+ * Sample clock timer: one tick is one frame of the stream the timer
+ * follows, counted from the DMA position, so events scheduled on it stay
+ * locked to the audio clock instead of drifting against CLOCK_MONOTONIC.
+ * The hrtimer only decides when to look at the position again. While no
+ * stream runs the count goes on at the last rate by the system clock.
+ */
+static u64 rockchip_i2s_tdm_timer_update(struct rk_i2s_tdm_dev *i2s_tdm)
+{
+	struct snd_pcm_substream *substream;
+	snd_pcm_uframes_t pos, size;
+	unsigned long flags;
+	ktime_t now;
+	u64 frames;
+
+	spin_lock_irqsave(&i2s_tdm->timer_lock, flags);
+	substream = i2s_tdm->timer_substream;
+	if (substream) {
+		size = substream->runtime->buffer_size;
+		pos = substream->ops->pointer(substream);
+		i2s_tdm->timer_frames += (pos + size - i2s_tdm->timer_hw) % size;
+		i2s_tdm->timer_hw = pos;
+	} else {
+		now = ktime_get();
+		frames = div_u64(ktime_to_ns(ktime_sub(now, i2s_tdm->timer_stamp)) *
+				 i2s_tdm->timer_rate, NSEC_PER_SEC);
+		i2s_tdm->timer_frames += frames;
+		/* keep the remainder for the next update */
+		i2s_tdm->timer_stamp = ktime_add_ns(i2s_tdm->timer_stamp,
+						    div_u64(frames * NSEC_PER_SEC,
+							    i2s_tdm->timer_rate));
+	}
+	frames = i2s_tdm->timer_frames;
+	spin_unlock_irqrestore(&i2s_tdm->timer_lock, flags);
+
+	return frames;
+}
+
+/* how long until timer_target, never more than half the DMA buffer */
+static ktime_t rockchip_i2s_tdm_timer_wait(struct rk_i2s_tdm_dev *i2s_tdm,
+					   u64 now)
+{
+	struct snd_pcm_substream *substream;
+	u64 frames = i2s_tdm->timer_target - now;
+	unsigned long flags;
+
+	spin_lock_irqsave(&i2s_tdm->timer_lock, flags);
+	substream = i2s_tdm->timer_substream;
+	if (substream)
+		frames = min_t(u64, frames,
+			       max(1UL, substream->runtime->buffer_size / 2));
+	spin_unlock_irqrestore(&i2s_tdm->timer_lock, flags);
+
+	return ns_to_ktime(div_u64(frames * NSEC_PER_SEC, i2s_tdm->timer_rate));
+}
+
+static void rockchip_i2s_tdm_timer_attach(struct rk_i2s_tdm_dev *i2s_tdm,
+					  struct snd_pcm_substream *substream)
+{
+	unsigned long flags;
+
+	if (!i2s_tdm->timer)
+		return;
+
+	rockchip_i2s_tdm_timer_update(i2s_tdm);
+	spin_lock_irqsave(&i2s_tdm->timer_lock, flags);
+	if (!i2s_tdm->timer_substream && substream->runtime->rate) {
+		i2s_tdm->timer_substream = substream;
+		i2s_tdm->timer_hw = substream->ops->pointer(substream);
+		i2s_tdm->timer_rate = substream->runtime->rate;
+	}
+	spin_unlock_irqrestore(&i2s_tdm->timer_lock, flags);
+}
+
+static void rockchip_i2s_tdm_timer_detach(struct rk_i2s_tdm_dev *i2s_tdm,
+					  struct snd_pcm_substream *substream)
+{
+	unsigned long flags;
+
+	if (!i2s_tdm->timer || i2s_tdm->timer_substream != substream)
+		return;
+
+	rockchip_i2s_tdm_timer_update(i2s_tdm);
+	spin_lock_irqsave(&i2s_tdm->timer_lock, flags);
+	if (i2s_tdm->timer_substream == substream) {
+		i2s_tdm->timer_substream = NULL;
+		i2s_tdm->timer_stamp = ktime_get();
+	}
+	spin_unlock_irqrestore(&i2s_tdm->timer_lock, flags);
+}
+
+static enum hrtimer_restart rockchip_i2s_tdm_timer_fn(struct hrtimer *hrt)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = container_of(hrt, struct rk_i2s_tdm_dev,
+						      timer_hrt);
+	struct snd_timer *t = i2s_tdm->timer;
+	enum hrtimer_restart ret = HRTIMER_NORESTART;
+	u64 now, ticks = 0;
+
+	spin_lock(&t->lock);
+	if (!t->running)
+		goto out;
+	i2s_tdm->timer_in_callback = true;
+	spin_unlock(&t->lock);
+
+	now = rockchip_i2s_tdm_timer_update(i2s_tdm);
+	if (now >= i2s_tdm->timer_target) {
+		ticks = now - i2s_tdm->timer_base;
+		i2s_tdm->timer_base = now;
+		snd_timer_interrupt(t, ticks);
+	}
+
+	spin_lock(&t->lock);
+	if (t->running) {
+		if (ticks)
+			i2s_tdm->timer_target = i2s_tdm->timer_base + t->sticks;
+		hrtimer_forward_now(hrt, rockchip_i2s_tdm_timer_wait(i2s_tdm, now));
+		ret = HRTIMER_RESTART;
+	}
+	i2s_tdm->timer_in_callback = false;
+out:
+	spin_unlock(&t->lock);
+	return ret;
+}
+
+static int rockchip_i2s_tdm_timer_start(struct snd_timer *t)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_timer_chip(t);
+	u64 now;
+
+	if (i2s_tdm->timer_in_callback)
+		return 0;
+
+	now = rockchip_i2s_tdm_timer_update(i2s_tdm);
+	i2s_tdm->timer_base = now;
+	i2s_tdm->timer_target = now + t->sticks;
+	hrtimer_start(&i2s_tdm->timer_hrt,
+		      rockchip_i2s_tdm_timer_wait(i2s_tdm, now),
+		      HRTIMER_MODE_REL);
+
+	return 0;
+}
+
+static int rockchip_i2s_tdm_timer_stop(struct snd_timer *t)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_timer_chip(t);
+
+	if (i2s_tdm->timer_in_callback)
+		return 0;
+
+	hrtimer_try_to_cancel(&i2s_tdm->timer_hrt);
+
+	return 0;
+}
+
+static int rockchip_i2s_tdm_timer_close(struct snd_timer *t)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_timer_chip(t);
+
+	spin_lock_irq(&t->lock);
+	t->running = 0;
+	i2s_tdm->timer_in_callback = true; /* skip start/stop */
+	spin_unlock_irq(&t->lock);
+
+	hrtimer_cancel(&i2s_tdm->timer_hrt);
+	i2s_tdm->timer_in_callback = false;
+
+	return 0;
+}
+
+static unsigned long rockchip_i2s_tdm_timer_resolution(struct snd_timer *t)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_timer_chip(t);
+
+	return NSEC_PER_SEC / i2s_tdm->timer_rate;
+}
+
+static const struct snd_timer_hardware rockchip_i2s_tdm_timer_hw = {
+	.flags = SNDRV_TIMER_HW_AUTO | SNDRV_TIMER_HW_WORK,
+	.resolution = NSEC_PER_SEC / DEFAULT_FS,
+	.ticks = SAMPLE_TIMER_TICKS_MAX,
+	.close = rockchip_i2s_tdm_timer_close,
+	.start = rockchip_i2s_tdm_timer_start,
+	.stop = rockchip_i2s_tdm_timer_stop,
+	.c_resolution = rockchip_i2s_tdm_timer_resolution,
+};
+
+static void rockchip_i2s_tdm_timer_free(struct snd_timer *t)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_timer_chip(t);
+
+	hrtimer_cancel(&i2s_tdm->timer_hrt);
+	i2s_tdm->timer = NULL;
+}
+
+static int rockchip_i2s_tdm_timer_new(struct rk_i2s_tdm_dev *i2s_tdm,
+				      struct snd_soc_dai *dai)
+{
+	struct snd_card *card = dai->component->card->snd_card;
+	struct snd_timer_id tid = {
+		.dev_class = SNDRV_TIMER_CLASS_CARD,
+		.dev_sclass = SNDRV_TIMER_SCLASS_NONE,
+		.card = card->number,
+	};
+	struct snd_timer *timer;
+	int ret;
+
+	ret = of_alias_get_id(i2s_tdm->dev->of_node, "i2s");
+	tid.device = max(ret, 0);
+
+	ret = snd_timer_new(card, "I2S TDM", &tid, &timer);
+	if (ret)
+		return ret;
+
+	snprintf(timer->name, sizeof(timer->name), "%s sample clock",
+		 dev_name(i2s_tdm->dev));
+	timer->hw = rockchip_i2s_tdm_timer_hw;
+	timer->private_data = i2s_tdm;
+	timer->private_free = rockchip_i2s_tdm_timer_free;
+
+	i2s_tdm->timer_rate = DEFAULT_FS;
+	i2s_tdm->timer_stamp = ktime_get();
+	i2s_tdm->timer = timer;
+
+	return 0;
+}
+
 static int rockchip_i2s_tdm_startup(struct snd_pcm_substream *substream,
 				    struct snd_soc_dai *dai)
 {
@@ -1545,6 +2221,8 @@ static int rockchip_i2s_tdm_startup(struct snd_pcm_substream *substream,
 		return -EBUSY;
 
 	i2s_tdm->substreams[substream->stream] = substream;
+	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+		rockchip_dmcfreq_register_blackout(&i2s_tdm->dmc_blackout);
 
 	return 0;
 }
@@ -1554,7 +2232,25 @@ static void rockchip_i2s_tdm_shutdown(struct snd_pcm_substream *substream,
 {
 	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_dai_get_drvdata(dai);
 
+	if ((i2s_tdm->quirks & QUIRK_CPUFREQ_BOOST) &&
+	    substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
+		cancel_delayed_work_sync(&i2s_tdm->fill_work);
+		rockchip_cpufreq_audio_fill_update(&i2s_tdm->cpufreq_req, -1);
+	}
+
+	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+		rockchip_dmcfreq_unregister_blackout(&i2s_tdm->dmc_blackout);
+	if (i2s_tdm->link && substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+		rockchip_i2s_tdm_link_close(i2s_tdm);
+	rockchip_i2s_tdm_timer_detach(i2s_tdm, substream);
 	i2s_tdm->substreams[substream->stream] = NULL;
+
+	if (i2s_tdm->clk_meter && !i2s_tdm->substreams[!substream->stream]) {
+		WRITE_ONCE(i2s_tdm->clk_meter_rate, 0);
+		cancel_delayed_work_sync(&i2s_tdm->clk_meter_work);
+	}
+	rockchip_dmcfreq_audio_bandwidth_update(&i2s_tdm->dmc_req[substream->stream], 0);
+	rockchip_perf_audio_put(&i2s_tdm->perf[substream->stream]);
 }
 
 static const struct snd_soc_dai_ops rockchip_i2s_tdm_dai_ops = {
@@ -1666,8 +2362,34 @@ static const struct regmap_config rockchip_i2s_tdm_regmap_config = {
 	.volatile_reg = rockchip_i2s_tdm_volatile_reg,
 	.precious_reg = rockchip_i2s_tdm_precious_reg,
 	.cache_type = REGCACHE_FLAT,
+	.use_relaxed_mmio = true,
 };
 
+static void rockchip_i2s_tdm_init_restore(struct rk_i2s_tdm_dev *i2s_tdm)
+{
+	const struct regmap_config *config = &rockchip_i2s_tdm_regmap_config;
+	unsigned int reg;
+	int i, n = 0;
+
+	for (reg = 0; reg <= config->max_register; reg += config->reg_stride) {
+		if (!config->writeable_reg(i2s_tdm->dev, reg) ||
+		    config->volatile_reg(i2s_tdm->dev, reg))
+			continue;
+
+		if (WARN_ON(n == RESTORE_REGS_MAX))
+			break;
+
+		i2s_tdm->restore[n].reg = reg;
+		i2s_tdm->restore[n].def = 0;
+		for (i = 0; i < config->num_reg_defaults; i++)
+			if (config->reg_defaults[i].reg == reg)
+				i2s_tdm->restore[n].def = config->reg_defaults[i].def;
+		n++;
+	}
+
+	i2s_tdm->num_restore = n;
+}
+
 static int common_soc_init(struct device *dev, u32 addr)
 {
 	struct rk_i2s_tdm_dev *i2s_tdm = dev_get_drvdata(dev);
@@ -1787,7 +2509,6 @@ static const struct of_device_id rockchip_i2s_tdm_match[] = {
 	{},
 };
 
-#ifdef HAVE_SYNC_RESET
 static int of_i2s_resetid_get(struct device_node *node,
 			      const char *id)
 {
@@ -1805,7 +2526,85 @@ static int of_i2s_resetid_get(struct device_node *node,
 
 	return args.args[0];
 }
-#endif
+
+static void rockchip_i2s_tdm_link_unregister(void *data)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = data;
+	struct rk_i2s_tdm_link *link = i2s_tdm->link;
+	unsigned long flags;
+
+	mutex_lock(&rockchip_i2s_tdm_links_lock);
+	spin_lock_irqsave(&link->lock, flags);
+	list_del(&i2s_tdm->link_node);
+	spin_unlock_irqrestore(&link->lock, flags);
+	if (list_empty(&link->members)) {
+		list_del(&link->node);
+		iounmap(link->cru_reset - i2s_tdm->soc_data->softrst_offset);
+		kfree(link);
+	}
+	mutex_unlock(&rockchip_i2s_tdm_links_lock);
+	i2s_tdm->link = NULL;
+}
+
+static int rockchip_i2s_tdm_link_register(struct rk_i2s_tdm_dev *i2s_tdm,
+					  struct device_node *node)
+{
+	struct rk_i2s_tdm_link *link;
+	struct device_node *cru_node;
+	void __iomem *cru_base;
+	unsigned long flags;
+	u32 id;
+
+	if (of_property_read_u32(node, "rockchip,link-group", &id))
+		return 0;
+
+	if (i2s_tdm->clk_trcm || (i2s_tdm->quirks & QUIRK_ALWAYS_ON) ||
+	    !i2s_tdm->soc_data ||
+	    !i2s_tdm->soc_data->softrst_offset) {
+		dev_warn(i2s_tdm->dev, "link-group not supported, ignored\n");
+		return 0;
+	}
+
+	i2s_tdm->link_tx_id = of_i2s_resetid_get(node, "tx-m");
+	if (i2s_tdm->link_tx_id < 0)
+		return i2s_tdm->link_tx_id;
+
+	mutex_lock(&rockchip_i2s_tdm_links_lock);
+	list_for_each_entry(link, &rockchip_i2s_tdm_links, node)
+		if (link->id == id)
+			goto found;
+
+	cru_node = of_parse_phandle(node, "rockchip,cru", 0);
+	cru_base = of_iomap(cru_node, 0);
+	of_node_put(cru_node);
+	if (!cru_base) {
+		mutex_unlock(&rockchip_i2s_tdm_links_lock);
+		return -ENOENT;
+	}
+
+	link = kzalloc(sizeof(*link), GFP_KERNEL);
+	if (!link) {
+		iounmap(cru_base);
+		mutex_unlock(&rockchip_i2s_tdm_links_lock);
+		return -ENOMEM;
+	}
+
+	link->id = id;
+	link->cru_reset = cru_base + i2s_tdm->soc_data->softrst_offset;
+	INIT_LIST_HEAD(&link->members);
+	spin_lock_init(&link->lock);
+	list_add_tail(&link->node, &rockchip_i2s_tdm_links);
+found:
+	spin_lock_irqsave(&link->lock, flags);
+	list_add_tail(&i2s_tdm->link_node, &link->members);
+	spin_unlock_irqrestore(&link->lock, flags);
+	i2s_tdm->link = link;
+	mutex_unlock(&rockchip_i2s_tdm_links_lock);
+
+	return devm_add_action_or_reset(i2s_tdm->dev,
+					rockchip_i2s_tdm_link_unregister,
+					i2s_tdm);
+}
 
 static int rockchip_i2s_tdm_dai_prepare(struct platform_device *pdev,
 					struct snd_soc_dai_driver **soc_dai)
@@ -2051,6 +2850,7 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 #ifdef HAVE_SYNC_RESET
 	bool sync;
 #endif
+	unsigned int pcm_flags = 0;
 	int ret, val, i, irq;
 
 	ret = rockchip_i2s_tdm_dai_prepare(pdev, &soc_dai);
@@ -2068,6 +2868,10 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 		return -EINVAL;
 
 	spin_lock_init(&i2s_tdm->lock);
+	INIT_DELAYED_WORK(&i2s_tdm->fill_work, rockchip_i2s_tdm_fill_work);
+	INIT_DELAYED_WORK(&i2s_tdm->clk_meter_work,
+			  rockchip_i2s_tdm_clk_meter_work);
+	i2s_tdm->dmc_blackout.safe_in_us = rockchip_i2s_tdm_dmc_safe_in_us;
 	i2s_tdm->soc_data = (const struct rk_i2s_soc_data *)of_id->data;
 
 	for (i = 0; i < ARRAY_SIZE(of_quirks); i++)
@@ -2092,6 +2896,20 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 	i2s_tdm->tdm_fsync_half_frame =
 		of_property_read_bool(node, "rockchip,tdm-fsync-half-frame");
 
+	/* 0: stop playback at once, as before */
+	if (!of_property_read_u32(node, "rockchip,stop-ramp-us", &val))
+		i2s_tdm->stop_ramp_us = min_t(u32, val, STOP_RAMP_US_MAX);
+
+	i2s_tdm->lp_playback = of_property_read_bool(node, "rockchip,lp-playback");
+	i2s_tdm->lp_playback_wake_ms = LP_PLAYBACK_WAKE_MS;
+	of_property_read_u32(node, "rockchip,lp-playback-wake-ms",
+			     &i2s_tdm->lp_playback_wake_ms);
+
+	i2s_tdm->sample_timer = of_property_read_bool(node, "rockchip,sample-timer");
+	spin_lock_init(&i2s_tdm->timer_lock);
+	hrtimer_init(&i2s_tdm->timer_hrt, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	i2s_tdm->timer_hrt.function = rockchip_i2s_tdm_timer_fn;
+
 	if (of_property_read_bool(node, "rockchip,playback-only"))
 		soc_dai->capture.channels_min = 0;
 	else if (of_property_read_bool(node, "rockchip,capture-only"))
@@ -2117,6 +2935,10 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 	}
 #endif
 
+	ret = rockchip_i2s_tdm_link_register(i2s_tdm, node);
+	if (ret)
+		return ret;
+
 	i2s_tdm->tx_reset = devm_reset_control_get(&pdev->dev, "tx-m");
 	if (IS_ERR(i2s_tdm->tx_reset)) {
 		ret = PTR_ERR(i2s_tdm->tx_reset);
@@ -2173,6 +2995,13 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 	i2s_tdm->io_multiplex =
 		of_property_read_bool(node, "rockchip,io-multiplex");
 
+	/* PWM channel in capture mode wired to LRCK, to measure it in slave mode */
+	if (of_property_match_string(node, "pwm-names", "clk-meter") >= 0) {
+		i2s_tdm->clk_meter = devm_pwm_get(&pdev->dev, "clk-meter");
+		if (IS_ERR(i2s_tdm->clk_meter))
+			return PTR_ERR(i2s_tdm->clk_meter);
+	}
+
 	i2s_tdm->mclk_calibrate =
 		of_property_read_bool(node, "rockchip,mclk-calibrate");
 	if (i2s_tdm->mclk_calibrate) {
@@ -2240,6 +3069,12 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 	atomic_set(&i2s_tdm->refcount, 0);
 	dev_set_drvdata(&pdev->dev, i2s_tdm);
 
+	rockchip_i2s_tdm_init_restore(i2s_tdm);
+	i2s_tdm->regs_retained = !pdev->dev.pm_domain;
+
+	/* ASoC puts with autosuspend, let power/autosuspend_delay_ms tune it */
+	pm_runtime_set_autosuspend_delay(&pdev->dev, 0);
+	pm_runtime_use_autosuspend(&pdev->dev);
 	pm_runtime_enable(&pdev->dev);
 	if (!pm_runtime_enabled(&pdev->dev)) {
 		ret = i2s_tdm_runtime_resume(&pdev->dev);
@@ -2295,10 +3130,32 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 	if (of_property_read_bool(node, "rockchip,no-dmaengine"))
 		return ret;
 
-	if (of_property_read_bool(node, "rockchip,digital-loopback"))
+	if (of_property_read_bool(node, "rockchip,dma-hardirq-callback"))
+		pcm_flags |= SND_DMAENGINE_PCM_FLAG_HARDIRQ_CB;
+
+	/* big DSD / 768k rings from fragmented memory */
+	if (of_property_read_bool(node, "rockchip,sg-buffer"))
+		pcm_flags |= SND_DMAENGINE_PCM_FLAG_SG;
+
+	if (of_property_read_bool(node, "rockchip,digital-loopback")) {
 		ret = devm_snd_dmaengine_dlp_register(&pdev->dev, &dconfig);
-	else
-		ret = devm_snd_dmaengine_pcm_register(&pdev->dev, NULL, 0);
+	} else if (!of_property_read_u32(node, "rockchip,prealloc-buffer-kbytes",
+					 &val) && val) {
+		/*
+		 * Sized to fit the "iram" pool of the DMA controller, the
+		 * ring is taken from on-chip SRAM (see snd_malloc_dev_iram)
+		 * and playback keeps running with DDR in self-refresh.
+		 */
+		i2s_tdm->pcm_config.prepare_slave_config =
+			snd_dmaengine_pcm_prepare_slave_config;
+		i2s_tdm->pcm_config.prealloc_buffer_size = val * 1024;
+		ret = devm_snd_dmaengine_pcm_register(&pdev->dev,
+						      &i2s_tdm->pcm_config,
+						      pcm_flags);
+	} else {
+		ret = devm_snd_dmaengine_pcm_register(&pdev->dev, NULL,
+						      pcm_flags);
+	}
 
 	if (ret) {
 		dev_err(&pdev->dev, "Could not register PCM\n");
@@ -2320,6 +3177,7 @@ static int rockchip_i2s_tdm_remove(struct platform_device *pdev)
 {
 	struct rk_i2s_tdm_dev *i2s_tdm = dev_get_drvdata(&pdev->dev);
 
+	pm_runtime_dont_use_autosuspend(&pdev->dev);
 	pm_runtime_disable(&pdev->dev);
 	if (!pm_runtime_status_suspended(&pdev->dev))
 		i2s_tdm_runtime_suspend(&pdev->dev);
@@ -2342,11 +3200,59 @@ static void rockchip_i2s_tdm_platform_shutdown(struct platform_device *pdev)
 }
 
 #ifdef CONFIG_PM_SLEEP
+/*
+ * A playback of a dai link with ignore_suspend is still running when the
+ * card is suspended: hand what is left of it to the hpmcu, which follows
+ * the DMA while the system sleeps and wakes it up to refill.
+ */
+static bool rockchip_i2s_tdm_lp_playback_arm(struct rk_i2s_tdm_dev *i2s_tdm)
+{
+	struct snd_pcm_substream *substream;
+	struct snd_pcm_runtime *runtime;
+	struct rockchip_lp_playback pb;
+	snd_pcm_uframes_t pos, hw, played, avail;
+
+	substream = i2s_tdm->substreams[SNDRV_PCM_STREAM_PLAYBACK];
+	if (!i2s_tdm->lp_playback || !substream || !substream->runtime)
+		return false;
+
+	runtime = substream->runtime;
+	if (runtime->status->state != SNDRV_PCM_STATE_RUNNING)
+		return false;
+
+	/* hw_ptr only moves on period interrupts, count what played since */
+	pos = substream->ops->pointer(substream);
+	hw = runtime->status->hw_ptr % runtime->buffer_size;
+	played = (pos + runtime->buffer_size - hw) % runtime->buffer_size;
+	avail = snd_pcm_playback_hw_avail(runtime);
+	if (avail <= played)
+		return false;
+
+	pb.buf = runtime->dma_addr;
+	pb.size = frames_to_bytes(runtime, runtime->buffer_size);
+	pb.pos = frames_to_bytes(runtime, pos);
+	pb.avail = frames_to_bytes(runtime, avail - played);
+	pb.byte_rate = frames_to_bytes(runtime, runtime->rate);
+	pb.wake_bytes = pb.byte_rate / 1000 * i2s_tdm->lp_playback_wake_ms;
+	pb.ddr = !runtime->dma_buffer_p ||
+		 runtime->dma_buffer_p->dev.type != SNDRV_DMA_TYPE_DEV_IRAM;
+	if (pb.avail <= pb.wake_bytes)
+		return false;
+
+	rockchip_lp_playback_set(&pb);
+	/* keep the power domain, and with it our registers, on */
+	device_set_wakeup_path(i2s_tdm->dev);
+
+	return true;
+}
+
 static int rockchip_i2s_tdm_suspend(struct device *dev)
 {
 	struct rk_i2s_tdm_dev *i2s_tdm = dev_get_drvdata(dev);
 
-	regcache_mark_dirty(i2s_tdm->regmap);
+	i2s_tdm->lp_playback_armed = rockchip_i2s_tdm_lp_playback_arm(i2s_tdm);
+	if (!i2s_tdm->lp_playback_armed)
+		regcache_mark_dirty(i2s_tdm->regmap);
 
 	return 0;
 }
@@ -2356,6 +3262,13 @@ static int rockchip_i2s_tdm_resume(struct device *dev)
 	struct rk_i2s_tdm_dev *i2s_tdm = dev_get_drvdata(dev);
 	int ret;
 
+	if (i2s_tdm->lp_playback_armed) {
+		/* the registers never lost their context */
+		rockchip_lp_playback_set(NULL);
+		i2s_tdm->lp_playback_armed = false;
+		return 0;
+	}
+
 	ret = pm_runtime_get_sync(dev);
 	if (ret < 0)
 		return ret;
@@ -0,0 +1,589 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Rockchip MCU compress offload driver
+ *
+ * Copyright (c) 2026 Rockchip Electronics Co. Ltd.
+ *
+ * FLAC/ALAC bitstreams are written into a buffer shared with the MCU
+ * started by rockchip_amp. The MCU decodes them and drives the I2S/TDM
+ * controller itself, while this driver only passes control messages
+ * and the write pointer over rpmsg, so the A7 can stay idle between
+ * fragments.
+ */
+
+#include <linux/completion.h>
+#include <linux/module.h>
+#include <linux/of_device.h>
+#include <linux/of_reserved_mem.h>
+#include <linux/platform_device.h>
+#include <linux/rpmsg.h>
+#include <linux/rpmsg/rockchip_rpmsg.h>
+#include <sound/compress_driver.h>
+#include <sound/soc.h>
+
+#include "rockchip_mcu_compr.h"
+
+#define DRV_NAME "rockchip-mcu-compr"
+
+#define MCU_COMPR_TIMEOUT_MS		500
+#define MCU_COMPR_MIN_FRAGMENT_SIZE	SZ_1K
+#define MCU_COMPR_MAX_FRAGMENT_SIZE	SZ_64K
+#define MCU_COMPR_MIN_FRAGMENTS		2
+#define MCU_COMPR_MAX_FRAGMENTS		16
+
+#define MCU_COMPR_RATES		SNDRV_PCM_RATE_KNOT
+#define MCU_COMPR_FORMATS	(SNDRV_PCM_FMTBIT_S16_LE | \
+				 SNDRV_PCM_FMTBIT_S24_LE | \
+				 SNDRV_PCM_FMTBIT_S32_LE)
+
+struct rk_mcu_compr_dev {
+	struct device *dev;
+	struct rpmsg_device *rpdev;
+	struct snd_compr_stream *cstream;
+	struct snd_dma_buffer dmab;
+	struct snd_codec codec;
+	/* serializes commands, one waiting for its ack at a time */
+	struct mutex lock;
+	struct completion ack;
+	u32 seq;
+	int status;
+	/* protects the position reported by the MCU */
+	spinlock_t pos_lock;
+	u64 written;
+	u64 consumed;
+	u32 pcm_frames;
+	u32 pcm_io_frames;
+	u32 sampling_rate;
+};
+
+/* only one MCU audio channel exists, bound before the component probes */
+static struct rpmsg_device *mcu_compr_rpdev;
+static struct rk_mcu_compr_dev *mcu_compr;
+static DEFINE_SPINLOCK(mcu_compr_lock);
+
+static int rk_mcu_compr_post(struct rk_mcu_compr_dev *mc, u32 type,
+			     const u32 *param, int num, bool wait)
+{
+	struct rk_mcu_compr_msg msg = { 0 };
+	unsigned long left;
+	int i, ret;
+
+	msg.type = cpu_to_le32(type);
+	msg.seq = cpu_to_le32(++mc->seq);
+	for (i = 0; i < num && i < ARRAY_SIZE(msg.param); i++)
+		msg.param[i] = cpu_to_le32(param[i]);
+
+	if (wait)
+		reinit_completion(&mc->ack);
+
+	ret = rpmsg_send(mc->rpdev->ept, &msg, sizeof(msg));
+	if (ret || !wait)
+		return ret;
+
+	left = wait_for_completion_timeout(&mc->ack,
+					   msecs_to_jiffies(MCU_COMPR_TIMEOUT_MS));
+	if (!left) {
+		dev_err(mc->dev, "cmd %u timed out\n", type);
+		return -ETIMEDOUT;
+	}
+
+	return mc->status;
+}
+
+static int rk_mcu_compr_cmd(struct rk_mcu_compr_dev *mc, u32 type,
+			    const u32 *param, int num)
+{
+	int ret;
+
+	mutex_lock(&mc->lock);
+	ret = rk_mcu_compr_post(mc, type, param, num, true);
+	mutex_unlock(&mc->lock);
+
+	return ret;
+}
+
+static int rk_mcu_compr_open(struct snd_soc_component *component,
+			     struct snd_compr_stream *cstream)
+{
+	struct rk_mcu_compr_dev *mc = snd_soc_component_get_drvdata(component);
+
+	if (cstream->direction != SND_COMPRESS_PLAYBACK)
+		return -EINVAL;
+	spin_lock_irq(&mcu_compr_lock);
+	if (mc->cstream) {
+		spin_unlock_irq(&mcu_compr_lock);
+		return -EBUSY;
+	}
+	mc->cstream = cstream;
+	spin_unlock_irq(&mcu_compr_lock);
+	mc->written = 0;
+	mc->consumed = 0;
+	mc->pcm_frames = 0;
+	mc->pcm_io_frames = 0;
+	mc->sampling_rate = 0;
+
+	return 0;
+}
+
+static int rk_mcu_compr_free(struct snd_soc_component *component,
+			     struct snd_compr_stream *cstream)
+{
+	struct rk_mcu_compr_dev *mc = snd_soc_component_get_drvdata(component);
+
+	rk_mcu_compr_cmd(mc, RK_MCU_COMPR_CMD_CLOSE, NULL, 0);
+
+	spin_lock_irq(&mcu_compr_lock);
+	mc->cstream = NULL;
+	spin_unlock_irq(&mcu_compr_lock);
+	/* an error event may have raced with the core cancelling this */
+	cancel_delayed_work_sync(&cstream->error_work);
+
+	snd_compr_set_runtime_buffer(cstream, NULL);
+	if (mc->dmab.area)
+		snd_dma_free_pages(&mc->dmab);
+	memset(&mc->dmab, 0, sizeof(mc->dmab));
+
+	return 0;
+}
+
+static int rk_mcu_compr_set_params(struct snd_soc_component *component,
+				   struct snd_compr_stream *cstream,
+				   struct snd_compr_params *params)
+{
+	struct rk_mcu_compr_dev *mc = snd_soc_component_get_drvdata(component);
+	struct snd_codec *codec = &params->codec;
+	size_t size = params->buffer.fragment_size * params->buffer.fragments;
+	u32 param[5];
+	int ret;
+
+	switch (codec->id) {
+	case SND_AUDIOCODEC_FLAC:
+	case SND_AUDIOCODEC_ALAC:
+		break;
+	default:
+		dev_err(mc->dev, "unsupported codec %u\n", codec->id);
+		return -EINVAL;
+	}
+
+	if (!codec->ch_in || !codec->sample_rate)
+		return -EINVAL;
+
+	if (mc->dmab.area && mc->dmab.bytes < size) {
+		snd_compr_set_runtime_buffer(cstream, NULL);
+		snd_dma_free_pages(&mc->dmab);
+		memset(&mc->dmab, 0, sizeof(mc->dmab));
+	}
+	if (!mc->dmab.area) {
+		/* from the reserved region shared with the MCU */
+		ret = snd_dma_alloc_pages(SNDRV_DMA_TYPE_DEV, mc->dev,
+					  size, &mc->dmab);
+		if (ret)
+			return ret;
+	}
+	snd_compr_set_runtime_buffer(cstream, &mc->dmab);
+
+	param[0] = codec->id;
+	param[1] = codec->sample_rate;
+	param[2] = codec->ch_in;
+	if (codec->id == SND_AUDIOCODEC_FLAC) {
+		param[3] = codec->options.flac_d.sample_size;
+		param[4] = codec->options.flac_d.max_blk_size;
+	} else {
+		/* the MCU takes the bit depth from the ALAC cookie */
+		param[3] = 0;
+		param[4] = codec->options.alac_d.frame_length;
+	}
+	ret = rk_mcu_compr_cmd(mc, RK_MCU_COMPR_CMD_SET_PARAMS, param, 5);
+	if (ret)
+		return ret;
+
+	param[0] = lower_32_bits(mc->dmab.addr);
+	param[1] = upper_32_bits(mc->dmab.addr);
+	param[2] = size;
+	param[3] = params->buffer.fragment_size;
+	ret = rk_mcu_compr_cmd(mc, RK_MCU_COMPR_CMD_SET_BUF, param, 4);
+	if (ret)
+		return ret;
+
+	mc->codec = *codec;
+
+	return 0;
+}
+
+static int rk_mcu_compr_get_params(struct snd_soc_component *component,
+				   struct snd_compr_stream *cstream,
+				   struct snd_codec *params)
+{
+	struct rk_mcu_compr_dev *mc = snd_soc_component_get_drvdata(component);
+
+	*params = mc->codec;
+
+	return 0;
+}
+
+static int rk_mcu_compr_set_metadata(struct snd_soc_component *component,
+				     struct snd_compr_stream *cstream,
+				     struct snd_compr_metadata *metadata)
+{
+	struct rk_mcu_compr_dev *mc = snd_soc_component_get_drvdata(component);
+	u32 param[2];
+
+	switch (metadata->key) {
+	case SNDRV_COMPRESS_ENCODER_DELAY:
+		param[0] = metadata->value[0];
+		param[1] = U32_MAX;
+		break;
+	case SNDRV_COMPRESS_ENCODER_PADDING:
+		param[0] = U32_MAX;
+		param[1] = metadata->value[0];
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	/* U32_MAX leaves that field unchanged on the MCU */
+	return rk_mcu_compr_cmd(mc, RK_MCU_COMPR_CMD_GAPLESS, param, 2);
+}
+
+static int rk_mcu_compr_trigger(struct snd_soc_component *component,
+				struct snd_compr_stream *cstream, int cmd)
+{
+	struct rk_mcu_compr_dev *mc = snd_soc_component_get_drvdata(component);
+	u32 type;
+
+	switch (cmd) {
+	case SNDRV_PCM_TRIGGER_START:
+		type = RK_MCU_COMPR_CMD_START;
+		break;
+	case SNDRV_PCM_TRIGGER_STOP:
+		type = RK_MCU_COMPR_CMD_STOP;
+		break;
+	case SNDRV_PCM_TRIGGER_PAUSE_PUSH:
+		type = RK_MCU_COMPR_CMD_PAUSE;
+		break;
+	case SNDRV_PCM_TRIGGER_PAUSE_RELEASE:
+		type = RK_MCU_COMPR_CMD_RESUME;
+		break;
+	case SND_COMPR_TRIGGER_DRAIN:
+		type = RK_MCU_COMPR_CMD_DRAIN;
+		break;
+	case SND_COMPR_TRIGGER_PARTIAL_DRAIN:
+		type = RK_MCU_COMPR_CMD_PARTIAL_DRAIN;
+		break;
+	case SND_COMPR_TRIGGER_NEXT_TRACK:
+		type = RK_MCU_COMPR_CMD_NEXT_TRACK;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return rk_mcu_compr_cmd(mc, type, NULL, 0);
+}
+
+static int rk_mcu_compr_pointer(struct snd_soc_component *component,
+				struct snd_compr_stream *cstream,
+				struct snd_compr_tstamp *tstamp)
+{
+	struct rk_mcu_compr_dev *mc = snd_soc_component_get_drvdata(component);
+	struct snd_compr_runtime *runtime = cstream->runtime;
+	unsigned long flags;
+	u64 consumed;
+
+	spin_lock_irqsave(&mc->pos_lock, flags);
+	consumed = mc->consumed;
+	tstamp->pcm_frames = mc->pcm_frames;
+	tstamp->pcm_io_frames = mc->pcm_io_frames;
+	tstamp->sampling_rate = mc->sampling_rate;
+	spin_unlock_irqrestore(&mc->pos_lock, flags);
+
+	tstamp->copied_total = consumed;
+	if (runtime->buffer_size)
+		tstamp->byte_offset = do_div(consumed, runtime->buffer_size);
+
+	return 0;
+}
+
+static int rk_mcu_compr_ack(struct snd_soc_component *component,
+			    struct snd_compr_stream *cstream, size_t bytes)
+{
+	struct rk_mcu_compr_dev *mc = snd_soc_component_get_drvdata(component);
+	u32 param[2];
+	int ret;
+
+	mutex_lock(&mc->lock);
+	mc->written += bytes;
+	param[0] = lower_32_bits(mc->written);
+	param[1] = upper_32_bits(mc->written);
+	ret = rk_mcu_compr_post(mc, RK_MCU_COMPR_CMD_WRITE, param, 2, false);
+	mutex_unlock(&mc->lock);
+
+	return ret;
+}
+
+static int rk_mcu_compr_get_caps(struct snd_soc_component *component,
+				 struct snd_compr_stream *cstream,
+				 struct snd_compr_caps *caps)
+{
+	caps->direction = SND_COMPRESS_PLAYBACK;
+	caps->min_fragment_size = MCU_COMPR_MIN_FRAGMENT_SIZE;
+	caps->max_fragment_size = MCU_COMPR_MAX_FRAGMENT_SIZE;
+	caps->min_fragments = MCU_COMPR_MIN_FRAGMENTS;
+	caps->max_fragments = MCU_COMPR_MAX_FRAGMENTS;
+	caps->num_codecs = 2;
+	caps->codecs[0] = SND_AUDIOCODEC_FLAC;
+	caps->codecs[1] = SND_AUDIOCODEC_ALAC;
+
+	return 0;
+}
+
+static int rk_mcu_compr_get_codec_caps(struct snd_soc_component *component,
+				       struct snd_compr_stream *cstream,
+				       struct snd_compr_codec_caps *codec)
+{
+	struct snd_codec_desc *desc = &codec->descriptor[0];
+
+	switch (codec->codec) {
+	case SND_AUDIOCODEC_FLAC:
+	case SND_AUDIOCODEC_ALAC:
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	codec->num_descriptors = 1;
+	desc->max_ch = 8;
+	desc->sample_rates[0] = 44100;
+	desc->sample_rates[1] = 48000;
+	desc->sample_rates[2] = 88200;
+	desc->sample_rates[3] = 96000;
+	desc->sample_rates[4] = 176400;
+	desc->sample_rates[5] = 192000;
+	desc->sample_rates[6] = 352800;
+	desc->sample_rates[7] = 384000;
+	desc->num_sample_rates = 8;
+	desc->formats = MCU_COMPR_FORMATS;
+
+	return 0;
+}
+
+static const struct snd_compress_ops rk_mcu_compr_ops = {
+	.open		= rk_mcu_compr_open,
+	.free		= rk_mcu_compr_free,
+	.set_params	= rk_mcu_compr_set_params,
+	.get_params	= rk_mcu_compr_get_params,
+	.set_metadata	= rk_mcu_compr_set_metadata,
+	.trigger	= rk_mcu_compr_trigger,
+	.pointer	= rk_mcu_compr_pointer,
+	.ack		= rk_mcu_compr_ack,
+	.get_caps	= rk_mcu_compr_get_caps,
+	.get_codec_caps	= rk_mcu_compr_get_codec_caps,
+};
+
+static const struct snd_soc_component_driver rk_mcu_compr_component = {
+	.name		= DRV_NAME,
+	.compress_ops	= &rk_mcu_compr_ops,
+};
+
+static struct snd_soc_dai_driver rk_mcu_compr_dai = {
+	.name = "mcu-compr",
+	.compress_new = snd_soc_new_compress,
+	.playback = {
+		.stream_name = "Offload Playback",
+		.channels_min = 1,
+		.channels_max = 8,
+		.rates = MCU_COMPR_RATES,
+		.rate_min = 8000,
+		.rate_max = 768000,
+		.formats = MCU_COMPR_FORMATS,
+	},
+};
+
+static int rk_mcu_compr_rpmsg_cb(struct rpmsg_device *rpdev, void *data,
+				 int len, void *priv, u32 src)
+{
+	struct rk_mcu_compr_msg *msg = data;
+	struct rk_mcu_compr_dev *mc;
+	unsigned long flags;
+
+	if (len < sizeof(*msg))
+		return -EINVAL;
+
+	spin_lock_irqsave(&mcu_compr_lock, flags);
+	mc = mcu_compr;
+	if (!mc)
+		goto unlock;
+
+	switch (le32_to_cpu(msg->type)) {
+	case RK_MCU_COMPR_EVT_ACK:
+		if (le32_to_cpu(msg->seq) != mc->seq)
+			break;
+		mc->status = -(s32)le32_to_cpu(msg->param[1]);
+		complete(&mc->ack);
+		break;
+	case RK_MCU_COMPR_EVT_POS:
+		spin_lock(&mc->pos_lock);
+		/* consumed only grows, the MCU reports its low word */
+		mc->consumed += (u32)(le32_to_cpu(msg->param[0]) -
+				      lower_32_bits(mc->consumed));
+		mc->pcm_frames = le32_to_cpu(msg->param[1]);
+		mc->pcm_io_frames = le32_to_cpu(msg->param[2]);
+		mc->sampling_rate = le32_to_cpu(msg->param[3]);
+		spin_unlock(&mc->pos_lock);
+		if (mc->cstream)
+			snd_compr_fragment_elapsed(mc->cstream);
+		break;
+	case RK_MCU_COMPR_EVT_DRAINED:
+		if (mc->cstream)
+			snd_compr_drain_notify(mc->cstream);
+		break;
+	case RK_MCU_COMPR_EVT_ERROR:
+		dev_err(mc->dev, "decoder error %d\n",
+			-(s32)le32_to_cpu(msg->param[0]));
+		if (mc->cstream)
+			snd_compr_stop_error(mc->cstream,
+					     SNDRV_PCM_STATE_XRUN);
+		break;
+	default:
+		break;
+	}
+unlock:
+	spin_unlock_irqrestore(&mcu_compr_lock, flags);
+
+	return 0;
+}
+
+static int rk_mcu_compr_rpmsg_probe(struct rpmsg_device *rpdev)
+{
+	spin_lock_irq(&mcu_compr_lock);
+	mcu_compr_rpdev = rpdev;
+	spin_unlock_irq(&mcu_compr_lock);
+
+	dev_info(&rpdev->dev, "channel 0x%x -> 0x%x\n", rpdev->src, rpdev->dst);
+
+	return 0;
+}
+
+static void rk_mcu_compr_rpmsg_remove(struct rpmsg_device *rpdev)
+{
+	spin_lock_irq(&mcu_compr_lock);
+	mcu_compr_rpdev = NULL;
+	spin_unlock_irq(&mcu_compr_lock);
+}
+
+static struct rpmsg_device_id rk_mcu_compr_rpmsg_id_table[] = {
+	{ .name = "rpmsg-audio-compr" },
+	{ /* sentinel */ },
+};
+MODULE_DEVICE_TABLE(rpmsg, rk_mcu_compr_rpmsg_id_table);
+
+static struct rpmsg_driver rk_mcu_compr_rpmsg_driver = {
+	.drv.name	= KBUILD_MODNAME,
+	.id_table	= rk_mcu_compr_rpmsg_id_table,
+	.probe		= rk_mcu_compr_rpmsg_probe,
+	.callback	= rk_mcu_compr_rpmsg_cb,
+	.remove		= rk_mcu_compr_rpmsg_remove,
+};
+
+static int rk_mcu_compr_probe(struct platform_device *pdev)
+{
+	struct rk_mcu_compr_dev *mc;
+	int ret;
+
+	mc = devm_kzalloc(&pdev->dev, sizeof(*mc), GFP_KERNEL);
+	if (!mc)
+		return -ENOMEM;
+
+	mc->dev = &pdev->dev;
+	mutex_init(&mc->lock);
+	init_completion(&mc->ack);
+	spin_lock_init(&mc->pos_lock);
+	dev_set_drvdata(&pdev->dev, mc);
+
+	ret = of_reserved_mem_device_init(&pdev->dev);
+	if (ret && ret != -ENODEV) {
+		dev_err(&pdev->dev, "failed to init shared memory: %d\n", ret);
+		return ret;
+	}
+
+	spin_lock_irq(&mcu_compr_lock);
+	if (!mcu_compr_rpdev) {
+		spin_unlock_irq(&mcu_compr_lock);
+		ret = -EPROBE_DEFER;
+		goto err_mem;
+	}
+	mc->rpdev = mcu_compr_rpdev;
+	mcu_compr = mc;
+	spin_unlock_irq(&mcu_compr_lock);
+
+	ret = devm_snd_soc_register_component(&pdev->dev,
+					      &rk_mcu_compr_component,
+					      &rk_mcu_compr_dai, 1);
+	if (ret) {
+		dev_err(&pdev->dev, "could not register component: %d\n", ret);
+		goto err_unbind;
+	}
+
+	return 0;
+
+err_unbind:
+	spin_lock_irq(&mcu_compr_lock);
+	mcu_compr = NULL;
+	spin_unlock_irq(&mcu_compr_lock);
+err_mem:
+	of_reserved_mem_device_release(&pdev->dev);
+
+	return ret;
+}
+
+static int rk_mcu_compr_remove(struct platform_device *pdev)
+{
+	spin_lock_irq(&mcu_compr_lock);
+	mcu_compr = NULL;
+	spin_unlock_irq(&mcu_compr_lock);
+
+	of_reserved_mem_device_release(&pdev->dev);
+
+	return 0;
+}
+
+static const struct of_device_id rk_mcu_compr_match[] = {
+	{ .compatible = "rockchip,mcu-compr", },
+	{},
+};
+MODULE_DEVICE_TABLE(of, rk_mcu_compr_match);
+
+static struct platform_driver rk_mcu_compr_driver = {
+	.probe = rk_mcu_compr_probe,
+	.remove = rk_mcu_compr_remove,
+	.driver = {
+		.name = DRV_NAME,
+		.of_match_table = of_match_ptr(rk_mcu_compr_match),
+	},
+};
+
+static int __init rk_mcu_compr_init(void)
+{
+	int ret;
+
+	ret = register_rpmsg_driver(&rk_mcu_compr_rpmsg_driver);
+	if (ret)
+		return ret;
+
+	ret = platform_driver_register(&rk_mcu_compr_driver);
+	if (ret)
+		unregister_rpmsg_driver(&rk_mcu_compr_rpmsg_driver);
+
+	return ret;
+}
+module_init(rk_mcu_compr_init);
+
+static void __exit rk_mcu_compr_exit(void)
+{
+	platform_driver_unregister(&rk_mcu_compr_driver);
+	unregister_rpmsg_driver(&rk_mcu_compr_rpmsg_driver);
+}
+module_exit(rk_mcu_compr_exit);
+
+MODULE_DESCRIPTION("Rockchip MCU Compress Offload Driver");
+MODULE_LICENSE("GPL");
+MODULE_ALIAS("platform:" DRV_NAME);
@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Rockchip MCU compress offload protocol
+ *
+ * Copyright (c) 2026 Rockchip Electronics Co. Ltd.
+ *
+ * Every rpmsg message is one struct rk_mcu_compr_msg, little endian.
+ * The host sends RK_MCU_COMPR_CMD_* and the MCU answers each one with
+ * RK_MCU_COMPR_EVT_ACK carrying the same seq, except for
+ * RK_MCU_COMPR_CMD_WRITE which is posted. RK_MCU_COMPR_EVT_POS and
+ * RK_MCU_COMPR_EVT_DRAINED are sent unsolicited while playing.
+ */
+
+#ifndef _ROCKCHIP_MCU_COMPR_H
+#define _ROCKCHIP_MCU_COMPR_H
+
+enum {
+	/* codec, rate, channels, bits, block size */
+	RK_MCU_COMPR_CMD_SET_PARAMS = 1,
+	/* addr_lo, addr_hi, buffer bytes, fragment bytes */
+	RK_MCU_COMPR_CMD_SET_BUF,
+	RK_MCU_COMPR_CMD_START,
+	RK_MCU_COMPR_CMD_STOP,
+	RK_MCU_COMPR_CMD_PAUSE,
+	RK_MCU_COMPR_CMD_RESUME,
+	RK_MCU_COMPR_CMD_DRAIN,
+	RK_MCU_COMPR_CMD_PARTIAL_DRAIN,
+	RK_MCU_COMPR_CMD_NEXT_TRACK,
+	/* total bytes written, low and high word */
+	RK_MCU_COMPR_CMD_WRITE,
+	/* encoder delay, encoder padding in frames, ~0 keeps the old value */
+	RK_MCU_COMPR_CMD_GAPLESS,
+	RK_MCU_COMPR_CMD_CLOSE,
+};
+
+enum {
+	/* cmd, status */
+	RK_MCU_COMPR_EVT_ACK = 0x80,
+	/* bytes consumed, frames decoded, frames rendered, rate */
+	RK_MCU_COMPR_EVT_POS,
+	RK_MCU_COMPR_EVT_DRAINED,
+	/* status */
+	RK_MCU_COMPR_EVT_ERROR,
+};
+
+struct rk_mcu_compr_msg {
+	__le32 type;
+	__le32 seq;
+	__le32 param[6];
+};
+
+#endif /* _ROCKCHIP_MCU_COMPR_H */
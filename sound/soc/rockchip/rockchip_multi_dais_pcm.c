@@ -378,6 +378,46 @@ static int snd_dmaengine_mpcm_trigger(struct snd_soc_component *component,
 	return 0;
 }
 
+/*
+ * Each DAI's DMA writes its own slots straight into the shared interleaved
+ * buffer: one burst of @sz bytes per frame, then a skip of the other
+ * DAIs' slots. Returns that burst length, 0 if the DAI owns the whole
+ * frame, or -EINVAL if the DMA can't produce this layout.
+ */
+static int dmaengine_mpcm_interlace_burst(struct dmaengine_mpcm *pcm,
+					  struct dma_chan *chan,
+					  int sz, int frame_bytes,
+					  enum dma_slave_buswidth width)
+{
+	struct dma_slave_caps caps;
+	int burst;
+
+	if (!sz || sz == frame_bytes)
+		return 0;
+
+	/* dma_slave_config interlace sizes only exist in NO_GKI builds */
+	if (!IS_ENABLED(CONFIG_NO_GKI)) {
+		dev_err(pcm->mdais->dev, "interleaved multi-dais needs dma interlace\n");
+		return -EINVAL;
+	}
+
+	if (width <= 0 || sz % width) {
+		dev_err(pcm->mdais->dev, "slot bytes %d not a multiple of bus width %d\n",
+			sz, width);
+		return -EINVAL;
+	}
+
+	burst = sz / width;
+	if (!dma_get_slave_caps(chan, &caps) && caps.max_burst &&
+	    burst > caps.max_burst) {
+		dev_err(pcm->mdais->dev, "slot burst %d exceeds dma max burst %u\n",
+			burst, caps.max_burst);
+		return -EINVAL;
+	}
+
+	return burst;
+}
+
 static int dmaengine_mpcm_hw_params(struct snd_soc_component *component,
 				    struct snd_pcm_substream *substream,
 				    struct snd_pcm_hw_params *params)
@@ -419,25 +459,33 @@ static int dmaengine_mpcm_hw_params(struct snd_soc_component *component,
 		sz = snd_pcm_format_size(format, maps[i]);
 		if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
 			chan = pcm->tx_chans[i];
+			if (!chan)
+				continue;
+			ret = dmaengine_mpcm_interlace_burst(pcm, chan, sz, frame_bytes,
+							     slave_config.dst_addr_width);
+			if (ret < 0)
+				return ret;
 #ifdef CONFIG_NO_GKI
-			if (sz) {
+			if (ret) {
 				slave_config.src_interlace_size = frame_bytes - sz;
-				if (slave_config.src_interlace_size)
-					slave_config.dst_maxburst = sz / slave_config.dst_addr_width;
+				slave_config.dst_maxburst = ret;
 			}
 #endif
 		} else {
 			chan = pcm->rx_chans[i];
+			if (!chan)
+				continue;
+			ret = dmaengine_mpcm_interlace_burst(pcm, chan, sz, frame_bytes,
+							     slave_config.src_addr_width);
+			if (ret < 0)
+				return ret;
 #ifdef CONFIG_NO_GKI
-			if (sz) {
+			if (ret) {
 				slave_config.dst_interlace_size = frame_bytes - sz;
-				if (slave_config.dst_interlace_size)
-					slave_config.src_maxburst = sz / slave_config.src_addr_width;
+				slave_config.src_maxburst = ret;
 			}
 #endif
 		}
-		if (!chan)
-			continue;
 
 		ret = dmaengine_slave_config(chan, &slave_config);
 		if (ret)
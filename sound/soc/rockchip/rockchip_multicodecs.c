@@ -49,10 +49,13 @@ struct adc_keys_button {
 
 struct input_dev_poller {
 	void (*poll)(struct input_dev *dev);
+	/* interrupt driven: keep polling only while this returns true */
+	bool (*active)(struct input_dev *dev);
 
 	unsigned int poll_interval_ms;
 	struct input_dev *input;
 	struct delayed_work work;
+	bool enabled;
 };
 
 struct multicodecs_data {
@@ -62,6 +65,7 @@ struct multicodecs_data {
 	struct gpio_desc *hp_ctl_gpio;
 	struct gpio_desc *spk_ctl_gpio;
 	struct gpio_desc *hp_det_gpio;
+	struct gpio_desc *key_det_gpio;
 	struct iio_channel *adc;
 	struct extcon_dev *extcon;
 	struct delayed_work handler;
@@ -104,19 +108,20 @@ static void mc_keys_poller_work(struct work_struct *work)
 		container_of(work, struct input_dev_poller, work.work);
 
 	poller->poll(poller->input);
-	mc_keys_poller_queue_work(poller);
+	if (!poller->active || poller->active(poller->input))
+		mc_keys_poller_queue_work(poller);
 }
 
 static void mc_keys_poller_start(struct input_dev_poller *poller)
 {
-	if (poller->poll_interval_ms > 0) {
-		poller->poll(poller->input);
-		mc_keys_poller_queue_work(poller);
-	}
+	WRITE_ONCE(poller->enabled, true);
+	if (poller->poll_interval_ms > 0)
+		mod_delayed_work(system_freezable_wq, &poller->work, 0);
 }
 
 static void mc_keys_poller_stop(struct input_dev_poller *poller)
 {
+	WRITE_ONCE(poller->enabled, false);
 	cancel_delayed_work_sync(&poller->work);
 }
 
@@ -171,6 +176,26 @@ static void mc_keys_poll(struct input_dev *input)
 	mc_data->last_key = keycode;
 }
 
+static bool mc_keys_active(struct input_dev *input)
+{
+	struct multicodecs_data *mc_data = input_get_drvdata(input);
+
+	/* poll on until the key is seen released */
+	return mc_data->last_key || gpiod_get_value_cansleep(mc_data->key_det_gpio);
+}
+
+static irqreturn_t mc_keys_det_irq_thread(int irq, void *data)
+{
+	struct input_dev_poller *poller = data;
+
+	/* sample once the level has settled */
+	if (READ_ONCE(poller->enabled))
+		mod_delayed_work(system_freezable_wq, &poller->work,
+				 msecs_to_jiffies(poller->poll_interval_ms));
+
+	return IRQ_HANDLED;
+}
+
 static int mc_keys_load_keymap(struct device *dev,
 			       struct multicodecs_data *mc_data)
 {
@@ -590,7 +615,7 @@ static int rk_multicodecs_probe(struct platform_device *pdev)
 	struct device_node *node;
 	struct input_dev *input;
 	u32 val;
-	int count, value;
+	int count, value, irq;
 	int ret = 0, i = 0, idx = 0;
 	const char *prefix = "rockchip,";
 
@@ -752,6 +777,37 @@ static int rk_multicodecs_probe(struct platform_device *pdev)
 		if (!device_property_read_u32(&pdev->dev, "poll-interval", &value))
 			mc_set_poll_interval(mc_data->poller, value);
 
+		/*
+		 * The SARADC has no threshold interrupt. With a key-det GPIO
+		 * (a comparator on the mic line) the ADC is only sampled
+		 * from a key edge until the key is released, instead of
+		 * polling all along while a headset is plugged in.
+		 */
+		mc_data->key_det_gpio = devm_gpiod_get_optional(&pdev->dev,
+								"key-det",
+								GPIOD_IN);
+		if (IS_ERR(mc_data->key_det_gpio))
+			return PTR_ERR(mc_data->key_det_gpio);
+
+		if (mc_data->key_det_gpio) {
+			irq = gpiod_to_irq(mc_data->key_det_gpio);
+			if (irq < 0)
+				return irq;
+
+			mc_data->poller->active = mc_keys_active;
+			ret = devm_request_threaded_irq(&pdev->dev, irq, NULL,
+							mc_keys_det_irq_thread,
+							IRQF_TRIGGER_RISING |
+							IRQF_TRIGGER_FALLING |
+							IRQF_ONESHOT,
+							"headset_keys",
+							mc_data->poller);
+			if (ret) {
+				dev_err(&pdev->dev, "Failed to request key detect irq\n");
+				return ret;
+			}
+		}
+
 		ret = input_register_device(mc_data->input);
 		if (ret) {
 			dev_err(&pdev->dev, "Unable to register input device: %d\n", ret);
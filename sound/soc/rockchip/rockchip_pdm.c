@@ -8,6 +8,7 @@
 #include <linux/module.h>
 #include <linux/clk.h>
 #include <linux/clk/rockchip.h>
+#include <linux/hrtimer.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
 #include <linux/pm_runtime.h>
@@ -29,6 +30,8 @@
 #define PDM_START_DELAY_MS_MAX		(1000)
 #define PDM_FILTER_DELAY_MS_MIN		(20)
 #define PDM_FILTER_DELAY_MS_MAX		(1000)
+#define PDM_REFRESH_US_MIN		(250)
+#define PDM_REFRESH_US_MAX		(100000)
 #define PDM_CLK_SHIFT_PPM_MAX		(1000000) /* 1 ppm */
 #define CLK_PPM_MIN		(-1000)
 #define CLK_PPM_MAX		(1000)
@@ -50,6 +53,10 @@ struct rk_pdm_dev {
 	struct reset_control *reset;
 	unsigned int start_delay_ms;
 	unsigned int filter_delay_ms;
+	/* hrtimer driven hw_ptr refresh between period IRQs, 0 for off */
+	unsigned int refresh_us;
+	struct hrtimer refresh_timer;
+	struct snd_pcm_substream *substream;
 	enum rk_pdm_version version;
 	unsigned int clk_root_rate;
 	unsigned int clk_root_initial_rate;
@@ -463,6 +470,51 @@ static int rockchip_pdm_set_fmt(struct snd_soc_dai *cpu_dai,
 	return 0;
 }
 
+/*
+ * Like sound/core/hrtimer.c, but instead of ticking an ALSA timer it
+ * runs the period-elapsed path, so hw_ptr follows the DMA residue at
+ * refresh_us granularity and poll() wakes on avail_min. Combined with
+ * SNDRV_PCM_HW_PARAMS_NO_PERIOD_WAKEUP this replaces period IRQs.
+ */
+static enum hrtimer_restart rockchip_pdm_refresh(struct hrtimer *timer)
+{
+	struct rk_pdm_dev *pdm = container_of(timer, struct rk_pdm_dev,
+					      refresh_timer);
+	struct snd_pcm_substream *substream = READ_ONCE(pdm->substream);
+
+	if (!substream)
+		return HRTIMER_NORESTART;
+
+	snd_pcm_period_elapsed(substream);
+
+	/* stopped meanwhile, the trigger could not wait for us */
+	if (!READ_ONCE(pdm->substream))
+		return HRTIMER_NORESTART;
+
+	hrtimer_forward_now(timer, ns_to_ktime(pdm->refresh_us * NSEC_PER_USEC));
+
+	return HRTIMER_RESTART;
+}
+
+static void rockchip_pdm_refresh_start(struct rk_pdm_dev *pdm,
+				       struct snd_pcm_substream *substream)
+{
+	if (!pdm->refresh_us)
+		return;
+
+	WRITE_ONCE(pdm->substream, substream);
+	hrtimer_start(&pdm->refresh_timer,
+		      ns_to_ktime(pdm->refresh_us * NSEC_PER_USEC),
+		      HRTIMER_MODE_REL);
+}
+
+static void rockchip_pdm_refresh_stop(struct rk_pdm_dev *pdm)
+{
+	/* atomic context: a running callback spins on our stream lock */
+	WRITE_ONCE(pdm->substream, NULL);
+	hrtimer_try_to_cancel(&pdm->refresh_timer);
+}
+
 static int rockchip_pdm_trigger(struct snd_pcm_substream *substream, int cmd,
 				struct snd_soc_dai *dai)
 {
@@ -473,14 +525,18 @@ static int rockchip_pdm_trigger(struct snd_pcm_substream *substream, int cmd,
 	case SNDRV_PCM_TRIGGER_START:
 	case SNDRV_PCM_TRIGGER_RESUME:
 	case SNDRV_PCM_TRIGGER_PAUSE_RELEASE:
-		if (substream->stream == SNDRV_PCM_STREAM_CAPTURE)
+		if (substream->stream == SNDRV_PCM_STREAM_CAPTURE) {
 			rockchip_pdm_rxctrl(pdm, 1);
+			rockchip_pdm_refresh_start(pdm, substream);
+		}
 		break;
 	case SNDRV_PCM_TRIGGER_SUSPEND:
 	case SNDRV_PCM_TRIGGER_STOP:
 	case SNDRV_PCM_TRIGGER_PAUSE_PUSH:
-		if (substream->stream == SNDRV_PCM_STREAM_CAPTURE)
+		if (substream->stream == SNDRV_PCM_STREAM_CAPTURE) {
+			rockchip_pdm_refresh_stop(pdm);
 			rockchip_pdm_rxctrl(pdm, 0);
+		}
 		break;
 	default:
 		ret = -EINVAL;
@@ -566,6 +622,48 @@ static int rockchip_pdm_filter_delay_put(struct snd_kcontrol *kcontrol,
 	return 1;
 }
 
+static int rockchip_pdm_refresh_info(struct snd_kcontrol *kcontrol,
+				     struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER;
+	uinfo->count = 1;
+	uinfo->value.integer.min = 0;
+	uinfo->value.integer.max = PDM_REFRESH_US_MAX;
+	uinfo->value.integer.step = 1;
+
+	return 0;
+}
+
+static int rockchip_pdm_refresh_get(struct snd_kcontrol *kcontrol,
+				    struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_pdm_dev *pdm = snd_soc_dai_get_drvdata(dai);
+
+	ucontrol->value.integer.value[0] = pdm->refresh_us;
+
+	return 0;
+}
+
+static int rockchip_pdm_refresh_put(struct snd_kcontrol *kcontrol,
+				    struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_pdm_dev *pdm = snd_soc_dai_get_drvdata(dai);
+	long us = ucontrol->value.integer.value[0];
+
+	if (us && (us < PDM_REFRESH_US_MIN || us > PDM_REFRESH_US_MAX))
+		return -EINVAL;
+
+	if (us == pdm->refresh_us)
+		return 0;
+
+	/* applies from the next trigger start */
+	pdm->refresh_us = us;
+
+	return 1;
+}
+
 static const struct snd_kcontrol_new rockchip_pdm_controls[] = {
 	{
 		.iface = SNDRV_CTL_ELEM_IFACE_PCM,
@@ -581,6 +679,13 @@ static const struct snd_kcontrol_new rockchip_pdm_controls[] = {
 		.get = rockchip_pdm_filter_delay_get,
 		.put = rockchip_pdm_filter_delay_put,
 	},
+	{
+		.iface = SNDRV_CTL_ELEM_IFACE_PCM,
+		.name = "PDM Pointer Refresh Us",
+		.info = rockchip_pdm_refresh_info,
+		.get = rockchip_pdm_refresh_get,
+		.put = rockchip_pdm_refresh_put,
+	},
 };
 
 static int rockchip_pdm_clk_compensation_info(struct snd_kcontrol *kcontrol,
@@ -652,6 +757,7 @@ static void rockchip_pdm_shutdown(struct snd_pcm_substream *substream,
 	if (substream->stream != SNDRV_PCM_STREAM_CAPTURE)
 		return;
 
+	hrtimer_cancel(&pdm->refresh_timer);
 	regmap_update_bits(pdm->regmap, PDM_CLK_CTRL, PDM_CLK_MSK, PDM_CLK_DIS);
 }
 
@@ -935,6 +1041,8 @@ static int rockchip_pdm_probe(struct platform_device *pdev)
 
 	pdm->start_delay_ms = PDM_START_DELAY_MS_DEFAULT;
 	pdm->filter_delay_ms = PDM_FILTER_DELAY_MS_MIN;
+	hrtimer_init(&pdm->refresh_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	pdm->refresh_timer.function = rockchip_pdm_refresh;
 
 	pdm->clk_calibrate =
 		of_property_read_bool(node, "rockchip,mclk-calibrate");
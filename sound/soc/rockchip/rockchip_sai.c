@@ -11,9 +11,11 @@
 #include <linux/of_gpio.h>
 #include <linux/of_device.h>
 #include <linux/clk.h>
+#include <linux/hrtimer.h>
 #include <linux/pm_runtime.h>
 #include <linux/regmap.h>
 #include <linux/reset.h>
+#include <linux/timekeeping.h>
 #include <sound/pcm_params.h>
 #include <sound/dmaengine_pcm.h>
 #include <sound/tlv.h>
@@ -25,6 +27,10 @@
 #define FW_RATIO_MAX		8
 #define FW_RATIO_MIN		1
 #define MAXBURST_PER_FIFO	8
+#define SAI_LANES_MAX		4
+#define SAI_TPATH_MASK(lanes)	GENMASK((lanes) * 2 - 1, 0)
+#define SAI_TPATH(lane, sdo)	((sdo) << ((lane) * 2))
+#define SAI_TPATH_V(v, lane)	(((v) >> ((lane) * 2)) & 0x3)
 
 enum fpw_mode {
 	FPW_ONE_BCLK_WIDTH,
@@ -50,6 +56,9 @@ struct rk_sai_dev {
 	bool has_playback;
 	bool is_master_mode;
 	bool is_tdm;
+	/* CLOCK_TAI time the next playback start enables TX at, 0 = now */
+	ktime_t start_time;
+	struct hrtimer start_timer;
 };
 
 static int sai_runtime_suspend(struct device *dev)
@@ -248,6 +257,36 @@ static void rockchip_sai_start(struct rk_sai_dev *sai, int stream)
 	rockchip_sai_xfer_start(sai, stream);
 }
 
+static enum hrtimer_restart rockchip_sai_start_timer(struct hrtimer *timer)
+{
+	struct rk_sai_dev *sai = container_of(timer, struct rk_sai_dev,
+					      start_timer);
+
+	rockchip_sai_xfer_start(sai, SNDRV_PCM_STREAM_PLAYBACK);
+
+	return HRTIMER_NORESTART;
+}
+
+/*
+ * Enable DMA now so the FIFO is pre-filled and leave only the TXS write
+ * to a hard hrtimer at start_time. Returns false to start immediately.
+ */
+static bool rockchip_sai_start_timed(struct rk_sai_dev *sai)
+{
+	ktime_t t = sai->start_time;
+
+	/* one shot */
+	sai->start_time = 0;
+
+	if (!t || ktime_compare(t, ktime_get_clocktai()) <= 0)
+		return false;
+
+	rockchip_sai_dma_ctrl(sai, SNDRV_PCM_STREAM_PLAYBACK, 1);
+	hrtimer_start(&sai->start_timer, t, HRTIMER_MODE_ABS_HARD);
+
+	return true;
+}
+
 static void rockchip_sai_stop(struct rk_sai_dev *sai, int stream)
 {
 	rockchip_sai_dma_ctrl(sai, stream, 0);
@@ -486,11 +525,16 @@ static int rockchip_sai_trigger(struct snd_pcm_substream *substream,
 	case SNDRV_PCM_TRIGGER_START:
 	case SNDRV_PCM_TRIGGER_RESUME:
 	case SNDRV_PCM_TRIGGER_PAUSE_RELEASE:
-		rockchip_sai_start(sai, substream->stream);
+		if (cmd != SNDRV_PCM_TRIGGER_START ||
+		    substream->stream != SNDRV_PCM_STREAM_PLAYBACK ||
+		    !rockchip_sai_start_timed(sai))
+			rockchip_sai_start(sai, substream->stream);
 		break;
 	case SNDRV_PCM_TRIGGER_SUSPEND:
 	case SNDRV_PCM_TRIGGER_STOP:
 	case SNDRV_PCM_TRIGGER_PAUSE_PUSH:
+		if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+			hrtimer_cancel(&sai->start_timer);
 		rockchip_sai_stop(sai, substream->stream);
 		break;
 	default:
@@ -546,6 +590,11 @@ static void rockchip_sai_shutdown(struct snd_pcm_substream *substream,
 {
 	struct rk_sai_dev *sai = snd_soc_dai_get_drvdata(dai);
 
+	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
+		hrtimer_cancel(&sai->start_timer);
+		sai->start_time = 0;
+	}
+
 	sai->substreams[substream->stream] = NULL;
 }
 
@@ -970,6 +1019,47 @@ static int rockchip_sai_rx_lanes_put(struct snd_kcontrol *kcontrol,
 	return 1;
 }
 
+static int rockchip_sai_start_time_info(struct snd_kcontrol *kcontrol,
+					struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER64;
+	uinfo->count = 1;
+	uinfo->value.integer64.min = 0;
+	uinfo->value.integer64.max = S64_MAX;
+	uinfo->value.integer64.step = 1;
+
+	return 0;
+}
+
+static int rockchip_sai_start_time_get(struct snd_kcontrol *kcontrol,
+				       struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rk_sai_dev *sai = snd_soc_component_get_drvdata(component);
+
+	ucontrol->value.integer64.value[0] = ktime_to_ns(sai->start_time);
+
+	return 0;
+}
+
+static int rockchip_sai_start_time_put(struct snd_kcontrol *kcontrol,
+				       struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rk_sai_dev *sai = snd_soc_component_get_drvdata(component);
+	s64 val = ucontrol->value.integer64.value[0];
+
+	if (val < 0)
+		return -EINVAL;
+
+	if (val == ktime_to_ns(sai->start_time))
+		return 0;
+
+	sai->start_time = ns_to_ktime(val);
+
+	return 1;
+}
+
 static DECLARE_TLV_DB_SCALE(fs_shift_tlv, 0, 8192, 0);
 
 static const struct snd_kcontrol_new rockchip_sai_controls[] = {
@@ -1028,12 +1118,192 @@ static const struct snd_kcontrol_new rockchip_sai_controls[] = {
 		       0, 8192, 0, fs_shift_tlv),
 	SOC_SINGLE_TLV("Receive Frame Shift Select", SAI_RX_SHIFT,
 		       0, 8192, 0, fs_shift_tlv),
+
+	/* CLOCK_TAI nsecs the next playback start is held until */
+	{
+		.iface = SNDRV_CTL_ELEM_IFACE_MIXER,
+		.name = "Transmit Start Time In NS",
+		.info = rockchip_sai_start_time_info,
+		.get = rockchip_sai_start_time_get,
+		.put = rockchip_sai_start_time_put,
+	},
 };
 
+/*
+ * Playback channel map
+ *
+ * The SDOx pins are wired for the ALSA standard layout of the stream
+ * (SDO0 FL/FR, SDO1 RL/RR, SDO2 FC/LFE, SDO3 SL/SR). Writing another
+ * order programs the TX PATH_SEL so each stereo pair of the data goes
+ * to the pin wired for it, which the hardware can do for whole pairs:
+ * the two channels inside a pair keep their order.
+ */
+static const struct snd_pcm_chmap_elem *
+rockchip_sai_chmap_wired(struct rk_sai_dev *sai,
+			 struct snd_pcm_substream *substream,
+			 unsigned int *lanes)
+{
+	const struct snd_pcm_chmap_elem *map;
+	unsigned int channels, val;
+
+	if (!substream->runtime || sai->is_tdm)
+		return NULL;
+
+	channels = substream->runtime->channels;
+	regmap_read(sai->regmap, SAI_TXCR, &val);
+	*lanes = SAI_XCR_CSR_V(val);
+	if (channels != *lanes * 2)
+		return NULL;
+
+	for (map = snd_pcm_std_chmaps; map->channels; map++)
+		if (map->channels == channels)
+			return map;
+
+	return NULL;
+}
+
+static int rockchip_sai_chmap_get(struct snd_kcontrol *kcontrol,
+				  struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_pcm_chmap *info = snd_kcontrol_chip(kcontrol);
+	struct rk_sai_dev *sai = info->private_data;
+	unsigned int idx = snd_ctl_get_ioffidx(kcontrol, &ucontrol->id);
+	const struct snd_pcm_chmap_elem *map;
+	struct snd_pcm_substream *substream;
+	unsigned int lanes, path, sdo, i;
+
+	substream = snd_pcm_chmap_substream(info, idx);
+	if (!substream)
+		return -ENODEV;
+
+	memset(ucontrol->value.integer.value, 0,
+	       sizeof(long) * info->max_channels);
+
+	map = rockchip_sai_chmap_wired(sai, substream, &lanes);
+	if (!map)
+		return 0;
+
+	regmap_read(sai->regmap, SAI_PATH_SEL, &path);
+	for (i = 0; i < lanes; i++) {
+		sdo = SAI_TPATH_V(path, i);
+		if (sdo >= lanes)
+			return 0;
+		ucontrol->value.integer.value[i * 2] = map->map[sdo * 2];
+		ucontrol->value.integer.value[i * 2 + 1] = map->map[sdo * 2 + 1];
+	}
+
+	return 0;
+}
+
+static int rockchip_sai_chmap_put(struct snd_kcontrol *kcontrol,
+				  struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_pcm_chmap *info = snd_kcontrol_chip(kcontrol);
+	struct rk_sai_dev *sai = info->private_data;
+	unsigned int idx = snd_ctl_get_ioffidx(kcontrol, &ucontrol->id);
+	const struct snd_pcm_chmap_elem *map;
+	struct snd_pcm_substream *substream;
+	unsigned int lanes, path = 0, used = 0, i, sdo;
+	long *pos = ucontrol->value.integer.value;
+	bool changed;
+
+	substream = snd_pcm_chmap_substream(info, idx);
+	if (!substream)
+		return -ENODEV;
+
+	map = rockchip_sai_chmap_wired(sai, substream, &lanes);
+	if (!map)
+		return -EBADFD;
+
+	for (i = 0; i < lanes; i++) {
+		for (sdo = 0; sdo < lanes; sdo++)
+			if (map->map[sdo * 2] == pos[i * 2] &&
+			    map->map[sdo * 2 + 1] == pos[i * 2 + 1])
+				break;
+
+		if (sdo == lanes || used & BIT(sdo))
+			return -EINVAL;
+
+		used |= BIT(sdo);
+		path |= SAI_TPATH(i, sdo);
+	}
+
+	regmap_update_bits_check(sai->regmap, SAI_PATH_SEL,
+				 SAI_TPATH_MASK(lanes), path, &changed);
+
+	return changed;
+}
+
+static int rockchip_sai_chmap_tlv(struct snd_kcontrol *kcontrol, int op_flag,
+				  unsigned int size, unsigned int __user *tlv)
+{
+	const struct snd_pcm_chmap_elem *map;
+	unsigned int __user *dst = tlv + 2;
+	unsigned int count = 0, type, c;
+
+	if (size < 8)
+		return -ENOMEM;
+	if (put_user(SNDRV_CTL_TLVT_CONTAINER, tlv))
+		return -EFAULT;
+	size -= 8;
+
+	for (map = snd_pcm_std_chmaps; map->channels; map++) {
+		if (map->channels > SAI_LANES_MAX * 2)
+			continue;
+		if (size < 8 + map->channels * 4)
+			return -ENOMEM;
+
+		type = map->channels > 2 ? SNDRV_CTL_TLVT_CHMAP_PAIRED :
+					   SNDRV_CTL_TLVT_CHMAP_FIXED;
+		if (put_user(type, dst) || put_user(map->channels * 4, dst + 1))
+			return -EFAULT;
+		dst += 2;
+		for (c = 0; c < map->channels; c++, dst++)
+			if (put_user(map->map[c], dst))
+				return -EFAULT;
+
+		size -= 8 + map->channels * 4;
+		count += 8 + map->channels * 4;
+	}
+
+	if (put_user(count, tlv + 1))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int rockchip_sai_pcm_construct(struct snd_soc_component *component,
+				      struct snd_soc_pcm_runtime *rtd)
+{
+	struct rk_sai_dev *sai = snd_soc_component_get_drvdata(component);
+	struct snd_pcm *pcm = rtd->pcm;
+	struct snd_pcm_chmap *info;
+	int i, ret;
+
+	if (!pcm->streams[SNDRV_PCM_STREAM_PLAYBACK].substream_count)
+		return 0;
+
+	ret = snd_pcm_add_chmap_ctls(pcm, SNDRV_PCM_STREAM_PLAYBACK,
+				     snd_pcm_std_chmaps, SAI_LANES_MAX * 2,
+				     0, &info);
+	if (ret < 0)
+		return ret;
+
+	info->private_data = sai;
+	info->kctl->get = rockchip_sai_chmap_get;
+	info->kctl->put = rockchip_sai_chmap_put;
+	info->kctl->tlv.c = rockchip_sai_chmap_tlv;
+	for (i = 0; i < info->kctl->count; i++)
+		info->kctl->vd[i].access |= SNDRV_CTL_ELEM_ACCESS_WRITE;
+
+	return 0;
+}
+
 static const struct snd_soc_component_driver rockchip_sai_component = {
 	.name = DRV_NAME,
 	.controls = rockchip_sai_controls,
 	.num_controls = ARRAY_SIZE(rockchip_sai_controls),
+	.pcm_construct = rockchip_sai_pcm_construct,
 };
 
 static irqreturn_t rockchip_sai_isr(int irq, void *devid)
@@ -1079,6 +1349,8 @@ static int rockchip_sai_probe(struct platform_device *pdev)
 
 	sai->dev = &pdev->dev;
 	sai->fw_ratio = 1;
+	hrtimer_init(&sai->start_timer, CLOCK_TAI, HRTIMER_MODE_ABS_HARD);
+	sai->start_timer.function = rockchip_sai_start_timer;
 	dev_set_drvdata(&pdev->dev, sai);
 
 	sai->rst_h = devm_reset_control_get_optional_exclusive(&pdev->dev, "h");
@@ -1154,6 +1426,9 @@ static int rockchip_sai_probe(struct platform_device *pdev)
 
 static int rockchip_sai_remove(struct platform_device *pdev)
 {
+	struct rk_sai_dev *sai = dev_get_drvdata(&pdev->dev);
+
+	hrtimer_cancel(&sai->start_timer);
 	pm_runtime_disable(&pdev->dev);
 	if (!pm_runtime_status_suspended(&pdev->dev))
 		sai_runtime_suspend(&pdev->dev);
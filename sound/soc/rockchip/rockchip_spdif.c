@@ -16,9 +16,11 @@
 #include <linux/pm_runtime.h>
 #include <linux/mfd/syscon.h>
 #include <linux/regmap.h>
+#include <sound/asoundef.h>
 #include <sound/pcm_params.h>
 #include <sound/pcm_iec958.h>
 #include <sound/dmaengine_pcm.h>
+#include <sound/soc.h>
 
 #include "rockchip_spdif.h"
 
@@ -49,6 +51,16 @@ enum rk_spdif_type {
 
 #define RK3288_GRF_SOC_CON2	0x24c
 
+/* DSD over PCM markers, alternating every frame (DoP v1.1) */
+#define DOP_MARKER_0		0x05
+#define DOP_MARKER_1		0xfa
+
+enum rk_spdif_mode {
+	RK_SPDIF_MODE_PCM,
+	RK_SPDIF_MODE_DOP,
+	RK_SPDIF_MODE_IEC61937,
+};
+
 struct rk_spdif_dev {
 	struct device *dev;
 
@@ -58,6 +70,12 @@ struct rk_spdif_dev {
 	struct snd_dmaengine_dai_dma_data playback_dma_data;
 
 	struct regmap *regmap;
+	/* channel status from "IEC958 Playback Default" */
+	u8 cs[CS_BYTE];
+	enum rk_spdif_mode mode;
+	/* byte of each sample carrying the DoP marker, 0 when not in DoP */
+	unsigned int dop_byte;
+	bool active;
 };
 
 static const struct of_device_id rk_spdif_match[] __maybe_unused = {
@@ -136,7 +154,32 @@ static int rk_spdif_hw_params(struct snd_pcm_substream *substream,
 	u8 cs[CS_BYTE];
 	u16 *fc = (u16 *)cs;
 
-	ret = snd_pcm_create_iec958_consumer_hw_params(params, cs, sizeof(cs));
+	spdif->dop_byte = 0;
+	switch (spdif->mode) {
+	case RK_SPDIF_MODE_DOP:
+		/* the marker sits in bits 23..16 of the 24-bit word */
+		if (params_format(params) == SNDRV_PCM_FORMAT_S24_LE)
+			spdif->dop_byte = 2;
+		else if (params_format(params) == SNDRV_PCM_FORMAT_S32_LE)
+			spdif->dop_byte = 3;
+		else
+			return -EINVAL;
+		break;
+	case RK_SPDIF_MODE_IEC61937:
+		if (params_format(params) != SNDRV_PCM_FORMAT_S16_LE)
+			return -EINVAL;
+		break;
+	default:
+		break;
+	}
+
+	memcpy(cs, spdif->cs, sizeof(cs));
+	if (spdif->mode == RK_SPDIF_MODE_IEC61937)
+		cs[0] |= IEC958_AES0_NONAUDIO;
+	else
+		cs[0] &= ~IEC958_AES0_NONAUDIO;
+
+	ret = snd_pcm_fill_iec958_consumer_hw_params(params, cs, sizeof(cs));
 	if (ret < 0)
 		return ret;
 
@@ -228,6 +271,39 @@ static int rk_spdif_trigger(struct snd_pcm_substream *substream,
 	return ret;
 }
 
+static int rk_spdif_startup(struct snd_pcm_substream *substream,
+			    struct snd_soc_dai *dai)
+{
+	struct rk_spdif_dev *spdif = snd_soc_dai_get_drvdata(dai);
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	int ret;
+
+	spdif->active = true;
+	if (spdif->mode != RK_SPDIF_MODE_DOP)
+		return 0;
+
+	/*
+	 * Markers are written while the data is copied in, so mmap would
+	 * skip them, and an even buffer keeps their phase across wraps.
+	 */
+	ret = snd_pcm_hw_constraint_mask(runtime, SNDRV_PCM_HW_PARAM_ACCESS,
+					 1 << SNDRV_PCM_ACCESS_RW_INTERLEAVED);
+	if (ret < 0)
+		return ret;
+
+	return snd_pcm_hw_constraint_step(runtime, 0,
+					  SNDRV_PCM_HW_PARAM_BUFFER_SIZE, 2);
+}
+
+static void rk_spdif_shutdown(struct snd_pcm_substream *substream,
+			      struct snd_soc_dai *dai)
+{
+	struct rk_spdif_dev *spdif = snd_soc_dai_get_drvdata(dai);
+
+	spdif->active = false;
+	spdif->dop_byte = 0;
+}
+
 static int rk_spdif_dai_probe(struct snd_soc_dai *dai)
 {
 	struct rk_spdif_dev *spdif = snd_soc_dai_get_drvdata(dai);
@@ -254,6 +330,8 @@ static int rk_spdif_set_sysclk(struct snd_soc_dai *dai,
 }
 
 static const struct snd_soc_dai_ops rk_spdif_dai_ops = {
+	.startup = rk_spdif_startup,
+	.shutdown = rk_spdif_shutdown,
 	.set_sysclk = rk_spdif_set_sysclk,
 	.hw_params = rk_spdif_hw_params,
 	.trigger = rk_spdif_trigger,
@@ -274,8 +352,150 @@ static struct snd_soc_dai_driver rk_spdif_dai = {
 	.ops = &rk_spdif_dai_ops,
 };
 
+static int rk_spdif_iec958_info(struct snd_kcontrol *kcontrol,
+				struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_IEC958;
+	uinfo->count = 1;
+
+	return 0;
+}
+
+static int rk_spdif_iec958_default_get(struct snd_kcontrol *kcontrol,
+				       struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rk_spdif_dev *spdif = snd_soc_component_get_drvdata(component);
+
+	memcpy(ucontrol->value.iec958.status, spdif->cs, sizeof(spdif->cs));
+
+	return 0;
+}
+
+static int rk_spdif_iec958_default_put(struct snd_kcontrol *kcontrol,
+				       struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rk_spdif_dev *spdif = snd_soc_component_get_drvdata(component);
+
+	if (!memcmp(spdif->cs, ucontrol->value.iec958.status, sizeof(spdif->cs)))
+		return 0;
+
+	/* takes effect at the next hw_params */
+	memcpy(spdif->cs, ucontrol->value.iec958.status, sizeof(spdif->cs));
+
+	return 1;
+}
+
+static int rk_spdif_iec958_mask_get(struct snd_kcontrol *kcontrol,
+				    struct snd_ctl_elem_value *ucontrol)
+{
+	memset(ucontrol->value.iec958.status, 0xff, CS_BYTE);
+
+	return 0;
+}
+
+static const char * const rk_spdif_mode_text[] = {
+	[RK_SPDIF_MODE_PCM] = "PCM",
+	[RK_SPDIF_MODE_DOP] = "DoP",
+	[RK_SPDIF_MODE_IEC61937] = "IEC61937",
+};
+
+static SOC_ENUM_SINGLE_EXT_DECL(rk_spdif_mode_enum, rk_spdif_mode_text);
+
+static int rk_spdif_mode_get(struct snd_kcontrol *kcontrol,
+			     struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rk_spdif_dev *spdif = snd_soc_component_get_drvdata(component);
+
+	ucontrol->value.enumerated.item[0] = spdif->mode;
+
+	return 0;
+}
+
+static int rk_spdif_mode_put(struct snd_kcontrol *kcontrol,
+			     struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rk_spdif_dev *spdif = snd_soc_component_get_drvdata(component);
+	unsigned int mode = ucontrol->value.enumerated.item[0];
+
+	if (mode > RK_SPDIF_MODE_IEC61937)
+		return -EINVAL;
+
+	if (mode == spdif->mode)
+		return 0;
+
+	/* the mode shapes the constraints applied at open */
+	if (spdif->active)
+		return -EBUSY;
+
+	spdif->mode = mode;
+
+	return 1;
+}
+
+static const struct snd_kcontrol_new rk_spdif_controls[] = {
+	{
+		.iface = SNDRV_CTL_ELEM_IFACE_PCM,
+		.name = SNDRV_CTL_NAME_IEC958("", PLAYBACK, DEFAULT),
+		.info = rk_spdif_iec958_info,
+		.get = rk_spdif_iec958_default_get,
+		.put = rk_spdif_iec958_default_put,
+	},
+	{
+		.access = SNDRV_CTL_ELEM_ACCESS_READ,
+		.iface = SNDRV_CTL_ELEM_IFACE_PCM,
+		.name = SNDRV_CTL_NAME_IEC958("", PLAYBACK, CON_MASK),
+		.info = rk_spdif_iec958_info,
+		.get = rk_spdif_iec958_mask_get,
+	},
+	SOC_ENUM_EXT("SPDIF Transmit Mode", rk_spdif_mode_enum,
+		     rk_spdif_mode_get, rk_spdif_mode_put),
+};
+
 static const struct snd_soc_component_driver rk_spdif_component = {
 	.name = "rockchip-spdif",
+	.controls = rk_spdif_controls,
+	.num_controls = ARRAY_SIZE(rk_spdif_controls),
+};
+
+/*
+ * Stamp the DoP marker into every sample as it is copied into the DMA
+ * buffer, so players can hand over the DSD bits in a plain 24-bit
+ * container without a framing pass of their own.
+ */
+static int rk_spdif_process(struct snd_pcm_substream *substream,
+			    int channel, unsigned long hwoff,
+			    void *buf, unsigned long bytes)
+{
+	struct snd_soc_pcm_runtime *rtd = asoc_substream_to_rtd(substream);
+	struct rk_spdif_dev *spdif =
+		snd_soc_dai_get_drvdata(asoc_rtd_to_cpu(rtd, 0));
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	unsigned int frame_bytes = frames_to_bytes(runtime, 1);
+	unsigned long frame = hwoff / frame_bytes;
+	u8 *p = runtime->dma_area + hwoff + spdif->dop_byte;
+	u8 *end = runtime->dma_area + hwoff + bytes;
+	u8 marker;
+
+	if (!spdif->dop_byte)
+		return 0;
+
+	/* both subframes of a frame carry the same marker */
+	for (; p < end; p += frame_bytes, frame++) {
+		marker = (frame & 1) ? DOP_MARKER_1 : DOP_MARKER_0;
+		p[0] = marker;
+		p[4] = marker;
+	}
+
+	return 0;
+}
+
+static const struct snd_dmaengine_pcm_config rk_spdif_dmaengine_config = {
+	.prepare_slave_config = snd_dmaengine_pcm_prepare_slave_config,
+	.process = rk_spdif_process,
 };
 
 static bool rk_spdif_wr_reg(struct device *dev, unsigned int reg)
@@ -388,6 +608,7 @@ static int rk_spdif_probe(struct platform_device *pdev)
 	spdif->playback_dma_data.maxburst = 4;
 
 	spdif->dev = &pdev->dev;
+	snd_pcm_create_iec958_consumer_default(spdif->cs, sizeof(spdif->cs));
 	dev_set_drvdata(&pdev->dev, spdif);
 
 	pm_runtime_enable(&pdev->dev);
@@ -405,7 +626,8 @@ static int rk_spdif_probe(struct platform_device *pdev)
 		goto err_pm_suspend;
 	}
 
-	ret = devm_snd_dmaengine_pcm_register(&pdev->dev, NULL, 0);
+	ret = devm_snd_dmaengine_pcm_register(&pdev->dev,
+					      &rk_spdif_dmaengine_config, 0);
 	if (ret) {
 		dev_err(&pdev->dev, "Could not register PCM\n");
 		goto err_pm_suspend;
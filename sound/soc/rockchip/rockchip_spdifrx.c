@@ -14,8 +14,11 @@
 #include <linux/mfd/syscon.h>
 #include <linux/regmap.h>
 #include <linux/reset.h>
+#include <sound/asoundef.h>
+#include <sound/control.h>
 #include <sound/pcm_params.h>
 #include <sound/dmaengine_pcm.h>
+#include <sound/soc.h>
 
 #include "rockchip_spdifrx.h"
 
@@ -27,6 +30,14 @@ struct rk_spdifrx_dev {
 	struct regmap *regmap;
 	struct reset_control *reset;
 	int irq;
+	/* protects substream against the irq thread */
+	spinlock_t lock;
+	struct snd_pcm_substream *substream;
+	struct snd_card *card;
+	struct snd_kcontrol *rate_kctl;
+	struct snd_kcontrol *lock_kctl;
+	unsigned int rate;
+	bool locked;
 };
 
 static int rk_spdifrx_runtime_suspend(struct device *dev)
@@ -129,22 +140,121 @@ static int rk_spdifrx_trigger(struct snd_pcm_substream *substream,
 	return ret;
 }
 
+static int rk_spdifrx_rate_info(struct snd_kcontrol *kcontrol,
+				struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER;
+	uinfo->count = 1;
+	uinfo->value.integer.min = 0;
+	uinfo->value.integer.max = 192000;
+
+	return 0;
+}
+
+static int rk_spdifrx_rate_get(struct snd_kcontrol *kcontrol,
+			       struct snd_ctl_elem_value *ucontrol)
+{
+	struct rk_spdifrx_dev *spdifrx = snd_kcontrol_chip(kcontrol);
+
+	ucontrol->value.integer.value[0] = spdifrx->rate;
+
+	return 0;
+}
+
+static int rk_spdifrx_lock_get(struct snd_kcontrol *kcontrol,
+			       struct snd_ctl_elem_value *ucontrol)
+{
+	struct rk_spdifrx_dev *spdifrx = snd_kcontrol_chip(kcontrol);
+
+	ucontrol->value.integer.value[0] = spdifrx->locked;
+
+	return 0;
+}
+
+static const struct snd_kcontrol_new rk_spdifrx_rate_control = {
+	.iface = SNDRV_CTL_ELEM_IFACE_PCM,
+	.name = "SPDIFRX Rate",
+	.access = SNDRV_CTL_ELEM_ACCESS_READ | SNDRV_CTL_ELEM_ACCESS_VOLATILE,
+	.info = rk_spdifrx_rate_info,
+	.get = rk_spdifrx_rate_get,
+};
+
+static const struct snd_kcontrol_new rk_spdifrx_lock_control = {
+	.iface = SNDRV_CTL_ELEM_IFACE_PCM,
+	.name = "SPDIFRX Lock Status",
+	.access = SNDRV_CTL_ELEM_ACCESS_READ | SNDRV_CTL_ELEM_ACCESS_VOLATILE,
+	.info = snd_ctl_boolean_mono_info,
+	.get = rk_spdifrx_lock_get,
+};
+
 static int rk_spdifrx_dai_probe(struct snd_soc_dai *dai)
 {
 	struct rk_spdifrx_dev *spdifrx = snd_soc_dai_get_drvdata(dai);
+	struct snd_card *card = dai->component->card->snd_card;
+	int ret;
 
 	dai->capture_dma_data = &spdifrx->capture_dma_data;
 
+	/* kept so the irq thread can notify rate and lock changes */
+	spdifrx->rate_kctl = snd_ctl_new1(&rk_spdifrx_rate_control, spdifrx);
+	ret = snd_ctl_add(card, spdifrx->rate_kctl);
+	if (ret < 0)
+		return ret;
+
+	spdifrx->lock_kctl = snd_ctl_new1(&rk_spdifrx_lock_control, spdifrx);
+	ret = snd_ctl_add(card, spdifrx->lock_kctl);
+	if (ret < 0)
+		return ret;
+
+	spdifrx->card = card;
+
 	return 0;
 }
 
+static int rk_spdifrx_dai_remove(struct snd_soc_dai *dai)
+{
+	struct rk_spdifrx_dev *spdifrx = snd_soc_dai_get_drvdata(dai);
+
+	/* the controls go away with the card */
+	spdifrx->card = NULL;
+	spdifrx->rate_kctl = NULL;
+	spdifrx->lock_kctl = NULL;
+
+	return 0;
+}
+
+static int rk_spdifrx_startup(struct snd_pcm_substream *substream,
+			      struct snd_soc_dai *dai)
+{
+	struct rk_spdifrx_dev *spdifrx = snd_soc_dai_get_drvdata(dai);
+
+	spin_lock_irq(&spdifrx->lock);
+	spdifrx->substream = substream;
+	spin_unlock_irq(&spdifrx->lock);
+
+	return 0;
+}
+
+static void rk_spdifrx_shutdown(struct snd_pcm_substream *substream,
+				struct snd_soc_dai *dai)
+{
+	struct rk_spdifrx_dev *spdifrx = snd_soc_dai_get_drvdata(dai);
+
+	spin_lock_irq(&spdifrx->lock);
+	spdifrx->substream = NULL;
+	spin_unlock_irq(&spdifrx->lock);
+}
+
 static const struct snd_soc_dai_ops rk_spdifrx_dai_ops = {
+	.startup = rk_spdifrx_startup,
+	.shutdown = rk_spdifrx_shutdown,
 	.hw_params = rk_spdifrx_hw_params,
 	.trigger = rk_spdifrx_trigger,
 };
 
 static struct snd_soc_dai_driver rk_spdifrx_dai = {
 	.probe = rk_spdifrx_dai_probe,
+	.remove = rk_spdifrx_dai_remove,
 	.capture = {
 		.stream_name = "Capture",
 		.channels_min = 2,
@@ -200,6 +310,7 @@ static bool rk_spdifrx_rd_reg(struct device *dev, unsigned int reg)
 	case SPDIFRX_INTSR:
 	case SPDIFRX_INTCLR:
 	case SPDIFRX_SMPDR:
+	case SPDIFRX_CHNSRn(0) ... SPDIFRX_CHNSRn(11):
 	case SPDIFRX_BURSTINFO:
 		return true;
 	default:
@@ -217,6 +328,7 @@ static bool rk_spdifrx_volatile_reg(struct device *dev, unsigned int reg)
 	case SPDIFRX_INTSR:
 	case SPDIFRX_INTCLR:
 	case SPDIFRX_SMPDR:
+	case SPDIFRX_CHNSRn(0) ... SPDIFRX_CHNSRn(11):
 	case SPDIFRX_BURSTINFO:
 		return true;
 	default:
@@ -246,21 +358,90 @@ static const struct regmap_config rk_spdifrx_regmap_config = {
 	.cache_type = REGCACHE_FLAT,
 };
 
+/* sample rate from byte 3 of the received channel status, 0 if unknown */
+static unsigned int rk_spdifrx_get_rate(struct rk_spdifrx_dev *spdifrx)
+{
+	unsigned int val;
+
+	/* each register holds two status bytes, as on the transmitter */
+	regmap_read(spdifrx->regmap, SPDIFRX_CHNSRn(1), &val);
+
+	switch ((val >> 8) & IEC958_AES3_CON_FS) {
+	case IEC958_AES3_CON_FS_32000:
+		return 32000;
+	case IEC958_AES3_CON_FS_44100:
+		return 44100;
+	case IEC958_AES3_CON_FS_48000:
+		return 48000;
+	case IEC958_AES3_CON_FS_88200:
+		return 88200;
+	case IEC958_AES3_CON_FS_96000:
+		return 96000;
+	case IEC958_AES3_CON_FS_176400:
+		return 176400;
+	case IEC958_AES3_CON_FS_192000:
+		return 192000;
+	default:
+		return 0;
+	}
+}
+
+static void rk_spdifrx_notify(struct rk_spdifrx_dev *spdifrx,
+			      struct snd_kcontrol *kctl)
+{
+	if (spdifrx->card && kctl)
+		snd_ctl_notify(spdifrx->card, SNDRV_CTL_EVENT_MASK_VALUE,
+			       &kctl->id);
+}
+
 static irqreturn_t rk_spdifrx_isr(int irq, void *dev_id)
 {
 	struct rk_spdifrx_dev *spdifrx = dev_id;
+	struct snd_pcm_substream *substream;
+	unsigned int rate;
 	u32 intsr;
 
 	regmap_read(spdifrx->regmap, SPDIFRX_INTSR, &intsr);
 
-	if (intsr & BIT(7)) {
+	if (intsr & SPDIFRX_INTSR_NSYNCISR_ACTIVE) {
 		dev_dbg(spdifrx->dev, "NSYNC\n");
-		regmap_write(spdifrx->regmap, SPDIFRX_INTCLR, BIT(7));
+		regmap_write(spdifrx->regmap, SPDIFRX_INTCLR,
+			     SPDIFRX_INTCLR_NSYNCICLR);
+		/* restart the sync search, DMA keeps running meanwhile */
+		regmap_write(spdifrx->regmap, SPDIFRX_CLR, SPDIFRX_CLR_RXSC);
+		if (spdifrx->locked) {
+			spdifrx->locked = false;
+			rk_spdifrx_notify(spdifrx, spdifrx->lock_kctl);
+		}
 	}
 
-	if (intsr & BIT(9)) {
+	if (intsr & SPDIFRX_INTSR_SYNCISR_ACTIVE) {
 		dev_dbg(spdifrx->dev, "SYNC\n");
-		regmap_write(spdifrx->regmap, SPDIFRX_INTCLR, BIT(9));
+		regmap_write(spdifrx->regmap, SPDIFRX_INTCLR,
+			     SPDIFRX_INTCLR_SYNCICLR);
+		if (!spdifrx->locked) {
+			spdifrx->locked = true;
+			rk_spdifrx_notify(spdifrx, spdifrx->lock_kctl);
+		}
+
+		rate = rk_spdifrx_get_rate(spdifrx);
+		if (rate != spdifrx->rate) {
+			dev_dbg(spdifrx->dev, "rate %u -> %u\n",
+				spdifrx->rate, rate);
+			spdifrx->rate = rate;
+			rk_spdifrx_notify(spdifrx, spdifrx->rate_kctl);
+
+			/*
+			 * The stream no longer matches the input, stop it so
+			 * the reader re-runs hw_params at "SPDIFRX Rate".
+			 */
+			spin_lock_irq(&spdifrx->lock);
+			substream = spdifrx->substream;
+			if (rate && substream && substream->runtime &&
+			    substream->runtime->rate != rate)
+				snd_pcm_stop_xrun(substream);
+			spin_unlock_irq(&spdifrx->lock);
+		}
 	}
 
 	return IRQ_HANDLED;
@@ -277,6 +458,8 @@ static int rk_spdifrx_probe(struct platform_device *pdev)
 	if (!spdifrx)
 		return -ENOMEM;
 
+	spin_lock_init(&spdifrx->lock);
+
 	spdifrx->reset = devm_reset_control_get(&pdev->dev, "spdifrx-m");
 	if (IS_ERR(spdifrx->reset)) {
 		ret = PTR_ERR(spdifrx->reset);
@@ -108,6 +108,7 @@
 #define SPDIFRX_SMPDR			(0x002C)
 #define SPDIFRX_USRDRN			(0x0030)
 #define SPDIFRX_CHNSRN			(0x0060)
+#define SPDIFRX_CHNSRn(x)		(SPDIFRX_CHNSRN + (x) * 4)
 #define SPDIFRX_BURSTINFO		(0x0100)
 
 #endif /* _ROCKCHIP_SPDIFRX_H */
@@ -11,13 +11,20 @@
 #include <linux/clk.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
 #include <linux/of_device.h>
 #include <linux/of_address.h>
 #include <linux/pm_runtime.h>
 #include <linux/regmap.h>
+#include <linux/rk-vad.h>
 #include <sound/pcm.h>
 #include <sound/pcm_params.h>
 #include <sound/soc.h>
+#ifdef CONFIG_KERNEL_MODE_NEON
+#include <asm/neon.h>
+#include <asm/simd.h>
+#endif
 
 #include "rockchip_vad.h"
 #include "rockchip_multi_dais.h"
@@ -37,6 +44,15 @@ static struct snd_pcm_substream *vad_substream;
 static unsigned int voice_inactive_frames;
 module_param(voice_inactive_frames, uint, 0644);
 MODULE_PARM_DESC(voice_inactive_frames, "voice inactive frame count");
+static unsigned int vad_mc_features;
+module_param(vad_mc_features, uint, 0644);
+MODULE_PARM_DESC(vad_mc_features, "all channel gating features, bit0: energy, bit1: zero crossing");
+static unsigned int vad_mc_rms_thd = 512;
+module_param(vad_mc_rms_thd, uint, 0644);
+MODULE_PARM_DESC(vad_mc_rms_thd, "min channel rms of a voiced period, in 16bit sample units");
+static unsigned int vad_mc_zcr_max = 250;
+module_param(vad_mc_zcr_max, uint, 0644);
+MODULE_PARM_DESC(vad_mc_zcr_max, "max channel zero crossings per 1000 samples of a voiced period");
 
 enum rk_vad_version {
 	VAD_RK1808ES = 1,
@@ -87,6 +103,7 @@ struct rockchip_vad {
 	u32 sample_bytes;
 	u32 buffer_time; /* msec */
 	struct dentry *debugfs_dir;
+	struct miscdevice miscdev;
 	void *buf;
 	bool acodec_cfg;
 	bool vswitch;
@@ -155,6 +172,15 @@ static int vad_buffer_sort(struct rockchip_vad *vad)
 	return 0;
 }
 
+/* advance the read cursor of the ring, wrapping at the end */
+static void vad_ring_consume(struct vad_buf *vbuf, int bytes)
+{
+	vbuf->pos += bytes;
+	if (vbuf->loop && vbuf->pos >= vbuf->end)
+		vbuf->pos = vbuf->begin + (vbuf->pos - vbuf->end);
+	vbuf->size -= bytes;
+}
+
 static int rockchip_vad_stop(struct rockchip_vad *vad)
 {
 	unsigned int val, frames;
@@ -379,11 +405,82 @@ snd_pcm_sframes_t snd_pcm_vad_read(struct snd_pcm_substream *substream,
 }
 EXPORT_SYMBOL(snd_pcm_vad_read);
 
+/* the first channels of a frame holding total samples, step s16 apart */
+static void vad_mc_features_c(const s16 *buf, int frames, int channels,
+			      int total, int step, u64 *energy, u32 *zcr)
+{
+	int f, c;
+
+	for (f = 0; f < frames; f++) {
+		for (c = 0; c < channels; c++) {
+			s16 cur = buf[(f * total + c) * step];
+
+			energy[c] += cur * cur;
+			if (f)
+				zcr[c] += (cur ^ buf[((f - 1) * total + c) * step]) < 0;
+		}
+	}
+}
+
+/*
+ * Gate on every channel of the stream, not only on audio_chnl that the
+ * preprocess above follows: the period counts as voice if any channel
+ * passes all the features enabled in vad_mc_features.
+ */
+static bool rockchip_vad_mc_active(struct rockchip_vad *vad,
+				   struct snd_pcm_runtime *runtime,
+				   void *buf, snd_pcm_uframes_t size)
+{
+	int channels = min_t(int, runtime->channels, VAD_MC_MAX_CHANNELS);
+	u64 energy[VAD_MC_MAX_CHANNELS] = { 0 };
+	u32 zcr[VAD_MC_MAX_CHANNELS] = { 0 };
+	int step, i;
+
+	if (!size)
+		return false;
+
+	switch (runtime->sample_bits) {
+	case 16:
+		step = 1;
+		break;
+	case 32:
+		step = 2;
+		if (vad->h_16bit)
+			buf += 2;
+		break;
+	default:
+		return false;
+	}
+
+#ifdef CONFIG_KERNEL_MODE_NEON
+	if (channels == runtime->channels && !(8 % channels) && may_use_simd()) {
+		kernel_neon_begin();
+		vad_mc_features_neon(buf, size, channels, step, energy, zcr);
+		kernel_neon_end();
+	} else
+#endif
+		vad_mc_features_c(buf, size, channels, runtime->channels, step,
+				  energy, zcr);
+
+	for (i = 0; i < channels; i++) {
+		if ((vad_mc_features & VAD_MC_FEAT_ENERGY) &&
+		    int_sqrt64(div_u64(energy[i], size)) < vad_mc_rms_thd)
+			continue;
+		if ((vad_mc_features & VAD_MC_FEAT_ZCR) &&
+		    div_u64((u64)zcr[i] * 1000, size) > vad_mc_zcr_max)
+			continue;
+		return true;
+	}
+
+	return false;
+}
+
 int snd_pcm_vad_preprocess(struct snd_pcm_substream *substream,
 			   void *buf, snd_pcm_uframes_t size)
 {
 	struct snd_pcm_runtime *runtime = substream->runtime;
 	struct rockchip_vad *vad = NULL;
+	bool mc_active = false;
 	unsigned int i;
 	s16 *data;
 
@@ -392,6 +489,9 @@ int snd_pcm_vad_preprocess(struct snd_pcm_substream *substream,
 	if (!vad)
 		return 0;
 
+	if (vad_mc_features)
+		mc_active = rockchip_vad_mc_active(vad, runtime, buf, size);
+
 	buf += samples_to_bytes(runtime, vad->audio_chnl);
 	/* retrieve the high 16bit data */
 	if (runtime->sample_bits == 32 && vad->h_16bit)
@@ -405,6 +505,9 @@ int snd_pcm_vad_preprocess(struct snd_pcm_substream *substream,
 		buf += frames_to_bytes(runtime, 1);
 	}
 
+	if (mc_active)
+		voice_inactive_frames = 0;
+
 	vad_preprocess_update_params(&vad->uparams);
 	return 0;
 }
@@ -499,31 +602,23 @@ snd_pcm_sframes_t snd_pcm_vad_memcpy(struct snd_pcm_substream *substream,
 	vbytes = vframe_sz * avail;
 
 	memset(buf, 0x0, bytes);
-	if (!vbuf->loop) {
+	if (!vbuf->loop || (vbuf->pos + vbytes) <= vbuf->end) {
 		vad_memcpy_fromio(buf, vbuf->pos, vbytes,
 				  vframe_sz, padding_sz);
-		vbuf->pos += vbytes;
 	} else {
-		if ((vbuf->pos + vbytes) <= vbuf->end) {
-			vad_memcpy_fromio(buf, vbuf->pos, vbytes,
-					  vframe_sz, padding_sz);
-			vbuf->pos += vbytes;
-		} else {
-			int part1 = vbuf->end - vbuf->pos;
-			int part2 = vbytes - part1;
-			int offset = part1;
-
-			if (padding_sz)
-				offset = part1 / vframe_sz * frame_sz;
-			vad_memcpy_fromio(buf, vbuf->pos, part1,
-					  vframe_sz, padding_sz);
-			vad_memcpy_fromio(buf + offset, vbuf->begin, part2,
-					  vframe_sz, padding_sz);
-			vbuf->pos = vbuf->begin + part2;
-		}
+		int part1 = vbuf->end - vbuf->pos;
+		int part2 = vbytes - part1;
+		int offset = part1;
+
+		if (padding_sz)
+			offset = part1 / vframe_sz * frame_sz;
+		vad_memcpy_fromio(buf, vbuf->pos, part1,
+				  vframe_sz, padding_sz);
+		vad_memcpy_fromio(buf + offset, vbuf->begin, part2,
+				  vframe_sz, padding_sz);
 	}
 
-	vbuf->size -= vbytes;
+	vad_ring_consume(vbuf, vbytes);
 
 	return avail;
 }
@@ -1117,6 +1212,82 @@ static const struct file_operations rockchip_vad_reg_debugfs_fops = {
 };
 #endif
 
+/*
+ * /dev/vad: read-only mmap of the VAD SRAM plus ioctls to fetch and move
+ * the ring read cursor, so the keyword engine can consume pre-roll audio
+ * in place. It shares the cursor with snd_pcm_vad_read()/_memcpy(), so
+ * a reader should use one path or the other.
+ */
+static struct rockchip_vad *file_to_vad(struct file *file)
+{
+	struct miscdevice *misc = file->private_data;
+
+	return container_of(misc, struct rockchip_vad, miscdev);
+}
+
+static int rockchip_vad_ring_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct rockchip_vad *vad = file_to_vad(file);
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+
+	return vm_iomap_memory(vma, vad->memphy,
+			       vad->memphy_end + 0x8 - vad->memphy);
+}
+
+static long rockchip_vad_ring_ioctl(struct file *file, unsigned int cmd,
+				    unsigned long arg)
+{
+	struct rockchip_vad *vad = file_to_vad(file);
+	struct vad_buf *vbuf = &vad->vbuf;
+	struct vad_ring_info info;
+	u32 bytes, frame_bytes;
+
+	frame_bytes = vad->channels * vad->sample_bytes;
+
+	switch (cmd) {
+	case VAD_IOC_RING_GET:
+		/* RK1808ES stores chunks rotated, once per wakeup */
+		if (vad_buffer_sort(vad) < 0)
+			return -EFAULT;
+
+		memset(&info, 0, sizeof(info));
+		info.begin = vbuf->begin - vad->membase;
+		info.end = vbuf->end - vad->membase;
+		info.pos = vbuf->pos - vad->membase;
+		info.avail = vbuf->size > 0 ? vbuf->size : 0;
+		info.frame_bytes = frame_bytes;
+		info.map_size = vad->memphy_end + 0x8 - vad->memphy;
+
+		if (copy_to_user((void __user *)arg, &info, sizeof(info)))
+			return -EFAULT;
+		return 0;
+	case VAD_IOC_RING_CONSUME:
+		if (get_user(bytes, (u32 __user *)arg))
+			return -EFAULT;
+		if (!frame_bytes || bytes % frame_bytes ||
+		    vbuf->size <= 0 || bytes > vbuf->size)
+			return -EINVAL;
+
+		vad_ring_consume(vbuf, bytes);
+		return 0;
+	default:
+		return -ENOTTY;
+	}
+}
+
+static const struct file_operations rockchip_vad_ring_fops = {
+	.owner = THIS_MODULE,
+	.mmap = rockchip_vad_ring_mmap,
+	.unlocked_ioctl = rockchip_vad_ring_ioctl,
+	.compat_ioctl = compat_ptr_ioctl,
+	.llseek = noop_llseek,
+};
+
 static void rockchip_vad_init(struct rockchip_vad *vad)
 {
 	unsigned int val, mask;
@@ -1285,6 +1456,16 @@ static int rockchip_vad_probe(struct platform_device *pdev)
 	if (ret)
 		goto err;
 
+	vad->miscdev.minor = MISC_DYNAMIC_MINOR;
+	vad->miscdev.name = "vad";
+	vad->miscdev.fops = &rockchip_vad_ring_fops;
+	vad->miscdev.parent = &pdev->dev;
+	ret = misc_register(&vad->miscdev);
+	if (ret) {
+		snd_soc_unregister_component(&pdev->dev);
+		goto err;
+	}
+
 	of_node_put(sram_np);
 
 	return 0;
@@ -1300,6 +1481,7 @@ static int rockchip_vad_remove(struct platform_device *pdev)
 {
 	struct rockchip_vad *vad = dev_get_drvdata(&pdev->dev);
 
+	misc_deregister(&vad->miscdev);
 	if (!IS_ERR(vad->hclk))
 		clk_disable_unprepare(vad->hclk);
 	of_node_put(vad->audio_node);
@@ -26,4 +26,14 @@ void vad_preprocess_destroy(void);
 void vad_preprocess_update_params(struct vad_uparams *uparams);
 int vad_preprocess(int data);
 
+/* per channel features over a period, see snd_pcm_vad_preprocess() */
+#define VAD_MC_FEAT_ENERGY	BIT(0)
+#define VAD_MC_FEAT_ZCR		BIT(1)
+#define VAD_MC_MAX_CHANNELS	16
+
+#ifdef CONFIG_KERNEL_MODE_NEON
+void vad_mc_features_neon(const s16 *buf, int frames, int channels,
+			  int step, u64 *energy, u32 *zcr);
+#endif
+
 #endif
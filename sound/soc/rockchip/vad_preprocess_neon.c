@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Rockchip VAD Preprocess, NEON multi-channel features
+ *
+ * Copyright (C) 2026 Rockchip Electronics Co., Ltd.
+ *
+ * Built with the NEON compiler flags, so only compiler headers here: the
+ * prototype lives in vad_preprocess.h and must be called between
+ * kernel_neon_begin() and kernel_neon_end().
+ */
+
+#ifdef CONFIG_ARM64
+#include <asm/neon-intrinsics.h>
+#else
+#include <arm_neon.h>
+#endif
+
+void vad_mc_features_neon(const int16_t *buf, int frames, int channels,
+			  int step, uint64_t *energy, uint32_t *zcr);
+
+static inline int16x8_t vad_ld(const int16_t *p, int step)
+{
+	if (step == 2)
+		return vld2q_s16(p).val[0];
+
+	return vld1q_s16(p);
+}
+
+/*
+ * Sample j of the interleaved stream is buf[j * step], channel j % channels.
+ * With channels 1, 2, 4 or 8 and j a multiple of channels, lane l of an
+ * eight sample vector always holds channel l % channels, so the lanes are
+ * accumulated as they are and only folded per channel at the end.
+ */
+void vad_mc_features_neon(const int16_t *buf, int frames, int channels,
+			  int step, uint64_t *energy, uint32_t *zcr)
+{
+	uint64x2_t e0 = vdupq_n_u64(0), e1 = e0, e2 = e0, e3 = e0;
+	uint32x4_t z0 = vdupq_n_u32(0), z1 = z0;
+	uint64_t e[8];
+	uint32_t z[8];
+	int n = frames * channels;
+	/* vld2 also reads the other half of the last sample, keep it in */
+	int vn = step == 2 ? n - 1 : n;
+	int j, l;
+
+	/* the first frame has no previous sample to count crossings against */
+	for (j = 0; j < channels && j < n; j++)
+		energy[j] += buf[j * step] * buf[j * step];
+
+	for (; j + 8 <= vn; j += 8) {
+		int16x8_t cur = vad_ld(buf + j * step, step);
+		int16x8_t prv = vad_ld(buf + (j - channels) * step, step);
+		uint32x4_t sq;
+		uint16x8_t x;
+
+		sq = vreinterpretq_u32_s32(vmull_s16(vget_low_s16(cur),
+						     vget_low_s16(cur)));
+		e0 = vaddw_u32(e0, vget_low_u32(sq));
+		e1 = vaddw_u32(e1, vget_high_u32(sq));
+		sq = vreinterpretq_u32_s32(vmull_s16(vget_high_s16(cur),
+						     vget_high_s16(cur)));
+		e2 = vaddw_u32(e2, vget_low_u32(sq));
+		e3 = vaddw_u32(e3, vget_high_u32(sq));
+
+		/* sign bit of cur ^ prv is set on a zero crossing */
+		x = vshrq_n_u16(vreinterpretq_u16_s16(veorq_s16(cur, prv)), 15);
+		z0 = vaddw_u16(z0, vget_low_u16(x));
+		z1 = vaddw_u16(z1, vget_high_u16(x));
+	}
+
+	vst1q_u64(&e[0], e0);
+	vst1q_u64(&e[2], e1);
+	vst1q_u64(&e[4], e2);
+	vst1q_u64(&e[6], e3);
+	vst1q_u32(&z[0], z0);
+	vst1q_u32(&z[4], z1);
+	for (l = 0; l < 8; l++) {
+		energy[l % channels] += e[l];
+		zcr[l % channels] += z[l];
+	}
+
+	for (; j < n; j++) {
+		int16_t cur = buf[j * step];
+		int16_t prv = buf[(j - channels) * step];
+
+		energy[j % channels] += cur * cur;
+		zcr[j % channels] += (cur ^ prv) < 0;
+	}
+}
@@ -616,13 +616,11 @@ EXPORT_SYMBOL_GPL(snd_soc_component_test_bits);
 int snd_soc_pcm_component_pointer(struct snd_pcm_substream *substream)
 {
 	struct snd_soc_pcm_runtime *rtd = asoc_substream_to_rtd(substream);
-	struct snd_soc_component *component;
-	int i;
+	struct snd_soc_component *component = rtd->pointer_component;
 
-	/* FIXME: use 1st pointer */
-	for_each_rtd_components(rtd, i, component)
-		if (component->driver->pointer)
-			return component->driver->pointer(component, substream);
+	/* FIXME: use 1st pointer, see soc_new_pcm() */
+	if (component)
+		return component->driver->pointer(component, substream);
 
 	return 0;
 }
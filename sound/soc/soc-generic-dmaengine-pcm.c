@@ -165,7 +165,14 @@ static int dmaengine_pcm_open(struct snd_soc_component *component,
 	if (ret)
 		return ret;
 
-	return snd_dmaengine_pcm_open(substream, chan);
+	ret = snd_dmaengine_pcm_open(substream, chan);
+	if (ret)
+		return ret;
+
+	if (pcm->flags & SND_DMAENGINE_PCM_FLAG_HARDIRQ_CB)
+		snd_dmaengine_pcm_set_hardirq_callback(substream, true);
+
+	return 0;
 }
 
 static int dmaengine_pcm_close(struct snd_soc_component *component,
@@ -238,10 +245,15 @@ static int dmaengine_pcm_new(struct snd_soc_component *component,
 	size_t prealloc_buffer_size;
 	size_t max_buffer_size;
 	unsigned int i;
+	int type;
 
 	if (config && config->prealloc_buffer_size) {
 		prealloc_buffer_size = config->prealloc_buffer_size;
-		max_buffer_size = config->pcm_hardware->buffer_bytes_max;
+		/* without pcm_hardware, never grow past the preallocation */
+		if (config->pcm_hardware)
+			max_buffer_size = config->pcm_hardware->buffer_bytes_max;
+		else
+			max_buffer_size = prealloc_buffer_size;
 	} else {
 		prealloc_buffer_size = prealloc_buffer_size_kbytes * 1024;
 		max_buffer_size = SIZE_MAX;
@@ -267,8 +279,12 @@ static int dmaengine_pcm_new(struct snd_soc_component *component,
 			return -EINVAL;
 		}
 
-		snd_pcm_set_managed_buffer(substream,
-				SNDRV_DMA_TYPE_DEV_IRAM,
+		type = SNDRV_DMA_TYPE_DEV_IRAM;
+		if ((pcm->flags & SND_DMAENGINE_PCM_FLAG_SG) &&
+		    pcm->chan[i]->device->device_prep_dma_cyclic_sg)
+			type = SNDRV_DMA_TYPE_DEV_SG;
+
+		snd_pcm_set_managed_buffer(substream, type,
 				dmaengine_dma_dev(pcm, substream),
 				prealloc_buffer_size,
 				max_buffer_size);
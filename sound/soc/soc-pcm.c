@@ -1090,6 +1090,8 @@ static snd_pcm_uframes_t soc_pcm_pointer(struct snd_pcm_substream *substream)
 
 	/* base delay if assigned in pointer callback */
 	delay = runtime->delay;
+	if (!rtd->dai_delay)
+		return offset;
 
 	for_each_rtd_cpu_dais(rtd, i, cpu_dai) {
 		cpu_delay = max(cpu_delay,
@@ -2690,6 +2692,7 @@ int soc_new_pcm(struct snd_soc_pcm_runtime *rtd, int num)
 {
 	struct snd_soc_dai *codec_dai;
 	struct snd_soc_dai *cpu_dai;
+	struct snd_soc_dai *dai;
 	struct snd_soc_component *component;
 	struct snd_pcm *pcm;
 	char new_name[64];
@@ -2818,6 +2821,20 @@ int soc_new_pcm(struct snd_soc_pcm_runtime *rtd, int num)
 	rtd->pcm = pcm;
 	pcm->private_data = rtd;
 
+	/*
+	 * The pointer runs every period, look up once which component
+	 * answers it and whether any DAI adds a delay.
+	 */
+	for_each_rtd_components(rtd, i, component) {
+		if (component->driver->pointer) {
+			rtd->pointer_component = component;
+			break;
+		}
+	}
+	for_each_rtd_dais(rtd, i, dai)
+		if (dai->driver->ops && dai->driver->ops->delay)
+			rtd->dai_delay = 1;
+
 	if (rtd->dai_link->no_pcm || rtd->dai_link->params) {
 		if (playback)
 			pcm->streams[SNDRV_PCM_STREAM_PLAYBACK].substream->private_data = rtd;
@@ -73,9 +73,12 @@ static bool ignore_ctl_error;
 static bool autoclock = true;
 static char *quirk_alias[SNDRV_CARDS];
 static char *delayed_register[SNDRV_CARDS];
+static char *dsd_native[SNDRV_CARDS];
 
 bool snd_usb_use_vmalloc = true;
 bool snd_usb_skip_validation;
+bool snd_usb_throughput;
+bool snd_usb_dsd_auto;
 
 module_param_array(index, int, NULL, 0444);
 MODULE_PARM_DESC(index, "Index value for the USB audio adapter.");
@@ -102,6 +105,12 @@ module_param_named(use_vmalloc, snd_usb_use_vmalloc, bool, 0444);
 MODULE_PARM_DESC(use_vmalloc, "Use vmalloc for PCM intermediate buffers (default: yes).");
 module_param_named(skip_validation, snd_usb_skip_validation, bool, 0444);
 MODULE_PARM_DESC(skip_validation, "Skip unit descriptor validation (default: no).");
+module_param_named(throughput, snd_usb_throughput, bool, 0644);
+MODULE_PARM_DESC(throughput, "Fewer, larger URBs in whole frames to cut the interrupt rate, at some latency cost (default: no).");
+module_param_array(dsd_native, charp, NULL, 0644);
+MODULE_PARM_DESC(dsd_native, "Native DSD altsettings, given by id:altsetting:format with format u8, u16le, u16be, u32le or u32be, e.g. 0123abcd:3:u32be.");
+module_param_named(dsd_auto, snd_usb_dsd_auto, bool, 0644);
+MODULE_PARM_DESC(dsd_auto, "Offer native DSD U32_BE on any UAC2 raw data altsetting with 4 byte subslots (default: no).");
 
 /*
  * we keep the snd_usb_audio_t instances by ourselves for merging
@@ -839,6 +848,49 @@ static bool get_alias_id(struct usb_device *dev, unsigned int *id)
 	return false;
 }
 
+static const struct {
+	const char *name;
+	u64 formats;
+} dsd_native_formats[] = {
+	{ "u8",		SNDRV_PCM_FMTBIT_DSD_U8 },
+	{ "u16le",	SNDRV_PCM_FMTBIT_DSD_U16_LE },
+	{ "u16be",	SNDRV_PCM_FMTBIT_DSD_U16_BE },
+	{ "u32le",	SNDRV_PCM_FMTBIT_DSD_U32_LE },
+	{ "u32be",	SNDRV_PCM_FMTBIT_DSD_U32_BE },
+};
+
+/*
+ * Look the altsetting up in the dsd_native option. It can be rewritten
+ * through sysfs at any time, new entries apply to the next probe.
+ */
+u64 snd_usb_dsd_native_option(struct snd_usb_audio *chip, int altsetting)
+{
+	unsigned int id, alt;
+	char fmt[8];
+	u64 formats = 0;
+	int i, j;
+
+	kernel_param_lock(THIS_MODULE);
+	for (i = 0; i < ARRAY_SIZE(dsd_native) && !formats; i++) {
+		if (!dsd_native[i] ||
+		    sscanf(dsd_native[i], "%x:%u:%7s", &id, &alt, fmt) != 3 ||
+		    id != chip->usb_id || alt != altsetting)
+			continue;
+		for (j = 0; j < ARRAY_SIZE(dsd_native_formats); j++) {
+			if (!strcmp(fmt, dsd_native_formats[j].name)) {
+				formats = dsd_native_formats[j].formats;
+				break;
+			}
+		}
+		if (!formats)
+			usb_audio_warn(chip, "dsd_native: unknown format %s\n",
+				       fmt);
+	}
+	kernel_param_unlock(THIS_MODULE);
+
+	return formats;
+}
+
 static bool check_delayed_register_option(struct snd_usb_audio *chip, int iface)
 {
 	int i;
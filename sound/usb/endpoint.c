@@ -743,6 +743,12 @@ static bool check_ep_params(struct snd_usb_endpoint *ep,
 				++interval;
 			}
 		}
+		/*
+		 * In throughput mode let the URBs grow up to a period, the
+		 * implicit feedback sink follows as it runs the same code.
+		 */
+		if (snd_usb_throughput)
+			urb_packs = max_packs_per_urb;
 		/* make capture URBs <= 1 ms and smaller than a period */
 		urb_packs = min(max_packs_per_urb, urb_packs);
 		while (urb_packs > 1 && urb_packs * maxsize >= period_bytes)
@@ -772,6 +778,13 @@ static bool check_ep_params(struct snd_usb_endpoint *ep,
 				max_packs_per_urb);
 		/* how many packets are needed in each URB? */
 		urb_packs = DIV_ROUND_UP(max_packs_per_period, urbs_per_period);
+		/*
+		 * Whole frames per URB keep each URB on its own set of
+		 * frame lists with descriptor DMA host controllers (dwc2).
+		 */
+		if (snd_usb_throughput && urb_packs < max_packs_per_urb)
+			urb_packs = min(roundup(urb_packs, packs_per_ms),
+					max_packs_per_urb);
 
 		/* limit the number of frames in a single URB */
 		ret = ret && (ep->max_urb_frames ==
@@ -913,6 +926,12 @@ static int data_ep_set_params(struct snd_usb_endpoint *ep,
 				++interval;
 			}
 		}
+		/*
+		 * In throughput mode let the URBs grow up to a period, the
+		 * implicit feedback sink follows as it runs the same code.
+		 */
+		if (snd_usb_throughput)
+			urb_packs = max_packs_per_urb;
 		/* make capture URBs <= 1 ms and smaller than a period */
 		urb_packs = min(max_packs_per_urb, urb_packs);
 		while (urb_packs > 1 && urb_packs * maxsize >= period_bytes)
@@ -942,6 +961,13 @@ static int data_ep_set_params(struct snd_usb_endpoint *ep,
 				max_packs_per_urb);
 		/* how many packets are needed in each URB? */
 		urb_packs = DIV_ROUND_UP(max_packs_per_period, urbs_per_period);
+		/*
+		 * Whole frames per URB keep each URB on its own set of
+		 * frame lists with descriptor DMA host controllers (dwc2).
+		 */
+		if (snd_usb_throughput && urb_packs < max_packs_per_urb)
+			urb_packs = min(roundup(urb_packs, packs_per_ms),
+					max_packs_per_urb);
 
 		/* limit the number of frames in a single URB */
 		ep->max_urb_frames = DIV_ROUND_UP(frames_per_period,
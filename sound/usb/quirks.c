@@ -1724,6 +1724,12 @@ u64 snd_usb_interface_dsd_format_quirks(struct snd_usb_audio *chip,
 					unsigned int sample_bytes)
 {
 	struct usb_interface *iface;
+	u64 formats;
+
+	/* user supplied entries first, they may override the tables below */
+	formats = snd_usb_dsd_native_option(chip, fp->altsetting);
+	if (formats)
+		return formats;
 
 	/* Playback Designs */
 	if (USB_ID_VENDOR(chip->usb_id) == 0x23ba &&
@@ -1832,6 +1838,16 @@ u64 snd_usb_interface_dsd_format_quirks(struct snd_usb_audio *chip,
 
 	}
 
+	/*
+	 * Unknown vendor: most native DSD DACs flag the DSD altsetting as
+	 * UAC2 raw data with 32 bit subslots, carrying DSD_U32_BE.
+	 */
+	if (snd_usb_dsd_auto && fp->dsd_raw && sample_bytes == 4) {
+		usb_audio_info(chip, "%u:%d: assuming native DSD_U32_BE\n",
+			       fp->iface, fp->altsetting);
+		return SNDRV_PCM_FMTBIT_DSD_U32_BE;
+	}
+
 	return 0;
 }
 
@@ -138,6 +138,10 @@ void snd_usb_unlock_shutdown(struct snd_usb_audio *chip);
 
 extern bool snd_usb_use_vmalloc;
 extern bool snd_usb_skip_validation;
+extern bool snd_usb_throughput;
+extern bool snd_usb_dsd_auto;
+
+u64 snd_usb_dsd_native_option(struct snd_usb_audio *chip, int altsetting);
 
 struct audioformat;
 
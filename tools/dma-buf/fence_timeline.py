@@ -0,0 +1,215 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0
+#
+# Copyright (C) 2026 Rockchip Electronics Co., Ltd.
+
+desc = """
+Rebuild per-frame pipeline timelines (camera -> rga -> rknpu -> rkvenc, or
+any other chain of devices handing buffers over with dma-fences) from the
+dma_fence tracepoints:
+
+  dma_fence_producer   job dev/frame will signal the fence
+  dma_fence_consumer   job dev/frame waits for the fence before it starts
+  dma_fence_signaled   the fence is signaled
+  dma_fence_wait_*     a CPU task blocks on the fence
+
+For each job three times are known: queued (first producer or consumer
+event of the job), ready (last in fence signaled) and done (out fence
+signaled). Per stage this gives
+
+  wait   queued -> ready, time spent blocked on the previous stage
+  run    ready -> done, time spent in the stage itself
+
+A frame is a job without a traced in fence followed through all jobs
+consuming its out fence. The summary lists wait and run percentiles per
+stage, the stage with the largest run time is where the pipeline stalls.
+
+Either parse a saved trace (trace-cmd report output or a copy of tracefs
+'trace'), or record live for --duration seconds:
+
+  echo 1 > /sys/kernel/tracing/events/dma_fence/enable
+  cat /sys/kernel/tracing/trace_pipe > fence.trace
+  fence_timeline.py fence.trace --frames 10
+"""
+
+import argparse
+import collections
+import os
+import re
+import sys
+import time
+
+TRACEFS = '/sys/kernel/tracing'
+EVENTS = ['dma_fence/enable']
+
+line_re = re.compile(r'^\s*(.+?)-(\d+)\s+.*?\s(\d+\.\d+):\s+(\w+):\s+(.*)$')
+field_re = re.compile(r'(\w+)=(\S+)')
+
+parser = argparse.ArgumentParser(description=desc,
+                                 formatter_class=argparse.RawTextHelpFormatter)
+parser.add_argument('trace', nargs='?',
+                    help='Trace file to parse, records live if omitted')
+parser.add_argument('--duration', type=int, default=10, metavar='SECONDS',
+                    help='Live recording time (default: %(default)s)')
+parser.add_argument('--frames', type=int, default=0, metavar='N',
+                    help='Also print the timeline of the first N frames')
+args = parser.parse_args()
+
+def record(duration):
+    for ev in EVENTS:
+        with open(os.path.join(TRACEFS, 'events', ev), 'w') as f:
+            f.write('1')
+    lines = []
+    end = time.monotonic() + duration
+    fd = os.open(os.path.join(TRACEFS, 'trace_pipe'), os.O_RDONLY | os.O_NONBLOCK)
+    buf = b''
+    try:
+        while time.monotonic() < end:
+            try:
+                chunk = os.read(fd, 65536)
+            except BlockingIOError:
+                time.sleep(0.05)
+                continue
+            buf += chunk
+            *done, buf = buf.split(b'\n')
+            lines += [l.decode(errors='replace') for l in done]
+    finally:
+        os.close(fd)
+        for ev in EVENTS:
+            with open(os.path.join(TRACEFS, 'events', ev), 'w') as f:
+                f.write('0')
+    return lines
+
+class Job:
+    def __init__(self, dev, frame):
+        self.dev = dev
+        self.frame = frame
+        self.queued = None
+        self.deps = []
+        self.out = None
+
+    def ready(self, signaled):
+        ts = [signaled[f] for f in self.deps if f in signaled]
+        if len(ts) != len(self.deps):
+            return None
+        return max(ts + [self.queued])
+
+    def done(self, signaled):
+        return signaled.get(self.out)
+
+    def name(self):
+        return '%s#%s' % (self.dev, self.frame)
+
+def parse(lines):
+    jobs = {}
+    producer = {}
+    consumers = collections.defaultdict(list)
+    signaled = {}
+    cpu_waits = collections.defaultdict(list)
+    waiting = {}
+    for line in lines:
+        m = line_re.search(line)
+        if not m:
+            continue
+        comm, ts = m.group(1).strip(), float(m.group(3))
+        event, f = m.group(4), dict(field_re.findall(m.group(5)))
+        if 'context' not in f:
+            continue
+        fence = (int(f['context']), int(f['seqno']))
+        if event in ('dma_fence_producer', 'dma_fence_consumer'):
+            key = (f['dev'], int(f['frame']))
+            job = jobs.get(key)
+            if not job:
+                job = jobs[key] = Job(*key)
+            if job.queued is None or ts < job.queued:
+                job.queued = ts
+            if event == 'dma_fence_producer':
+                job.out = fence
+                producer[fence] = job
+            elif fence not in job.deps:
+                job.deps.append(fence)
+                consumers[fence].append(job)
+        elif event == 'dma_fence_signaled':
+            signaled.setdefault(fence, ts)
+        elif event == 'dma_fence_wait_start':
+            waiting[(comm, fence)] = ts
+        elif event == 'dma_fence_wait_end':
+            start = waiting.pop((comm, fence), None)
+            if start is not None:
+                cpu_waits[comm].append(ts - start)
+    return jobs, producer, consumers, signaled, cpu_waits
+
+def walk(job, consumers, seen):
+    stages = [job]
+    seen.add(id(job))
+    for nxt in consumers.get(job.out, []):
+        if id(nxt) not in seen:
+            stages += walk(nxt, consumers, seen)
+    return stages
+
+def pct(vals, p):
+    vals = sorted(vals)
+    return vals[min(len(vals) - 1, len(vals) * p // 100)]
+
+def ms(sec):
+    return sec * 1e3
+
+lines = open(args.trace).readlines() if args.trace else record(args.duration)
+jobs, producer, consumers, signaled, cpu_waits = parse(lines)
+if not jobs:
+    sys.exit('no dma_fence_producer/consumer events found')
+
+roots = [j for j in jobs.values()
+         if not any(d in producer for d in j.deps)]
+roots.sort(key=lambda j: j.queued)
+
+wait = collections.defaultdict(list)
+run = collections.defaultdict(list)
+for job in jobs.values():
+    ready, done = job.ready(signaled), job.done(signaled)
+    if ready is None or done is None:
+        continue
+    wait[job.dev].append(ready - job.queued)
+    run[job.dev].append(done - ready)
+
+paths = collections.Counter()
+totals = collections.defaultdict(list)
+shown = 0
+for root in roots:
+    stages = walk(root, consumers, set())
+    path = ' -> '.join(s.dev for s in stages)
+    paths[path] += 1
+    end = [s.done(signaled) for s in stages]
+    if None not in end:
+        totals[path].append(max(end) - root.queued)
+    if shown >= args.frames:
+        continue
+    shown += 1
+    print('frame %s: %s' % (root.name(), path))
+    for s in stages:
+        ready, done = s.ready(signaled), s.done(signaled)
+        print('  %-24s queued %+9.3f ms  ready %9s  done %9s' %
+              (s.name(), ms(s.queued - root.queued),
+               '%+.3f' % ms(ready - root.queued) if ready is not None else '-',
+               '%+.3f' % ms(done - root.queued) if done is not None else '-'))
+
+print('%-16s %7s %27s %27s' % ('stage', 'jobs', 'wait ms avg/p99/max',
+                               'run ms avg/p99/max'))
+for dev in sorted(set(wait) | set(run), key=lambda d: -sum(run[d]) / len(run[d])):
+    w, r = wait[dev], run[dev]
+    print('%-16s %7d %9.3f %8.3f %8.3f %9.3f %8.3f %8.3f' %
+          (dev, len(r), ms(sum(w) / len(w)), ms(pct(w, 99)), ms(max(w)),
+           ms(sum(r) / len(r)), ms(pct(r, 99)), ms(max(r))))
+
+print()
+for path, count in paths.most_common():
+    t = totals[path]
+    if t:
+        print('%5d frames %s: end to end avg %.3f ms, p99 %.3f ms, max %.3f ms' %
+              (count, path, ms(sum(t) / len(t)), ms(pct(t, 99)), ms(max(t))))
+    else:
+        print('%5d frames %s: never completed' % (count, path))
+
+for comm, waits in sorted(cpu_waits.items()):
+    print('cpu wait %-16s %6d x avg %.3f ms, max %.3f ms' %
+          (comm, len(waits), ms(sum(waits) / len(waits)), ms(max(waits))))
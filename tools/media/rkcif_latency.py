@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0
+#
+# Copyright (C) 2026 Rockchip Electronics Co., Ltd.
+
+desc = """
+Capture latency histograms for the rkcif driver, from its rkcif:*
+tracepoints, broken down by the DDR frequency set by the devfreq
+governor (devfreq:devfreq_frequency) at the time each frame started.
+
+  fs->fe    frame start to DMA done (sensor readout + write to DDR)
+  fs->done  frame start to vb2 buffer done (what userspace sees)
+
+Frames that started but never completed DMA are counted as drops.
+
+Either parse a saved trace (trace-cmd report output or a copy of
+tracefs 'trace'), or record live for --duration seconds:
+
+  echo 1 > /sys/kernel/tracing/events/rkcif/enable
+  echo 1 > /sys/kernel/tracing/events/devfreq/devfreq_frequency/enable
+  cat /sys/kernel/tracing/trace_pipe > cif.trace
+  rkcif_latency.py cif.trace
+"""
+
+import argparse
+import collections
+import os
+import re
+import sys
+import time
+
+TRACEFS = '/sys/kernel/tracing'
+EVENTS = ['rkcif/enable', 'devfreq/devfreq_frequency/enable']
+
+line_re = re.compile(r'\s(\d+\.\d+):\s+(\w+):\s+(.*)$')
+field_re = re.compile(r'(\w+)=(\S+)')
+
+parser = argparse.ArgumentParser(description=desc,
+                                 formatter_class=argparse.RawTextHelpFormatter)
+parser.add_argument('trace', nargs='?',
+                    help='Trace file to parse, records live if omitted')
+parser.add_argument('--duration', type=int, default=10, metavar='SECONDS',
+                    help='Live recording time (default: %(default)s)')
+parser.add_argument('--dmc', default='dmc', metavar='NAME',
+                    help='devfreq device of the DDR (default: %(default)s)')
+parser.add_argument('--bucket-us', type=int, default=500, metavar='US',
+                    help='Histogram bucket width (default: %(default)s)')
+args = parser.parse_args()
+
+def record(duration):
+    for ev in EVENTS:
+        with open(os.path.join(TRACEFS, 'events', ev), 'w') as f:
+            f.write('1')
+    lines = []
+    end = time.monotonic() + duration
+    fd = os.open(os.path.join(TRACEFS, 'trace_pipe'), os.O_RDONLY | os.O_NONBLOCK)
+    buf = b''
+    try:
+        while time.monotonic() < end:
+            try:
+                chunk = os.read(fd, 65536)
+            except BlockingIOError:
+                time.sleep(0.05)
+                continue
+            buf += chunk
+            *done, buf = buf.split(b'\n')
+            lines += [l.decode(errors='replace') for l in done]
+    finally:
+        os.close(fd)
+        for ev in EVENTS:
+            with open(os.path.join(TRACEFS, 'events', ev), 'w') as f:
+                f.write('0')
+    return lines
+
+class Stream:
+    def __init__(self):
+        self.starts = {}
+        self.fe = collections.defaultdict(collections.Counter)
+        self.done = collections.defaultdict(collections.Counter)
+        self.frames = collections.Counter()
+        self.drops = collections.Counter()
+
+def bucket(ns):
+    return ns // 1000 // args.bucket_us * args.bucket_us
+
+def parse(lines):
+    streams = collections.defaultdict(Stream)
+    freq = 0
+    for line in lines:
+        m = line_re.search(line)
+        if not m:
+            continue
+        event, f = m.group(2), dict(field_re.findall(m.group(3)))
+        if event == 'devfreq_frequency':
+            if f.get('dev_name') == args.dmc:
+                freq = int(f['freq'])
+            continue
+        if not event.startswith('rkcif_'):
+            continue
+        s = streams[(f['dev'], int(f['id']))]
+        fs = int(f['fs_ts'])
+        if event == 'rkcif_frame_start':
+            # a frame start never followed by its DMA done was dropped
+            for ts in [ts for ts in s.starts if ts < fs]:
+                fq, dma = s.starts[ts]
+                if not dma:
+                    s.drops[fq] += 1
+                    del s.starts[ts]
+            # rockit buffers have no vb2 done, forget them after a while
+            while len(s.starts) > 16:
+                del s.starts[min(s.starts)]
+            s.starts[fs] = [freq, False]
+            s.frames[freq] += 1
+        elif event == 'rkcif_dma_done':
+            start = s.starts.setdefault(fs, [freq, False])
+            start[1] = True
+            s.fe[start[0]][bucket(int(f['fe_ts']) - fs)] += 1
+        elif event == 'rkcif_buf_done':
+            fq = s.starts.pop(fs, [freq])[0]
+            s.done[fq][bucket(int(f['done_ts']) - fs)] += 1
+    return streams
+
+def histogram(title, hist):
+    total = sum(hist.values())
+    if not total:
+        return
+    width = max(hist.values())
+    print('    %s (%d frames)' % (title, total))
+    for b in sorted(hist):
+        bar = '#' * max(1, hist[b] * 40 // width)
+        print('    %8d us %7d %s' % (b, hist[b], bar))
+
+lines = open(args.trace).readlines() if args.trace else record(args.duration)
+streams = parse(lines)
+if not streams:
+    sys.exit('no rkcif events found')
+
+for (dev, sid), s in sorted(streams.items()):
+    for fq in sorted(set(s.frames) | set(s.fe) | set(s.done)):
+        label = '%d MHz' % (fq // 1000000) if fq else 'unknown'
+        print('%s id%d @ DDR %s: %d frames, %d dropped' %
+              (dev, sid, label, s.frames[fq], s.drops[fq]))
+        histogram('fs->fe', s.fe[fq])
+        histogram('fs->done', s.done[fq])
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0
+#
+# Copyright (C) 2026 Rockchip Electronics Co., Ltd.
+
+desc = """
+Benchmark the flash stack layer by layer and print one report:
+
+  mtd        sequential read of a raw MTD partition (spinand + sfc)
+  ubi        sequential read of a UBI volume, one LEB per read
+  ubiblock   sequential and random O_DIRECT reads of a ubiblock device
+  squashfs   cold read of every file below a squashfs mount point
+
+Each phase drops the page cache first and runs with the ftrace function
+profiler on the functions of the layers below it, so the time spent in
+rockchip_sfc_exec_mem_op, ubi_eba_read_leb and squashfs_decompress is
+reported next to the throughput seen from userspace. That needs
+CONFIG_FUNCTION_PROFILER; without it only throughput is reported.
+
+  flash_bench.py --mtd /dev/mtd3 --ubi /dev/ubi0_0 \\
+                 --ubiblock /dev/ubiblock0_0 --squashfs /oem
+"""
+
+import argparse
+import mmap
+import os
+import random
+import re
+import sys
+import time
+
+TRACEFS = '/sys/kernel/tracing'
+SFC = 'rockchip_sfc_exec_mem_op'
+LEB = 'ubi_eba_read_leb'
+SQUASHFS = 'squashfs_decompress'
+
+parser = argparse.ArgumentParser(description=desc,
+                                 formatter_class=argparse.RawTextHelpFormatter)
+parser.add_argument('--mtd', metavar='DEV', help='Raw MTD char device')
+parser.add_argument('--ubi', metavar='DEV', help='UBI volume char device')
+parser.add_argument('--ubiblock', metavar='DEV', help='ubiblock device')
+parser.add_argument('--squashfs', metavar='DIR',
+                    help='Mount point of a squashfs on the flash')
+parser.add_argument('--size', type=int, default=16, metavar='MB',
+                    help='Bytes to read per sequential phase (default: %(default)s)')
+parser.add_argument('--random', type=int, default=2000, metavar='N',
+                    help='Random 4KiB reads on ubiblock (default: %(default)s)')
+args = parser.parse_args()
+
+def drop_caches():
+    os.sync()
+    with open('/proc/sys/vm/drop_caches', 'w') as f:
+        f.write('3')
+
+def tracefs_write(name, val):
+    with open(os.path.join(TRACEFS, name), 'w') as f:
+        f.write(val)
+
+class Profiler:
+    def __init__(self, funcs):
+        self.funcs = funcs
+        self.ok = os.path.exists(os.path.join(TRACEFS, 'function_profile_enabled'))
+
+    def __enter__(self):
+        if self.ok:
+            try:
+                tracefs_write('set_ftrace_filter', ' '.join(self.funcs))
+                tracefs_write('function_profile_enabled', '0')
+                tracefs_write('function_profile_enabled', '1')
+            except OSError:
+                self.ok = False
+        return self
+
+    def __exit__(self, *exc):
+        if self.ok:
+            tracefs_write('function_profile_enabled', '0')
+
+    # trace_stat/functionN: Function Hit Time(us) Avg(us) s^2
+    def stats(self):
+        res = {}
+        if not self.ok:
+            return res
+        stat_dir = os.path.join(TRACEFS, 'trace_stat')
+        for name in os.listdir(stat_dir):
+            if not name.startswith('function'):
+                continue
+            for line in open(os.path.join(stat_dir, name)):
+                m = re.match(r'\s*(\w+)\s+(\d+)\s+([\d.]+) us', line)
+                if not m or m.group(1) not in self.funcs:
+                    continue
+                hit, us = res.get(m.group(1), (0, 0.0))
+                res[m.group(1)] = (hit + int(m.group(2)), us + float(m.group(3)))
+        return res
+
+def aligned_buf(size):
+    return mmap.mmap(-1, size)
+
+def read_seq(path, bs, total, direct=False):
+    flags = os.O_RDONLY | (os.O_DIRECT if direct else 0)
+    fd = os.open(path, flags)
+    buf = aligned_buf(bs)
+    done = 0
+    try:
+        while done < total:
+            n = os.readv(fd, [buf])
+            if n <= 0:
+                break
+            done += n
+    finally:
+        os.close(fd)
+    return done
+
+def read_random(path, bs, count):
+    fd = os.open(path, os.O_RDONLY | os.O_DIRECT)
+    buf = aligned_buf(bs)
+    done = 0
+    try:
+        blocks = os.lseek(fd, 0, os.SEEK_END) // bs
+        for _ in range(count):
+            os.lseek(fd, random.randrange(blocks) * bs, os.SEEK_SET)
+            done += os.readv(fd, [buf])
+    finally:
+        os.close(fd)
+    return done
+
+def read_tree(top):
+    done = 0
+    for root, _, files in os.walk(top):
+        for name in files:
+            path = os.path.join(root, name)
+            if not os.path.isfile(path) or os.path.islink(path):
+                continue
+            with open(path, 'rb') as f:
+                while True:
+                    chunk = f.read(1 << 17)
+                    if not chunk:
+                        break
+                    done += len(chunk)
+    return done
+
+def sysfs_int(path, default):
+    try:
+        return int(open(path).read())
+    except (OSError, ValueError):
+        return default
+
+results = []
+
+def run(name, funcs, fn, *fn_args):
+    drop_caches()
+    with Profiler(funcs) as prof:
+        start = time.monotonic()
+        nbytes = fn(*fn_args)
+        elapsed = time.monotonic() - start
+    results.append((name, nbytes, elapsed, prof.stats()))
+
+size = args.size << 20
+if args.mtd:
+    dev = os.path.basename(args.mtd)
+    bs = sysfs_int('/sys/class/mtd/%s/writesize' % dev, 2048)
+    run('mtd seq', [SFC], read_seq, args.mtd, bs, size)
+if args.ubi:
+    vol = os.path.basename(args.ubi)
+    bs = sysfs_int('/sys/class/ubi/%s/usable_eb_size' % vol, 126976)
+    run('ubi seq', [LEB, SFC], read_seq, args.ubi, bs, size)
+if args.ubiblock:
+    run('ubiblock seq', [LEB, SFC], read_seq, args.ubiblock, 1 << 17, size, True)
+    run('ubiblock rand', [LEB, SFC], read_random, args.ubiblock, 4096, args.random)
+if args.squashfs:
+    run('squashfs', [SQUASHFS, LEB, SFC], read_tree, args.squashfs)
+
+if not results:
+    parser.print_usage()
+    sys.exit(1)
+
+print('%-14s %10s %9s %9s   %s' % ('phase', 'KiB', 'ms', 'MiB/s', 'time in layers'))
+for name, nbytes, elapsed, stats in results:
+    layers = []
+    for func, (hit, us) in sorted(stats.items()):
+        share = us / 1e4 / elapsed if elapsed else 0
+        layers.append('%s %d x %.1f us (%.0f%%)' %
+                      (func, hit, us / hit if hit else 0, share))
+    print('%-14s %10d %9.1f %9.2f   %s' %
+          (name, nbytes >> 10, elapsed * 1e3,
+           nbytes / elapsed / (1 << 20) if elapsed else 0,
+           ', '.join(layers) or '-'))
@@ -0,0 +1,456 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * pcm-shmring.c -- shared-memory PCM ring between two processes
+ *
+ * Copyright (C) 2026 Rockchip Electronics Co. Ltd.
+ *
+ * Reference for handing PCM periods from a decoder to an output daemon
+ * without copying them through an AF_UNIX stream socket. The producer
+ * creates a sealed memfd holding a single-producer single-consumer ring
+ * of periods plus two eventfd doorbells, and passes all three to the
+ * consumer once with SCM_RIGHTS over the control socket. After that no
+ * PCM goes through the socket any more: the producer writes periods in
+ * place, publishes them by moving the head index and rings the "filled"
+ * doorbell, the consumer moves the tail and rings "freed".
+ *
+ * The doorbells are only rung when the peer said it is about to sleep,
+ * so a ring that never runs empty or full costs no syscall at all.
+ *
+ * With -c the same periods are sent through the socket instead, for
+ * comparison. Throughput is printed once a second by the consumer.
+ *
+ * Usage: pcm-shmring [-c] [-p period_bytes] [-n periods] [-t seconds]
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RING_MAGIC		0x50434d52	/* "PCMR" */
+#define CACHELINE		64
+
+/* doorbell indexes, also the order the fds are passed in */
+enum {
+	BELL_FILLED,
+	BELL_FREED,
+	BELL_NUM,
+};
+
+struct ring {
+	uint32_t magic;
+	uint32_t period_bytes;
+	uint32_t periods;
+	uint32_t data_offset;
+
+	/* written by the producer only */
+	uint64_t head __attribute__((aligned(CACHELINE)));
+	uint32_t producer_waiting;
+
+	/* written by the consumer only */
+	uint64_t tail __attribute__((aligned(CACHELINE)));
+	uint32_t consumer_waiting;
+	uint32_t done;
+};
+
+struct shmring {
+	int sock;
+	int bell[BELL_NUM];
+	struct ring *ring;
+	uint8_t *data;
+
+	bool copy;
+	unsigned int period_bytes;
+	unsigned int periods;
+	unsigned int seconds;
+
+	uint64_t bytes;
+	uint64_t wakeups;
+};
+
+static void die(const char *what)
+{
+	fprintf(stderr, "pcm-shmring: %s: %s\n", what, strerror(errno));
+	exit(1);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bell_ring(struct shmring *s, int bell)
+{
+	uint64_t one = 1;
+
+	if (write(s->bell[bell], &one, sizeof(one)) != sizeof(one))
+		die("doorbell");
+}
+
+/* Block until the peer rings, or up to a second */
+static void bell_wait(struct shmring *s, int bell)
+{
+	struct pollfd pfd = { .fd = s->bell[bell], .events = POLLIN };
+	uint64_t count;
+
+	if (poll(&pfd, 1, 1000) > 0 &&
+	    read(s->bell[bell], &count, sizeof(count)) != sizeof(count))
+		die("doorbell wait");
+	s->wakeups++;
+}
+
+/*
+ * Sleep until @cond holds. @waiting is raised before @cond is checked a
+ * last time so that the peer either sees it and rings, or has already
+ * made @cond true.
+ */
+#define ring_wait(s, bell, waiting, cond)				\
+	do {								\
+		while (!(cond)) {					\
+			__atomic_store_n(waiting, 1, __ATOMIC_SEQ_CST);	\
+			if (!(cond))					\
+				bell_wait(s, bell);			\
+			__atomic_store_n(waiting, 0, __ATOMIC_RELAXED);	\
+		}							\
+	} while (0)
+
+static void ring_kick(struct shmring *s, int bell, uint32_t *waiting)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(waiting, __ATOMIC_RELAXED))
+		bell_ring(s, bell);
+}
+
+static void ring_create(struct shmring *s)
+{
+	size_t hdr = (sizeof(struct ring) + CACHELINE - 1) & ~(CACHELINE - 1);
+	size_t size = hdr + (size_t)s->period_bytes * s->periods;
+	int fd, i;
+
+	fd = memfd_create("pcm-shmring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd < 0)
+		die("memfd_create");
+	if (ftruncate(fd, size))
+		die("ftruncate");
+	/* the consumer must not be able to pull the mapping from under us */
+	if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL))
+		die("F_ADD_SEALS");
+
+	s->ring = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (s->ring == MAP_FAILED)
+		die("mmap");
+	s->ring->magic = RING_MAGIC;
+	s->ring->period_bytes = s->period_bytes;
+	s->ring->periods = s->periods;
+	s->ring->data_offset = hdr;
+	s->data = (uint8_t *)s->ring + hdr;
+
+	for (i = 0; i < BELL_NUM; i++) {
+		s->bell[i] = eventfd(0, EFD_CLOEXEC);
+		if (s->bell[i] < 0)
+			die("eventfd");
+	}
+
+	/* memfd, then the doorbells */
+	{
+		int fds[1 + BELL_NUM] = { fd, s->bell[0], s->bell[1] };
+		char cbuf[CMSG_SPACE(sizeof(fds))];
+		char byte = 0;
+		struct iovec iov = { .iov_base = &byte, .iov_len = 1 };
+		struct msghdr msg = {
+			.msg_iov = &iov,
+			.msg_iovlen = 1,
+			.msg_control = cbuf,
+			.msg_controllen = sizeof(cbuf),
+		};
+		struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+		memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+		if (sendmsg(s->sock, &msg, 0) != 1)
+			die("sendmsg");
+	}
+	close(fd);
+}
+
+static void ring_attach(struct shmring *s)
+{
+	int fds[1 + BELL_NUM];
+	char cbuf[CMSG_SPACE(sizeof(fds))];
+	char byte;
+	struct iovec iov = { .iov_base = &byte, .iov_len = 1 };
+	struct msghdr msg = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+		.msg_control = cbuf,
+		.msg_controllen = sizeof(cbuf),
+	};
+	struct cmsghdr *cmsg;
+	struct stat st;
+	int seals, i;
+
+	if (recvmsg(s->sock, &msg, MSG_CMSG_CLOEXEC) != 1)
+		die("recvmsg");
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS ||
+	    cmsg->cmsg_len != CMSG_LEN(sizeof(fds))) {
+		errno = EPROTO;
+		die("SCM_RIGHTS");
+	}
+	memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+
+	seals = fcntl(fds[0], F_GET_SEALS);
+	if (seals < 0 || !(seals & F_SEAL_SHRINK) || fstat(fds[0], &st)) {
+		errno = EPERM;
+		die("unsealed ring");
+	}
+
+	s->ring = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		       fds[0], 0);
+	if (s->ring == MAP_FAILED)
+		die("mmap");
+	close(fds[0]);
+
+	if (s->ring->magic != RING_MAGIC ||
+	    s->ring->data_offset + (uint64_t)s->ring->period_bytes *
+	    s->ring->periods > (uint64_t)st.st_size) {
+		errno = EPROTO;
+		die("ring header");
+	}
+	s->period_bytes = s->ring->period_bytes;
+	s->periods = s->ring->periods;
+	s->data = (uint8_t *)s->ring + s->ring->data_offset;
+
+	for (i = 0; i < BELL_NUM; i++)
+		s->bell[i] = fds[1 + i];
+}
+
+/* Stand-in for the decoder: a sawtooth, so the consumer can check it */
+static void fill_period(uint8_t *p, unsigned int bytes, uint64_t seq)
+{
+	unsigned int i;
+
+	for (i = 0; i < bytes; i += sizeof(uint32_t))
+		*(uint32_t *)(p + i) = (uint32_t)seq + i;
+}
+
+static bool check_period(const uint8_t *p, uint64_t seq)
+{
+	return *(const uint32_t *)p == (uint32_t)seq;
+}
+
+static void run_producer(struct shmring *s)
+{
+	struct ring *r = s->ring;
+	uint64_t head = 0;
+
+	while (!__atomic_load_n(&r->done, __ATOMIC_ACQUIRE)) {
+		ring_wait(s, BELL_FREED, &r->producer_waiting,
+			  head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) <
+			  s->periods ||
+			  __atomic_load_n(&r->done, __ATOMIC_ACQUIRE));
+
+		fill_period(s->data + (head % s->periods) * s->period_bytes,
+			    s->period_bytes, head);
+		__atomic_store_n(&r->head, ++head, __ATOMIC_RELEASE);
+		ring_kick(s, BELL_FILLED, &r->consumer_waiting);
+	}
+}
+
+static void run_producer_copy(struct shmring *s)
+{
+	uint8_t *buf = malloc(s->period_bytes);
+	uint64_t seq;
+
+	if (!buf)
+		die("malloc");
+
+	for (seq = 0; ; seq++) {
+		fill_period(buf, s->period_bytes, seq);
+		if (write(s->sock, buf, s->period_bytes) != s->period_bytes)
+			break;
+	}
+	free(buf);
+}
+
+static bool report(struct shmring *s, double *last, unsigned int *elapsed)
+{
+	static uint64_t bytes, wakeups;
+	double t = now(), dt = t - *last;
+
+	if (dt < 1.0)
+		return true;
+
+	printf("%s: %9.2f MB/s %9.0f periods/s %8.0f wakeups/s\n",
+	       s->copy ? "copy" : "ring",
+	       (s->bytes - bytes) / dt / 1e6,
+	       (s->bytes - bytes) / s->period_bytes / dt,
+	       (s->wakeups - wakeups) / dt);
+	fflush(stdout);
+
+	bytes = s->bytes;
+	wakeups = s->wakeups;
+	*last = t;
+
+	return !s->seconds || ++*elapsed < s->seconds;
+}
+
+static int run_consumer(struct shmring *s)
+{
+	struct ring *r = s->ring;
+	unsigned int elapsed = 0;
+	uint64_t tail = 0;
+	double last = now();
+	int errors = 0;
+
+	while (report(s, &last, &elapsed)) {
+		uint64_t head;
+
+		ring_wait(s, BELL_FILLED, &r->consumer_waiting,
+			  __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) != tail);
+
+		/* the output daemon would hand these to ALSA in place */
+		head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+		for (; tail != head; tail++) {
+			if (!check_period(s->data + (tail % s->periods) *
+					  s->period_bytes, tail))
+				errors++;
+			s->bytes += s->period_bytes;
+		}
+		__atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+		ring_kick(s, BELL_FREED, &r->producer_waiting);
+	}
+
+	__atomic_store_n(&r->done, 1, __ATOMIC_RELEASE);
+	bell_ring(s, BELL_FREED);
+
+	return errors;
+}
+
+static int run_consumer_copy(struct shmring *s)
+{
+	uint8_t *buf = malloc(s->period_bytes);
+	unsigned int elapsed = 0, fill = 0;
+	double last = now();
+	uint64_t seq = 0;
+	int errors = 0;
+	ssize_t n;
+
+	if (!buf)
+		die("malloc");
+
+	while (report(s, &last, &elapsed)) {
+		n = read(s->sock, buf + fill, s->period_bytes - fill);
+		if (n <= 0)
+			die("read");
+		s->bytes += n;
+		s->wakeups++;
+		fill += n;
+		if (fill < s->period_bytes)
+			continue;
+		if (!check_period(buf, seq++))
+			errors++;
+		fill = 0;
+	}
+	free(buf);
+
+	return errors;
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: pcm-shmring [options]\n"
+		"  -c          copy periods through the socket instead\n"
+		"  -p bytes    period size (default 4096)\n"
+		"  -n periods  periods in the ring (default 8)\n"
+		"  -t seconds  stop after that many reports (default 10)\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	struct shmring s = { .period_bytes = 4096, .periods = 8, .seconds = 10 };
+	int sv[2], status, errors, c;
+	pid_t pid;
+
+	while ((c = getopt(argc, argv, "cp:n:t:")) != -1) {
+		switch (c) {
+		case 'c':
+			s.copy = true;
+			break;
+		case 'p':
+			s.period_bytes = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			s.periods = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			s.seconds = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (!s.period_bytes || s.period_bytes % sizeof(uint32_t) ||
+	    s.periods < 2)
+		usage();
+
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv))
+		die("socketpair");
+
+	pid = fork();
+	if (pid < 0)
+		die("fork");
+
+	if (!pid) {
+		/* producer, the decoder side */
+		close(sv[1]);
+		s.sock = sv[0];
+		if (s.copy) {
+			run_producer_copy(&s);
+		} else {
+			ring_create(&s);
+			run_producer(&s);
+		}
+		_exit(0);
+	}
+
+	/* consumer, the output side */
+	close(sv[0]);
+	s.sock = sv[1];
+	if (s.copy) {
+		errors = run_consumer_copy(&s);
+	} else {
+		ring_attach(&s);
+		printf("ring: %u periods of %u bytes\n", s.periods,
+		       s.period_bytes);
+		errors = run_consumer(&s);
+	}
+	close(s.sock);
+	waitpid(pid, &status, 0);
+
+	if (errors)
+		fprintf(stderr, "pcm-shmring: %d corrupted periods\n", errors);
+
+	return !!errors;
+}
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0
+#
+# Copyright (C) 2026 Rockchip Electronics Co., Ltd.
+
+desc = """
+Per-period latency histograms of the pl330 + dmaengine PCM audio path,
+from the pl330:* and snd_pcm:* tracepoints (the latter need
+CONFIG_SND_PCM_XRUN_DEBUG):
+
+  irq->tasklet   pl330_rqcb (DMAC interrupt) to pl330_callback
+  tasklet->core  pl330_callback to the end of snd_pcm_period_elapsed
+                 (dma_complete, hw_ptr update and wakeups, period_lock)
+  core->wake     period_lock to the blocked read/write running again
+                 (avail_wake), only when someone was sleeping on it
+  irq->wake      the whole path
+
+XRUNs are counted per substream so dropouts can be put against the
+stage whose tail grew.
+
+Either parse a saved trace (trace-cmd report output or a copy of
+tracefs 'trace'), or record live for --duration seconds:
+
+  echo 1 > /sys/kernel/tracing/events/pl330/enable
+  for e in dma_complete period_lock avail_wake xrun; do
+    echo 1 > /sys/kernel/tracing/events/snd_pcm/$e/enable
+  done
+  cat /sys/kernel/tracing/trace_pipe > pcm.trace
+  pcm_latency.py pcm.trace
+"""
+
+import argparse
+import collections
+import os
+import re
+import sys
+import time
+
+TRACEFS = '/sys/kernel/tracing'
+EVENTS = ['pl330/enable'] + ['snd_pcm/%s/enable' % e for e in
+                             ('dma_complete', 'period_lock', 'avail_wake',
+                              'xrun')]
+STAGES = ['irq->tasklet', 'tasklet->core', 'core->wake', 'irq->wake']
+
+line_re = re.compile(r'\s(\d+\.\d+):\s+(\w+):\s+(.*)$')
+field_re = re.compile(r'(\w+)=(\S+)')
+pcm_re = re.compile(r'^(pcmC\d+D\d+[pc]/sub\d+):')
+
+parser = argparse.ArgumentParser(description=desc,
+                                 formatter_class=argparse.RawTextHelpFormatter)
+parser.add_argument('trace', nargs='?',
+                    help='Trace file to parse, records live if omitted')
+parser.add_argument('--duration', type=int, default=10, metavar='SECONDS',
+                    help='Live recording time (default: %(default)s)')
+parser.add_argument('--bucket-us', type=int, default=100, metavar='US',
+                    help='Histogram bucket width (default: %(default)s)')
+args = parser.parse_args()
+
+def record(duration):
+    for ev in EVENTS:
+        with open(os.path.join(TRACEFS, 'events', ev), 'w') as f:
+            f.write('1')
+    lines = []
+    end = time.monotonic() + duration
+    fd = os.open(os.path.join(TRACEFS, 'trace_pipe'), os.O_RDONLY | os.O_NONBLOCK)
+    buf = b''
+    try:
+        while time.monotonic() < end:
+            try:
+                chunk = os.read(fd, 65536)
+            except BlockingIOError:
+                time.sleep(0.05)
+                continue
+            buf += chunk
+            *done, buf = buf.split(b'\n')
+            lines += [l.decode(errors='replace') for l in done]
+    finally:
+        os.close(fd)
+        for ev in EVENTS:
+            with open(os.path.join(TRACEFS, 'events', ev), 'w') as f:
+                f.write('0')
+    return lines
+
+class Substream:
+    def __init__(self):
+        self.chan = None
+        self.irq = None         # start of the period in flight
+        self.tasklet = None
+        self.core = None
+        self.hist = {s: collections.Counter() for s in STAGES}
+        self.periods = 0
+        self.xruns = 0
+
+def bucket(sec):
+    return round(sec * 1e6) // args.bucket_us * args.bucket_us
+
+def parse(lines):
+    subs = collections.defaultdict(Substream)
+    irq = {}        # chan -> first unserviced pl330_rqcb
+    tasklet = {}    # chan -> (irq, callback) of the last pl330_callback
+    for line in lines:
+        m = line_re.search(line)
+        if not m:
+            continue
+        ts, event, rest = float(m.group(1)), m.group(2), m.group(3)
+        f = dict(field_re.findall(rest))
+        if event == 'pl330_rqcb':
+            # periods coalesced by a late tasklet count from the first one
+            irq.setdefault(f['chan'], ts)
+            continue
+        if event == 'pl330_callback':
+            tasklet[f['chan']] = (irq.pop(f['chan'], None), ts)
+            continue
+        p = pcm_re.match(rest)
+        if not p:
+            continue
+        s = subs[p.group(1)]
+        if event == 'dma_complete':
+            s.chan = f['chan']
+            s.irq, s.tasklet = tasklet.pop(s.chan, (None, ts))
+        elif event == 'period_lock':
+            if s.tasklet is None:
+                continue
+            s.periods += 1
+            if s.irq is not None:
+                s.hist['irq->tasklet'][bucket(s.tasklet - s.irq)] += 1
+            s.hist['tasklet->core'][bucket(ts - s.tasklet)] += 1
+            s.core = ts
+            s.tasklet = None
+        elif event == 'avail_wake':
+            if s.core is None:
+                continue
+            # lock release and wakeup race, a wakeup is never early
+            s.hist['core->wake'][bucket(max(0.0, ts - s.core))] += 1
+            if s.irq is not None:
+                s.hist['irq->wake'][bucket(ts - s.irq)] += 1
+            s.core = None
+        elif event == 'xrun':
+            s.xruns += 1
+    return subs
+
+def histogram(title, hist):
+    total = sum(hist.values())
+    if not total:
+        return
+    width = max(hist.values())
+    print('    %s (%d periods)' % (title, total))
+    for b in sorted(hist):
+        bar = '#' * max(1, hist[b] * 40 // width)
+        print('    %8d us %7d %s' % (b, hist[b], bar))
+
+lines = open(args.trace).readlines() if args.trace else record(args.duration)
+subs = parse(lines)
+if not subs:
+    sys.exit('no snd_pcm events found')
+
+for name, s in sorted(subs.items()):
+    print('%s via %s: %d periods, %d xruns' %
+          (name, s.chan or 'unknown', s.periods, s.xruns))
+    for stage in STAGES:
+        histogram(stage, s.hist[stage])
@@ -0,0 +1,390 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * stmmac-uio-bench.c -- packet rate benchmark for the stmmac UIO channel
+ *
+ * Copyright (C) 2023 Rockchip Electronics Co. Ltd.
+ *
+ * Drives the DMA channel lent by stmmac_uio straight from userspace and
+ * prints packets and bits per second once a second. RX counts whatever
+ * the MAC routes to the channel, TX floods broadcast frames. Only the
+ * dwmac4/5 descriptor layout is handled.
+ *
+ * Usage: stmmac-uio-bench -d uio0 [-t] [-s size] [-p] [-n seconds]
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/stmmac_uio.h>
+
+/* dwmac4 channel registers, relative to info->chan_regs */
+#define CH_TX_CONTROL		0x04
+#define CH_RX_CONTROL		0x08
+#define CH_TX_END_ADDR		0x20
+#define CH_RX_END_ADDR		0x28
+#define CH_CONTROL_START	(1u << 0)
+
+/* dwmac4 normal descriptor bits */
+#define RDES3_OWN		(1u << 31)
+#define RDES3_IOC		(1u << 30)
+#define RDES3_BUF1V		(1u << 24)
+#define RDES3_ES		(1u << 15)
+#define RDES3_PL_MASK		0x7fff
+#define TDES2_IOC		(1u << 31)
+#define TDES2_B1L_MASK		0x3fff
+#define TDES3_OWN		(1u << 31)
+#define TDES3_FD		(1u << 29)
+#define TDES3_LD		(1u << 28)
+#define TDES3_FL_MASK		0x7fff
+
+/* request a completion interrupt every this many TX frames */
+#define TX_IRQ_BATCH		32
+
+struct desc {
+	uint32_t des0;
+	uint32_t des1;
+	uint32_t des2;
+	uint32_t des3;
+};
+
+struct bench {
+	const char *name;
+	int fd;
+	const struct stmmac_uio_info *info;
+	volatile uint8_t *regs;
+	volatile uint8_t *rx_ring;
+	volatile uint8_t *tx_ring;
+	uint8_t *buf;
+
+	bool tx;
+	bool busy_poll;
+	unsigned int size;
+	unsigned int seconds;
+
+	uint64_t pkts;
+	uint64_t bytes;
+	uint64_t errors;
+};
+
+static void die(const char *what)
+{
+	fprintf(stderr, "stmmac-uio-bench: %s: %s\n", what, strerror(errno));
+	exit(1);
+}
+
+static void barrier_dma(void)
+{
+	__sync_synchronize();
+}
+
+static void reg_write(struct bench *b, unsigned int reg, uint32_t val)
+{
+	barrier_dma();
+	*(volatile uint32_t *)(b->regs + b->info->chan_regs + reg) = val;
+}
+
+static uint32_t reg_read(struct bench *b, unsigned int reg)
+{
+	return *(volatile uint32_t *)(b->regs + b->info->chan_regs + reg);
+}
+
+static unsigned long map_size(struct bench *b, int map)
+{
+	char path[128];
+	unsigned long size;
+	FILE *f;
+
+	snprintf(path, sizeof(path), "/sys/class/uio/%s/maps/map%d/size",
+		 b->name, map);
+	f = fopen(path, "r");
+	if (!f)
+		die(path);
+	if (fscanf(f, "%lx", &size) != 1) {
+		errno = EINVAL;
+		die(path);
+	}
+	fclose(f);
+
+	return size;
+}
+
+static void *map(struct bench *b, int map, int prot)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	void *p;
+
+	p = mmap(NULL, map_size(b, map), prot, MAP_SHARED, b->fd, map * page);
+	if (p == MAP_FAILED)
+		die("mmap");
+
+	return p;
+}
+
+static volatile struct desc *rx_desc(struct bench *b, unsigned int i)
+{
+	return (volatile struct desc *)(b->rx_ring + i * b->info->rx_desc_size);
+}
+
+static volatile struct desc *tx_desc(struct bench *b, unsigned int i)
+{
+	return (volatile struct desc *)(b->tx_ring + i * b->info->tx_desc_size);
+}
+
+static uint32_t rx_tail(struct bench *b, unsigned int i)
+{
+	return b->info->rx_ring_dma + i * b->info->rx_desc_size;
+}
+
+static uint32_t tx_tail(struct bench *b, unsigned int i)
+{
+	return b->info->tx_ring_dma + i * b->info->tx_desc_size;
+}
+
+static void rx_arm(struct bench *b, unsigned int i)
+{
+	volatile struct desc *d = rx_desc(b, i);
+	uint64_t dma = b->info->rx_buf_dma + (uint64_t)i * b->info->buf_size;
+
+	d->des0 = dma;
+	d->des1 = dma >> 32;
+	d->des2 = 0;
+	barrier_dma();
+	d->des3 = RDES3_OWN | RDES3_IOC | RDES3_BUF1V;
+}
+
+/* Block until the channel interrupts, or up to a second */
+static void wait_irq(struct bench *b)
+{
+	struct pollfd pfd = { .fd = b->fd, .events = POLLIN };
+	int32_t on = 1;
+	uint32_t count;
+
+	if (b->busy_poll)
+		return;
+
+	if (write(b->fd, &on, sizeof(on)) != sizeof(on))
+		die("irq enable");
+
+	if (poll(&pfd, 1, 1000) > 0 &&
+	    read(b->fd, &count, sizeof(count)) != sizeof(count))
+		die("irq wait");
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool report(struct bench *b, double *last, unsigned int *elapsed)
+{
+	static uint64_t pkts, bytes;
+	double t = now(), dt = t - *last;
+
+	if (dt < 1.0)
+		return true;
+
+	printf("%s: %10.0f pps %9.2f Mbps %8llu errors\n",
+	       b->tx ? "tx" : "rx",
+	       (b->pkts - pkts) / dt, (b->bytes - bytes) * 8 / dt / 1e6,
+	       (unsigned long long)b->errors);
+	fflush(stdout);
+
+	pkts = b->pkts;
+	bytes = b->bytes;
+	*last = t;
+
+	return !b->seconds || ++*elapsed < b->seconds;
+}
+
+static void run_rx(struct bench *b)
+{
+	unsigned int n = b->info->rx_ring_size, cur = 0, elapsed = 0, i;
+	double last = now();
+
+	for (i = 0; i < n; i++)
+		rx_arm(b, i);
+	reg_write(b, CH_RX_END_ADDR, rx_tail(b, n));
+	reg_write(b, CH_RX_CONTROL,
+		  reg_read(b, CH_RX_CONTROL) | CH_CONTROL_START);
+
+	while (report(b, &last, &elapsed)) {
+		volatile struct desc *d = rx_desc(b, cur);
+		uint32_t des3 = d->des3;
+
+		if (des3 & RDES3_OWN) {
+			wait_irq(b);
+			continue;
+		}
+
+		barrier_dma();
+		if (des3 & RDES3_ES) {
+			b->errors++;
+		} else {
+			b->pkts++;
+			b->bytes += des3 & RDES3_PL_MASK;
+		}
+
+		rx_arm(b, cur);
+		cur = (cur + 1) % n;
+		reg_write(b, CH_RX_END_ADDR, rx_tail(b, cur));
+	}
+
+	reg_write(b, CH_RX_CONTROL,
+		  reg_read(b, CH_RX_CONTROL) & ~CH_CONTROL_START);
+}
+
+static void run_tx(struct bench *b)
+{
+	unsigned int n = b->info->tx_ring_size, cur = 0, dirty = 0;
+	unsigned int elapsed = 0, queued = 0, i;
+	uint8_t *tx_buf = b->buf + b->info->tx_buf_offset;
+	double last = now();
+
+	/* broadcast, locally administered source, local experimental type */
+	for (i = 0; i < n; i++) {
+		uint8_t *f = tx_buf + i * b->info->buf_size;
+
+		memset(f, 0xff, 6);
+		memcpy(f + 6, "\x02\x00\x00\x00\x00\x01", 6);
+		f[12] = 0x88;
+		f[13] = 0xb5;
+		memset(f + 14, 0, b->size - 14);
+	}
+
+	reg_write(b, CH_TX_CONTROL,
+		  reg_read(b, CH_TX_CONTROL) | CH_CONTROL_START);
+
+	while (report(b, &last, &elapsed)) {
+		/* reap */
+		while (queued && !(tx_desc(b, dirty)->des3 & TDES3_OWN)) {
+			b->pkts++;
+			b->bytes += b->size;
+			dirty = (dirty + 1) % n;
+			queued--;
+		}
+
+		if (queued == n - 1) {
+			wait_irq(b);
+			continue;
+		}
+
+		/* fill */
+		while (queued < n - 1) {
+			volatile struct desc *d = tx_desc(b, cur);
+			uint64_t dma = b->info->tx_buf_dma +
+				       (uint64_t)cur * b->info->buf_size;
+
+			d->des0 = dma;
+			d->des1 = dma >> 32;
+			d->des2 = (b->size & TDES2_B1L_MASK) |
+				  (cur % TX_IRQ_BATCH ? 0 : TDES2_IOC);
+			barrier_dma();
+			d->des3 = TDES3_OWN | TDES3_FD | TDES3_LD |
+				  (b->size & TDES3_FL_MASK);
+			cur = (cur + 1) % n;
+			queued++;
+		}
+		reg_write(b, CH_TX_END_ADDR, tx_tail(b, cur));
+	}
+
+	reg_write(b, CH_TX_CONTROL,
+		  reg_read(b, CH_TX_CONTROL) & ~CH_CONTROL_START);
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: stmmac-uio-bench -d uioN [options]\n"
+		"  -t          transmit instead of receive\n"
+		"  -s size     TX frame size without FCS (default 60)\n"
+		"  -p          busy poll instead of waiting for interrupts\n"
+		"  -n seconds  stop after that many reports (default: run)\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	struct bench b = { .size = 60 };
+	char path[64];
+	int c;
+
+	while ((c = getopt(argc, argv, "d:ts:pn:")) != -1) {
+		switch (c) {
+		case 'd':
+			b.name = optarg;
+			break;
+		case 't':
+			b.tx = true;
+			break;
+		case 's':
+			b.size = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			b.busy_poll = true;
+			break;
+		case 'n':
+			b.seconds = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (!b.name)
+		usage();
+
+	snprintf(path, sizeof(path), "/dev/%s", b.name);
+	b.fd = open(path, O_RDWR);
+	if (b.fd < 0)
+		die(path);
+
+	b.info = map(&b, STMMAC_UIO_MAP_INFO, PROT_READ);
+	if (b.info->magic != STMMAC_UIO_MAGIC ||
+	    b.info->version != STMMAC_UIO_ABI_VERSION) {
+		fprintf(stderr, "%s: unsupported ABI %#x/%u\n", path,
+			b.info->magic, b.info->version);
+		return 1;
+	}
+	if (!(b.info->flags & STMMAC_UIO_F_GMAC4) ||
+	    b.info->rx_desc_size != sizeof(struct desc) ||
+	    b.info->tx_desc_size != sizeof(struct desc)) {
+		fprintf(stderr, "%s: only dwmac4 normal descriptors are handled\n",
+			path);
+		return 1;
+	}
+	if (b.size < 60 || b.size > b.info->buf_size) {
+		fprintf(stderr, "frame size must be 60..%u\n",
+			b.info->buf_size);
+		return 1;
+	}
+
+	b.regs = (uint8_t *)map(&b, STMMAC_UIO_MAP_REGS,
+				PROT_READ | PROT_WRITE) + b.info->regs_offset;
+	b.rx_ring = map(&b, STMMAC_UIO_MAP_RX_RING, PROT_READ | PROT_WRITE);
+	b.tx_ring = map(&b, STMMAC_UIO_MAP_TX_RING, PROT_READ | PROT_WRITE);
+	b.buf = map(&b, STMMAC_UIO_MAP_BUF, PROT_READ | PROT_WRITE);
+
+	printf("%s: channel %u%s, %u/%u descriptors, %u byte buffers\n",
+	       b.name, b.info->channel,
+	       b.info->flags & STMMAC_UIO_F_COEXIST ? " (coexist)" : "",
+	       b.info->rx_ring_size, b.info->tx_ring_size, b.info->buf_size);
+
+	if (b.tx)
+		run_tx(&b);
+	else
+		run_rx(&b);
+
+	return 0;
+}
@@ -0,0 +1,385 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Throughput benchmark for rockchip_i2s_tdm + pcm_dmaengine + pl330.
+ *
+ * Puts the controller into digital loopback and runs playback and
+ * capture together for every rate/format/channels combination the
+ * driver accepts, reporting the achieved bytes/s per direction, the
+ * system CPU load and the DMA interrupt rate.
+ *
+ * Copyright (c) 2026 Rockchip Electronics Co. Ltd.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/types.h>
+
+#include <sound/asound.h>
+
+#define LOOPBACK_CTL	"I2STDM Digital Loopback Mode"
+#define PERIOD_FRAMES	1024
+#define PERIODS		4
+
+struct bench_fmt {
+	const char *name;
+	int format;
+	int bytes;
+};
+
+static const struct bench_fmt fmts[] = {
+	{ "S16_LE", SNDRV_PCM_FORMAT_S16_LE, 2 },
+	{ "S24_LE", SNDRV_PCM_FORMAT_S24_LE, 4 },
+	{ "S32_LE", SNDRV_PCM_FORMAT_S32_LE, 4 },
+};
+
+static const unsigned int rates[] = {
+	44100, 48000, 88200, 96000, 176400, 192000,
+	352800, 384000, 705600, 768000,
+};
+
+static const unsigned int channels[] = { 2, 4, 8, 16 };
+
+struct cpu_sample {
+	unsigned long long busy;
+	unsigned long long total;
+};
+
+static void hw_any(struct snd_pcm_hw_params *p)
+{
+	int i;
+
+	memset(p, 0, sizeof(*p));
+	for (i = 0; i <= SNDRV_PCM_HW_PARAM_LAST_MASK - SNDRV_PCM_HW_PARAM_FIRST_MASK; i++)
+		memset(&p->masks[i], 0xff, sizeof(p->masks[i]));
+	for (i = 0; i <= SNDRV_PCM_HW_PARAM_LAST_INTERVAL - SNDRV_PCM_HW_PARAM_FIRST_INTERVAL; i++) {
+		p->intervals[i].min = 0;
+		p->intervals[i].max = UINT_MAX;
+	}
+	p->rmask = ~0U;
+	p->info = ~0U;
+}
+
+static void hw_set_mask(struct snd_pcm_hw_params *p, int param, unsigned int val)
+{
+	struct snd_mask *m = &p->masks[param - SNDRV_PCM_HW_PARAM_FIRST_MASK];
+
+	memset(m, 0, sizeof(*m));
+	m->bits[val >> 5] |= 1U << (val & 31);
+}
+
+static void hw_set_int(struct snd_pcm_hw_params *p, int param, unsigned int val)
+{
+	struct snd_interval *i = &p->intervals[param - SNDRV_PCM_HW_PARAM_FIRST_INTERVAL];
+
+	i->min = val;
+	i->max = val;
+	i->integer = 1;
+}
+
+static int pcm_setup(int fd, const struct bench_fmt *f, unsigned int rate,
+		     unsigned int chs)
+{
+	struct snd_pcm_hw_params hw;
+	struct snd_pcm_sw_params sw;
+
+	hw_any(&hw);
+	hw_set_mask(&hw, SNDRV_PCM_HW_PARAM_ACCESS,
+		    SNDRV_PCM_ACCESS_RW_INTERLEAVED);
+	hw_set_mask(&hw, SNDRV_PCM_HW_PARAM_FORMAT, f->format);
+	hw_set_mask(&hw, SNDRV_PCM_HW_PARAM_SUBFORMAT,
+		    SNDRV_PCM_SUBFORMAT_STD);
+	hw_set_int(&hw, SNDRV_PCM_HW_PARAM_RATE, rate);
+	hw_set_int(&hw, SNDRV_PCM_HW_PARAM_CHANNELS, chs);
+	hw_set_int(&hw, SNDRV_PCM_HW_PARAM_PERIOD_SIZE, PERIOD_FRAMES);
+	hw_set_int(&hw, SNDRV_PCM_HW_PARAM_PERIODS, PERIODS);
+
+	if (ioctl(fd, SNDRV_PCM_IOCTL_HW_PARAMS, &hw) < 0)
+		return -errno;
+
+	memset(&sw, 0, sizeof(sw));
+	sw.tstamp_mode = SNDRV_PCM_TSTAMP_NONE;
+	sw.period_step = 1;
+	sw.avail_min = PERIOD_FRAMES;
+	sw.start_threshold = PERIOD_FRAMES;
+	sw.stop_threshold = PERIOD_FRAMES * PERIODS;
+	sw.boundary = PERIOD_FRAMES * PERIODS;
+	while (sw.boundary * 2 <= LONG_MAX - PERIOD_FRAMES * PERIODS)
+		sw.boundary *= 2;
+
+	if (ioctl(fd, SNDRV_PCM_IOCTL_SW_PARAMS, &sw) < 0)
+		return -errno;
+
+	if (ioctl(fd, SNDRV_PCM_IOCTL_PREPARE) < 0)
+		return -errno;
+
+	return 0;
+}
+
+static int ctl_set_loopback(int card, int mode)
+{
+	struct snd_ctl_elem_value val;
+	char path[64];
+	int fd, ret = 0;
+
+	snprintf(path, sizeof(path), "/dev/snd/controlC%d", card);
+	fd = open(path, O_RDWR);
+	if (fd < 0)
+		return -errno;
+
+	memset(&val, 0, sizeof(val));
+	val.id.iface = SNDRV_CTL_ELEM_IFACE_MIXER;
+	strncpy((char *)val.id.name, LOOPBACK_CTL, sizeof(val.id.name) - 1);
+	val.value.enumerated.item[0] = mode;
+	if (ioctl(fd, SNDRV_CTL_IOCTL_ELEM_WRITE, &val) < 0)
+		ret = -errno;
+
+	close(fd);
+	return ret;
+}
+
+static void cpu_read(struct cpu_sample *s)
+{
+	unsigned long long v[8] = { 0 };
+	FILE *fp;
+	int i;
+
+	s->busy = 0;
+	s->total = 0;
+
+	fp = fopen("/proc/stat", "r");
+	if (!fp)
+		return;
+
+	if (fscanf(fp, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+		   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) == 8) {
+		for (i = 0; i < 8; i++)
+			s->total += v[i];
+		/* everything but idle and iowait */
+		s->busy = s->total - v[3] - v[4];
+	}
+
+	fclose(fp);
+}
+
+static unsigned long long irq_read(const char *pattern)
+{
+	unsigned long long sum = 0, n;
+	char line[512], *p, *end;
+	FILE *fp;
+
+	fp = fopen("/proc/interrupts", "r");
+	if (!fp)
+		return 0;
+
+	while (fgets(line, sizeof(line), fp)) {
+		if (!strstr(line, pattern))
+			continue;
+		p = strchr(line, ':');
+		if (!p)
+			continue;
+		p++;
+		/* sum the per-cpu columns */
+		for (;;) {
+			n = strtoull(p, &end, 10);
+			if (end == p)
+				break;
+			sum += n;
+			p = end;
+		}
+	}
+
+	fclose(fp);
+	return sum;
+}
+
+static double now_sec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int run_one(int card, int dev, const struct bench_fmt *f,
+		   unsigned int rate, unsigned int chs, double secs,
+		   const char *irq_pattern)
+{
+	unsigned long long tx_frames = 0, rx_frames = 0, irq0, irq1;
+	struct cpu_sample c0, c1;
+	struct pollfd pfd[2];
+	struct snd_xferi xfer;
+	char path[64];
+	double t0, t;
+	size_t bytes;
+	void *buf;
+	int tx, rx, ret;
+
+	snprintf(path, sizeof(path), "/dev/snd/pcmC%dD%dp", card, dev);
+	tx = open(path, O_RDWR | O_NONBLOCK);
+	if (tx < 0)
+		return -errno;
+
+	snprintf(path, sizeof(path), "/dev/snd/pcmC%dD%dc", card, dev);
+	rx = open(path, O_RDWR | O_NONBLOCK);
+	if (rx < 0) {
+		ret = -errno;
+		close(tx);
+		return ret;
+	}
+
+	ret = pcm_setup(tx, f, rate, chs);
+	if (!ret)
+		ret = pcm_setup(rx, f, rate, chs);
+	if (ret)
+		goto out;
+
+	bytes = (size_t)PERIOD_FRAMES * chs * f->bytes;
+	buf = calloc(1, bytes);
+	if (!buf) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	ioctl(rx, SNDRV_PCM_IOCTL_START);
+
+	pfd[0].fd = tx;
+	pfd[0].events = POLLOUT;
+	pfd[1].fd = rx;
+	pfd[1].events = POLLIN;
+
+	cpu_read(&c0);
+	irq0 = irq_read(irq_pattern);
+	t0 = now_sec();
+
+	do {
+		if (poll(pfd, 2, 1000) <= 0) {
+			ret = -ETIMEDOUT;
+			break;
+		}
+
+		if (pfd[0].revents & POLLOUT) {
+			xfer.buf = buf;
+			xfer.frames = PERIOD_FRAMES;
+			if (ioctl(tx, SNDRV_PCM_IOCTL_WRITEI_FRAMES, &xfer) < 0) {
+				ret = -errno;
+				break;
+			}
+			tx_frames += xfer.result;
+		}
+
+		if (pfd[1].revents & POLLIN) {
+			xfer.buf = buf;
+			xfer.frames = PERIOD_FRAMES;
+			if (ioctl(rx, SNDRV_PCM_IOCTL_READI_FRAMES, &xfer) < 0) {
+				ret = -errno;
+				break;
+			}
+			rx_frames += xfer.result;
+		}
+
+		t = now_sec() - t0;
+	} while (t < secs);
+
+	cpu_read(&c1);
+	irq1 = irq_read(irq_pattern);
+	t = now_sec() - t0;
+
+	ioctl(tx, SNDRV_PCM_IOCTL_DROP);
+	ioctl(rx, SNDRV_PCM_IOCTL_DROP);
+	free(buf);
+
+	printf("%-6s %6u %2u  tx %10.0f B/s  rx %10.0f B/s  cpu %5.1f%%  irq %7.0f/s%s\n",
+	       f->name, rate, chs,
+	       tx_frames * chs * f->bytes / t,
+	       rx_frames * chs * f->bytes / t,
+	       c1.total > c0.total ?
+			100.0 * (c1.busy - c0.busy) / (c1.total - c0.total) : 0.0,
+	       (irq1 - irq0) / t,
+	       ret ? "  (xrun)" : "");
+out:
+	close(rx);
+	close(tx);
+	return ret;
+}
+
+static void usage(const char *prog)
+{
+	printf("%s [-c card] [-d device] [-t seconds] [-i irq-name] [-m loopback-mode]\n"
+	       "  default: card 0, device 0, 2 seconds, irq 'pl330', loopback mode 1\n",
+	       prog);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *irq_pattern = "pl330";
+	int card = 0, dev = 0, mode = 1, opt;
+	int pass = 0, fail = 0, skip = 0;
+	unsigned int r, c, f;
+	double secs = 2.0;
+	int ret;
+
+	while ((opt = getopt(argc, argv, "c:d:t:i:m:h")) != -1) {
+		switch (opt) {
+		case 'c':
+			card = atoi(optarg);
+			break;
+		case 'd':
+			dev = atoi(optarg);
+			break;
+		case 't':
+			secs = atof(optarg);
+			break;
+		case 'i':
+			irq_pattern = optarg;
+			break;
+		case 'm':
+			mode = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : -1;
+		}
+	}
+
+	ret = ctl_set_loopback(card, mode);
+	if (ret) {
+		printf("set '%s' failed: %s\n", LOOPBACK_CTL, strerror(-ret));
+		return 4; /* KSFT_SKIP */
+	}
+
+	for (f = 0; f < sizeof(fmts) / sizeof(fmts[0]); f++) {
+		for (c = 0; c < sizeof(channels) / sizeof(channels[0]); c++) {
+			for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+				ret = run_one(card, dev, &fmts[f], rates[r],
+					      channels[c], secs, irq_pattern);
+				if (ret == -EINVAL) {
+					skip++;
+					continue;
+				}
+				if (ret) {
+					printf("%-6s %6u %2u  failed: %s\n",
+					       fmts[f].name, rates[r], channels[c],
+					       strerror(-ret));
+					fail++;
+				} else {
+					pass++;
+				}
+			}
+		}
+	}
+
+	ctl_set_loopback(card, 0);
+
+	printf("pass %d, fail %d, unsupported %d\n", pass, fail, skip);
+
+	return fail ? 1 : 0;
+}